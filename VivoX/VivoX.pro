@@ -3,7 +3,13 @@
 
 #TARGET = VivoX
 
-QT = core gui widgets
+QT = core concurrent gui widgets qml quick
+
+# Compile the QML in the resources ahead of time
+CONFIG += qtquickcompiler
+
+RESOURCES = \
+   $$PWD/ui/qml.qrc
 
 HEADERS = \
    $$PWD/compositor/protocols/LinuxDmabufProtocol.h \
@@ -12,9 +18,19 @@ HEADERS = \
    $$PWD/compositor/protocols/WaylandLayerShell.h \
    $$PWD/compositor/protocols/WaylandProtocols.h \
    $$PWD/compositor/protocols/XWaylandIntegration.h \
+   $$PWD/compositor/rendering/BufferResidency.h \
+   $$PWD/compositor/rendering/ClientAccounting.h \
+   $$PWD/compositor/rendering/FrameScheduler.h \
+   $$PWD/compositor/rendering/GeometryAnimator.h \
+   $$PWD/compositor/rendering/PixelBufferRing.h \
    $$PWD/compositor/rendering/RenderEngine.h \
    $$PWD/compositor/rendering/RenderEngineInterface.h \
+   $$PWD/compositor/rendering/ShmUpload.h \
+   $$PWD/compositor/rendering/ThumbnailAtlas.h \
+   $$PWD/compositor/rendering/WorkspaceSnapshots.h \
+   $$PWD/compositor/wayland/OcclusionCuller.h \
    $$PWD/compositor/wayland/OutputManager.h \
+   $$PWD/compositor/wayland/OutputRenderLoop.h \
    $$PWD/compositor/wayland/WaylandCompositor.h \
    $$PWD/compositor/xwayland/XWaylandIntegration.h \
    $$PWD/compositor/CompositorInterface.h \
@@ -37,30 +53,46 @@ HEADERS = \
    $$PWD/input/InputManager.h \
    $$PWD/input/InputManagerInterface.h \
    $$PWD/system/applications/ApplicationManager.h \
+   $$PWD/system/applications/ApplicationSearchIndex.h \
+   $$PWD/system/applications/DesktopEntryIndex.h \
+   $$PWD/system/applications/FrecencyStore.h \
+   $$PWD/system/applications/ProcessLauncher.h \
    $$PWD/system/media/MediaController.h \
+   $$PWD/system/network/NetlinkMonitor.h \
    $$PWD/system/network/NetworkManager.h \
    $$PWD/system/network/NetworkManagerInterface.h \
    $$PWD/system/notifications/NotificationManager.h \
    $$PWD/system/notifications/NotificationManagerInterface.h \
+   $$PWD/system/notifications/TimingWheel.h \
    $$PWD/system/power/PowerManager.h \
+   $$PWD/system/power/PowerProfileWriter.h \
    $$PWD/system/session/SessionManager.h \
+   $$PWD/system/session/SessionStore.h \
    $$PWD/system/SystemService.h \
    $$PWD/system/SystemServiceInterface.h \
+   $$PWD/tests/unit/TestSupport.h \
+   $$PWD/ui/effects/EffectTextureCache.h \
+   $$PWD/ui/effects/ShadowItem.h \
    $$PWD/ui/panels/PanelInterface.h \
    $$PWD/ui/panels/PanelManager.h \
    $$PWD/ui/qml/theme/ThemeManager.h \
+   $$PWD/ui/qml/theme/ThemePalette.h \
    $$PWD/ui/widgets/Widget.h \
    $$PWD/ui/widgets/WidgetHost.h \
    $$PWD/ui/widgets/WidgetInterface.h \
    $$PWD/ui/widgets/WidgetManager.h \
    $$PWD/ui/widgets/WidgetRegistry.h \
+   $$PWD/ui/QmlIncubationController.h \
    $$PWD/ui/UIManager.h \
    $$PWD/ui/UIManagerInterface.h \
+   $$PWD/window_manager/layouts/LayoutArchive.h \
    $$PWD/window_manager/layouts/LayoutEngine.h \
    $$PWD/window_manager/stage/StageManager.h \
    $$PWD/window_manager/tabbing/TabManager.h \
    $$PWD/window_manager/windows/WindowManager.h \
    $$PWD/window_manager/windows/WindowManagerInterface.h \
+   $$PWD/window_manager/windows/WindowRegistry.h \
+   $$PWD/window_manager/windows/WindowRules.h \
    $$PWD/window_manager/workspaces/Workspace.h \
    $$PWD/window_manager/workspaces/WorkspaceManager.h \
    $$PWD/InputManager.h \
@@ -74,8 +106,18 @@ SOURCES = \
    $$PWD/compositor/protocols/WaylandLayerShell.cpp \
    $$PWD/compositor/protocols/WaylandProtocols.cpp \
    $$PWD/compositor/protocols/XWaylandIntegration.cpp \
+   $$PWD/compositor/rendering/BufferResidency.cpp \
+   $$PWD/compositor/rendering/ClientAccounting.cpp \
+   $$PWD/compositor/rendering/FrameScheduler.cpp \
+   $$PWD/compositor/rendering/GeometryAnimator.cpp \
+   $$PWD/compositor/rendering/PixelBufferRing.cpp \
    $$PWD/compositor/rendering/RenderEngine.cpp \
+   $$PWD/compositor/rendering/ShmUpload.cpp \
+   $$PWD/compositor/rendering/ThumbnailAtlas.cpp \
+   $$PWD/compositor/rendering/WorkspaceSnapshots.cpp \
+   $$PWD/compositor/wayland/OcclusionCuller.cpp \
    $$PWD/compositor/wayland/OutputManager.cpp \
+   $$PWD/compositor/wayland/OutputRenderLoop.cpp \
    $$PWD/compositor/wayland/WaylandCompositor.cpp \
    $$PWD/compositor/xwayland/XWaylandIntegration.cpp \
    $$PWD/core/actions/ActionManager.cpp \
@@ -90,30 +132,66 @@ SOURCES = \
    $$PWD/input/shortcuts/ShortcutManager.cpp \
    $$PWD/input/InputManager.cpp \
    $$PWD/system/applications/ApplicationManager.cpp \
+   $$PWD/system/applications/ApplicationSearchIndex.cpp \
+   $$PWD/system/applications/DesktopEntryIndex.cpp \
+   $$PWD/system/applications/FrecencyStore.cpp \
+   $$PWD/system/applications/ProcessLauncher.cpp \
    $$PWD/system/media/MediaController.cpp \
+   $$PWD/system/network/NetlinkMonitor.cpp \
    $$PWD/system/network/NetworkManager.cpp \
    $$PWD/system/notifications/NotificationManager.cpp \
+   $$PWD/system/notifications/TimingWheel.cpp \
    $$PWD/system/power/PowerManager.cpp \
+   $$PWD/system/power/PowerProfileWriter.cpp \
    $$PWD/system/session/SessionManager.cpp \
+   $$PWD/system/session/SessionStore.cpp \
    $$PWD/system/SystemService.cpp \
    $$PWD/tests/integration/core/CoreIntegrationTest.cpp \
+   $$PWD/tests/unit/compositor/BufferResidencyTest.cpp \
+   $$PWD/tests/unit/compositor/ClientAccountingTest.cpp \
+   $$PWD/tests/unit/compositor/FrameSchedulerTest.cpp \
+   $$PWD/tests/unit/compositor/GeometryAnimatorTest.cpp \
+   $$PWD/tests/unit/compositor/OcclusionCullerTest.cpp \
+   $$PWD/tests/unit/compositor/ShmUploadTest.cpp \
+   $$PWD/tests/unit/compositor/ThumbnailAtlasTest.cpp \
+   $$PWD/tests/unit/compositor/WorkspaceSnapshotsTest.cpp \
    $$PWD/tests/unit/core/ActionManagerTest.cpp \
    $$PWD/tests/unit/core/ConfigManagerTest.cpp \
    $$PWD/tests/unit/core/EventManagerTest.cpp \
    $$PWD/tests/unit/core/LoggerTest.cpp \
    $$PWD/tests/unit/core/PluginLoaderTest.cpp \
    $$PWD/tests/unit/core/ServiceRegistryTest.cpp \
+   $$PWD/tests/unit/system/ApplicationSearchIndexTest.cpp \
+   $$PWD/tests/unit/system/DesktopEntryIndexTest.cpp \
+   $$PWD/tests/unit/system/FrecencyStoreTest.cpp \
+   $$PWD/tests/unit/system/MediaControllerTest.cpp \
+   $$PWD/tests/unit/system/NetworkManagerTest.cpp \
+   $$PWD/tests/unit/system/NotificationManagerTest.cpp \
+   $$PWD/tests/unit/system/ProcessLauncherTest.cpp \
+   $$PWD/tests/unit/system/PowerManagerTest.cpp \
+   $$PWD/tests/unit/system/PowerProfileWriterTest.cpp \
+   $$PWD/tests/unit/system/SessionStoreTest.cpp \
+   $$PWD/tests/unit/ui/ThemeManagerTest.cpp \
+   $$PWD/tests/unit/window_manager/LayoutArchiveTest.cpp \
+   $$PWD/tests/unit/window_manager/WindowRegistryTest.cpp \
+   $$PWD/tests/unit/window_manager/WindowRulesTest.cpp \
+   $$PWD/ui/effects/EffectTextureCache.cpp \
+   $$PWD/ui/effects/ShadowItem.cpp \
    $$PWD/ui/panels/PanelManager.cpp \
    $$PWD/ui/qml/theme/ThemeManager.cpp \
    $$PWD/ui/widgets/Widget.cpp \
    $$PWD/ui/widgets/WidgetHost.cpp \
    $$PWD/ui/widgets/WidgetManager.cpp \
    $$PWD/ui/widgets/WidgetRegistry.cpp \
+   $$PWD/ui/QmlIncubationController.cpp \
    $$PWD/ui/UIManager.cpp \
+   $$PWD/window_manager/layouts/LayoutArchive.cpp \
    $$PWD/window_manager/layouts/LayoutEngine.cpp \
    $$PWD/window_manager/stage/StageManager.cpp \
    $$PWD/window_manager/tabbing/TabManager.cpp \
    $$PWD/window_manager/windows/WindowManager.cpp \
+   $$PWD/window_manager/windows/WindowRegistry.cpp \
+   $$PWD/window_manager/windows/WindowRules.cpp \
    $$PWD/window_manager/workspaces/Workspace.cpp \
    $$PWD/window_manager/workspaces/WorkspaceManager.cpp \
    $$PWD/InputManager.cpp \
@@ -145,6 +223,7 @@ INCLUDEPATH = \
     $$PWD/system/power \
     $$PWD/system/session \
     $$PWD/ui \
+    $$PWD/ui/effects \
     $$PWD/ui/panels \
     $$PWD/ui/qml/theme \
     $$PWD/ui/widgets \
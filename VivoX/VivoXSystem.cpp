@@ -3,9 +3,24 @@
 #include <QDebug>
 #include <QQuickWindow>
 #include <QQuickStyle>
+#include <QWaylandClient>
+#include <QWaylandSurface>
+#include <QWaylandXdgToplevel>
+
+#include <memory>
 
 namespace VivoX {
 
+namespace {
+// Moves shorter than this that keep the size follow directly, e.g. while a window is dragged
+const int animatedMoveThreshold = 64;
+
+bool isAnimatedGeometryChange(const QRect &from, const QRect &to)
+{
+    return from.size() != to.size() || (to.topLeft() - from.topLeft()).manhattanLength() >= animatedMoveThreshold;
+}
+} // namespace
+
 VivoXSystem::VivoXSystem(QObject *parent)
     : QObject(parent)
     , m_app(nullptr)
@@ -22,6 +37,7 @@ VivoXSystem::VivoXSystem(QObject *parent)
     , m_windowManager(nullptr)
     , m_workspaceManager(nullptr)
     , m_layoutEngine(nullptr)
+    , m_stageManager(nullptr)
     , m_uiManager(nullptr)
     , m_themeManager(nullptr)
     , m_panelManager(nullptr)
@@ -100,6 +116,10 @@ bool VivoXSystem::initialize(int argc, char *argv[])
     // Connect signals between components
     connectSignals();
 
+    // Bring back the previous session before recording overwrites it with the defaults
+    m_sessionManager->restoreSession();
+    recordSessionWorkspaces();
+
     qDebug() << "VivoXSystem initialized successfully";
     return true;
 }
@@ -167,6 +187,9 @@ void VivoXSystem::shutdown()
     m_inputManager = nullptr;
 
     // Window manager components
+    delete m_stageManager;
+    m_stageManager = nullptr;
+
     delete m_layoutEngine;
     m_layoutEngine = nullptr;
 
@@ -323,6 +346,13 @@ bool VivoXSystem::initializeWindowManagerComponents()
         return false;
     }
 
+    // Initialize stage manager
+    m_stageManager = new WindowManager::StageManager(this);
+    if (!m_stageManager->initialize(m_windowManager)) {
+        qCritical() << "Failed to initialize stage manager";
+        return false;
+    }
+
     qDebug() << "Window manager components initialized successfully";
     return true;
 }
@@ -364,6 +394,10 @@ bool VivoXSystem::initializeUIComponents()
     m_uiManager->registerContextProperty("panelManager", m_panelManager);
     m_uiManager->registerContextProperty("widgetManager", m_widgetManager);
 
+    // Client resource usage, e.g. for a debug overlay
+    m_uiManager->registerContextProperty("compositor", m_waylandCompositor);
+    m_uiManager->registerContextProperty("stageManager", m_stageManager);
+
     qDebug() << "UI components initialized successfully";
     return true;
 }
@@ -414,6 +448,7 @@ bool VivoXSystem::initializeSystemComponents()
         qCritical() << "Failed to initialize application manager";
         return false;
     }
+    m_applicationManager->setWaylandDisplay(QString::fromUtf8(m_waylandCompositor->compositor()->socketName()));
 
     // Initialize notification manager
     m_notificationManager = new System::NotificationManager(this);
@@ -511,6 +546,88 @@ void VivoXSystem::connectSignals()
                 // Create a new window for this toplevel
                 WindowManager::Window *window = new WindowManager::Window(toplevel, surface);
                 m_windowManager->addWindow(window);
+
+                // Restored windows are matched by application, which may only be known after creation
+                if (!toplevel->appId().isEmpty()) {
+                    restoreSessionWindow(window, toplevel);
+                } else {
+                    auto connection = std::make_shared<QMetaObject::Connection>();
+                    *connection = connect(toplevel, &QWaylandXdgToplevel::appIdChanged, window,
+                                          [this, window, toplevel, connection]() {
+                                              disconnect(*connection);
+                                              restoreSessionWindow(window, toplevel);
+                                          });
+                }
+
+                // Keep the session up to date as the window changes
+                recordSessionWindow(window, toplevel);
+                auto record = [this, window, toplevel]() {
+                    recordSessionWindow(window, toplevel);
+                };
+                connect(toplevel, &QWaylandXdgToplevel::titleChanged, window, record);
+                connect(toplevel, &QWaylandXdgToplevel::appIdChanged, window, record);
+                connect(toplevel, &QWaylandXdgToplevel::maximizedChanged, window, record);
+                connect(toplevel, &QWaylandXdgToplevel::fullscreenChanged, window, record);
+                connect(window, &WindowManager::Window::geometryChanged, toplevel, record);
+                connect(m_workspaceManager, &WindowManager::WorkspaceManager::windowMovedToWorkspace, window,
+                        [window, record](WindowManager::Window *moved) {
+                            if (moved == window) {
+                                record();
+                            }
+                        });
+
+                // The compositor only composites the active workspace
+                if (WindowManager::Workspace *workspace = m_workspaceManager->getWorkspaceForWindow(window)) {
+                    m_waylandCompositor->setSurfaceWorkspace(surface, workspace->id());
+                }
+                connect(m_workspaceManager, &WindowManager::WorkspaceManager::windowMovedToWorkspace, window,
+                        [this, window, surface](WindowManager::Window *moved, WindowManager::Workspace *workspace) {
+                            if (moved == window) {
+                                m_waylandCompositor->setSurfaceWorkspace(surface, workspace->id());
+                            }
+                        });
+
+                // Relayouts and snapping glide to the new geometry while the client resizes, once animations are enabled
+                auto geometry = std::make_shared<QRect>(window->geometry());
+                connect(window, &WindowManager::Window::geometryChanged, window,
+                        [this, window, surface, geometry]() {
+                            const QRect previous = *geometry;
+                            *geometry = window->geometry();
+                            if (previous.isValid() && isAnimatedGeometryChange(previous, *geometry)) {
+                                m_waylandCompositor->animateSurfaceGeometry(surface, previous, *geometry);
+                            } else {
+                                m_waylandCompositor->cancelSurfaceAnimation(surface);
+                            }
+                        });
+
+                // A fullscreen window drives the refresh of its output, so adaptive sync follows its frame rate
+                connect(toplevel, &QWaylandXdgToplevel::fullscreenChanged, window, [this, toplevel, surface]() {
+                    for (QWaylandOutput *output : m_waylandCompositor->outputs()) {
+                        if (m_waylandCompositor->fullscreenSurface(output) == surface) {
+                            m_waylandCompositor->setFullscreenSurface(output, nullptr);
+                        }
+                    }
+                    if (toplevel->fullscreen()) {
+                        m_waylandCompositor->setFullscreenSurface(m_waylandCompositor->outputForSurface(surface), surface);
+                    }
+                });
+
+                // Minimizing goes through the window manager, which moves focus on; the window is hidden
+                // until it is activated again, so its buffers can be released
+                connect(toplevel, &QWaylandXdgToplevel::setMinimized, window, [this, window, surface]() {
+                    if (m_windowManager->minimizeWindow(window)) {
+                        m_waylandCompositor->setSurfaceHidden(surface, true);
+                    }
+                });
+                connect(m_windowManager, &WindowManager::WindowManager::windowActivated, window,
+                        [this, window, surface](WindowManager::Window *activated) {
+                            if (activated == window) {
+                                m_waylandCompositor->setSurfaceHidden(surface, false);
+                                
+                                // Activation raises the window; occlusion follows the window manager's stacking
+                                m_waylandCompositor->raiseSurface(surface);
+                            }
+                        });
             });
 
     // Connect input manager to window manager
@@ -558,6 +675,45 @@ void VivoXSystem::connectSignals()
                 m_uiManager->activateWorkspaceInUI(workspace);
             });
 
+    // Composite the active workspace; the others are kept as snapshots for switching
+    if (WindowManager::Workspace *workspace = m_workspaceManager->getActiveWorkspace()) {
+        m_waylandCompositor->setActiveWorkspace(workspace->id());
+    }
+
+    connect(m_workspaceManager, &WindowManager::WorkspaceManager::workspaceActivated,
+            m_waylandCompositor, [this](WindowManager::Workspace *workspace) {
+                m_waylandCompositor->setActiveWorkspace(workspace->id());
+            });
+
+    connect(m_workspaceManager, &WindowManager::WorkspaceManager::workspaceRemoved,
+            m_waylandCompositor, [this](WindowManager::Workspace *workspace) {
+                m_waylandCompositor->removeWorkspace(workspace->id());
+            });
+
+    // The stage shows window thumbnails on the primary output; they are only kept up to date while it is shown
+    if (QWaylandOutput *output = m_waylandCompositor->primaryOutput()) {
+        m_stageManager->setStageArea(output->geometry());
+    }
+
+    connect(m_waylandCompositor, &Compositor::WaylandCompositor::primaryOutputChanged,
+            m_stageManager, [this](QWaylandOutput *output) {
+                m_stageManager->setStageArea(output ? output->geometry() : QRect());
+            });
+
+    connect(m_stageManager, &WindowManager::StageManager::activeChanged,
+            m_waylandCompositor, [this](bool active) {
+                if (active) {
+                    m_waylandCompositor->acquireThumbnails();
+                } else {
+                    m_waylandCompositor->releaseThumbnails();
+                }
+            });
+
+    connect(m_stageManager, &WindowManager::StageManager::stageLayoutChanged,
+            m_waylandCompositor, [this]() {
+                m_waylandCompositor->scheduleRepaint(m_stageManager->stageArea());
+            });
+
     // Connect system services to UI
     connect(m_notificationManager, &System::NotificationManager::notificationCreated,
             m_uiManager, [this](const System::NotificationInfo &info) {
@@ -565,6 +721,12 @@ void VivoXSystem::connectSignals()
                 m_uiManager->showNotification(info);
             });
 
+    connect(m_notificationManager, &System::NotificationManager::notificationUpdated,
+            m_uiManager, [this](const System::NotificationInfo &info) {
+                // Refresh the notification shown in UI
+                m_uiManager->showNotification(info);
+            });
+
     connect(m_notificationManager, &System::NotificationManager::notificationClosed,
             m_uiManager, [this](uint32_t id) {
                 // Remove notification from UI
@@ -635,6 +797,57 @@ void VivoXSystem::connectSignals()
                 m_uiManager->updateNetworkStatus(status);
             });
 
+    // Record windows, workspaces and applications in the session
+    connect(m_windowManager, &WindowManager::WindowManager::windowRemoved,
+            m_sessionManager, [this](WindowManager::Window *window) {
+                m_sessionManager->removeWindow(window->id());
+            });
+
+    connect(m_workspaceManager, &WindowManager::WorkspaceManager::workspaceAdded,
+            m_sessionManager, [this]() {
+                recordSessionWorkspaces();
+            });
+
+    connect(m_workspaceManager, &WindowManager::WorkspaceManager::workspaceRemoved,
+            m_sessionManager, [this](WindowManager::Workspace *workspace) {
+                // Later workspaces move up, so their indices are recorded again
+                m_sessionManager->removeWorkspace(workspace->id());
+                recordSessionWorkspaces();
+            });
+
+    connect(m_workspaceManager, &WindowManager::WorkspaceManager::workspaceActivated,
+            m_sessionManager, [this](WindowManager::Workspace *workspace) {
+                m_sessionManager->setActiveWorkspace(workspace->id());
+            });
+
+    connect(m_applicationManager, &System::ApplicationManager::applicationLaunched,
+            m_sessionManager, [this](const QString &appId) {
+                m_sessionManager->applicationStarted(appId);
+            });
+
+    connect(m_applicationManager, &System::ApplicationManager::applicationFinished,
+            m_sessionManager, [this](const QString &appId) {
+                m_sessionManager->applicationStopped(appId);
+            });
+
+    // Restore the previous session: workspaces first, then all applications at once
+    connect(m_sessionManager, &System::SessionManager::sessionRestoreStarted,
+            m_workspaceManager, [this](const System::SessionState &state) {
+                for (const System::SessionWorkspace &workspace : state.workspaces) {
+                    if (!m_workspaceManager->getWorkspaceByIndex(workspace.index)) {
+                        m_workspaceManager->createWorkspace(workspace.name);
+                    }
+                    if (workspace.id == state.activeWorkspace) {
+                        m_workspaceManager->activateWorkspace(m_workspaceManager->getWorkspaceByIndex(workspace.index));
+                    }
+                }
+            });
+
+    connect(m_sessionManager, &System::SessionManager::applicationRestoreRequested,
+            m_applicationManager, [this](const QString &appId) {
+                m_applicationManager->launchApplication(appId);
+            });
+
     // Connect session manager to system
     connect(m_sessionManager, &System::SessionManager::sessionEnding,
             this, [this](const QString &reason) {
@@ -665,6 +878,19 @@ void VivoXSystem::connectSignals()
     connect(m_gestureEngine, &Input::GestureEngine::gestureDetected,
             m_actionManager, &Core::ActionManager::executeAction);
 
+    // Report the first commit of each surface to complete launch latency measurements
+    connect(m_waylandCompositor, &Compositor::WaylandCompositor::surfaceCreated,
+            m_applicationManager, [this](QWaylandSurface *surface) {
+                auto connection = std::make_shared<QMetaObject::Connection>();
+                *connection = connect(surface, &QWaylandSurface::redraw, m_applicationManager,
+                                      [this, surface, connection]() {
+                                          disconnect(*connection);
+                                          if (surface->client()) {
+                                              m_applicationManager->notifySurfaceCommitted(surface->client()->processId());
+                                          }
+                                      });
+            });
+
     // Connect application manager to window manager
     connect(m_applicationManager, &System::ApplicationManager::applicationLaunched,
             m_windowManager, [this](const QString &appId, pid_t pid) {
@@ -675,4 +901,52 @@ void VivoXSystem::connectSignals()
     qDebug() << "Signals connected successfully";
 }
 
+void VivoXSystem::restoreSessionWindow(WindowManager::Window *window, QWaylandXdgToplevel *toplevel)
+{
+    System::SessionWindow saved;
+    if (!m_sessionManager->matchRestoredWindow(toplevel->appId(), toplevel->title(), saved)) {
+        return;
+    }
+
+    window->setGeometry(saved.geometry);
+    if (saved.state == System::SessionWindow::Fullscreen) {
+        toplevel->sendFullscreen(saved.geometry.size());
+    } else if (saved.state == System::SessionWindow::Maximized) {
+        toplevel->sendMaximized(saved.geometry.size());
+    }
+
+    if (WindowManager::Workspace *workspace = m_workspaceManager->getWorkspaceByIndex(saved.workspace)) {
+        m_workspaceManager->moveWindowToWorkspace(window, workspace);
+    }
+}
+
+void VivoXSystem::recordSessionWindow(WindowManager::Window *window, QWaylandXdgToplevel *toplevel)
+{
+    System::SessionWindow state;
+    state.key = window->id();
+    state.appId = toplevel->appId();
+    state.title = toplevel->title();
+    state.geometry = window->geometry();
+    if (toplevel->fullscreen()) {
+        state.state = System::SessionWindow::Fullscreen;
+    } else if (toplevel->maximized()) {
+        state.state = System::SessionWindow::Maximized;
+    }
+    state.workspace = m_workspaceManager->getAllWorkspaces().indexOf(m_workspaceManager->getWorkspaceForWindow(window));
+
+    m_sessionManager->updateWindow(state);
+}
+
+void VivoXSystem::recordSessionWorkspaces()
+{
+    const QList<WindowManager::Workspace*> workspaces = m_workspaceManager->getAllWorkspaces();
+    for (int i = 0; i < workspaces.size(); ++i) {
+        m_sessionManager->updateWorkspace({ workspaces[i]->id(), workspaces[i]->name(), i });
+    }
+
+    if (WindowManager::Workspace *active = m_workspaceManager->getActiveWorkspace()) {
+        m_sessionManager->setActiveWorkspace(active->id());
+    }
+}
+
 } // namespace VivoX
@@ -15,6 +15,7 @@
 #include "window_manager/windows/WindowManager.h"
 #include "window_manager/workspaces/WorkspaceManager.h"
 #include "window_manager/layouts/LayoutEngine.h"
+#include "window_manager/stage/StageManager.h"
 
 #include "ui/UIManager.h"
 #include "ui/qml/theme/ThemeManager.h"
@@ -38,6 +39,8 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 
+class QWaylandXdgToplevel;
+
 namespace VivoX {
 
 /**
@@ -94,6 +97,7 @@ private:
     WindowManager::WindowManager *m_windowManager;
     WindowManager::WorkspaceManager *m_workspaceManager;
     WindowManager::LayoutEngine *m_layoutEngine;
+    WindowManager::StageManager *m_stageManager;
 
     // UI components
     UI::UIManager *m_uiManager;
@@ -138,6 +142,13 @@ private:
 
     // Connect signals between components
     void connectSignals();
+
+    // Give a window of a restored application its saved state
+    void restoreSessionWindow(WindowManager::Window *window, QWaylandXdgToplevel *toplevel);
+
+    // Record the state of a window, or of all workspaces, in the session
+    void recordSessionWindow(WindowManager::Window *window, QWaylandXdgToplevel *toplevel);
+    void recordSessionWorkspaces();
 };
 
 } // namespace VivoX
@@ -266,7 +266,7 @@
      low = static_cast<uint32_t>(time & 0xFFFFFFFF);
  }
  
- void PresentationTimeProtocol::presentSurface(QWaylandSurface* surface, const QWaylandSyncPoint& syncPoint, uint64_t frameTime)
+ void PresentationTimeProtocol::presentSurface(QWaylandSurface* surface, uint64_t sequence, uint64_t frameTime, uint32_t refresh)
  {
      // Prüfe, ob es Feedback-Objekte für diese Oberfläche gibt
      QList<PresentationFeedback*> feedbacks = feedbacksForSurface(surface);
@@ -283,14 +283,15 @@
      uint32_t tvNsec = now.tv_nsec;
      splitTimeValue(now.tv_sec, tvSecHi, tvSecLo);
      
-     // Aktualisierungsfrequenz des Displays berechnen
-     // Wir nehmen hier eine Standard-Bildschirmfrequenz von 60Hz an
-     // In einer realen Implementierung würde man diese Informationen aus dem Display-System bekommen
-     uint32_t refresh = 16666667; // 60 Hz in Nanosekunden
+     // Aktualisierungsintervall der Ausgabe, auf der die Oberfläche dargestellt wurde
+     // Ohne Angabe des Schedulers nehmen wir eine Standard-Bildschirmfrequenz von 60Hz an
+     if (refresh == 0) {
+         refresh = 16666667; // 60 Hz in Nanosekunden
+     }
      
-     // Sequenznummer aus dem Sync-Punkt extrahieren
-     uint32_t sequenceHigh = 0;
-     uint32_t sequenceLow = syncPoint.frame();
+     // Sequenznummer der Ausgabe
+     uint32_t sequenceHigh, sequenceLow;
+     splitTimeValue(sequence, sequenceHigh, sequenceLow);
      
      // Flags für die Präsentation
      // - WP_PRESENTATION_FEEDBACK_KIND_VSYNC: Frame wurde mit VSync gerendert
@@ -13,7 +13,6 @@
 #include <QWaylandSurface>
 #include <QWaylandResource>
 #include <QWaylandGlobal>
-#include <QWaylandSyncPoint>
 #include <QMap>
 #include <chrono>
 
@@ -143,10 +142,11 @@ namespace VivoX {
             /**
              * @brief Benachrichtigt alle Feedback-Objekte für eine Oberfläche über eine erfolgreiche Darstellung
              * @param surface Wayland-Oberfläche, die dargestellt wurde
-             * @param syncPoint Synchronisationspunkt für die Darstellung
+             * @param sequence Fortlaufende Nummer des dargestellten Frames der Ausgabe
              * @param frameTime Zeitpunkt der Darstellung in Nanosekunden. Wenn 0, wird der aktuelle Zeitpunkt verwendet.
+             * @param refresh Aktualisierungsintervall des Ausgabegeräts in Nanosekunden. Wenn 0, werden 60 Hz angenommen.
              */
-            void presentSurface(QWaylandSurface* surface, const QWaylandSyncPoint& syncPoint, uint64_t frameTime = 0);
+            void presentSurface(QWaylandSurface* surface, uint64_t sequence, uint64_t frameTime = 0, uint32_t refresh = 0);
 
             /**
              * @brief Benachrichtigt alle Feedback-Objekte für eine Oberfläche über eine verworfene Darstellung
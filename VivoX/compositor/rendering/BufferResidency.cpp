@@ -0,0 +1,194 @@
+// BufferResidency.cpp
+#include "BufferResidency.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+BufferResidency::BufferResidency(uint64_t budget, int64_t gracePeriod)
+    : m_budget(budget)
+    , m_gracePeriod(std::max<int64_t>(0, gracePeriod))
+    , m_residentBytes(0)
+    , m_releasedBytes(0)
+    , m_droppedBytes(0)
+    , m_releases(0)
+    , m_reimports(0) {
+}
+
+BufferResidency::~BufferResidency() {
+}
+
+void BufferResidency::setBudget(uint64_t bytes) {
+    m_budget = bytes;
+}
+
+uint64_t BufferResidency::getBudget() const {
+    return m_budget;
+}
+
+void BufferResidency::setGracePeriod(int64_t gracePeriod) {
+    m_gracePeriod = std::max<int64_t>(0, gracePeriod);
+}
+
+int64_t BufferResidency::getGracePeriod() const {
+    return m_gracePeriod;
+}
+
+void BufferResidency::setWindow(uint64_t window, int width, int height, int bytesPerPixel) {
+    const uint64_t bytes = static_cast<uint64_t>(std::max(0, width)) * static_cast<uint64_t>(std::max(0, height))
+        * static_cast<uint64_t>(std::max(0, bytesPerPixel));
+
+    Entry& entry = m_entries[window];
+    uint64_t& total = entry.resident ? m_residentBytes : m_releasedBytes;
+    total = total - entry.bytes + bytes;
+    entry.bytes = bytes;
+}
+
+void BufferResidency::removeWindow(uint64_t window) {
+    auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    if (it->second.resident) {
+        m_residentBytes -= it->second.bytes;
+    } else {
+        m_releasedBytes -= it->second.bytes;
+    }
+    m_entries.erase(it);
+}
+
+bool BufferResidency::hasWindow(uint64_t window) const {
+    return m_entries.count(window) > 0;
+}
+
+bool BufferResidency::setHidden(uint64_t window, bool hidden, int64_t now) {
+    auto it = m_entries.find(window);
+    if (it == m_entries.end() || it->second.hidden == hidden) {
+        return false;
+    }
+
+    Entry& entry = it->second;
+    entry.hidden = hidden;
+    entry.hiddenSince = now;
+    if (hidden || entry.resident) {
+        return false;
+    }
+
+    makeResident(entry);
+    return true;
+}
+
+bool BufferResidency::isHidden(uint64_t window) const {
+    auto it = m_entries.find(window);
+    return it != m_entries.end() && it->second.hidden;
+}
+
+bool BufferResidency::isResident(uint64_t window) const {
+    auto it = m_entries.find(window);
+    return it == m_entries.end() || it->second.resident;
+}
+
+bool BufferResidency::reimport(uint64_t window, int64_t now) {
+    auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    Entry& entry = it->second;
+    entry.hiddenSince = now;
+    if (entry.resident) {
+        return false;
+    }
+
+    makeResident(entry);
+    return true;
+}
+
+std::vector<uint64_t> BufferResidency::takeReleases(int64_t now, const std::function<bool(uint64_t)>& canRelease) {
+    std::vector<std::pair<int64_t, uint64_t>> candidates;
+    for (const auto& item : m_entries) {
+        if (item.second.hidden && item.second.resident) {
+            candidates.emplace_back(item.second.hiddenSince, item.first);
+        }
+    }
+
+    // Longest hidden first, both for the grace period and under pressure
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<uint64_t> releases;
+    for (const auto& candidate : candidates) {
+        Entry& entry = m_entries.at(candidate.second);
+        const bool graceOver = now - entry.hiddenSince >= m_gracePeriod;
+        if (!graceOver && m_residentBytes <= m_budget) {
+            break;
+        }
+        if (canRelease && !canRelease(candidate.second)) {
+            continue;
+        }
+
+        entry.resident = false;
+        m_residentBytes -= entry.bytes;
+        m_releasedBytes += entry.bytes;
+        m_droppedBytes += entry.bytes;
+        releases.push_back(candidate.second);
+    }
+
+    m_releases += releases.size();
+    return releases;
+}
+
+int64_t BufferResidency::nextReleaseTime(int64_t now) const {
+    int64_t next = -1;
+    for (const auto& item : m_entries) {
+        const Entry& entry = item.second;
+        if (!entry.hidden || !entry.resident) {
+            continue;
+        }
+
+        // Over budget, every hidden window is due
+        if (m_residentBytes > m_budget) {
+            return now;
+        }
+
+        const int64_t due = std::max(now, entry.hiddenSince + m_gracePeriod);
+        if (next < 0 || due < next) {
+            next = due;
+        }
+    }
+    return next;
+}
+
+BufferResidency::Stats BufferResidency::getStats() const {
+    Stats stats;
+    stats.windows = m_entries.size();
+    for (const auto& item : m_entries) {
+        if (item.second.hidden) {
+            stats.hiddenWindows++;
+        }
+        if (!item.second.resident) {
+            stats.releasedWindows++;
+        }
+    }
+    stats.residentBytes = m_residentBytes;
+    stats.releasedBytes = m_releasedBytes;
+    stats.droppedBytes = m_droppedBytes;
+    stats.releases = m_releases;
+    stats.reimports = m_reimports;
+    stats.budget = m_budget;
+    return stats;
+}
+
+void BufferResidency::makeResident(Entry& entry) {
+    entry.resident = true;
+    m_releasedBytes -= entry.bytes;
+    m_residentBytes += entry.bytes;
+    m_reimports++;
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,205 @@
+// BufferResidency.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class BufferResidency
+ * @brief Decides when the buffers of hidden windows are released
+ *
+ * Minimized windows, windows on inactive workspaces and background tabs are
+ * not shown, yet their full-size client buffers and the textures imported
+ * from them stay resident. Once a window has been hidden for the grace
+ * period its buffers are released, keeping only its downscaled preview.
+ * While the buffers of all windows exceed the memory budget, hidden windows
+ * are released before their grace period is over, the longest hidden first.
+ * Visible windows are never released.
+ *
+ * A released window's buffers are imported again when it is shown, or on
+ * demand while it stays hidden.
+ *
+ * The policy only does the bookkeeping; the compositor drops and imports
+ * the buffers. Byte counts are of the full client buffers, but releasing
+ * only drops the compositor's references and imported copies: the client's
+ * current buffer stays attached to its surface, so its memory is freed
+ * only once the client lets go of it as well.
+ */
+class BufferResidency {
+public:
+    /**
+     * Residency statistics
+     */
+    struct Stats {
+        size_t windows = 0;             ///< Windows tracked
+        size_t hiddenWindows = 0;       ///< Windows not shown
+        size_t releasedWindows = 0;     ///< Windows whose buffers are released
+        uint64_t residentBytes = 0;     ///< Bytes of resident buffers
+        uint64_t releasedBytes = 0;     ///< Bytes of the buffers released at the moment
+        uint64_t droppedBytes = 0;      ///< Bytes released in total, as dropped references
+        uint64_t releases = 0;          ///< Windows released in total
+        uint64_t reimports = 0;         ///< Windows imported again in total
+        uint64_t budget = 0;            ///< Memory budget in bytes
+    };
+
+    /**
+     * Constructor
+     *
+     * @param budget Memory budget for the buffers of all windows, in bytes
+     * @param gracePeriod How long a window stays hidden before it is released, in nanoseconds
+     */
+    explicit BufferResidency(uint64_t budget = 512ull * 1024 * 1024, int64_t gracePeriod = 10000000000ll);
+
+    /**
+     * Destructor
+     */
+    ~BufferResidency();
+
+    /**
+     * Set the memory budget for the buffers of all windows
+     *
+     * @param bytes The budget in bytes
+     */
+    void setBudget(uint64_t bytes);
+
+    /**
+     * Get the memory budget
+     *
+     * @return The budget in bytes
+     */
+    uint64_t getBudget() const;
+
+    /**
+     * Set how long a window stays hidden before it is released
+     *
+     * @param gracePeriod The period in nanoseconds
+     */
+    void setGracePeriod(int64_t gracePeriod);
+
+    /**
+     * Get how long a window stays hidden before it is released
+     *
+     * @return The period in nanoseconds
+     */
+    int64_t getGracePeriod() const;
+
+    /**
+     * Add a visible window or change its buffer size
+     *
+     * @param window The window
+     * @param width The width of the window's buffer
+     * @param height The height of the window's buffer
+     * @param bytesPerPixel The bytes per pixel of the buffer
+     */
+    void setWindow(uint64_t window, int width, int height, int bytesPerPixel = 4);
+
+    /**
+     * Remove a window
+     *
+     * @param window The window
+     */
+    void removeWindow(uint64_t window);
+
+    /**
+     * Check if a window is tracked
+     *
+     * @param window The window
+     * @return True if the window was added
+     */
+    bool hasWindow(uint64_t window) const;
+
+    /**
+     * Hide or show a window
+     *
+     * @param window The window
+     * @param hidden True if the window is no longer shown
+     * @param now The current time in nanoseconds
+     * @return True if the window was shown and its buffers have to be imported again
+     */
+    bool setHidden(uint64_t window, bool hidden, int64_t now);
+
+    /**
+     * Check if a window is hidden
+     *
+     * @param window The window
+     * @return True if the window is not shown
+     */
+    bool isHidden(uint64_t window) const;
+
+    /**
+     * Check if a window's buffers are resident
+     *
+     * @param window The window
+     * @return True unless the window's buffers were released
+     */
+    bool isResident(uint64_t window) const;
+
+    /**
+     * Import the buffers of a hidden window again, e.g. for a live preview
+     *
+     * The window's grace period starts over.
+     *
+     * @param window The window
+     * @param now The current time in nanoseconds
+     * @return True if the window was released and has to be imported again
+     */
+    bool reimport(uint64_t window, int64_t now);
+
+    /**
+     * Take the windows whose buffers are to be released now
+     *
+     * The returned windows count as released.
+     *
+     * @param now The current time in nanoseconds
+     * @param canRelease Returns false for windows that aren't ready to be released yet; all are if empty
+     * @return The windows, longest hidden first
+     */
+    std::vector<uint64_t> takeReleases(int64_t now, const std::function<bool(uint64_t)>& canRelease = nullptr);
+
+    /**
+     * Get the time the next window is due for release
+     *
+     * @param now The current time in nanoseconds
+     * @return The time in nanoseconds, now if one is due already, or -1 if no window is hidden
+     */
+    int64_t nextReleaseTime(int64_t now) const;
+
+    /**
+     * Get the residency statistics
+     *
+     * @return The statistics
+     */
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        uint64_t bytes = 0;
+        bool hidden = false;
+        bool resident = true;
+        int64_t hiddenSince = 0;
+    };
+
+    void makeResident(Entry& entry);
+
+    uint64_t m_budget;
+    int64_t m_gracePeriod;
+
+    std::unordered_map<uint64_t, Entry> m_entries;
+
+    uint64_t m_residentBytes;
+    uint64_t m_releasedBytes;
+    uint64_t m_droppedBytes;
+    uint64_t m_releases;
+    uint64_t m_reimports;
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,302 @@
+// ClientAccounting.cpp
+#include "ClientAccounting.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+namespace {
+    // Request rates are measured over a sliding window of one second
+    const int64_t rateWindow = 1000000000ll;
+
+    const uint64_t MiB = 1024ull * 1024;
+
+    // Generous enough for heavy clients, e.g. a browser with hundreds of tabs
+    const ClientAccounting::Limit defaultLimits[ClientAccounting::ResourceCount] = {
+        { 1000, 4000 },             // Surfaces
+        { 1000, 4000 },             // Buffers
+        { 256, 1024 },              // DmabufImports
+        { 1024 * MiB, 4096 * MiB }, // ShmBytes
+        { 1024 * MiB, 2048 * MiB }, // TextureBytes
+        { 50000, 200000 },          // ProtocolObjects
+        { 50000, 250000 }           // RequestRate
+    };
+
+    const char* const resourceNames[ClientAccounting::ResourceCount] = {
+        "surfaces",
+        "buffers",
+        "dmabufImports",
+        "shmBytes",
+        "textureBytes",
+        "protocolObjects",
+        "requestRate"
+    };
+}
+
+ClientAccounting::ClientAccounting(int64_t gracePeriod)
+    : m_gracePeriod(std::max<int64_t>(0, gracePeriod))
+    , m_softLimitHits(0)
+    , m_hardLimitHits(0)
+    , m_disconnects(0)
+    , m_requests(0) {
+    std::copy(std::begin(defaultLimits), std::end(defaultLimits), m_limits);
+}
+
+ClientAccounting::~ClientAccounting() {
+}
+
+void ClientAccounting::setLimit(Resource resource, uint64_t soft, uint64_t hard) {
+    if (resource < 0 || resource >= ResourceCount) {
+        return;
+    }
+
+    m_limits[resource].soft = soft;
+    m_limits[resource].hard = hard;
+}
+
+ClientAccounting::Limit ClientAccounting::getLimit(Resource resource) const {
+    return resource >= 0 && resource < ResourceCount ? m_limits[resource] : Limit();
+}
+
+void ClientAccounting::setGracePeriod(int64_t gracePeriod) {
+    m_gracePeriod = std::max<int64_t>(0, gracePeriod);
+}
+
+int64_t ClientAccounting::getGracePeriod() const {
+    return m_gracePeriod;
+}
+
+void ClientAccounting::addClient(uint64_t client, int pid, int64_t now) {
+    Client& entry = m_clients[client];
+    entry.pid = pid;
+    entry.windowStart = now;
+}
+
+void ClientAccounting::removeClient(uint64_t client) {
+    if (m_clients.erase(client) == 0) {
+        return;
+    }
+
+    // Events of a client gone can't be acted upon
+    m_events.erase(std::remove_if(m_events.begin(), m_events.end(), [client](const Event& event) {
+        return event.client == client;
+    }), m_events.end());
+}
+
+bool ClientAccounting::hasClient(uint64_t client) const {
+    return m_clients.count(client) > 0;
+}
+
+ClientAccounting::Level ClientAccounting::set(uint64_t client, Resource resource, uint64_t value, int64_t now) {
+    auto it = m_clients.find(client);
+    if (it == m_clients.end() || resource < 0 || resource >= ResourceCount) {
+        return Normal;
+    }
+
+    return setValue(client, it->second, resource, value, now);
+}
+
+ClientAccounting::Level ClientAccounting::add(uint64_t client, Resource resource, int64_t delta, int64_t now) {
+    auto it = m_clients.find(client);
+    if (it == m_clients.end() || resource < 0 || resource >= ResourceCount) {
+        return Normal;
+    }
+
+    const uint64_t current = it->second.values[resource];
+    const uint64_t value = delta < 0 ? current - std::min(current, static_cast<uint64_t>(-delta))
+                                     : current + static_cast<uint64_t>(delta);
+    return setValue(client, it->second, resource, value, now);
+}
+
+ClientAccounting::Level ClientAccounting::request(uint64_t client, int64_t now, uint32_t count) {
+    auto it = m_clients.find(client);
+    if (it == m_clients.end()) {
+        return Normal;
+    }
+
+    Client& entry = it->second;
+    entry.requests += count;
+    m_requests += count;
+
+    const uint64_t rate = requestRate(entry, now) + count;
+    entry.currentRequests += count;
+
+    // Most requests leave the level as it is; skip the bookkeeping for them
+    if (entry.levels[RequestRate] == Normal && (m_limits[RequestRate].soft == 0 || rate <= m_limits[RequestRate].soft)
+        && (m_limits[RequestRate].hard == 0 || rate <= m_limits[RequestRate].hard)) {
+        entry.values[RequestRate] = rate;
+        return levelOf(entry);
+    }
+    return setValue(client, entry, RequestRate, rate, now);
+}
+
+uint64_t ClientAccounting::usage(uint64_t client, Resource resource) const {
+    auto it = m_clients.find(client);
+    if (it == m_clients.end() || resource < 0 || resource >= ResourceCount) {
+        return 0;
+    }
+
+    return it->second.values[resource];
+}
+
+ClientAccounting::Level ClientAccounting::level(uint64_t client) const {
+    auto it = m_clients.find(client);
+    return it != m_clients.end() ? levelOf(it->second) : Normal;
+}
+
+std::vector<ClientAccounting::Event> ClientAccounting::takeEvents() {
+    std::vector<Event> events;
+    events.swap(m_events);
+    return events;
+}
+
+std::vector<uint64_t> ClientAccounting::update(int64_t now) {
+    std::vector<uint64_t> expired;
+    for (auto& item : m_clients) {
+        Client& client = item.second;
+
+        // Rates fall while a client is idle
+        setValue(item.first, client, RequestRate, requestRate(client, now), now);
+
+        if (!client.disconnected && client.overHardLimitSince >= 0 && now - client.overHardLimitSince >= m_gracePeriod) {
+            client.disconnected = true;
+            m_disconnects++;
+            expired.push_back(item.first);
+        }
+    }
+
+    std::sort(expired.begin(), expired.end());
+    return expired;
+}
+
+std::vector<ClientAccounting::Usage> ClientAccounting::topClients(size_t count, Resource by) const {
+    std::vector<Usage> usages;
+    if (by < 0 || by >= ResourceCount) {
+        return usages;
+    }
+
+    usages.reserve(m_clients.size());
+    for (const auto& item : m_clients) {
+        usages.push_back(usageOf(item.first, item.second));
+    }
+
+    count = std::min(count, usages.size());
+    std::partial_sort(usages.begin(), usages.begin() + count, usages.end(), [by](const Usage& a, const Usage& b) {
+        if (a.values[by] != b.values[by]) {
+            return a.values[by] > b.values[by];
+        }
+        return a.client < b.client;
+    });
+    usages.resize(count);
+    return usages;
+}
+
+ClientAccounting::Stats ClientAccounting::getStats() const {
+    Stats stats;
+    stats.clients = m_clients.size();
+    for (const auto& item : m_clients) {
+        const Level level = levelOf(item.second);
+        if (level == OverSoftLimit) {
+            stats.clientsOverSoftLimit++;
+        } else if (level == OverHardLimit) {
+            stats.clientsOverHardLimit++;
+        }
+    }
+    stats.softLimitHits = m_softLimitHits;
+    stats.hardLimitHits = m_hardLimitHits;
+    stats.disconnects = m_disconnects;
+    stats.requests = m_requests;
+    return stats;
+}
+
+const char* ClientAccounting::resourceName(Resource resource) {
+    return resource >= 0 && resource < ResourceCount ? resourceNames[resource] : "";
+}
+
+ClientAccounting::Level ClientAccounting::setValue(uint64_t id, Client& client, Resource resource, uint64_t value, int64_t now) {
+    client.values[resource] = value;
+
+    const Limit& limit = m_limits[resource];
+    Level level = Normal;
+    if (limit.hard != 0 && value > limit.hard) {
+        level = OverHardLimit;
+    } else if (limit.soft != 0 && value > limit.soft) {
+        level = OverSoftLimit;
+    }
+
+    const Level previous = client.levels[resource];
+    if (level == previous) {
+        return levelOf(client);
+    }
+    client.levels[resource] = level;
+
+    if (level > previous) {
+        if (level == OverHardLimit) {
+            m_hardLimitHits++;
+        } else {
+            m_softLimitHits++;
+        }
+    }
+
+    // The grace period runs while any resource is over its hard limit
+    if (level == OverHardLimit) {
+        client.overHardLimit++;
+    } else if (previous == OverHardLimit) {
+        client.overHardLimit--;
+    }
+    if (client.overHardLimit == 0) {
+        client.overHardLimitSince = -1;
+    } else if (client.overHardLimitSince < 0) {
+        client.overHardLimitSince = now;
+    }
+
+    Event event;
+    event.client = id;
+    event.resource = resource;
+    event.level = level;
+    m_events.push_back(event);
+
+    return levelOf(client);
+}
+
+uint64_t ClientAccounting::requestRate(Client& client, int64_t now) {
+    // Move the window along; the requests of the previous window count in proportion to its overlap
+    const int64_t elapsed = now - client.windowStart;
+    if (elapsed >= 2 * rateWindow) {
+        client.previousRequests = 0;
+        client.currentRequests = 0;
+        client.windowStart = now;
+    } else if (elapsed >= rateWindow) {
+        client.previousRequests = client.currentRequests;
+        client.currentRequests = 0;
+        client.windowStart += rateWindow;
+    }
+
+    const int64_t overlap = rateWindow - std::max<int64_t>(0, now - client.windowStart);
+    return client.previousRequests * static_cast<uint64_t>(overlap) / rateWindow + client.currentRequests;
+}
+
+ClientAccounting::Usage ClientAccounting::usageOf(uint64_t id, const Client& client) const {
+    Usage usage;
+    usage.client = id;
+    usage.pid = client.pid;
+    std::copy(std::begin(client.values), std::end(client.values), usage.values);
+    usage.level = levelOf(client);
+    usage.requests = client.requests;
+    return usage;
+}
+
+ClientAccounting::Level ClientAccounting::levelOf(const Client& client) {
+    Level level = Normal;
+    for (Level resourceLevel : client.levels) {
+        level = std::max(level, resourceLevel);
+    }
+    return level;
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
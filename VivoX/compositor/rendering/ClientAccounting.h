@@ -0,0 +1,295 @@
+// ClientAccounting.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class ClientAccounting
+ * @brief Accounts the resources held by each client against soft and hard limits
+ *
+ * For every connected client the compositor reports how many surfaces,
+ * buffers, dmabuf imports and protocol objects it holds, how many bytes of
+ * shared memory it maps into the compositor and how many bytes of textures
+ * the compositor keeps for it, and every request it makes.
+ *
+ * A client going over a soft limit is reported, so the shell can warn about
+ * it. A client over a hard limit is disconnected unless it drops back under
+ * the limit within the grace period; one misbehaving client can then no
+ * longer exhaust the compositor's memory.
+ *
+ * The accounting only does the bookkeeping; the compositor measures the
+ * clients and disconnects them.
+ */
+class ClientAccounting {
+public:
+    /**
+     * Resources accounted per client
+     */
+    enum Resource {
+        Surfaces,           ///< wl_surface objects
+        Buffers,            ///< wl_buffer objects of any kind
+        DmabufImports,      ///< Buffers imported through zwp_linux_dmabuf_v1
+        ShmBytes,           ///< Bytes of the shared memory buffers
+        TextureBytes,       ///< Bytes of the textures the compositor holds for the client
+        ProtocolObjects,    ///< Protocol objects of any kind
+        RequestRate,        ///< Requests per second
+        ResourceCount
+    };
+
+    /**
+     * How far a client is over its limits
+     */
+    enum Level {
+        Normal,
+        OverSoftLimit,
+        OverHardLimit
+    };
+
+    /**
+     * Limits of one resource; 0 for none
+     */
+    struct Limit {
+        uint64_t soft = 0;
+        uint64_t hard = 0;
+    };
+
+    /**
+     * Resources held by one client
+     */
+    struct Usage {
+        uint64_t client = 0;
+        int pid = 0;
+        uint64_t values[ResourceCount] = {};
+        Level level = Normal;           ///< The highest level of any resource
+        uint64_t requests = 0;          ///< Requests in total
+    };
+
+    /**
+     * A client's resource going over or back under a limit
+     */
+    struct Event {
+        uint64_t client = 0;
+        Resource resource = Surfaces;
+        Level level = Normal;           ///< The resource's new level
+    };
+
+    /**
+     * Accounting statistics
+     */
+    struct Stats {
+        size_t clients = 0;                 ///< Clients connected
+        size_t clientsOverSoftLimit = 0;    ///< Clients over a soft limit only
+        size_t clientsOverHardLimit = 0;    ///< Clients over a hard limit
+        uint64_t softLimitHits = 0;         ///< Soft limits gone over in total
+        uint64_t hardLimitHits = 0;         ///< Hard limits gone over in total
+        uint64_t disconnects = 0;           ///< Clients disconnected in total
+        uint64_t requests = 0;              ///< Requests of all clients in total
+    };
+
+    /**
+     * Constructor
+     *
+     * All resources start with default limits.
+     *
+     * @param gracePeriod How long a client may stay over a hard limit before it is disconnected, in nanoseconds
+     */
+    explicit ClientAccounting(int64_t gracePeriod = 2000000000ll);
+
+    /**
+     * Destructor
+     */
+    ~ClientAccounting();
+
+    /**
+     * Set the limits of a resource
+     *
+     * Clients are measured against the new limits when their usage changes next.
+     *
+     * @param resource The resource
+     * @param soft The soft limit, 0 for none
+     * @param hard The hard limit, 0 for none
+     */
+    void setLimit(Resource resource, uint64_t soft, uint64_t hard);
+
+    /**
+     * Get the limits of a resource
+     *
+     * @param resource The resource
+     * @return The limits
+     */
+    Limit getLimit(Resource resource) const;
+
+    /**
+     * Set how long a client may stay over a hard limit
+     *
+     * @param gracePeriod The period in nanoseconds
+     */
+    void setGracePeriod(int64_t gracePeriod);
+
+    /**
+     * Get how long a client may stay over a hard limit
+     *
+     * @return The period in nanoseconds
+     */
+    int64_t getGracePeriod() const;
+
+    /**
+     * Start accounting a client
+     *
+     * @param client The client
+     * @param pid The client's process ID
+     * @param now The current time in nanoseconds
+     */
+    void addClient(uint64_t client, int pid, int64_t now);
+
+    /**
+     * Stop accounting a client, e.g. when it disconnects
+     *
+     * Events of the client not taken yet are dropped.
+     *
+     * @param client The client
+     */
+    void removeClient(uint64_t client);
+
+    /**
+     * Check if a client is accounted
+     *
+     * @param client The client
+     * @return True if the client was added
+     */
+    bool hasClient(uint64_t client) const;
+
+    /**
+     * Set the amount of a resource a client holds
+     *
+     * @param client The client
+     * @param resource The resource; the request rate is measured by request()
+     * @param value The amount
+     * @param now The current time in nanoseconds
+     * @return The client's level
+     */
+    Level set(uint64_t client, Resource resource, uint64_t value, int64_t now);
+
+    /**
+     * Change the amount of a resource a client holds
+     *
+     * @param client The client
+     * @param resource The resource
+     * @param delta The amount added, negative if released
+     * @param now The current time in nanoseconds
+     * @return The client's level
+     */
+    Level add(uint64_t client, Resource resource, int64_t delta, int64_t now);
+
+    /**
+     * Count requests of a client
+     *
+     * @param client The client
+     * @param now The current time in nanoseconds
+     * @param count The number of requests
+     * @return The client's level
+     */
+    Level request(uint64_t client, int64_t now, uint32_t count = 1);
+
+    /**
+     * Get the amount of a resource a client holds
+     *
+     * @param client The client
+     * @param resource The resource
+     * @return The amount, 0 if the client is unknown
+     */
+    uint64_t usage(uint64_t client, Resource resource) const;
+
+    /**
+     * Get how far a client is over its limits
+     *
+     * @param client The client
+     * @return The highest level of any of the client's resources
+     */
+    Level level(uint64_t client) const;
+
+    /**
+     * Take the limits gone over or back under since the last call
+     *
+     * @return The events, in the order they happened
+     */
+    std::vector<Event> takeEvents();
+
+    /**
+     * Bring the request rates up to date and find the clients to disconnect
+     *
+     * Called periodically, e.g. once a second. The returned clients count as
+     * disconnected and aren't returned again.
+     *
+     * @param now The current time in nanoseconds
+     * @return The clients over a hard limit for longer than the grace period
+     */
+    std::vector<uint64_t> update(int64_t now);
+
+    /**
+     * Get the clients using the most of a resource
+     *
+     * @param count The number of clients
+     * @param by The resource to rank the clients by
+     * @return The clients' usage, the highest first
+     */
+    std::vector<Usage> topClients(size_t count, Resource by) const;
+
+    /**
+     * Get the accounting statistics
+     *
+     * @return The statistics
+     */
+    Stats getStats() const;
+
+    /**
+     * Get the name of a resource
+     *
+     * @param resource The resource
+     * @return The name, e.g. "textureBytes"
+     */
+    static const char* resourceName(Resource resource);
+
+private:
+    struct Client {
+        int pid = 0;
+        uint64_t values[ResourceCount] = {};
+        Level levels[ResourceCount] = {};
+        int overHardLimit = 0;          // Resources over their hard limit
+        int64_t overHardLimitSince = -1;
+        bool disconnected = false;
+
+        // Requests in the current and the previous rate window
+        int64_t windowStart = 0;
+        uint64_t currentRequests = 0;
+        uint64_t previousRequests = 0;
+        uint64_t requests = 0;
+    };
+
+    Level setValue(uint64_t id, Client& client, Resource resource, uint64_t value, int64_t now);
+    static uint64_t requestRate(Client& client, int64_t now);
+    Usage usageOf(uint64_t id, const Client& client) const;
+    static Level levelOf(const Client& client);
+
+    Limit m_limits[ResourceCount];
+    int64_t m_gracePeriod;
+
+    std::unordered_map<uint64_t, Client> m_clients;
+    std::vector<Event> m_events;
+
+    uint64_t m_softLimitHits;
+    uint64_t m_hardLimitHits;
+    uint64_t m_disconnects;
+    uint64_t m_requests;
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,305 @@
+// FrameScheduler.cpp
+#include "FrameScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <time.h>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+namespace {
+    // Default margin between the end of rendering and the deadline (1.5 ms)
+    const int64_t defaultSafetyMargin = 1500000;
+
+    // Render time percentile used for the prediction
+    const double renderTimePercentile = 0.9;
+
+    // Weight of the newest sample in the smoothed frame rate
+    const double frameTimeSmoothing = 0.1;
+
+    int64_t refreshIntervalFromRate(int refreshRate) {
+        // Refresh rates are given in mHz
+        if (refreshRate <= 0) {
+            return 0;
+        }
+        return static_cast<int64_t>(1000000000000LL / refreshRate);
+    }
+}
+
+FrameScheduler::FrameScheduler()
+    : m_safetyMargin(defaultSafetyMargin) {
+}
+
+FrameScheduler::~FrameScheduler() {
+}
+
+int64_t FrameScheduler::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void FrameScheduler::addOutput(const std::string& output, int refreshRate) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    OutputState& state = m_outputs[output];
+    state.stats.refreshInterval = refreshIntervalFromRate(refreshRate);
+}
+
+void FrameScheduler::removeOutput(const std::string& output) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_outputs.erase(output);
+}
+
+bool FrameScheduler::hasOutput(const std::string& output) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_outputs.find(output) != m_outputs.end();
+}
+
+std::vector<std::string> FrameScheduler::getOutputs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<std::string> outputs;
+    outputs.reserve(m_outputs.size());
+    for (const auto& pair : m_outputs) {
+        outputs.push_back(pair.first);
+    }
+    return outputs;
+}
+
+void FrameScheduler::setRefreshRate(const std::string& output, int refreshRate) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        std::cerr << "FrameScheduler: unknown output " << output << std::endl;
+        return;
+    }
+
+    it->second.stats.refreshInterval = refreshIntervalFromRate(refreshRate);
+}
+
+void FrameScheduler::setAdaptiveSync(const std::string& output, bool enable, int minRefreshRate) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        std::cerr << "FrameScheduler: unknown output " << output << std::endl;
+        return;
+    }
+
+    it->second.stats.adaptiveSync = enable;
+    it->second.maxRefreshInterval = refreshIntervalFromRate(minRefreshRate);
+}
+
+void FrameScheduler::setContentDriven(const std::string& output, bool enable) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        std::cerr << "FrameScheduler: unknown output " << output << std::endl;
+        return;
+    }
+
+    it->second.stats.contentDriven = enable;
+}
+
+void FrameScheduler::setSafetyMargin(int64_t margin) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_safetyMargin = std::max<int64_t>(0, margin);
+}
+
+int64_t FrameScheduler::getSafetyMargin() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_safetyMargin;
+}
+
+int64_t FrameScheduler::nextPresentationTime(const std::string& output, int64_t time) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        return time;
+    }
+
+    return predictNextPresentation(it->second, time);
+}
+
+int64_t FrameScheduler::nextRenderStart(const std::string& output, int64_t time) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        return time;
+    }
+
+    const OutputState& state = it->second;
+    if (state.stats.refreshInterval <= 0 || state.stats.lastPresentationTime == 0) {
+        // Phase unknown, render right away
+        return time;
+    }
+
+    // Start as late as possible while still making the next vblank; with
+    // variable refresh the panel waits for us and that is as soon as allowed
+    int64_t deadline = predictNextPresentation(state, time);
+    int64_t start = deadline - predictRenderTime(state) - m_safetyMargin;
+
+    return std::max(start, time);
+}
+
+void FrameScheduler::waitForRenderStart(const std::string& output) const {
+    int64_t current = now();
+    int64_t start = nextRenderStart(output, current);
+
+    if (start > current) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(start - current));
+    }
+}
+
+void FrameScheduler::renderStarted(const std::string& output, int64_t time) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        return;
+    }
+
+    OutputState& state = it->second;
+    state.renderStart = time;
+
+    // The frame aims for the first vblank after composition started
+    state.pendingTarget = state.stats.lastPresentationTime != 0 ? predictNextPresentation(state, time) : 0;
+}
+
+void FrameScheduler::renderFinished(const std::string& output, int64_t time) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end() || it->second.renderStart == 0) {
+        return;
+    }
+
+    OutputState& state = it->second;
+    int64_t duration = std::max<int64_t>(0, time - state.renderStart);
+
+    // Record the render time in the ring buffer
+    state.renderHistory[state.renderHistoryIndex] = duration;
+    state.renderHistoryIndex = (state.renderHistoryIndex + 1) % RenderHistorySize;
+    state.renderHistoryCount = std::min(state.renderHistoryCount + 1, RenderHistorySize);
+
+    state.stats.lastRenderTime = duration;
+    state.stats.predictedRenderTime = predictRenderTime(state);
+
+    // The frame is now queued for presentation
+    state.targetPresentation = state.pendingTarget;
+    state.renderStart = 0;
+}
+
+void FrameScheduler::presented(const std::string& output, int64_t time, uint64_t sequence,
+                               int64_t refreshInterval, bool hardwareClock) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        return;
+    }
+
+    OutputState& state = it->second;
+    OutputStats& stats = state.stats;
+
+    if (refreshInterval > 0) {
+        stats.refreshInterval = refreshInterval;
+    } else if (hardwareClock && stats.hardwareClock && sequence > stats.lastSequence && stats.lastPresentationTime != 0) {
+        // Derive the refresh interval from consecutive vblanks
+        stats.refreshInterval = (time - stats.lastPresentationTime) / static_cast<int64_t>(sequence - stats.lastSequence);
+    }
+
+    // A frame shown more than half a refresh after its target missed its vblank
+    if (state.targetPresentation != 0 && time > state.targetPresentation + stats.refreshInterval / 2) {
+        stats.missedDeadlines++;
+    }
+    state.targetPresentation = 0;
+
+    // Smooth the presentation interval into frame time and frame rate
+    if (stats.lastPresentationTime != 0 && time > stats.lastPresentationTime) {
+        int64_t interval = time - stats.lastPresentationTime;
+        stats.averageFrameTime = stats.averageFrameTime == 0
+            ? interval
+            : static_cast<int64_t>(stats.averageFrameTime + frameTimeSmoothing * (interval - stats.averageFrameTime));
+        stats.frameRate = 1000000000.0f / static_cast<float>(stats.averageFrameTime);
+    }
+
+    stats.framesPresented++;
+    stats.lastPresentationTime = time;
+    stats.lastSequence = sequence;
+    stats.hardwareClock = hardwareClock;
+}
+
+FrameScheduler::OutputStats FrameScheduler::getStats(const std::string& output) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_outputs.find(output);
+    if (it == m_outputs.end()) {
+        return OutputStats();
+    }
+
+    return it->second.stats;
+}
+
+int64_t FrameScheduler::predictNextPresentation(const OutputState& state, int64_t time) const {
+    int64_t refresh = state.stats.refreshInterval;
+    int64_t last = state.stats.lastPresentationTime;
+
+    if (refresh <= 0 || last == 0) {
+        return time;
+    }
+
+    if (isVariableRefresh(state)) {
+        // No fixed phase: the next frame can go out once the minimum interval has passed
+        int64_t earliest = last + refresh;
+
+        // Past the longest interval the panel repeated the last frame, which has to finish scanning out first
+        int64_t longest = state.maxRefreshInterval;
+        if (longest > refresh && time >= last + longest) {
+            earliest = last + (time - last) / longest * longest + refresh;
+        }
+        return std::max(time, earliest);
+    }
+
+    if (time < last) {
+        return last;
+    }
+
+    // First vblank strictly after the reference time
+    int64_t cycles = (time - last) / refresh + 1;
+    return last + cycles * refresh;
+}
+
+bool FrameScheduler::isVariableRefresh(const OutputState& state) const {
+    return state.stats.adaptiveSync && state.stats.contentDriven;
+}
+
+int64_t FrameScheduler::predictRenderTime(const OutputState& state) const {
+    int64_t refresh = state.stats.refreshInterval;
+
+    // Without history assume the worst and render right after the previous vblank
+    if (state.renderHistoryCount == 0) {
+        return refresh;
+    }
+
+    // Use a high percentile so occasional slow frames don't miss the deadline
+    std::vector<int64_t> samples(state.renderHistory, state.renderHistory + state.renderHistoryCount);
+    size_t index = static_cast<size_t>(renderTimePercentile * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+
+    int64_t predicted = samples[index];
+    return refresh > 0 ? std::min(predicted, refresh) : predicted;
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,231 @@
+// FrameScheduler.h
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class FrameScheduler
+ * @brief Per-output frame scheduler driven by presentation feedback
+ *
+ * Each output keeps its own vblank phase (taken from presentation timestamps)
+ * and a short history of render times. From these the scheduler predicts the
+ * next presentation deadline and the latest moment composition can start and
+ * still make it, so frames are rendered as close to scanout as is safe.
+ *
+ * All timestamps are CLOCK_MONOTONIC nanoseconds, the same clock advertised
+ * to clients by wp_presentation.
+ */
+class FrameScheduler {
+public:
+    /**
+     * Per-output scheduling statistics
+     */
+    struct OutputStats {
+        uint64_t framesPresented = 0;       ///< Frames presented on the output
+        uint64_t missedDeadlines = 0;       ///< Frames presented after the vblank they targeted
+        uint64_t lastSequence = 0;          ///< Sequence number of the last presentation
+        int64_t refreshInterval = 0;        ///< Refresh interval in nanoseconds
+        int64_t lastPresentationTime = 0;   ///< Timestamp of the last presentation
+        int64_t lastRenderTime = 0;         ///< Duration of the last frame in nanoseconds
+        int64_t predictedRenderTime = 0;    ///< Render time budgeted for the next frame
+        int64_t averageFrameTime = 0;       ///< Smoothed interval between presentations in nanoseconds
+        float frameRate = 0.0f;             ///< Smoothed presentation rate in frames per second
+        bool hardwareClock = false;         ///< Whether timestamps come from the display hardware
+        bool adaptiveSync = false;          ///< Whether variable refresh is active
+        bool contentDriven = false;         ///< Whether a fullscreen client drives the refresh
+    };
+
+    /**
+     * Constructor
+     */
+    FrameScheduler();
+
+    /**
+     * Destructor
+     */
+    ~FrameScheduler();
+
+    /**
+     * Get the current CLOCK_MONOTONIC time
+     *
+     * @return The current time in nanoseconds
+     */
+    static int64_t now();
+
+    /**
+     * Add an output to the scheduler
+     *
+     * @param output The output name
+     * @param refreshRate The refresh rate in mHz (60000 = 60Hz)
+     */
+    void addOutput(const std::string& output, int refreshRate);
+
+    /**
+     * Remove an output from the scheduler
+     *
+     * @param output The output name
+     */
+    void removeOutput(const std::string& output);
+
+    /**
+     * Check if an output is known to the scheduler
+     *
+     * @param output The output name
+     * @return True if the output exists, false otherwise
+     */
+    bool hasOutput(const std::string& output) const;
+
+    /**
+     * Get the names of all scheduled outputs
+     *
+     * @return A vector of output names
+     */
+    std::vector<std::string> getOutputs() const;
+
+    /**
+     * Set the nominal refresh rate of an output
+     *
+     * @param output The output name
+     * @param refreshRate The refresh rate in mHz
+     * @note Presentation feedback that reports a refresh interval overrides this
+     */
+    void setRefreshRate(const std::string& output, int refreshRate);
+
+    /**
+     * Enable or disable adaptive sync (variable refresh) for an output
+     *
+     * With adaptive sync the output has no fixed vblank phase; once content
+     * drives the refresh (see setContentDriven) a frame can be presented as
+     * soon as the maximum refresh rate allows. Below the minimum refresh rate
+     * the panel refreshes on its own, and the next frame has to wait for that
+     * scanout to finish.
+     *
+     * @param output The output name
+     * @param enable Whether to enable adaptive sync
+     * @param minRefreshRate The lowest refresh rate of the panel in mHz, 0 if unknown
+     */
+    void setAdaptiveSync(const std::string& output, bool enable, int minRefreshRate = 0);
+
+    /**
+     * Let the content of an output drive its refresh rate
+     *
+     * Used for fullscreen games: with adaptive sync enabled, a frame is
+     * composed as soon as the client commits instead of on the nominal
+     * refresh cadence. Without adaptive sync this has no effect.
+     *
+     * @param output The output name
+     * @param enable Whether content drives the refresh rate
+     */
+    void setContentDriven(const std::string& output, bool enable);
+
+    /**
+     * Set the safety margin kept between the end of rendering and the deadline
+     *
+     * @param margin The margin in nanoseconds
+     */
+    void setSafetyMargin(int64_t margin);
+
+    /**
+     * Get the safety margin
+     *
+     * @return The margin in nanoseconds
+     */
+    int64_t getSafetyMargin() const;
+
+    /**
+     * Predict the next presentation time of an output
+     *
+     * @param output The output name
+     * @param time The reference time in nanoseconds
+     * @return The first predicted vblank after the reference time, or the
+     *         reference time itself if the output phase is unknown
+     */
+    int64_t nextPresentationTime(const std::string& output, int64_t time) const;
+
+    /**
+     * Get the latest time composition for an output may start
+     *
+     * @param output The output name
+     * @param time The reference time in nanoseconds
+     * @return The start time in nanoseconds, never earlier than the reference time
+     */
+    int64_t nextRenderStart(const std::string& output, int64_t time) const;
+
+    /**
+     * Block until composition for an output should start
+     *
+     * @param output The output name
+     */
+    void waitForRenderStart(const std::string& output) const;
+
+    /**
+     * Record that composition for an output has started
+     *
+     * @param output The output name
+     * @param time The start time in nanoseconds
+     */
+    void renderStarted(const std::string& output, int64_t time);
+
+    /**
+     * Record that composition for an output has finished
+     *
+     * @param output The output name
+     * @param time The finish time in nanoseconds
+     */
+    void renderFinished(const std::string& output, int64_t time);
+
+    /**
+     * Feed presentation feedback for an output
+     *
+     * @param output The output name
+     * @param time The presentation (vblank) timestamp in nanoseconds
+     * @param sequence The vblank sequence number
+     * @param refreshInterval The measured refresh interval in nanoseconds (0 if unknown)
+     * @param hardwareClock Whether the timestamp comes from the display hardware
+     */
+    void presented(const std::string& output, int64_t time, uint64_t sequence,
+                   int64_t refreshInterval = 0, bool hardwareClock = true);
+
+    /**
+     * Get the scheduling statistics of an output
+     *
+     * @param output The output name
+     * @return The statistics, or default values if the output is unknown
+     */
+    OutputStats getStats(const std::string& output) const;
+
+private:
+    // Number of render time samples kept per output
+    static constexpr size_t RenderHistorySize = 32;
+
+    struct OutputState {
+        OutputStats stats;
+        int64_t renderStart = 0;
+        int64_t targetPresentation = 0;
+        int64_t pendingTarget = 0;
+        int64_t maxRefreshInterval = 0;
+        int64_t renderHistory[RenderHistorySize] = {};
+        size_t renderHistoryCount = 0;
+        size_t renderHistoryIndex = 0;
+    };
+
+    int64_t predictNextPresentation(const OutputState& state, int64_t time) const;
+    int64_t predictRenderTime(const OutputState& state) const;
+    bool isVariableRefresh(const OutputState& state) const;
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, OutputState> m_outputs;
+    int64_t m_safetyMargin;
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
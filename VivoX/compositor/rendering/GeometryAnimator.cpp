@@ -0,0 +1,273 @@
+// GeometryAnimator.cpp
+#include "GeometryAnimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+namespace {
+    // Default time the resized buffer takes to fade in (100 ms)
+    const int64_t defaultCrossfadeDuration = 100000000;
+
+    // Default time a resized buffer is waited for after the geometry animation (1 s)
+    const int64_t defaultResizeTimeout = 1000000000;
+
+    float ease(GeometryAnimator::Curve curve, float t) {
+        switch (curve) {
+        case GeometryAnimator::Curve::EaseOutCubic: {
+            const float u = 1.0f - t;
+            return 1.0f - u * u * u;
+        }
+        case GeometryAnimator::Curve::EaseInOutCubic: {
+            if (t < 0.5f) {
+                return 4.0f * t * t * t;
+            }
+            const float u = 2.0f - 2.0f * t;
+            return 1.0f - u * u * u * 0.5f;
+        }
+        case GeometryAnimator::Curve::Linear:
+        default:
+            return t;
+        }
+    }
+
+    float progress(int64_t now, int64_t start, int64_t duration) {
+        if (duration <= 0) {
+            return 1.0f;
+        }
+        return std::clamp(static_cast<float>(now - start) / static_cast<float>(duration), 0.0f, 1.0f);
+    }
+
+    float scale(float shown, float buffer) {
+        return buffer > 0.0f ? shown / buffer : 1.0f;
+    }
+
+    bool sameSize(float width, float height, float otherWidth, float otherHeight) {
+        return std::lround(width) == std::lround(otherWidth) && std::lround(height) == std::lround(otherHeight);
+    }
+}
+
+GeometryAnimator::GeometryAnimator(int64_t duration, Curve curve, size_t capacity)
+    : m_duration(std::max<int64_t>(0, duration))
+    , m_curve(curve)
+    , m_crossfadeDuration(defaultCrossfadeDuration)
+    , m_resizeTimeout(defaultResizeTimeout)
+    , m_started(0)
+    , m_retargeted(0)
+    , m_crossfades(0)
+    , m_timedOut(0)
+    , m_finished(0) {
+    m_animations.reserve(capacity);
+    m_transforms.reserve(capacity);
+    m_indices.reserve(capacity);
+}
+
+GeometryAnimator::~GeometryAnimator() {
+}
+
+void GeometryAnimator::setDuration(int64_t duration) {
+    m_duration = std::max<int64_t>(0, duration);
+}
+
+int64_t GeometryAnimator::getDuration() const {
+    return m_duration;
+}
+
+void GeometryAnimator::setCurve(Curve curve) {
+    m_curve = curve;
+}
+
+GeometryAnimator::Curve GeometryAnimator::getCurve() const {
+    return m_curve;
+}
+
+void GeometryAnimator::setCrossfadeDuration(int64_t duration) {
+    m_crossfadeDuration = std::max<int64_t>(0, duration);
+}
+
+void GeometryAnimator::setResizeTimeout(int64_t timeout) {
+    m_resizeTimeout = std::max<int64_t>(0, timeout);
+}
+
+bool GeometryAnimator::animate(uint64_t window, const Rect& from, const Rect& to, int64_t now) {
+    auto it = m_indices.find(window);
+    if (it == m_indices.end()) {
+        if (from.x == to.x && from.y == to.y && from.width == to.width && from.height == to.height) {
+            return false;
+        }
+
+        // The buffer on screen keeps being drawn until the client catches up
+        Animation animation;
+        animation.from = from;
+        animation.to = to;
+        animation.start = now;
+        animation.duration = m_duration;
+        animation.curve = m_curve;
+        animation.oldWidth = from.width;
+        animation.oldHeight = from.height;
+        animation.needsBuffer = !sameSize(from.width, from.height, to.width, to.height);
+
+        m_indices.emplace(window, m_animations.size());
+        m_animations.push_back(animation);
+        m_transforms.emplace_back();
+        m_transforms.back().window = window;
+        evaluate(m_animations.back(), m_transforms.back(), now);
+
+        m_started++;
+        return animation.needsBuffer;
+    }
+
+    // Continue from where the window is now, so it doesn't jump
+    Animation& animation = m_animations[it->second];
+    Transform& transform = m_transforms[it->second];
+    evaluate(animation, transform, now);
+
+    // Once the client's resized buffer is shown, that is the one to keep
+    bool keepBuffer = false;
+    if (animation.crossfadeStart >= 0 || !animation.needsBuffer) {
+        animation.oldWidth = animation.to.width;
+        animation.oldHeight = animation.to.height;
+        keepBuffer = true;
+    }
+
+    animation.from = transform.rect;
+    animation.to = to;
+    animation.start = now;
+    animation.duration = m_duration;
+    animation.curve = m_curve;
+    animation.crossfadeStart = -1;
+    animation.needsBuffer = !sameSize(animation.oldWidth, animation.oldHeight, to.width, to.height);
+    evaluate(animation, transform, now);
+
+    m_retargeted++;
+    return keepBuffer && animation.needsBuffer;
+}
+
+bool GeometryAnimator::bufferCommitted(uint64_t window, int width, int height, int64_t now) {
+    auto it = m_indices.find(window);
+    if (it == m_indices.end()) {
+        return false;
+    }
+
+    Animation& animation = m_animations[it->second];
+    if (!animation.needsBuffer || animation.crossfadeStart >= 0
+        || !sameSize(static_cast<float>(width), static_cast<float>(height), animation.to.width, animation.to.height)) {
+        return false;
+    }
+
+    animation.crossfadeStart = now;
+    m_crossfades++;
+    return true;
+}
+
+void GeometryAnimator::cancel(uint64_t window) {
+    auto it = m_indices.find(window);
+    if (it != m_indices.end()) {
+        removeAt(it->second);
+    }
+}
+
+bool GeometryAnimator::isAnimating(uint64_t window) const {
+    auto it = m_indices.find(window);
+    return it != m_indices.end() && !m_transforms[it->second].finished;
+}
+
+size_t GeometryAnimator::update(int64_t now) {
+    // Finished animations were drawn at their target in the previous frame
+    for (size_t i = m_transforms.size(); i-- > 0;) {
+        if (m_transforms[i].finished) {
+            removeAt(i);
+        }
+    }
+
+    for (size_t i = 0; i < m_animations.size(); ++i) {
+        const Animation& animation = m_animations[i];
+        Transform& transform = m_transforms[i];
+        evaluate(animation, transform, now);
+
+        if (transform.finished) {
+            m_finished++;
+            if (animation.needsBuffer && animation.crossfadeStart < 0) {
+                m_timedOut++;
+            }
+        }
+    }
+
+    return m_transforms.size();
+}
+
+const std::vector<GeometryAnimator::Transform>& GeometryAnimator::getTransforms() const {
+    return m_transforms;
+}
+
+const GeometryAnimator::Transform* GeometryAnimator::getTransform(uint64_t window) const {
+    auto it = m_indices.find(window);
+    return it != m_indices.end() ? &m_transforms[it->second] : nullptr;
+}
+
+GeometryAnimator::Stats GeometryAnimator::getStats() const {
+    Stats stats;
+    for (const Transform& transform : m_transforms) {
+        if (!transform.finished) {
+            stats.active++;
+        }
+    }
+    stats.started = m_started;
+    stats.retargeted = m_retargeted;
+    stats.crossfades = m_crossfades;
+    stats.timedOut = m_timedOut;
+    stats.finished = m_finished;
+    return stats;
+}
+
+void GeometryAnimator::evaluate(const Animation& animation, Transform& transform, int64_t now) const {
+    const float t = progress(now, animation.start, animation.duration);
+    const float e = ease(animation.curve, t);
+
+    transform.rect.x = animation.from.x + (animation.to.x - animation.from.x) * e;
+    transform.rect.y = animation.from.y + (animation.to.y - animation.from.y) * e;
+    transform.rect.width = animation.from.width + (animation.to.width - animation.from.width) * e;
+    transform.rect.height = animation.from.height + (animation.to.height - animation.from.height) * e;
+
+    transform.oldScaleX = scale(transform.rect.width, animation.oldWidth);
+    transform.oldScaleY = scale(transform.rect.height, animation.oldHeight);
+    transform.newScaleX = scale(transform.rect.width, animation.to.width);
+    transform.newScaleY = scale(transform.rect.height, animation.to.height);
+
+    if (!animation.needsBuffer) {
+        transform.crossfade = 1.0f;
+    } else if (animation.crossfadeStart >= 0) {
+        transform.crossfade = progress(now, animation.crossfadeStart, m_crossfadeDuration);
+    } else {
+        transform.crossfade = 0.0f;
+    }
+
+    // A client that doesn't resize in time is shown as it is
+    const bool timedOut = t >= 1.0f && animation.crossfadeStart < 0
+        && now - (animation.start + animation.duration) >= m_resizeTimeout;
+    if (timedOut) {
+        transform.crossfade = 1.0f;
+    }
+
+    transform.finished = t >= 1.0f && transform.crossfade >= 1.0f;
+}
+
+void GeometryAnimator::removeAt(size_t index) {
+    m_indices.erase(m_transforms[index].window);
+
+    const size_t last = m_transforms.size() - 1;
+    if (index != last) {
+        m_animations[index] = m_animations[last];
+        m_transforms[index] = m_transforms[last];
+        m_indices.find(m_transforms[index].window)->second = index;
+    }
+    m_animations.pop_back();
+    m_transforms.pop_back();
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
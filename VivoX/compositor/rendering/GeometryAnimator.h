@@ -0,0 +1,240 @@
+// GeometryAnimator.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class GeometryAnimator
+ * @brief Animates window geometry changes on the compositor side
+ *
+ * When a relayout moves or resizes a window, the client is configured to
+ * the new size at once, but its new buffer may take several frames to
+ * arrive. Meanwhile the compositor keeps the window's last buffer and draws
+ * it scaled into a rectangle interpolated from the old geometry to the new
+ * one, at the display's refresh rate. Once the client commits a buffer of
+ * the new size, it is crossfaded in over the old one.
+ *
+ * All animations are evaluated together once per frame by update(), which
+ * writes into a buffer reserved up front and doesn't allocate.
+ *
+ * The animator only computes the transforms; the compositor draws them.
+ */
+class GeometryAnimator {
+public:
+    /**
+     * Easing curves
+     */
+    enum class Curve {
+        Linear,
+        EaseOutCubic,
+        EaseInOutCubic
+    };
+
+    /**
+     * A rectangle in output coordinates
+     */
+    struct Rect {
+        float x = 0.0f;
+        float y = 0.0f;
+        float width = 0.0f;
+        float height = 0.0f;
+    };
+
+    /**
+     * Where and how to draw an animated window in the current frame
+     */
+    struct Transform {
+        uint64_t window = 0;    ///< The window
+        Rect rect;              ///< The interpolated geometry
+        float oldScaleX = 1.0f; ///< Horizontal scale of the buffer kept from before the change
+        float oldScaleY = 1.0f; ///< Vertical scale of the buffer kept from before the change
+        float newScaleX = 1.0f; ///< Horizontal scale of the client's buffer at the new size
+        float newScaleY = 1.0f; ///< Vertical scale of the client's buffer at the new size
+        float crossfade = 0.0f; ///< Opacity of the new buffer over the old one
+        bool finished = false;  ///< True in the last frame of the animation
+    };
+
+    /**
+     * Animation statistics
+     */
+    struct Stats {
+        size_t active = 0;          ///< Animations running
+        uint64_t started = 0;       ///< Animations started in total
+        uint64_t retargeted = 0;    ///< Animations given a new target while running
+        uint64_t crossfades = 0;    ///< Crossfades to a resized buffer
+        uint64_t timedOut = 0;      ///< Animations finished without the client's resized buffer
+        uint64_t finished = 0;      ///< Animations finished in total
+    };
+
+    /**
+     * Constructor
+     *
+     * @param duration The duration of a geometry animation in nanoseconds
+     * @param curve The easing curve
+     * @param capacity The number of animations reserved for up front
+     */
+    explicit GeometryAnimator(int64_t duration = 250000000, Curve curve = Curve::EaseOutCubic, size_t capacity = 64);
+
+    /**
+     * Destructor
+     */
+    ~GeometryAnimator();
+
+    /**
+     * Set the duration of geometry animations started from now on
+     *
+     * @param duration The duration in nanoseconds
+     */
+    void setDuration(int64_t duration);
+
+    /**
+     * Get the duration of geometry animations
+     *
+     * @return The duration in nanoseconds
+     */
+    int64_t getDuration() const;
+
+    /**
+     * Set the easing curve of animations started from now on
+     *
+     * @param curve The curve
+     */
+    void setCurve(Curve curve);
+
+    /**
+     * Get the easing curve
+     *
+     * @return The curve
+     */
+    Curve getCurve() const;
+
+    /**
+     * Set how long the resized buffer takes to fade in
+     *
+     * @param duration The duration in nanoseconds
+     */
+    void setCrossfadeDuration(int64_t duration);
+
+    /**
+     * Set how long after the geometry animation a resized buffer is waited for
+     *
+     * Slow clients then snap to their buffer once it arrives.
+     *
+     * @param timeout The timeout in nanoseconds
+     */
+    void setResizeTimeout(int64_t timeout);
+
+    /**
+     * Animate a window from one geometry to another
+     *
+     * A window already animating is retargeted from where it is now.
+     *
+     * @param window The window
+     * @param from The geometry shown until now
+     * @param to The new geometry
+     * @param now The current time in nanoseconds
+     * @return True if the window's current buffer has to be kept as the old buffer
+     */
+    bool animate(uint64_t window, const Rect& from, const Rect& to, int64_t now);
+
+    /**
+     * Tell the animator that a window's client committed a buffer
+     *
+     * @param window The window
+     * @param width The width of the buffer
+     * @param height The height of the buffer
+     * @param now The current time in nanoseconds
+     * @return True if the buffer has the new size and the crossfade starts
+     */
+    bool bufferCommitted(uint64_t window, int width, int height, int64_t now);
+
+    /**
+     * Stop animating a window; it is drawn at its new geometry right away
+     *
+     * @param window The window
+     */
+    void cancel(uint64_t window);
+
+    /**
+     * Check if a window is animating
+     *
+     * @param window The window
+     * @return True if an animation of the window is running
+     */
+    bool isAnimating(uint64_t window) const;
+
+    /**
+     * Evaluate every animation for a frame
+     *
+     * Animations reported finished by the previous update are dropped first.
+     *
+     * @param now The presentation time of the frame in nanoseconds
+     * @return The number of transforms of the frame
+     */
+    size_t update(int64_t now);
+
+    /**
+     * Get the transforms of the last update
+     *
+     * @return The transforms, valid until the next call of a non-const method
+     */
+    const std::vector<Transform>& getTransforms() const;
+
+    /**
+     * Get the transform of a window in the last update
+     *
+     * @param window The window
+     * @return The transform, or nullptr if the window isn't animating
+     */
+    const Transform* getTransform(uint64_t window) const;
+
+    /**
+     * Get the animation statistics
+     *
+     * @return The statistics
+     */
+    Stats getStats() const;
+
+private:
+    struct Animation {
+        Rect from;
+        Rect to;
+        int64_t start = 0;
+        int64_t duration = 0;
+        Curve curve = Curve::Linear;
+        float oldWidth = 0.0f;
+        float oldHeight = 0.0f;
+        bool needsBuffer = false;
+        int64_t crossfadeStart = -1;
+    };
+
+    void evaluate(const Animation& animation, Transform& transform, int64_t now) const;
+    void removeAt(size_t index);
+
+    int64_t m_duration;
+    Curve m_curve;
+    int64_t m_crossfadeDuration;
+    int64_t m_resizeTimeout;
+
+    // Parallel arrays; the map points into both
+    std::vector<Animation> m_animations;
+    std::vector<Transform> m_transforms;
+    std::unordered_map<uint64_t, size_t> m_indices;
+
+    uint64_t m_started;
+    uint64_t m_retargeted;
+    uint64_t m_crossfades;
+    uint64_t m_timedOut;
+    uint64_t m_finished;
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
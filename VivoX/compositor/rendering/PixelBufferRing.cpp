@@ -0,0 +1,191 @@
+// PixelBufferRing.cpp
+#include "PixelBufferRing.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <EGL/egl.h>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+namespace {
+    const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    bool hasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension && std::strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Buffer storage is core since GL 4.4, an extension before
+    PFNGLBUFFERSTORAGEPROC bufferStorageFunction() {
+        GLint major = 0;
+        GLint minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+        const char* name = nullptr;
+        if (major > 4 || (major == 4 && minor >= 4) || hasExtension("GL_ARB_buffer_storage")) {
+            name = "glBufferStorage";
+        } else if (hasExtension("GL_EXT_buffer_storage")) {
+            name = "glBufferStorageEXT";
+        } else {
+            return nullptr;
+        }
+        return reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(eglGetProcAddress(name));
+    }
+}
+
+PixelBufferRing::PixelBufferRing(size_t segmentSize, int segments)
+    : m_segmentSize(segmentSize)
+    , m_segments(segments > 0 ? segments : 1)
+    , m_buffer(0)
+    , m_data(nullptr)
+    , m_segment(0)
+    , m_used(0)
+    , m_ready(true) {
+}
+
+PixelBufferRing::~PixelBufferRing() {
+    release();
+}
+
+bool PixelBufferRing::initialize() {
+    if (m_data) {
+        return true;
+    }
+
+    PFNGLBUFFERSTORAGEPROC bufferStorage = bufferStorageFunction();
+    if (!bufferStorage) {
+        std::cerr << "Persistent buffer mapping not supported, uploading textures directly" << std::endl;
+        return false;
+    }
+
+    const size_t size = m_segmentSize * m_segments;
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    bufferStorage(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, mapFlags);
+    void* data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size), mapFlags);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (!data) {
+        std::cerr << "Could not map the pixel buffer ring" << std::endl;
+        glDeleteBuffers(1, &buffer);
+        return false;
+    }
+
+    m_buffer = buffer;
+    m_data = static_cast<uint8_t*>(data);
+    m_fences.assign(m_segments, nullptr);
+    m_segment = 0;
+    m_used = 0;
+    m_ready = true;
+    m_stats.size = size;
+    return true;
+}
+
+void PixelBufferRing::release() {
+    for (void* fence : m_fences) {
+        if (fence) {
+            glDeleteSync(static_cast<GLsync>(fence));
+        }
+    }
+    m_fences.clear();
+
+    if (m_buffer) {
+        // A persistent mapping ends with the buffer
+        GLuint buffer = m_buffer;
+        glDeleteBuffers(1, &buffer);
+        m_buffer = 0;
+    }
+    m_data = nullptr;
+    m_stats.size = 0;
+}
+
+bool PixelBufferRing::isValid() const {
+    return m_data != nullptr;
+}
+
+PixelBufferRing::Allocation PixelBufferRing::allocate(size_t bytes, size_t alignment) {
+    Allocation allocation;
+    if (!m_data || bytes == 0) {
+        return allocation;
+    }
+
+    if (!segmentReady()) {
+        m_stats.busy++;
+        return allocation;
+    }
+
+    alignment = alignment > 0 ? alignment : 1;
+    const size_t offset = (m_used + alignment - 1) / alignment * alignment;
+    if (bytes > m_segmentSize || offset > m_segmentSize - bytes) {
+        m_stats.overflows++;
+        return allocation;
+    }
+
+    m_used = offset + bytes;
+    allocation.buffer = m_buffer;
+    allocation.offset = static_cast<size_t>(m_segment) * m_segmentSize + offset;
+    allocation.data = m_data + allocation.offset;
+
+    m_stats.allocations++;
+    m_stats.allocatedBytes += bytes;
+    return allocation;
+}
+
+void PixelBufferRing::endFrame() {
+    // A segment nothing was written to can be used by the next frame as it is
+    if (!m_data || m_used == 0) {
+        return;
+    }
+
+    void*& fence = m_fences[m_segment];
+    if (fence) {
+        glDeleteSync(static_cast<GLsync>(fence));
+    }
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_segment = (m_segment + 1) % m_segments;
+    m_used = 0;
+    m_ready = false;
+}
+
+PixelBufferRing::Stats PixelBufferRing::getStats() const {
+    return m_stats;
+}
+
+bool PixelBufferRing::segmentReady() {
+    if (m_ready) {
+        return true;
+    }
+
+    // Poll without waiting; the GPU may still be reading the segment's previous frame
+    void*& fence = m_fences[m_segment];
+    if (fence) {
+        const GLenum status = glClientWaitSync(static_cast<GLsync>(fence), 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(static_cast<GLsync>(fence));
+        fence = nullptr;
+    }
+
+    m_ready = true;
+    return true;
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,129 @@
+// PixelBufferRing.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class PixelBufferRing
+ * @brief A ring of persistently mapped pixel buffers for texture uploads
+ *
+ * One pixel unpack buffer is mapped once for the lifetime of the ring and
+ * split into a segment per frame in flight. Pixels are written straight into
+ * the mapping and the texture upload sourced from the buffer returns at
+ * once, leaving the transfer to the GPU's DMA engine.
+ *
+ * At the end of a frame its segment is fenced and the ring moves on to the
+ * next one. A segment whose fence hasn't signalled yet isn't written to;
+ * allocations fail instead of stalling, and the caller uploads directly from
+ * client memory. The same happens if the ring couldn't be created, e.g.
+ * without GL_ARB_buffer_storage.
+ *
+ * Needs a current GL context for everything but the constructor and the
+ * getters.
+ */
+class PixelBufferRing {
+public:
+    /**
+     * A piece of a segment to write pixels into
+     */
+    struct Allocation {
+        uint32_t buffer = 0;        ///< The buffer to bind as GL_PIXEL_UNPACK_BUFFER, 0 if the allocation failed
+        size_t offset = 0;          ///< Offset of the piece in the buffer
+        void* data = nullptr;       ///< The mapped piece
+    };
+
+    /**
+     * Ring statistics
+     */
+    struct Stats {
+        size_t size = 0;                ///< Size of the buffer in bytes, 0 if not created
+        uint64_t allocations = 0;       ///< Successful allocations
+        uint64_t allocatedBytes = 0;    ///< Bytes allocated in total
+        uint64_t busy = 0;              ///< Allocations failed as the segment was still in flight
+        uint64_t overflows = 0;         ///< Allocations failed as the segment was full
+    };
+
+    /**
+     * Constructor
+     *
+     * @param segmentSize Size of each segment in bytes
+     * @param segments Number of frames that may be in flight
+     */
+    explicit PixelBufferRing(size_t segmentSize = 16 * 1024 * 1024, int segments = 3);
+
+    /**
+     * Destructor
+     */
+    ~PixelBufferRing();
+
+    /**
+     * Create and map the buffer
+     *
+     * @return True if the ring can be used
+     */
+    bool initialize();
+
+    /**
+     * Unmap and delete the buffer
+     */
+    void release();
+
+    /**
+     * Check if the ring can be used
+     *
+     * @return True if the buffer is mapped
+     */
+    bool isValid() const;
+
+    /**
+     * Allocate a piece of the current frame's segment
+     *
+     * Never blocks.
+     *
+     * @param bytes The size of the piece
+     * @param alignment The alignment of the piece's offset
+     * @return The piece, with a zero buffer if there's no room
+     */
+    Allocation allocate(size_t bytes, size_t alignment = 16);
+
+    /**
+     * Fence the current frame's uploads and move on to the next segment
+     *
+     * Called once per frame after the uploads were submitted.
+     */
+    void endFrame();
+
+    /**
+     * Get the ring statistics
+     *
+     * @return The statistics
+     */
+    Stats getStats() const;
+
+private:
+    bool segmentReady();
+
+    size_t m_segmentSize;
+    int m_segments;
+
+    uint32_t m_buffer;
+    uint8_t* m_data;
+
+    // Fences of the segments' last frames, GLsync
+    std::vector<void*> m_fences;
+    int m_segment;
+    size_t m_used;
+    bool m_ready;
+
+    Stats m_stats;
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -3,6 +3,10 @@
 #include "RenderTexture.h"
 #include "RenderShader.h"
 #include "RenderTarget.h"
+#include "FrameScheduler.h"
+#include "PixelBufferRing.h"
+#include "ThumbnailAtlas.h"
+#include "WorkspaceSnapshots.h"
 
 #include <iostream>
 #include <chrono>
@@ -302,6 +306,16 @@ const Vertex quadVertices[] = {
     { -1.0f,  1.0f, 0.0f, 0.0f, 1.0f }   // Top-left
 };
 
+// Scheduler name of the engine's own surface, used when no output is given
+const std::string defaultOutputName = "default";
+
+const float identityMatrix[] = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+};
+
 const uint16_t quadIndices[] = {
     0, 1, 2,  // First triangle
     0, 2, 3   // Second triangle
@@ -316,8 +330,6 @@ public:
         , m_hardwareAccelerationAvailable(false)
         , m_vSync(true)
         , m_maxFrameRate(60)
-        , m_currentFrameRate(0)
-        , m_frameTime(0.0f)
         , m_frameCount(0)
         , m_drawCalls(0)
         , m_eglDisplay(EGL_NO_DISPLAY)
@@ -390,6 +402,12 @@ public:
         // Stop rendering if running
         stop();
         
+        // Destroy the thumbnail atlas
+        m_thumbnailTarget.reset();
+
+        // Destroy the workspace snapshots
+        m_snapshotTargets.clear();
+        
         // Destroy shaders
         m_shaders.clear();
         m_shadersByName.clear();
@@ -478,6 +496,11 @@ public:
         
         m_isRunning = true;
         m_lastFrameTime = std::chrono::high_resolution_clock::now();
+        
+        // The engine's own surface is paced at the maximum frame rate
+        if (!m_frameScheduler.hasOutput(defaultOutputName)) {
+            m_frameScheduler.addOutput(defaultOutputName, m_maxFrameRate * 1000);
+        }
     }
     
     void stop() {
@@ -488,35 +511,21 @@ public:
         return m_isRunning;
     }
     
-    bool beginFrame() {
+    bool beginFrame(const std::string& output) {
         if (!m_initialized || !m_isRunning) {
             return false;
         }
         
-        // Calculate frame time
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        auto delta = currentTime - m_lastFrameTime;
-        m_frameTime = std::chrono::duration<float>(delta).count();
-        m_lastFrameTime = currentTime;
-        
-        // Limit frame rate if needed
-        if (m_maxFrameRate > 0 && !m_vSync) {
-            float targetFrameTime = 1.0f / static_cast<float>(m_maxFrameRate);
-            if (m_frameTime < targetFrameTime) {
-                std::this_thread::sleep_for(std::chrono::duration<float>(targetFrameTime - m_frameTime));
-                
-                // Recalculate frame time
-                currentTime = std::chrono::high_resolution_clock::now();
-                delta = currentTime - m_lastFrameTime;
-                m_frameTime = std::chrono::duration<float>(delta).count();
-                m_lastFrameTime = currentTime;
-            }
+        // Start composition as late as the output's next deadline allows;
+        // with vsync off and no frame rate limit, render immediately
+        if (m_vSync || m_maxFrameRate > 0) {
+            m_frameScheduler.waitForRenderStart(output);
         }
         
-        // Calculate current frame rate
-        if (m_frameTime > 0.0f) {
-            m_currentFrameRate = static_cast<int>(1.0f / m_frameTime);
-        }
+        m_lastFrameTime = std::chrono::high_resolution_clock::now();
+        
+        m_currentOutput = output;
+        m_frameScheduler.renderStarted(output, FrameScheduler::now());
         
         // Reset draw calls counter
         m_drawCalls = 0;
@@ -539,8 +548,13 @@ public:
         // Update stats
         updateStats();
         
+        // Feed the render time history before presenting
+        m_frameScheduler.renderFinished(m_currentOutput, FrameScheduler::now());
+        
         // Swap buffers based on backend
         if (m_currentBackend == "opengl") {
+            // The frame's texture uploads are submitted; their staging memory is reused once they completed
+            m_pixelBufferRing.endFrame();
             eglSwapBuffers(m_eglDisplay, m_eglSurface);
         } else if (m_currentBackend == "vulkan") {
             // Vulkan present
@@ -550,6 +564,11 @@ public:
             presentSoftwareFrame();
         }
         
+        // Without hardware presentation feedback, the swap completion stands in for the vblank
+        if (!m_frameScheduler.getStats(m_currentOutput).hardwareClock) {
+            m_frameScheduler.presented(m_currentOutput, FrameScheduler::now(), m_frameCount, 0, false);
+        }
+        
         return true;
     }
     
@@ -583,6 +602,15 @@ public:
         return texture;
     }
     
+    void releaseTexture(const std::shared_ptr<RenderTexture>& texture) {
+        if (!texture) {
+            return;
+        }
+        
+        // The memory usage is recalculated from the remaining textures
+        m_textures.erase(std::remove(m_textures.begin(), m_textures.end(), texture), m_textures.end());
+    }
+    
     std::shared_ptr<RenderShader> createShader(const std::string& vertexShader, const std::string& fragmentShader) {
         if (!m_initialized) {
             std::cerr << "Engine not initialized" << std::endl;
@@ -1084,12 +1112,12 @@ public:
                                     }
 
                                     // Render statistics and performance methods
-                                    int getFrameRate() const {
-                                        return m_currentFrameRate;
+                                    int getFrameRate(const std::string& output) const {
+                                        return static_cast<int>(m_frameScheduler.getStats(output).frameRate + 0.5f);
                                     }
 
-                                    float getFrameTime() const {
-                                        return m_frameTime;
+                                    float getFrameTime(const std::string& output) const {
+                                        return static_cast<float>(m_frameScheduler.getStats(output).averageFrameTime) / 1e9f;
                                     }
 
                                     int getDrawCalls() const {
@@ -1119,12 +1147,216 @@ public:
 
                                     void setMaxFrameRate(int frameRate) {
                                         m_maxFrameRate = frameRate;
+
+                                        if (m_frameScheduler.hasOutput(defaultOutputName)) {
+                                            m_frameScheduler.setRefreshRate(defaultOutputName, frameRate * 1000);
+                                        }
                                     }
 
                                     int getMaxFrameRate() const {
                                         return m_maxFrameRate;
                                     }
 
+                                    FrameScheduler& getFrameScheduler() {
+                                        return m_frameScheduler;
+                                    }
+
+    PixelBufferRing& getPixelBufferRing() {
+        return m_pixelBufferRing;
+    }
+
+    bool makeCurrent() {
+        if (m_eglContext == EGL_NO_CONTEXT) {
+            return false;
+        }
+
+        // Other renderers, e.g. Qt Quick, bind their own context before they draw
+        if (eglGetCurrentContext() == m_eglContext) {
+            return true;
+        }
+        return eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext) == EGL_TRUE;
+    }
+
+    int updateThumbnails(ThumbnailAtlas& atlas, const std::function<uint32_t(uint64_t)>& textureForWindow, int64_t now) {
+        if (!m_initialized || m_currentBackend == "vulkan" || !makeCurrent()) {
+            return 0;
+        }
+
+        auto shaderIt = m_shadersByName.find("basic");
+        if (shaderIt == m_shadersByName.end()) {
+            std::cerr << "Basic shader not found" << std::endl;
+            return 0;
+        }
+
+        std::vector<ThumbnailAtlas::Update> updates = atlas.takeUpdates(now);
+        if (updates.empty()) {
+            return 0;
+        }
+
+        // One atlas for all thumbnails, drawn into cell by cell
+        if (!m_thumbnailTarget || m_thumbnailTarget->getWidth() != atlas.getSize()) {
+            releaseRenderTarget(m_thumbnailTarget);
+            m_thumbnailTarget = createRenderTarget(atlas.getSize(), atlas.getSize(), "rgba8");
+            updateStats();
+            if (!m_thumbnailTarget) {
+                return 0;
+            }
+        }
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        auto shader = shaderIt->second;
+        m_thumbnailTarget->bind();
+        shader->bind();
+        shader->setUniformMat4("u_mvpMatrix", identityMatrix);
+        shader->setUniformInt("u_texture", 0);
+        glActiveTexture(GL_TEXTURE0);
+
+        // Thumbnails replace what was in their cell
+        glDisable(GL_BLEND);
+        glEnable(GL_SCISSOR_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+        int drawn = 0;
+        for (const auto& update : updates) {
+            // Clear the whole cell, so the padding stays transparent in every mip level
+            glScissor(update.cell.x, update.cell.y, update.cell.width, update.cell.height);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            const uint32_t texture = textureForWindow(update.window);
+            if (texture == 0) {
+                continue;
+            }
+
+            glViewport(update.rect.x, update.rect.y, update.rect.width, update.rect.height);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            drawFullscreenQuad();
+            drawn++;
+        }
+
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_BLEND);
+        shader->unbind();
+        m_thumbnailTarget->unbind();
+
+        // Regenerate the mip chain once for the whole batch
+        glBindTexture(GL_TEXTURE_2D, m_thumbnailTarget->getColorTextureId());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, atlas.getMipLevels() - 1);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        // Buffers uploaded for the pass were staged in the current segment
+        m_pixelBufferRing.endFrame();
+
+        m_drawCalls += drawn;
+        return drawn;
+    }
+
+    uint32_t getThumbnailTextureId() const {
+        return m_thumbnailTarget ? m_thumbnailTarget->getColorTextureId() : 0;
+    }
+
+    int updateWorkspaceSnapshots(WorkspaceSnapshots& snapshots,
+                                 const std::function<std::vector<WorkspaceSnapshots::Layer>(uint64_t)>& layersForWorkspace,
+                                 int64_t now) {
+        if (!m_initialized || m_currentBackend == "vulkan" || !makeCurrent()) {
+            return 0;
+        }
+
+        auto shaderIt = m_shadersByName.find("basic");
+        if (shaderIt == m_shadersByName.end()) {
+            std::cerr << "Basic shader not found" << std::endl;
+            return 0;
+        }
+
+        std::vector<uint64_t> refreshes = snapshots.takeRefreshes(now);
+        if (refreshes.empty()) {
+            return 0;
+        }
+
+        const int width = snapshots.getTextureWidth();
+        const int height = snapshots.getTextureHeight();
+        const double scale = snapshots.getScale();
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        auto shader = shaderIt->second;
+        shader->bind();
+        shader->setUniformMat4("u_mvpMatrix", identityMatrix);
+        shader->setUniformInt("u_texture", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+        int drawn = 0;
+        for (uint64_t workspace : refreshes) {
+            // One target per workspace, recreated when the workspaces are resized
+            std::shared_ptr<RenderTarget>& target = m_snapshotTargets[workspace];
+            if (!target || target->getWidth() != width || target->getHeight() != height) {
+                releaseRenderTarget(target);
+                target = createRenderTarget(width, height, "rgba8");
+                if (!target) {
+                    m_snapshotTargets.erase(workspace);
+                    continue;
+                }
+            }
+
+            target->bind();
+            glViewport(0, 0, width, height);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // Layers come bottom to top in workspace pixels, with y pointing down
+            const std::vector<WorkspaceSnapshots::Layer> layers = layersForWorkspace(workspace);
+            for (const auto& layer : layers) {
+                if (layer.texture == 0 || layer.width <= 0 || layer.height <= 0) {
+                    continue;
+                }
+
+                const int x = static_cast<int>(std::lround(layer.x * scale));
+                const int y = static_cast<int>(std::lround((snapshots.getHeight() - layer.y - layer.height) * scale));
+                glViewport(x, y, std::max(1, static_cast<int>(std::lround(layer.width * scale))),
+                           std::max(1, static_cast<int>(std::lround(layer.height * scale))));
+                glBindTexture(GL_TEXTURE_2D, layer.texture);
+                drawFullscreenQuad();
+                m_drawCalls++;
+            }
+
+            target->unbind();
+            drawn++;
+        }
+
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        shader->unbind();
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        // Buffers uploaded for the pass were staged in the current segment
+        m_pixelBufferRing.endFrame();
+
+        return drawn;
+    }
+
+    uint32_t getWorkspaceSnapshotTextureId(uint64_t workspace) const {
+        auto it = m_snapshotTargets.find(workspace);
+        return it != m_snapshotTargets.end() && it->second ? it->second->getColorTextureId() : 0;
+    }
+
+    void releaseWorkspaceSnapshot(uint64_t workspace) {
+        auto it = m_snapshotTargets.find(workspace);
+        if (it == m_snapshotTargets.end()) {
+            return;
+        }
+
+        releaseRenderTarget(it->second);
+        m_snapshotTargets.erase(it);
+    }
+
 private:
     // Private helper methods for initialization and rendering
     bool checkHardwareAcceleration() {
@@ -1266,6 +1498,9 @@ private:
         // Enable blending
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // Staging memory for shared memory uploads; without it they go straight from client memory
+        m_pixelBufferRing.initialize();
     }
 
     void drawFullscreenQuad() {
@@ -1391,6 +1626,8 @@ private:
                 m_ibo = 0;
             }
 
+            m_pixelBufferRing.release();
+
             // Release EGL context
             eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
@@ -1509,10 +1746,25 @@ private:
                     target->getWidth(), target->getHeight(), target->getColorFormat());
                 m_gpuMemoryUsage += calculateTextureMemoryUsage(
                     target->getWidth(), target->getHeight(), "depth24");
+
+                // The thumbnail atlas' mip chain adds a third to the base level
+                if (target == m_thumbnailTarget) {
+                    m_gpuMemoryUsage += calculateTextureMemoryUsage(
+                        target->getWidth(), target->getHeight(), "rgba8") / 3;
+                }
             }
         }
     }
 
+    void releaseRenderTarget(const std::shared_ptr<RenderTarget>& target) {
+        if (!target) {
+            return;
+        }
+
+        // The memory usage is recalculated from the remaining targets
+        m_renderTargets.erase(std::remove(m_renderTargets.begin(), m_renderTargets.end(), target), m_renderTargets.end());
+    }
+
     uint64_t calculateTextureMemoryUsage(int width, int height, const std::string& format) {
         // Calculate memory usage for a texture based on its format
         uint64_t bytesPerPixel = 4; // Default to 4 bytes per pixel (RGBA8)
@@ -1544,8 +1796,6 @@ private:
     bool m_hardwareAccelerationAvailable;
     bool m_vSync;
     int m_maxFrameRate;
-    int m_currentFrameRate;
-    float m_frameTime;
     uint64_t m_frameCount;
     int m_drawCalls;
 
@@ -1568,12 +1818,25 @@ private:
     std::chrono::high_resolution_clock::time_point m_lastFrameTime;
     uint64_t m_gpuMemoryUsage;
 
+    // Frame pacing
+    FrameScheduler m_frameScheduler;
+    std::string m_currentOutput;
+
+    // Staging memory for texture uploads
+    PixelBufferRing m_pixelBufferRing;
+
     // Resources
     std::vector<std::shared_ptr<RenderSurface>> m_surfaces;
     std::vector<std::shared_ptr<RenderTexture>> m_textures;
     std::vector<std::shared_ptr<RenderShader>> m_shaders;
     std::vector<std::shared_ptr<RenderTarget>> m_renderTargets;
     std::map<std::string, std::shared_ptr<RenderShader>> m_shadersByName;
+
+    // Atlas window thumbnails are drawn into
+    std::shared_ptr<RenderTarget> m_thumbnailTarget;
+
+    // Composited snapshots of the workspaces
+    std::map<uint64_t, std::shared_ptr<RenderTarget>> m_snapshotTargets;
 };
 
 // Public methods implementation that delegate to the impl
@@ -1633,13 +1896,21 @@ bool RenderEngine::isRunning() const {
 }
 
 bool RenderEngine::beginFrame() {
-    return m_pImpl->beginFrame();
+    return m_pImpl->beginFrame(defaultOutputName);
+}
+
+bool RenderEngine::beginFrame(const std::string& output) {
+    return m_pImpl->beginFrame(output);
 }
 
 bool RenderEngine::endFrame() {
     return m_pImpl->endFrame();
 }
 
+bool RenderEngine::makeCurrent() {
+    return m_pImpl->makeCurrent();
+}
+
 std::shared_ptr<RenderSurface> RenderEngine::createSurface(int width, int height, const std::string& format) {
     return m_pImpl->createSurface(width, height, format);
 }
@@ -1648,6 +1919,10 @@ std::shared_ptr<RenderTexture> RenderEngine::createTexture(int width, int height
     return m_pImpl->createTexture(width, height, format);
 }
 
+void RenderEngine::releaseTexture(const std::shared_ptr<RenderTexture>& texture) {
+    m_pImpl->releaseTexture(texture);
+}
+
 std::shared_ptr<RenderShader> RenderEngine::createShader(const std::string& vertexShader, const std::string& fragmentShader) {
     return m_pImpl->createShader(vertexShader, fragmentShader);
 }
@@ -1661,11 +1936,19 @@ bool RenderEngine::applyEffect(std::shared_ptr<RenderSurface> surface, const Eff
 }
 
 int RenderEngine::getFrameRate() const {
-    return m_pImpl->getFrameRate();
+    return m_pImpl->getFrameRate(defaultOutputName);
+}
+
+int RenderEngine::getFrameRate(const std::string& output) const {
+    return m_pImpl->getFrameRate(output);
 }
 
 float RenderEngine::getFrameTime() const {
-    return m_pImpl->getFrameTime();
+    return m_pImpl->getFrameTime(defaultOutputName);
+}
+
+float RenderEngine::getFrameTime(const std::string& output) const {
+    return m_pImpl->getFrameTime(output);
 }
 
 int RenderEngine::getDrawCalls() const {
@@ -1692,6 +1975,36 @@ int RenderEngine::getMaxFrameRate() const {
     return m_pImpl->getMaxFrameRate();
 }
 
+FrameScheduler& RenderEngine::getFrameScheduler() {
+    return m_pImpl->getFrameScheduler();
+}
+
+PixelBufferRing& RenderEngine::getPixelBufferRing() {
+    return m_pImpl->getPixelBufferRing();
+}
+
+int RenderEngine::updateThumbnails(ThumbnailAtlas& atlas, const std::function<uint32_t(uint64_t)>& textureForWindow, int64_t now) {
+    return m_pImpl->updateThumbnails(atlas, textureForWindow, now);
+}
+
+uint32_t RenderEngine::getThumbnailTextureId() const {
+    return m_pImpl->getThumbnailTextureId();
+}
+
+int RenderEngine::updateWorkspaceSnapshots(WorkspaceSnapshots& snapshots,
+                                           const std::function<std::vector<WorkspaceSnapshots::Layer>(uint64_t)>& layersForWorkspace,
+                                           int64_t now) {
+    return m_pImpl->updateWorkspaceSnapshots(snapshots, layersForWorkspace, now);
+}
+
+uint32_t RenderEngine::getWorkspaceSnapshotTextureId(uint64_t workspace) const {
+    return m_pImpl->getWorkspaceSnapshotTextureId(workspace);
+}
+
+void RenderEngine::releaseWorkspaceSnapshot(uint64_t workspace) {
+    m_pImpl->releaseWorkspaceSnapshot(workspace);
+}
+
 } // namespace Rendering
 } // namespace Compositor
 } // namespace VivoX
@@ -1,11 +1,15 @@
 // RenderEngine.h
 #pragma once
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 #include <cstdint>
 
+#include "WorkspaceSnapshots.h"
+
 namespace VivoX {
 namespace Compositor {
 namespace Rendering {
@@ -15,6 +19,9 @@ class RenderSurface;
 class RenderTexture;
 class RenderShader;
 class RenderTarget;
+class FrameScheduler;
+class PixelBufferRing;
+class ThumbnailAtlas;
 
 // Effect types for visual effects
 enum class EffectType {
@@ -143,12 +150,23 @@ public:
     bool isRunning() const;
     
     /**
-     * Begin a new frame
+     * Begin a new frame on the engine's own surface
      * 
      * @return True if successful, false otherwise
      */
     bool beginFrame();
     
+    /**
+     * Begin a new frame for an output
+     * 
+     * Blocks until the output's frame scheduler says composition should start,
+     * i.e. as late as possible while still making the next vblank.
+     * 
+     * @param output The name of the output registered with the frame scheduler
+     * @return True if successful, false otherwise
+     */
+    bool beginFrame(const std::string& output);
+    
     /**
      * End the current frame and present it
      * 
@@ -156,6 +174,18 @@ public:
      */
     bool endFrame();
     
+    /**
+     * Make the engine's GL context current on the calling thread
+     * 
+     * The engine's objects and the textures it creates only exist in this
+     * context. Passes run from timers, outside any frame, make it current
+     * themselves; anything else doing GL work with the engine's textures,
+     * e.g. uploads, has to call this first.
+     * 
+     * @return True if the context is current, false without a GL context
+     */
+    bool makeCurrent();
+    
     /**
      * Create a new render surface
      * 
@@ -176,6 +206,16 @@ public:
      */
     std::shared_ptr<RenderTexture> createTexture(int width, int height, const std::string& format = "rgba8");
     
+    /**
+     * Stop tracking a texture created by the engine
+     * 
+     * The texture is deleted with its last reference, which needs the
+     * engine's context current (see makeCurrent()).
+     * 
+     * @param texture The texture to release
+     */
+    void releaseTexture(const std::shared_ptr<RenderTexture>& texture);
+    
     /**
      * Create a new shader program
      * 
@@ -205,19 +245,35 @@ public:
     bool applyEffect(std::shared_ptr<RenderSurface> surface, const EffectParams& effect);
     
     /**
-     * Get the current frame rate
+     * Get the current frame rate of the engine's own surface
      * 
      * @return The current frame rate in frames per second
      */
     int getFrameRate() const;
     
     /**
-     * Get the time taken to render the last frame
+     * Get the current frame rate of an output
+     * 
+     * @param output The name of the output
+     * @return The smoothed presentation rate in frames per second
+     */
+    int getFrameRate(const std::string& output) const;
+    
+    /**
+     * Get the frame time of the engine's own surface
      * 
      * @return The frame time in seconds
      */
     float getFrameTime() const;
     
+    /**
+     * Get the frame time of an output
+     * 
+     * @param output The name of the output
+     * @return The smoothed interval between presentations in seconds
+     */
+    float getFrameTime(const std::string& output) const;
+    
     /**
      * Get the number of draw calls in the last frame
      * 
@@ -261,6 +317,75 @@ public:
      */
     int getMaxFrameRate() const;
     
+    /**
+     * Get the frame scheduler that paces rendering per output
+     * 
+     * Outputs are registered here and fed with presentation feedback.
+     * 
+     * @return The frame scheduler
+     */
+    FrameScheduler& getFrameScheduler();
+    
+    /**
+     * Get the persistently mapped pixel buffers that stage texture uploads
+     * 
+     * Pass it to RenderTexture::uploadShm(). Its memory is fenced and reused
+     * as frames end; it is invalid if the GL lacks persistent mapping.
+     * 
+     * @return The pixel buffer ring
+     */
+    PixelBufferRing& getPixelBufferRing();
+    
+    /**
+     * Redraw the thumbnails that are due into the thumbnail atlas texture
+     * 
+     * Each due window's current buffer is drawn scaled down into its cell,
+     * then the mip levels of the atlas are regenerated once for all of them.
+     * 
+     * @param atlas The atlas deciding which thumbnails are due and where they go
+     * @param textureForWindow Returns the texture holding a window's current buffer, or 0 if there is none
+     * @param now The current time in nanoseconds
+     * @return The number of thumbnails drawn
+     */
+    int updateThumbnails(ThumbnailAtlas& atlas, const std::function<uint32_t(uint64_t)>& textureForWindow, int64_t now);
+    
+    /**
+     * Get the texture thumbnails are drawn into
+     * 
+     * @return The texture ID, or 0 before the first thumbnail was drawn
+     */
+    uint32_t getThumbnailTextureId() const;
+    
+    /**
+     * Redraw the workspace snapshots that are due
+     * 
+     * Each due workspace's windows are composited bottom to top into the
+     * workspace's snapshot texture, scaled to the snapshot size.
+     * 
+     * @param snapshots The schedule deciding which snapshots are due
+     * @param layersForWorkspace Returns the windows of a workspace, bottom first
+     * @param now The current time in nanoseconds
+     * @return The number of snapshots drawn
+     */
+    int updateWorkspaceSnapshots(WorkspaceSnapshots& snapshots,
+                                 const std::function<std::vector<WorkspaceSnapshots::Layer>(uint64_t)>& layersForWorkspace,
+                                 int64_t now);
+    
+    /**
+     * Get the texture holding a workspace's snapshot
+     * 
+     * @param workspace The workspace
+     * @return The texture ID, or 0 before the snapshot was drawn
+     */
+    uint32_t getWorkspaceSnapshotTextureId(uint64_t workspace) const;
+    
+    /**
+     * Free the snapshot texture of a workspace
+     * 
+     * @param workspace The workspace
+     */
+    void releaseWorkspaceSnapshot(uint64_t workspace);
+    
 private:
     // Implementation using the PIMPL idiom
     class Impl;
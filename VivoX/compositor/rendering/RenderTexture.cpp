@@ -1,17 +1,46 @@
 // RenderTexture.cpp
 #include "RenderTexture.h"
+#include "PixelBufferRing.h"
 #include <GL/gl.h>
+#include <GL/glext.h>
 #include <iostream>
 
 namespace VivoX {
     namespace Compositor {
         namespace Rendering {
 
+            namespace {
+                // Storage and upload format of each shared memory format; the GPU swaps
+                // the channels of BGR formats while uploading, so the CPU never converts
+                struct ShmPixelFormat {
+                    const char* storage;
+                    GLenum format;
+                };
+
+                ShmPixelFormat shmPixelFormat(ShmUpload::Format format) {
+                    switch (format) {
+                    case ShmUpload::Format::RGBA:
+                    case ShmUpload::Format::RGBX:
+                        return { "rgba8", GL_RGBA };
+                    case ShmUpload::Format::BGRA:
+                    case ShmUpload::Format::BGRX:
+                        return { "rgba8", GL_BGRA };
+                    case ShmUpload::Format::RGB:
+                        return { "rgb8", GL_RGB };
+                    case ShmUpload::Format::R8:
+                        return { "r8", GL_RED };
+                    default:
+                        return { nullptr, 0 };
+                    }
+                }
+            }
+
             RenderTexture::RenderTexture(int width, int height, const std::string& format)
             : m_width(width)
             , m_height(height)
             , m_textureId(0)
-            , m_format(format) {
+            , m_format(format)
+            , m_alphaIgnored(false) {
 
                 // Create texture
                 glGenTextures(1, &m_textureId);
@@ -24,18 +53,7 @@ namespace VivoX {
                 glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
                 // Allocate texture storage based on format
-                if (format == "rgba8") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-                } else if (format == "rgb8") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-                } else if (format == "rgba16f") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-                } else if (format == "r8") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
-                } else {
-                    // Default to RGBA8
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-                }
+                allocateStorage();
             }
 
             RenderTexture::~RenderTexture() {
@@ -58,11 +76,12 @@ namespace VivoX {
             void RenderTexture::upload(const void* data, const std::string& format) {
                 glBindTexture(GL_TEXTURE_2D, m_textureId);
 
-                if (format == "rgba" || m_format == "rgba8") {
+                // The data is in the given format, whatever the texture's storage
+                if (format == "rgba") {
                     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, data);
-                } else if (format == "rgb" || m_format == "rgb8") {
+                } else if (format == "rgb") {
                     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, data);
-                } else if (format == "r" || m_format == "r8") {
+                } else if (format == "r") {
                     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RED, GL_UNSIGNED_BYTE, data);
                 } else {
                     std::cerr << "Unsupported texture format for upload: " << format << std::endl;
@@ -81,17 +100,100 @@ namespace VivoX {
                 glBindTexture(GL_TEXTURE_2D, m_textureId);
 
                 // Reallocate texture storage based on format
+                allocateStorage();
+            }
+
+            size_t RenderTexture::uploadShm(const void* data, int width, int height, int stride, ShmUpload::Format format,
+                                            const std::vector<ShmUpload::Rect>& damage, PixelBufferRing* ring) {
+                const int bpp = ShmUpload::bytesPerPixel(format);
+                const ShmPixelFormat pixelFormat = shmPixelFormat(format);
+                if (!data || bpp == 0 || width <= 0 || height <= 0 || stride < width * bpp) {
+                    std::cerr << "Invalid shared memory buffer for upload" << std::endl;
+                    return 0;
+                }
+
+                glBindTexture(GL_TEXTURE_2D, m_textureId);
+
+                // Storage is only reallocated when the buffer's size or format changes, and is then filled completely
+                std::vector<ShmUpload::Rect> everything;
+                if (width != m_width || height != m_height || m_format != pixelFormat.storage) {
+                    m_width = width;
+                    m_height = height;
+                    m_format = pixelFormat.storage;
+                    allocateStorage();
+
+                    ShmUpload::Rect rect;
+                    rect.width = width;
+                    rect.height = height;
+                    everything.push_back(rect);
+                }
+
+                // The ignored alpha byte of X formats reads as opaque
+                const bool ignoreAlpha = bpp == 4 && !ShmUpload::hasAlpha(format);
+                if (ignoreAlpha != m_alphaIgnored) {
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, ignoreAlpha ? GL_ONE : GL_ALPHA);
+                    m_alphaIgnored = ignoreAlpha;
+                }
+
+                const ShmUpload::Plan plan = ShmUpload::plan(width, height, format, everything.empty() ? damage : everything);
+                if (plan.regions.empty()) {
+                    return 0;
+                }
+
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+                PixelBufferRing::Allocation staging;
+                if (ring && ring->isValid()) {
+                    staging = ring->allocate(plan.bytes);
+                }
+
+                if (staging.buffer) {
+                    // Only the damaged pixels are copied; the GPU transfers them from the buffer while we go on
+                    ShmUpload::stage(plan, data, stride, format, staging.data);
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.buffer);
+                    for (const ShmUpload::Region& region : plan.regions) {
+                        const ShmUpload::Rect& rect = region.rect;
+                        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, pixelFormat.format,
+                                        GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(staging.offset + region.offset));
+                    }
+                    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                } else if (stride % bpp == 0) {
+                    // Straight from the client's memory; the row length steps over the pixels around each region
+                    const uint8_t* pixels = static_cast<const uint8_t*>(data);
+                    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / bpp);
+                    for (const ShmUpload::Region& region : plan.regions) {
+                        const ShmUpload::Rect& rect = region.rect;
+                        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, pixelFormat.format,
+                                        GL_UNSIGNED_BYTE, pixels + static_cast<size_t>(rect.y) * stride + static_cast<size_t>(rect.x) * bpp);
+                    }
+                    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+                } else {
+                    // Rows that aren't a whole number of pixels long can't be described to GL; pack them first
+                    std::vector<uint8_t> packed(plan.bytes);
+                    ShmUpload::stage(plan, data, stride, format, packed.data());
+                    for (const ShmUpload::Region& region : plan.regions) {
+                        const ShmUpload::Rect& rect = region.rect;
+                        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, pixelFormat.format,
+                                        GL_UNSIGNED_BYTE, packed.data() + region.offset);
+                    }
+                }
+
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                return plan.bytes;
+            }
+
+            void RenderTexture::allocateStorage() {
                 if (m_format == "rgba8") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
                 } else if (m_format == "rgb8") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
                 } else if (m_format == "rgba16f") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, m_width, m_height, 0, GL_RGBA, GL_FLOAT, nullptr);
                 } else if (m_format == "r8") {
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, m_width, m_height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
                 } else {
                     // Default to RGBA8
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
                 }
             }
 
@@ -1,13 +1,19 @@
 // RenderTexture.h
 #pragma once
 
+#include "ShmUpload.h"
+
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 
 namespace VivoX {
 namespace Compositor {
 namespace Rendering {
 
+class PixelBufferRing;
+
 class RenderTexture {
 public:
     RenderTexture(int width, int height, const std::string& format = "rgba8");
@@ -22,11 +28,35 @@ public:
     void upload(const void* data, const std::string& format = "rgba");
     void resize(int width, int height);
 
+    /**
+     * Upload the damaged parts of a shared memory buffer
+     *
+     * The texture is only reallocated if the buffer's size or format changed,
+     * and is then uploaded completely. Pixels are uploaded in the buffer's
+     * format, converted by the GPU. With a ring, the damaged pixels are staged
+     * in a pixel buffer and transferred asynchronously; without one, or if it
+     * has no room, they are uploaded straight from the buffer.
+     *
+     * @param data The buffer's pixels
+     * @param width The width of the buffer
+     * @param height The height of the buffer
+     * @param stride The length of the buffer's rows in bytes
+     * @param format The format of the buffer
+     * @param damage The damaged rectangles in buffer pixels
+     * @param ring The pixel buffers to stage the upload in, may be null
+     * @return The number of bytes uploaded
+     */
+    size_t uploadShm(const void* data, int width, int height, int stride, ShmUpload::Format format,
+                     const std::vector<ShmUpload::Rect>& damage, PixelBufferRing* ring = nullptr);
+
 private:
+    void allocateStorage();
+
     int m_width;
     int m_height;
     uint32_t m_textureId;
     std::string m_format;
+    bool m_alphaIgnored;
 };
 
 
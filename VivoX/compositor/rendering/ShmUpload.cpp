@@ -0,0 +1,233 @@
+// ShmUpload.cpp
+#include "ShmUpload.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+namespace {
+    // wl_shm formats; all others are DRM fourccs
+    const uint32_t shmArgb8888 = 0;
+    const uint32_t shmXrgb8888 = 1;
+    const uint32_t drmAbgr8888 = 0x34324241; // 'AB24'
+    const uint32_t drmXbgr8888 = 0x34324258; // 'XB24'
+    const uint32_t drmBgr888 = 0x34324742;   // 'BG24'
+    const uint32_t drmR8 = 0x20203852;       // 'R8  '
+
+    // More damage than this is merged into its bounding box
+    const size_t maxDamageRects = 64;
+
+    // Each region costs a transfer; beyond this many, neighbours are merged
+    const size_t maxRegions = 16;
+
+    // Two rectangles are merged if their bounding box wastes at most this many pixels,
+    // or a quarter of their area; one glyph cell is about 200
+    const int64_t mergeSlack = 4096;
+
+    // Once this share of the buffer is damaged, one full upload beats many small ones
+    const int64_t fullUploadPercent = 60;
+
+    // Regions start at offsets aligned for fast copies
+    const size_t stagingAlignment = 16;
+
+    int64_t area(const ShmUpload::Rect& rect) {
+        return static_cast<int64_t>(rect.width) * rect.height;
+    }
+
+    ShmUpload::Rect bounds(const ShmUpload::Rect& a, const ShmUpload::Rect& b) {
+        ShmUpload::Rect result;
+        result.x = std::min(a.x, b.x);
+        result.y = std::min(a.y, b.y);
+        result.width = std::max(a.x + a.width, b.x + b.width) - result.x;
+        result.height = std::max(a.y + a.height, b.y + b.height) - result.y;
+        return result;
+    }
+
+    int64_t overlap(const ShmUpload::Rect& a, const ShmUpload::Rect& b) {
+        const int64_t width = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+        const int64_t height = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+        return width > 0 && height > 0 ? width * height : 0;
+    }
+
+    // Pixels uploaded in vain if the two were uploaded as their bounding box
+    int64_t waste(const ShmUpload::Rect& a, const ShmUpload::Rect& b) {
+        return area(bounds(a, b)) - (area(a) + area(b) - overlap(a, b));
+    }
+
+    void mergeNearby(std::vector<ShmUpload::Rect>& rects) {
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < rects.size(); ++i) {
+                for (size_t j = i + 1; j < rects.size(); ++j) {
+                    const int64_t slack = std::max(mergeSlack, (area(rects[i]) + area(rects[j])) / 4);
+                    if (waste(rects[i], rects[j]) > slack) {
+                        continue;
+                    }
+                    rects[i] = bounds(rects[i], rects[j]);
+                    rects.erase(rects.begin() + j);
+                    j = i;
+                    merged = true;
+                }
+            }
+        }
+    }
+
+    void mergeCheapest(std::vector<ShmUpload::Rect>& rects) {
+        size_t first = 0;
+        size_t second = 1;
+        int64_t cheapest = -1;
+        for (size_t i = 0; i < rects.size(); ++i) {
+            for (size_t j = i + 1; j < rects.size(); ++j) {
+                const int64_t cost = waste(rects[i], rects[j]);
+                if (cheapest < 0 || cost < cheapest) {
+                    cheapest = cost;
+                    first = i;
+                    second = j;
+                }
+            }
+        }
+        rects[first] = bounds(rects[first], rects[second]);
+        rects.erase(rects.begin() + second);
+    }
+}
+
+ShmUpload::Format ShmUpload::fromShmFormat(uint32_t format) {
+    switch (format) {
+    case shmArgb8888:
+        return Format::BGRA;
+    case shmXrgb8888:
+        return Format::BGRX;
+    case drmAbgr8888:
+        return Format::RGBA;
+    case drmXbgr8888:
+        return Format::RGBX;
+    case drmBgr888:
+        return Format::RGB;
+    case drmR8:
+        return Format::R8;
+    default:
+        return Format::Invalid;
+    }
+}
+
+int ShmUpload::bytesPerPixel(Format format) {
+    switch (format) {
+    case Format::RGBA:
+    case Format::RGBX:
+    case Format::BGRA:
+    case Format::BGRX:
+        return 4;
+    case Format::RGB:
+        return 3;
+    case Format::R8:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+bool ShmUpload::hasAlpha(Format format) {
+    return format == Format::RGBA || format == Format::BGRA;
+}
+
+ShmUpload::Plan ShmUpload::plan(int width, int height, Format format, const std::vector<Rect>& damage) {
+    Plan result;
+    const int bpp = bytesPerPixel(format);
+    if (bpp == 0 || width <= 0 || height <= 0) {
+        return result;
+    }
+
+    // Clip the damage to the buffer
+    std::vector<Rect> rects;
+    rects.reserve(std::min(damage.size(), maxDamageRects));
+    for (const Rect& rect : damage) {
+        Rect clipped;
+        clipped.x = std::max(rect.x, 0);
+        clipped.y = std::max(rect.y, 0);
+        clipped.width = std::min(rect.x + rect.width, width) - clipped.x;
+        clipped.height = std::min(rect.y + rect.height, height) - clipped.y;
+        if (clipped.width <= 0 || clipped.height <= 0) {
+            continue;
+        }
+
+        if (rects.size() < maxDamageRects) {
+            rects.push_back(clipped);
+        } else {
+            rects.back() = bounds(rects.back(), clipped);
+        }
+    }
+    if (rects.empty()) {
+        return result;
+    }
+
+    mergeNearby(rects);
+    while (rects.size() > maxRegions) {
+        mergeCheapest(rects);
+    }
+
+    int64_t damaged = 0;
+    for (const Rect& rect : rects) {
+        damaged += area(rect);
+    }
+
+    if (damaged * 100 >= static_cast<int64_t>(width) * height * fullUploadPercent) {
+        Region region;
+        region.rect.width = width;
+        region.rect.height = height;
+        result.regions.push_back(region);
+        result.bytes = static_cast<size_t>(width) * height * bpp;
+        result.full = true;
+        return result;
+    }
+
+    // Top to bottom, so the staging copies walk the buffer forward
+    std::sort(rects.begin(), rects.end(), [](const Rect& a, const Rect& b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+
+    result.regions.reserve(rects.size());
+    for (const Rect& rect : rects) {
+        Region region;
+        region.rect = rect;
+        region.offset = (result.bytes + stagingAlignment - 1) / stagingAlignment * stagingAlignment;
+        result.regions.push_back(region);
+        result.bytes = region.offset + static_cast<size_t>(rect.width) * rect.height * bpp;
+    }
+    return result;
+}
+
+void ShmUpload::stage(const Plan& plan, const void* source, int stride, Format format, void* destination) {
+    const int bpp = bytesPerPixel(format);
+    if (!source || !destination || bpp == 0) {
+        return;
+    }
+
+    const uint8_t* pixels = static_cast<const uint8_t*>(source);
+    uint8_t* staging = static_cast<uint8_t*>(destination);
+    for (const Region& region : plan.regions) {
+        const Rect& rect = region.rect;
+        const size_t rowBytes = static_cast<size_t>(rect.width) * bpp;
+        const uint8_t* from = pixels + static_cast<size_t>(rect.y) * stride + static_cast<size_t>(rect.x) * bpp;
+        uint8_t* to = staging + region.offset;
+
+        // Full rows of a tightly packed buffer are one block
+        if (rowBytes == static_cast<size_t>(stride)) {
+            std::memcpy(to, from, rowBytes * rect.height);
+            continue;
+        }
+
+        for (int row = 0; row < rect.height; ++row) {
+            std::memcpy(to, from, rowBytes);
+            from += stride;
+            to += rowBytes;
+        }
+    }
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,121 @@
+// ShmUpload.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class ShmUpload
+ * @brief Plans the upload of the damaged parts of a shared memory buffer
+ *
+ * A wl_shm client redraws a few rectangles of its buffer, e.g. a terminal
+ * the cursor cell and the line being typed, yet re-specifying the whole
+ * texture moves 33 MB per frame at 4K. The plan clips the damage to the
+ * buffer, merges rectangles close enough that one transfer is cheaper than
+ * two, and falls back to a single full upload once most of the buffer is
+ * damaged anyway.
+ *
+ * Each region of the plan gets a place in a staging buffer, rows packed
+ * tightly, so the damaged pixels can be copied into a pixel buffer object
+ * and transferred from there while the client draws its next frame.
+ *
+ * Pixels are uploaded in the client's format; the texture's upload format
+ * and swizzle convert them, so no CPU conversion is needed.
+ */
+class ShmUpload {
+public:
+    /**
+     * Pixel formats of shared memory buffers, named by their byte order in memory
+     */
+    enum class Format {
+        Invalid,
+        RGBA,       ///< DRM ABGR8888
+        RGBX,       ///< DRM XBGR8888
+        BGRA,       ///< wl_shm ARGB8888
+        BGRX,       ///< wl_shm XRGB8888
+        RGB,        ///< DRM BGR888
+        R8          ///< DRM R8
+    };
+
+    /**
+     * A rectangle in buffer pixels
+     */
+    struct Rect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    /**
+     * A rectangle to upload and where its pixels are staged
+     */
+    struct Region {
+        Rect rect;
+        size_t offset = 0;      ///< Offset of the first row in the staging buffer
+    };
+
+    /**
+     * The regions to upload for one commit
+     */
+    struct Plan {
+        std::vector<Region> regions;
+        size_t bytes = 0;       ///< Size of the staging buffer needed
+        bool full = false;      ///< True if the whole buffer is uploaded
+    };
+
+    /**
+     * Get the format of a wl_shm format code
+     *
+     * @param format The wl_shm format, i.e. 0, 1 or a DRM fourcc
+     * @return The format, Invalid if it can't be uploaded
+     */
+    static Format fromShmFormat(uint32_t format);
+
+    /**
+     * Get the size of a pixel
+     *
+     * @param format The format
+     * @return The size in bytes, 0 for Invalid
+     */
+    static int bytesPerPixel(Format format);
+
+    /**
+     * Check if a format's alpha channel is to be used
+     *
+     * @param format The format
+     * @return False for formats without alpha or with the alpha byte ignored
+     */
+    static bool hasAlpha(Format format);
+
+    /**
+     * Plan the upload of a buffer's damage
+     *
+     * @param width The width of the buffer
+     * @param height The height of the buffer
+     * @param format The format of the buffer
+     * @param damage The damaged rectangles in buffer pixels, may lie partly outside
+     * @return The plan, without regions if nothing within the buffer is damaged
+     */
+    static Plan plan(int width, int height, Format format, const std::vector<Rect>& damage);
+
+    /**
+     * Copy the damaged pixels of a buffer into a staging buffer
+     *
+     * @param plan The plan for the buffer
+     * @param source The buffer's pixels
+     * @param stride The length of the buffer's rows in bytes
+     * @param format The format of the buffer
+     * @param destination The staging buffer, at least plan.bytes large
+     */
+    static void stage(const Plan& plan, const void* source, int stride, Format format, void* destination);
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
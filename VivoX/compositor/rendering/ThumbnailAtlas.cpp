@@ -0,0 +1,356 @@
+// ThumbnailAtlas.cpp
+#include "ThumbnailAtlas.h"
+
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+namespace {
+    // Default minimum interval between redraws of one thumbnail (10 Hz)
+    const int64_t defaultUpdateInterval = 100000000;
+
+    // Default number of thumbnails redrawn per frame
+    const int defaultUpdateBudget = 8;
+
+    // Thumbnails are not shrunk below this size to make room
+    const int minThumbnailSize = 32;
+
+    // A shelf may be at most this many times as tall as a cell placed on it,
+    // unless the atlas has no room for a better fitting shelf
+    const int maxShelfWaste = 2;
+}
+
+ThumbnailAtlas::ThumbnailAtlas(int size, int thumbnailSize, int mipLevels)
+    : m_size(std::max(1, size))
+    , m_maxThumbnailSize(std::clamp(thumbnailSize, 1, std::max(1, size)))
+    , m_thumbnailSize(m_maxThumbnailSize)
+    , m_mipLevels(std::clamp(mipLevels, 1, 16))
+    , m_updateInterval(defaultUpdateInterval)
+    , m_updateBudget(defaultUpdateBudget)
+    , m_shelfBottom(0)
+    , m_usedArea(0)
+    , m_updatesIssued(0)
+    , m_coalescedDamage(0)
+    , m_repacks(0) {
+}
+
+ThumbnailAtlas::~ThumbnailAtlas() {
+}
+
+int ThumbnailAtlas::getSize() const {
+    return m_size;
+}
+
+int ThumbnailAtlas::getMipLevels() const {
+    return m_mipLevels;
+}
+
+void ThumbnailAtlas::setUpdateInterval(int64_t interval) {
+    m_updateInterval = std::max<int64_t>(0, interval);
+}
+
+void ThumbnailAtlas::setUpdateBudget(int updates) {
+    m_updateBudget = std::max(1, updates);
+}
+
+void ThumbnailAtlas::setWindow(uint64_t window, int width, int height) {
+    auto it = m_entries.find(window);
+    if (it != m_entries.end() && it->second.width == width && it->second.height == height) {
+        return;
+    }
+
+    Entry& entry = m_entries[window];
+    Entry resized = entry;
+    resized.width = width;
+    resized.height = height;
+    fitThumbnail(resized, m_thumbnailSize);
+
+    // A thumbnail that still needs the same cell stays where it is
+    if (entry.shelf >= 0 && resized.cell.width == entry.cell.width && resized.cell.height == entry.cell.height) {
+        entry = resized;
+        markDirty(window, entry);
+        return;
+    }
+
+    if (entry.shelf >= 0) {
+        release(entry);
+    }
+    entry = resized;
+    entry.ready = false;
+    markDirty(window, entry);
+
+    if (allocate(m_shelves, m_shelfBottom, entry)) {
+        m_usedArea += entry.cell.width * entry.cell.height;
+        return;
+    }
+
+    // Full: repack every thumbnail, smaller if they don't fit otherwise
+    for (int limit = m_thumbnailSize; !repack(limit); limit /= 2) {
+        if (limit <= minThumbnailSize) {
+            std::cerr << "Thumbnail atlas full, dropping window " << window << std::endl;
+            removeWindow(window);
+            return;
+        }
+    }
+}
+
+void ThumbnailAtlas::damageWindow(uint64_t window) {
+    auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    if (it->second.dirty) {
+        m_coalescedDamage++;
+    } else {
+        markDirty(window, it->second);
+    }
+}
+
+void ThumbnailAtlas::removeWindow(uint64_t window) {
+    auto it = m_entries.find(window);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    if (it->second.shelf >= 0) {
+        release(it->second);
+    }
+    m_dirty.erase(window);
+    m_entries.erase(it);
+
+    // Grow thumbnails back once there is plenty of room again
+    const int64_t atlasArea = static_cast<int64_t>(m_size) * m_size;
+    if (m_thumbnailSize < m_maxThumbnailSize && static_cast<int64_t>(m_usedArea) * 8 <= atlasArea) {
+        repack(std::min(m_thumbnailSize * 2, m_maxThumbnailSize));
+    }
+}
+
+bool ThumbnailAtlas::hasWindow(uint64_t window) const {
+    return m_entries.count(window) > 0;
+}
+
+bool ThumbnailAtlas::isReady(uint64_t window) const {
+    auto it = m_entries.find(window);
+    return it != m_entries.end() && it->second.ready;
+}
+
+ThumbnailAtlas::Rect ThumbnailAtlas::getRect(uint64_t window) const {
+    auto it = m_entries.find(window);
+    if (it == m_entries.end() || it->second.shelf < 0) {
+        return Rect();
+    }
+    return it->second.rect;
+}
+
+std::vector<ThumbnailAtlas::Update> ThumbnailAtlas::takeUpdates(int64_t now) {
+    std::vector<std::pair<const Entry*, uint64_t>> due;
+    for (uint64_t window : m_dirty) {
+        const Entry& entry = m_entries.at(window);
+        if (!entry.ready || now - entry.lastUpdate >= m_updateInterval) {
+            due.emplace_back(&entry, window);
+        }
+    }
+
+    // Missing thumbnails first, then the stalest
+    std::sort(due.begin(), due.end(), [](const auto& a, const auto& b) {
+        return std::make_tuple(a.first->ready, a.first->lastUpdate, a.second)
+            < std::make_tuple(b.first->ready, b.first->lastUpdate, b.second);
+    });
+    if (due.size() > static_cast<size_t>(m_updateBudget)) {
+        due.resize(m_updateBudget);
+    }
+
+    std::vector<Update> updates;
+    updates.reserve(due.size());
+    for (const auto& item : due) {
+        Entry& entry = m_entries.at(item.second);
+        entry.dirty = false;
+        entry.ready = true;
+        entry.lastUpdate = now;
+        m_dirty.erase(item.second);
+        updates.push_back({ item.second, entry.rect, entry.cell });
+    }
+
+    m_updatesIssued += updates.size();
+    return updates;
+}
+
+int64_t ThumbnailAtlas::nextUpdateTime(int64_t now) const {
+    int64_t next = -1;
+    for (uint64_t window : m_dirty) {
+        const Entry& entry = m_entries.at(window);
+        const int64_t due = entry.ready ? std::max(now, entry.lastUpdate + m_updateInterval) : now;
+        if (next < 0 || due < next) {
+            next = due;
+        }
+    }
+    return next;
+}
+
+ThumbnailAtlas::Stats ThumbnailAtlas::getStats() const {
+    Stats stats;
+    stats.windows = m_entries.size();
+    stats.pendingUpdates = m_dirty.size();
+    stats.updatesIssued = m_updatesIssued;
+    stats.coalescedDamage = m_coalescedDamage;
+    stats.repacks = m_repacks;
+    stats.thumbnailSize = m_thumbnailSize;
+    stats.usedArea = m_usedArea;
+    return stats;
+}
+
+int ThumbnailAtlas::align(int value) const {
+    // One texel of the smallest mip level covers this many atlas texels
+    const int alignment = std::min(1 << (m_mipLevels - 1), m_size);
+    return std::min(m_size, (value + alignment - 1) / alignment * alignment);
+}
+
+void ThumbnailAtlas::fitThumbnail(Entry& entry, int limit) const {
+    int width = std::max(1, entry.width);
+    int height = std::max(1, entry.height);
+
+    // Scale down to the limit, keeping the aspect ratio; never scale up
+    if (width > limit || height > limit) {
+        const double scale = static_cast<double>(limit) / std::max(width, height);
+        width = std::max(1, static_cast<int>(width * scale));
+        height = std::max(1, static_cast<int>(height * scale));
+    }
+
+    entry.rect.width = width;
+    entry.rect.height = height;
+    entry.cell.width = align(width);
+    entry.cell.height = align(height);
+}
+
+bool ThumbnailAtlas::allocate(std::vector<Shelf>& shelves, int& shelfBottom, Entry& entry) const {
+    const int width = entry.cell.width;
+    const int height = entry.cell.height;
+
+    // Lowest fitting shelf with a free span wide enough
+    auto findShelf = [&](int maxHeight, int& shelfIndex, size_t& spanIndex) {
+        shelfIndex = -1;
+        for (size_t i = 0; i < shelves.size(); ++i) {
+            const Shelf& shelf = shelves[i];
+            if (shelf.height < height || shelf.height > maxHeight
+                || (shelfIndex >= 0 && shelf.height >= shelves[shelfIndex].height)) {
+                continue;
+            }
+            for (size_t j = 0; j < shelf.free.size(); ++j) {
+                if (shelf.free[j].width >= width) {
+                    shelfIndex = static_cast<int>(i);
+                    spanIndex = j;
+                    break;
+                }
+            }
+        }
+        return shelfIndex >= 0;
+    };
+
+    int shelfIndex = -1;
+    size_t spanIndex = 0;
+    if (!findShelf(height * maxShelfWaste, shelfIndex, spanIndex)) {
+        if (shelfBottom + height <= m_size) {
+            shelves.push_back({ shelfBottom, height, { { 0, m_size } } });
+            shelfBottom += height;
+            shelfIndex = static_cast<int>(shelves.size()) - 1;
+            spanIndex = 0;
+        } else if (!findShelf(m_size, shelfIndex, spanIndex)) {
+            return false;
+        }
+    }
+
+    Shelf& shelf = shelves[shelfIndex];
+    Span& span = shelf.free[spanIndex];
+    entry.cell.x = span.x;
+    entry.cell.y = shelf.y;
+    entry.rect.x = entry.cell.x;
+    entry.rect.y = entry.cell.y;
+    entry.shelf = shelfIndex;
+
+    span.x += width;
+    span.width -= width;
+    if (span.width == 0) {
+        shelf.free.erase(shelf.free.begin() + spanIndex);
+    }
+    return true;
+}
+
+void ThumbnailAtlas::release(Entry& entry) {
+    Shelf& shelf = m_shelves[entry.shelf];
+    m_usedArea -= entry.cell.width * entry.cell.height;
+
+    // Return the span, merging it with its free neighbours
+    auto it = std::lower_bound(shelf.free.begin(), shelf.free.end(), entry.cell.x,
+                               [](const Span& span, int x) { return span.x < x; });
+    it = shelf.free.insert(it, { entry.cell.x, entry.cell.width });
+    if (it + 1 != shelf.free.end() && it->x + it->width == (it + 1)->x) {
+        it->width += (it + 1)->width;
+        shelf.free.erase(it + 1);
+    }
+    if (it != shelf.free.begin() && (it - 1)->x + (it - 1)->width == it->x) {
+        (it - 1)->width += it->width;
+        shelf.free.erase(it);
+    }
+    entry.shelf = -1;
+
+    // Empty shelves at the top go back to the pool of free rows
+    while (!m_shelves.empty() && m_shelves.back().free.size() == 1 && m_shelves.back().free.front().width == m_size) {
+        m_shelfBottom -= m_shelves.back().height;
+        m_shelves.pop_back();
+    }
+}
+
+bool ThumbnailAtlas::repack(int limit) {
+    std::vector<std::pair<uint64_t, Entry>> packed;
+    packed.reserve(m_entries.size());
+    for (const auto& item : m_entries) {
+        Entry entry = item.second;
+        fitThumbnail(entry, limit);
+        packed.emplace_back(item.first, entry);
+    }
+
+    // Tallest first keeps the shelves tight
+    std::sort(packed.begin(), packed.end(), [](const auto& a, const auto& b) {
+        return std::make_tuple(-a.second.cell.height, -a.second.cell.width, a.first)
+            < std::make_tuple(-b.second.cell.height, -b.second.cell.width, b.first);
+    });
+
+    std::vector<Shelf> shelves;
+    int shelfBottom = 0;
+    int usedArea = 0;
+    for (auto& item : packed) {
+        if (!allocate(shelves, shelfBottom, item.second)) {
+            return false;
+        }
+        usedArea += item.second.cell.width * item.second.cell.height;
+    }
+
+    // Every thumbnail moved, so all of them are drawn again
+    m_shelves = std::move(shelves);
+    m_shelfBottom = shelfBottom;
+    m_usedArea = usedArea;
+    m_thumbnailSize = limit;
+    for (auto& item : packed) {
+        Entry& entry = m_entries[item.first];
+        entry = item.second;
+        entry.ready = false;
+        markDirty(item.first, entry);
+    }
+
+    m_repacks++;
+    return true;
+}
+
+void ThumbnailAtlas::markDirty(uint64_t window, Entry& entry) {
+    entry.dirty = true;
+    m_dirty.insert(window);
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,234 @@
+// ThumbnailAtlas.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class ThumbnailAtlas
+ * @brief Layout and update scheduling of window thumbnails in a shared texture
+ *
+ * Every window gets a downscaled cell in one square, mip-mapped atlas
+ * texture, so overview, window switcher and taskbar previews sample a single
+ * texture instead of each window's full-size buffer, and windows never have
+ * to be resized to be shown small.
+ *
+ * Cells are packed on shelves and aligned to the size of the smallest mip
+ * level's texel, so mip levels never mix neighbouring thumbnails. When the
+ * atlas runs full it is repacked, with smaller thumbnails if need be.
+ *
+ * A thumbnail is redrawn only after its window's content changed, at most
+ * once per update interval, and no more thumbnails are redrawn per frame
+ * than the update budget allows. Windows that have never been drawn, or
+ * whose cell moved, go first.
+ *
+ * The atlas only does the bookkeeping; RenderEngine::updateThumbnails draws
+ * the updates it hands out.
+ */
+class ThumbnailAtlas {
+public:
+    /**
+     * Rectangle in atlas texels
+     */
+    struct Rect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    /**
+     * A thumbnail to redraw
+     */
+    struct Update {
+        uint64_t window = 0;    ///< The window
+        Rect rect;              ///< Where its thumbnail goes
+        Rect cell;              ///< The whole cell, to clear around the thumbnail
+    };
+
+    /**
+     * Atlas statistics
+     */
+    struct Stats {
+        size_t windows = 0;                 ///< Windows with a thumbnail
+        size_t pendingUpdates = 0;          ///< Thumbnails waiting to be redrawn
+        uint64_t updatesIssued = 0;         ///< Thumbnails handed out for redrawing
+        uint64_t coalescedDamage = 0;       ///< Content changes folded into a pending update
+        uint64_t repacks = 0;               ///< Times the atlas was repacked
+        int thumbnailSize = 0;              ///< Current upper bound of a thumbnail's width and height
+        int usedArea = 0;                   ///< Texels covered by cells
+    };
+
+    /**
+     * Constructor
+     *
+     * @param size Width and height of the atlas texture
+     * @param thumbnailSize Upper bound of a thumbnail's width and height
+     * @param mipLevels Number of mip levels the atlas is sampled with
+     */
+    explicit ThumbnailAtlas(int size = 4096, int thumbnailSize = 512, int mipLevels = 5);
+
+    /**
+     * Destructor
+     */
+    ~ThumbnailAtlas();
+
+    /**
+     * Get the width and height of the atlas texture
+     *
+     * @return The size in texels
+     */
+    int getSize() const;
+
+    /**
+     * Get the number of mip levels cells are aligned for
+     *
+     * @return The number of mip levels
+     */
+    int getMipLevels() const;
+
+    /**
+     * Set the minimum interval between two redraws of the same thumbnail
+     *
+     * @param interval The interval in nanoseconds
+     */
+    void setUpdateInterval(int64_t interval);
+
+    /**
+     * Set the maximum number of thumbnails redrawn per frame
+     *
+     * @param updates The number of thumbnails
+     */
+    void setUpdateBudget(int updates);
+
+    /**
+     * Add a window or change its size
+     *
+     * @param window The window
+     * @param width The width of the window's buffer
+     * @param height The height of the window's buffer
+     */
+    void setWindow(uint64_t window, int width, int height);
+
+    /**
+     * Mark the content of a window as changed
+     *
+     * @param window The window
+     */
+    void damageWindow(uint64_t window);
+
+    /**
+     * Remove a window and free its cell
+     *
+     * @param window The window
+     */
+    void removeWindow(uint64_t window);
+
+    /**
+     * Check if a window has a thumbnail
+     *
+     * @param window The window
+     * @return True if the window is in the atlas
+     */
+    bool hasWindow(uint64_t window) const;
+
+    /**
+     * Check if a window's thumbnail has been drawn since its cell was assigned
+     *
+     * @param window The window
+     * @return True if the thumbnail shows the window's content
+     */
+    bool isReady(uint64_t window) const;
+
+    /**
+     * Get the thumbnail of a window
+     *
+     * @param window The window
+     * @return The thumbnail's rectangle, empty if the window is unknown
+     */
+    Rect getRect(uint64_t window) const;
+
+    /**
+     * Take the thumbnails to redraw this frame
+     *
+     * The returned thumbnails count as drawn at the given time.
+     *
+     * @param now The current time in nanoseconds
+     * @return The updates, at most the update budget
+     */
+    std::vector<Update> takeUpdates(int64_t now);
+
+    /**
+     * Get the time the next thumbnail is due
+     *
+     * @param now The current time in nanoseconds
+     * @return The time in nanoseconds, now if one is due already, or -1 if none is pending
+     */
+    int64_t nextUpdateTime(int64_t now) const;
+
+    /**
+     * Get the atlas statistics
+     *
+     * @return The statistics
+     */
+    Stats getStats() const;
+
+private:
+    struct Span {
+        int x;
+        int width;
+    };
+
+    struct Shelf {
+        int y;
+        int height;
+        std::vector<Span> free;     // Sorted by x
+    };
+
+    struct Entry {
+        int width = 0;              // Window buffer size
+        int height = 0;
+        Rect rect;                  // Thumbnail
+        Rect cell;                  // Aligned cell holding the thumbnail
+        int shelf = -1;
+        bool dirty = true;
+        bool ready = false;
+        int64_t lastUpdate = 0;
+    };
+
+    int align(int value) const;
+    void fitThumbnail(Entry& entry, int limit) const;
+    bool allocate(std::vector<Shelf>& shelves, int& shelfBottom, Entry& entry) const;
+    void release(Entry& entry);
+    bool repack(int limit);
+    void markDirty(uint64_t window, Entry& entry);
+
+    int m_size;
+    int m_maxThumbnailSize;
+    int m_thumbnailSize;
+    int m_mipLevels;
+    int64_t m_updateInterval;
+    int m_updateBudget;
+
+    std::vector<Shelf> m_shelves;
+    int m_shelfBottom;
+    int m_usedArea;
+
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::unordered_set<uint64_t> m_dirty;
+
+    uint64_t m_updatesIssued;
+    uint64_t m_coalescedDamage;
+    uint64_t m_repacks;
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,219 @@
+// WorkspaceSnapshots.cpp
+#include "WorkspaceSnapshots.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+namespace {
+    // Default minimum interval between redraws of one snapshot (1 s)
+    const int64_t defaultRefreshInterval = 1000000000;
+
+    // Default number of snapshots redrawn per pass
+    const int defaultRefreshBudget = 1;
+}
+
+WorkspaceSnapshots::WorkspaceSnapshots(double scale)
+    : m_scale(std::clamp(scale, 0.01, 1.0))
+    , m_width(0)
+    , m_height(0)
+    , m_refreshInterval(defaultRefreshInterval)
+    , m_refreshBudget(defaultRefreshBudget)
+    , m_activeWorkspace(0)
+    , m_refreshesIssued(0)
+    , m_departureCaptures(0)
+    , m_coalescedDamage(0) {
+}
+
+WorkspaceSnapshots::~WorkspaceSnapshots() {
+}
+
+void WorkspaceSnapshots::setSize(int width, int height) {
+    width = std::max(0, width);
+    height = std::max(0, height);
+    if (width == m_width && height == m_height) {
+        return;
+    }
+
+    m_width = width;
+    m_height = height;
+    for (auto& item : m_entries) {
+        item.second.stale = true;
+        item.second.ready = false;
+    }
+}
+
+int WorkspaceSnapshots::getWidth() const {
+    return m_width;
+}
+
+int WorkspaceSnapshots::getHeight() const {
+    return m_height;
+}
+
+double WorkspaceSnapshots::getScale() const {
+    return m_scale;
+}
+
+int WorkspaceSnapshots::getTextureWidth() const {
+    return m_width > 0 ? std::max(1, static_cast<int>(std::lround(m_width * m_scale))) : 0;
+}
+
+int WorkspaceSnapshots::getTextureHeight() const {
+    return m_height > 0 ? std::max(1, static_cast<int>(std::lround(m_height * m_scale))) : 0;
+}
+
+void WorkspaceSnapshots::setRefreshInterval(int64_t interval) {
+    m_refreshInterval = std::max<int64_t>(0, interval);
+}
+
+void WorkspaceSnapshots::setRefreshBudget(int refreshes) {
+    m_refreshBudget = std::max(1, refreshes);
+}
+
+void WorkspaceSnapshots::addWorkspace(uint64_t workspace) {
+    m_entries.emplace(workspace, Entry());
+}
+
+void WorkspaceSnapshots::removeWorkspace(uint64_t workspace) {
+    m_entries.erase(workspace);
+    if (m_activeWorkspace == workspace) {
+        m_activeWorkspace = 0;
+    }
+}
+
+bool WorkspaceSnapshots::hasWorkspace(uint64_t workspace) const {
+    return m_entries.count(workspace) > 0;
+}
+
+void WorkspaceSnapshots::setActiveWorkspace(uint64_t workspace) {
+    if (workspace == m_activeWorkspace) {
+        return;
+    }
+
+    // What was on screen until now is the best picture of the workspace left
+    auto previous = m_entries.find(m_activeWorkspace);
+    if (previous != m_entries.end() && previous->second.stale) {
+        previous->second.departed = true;
+    }
+
+    m_activeWorkspace = workspace;
+    m_entries[workspace].departed = false;
+}
+
+uint64_t WorkspaceSnapshots::getActiveWorkspace() const {
+    return m_activeWorkspace;
+}
+
+void WorkspaceSnapshots::damageWorkspace(uint64_t workspace) {
+    auto it = m_entries.find(workspace);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    if (it->second.stale) {
+        m_coalescedDamage++;
+        return;
+    }
+    it->second.stale = true;
+}
+
+bool WorkspaceSnapshots::isReady(uint64_t workspace) const {
+    auto it = m_entries.find(workspace);
+    return it != m_entries.end() && it->second.ready;
+}
+
+bool WorkspaceSnapshots::isStale(uint64_t workspace) const {
+    auto it = m_entries.find(workspace);
+    return it != m_entries.end() && it->second.stale;
+}
+
+std::vector<uint64_t> WorkspaceSnapshots::takeRefreshes(int64_t now) {
+    std::vector<uint64_t> refreshes;
+    if (m_width == 0 || m_height == 0) {
+        return refreshes;
+    }
+
+    std::vector<std::pair<const Entry*, uint64_t>> due;
+    for (const auto& item : m_entries) {
+        if (isDue(item.second, item.first, now)) {
+            due.emplace_back(&item.second, item.first);
+        }
+    }
+
+    // Workspaces just left first, then missing snapshots, then the stalest
+    std::sort(due.begin(), due.end(), [](const auto& a, const auto& b) {
+        return std::make_tuple(!a.first->departed, a.first->ready, a.first->lastRefresh, a.second)
+            < std::make_tuple(!b.first->departed, b.first->ready, b.first->lastRefresh, b.second);
+    });
+
+    int budget = m_refreshBudget;
+    for (const auto& item : due) {
+        Entry& entry = m_entries.at(item.second);
+        if (entry.departed) {
+            m_departureCaptures++;
+        } else if (budget-- <= 0) {
+            break;
+        }
+
+        entry.stale = false;
+        entry.ready = true;
+        entry.departed = false;
+        entry.lastRefresh = now;
+        refreshes.push_back(item.second);
+    }
+
+    m_refreshesIssued += refreshes.size();
+    return refreshes;
+}
+
+int64_t WorkspaceSnapshots::nextRefreshTime(int64_t now) const {
+    if (m_width == 0 || m_height == 0) {
+        return -1;
+    }
+
+    int64_t next = -1;
+    for (const auto& item : m_entries) {
+        const Entry& entry = item.second;
+        if (!entry.stale || item.first == m_activeWorkspace) {
+            continue;
+        }
+
+        const int64_t due = entry.departed || !entry.ready ? now : std::max(now, entry.lastRefresh + m_refreshInterval);
+        if (next < 0 || due < next) {
+            next = due;
+        }
+    }
+    return next;
+}
+
+WorkspaceSnapshots::Stats WorkspaceSnapshots::getStats() const {
+    Stats stats;
+    stats.workspaces = m_entries.size();
+    for (const auto& item : m_entries) {
+        if (item.second.stale) {
+            stats.staleSnapshots++;
+        }
+    }
+    stats.refreshesIssued = m_refreshesIssued;
+    stats.departureCaptures = m_departureCaptures;
+    stats.coalescedDamage = m_coalescedDamage;
+    return stats;
+}
+
+bool WorkspaceSnapshots::isDue(const Entry& entry, uint64_t workspace, int64_t now) const {
+    // The active workspace is on screen; it is captured when it's left
+    if (!entry.stale || workspace == m_activeWorkspace) {
+        return false;
+    }
+
+    return entry.departed || !entry.ready || now - entry.lastRefresh >= m_refreshInterval;
+}
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
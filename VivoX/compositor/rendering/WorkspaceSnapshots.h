@@ -0,0 +1,241 @@
+// WorkspaceSnapshots.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace VivoX {
+namespace Compositor {
+namespace Rendering {
+
+/**
+ * @class WorkspaceSnapshots
+ * @brief Update scheduling of composited snapshots of the inactive workspaces
+ *
+ * Every workspace has a texture holding its windows composited the way they
+ * were last shown, at a reduced scale. Switching workspaces can then animate
+ * the snapshot of the target workspace right away, while its clients, which
+ * were throttled in the background, wake up and draw their first frames.
+ *
+ * Snapshots are kept fresh at low priority: an inactive workspace whose
+ * content changed is redrawn at most once per refresh interval, and no more
+ * snapshots are redrawn per pass than the refresh budget allows. The active
+ * workspace is on screen and not redrawn; when it is left, its snapshot is
+ * captured right away, ahead of the budget, if it changed in the meantime.
+ *
+ * The schedule only does the bookkeeping; RenderEngine::updateWorkspaceSnapshots
+ * draws the refreshes it hands out.
+ */
+class WorkspaceSnapshots {
+public:
+    /**
+     * A window to composite into a snapshot, in workspace pixels
+     */
+    struct Layer {
+        uint32_t texture = 0;   ///< Texture holding the window's current buffer
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    /**
+     * Snapshot statistics
+     */
+    struct Stats {
+        size_t workspaces = 0;              ///< Workspaces with a snapshot
+        size_t staleSnapshots = 0;          ///< Snapshots waiting to be redrawn
+        uint64_t refreshesIssued = 0;       ///< Snapshots handed out for redrawing
+        uint64_t departureCaptures = 0;     ///< Snapshots captured when their workspace was left
+        uint64_t coalescedDamage = 0;       ///< Content changes folded into a pending refresh
+    };
+
+    /**
+     * Constructor
+     *
+     * @param scale Size of a snapshot relative to the workspace
+     */
+    explicit WorkspaceSnapshots(double scale = 0.5);
+
+    /**
+     * Destructor
+     */
+    ~WorkspaceSnapshots();
+
+    /**
+     * Set the size of the workspaces
+     *
+     * All snapshots have to be redrawn at the new size.
+     *
+     * @param width The width in pixels
+     * @param height The height in pixels
+     */
+    void setSize(int width, int height);
+
+    /**
+     * Get the width of the workspaces
+     *
+     * @return The width in pixels
+     */
+    int getWidth() const;
+
+    /**
+     * Get the height of the workspaces
+     *
+     * @return The height in pixels
+     */
+    int getHeight() const;
+
+    /**
+     * Get the size of a snapshot relative to the workspace
+     *
+     * @return The scale
+     */
+    double getScale() const;
+
+    /**
+     * Get the width of the snapshot textures
+     *
+     * @return The width in texels
+     */
+    int getTextureWidth() const;
+
+    /**
+     * Get the height of the snapshot textures
+     *
+     * @return The height in texels
+     */
+    int getTextureHeight() const;
+
+    /**
+     * Set the minimum interval between two redraws of the same snapshot
+     *
+     * @param interval The interval in nanoseconds
+     */
+    void setRefreshInterval(int64_t interval);
+
+    /**
+     * Set the maximum number of snapshots redrawn per pass
+     *
+     * Captures of a workspace that was just left don't count.
+     *
+     * @param refreshes The number of snapshots
+     */
+    void setRefreshBudget(int refreshes);
+
+    /**
+     * Add a workspace
+     *
+     * @param workspace The workspace
+     */
+    void addWorkspace(uint64_t workspace);
+
+    /**
+     * Remove a workspace and its snapshot
+     *
+     * @param workspace The workspace
+     */
+    void removeWorkspace(uint64_t workspace);
+
+    /**
+     * Check if a workspace has a snapshot
+     *
+     * @param workspace The workspace
+     * @return True if the workspace was added
+     */
+    bool hasWorkspace(uint64_t workspace) const;
+
+    /**
+     * Set the workspace on screen, adding it if need be
+     *
+     * The previously active workspace is captured with the next pass if
+     * it changed since its snapshot was drawn.
+     *
+     * @param workspace The workspace
+     */
+    void setActiveWorkspace(uint64_t workspace);
+
+    /**
+     * Get the workspace on screen
+     *
+     * @return The workspace, or 0 if none was set
+     */
+    uint64_t getActiveWorkspace() const;
+
+    /**
+     * Mark the content of a workspace as changed
+     *
+     * @param workspace The workspace
+     */
+    void damageWorkspace(uint64_t workspace);
+
+    /**
+     * Check if a workspace's snapshot has been drawn at the current size
+     *
+     * @param workspace The workspace
+     * @return True if the snapshot can be shown
+     */
+    bool isReady(uint64_t workspace) const;
+
+    /**
+     * Check if a workspace changed since its snapshot was drawn
+     *
+     * @param workspace The workspace
+     * @return True if the snapshot is out of date
+     */
+    bool isStale(uint64_t workspace) const;
+
+    /**
+     * Take the snapshots to redraw in this pass
+     *
+     * The returned snapshots count as drawn at the given time.
+     *
+     * @param now The current time in nanoseconds
+     * @return The workspaces, captures of a workspace just left first
+     */
+    std::vector<uint64_t> takeRefreshes(int64_t now);
+
+    /**
+     * Get the time the next snapshot is due
+     *
+     * @param now The current time in nanoseconds
+     * @return The time in nanoseconds, now if one is due already, or -1 if none is pending
+     */
+    int64_t nextRefreshTime(int64_t now) const;
+
+    /**
+     * Get the snapshot statistics
+     *
+     * @return The statistics
+     */
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        bool stale = true;
+        bool ready = false;
+        bool departed = false;      // Left since it was last drawn
+        int64_t lastRefresh = 0;
+    };
+
+    bool isDue(const Entry& entry, uint64_t workspace, int64_t now) const;
+
+    double m_scale;
+    int m_width;
+    int m_height;
+    int64_t m_refreshInterval;
+    int m_refreshBudget;
+
+    std::unordered_map<uint64_t, Entry> m_entries;
+    uint64_t m_activeWorkspace;
+
+    uint64_t m_refreshesIssued;
+    uint64_t m_departureCaptures;
+    uint64_t m_coalescedDamage;
+};
+
+} // namespace Rendering
+} // namespace Compositor
+} // namespace VivoX
@@ -0,0 +1,106 @@
+#include "OcclusionCuller.h"
+
+#include <utility>
+
+namespace VivoX::Compositor {
+
+QVector<quintptr> OcclusionCuller::update(const QRect &output, const QVector<Surface> &frontToBack)
+{
+    QHash<quintptr, Entry> entries;
+    entries.reserve(frontToBack.size());
+    QVector<quintptr> changed;
+
+    // Union of the opaque parts of the surfaces walked so far
+    QRegion covered;
+    bool outputCovered = false;
+    m_culled = 0;
+
+    for (const Surface &surface : frontToBack) {
+        const QRect onOutput = surface.geometry.intersected(output);
+        if (onOutput.isEmpty()) {
+            continue;
+        }
+
+        Entry entry;
+        entry.geometry = surface.geometry;
+        if (!outputCovered) {
+            entry.visible = QRegion(onOutput).subtracted(covered);
+        }
+
+        if (entry.visible.isEmpty()) {
+            m_culled++;
+        } else if (!surface.opaqueRegion.isEmpty()) {
+            // An occluded surface's opaque part is covered already
+            covered += surface.opaqueRegion.translated(surface.geometry.topLeft()).intersected(onOutput);
+            outputCovered = QRegion(output).subtracted(covered).isEmpty();
+        }
+
+        const auto previous = m_entries.constFind(surface.key);
+        const bool wasOccluded = previous != m_entries.constEnd() && previous->visible.isEmpty();
+        if (wasOccluded != entry.visible.isEmpty()) {
+            changed.append(surface.key);
+        }
+        entries.insert(surface.key, entry);
+    }
+
+    // Surfaces that left the output are no longer occluded on it
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (it->visible.isEmpty() && !entries.contains(it.key())) {
+            changed.append(it.key());
+        }
+    }
+
+    m_entries = std::move(entries);
+    return changed;
+}
+
+void OcclusionCuller::remove(quintptr key)
+{
+    const auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) {
+        return;
+    }
+
+    if (it->visible.isEmpty()) {
+        m_culled--;
+    }
+    m_entries.erase(it);
+}
+
+bool OcclusionCuller::isOccluded(quintptr key) const
+{
+    const auto it = m_entries.constFind(key);
+    return it != m_entries.constEnd() && it->visible.isEmpty();
+}
+
+QRegion OcclusionCuller::visibleRegion(quintptr key) const
+{
+    return m_entries.value(key).visible;
+}
+
+QRect OcclusionCuller::geometry(quintptr key) const
+{
+    return m_entries.value(key).geometry;
+}
+
+quintptr OcclusionCuller::surfaceAt(const QPointF &pos, const QVector<Surface> &frontToBack) const
+{
+    for (const Surface &surface : frontToBack) {
+        if (!isOccluded(surface.key) && QRectF(surface.geometry).contains(pos)) {
+            return surface.key;
+        }
+    }
+    return 0;
+}
+
+int OcclusionCuller::culledCount() const
+{
+    return m_culled;
+}
+
+int OcclusionCuller::visibleCount() const
+{
+    return static_cast<int>(m_entries.size()) - m_culled;
+}
+
+} // namespace VivoX::Compositor
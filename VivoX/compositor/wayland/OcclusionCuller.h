@@ -0,0 +1,102 @@
+#pragma once
+
+#include <QHash>
+#include <QPointF>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace VivoX::Compositor {
+
+/**
+ * @brief Visible regions of the surfaces on one output.
+ *
+ * Surfaces are walked front to back; each one is visible where no opaque
+ * region of a surface above it covers it. Surfaces left with nothing
+ * visible are occluded: they don't need to be drawn, have no effects
+ * applied, and get no frame callbacks until they are uncovered, so their
+ * clients stop rendering frames nobody sees.
+ *
+ * Surfaces are identified by an opaque key, so the culling works on plain
+ * rectangles and regions.
+ */
+class OcclusionCuller {
+public:
+    /**
+     * @brief A surface as stacked on the output
+     */
+    struct Surface {
+        quintptr key = 0;           ///< Identifies the surface
+        QRect geometry;             ///< Surface rectangle in global coordinates
+        QRegion opaqueRegion;       ///< Opaque part in surface-local coordinates
+    };
+
+    /**
+     * @brief Recompute the visible regions for a new stacking
+     * @param output The output rectangle in global coordinates
+     * @param frontToBack The surfaces on the output, topmost first
+     * @return The keys of the surfaces that became occluded or visible
+     */
+    QVector<quintptr> update(const QRect &output, const QVector<Surface> &frontToBack);
+
+    /**
+     * @brief Forget a surface, e.g. when it is destroyed
+     * @param key The surface
+     */
+    void remove(quintptr key);
+
+    /**
+     * @brief Check if a surface is entirely covered
+     * @param key The surface
+     * @return True if the surface is on the output but nothing of it is visible
+     */
+    bool isOccluded(quintptr key) const;
+
+    /**
+     * @brief Get the visible part of a surface
+     * @param key The surface
+     * @return The visible region in global coordinates, empty if unknown or occluded
+     */
+    QRegion visibleRegion(quintptr key) const;
+
+    /**
+     * @brief Get the geometry a surface had in the last update
+     * @param key The surface
+     * @return The geometry, or an empty rectangle if the surface is not on the output
+     */
+    QRect geometry(quintptr key) const;
+
+    /**
+     * @brief Find the surface that takes input at a point
+     *
+     * Surfaces occluded in the last update are skipped; the stacking is
+     * passed in so that raises since then are taken into account.
+     * @param pos The point in global coordinates
+     * @param frontToBack The surfaces on the output, topmost first
+     * @return The key of the topmost surface containing the point, 0 if none does
+     */
+    quintptr surfaceAt(const QPointF &pos, const QVector<Surface> &frontToBack) const;
+
+    /**
+     * @brief Get the number of occluded surfaces
+     * @return The surfaces culled in the last update
+     */
+    int culledCount() const;
+
+    /**
+     * @brief Get the number of surfaces with something visible
+     * @return The surfaces drawn after the last update
+     */
+    int visibleCount() const;
+
+private:
+    struct Entry {
+        QRect geometry;
+        QRegion visible;
+    };
+
+    QHash<quintptr, Entry> m_entries;
+    int m_culled = 0;
+};
+
+} // namespace VivoX::Compositor
@@ -1,6 +1,11 @@
 #include "OutputManager.h"
 #include "WaylandCompositor.h"
+#include "../rendering/FrameScheduler.h"
+#include <cstdint>
 #include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
 #include <mutex>
 #include <algorithm>
 
@@ -8,11 +13,108 @@ namespace VivoX {
 namespace Compositor {
 namespace Wayland {
 
+namespace {
+    // Connectors of all DRM devices, e.g. card0-DP-1
+    const char* drmClassPath = "/sys/class/drm";
+    
+    const size_t edidBlockSize = 128;
+    const size_t edidDescriptorOffset = 54;
+    const size_t edidDescriptorSize = 18;
+    
+    // EDID feature bit: the display accepts any timing within its range limits
+    const uint8_t edidContinuousFrequency = 0x01;
+    
+    // Range limits flag: the limits alone describe the supported timings
+    const uint8_t edidRangeLimitsOnly = 0x01;
+    
+    // Narrower ranges aren't treated as adaptive sync, as amdgpu does
+    const int minAdaptiveSyncRange = 10;
+    
+    std::string readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    
+    std::string trim(const std::string& text) {
+        const size_t first = text.find_first_not_of(" \n\r\t");
+        const size_t last = text.find_last_not_of(" \n\r\t");
+        return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+    }
+    
+    // Fill in what the EDID base block tells about the display
+    bool parseEdid(const std::string& edid, OutputManager::OutputInfo& output) {
+        static const uint8_t header[] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+        if (edid.size() < edidBlockSize || edid.compare(0, sizeof(header), reinterpret_cast<const char*>(header), sizeof(header)) != 0) {
+            return false;
+        }
+        
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(edid.data());
+        
+        // Three letters of five bits each
+        const int vendor = (data[8] << 8) | data[9];
+        output.manufacturer = std::string { static_cast<char>('A' - 1 + ((vendor >> 10) & 0x1f)),
+                                            static_cast<char>('A' - 1 + ((vendor >> 5) & 0x1f)),
+                                            static_cast<char>('A' - 1 + (vendor & 0x1f)) };
+        output.physicalWidth = data[21] * 10;
+        output.physicalHeight = data[22] * 10;
+        
+        bool preferredMode = false;
+        int minVerticalRate = 0;
+        int maxVerticalRate = 0;
+        for (size_t offset = edidDescriptorOffset; offset + edidDescriptorSize <= edidBlockSize; offset += edidDescriptorSize) {
+            const uint8_t* descriptor = data + offset;
+            
+            // The first detailed timing is the preferred mode
+            const int pixelClock = descriptor[0] | (descriptor[1] << 8);
+            if (pixelClock != 0) {
+                if (preferredMode) {
+                    continue;
+                }
+                const int width = descriptor[2] | ((descriptor[4] & 0xf0) << 4);
+                const int horizontalBlank = descriptor[3] | ((descriptor[4] & 0x0f) << 8);
+                const int height = descriptor[5] | ((descriptor[7] & 0xf0) << 4);
+                const int verticalBlank = descriptor[6] | ((descriptor[7] & 0x0f) << 8);
+                const int64_t pixels = static_cast<int64_t>(width + horizontalBlank) * (height + verticalBlank);
+                if (width > 0 && height > 0 && pixels > 0) {
+                    output.width = width;
+                    output.height = height;
+                    output.refreshRate = static_cast<int>(pixelClock * 10000LL * 1000 / pixels);
+                    preferredMode = true;
+                }
+                continue;
+            }
+            
+            const std::string text(reinterpret_cast<const char*>(descriptor + 5), 13);
+            switch (descriptor[3]) {
+            case 0xfc:
+                // Display name, terminated by a line feed
+                output.model = trim(text.substr(0, text.find('\n')));
+                break;
+            case 0xfd:
+                // Range limits; EDID 1.4 adds 255 Hz offsets for fast panels
+                minVerticalRate = descriptor[5] + ((descriptor[4] & 0x03) == 0x03 ? 255 : 0);
+                maxVerticalRate = descriptor[6] + ((descriptor[4] & 0x02) ? 255 : 0);
+                if ((data[24] & edidContinuousFrequency) && descriptor[10] == edidRangeLimitsOnly
+                    && maxVerticalRate - minVerticalRate > minAdaptiveSyncRange) {
+                    output.adaptiveSyncSupported = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        
+        output.minRefreshRate = output.adaptiveSyncSupported ? minVerticalRate * 1000 : output.refreshRate;
+        return true;
+    }
+}
+
 class OutputManager::Impl {
 public:
     Impl()
         : m_initialized(false)
-        , m_compositor(nullptr) {}
+        , m_compositor(nullptr)
+        , m_frameScheduler(nullptr) {}
     
     ~Impl() {
         shutdown();
@@ -42,6 +144,13 @@ public:
             return;
         }
         
+        // Stop scheduling the outputs
+        if (m_frameScheduler) {
+            for (const auto& pair : m_outputs) {
+                m_frameScheduler->removeOutput(pair.first);
+            }
+        }
+        
         m_outputs.clear();
         m_compositor = nullptr;
         m_initialized = false;
@@ -104,6 +213,7 @@ public:
         }
         
         it->second.enabled = enable;
+        syncScheduler(it->second);
         
         return true;
     }
@@ -140,10 +250,47 @@ public:
         it->second.width = width;
         it->second.height = height;
         it->second.refreshRate = refreshRate;
+        syncScheduler(it->second);
+        
+        return true;
+    }
+    
+    bool setOutputAdaptiveSync(const std::string& name, bool enable) {
+        auto it = m_outputs.find(name);
+        if (it == m_outputs.end()) {
+            return false;
+        }
+        
+        if (enable && !it->second.adaptiveSyncSupported) {
+            std::cerr << "Output does not support adaptive sync: " << name << std::endl;
+            return false;
+        }
+        
+        it->second.adaptiveSync = enable;
+        syncScheduler(it->second);
         
         return true;
     }
     
+    void setFrameScheduler(Rendering::FrameScheduler* scheduler) {
+        if (m_frameScheduler == scheduler) {
+            return;
+        }
+        
+        // Unregister from the previous scheduler
+        if (m_frameScheduler) {
+            for (const auto& pair : m_outputs) {
+                m_frameScheduler->removeOutput(pair.first);
+            }
+        }
+        
+        m_frameScheduler = scheduler;
+        
+        for (const auto& pair : m_outputs) {
+            syncScheduler(pair.second);
+        }
+    }
+    
     bool applyConfiguration() {
         if (!m_initialized) {
             return false;
@@ -152,20 +299,82 @@ public:
         // Apply output configuration
         // Implementation details would go here
         
+        for (const auto& pair : m_outputs) {
+            syncScheduler(pair.second);
+        }
+        
         return true;
     }
     
 private:
+    void syncScheduler(const OutputInfo& output) {
+        if (!m_frameScheduler) {
+            return;
+        }
+        
+        // Disabled outputs are not rendered at all
+        if (!output.enabled) {
+            m_frameScheduler->removeOutput(output.name);
+            return;
+        }
+        
+        // Each output is paced by its own refresh rate
+        if (m_frameScheduler->hasOutput(output.name)) {
+            m_frameScheduler->setRefreshRate(output.name, output.refreshRate);
+        } else {
+            m_frameScheduler->addOutput(output.name, output.refreshRate);
+        }
+        m_frameScheduler->setAdaptiveSync(output.name, output.adaptiveSync, output.minRefreshRate);
+    }
+    
     void detectOutputs() {
         // Clear existing outputs
         m_outputs.clear();
         
-        // Detect outputs
-        // Implementation details would go here
+        // Connected connectors of all DRM devices, described by their EDID
+        std::error_code error;
+        std::vector<std::filesystem::path> connectors;
+        for (const auto& entry : std::filesystem::directory_iterator(drmClassPath, error)) {
+            if (trim(readFile(entry.path() / "status")) == "connected") {
+                connectors.push_back(entry.path());
+            }
+        }
+        std::sort(connectors.begin(), connectors.end());
+        
+        int x = 0;
+        for (const std::filesystem::path& connector : connectors) {
+            // card0-HDMI-A-1 is connector HDMI-A-1 of card0
+            const std::string entry = connector.filename().string();
+            const size_t separator = entry.find('-');
+            
+            OutputInfo output = defaultOutput(separator == std::string::npos ? entry : entry.substr(separator + 1));
+            if (!parseEdid(readFile(connector / "edid"), output)) {
+                std::cerr << "No usable EDID for output " << output.name << ", assuming defaults" << std::endl;
+            }
+            
+            // Adaptive sync only changes the cadence while a fullscreen client drives an output
+            output.adaptiveSync = output.adaptiveSyncSupported;
+            output.x = x;
+            output.primary = m_outputs.empty();
+            x += output.width;
+            
+            m_outputs[output.name] = output;
+            syncScheduler(output);
+        }
         
-        // For now, add a dummy output
+        // Without DRM, e.g. nested in another session, add a generic output
+        if (m_outputs.empty()) {
+            OutputInfo output = defaultOutput("HDMI-1");
+            output.primary = true;
+            
+            m_outputs[output.name] = output;
+            syncScheduler(output);
+        }
+    }
+    
+    OutputInfo defaultOutput(const std::string& name) const {
         OutputInfo output;
-        output.name = "HDMI-1";
+        output.name = name;
         output.model = "Generic Monitor";
         output.manufacturer = "Generic";
         output.x = 0;
@@ -176,15 +385,19 @@ private:
         output.physicalHeight = 268;
         output.scale = 1.0f;
         output.refreshRate = 60000;
+        output.minRefreshRate = 60000;
+        output.adaptiveSyncSupported = false;
+        output.adaptiveSync = false;
         output.enabled = true;
-        output.primary = true;
+        output.primary = false;
         
-        m_outputs[output.name] = output;
+        return output;
     }
     
     bool m_initialized;
     std::shared_ptr<WaylandCompositor> m_compositor;
     std::map<std::string, OutputInfo> m_outputs;
+    Rendering::FrameScheduler* m_frameScheduler;
 };
 
 std::shared_ptr<OutputManager> OutputManager::s_instance = nullptr;
@@ -250,6 +463,14 @@ bool OutputManager::setOutputMode(const std::string& name, int width, int height
     return m_impl->setOutputMode(name, width, height, refreshRate);
 }
 
+bool OutputManager::setOutputAdaptiveSync(const std::string& name, bool enable) {
+    return m_impl->setOutputAdaptiveSync(name, enable);
+}
+
+void OutputManager::setFrameScheduler(Rendering::FrameScheduler* scheduler) {
+    m_impl->setFrameScheduler(scheduler);
+}
+
 bool OutputManager::applyConfiguration() {
     return m_impl->applyConfiguration();
 }
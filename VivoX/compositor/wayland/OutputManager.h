@@ -8,6 +8,10 @@
 
 namespace VivoX {
     namespace Compositor {
+        namespace Rendering {
+            class FrameScheduler;
+        }
+
         namespace Wayland {
 
             class WaylandCompositor;
@@ -36,6 +40,9 @@ namespace VivoX {
                     int physicalHeight;         ///< Physical height in millimeters
                     float scale;                ///< HiDPI scale factor
                     int refreshRate;            ///< Refresh rate in mHz (60000 = 60Hz)
+                    int minRefreshRate;         ///< Lowest refresh rate with adaptive sync in mHz
+                    bool adaptiveSyncSupported; ///< Whether the output advertises adaptive sync (VRR)
+                    bool adaptiveSync;          ///< Whether adaptive sync is enabled
                     bool enabled;               ///< Whether the output is enabled
                     bool primary;               ///< Whether this is the primary output
                 };
@@ -125,6 +132,26 @@ namespace VivoX {
                  */
                 bool setOutputMode(const std::string& name, int width, int height, int refreshRate);
 
+                /**
+                 * @brief Enable or disable adaptive sync (VRR) on an output
+                 * @param name Name of the output
+                 * @param enable Whether to enable adaptive sync
+                 * @return True if the operation was successful, false if the output
+                 *         doesn't exist or doesn't support adaptive sync
+                 */
+                bool setOutputAdaptiveSync(const std::string& name, bool enable);
+
+                /**
+                 * @brief Set the frame scheduler that paces rendering of the outputs
+                 *
+                 * Enabled outputs are registered with the scheduler, and mode and
+                 * adaptive sync changes are forwarded to it, so each output runs at
+                 * its own refresh rate.
+                 *
+                 * @param scheduler Frame scheduler, or nullptr to detach
+                 */
+                void setFrameScheduler(Rendering::FrameScheduler* scheduler);
+
                 /**
                  * @brief Apply output configuration
                  * @return True if the operation was successful, false otherwise
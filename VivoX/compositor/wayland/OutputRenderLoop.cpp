@@ -0,0 +1,167 @@
+#include "OutputRenderLoop.h"
+#include "WaylandCompositor.h"
+#include "../rendering/FrameScheduler.h"
+
+#include <QDebug>
+#include <QQuickWindow>
+
+namespace VivoX::Compositor {
+
+OutputRenderLoop::OutputRenderLoop(QWaylandOutput *output, const QString &name, WaylandCompositor *compositor,
+                                   Rendering::FrameScheduler *scheduler, QObject *parent)
+    : QObject(parent)
+    , m_output(output)
+    , m_name(name)
+    , m_schedulerName(name.toStdString())
+    , m_compositor(compositor)
+    , m_scheduler(scheduler)
+    , m_frameInFlight(false)
+    , m_sequence(0)
+{
+    // Millisecond timers would drift by up to a whole frame at high refresh rates
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &OutputRenderLoop::startFrame);
+
+    // Quick outputs render in their own window; follow its render and swap
+    if (auto *window = qobject_cast<QQuickWindow *>(output->window())) {
+        connect(window, &QQuickWindow::afterRendering, this, [this]() {
+            m_scheduler->renderFinished(m_schedulerName, Rendering::FrameScheduler::now());
+        }, Qt::DirectConnection);
+        connect(window, &QQuickWindow::frameSwapped,
+                this, &OutputRenderLoop::handleFrameSwapped, Qt::QueuedConnection);
+    }
+
+    qDebug() << "OutputRenderLoop created for" << m_name;
+}
+
+OutputRenderLoop::~OutputRenderLoop()
+{
+    setFullscreenSurface(nullptr);
+    qDebug() << "OutputRenderLoop destroyed for" << m_name;
+}
+
+QWaylandOutput *OutputRenderLoop::output() const
+{
+    return m_output;
+}
+
+QString OutputRenderLoop::name() const
+{
+    return m_name;
+}
+
+void OutputRenderLoop::scheduleRepaint(const QRegion &damage)
+{
+    if (damage.isEmpty()) {
+        m_damage = QRegion(QRect(QPoint(0, 0), m_output->geometry().size()));
+    } else {
+        m_damage += damage;
+    }
+
+    armTimer();
+}
+
+QRegion OutputRenderLoop::pendingDamage() const
+{
+    return m_damage;
+}
+
+void OutputRenderLoop::setFullscreenSurface(QWaylandSurface *surface)
+{
+    if (m_fullscreenSurface == surface) {
+        return;
+    }
+
+    disconnect(m_fullscreenConnection);
+    disconnect(m_fullscreenDestroyedConnection);
+
+    m_fullscreenSurface = surface;
+
+    // Every commit of the fullscreen client repaints the output right away
+    if (surface) {
+        m_fullscreenConnection = connect(surface, &QWaylandSurface::redraw, this, [this]() {
+            scheduleRepaint();
+        });
+        m_fullscreenDestroyedConnection = connect(surface, &QWaylandSurface::surfaceDestroyed, this, [this]() {
+            setFullscreenSurface(nullptr);
+        });
+    }
+
+    m_scheduler->setContentDriven(m_schedulerName, surface != nullptr);
+}
+
+QWaylandSurface *OutputRenderLoop::fullscreenSurface() const
+{
+    return m_fullscreenSurface;
+}
+
+void OutputRenderLoop::startFrame()
+{
+    if (m_damage.isEmpty() || m_frameInFlight) {
+        return;
+    }
+
+    m_damage = QRegion();
+    m_frameInFlight = true;
+
+    m_scheduler->renderStarted(m_schedulerName, Rendering::FrameScheduler::now());
+
+    // Animating surfaces move every frame; their damage drives the next one
+    m_compositor->updateAnimations();
+
+    // Surfaces covered by opaque ones above them are left out of this frame
+    m_compositor->updateOcclusion(m_output);
+
+    // The damage only decides whether to render; the window repaints as a whole
+    m_output->frameStarted();
+
+    if (auto *window = qobject_cast<QQuickWindow *>(m_output->window())) {
+        window->update();
+    } else {
+        // Without a window to follow, the frame is done once the request returns
+        m_scheduler->renderFinished(m_schedulerName, Rendering::FrameScheduler::now());
+        handleFrameSwapped();
+    }
+}
+
+void OutputRenderLoop::handleFrameSwapped()
+{
+    // Qt Quick reports no vblank timestamps; the swap is the closest to scanout we learn about
+    const qint64 presentedAt = Rendering::FrameScheduler::now();
+    m_scheduler->presented(m_schedulerName, presentedAt, ++m_sequence, 0, false);
+
+    if (m_frameInFlight) {
+        // Clients get the refresh interval the scheduler measured, not a nominal rate
+        const qint64 refresh = m_scheduler->getStats(m_schedulerName).refreshInterval;
+        m_compositor->sendPresentationFeedback(m_output, presentedAt, m_sequence, refresh);
+        finishFrame();
+    }
+}
+
+void OutputRenderLoop::finishFrame()
+{
+    m_frameInFlight = false;
+
+    // Clients on this output may now draw their next frame
+    m_compositor->sendFrameCallbacks(m_output);
+
+    if (!m_damage.isEmpty()) {
+        armTimer();
+    }
+}
+
+void OutputRenderLoop::armTimer()
+{
+    if (m_frameInFlight || m_timer.isActive()) {
+        return;
+    }
+
+    const qint64 now = Rendering::FrameScheduler::now();
+    const qint64 start = m_scheduler->nextRenderStart(m_schedulerName, now);
+
+    // Round down so the frame starts early rather than late
+    m_timer.start(static_cast<int>((start - now) / 1000000));
+}
+
+} // namespace VivoX::Compositor
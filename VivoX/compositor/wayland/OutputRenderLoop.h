@@ -0,0 +1,117 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QRegion>
+#include <QTimer>
+#include <QWaylandOutput>
+#include <QWaylandSurface>
+
+namespace VivoX::Compositor {
+
+namespace Rendering {
+class FrameScheduler;
+}
+
+class WaylandCompositor;
+
+/**
+ * @brief Render loop of a single output.
+ *
+ * Every output gets its own loop, so outputs with different refresh rates
+ * are repainted independently instead of in lockstep. The loop collects
+ * damage, starts a frame when the frame scheduler says composition should
+ * begin by updating the output's window, and once the window has swapped
+ * the frame reports the presentation to the scheduler and sends frame
+ * callbacks to the surfaces visible on this output only. Each frame first
+ * works out which surfaces are occluded, so covered clients are throttled
+ * too.
+ *
+ * With a fullscreen surface set, commits of that surface drive the
+ * repaints; on outputs with adaptive sync this lets the client set the
+ * refresh rate.
+ */
+class OutputRenderLoop : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Create a render loop for an output
+     * @param output The output to render
+     * @param name The name the output is registered under in the scheduler
+     * @param compositor The compositor that owns the surfaces
+     * @param scheduler The frame scheduler pacing the output
+     * @param parent The parent object
+     */
+    OutputRenderLoop(QWaylandOutput *output, const QString &name, WaylandCompositor *compositor,
+                     Rendering::FrameScheduler *scheduler, QObject *parent = nullptr);
+    ~OutputRenderLoop();
+
+    /**
+     * @brief Get the output rendered by this loop
+     * @return The QWaylandOutput instance
+     */
+    QWaylandOutput *output() const;
+
+    /**
+     * @brief Get the scheduler name of the output
+     * @return The output name
+     */
+    QString name() const;
+
+    /**
+     * @brief Request a repaint of part of the output
+     * @param damage The damaged region in output coordinates; empty repaints the whole output
+     */
+    void scheduleRepaint(const QRegion &damage = QRegion());
+
+    /**
+     * @brief Get the damage accumulated for the next frame
+     * @return The pending damage region
+     */
+    QRegion pendingDamage() const;
+
+    /**
+     * @brief Let a fullscreen surface drive the refresh of this output
+     * @param surface The fullscreen surface, or nullptr to return to the normal cadence
+     */
+    void setFullscreenSurface(QWaylandSurface *surface);
+
+    /**
+     * @brief Get the surface currently driving the refresh
+     * @return The fullscreen surface, or nullptr if none
+     */
+    QWaylandSurface *fullscreenSurface() const;
+
+private slots:
+    void startFrame();
+    void handleFrameSwapped();
+
+private:
+    void armTimer();
+    void finishFrame();
+
+    QWaylandOutput *m_output;
+    QString m_name;
+    std::string m_schedulerName;
+    WaylandCompositor *m_compositor;
+    Rendering::FrameScheduler *m_scheduler;
+
+    // Fires when composition of the next frame should start
+    QTimer m_timer;
+
+    // Damage collected since the last frame
+    QRegion m_damage;
+
+    // Whether a frame has been started but not yet presented
+    bool m_frameInFlight;
+
+    // Frames presented, as the output window reports no vblank sequence
+    quint64 m_sequence;
+
+    QPointer<QWaylandSurface> m_fullscreenSurface;
+    QMetaObject::Connection m_fullscreenConnection;
+    QMetaObject::Connection m_fullscreenDestroyedConnection;
+};
+
+} // namespace VivoX::Compositor
@@ -1,22 +1,208 @@
 #include "WaylandCompositor.h"
 #include "WaylandProtocols.h"
+#include "OutputManager.h"
+#include "OutputRenderLoop.h"
 #include "../rendering/RenderEngine.h"
+#include "../rendering/FrameScheduler.h"
+#include "../rendering/GeometryAnimator.h"
+#include "../rendering/BufferResidency.h"
+#include "../rendering/ClientAccounting.h"
+#include "../rendering/RenderTexture.h"
+#include "../rendering/ThumbnailAtlas.h"
+#include "../rendering/WorkspaceSnapshots.h"
+#include "../protocols/LinuxDmabufProtocol.h"
+#include "../protocols/PresentationTimeProtocol.h"
 
 #include <QDebug>
+#include <QImage>
+#include <QScreen>
+#include <QTimer>
+#include <QVarLengthArray>
+#include <QWindow>
+#include <QWaylandBufferRef>
+#include <QWaylandClient>
 #include <QWaylandQuickOutput>
 #include <QWaylandQuickCompositor>
+#include <QWaylandResource>
+#include <QWaylandView>
+
+#include <cstring>
+#include <wayland-server.h>
 
 namespace VivoX::Compositor {
 
+namespace {
+// Thumbnail passes are at least a frame apart (16 ms)
+const qint64 thumbnailFrameInterval = 16000000;
+
+// Snapshot passes are at least a frame apart as well (16 ms)
+const qint64 snapshotFrameInterval = 16000000;
+
+// Clients on inactive workspaces get a frame callback once a second
+const int backgroundFrameInterval = 1000;
+
+// Clients with nothing new to draw after a workspace switch are not waited for longer (250 ms)
+const int catchUpTimeout = 250;
+
+// Release passes are at least this far apart, as they may wait for thumbnails (100 ms)
+const qint64 residencyPassInterval = 100000000;
+
+// Clients are measured once a second
+const int accountingInterval = 1000;
+
+quint64 thumbnailId(QWaylandSurface *surface)
+{
+    return reinterpret_cast<quintptr>(surface);
+}
+
+quintptr occlusionKey(QWaylandSurface *surface)
+{
+    return reinterpret_cast<quintptr>(surface);
+}
+
+quint64 residencyId(QWaylandSurface *surface)
+{
+    return reinterpret_cast<quintptr>(surface);
+}
+
+quint64 animationId(QWaylandSurface *surface)
+{
+    return reinterpret_cast<quintptr>(surface);
+}
+
+Rendering::GeometryAnimator::Rect animationRect(const QRect &rect)
+{
+    Rendering::GeometryAnimator::Rect result;
+    result.x = rect.x();
+    result.y = rect.y();
+    result.width = rect.width();
+    result.height = rect.height();
+    return result;
+}
+
+QRectF animationRect(const Rendering::GeometryAnimator::Rect &rect)
+{
+    return QRectF(rect.x, rect.y, rect.width, rect.height);
+}
+
+quint64 accountingId(wl_client *client)
+{
+    return reinterpret_cast<quintptr>(client);
+}
+
+// Byte order of the image formats shared memory buffers come in, on a little endian host
+Rendering::ShmUpload::Format shmFormat(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return Rendering::ShmUpload::Format::BGRA;
+    case QImage::Format_RGB32:
+        return Rendering::ShmUpload::Format::BGRX;
+    case QImage::Format_RGBA8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return Rendering::ShmUpload::Format::RGBA;
+    case QImage::Format_RGBX8888:
+        return Rendering::ShmUpload::Format::RGBX;
+    case QImage::Format_RGB888:
+        return Rendering::ShmUpload::Format::RGB;
+    default:
+        return Rendering::ShmUpload::Format::Invalid;
+    }
+}
+
+// Objects of one client, counted by walking its resources
+struct ClientObjects {
+    const VivoX::Wayland::LinuxDmabufProtocol *linuxDmabuf = nullptr;
+    quint64 surfaces = 0;
+    quint64 buffers = 0;
+    quint64 dmabufImports = 0;
+    quint64 shmBytes = 0;
+    quint64 objects = 0;
+};
+
+wl_iterator_result countClientObject(wl_resource *resource, void *data)
+{
+    ClientObjects *objects = static_cast<ClientObjects *>(data);
+    objects->objects++;
+    
+    const char *name = wl_resource_get_class(resource);
+    if (std::strcmp(name, "wl_surface") == 0) {
+        objects->surfaces++;
+    } else if (std::strcmp(name, "wl_buffer") == 0) {
+        objects->buffers++;
+        
+        // Other buffers, such as wl_drm ones, only count as buffers
+        if (wl_shm_buffer *shmBuffer = wl_shm_buffer_get(resource)) {
+            objects->shmBytes += static_cast<quint64>(wl_shm_buffer_get_stride(shmBuffer))
+                * static_cast<quint64>(wl_shm_buffer_get_height(shmBuffer));
+        } else if (objects->linuxDmabuf && objects->linuxDmabuf->getBuffer(QWaylandResource(resource))) {
+            objects->dmabufImports++;
+        }
+    }
+    return WL_ITERATOR_CONTINUE;
+}
+} // namespace
+
+struct WaylandCompositor::DisplayListener {
+    wl_listener clientCreated;
+    WaylandCompositor *compositor;
+};
+
+struct WaylandCompositor::ClientListener {
+    wl_listener resourceCreated;
+    wl_listener destroyed;
+    WaylandCompositor *compositor;
+    wl_client *client;
+};
+
 WaylandCompositor::WaylandCompositor(QObject *parent)
     : QObject(parent)
     , m_compositor(nullptr)
     , m_seat(nullptr)
     , m_xdgShell(nullptr)
     , m_protocols(nullptr)
+    , m_presentationTime(nullptr)
+    , m_linuxDmabuf(nullptr)
     , m_renderEngine(nullptr)
     , m_primaryOutput(nullptr)
+    , m_thumbnails(new Rendering::ThumbnailAtlas())
+    , m_thumbnailUsers(0)
+    , m_thumbnailTimer(new QTimer(this))
+    , m_lastThumbnailPass(0)
+    , m_nextWorkspaceKey(1)
+    , m_snapshots(new Rendering::WorkspaceSnapshots())
+    , m_catchUpTimer(new QTimer(this))
+    , m_snapshotTimer(new QTimer(this))
+    , m_lastSnapshotPass(0)
+    , m_backgroundFrameTimer(new QTimer(this))
+    , m_residency(new Rendering::BufferResidency())
+    , m_residencyTimer(new QTimer(this))
+    , m_lastResidencyPass(0)
+    , m_animator(new Rendering::GeometryAnimator())
+    , m_animationsEnabled(false)
+    , m_clientAccounting(new Rendering::ClientAccounting())
+    , m_accountingTimer(new QTimer(this))
 {
+    m_thumbnailTimer->setSingleShot(true);
+    connect(m_thumbnailTimer, &QTimer::timeout, this, &WaylandCompositor::updateThumbnails);
+    
+    m_catchUpTimer->setSingleShot(true);
+    m_catchUpTimer->setInterval(catchUpTimeout);
+    connect(m_catchUpTimer, &QTimer::timeout, this, &WaylandCompositor::catchUpTimedOut);
+    
+    m_snapshotTimer->setSingleShot(true);
+    connect(m_snapshotTimer, &QTimer::timeout, this, &WaylandCompositor::updateWorkspaceSnapshots);
+    
+    m_backgroundFrameTimer->setInterval(backgroundFrameInterval);
+    connect(m_backgroundFrameTimer, &QTimer::timeout, this, &WaylandCompositor::sendBackgroundFrameCallbacks);
+    
+    m_residencyTimer->setSingleShot(true);
+    connect(m_residencyTimer, &QTimer::timeout, this, &WaylandCompositor::releaseHiddenBuffers);
+    
+    m_accountingTimer->setInterval(accountingInterval);
+    connect(m_accountingTimer, &QTimer::timeout, this, &WaylandCompositor::accountClients);
+    
     qDebug() << "WaylandCompositor created";
 }
 
@@ -24,6 +210,21 @@ WaylandCompositor::~WaylandCompositor()
 {
     qDebug() << "WaylandCompositor destroyed";
     closeAllSurfaces();
+    
+    // The display outlives this object, so it must no longer call back into it
+    for (ClientListener *listener : m_clientListeners) {
+        wl_list_remove(&listener->resourceCreated.link);
+        wl_list_remove(&listener->destroyed.link);
+        delete listener;
+    }
+    m_clientListeners.clear();
+    if (m_displayListener) {
+        wl_list_remove(&m_displayListener->clientCreated.link);
+    }
+    
+    if (m_renderEngine) {
+        Wayland::OutputManager::getInstance()->setFrameScheduler(nullptr);
+    }
 }
 
 bool WaylandCompositor::initialize(RenderEngine *renderEngine, const QString &socketName)
@@ -34,6 +235,9 @@ bool WaylandCompositor::initialize(RenderEngine *renderEngine, const QString &so
     }
 
     m_renderEngine = renderEngine;
+    
+    // Output configuration (modes, adaptive sync) feeds the per-output scheduling
+    Wayland::OutputManager::getInstance()->setFrameScheduler(&m_renderEngine->getFrameScheduler());
 
     // Create the Wayland compositor
     m_compositor = new QWaylandQuickCompositor(this);
@@ -58,12 +262,26 @@ bool WaylandCompositor::initialize(RenderEngine *renderEngine, const QString &so
         return false;
     }
     
+    // Clients learn when their frames reached the screen from the render loops
+    m_presentationTime = new VivoX::Wayland::PresentationTimeProtocol(m_compositor, this);
+    
+    // Client accounting asks it which buffers are dmabufs
+    m_linuxDmabuf = new VivoX::Wayland::LinuxDmabufProtocol(m_compositor, this);
+    m_linuxDmabuf->initialize();
+    
     // Connect signals
     connectSignals();
     
     // Create the compositor
     m_compositor->create();
     
+    // Account the resources of every client that connects
+    m_displayListener.reset(new DisplayListener);
+    m_displayListener->compositor = this;
+    m_displayListener->clientCreated.notify = &WaylandCompositor::handleClientCreated;
+    wl_display_add_client_created_listener(m_compositor->display(), &m_displayListener->clientCreated);
+    m_accountingTimer->start();
+    
     qDebug() << "WaylandCompositor initialized with socket name:" << socketName;
     
     return true;
@@ -111,6 +329,15 @@ void WaylandCompositor::addOutput(QWaylandOutput *output)
     // Set up the output
     output->setCompositor(m_compositor);
     
+    // Give the output its own render loop at its own refresh rate
+    if (m_renderEngine) {
+        const QString name = outputName(output);
+        Rendering::FrameScheduler &scheduler = m_renderEngine->getFrameScheduler();
+        scheduler.addOutput(name.toStdString(), output->currentMode().refreshRate());
+        
+        m_renderLoops.insert(output, new OutputRenderLoop(output, name, this, &scheduler, this));
+    }
+    
     // If this is the first output, set it as primary
     if (m_outputs.size() == 1 && !m_primaryOutput) {
         setPrimaryOutput(output);
@@ -148,6 +375,14 @@ void WaylandCompositor::removeOutput(QWaylandOutput *output)
     
     m_outputs.removeOne(output);
     
+    m_occlusion.remove(output);
+    
+    // Stop rendering the output
+    if (OutputRenderLoop *loop = m_renderLoops.take(output)) {
+        m_renderEngine->getFrameScheduler().removeOutput(loop->name().toStdString());
+        delete loop;
+    }
+    
     qDebug() << "Removed output from WaylandCompositor";
 }
 
@@ -165,6 +400,11 @@ void WaylandCompositor::setPrimaryOutput(QWaylandOutput *output)
     
     if (m_primaryOutput != output) {
         m_primaryOutput = output;
+        
+        // Workspaces are laid out on the primary output
+        m_snapshots->setSize(output->geometry().width(), output->geometry().height());
+        armSnapshotTimer();
+        
         emit primaryOutputChanged(m_primaryOutput);
         qDebug() << "Set primary output:" << output->manufacturer() << output->model();
     }
@@ -215,190 +455,1357 @@ QWaylandOutput *WaylandCompositor::outputForSurface(QWaylandSurface *surface) co
     return bestOutput ? bestOutput : m_primaryOutput;
 }
 
-RenderEngine *WaylandCompositor::renderEngine() const
+bool WaylandCompositor::isSurfaceVisibleOnOutput(QWaylandSurface *surface, QWaylandOutput *output) const
 {
-    return m_renderEngine;
+    if (!surface || !output || !surface->hasContent()) {
+        return false;
+    }
+    
+    QPoint surfacePos = surface->client()->positionForOutput(surface, m_primaryOutput);
+    QRect surfaceGeometry(surfacePos, surface->size());
+    
+    return output->geometry().intersects(surfaceGeometry);
 }
 
-void WaylandCompositor::setKeyboardFocus(QWaylandSurface *surface)
+void WaylandCompositor::raiseSurface(QWaylandSurface *surface)
 {
-    if (!m_seat) {
-        qWarning() << "Cannot set keyboard focus: no seat available";
+    if (!surface || !m_surfaces.removeOne(surface)) {
         return;
     }
     
-    QWaylandSurface *oldFocus = m_seat->keyboardFocus();
-    if (oldFocus != surface) {
-        m_seat->setKeyboardFocus(surface);
-        emit keyboardFocusChanged(surface);
-    }
+    m_surfaces.append(surface);
+    damageSurface(surface, true);
+    damageWorkspace(surface);
 }
 
-QWaylandSurface *WaylandCompositor::keyboardFocus() const
+void WaylandCompositor::lowerSurface(QWaylandSurface *surface)
 {
-    return m_seat ? m_seat->keyboardFocus() : nullptr;
+    if (!surface || !m_surfaces.removeOne(surface)) {
+        return;
+    }
+    
+    m_surfaces.prepend(surface);
+    damageSurface(surface, true);
+    damageWorkspace(surface);
 }
 
-void WaylandCompositor::sendKeyEvent(bool pressed, int keyCode, int modifiers)
+void WaylandCompositor::updateOcclusion(QWaylandOutput *output)
 {
-    if (!m_seat || !m_seat->keyboard()) {
-        qWarning() << "Cannot send key event: no keyboard available";
+    if (!output) {
         return;
     }
     
-    QWaylandSurface *focus = m_seat->keyboardFocus();
-    if (!focus) {
-        qWarning() << "Cannot send key event: no surface has keyboard focus";
-        return;
+    OcclusionCuller &culler = m_occlusion[output];
+    const QVector<quintptr> changed = culler.update(output->geometry(), stackingFrontToBack());
+    
+    for (quintptr key : changed) {
+        emit surfaceOcclusionChanged(output, reinterpret_cast<QWaylandSurface *>(key), culler.isOccluded(key));
+    }
+}
+
+QVector<OcclusionCuller::Surface> WaylandCompositor::stackingFrontToBack() const
+{
+    QVector<OcclusionCuller::Surface> frontToBack;
+    frontToBack.reserve(m_surfaces.size());
+    
+    for (auto it = m_surfaces.crbegin(); it != m_surfaces.crend(); ++it) {
+        QWaylandSurface *surface = *it;
+        if (!surface->hasContent() || isSurfaceHidden(surface)) {
+            continue;
+        }
+        
+        OcclusionCuller::Surface entry;
+        entry.key = occlusionKey(surface);
+        entry.geometry = QRect(surface->client()->positionForOutput(surface, m_primaryOutput), surface->size());
+        
+        // Qt only tells whether the opaque region covers the whole surface; animating ones are drawn elsewhere
+        if (surface->isOpaque() && !m_animator->isAnimating(animationId(surface))) {
+            entry.opaqueRegion = QRegion(QRect(QPoint(0, 0), surface->size()));
+        }
+        
+        frontToBack.append(entry);
     }
     
-    if (pressed) {
-        m_seat->keyboard()->sendKeyPressEvent(keyCode);
-    } else {
-        m_seat->keyboard()->sendKeyReleaseEvent(keyCode);
+    return frontToBack;
+}
+
+QWaylandSurface *WaylandCompositor::surfaceAt(const QPointF &pos, QPointF *localPos) const
+{
+    // Before the output's first frame nothing is culled yet
+    static const OcclusionCuller unculled;
+    const auto it = m_occlusion.constFind(outputAt(pos.toPoint()));
+    const OcclusionCuller &culler = it != m_occlusion.constEnd() ? *it : unculled;
+    
+    const quintptr key = culler.surfaceAt(pos, stackingFrontToBack());
+    if (!key) {
+        return nullptr;
     }
     
-    emit keyEvent(focus, pressed, keyCode, modifiers);
+    QWaylandSurface *surface = reinterpret_cast<QWaylandSurface *>(key);
+    *localPos = pos - surface->client()->positionForOutput(surface, m_primaryOutput);
+    return surface;
 }
 
-void WaylandCompositor::sendPointerEvent(const QPointF &pos, bool pressed, int button, int modifiers)
+bool WaylandCompositor::isSurfaceOccluded(QWaylandSurface *surface, QWaylandOutput *output) const
 {
-    if (!m_seat || !m_seat->pointer()) {
-        qWarning() << "Cannot send pointer event: no pointer available";
+    const auto it = m_occlusion.constFind(output);
+    return it != m_occlusion.constEnd() && it->isOccluded(occlusionKey(surface));
+}
+
+int WaylandCompositor::culledSurfaces(QWaylandOutput *output) const
+{
+    const auto it = m_occlusion.constFind(output);
+    return it != m_occlusion.constEnd() ? it->culledCount() : 0;
+}
+
+void WaylandCompositor::sendFrameCallbacks(QWaylandOutput *output)
+{
+    if (!output) {
         return;
     }
     
-    // Find the surface at the position
-    QWaylandSurface *targetSurface = nullptr;
-    QPointF localPos;
+    // The focused surface is never throttled, even if the stacking order hasn't caught up with it yet
+    QWaylandSurface *focus = keyboardFocus();
     
     for (QWaylandSurface *surface : m_surfaces) {
-        QPoint surfacePos = surface->client()->positionForOutput(surface, m_primaryOutput);
-        QRectF surfaceGeometry(surfacePos, surface->size());
-        
-        if (surfaceGeometry.contains(pos)) {
-            targetSurface = surface;
-            localPos = pos - surfacePos;
-            break;
+        // Covered clients wait for their callback until they are uncovered, background ones are paced separately
+        if (!isSurfaceHidden(surface) && isSurfaceVisibleOnOutput(surface, output)
+            && (surface == focus || !isSurfaceOccluded(surface, output))) {
+            surface->sendFrameCallbacks();
         }
     }
-    
-    if (!targetSurface) {
+}
+
+void WaylandCompositor::sendPresentationFeedback(QWaylandOutput *output, qint64 time, quint64 sequence, qint64 refresh)
+{
+    if (!output || !m_presentationTime) {
         return;
     }
     
-    // Set pointer focus
-    m_seat->pointer()->setFocus(targetSurface, localPos);
-    
-    // Send button event if needed
-    if (pressed) {
-        m_seat->pointer()->sendButtonPressEvent(button);
-    } else {
-        m_seat->pointer()->sendButtonReleaseEvent(button);
+    for (QWaylandSurface *surface : m_surfaces) {
+        if (isSurfaceHidden(surface) || !isSurfaceVisibleOnOutput(surface, output)) {
+            continue;
+        }
+        
+        if (isSurfaceOccluded(surface, output)) {
+            m_presentationTime->discardSurface(surface);
+        } else {
+            m_presentationTime->presentSurface(surface, sequence, static_cast<uint64_t>(time), static_cast<uint32_t>(refresh));
+        }
     }
-    
-    emit pointerEvent(targetSurface, localPos, pressed, button, modifiers);
 }
 
-void WaylandCompositor::sendTouchEvent(const QPointF &pos, int id, int state)
+OutputRenderLoop *WaylandCompositor::renderLoop(QWaylandOutput *output) const
 {
-    if (!m_seat || !m_seat->touch()) {
-        qWarning() << "Cannot send touch event: no touch device available";
+    return m_renderLoops.value(output, nullptr);
+}
+
+void WaylandCompositor::scheduleRepaint(QWaylandSurface *surface)
+{
+    damageSurface(surface, false);
+}
+
+void WaylandCompositor::scheduleRepaint(const QRect &rect)
+{
+    damageRect(rect);
+}
+
+void WaylandCompositor::damageSurface(QWaylandSurface *surface, bool wholeSurface)
+{
+    // Hidden surfaces are not composited
+    if (!surface || isSurfaceHidden(surface)) {
         return;
     }
     
-    // Find the surface at the position
-    QWaylandSurface *targetSurface = nullptr;
-    QPointF localPos;
+    QPoint surfacePos = surface->client()->positionForOutput(surface, m_primaryOutput);
+    QRect surfaceGeometry(surfacePos, surface->size());
+    const quintptr key = occlusionKey(surface);
     
-    for (QWaylandSurface *surface : m_surfaces) {
-        QPoint surfacePos = surface->client()->positionForOutput(surface, m_primaryOutput);
-        QRectF surfaceGeometry(surfacePos, surface->size());
+    // Only outputs showing the surface need a new frame
+    for (auto it = m_renderLoops.cbegin(); it != m_renderLoops.cend(); ++it) {
+        QRect outputGeometry = it.key()->geometry();
+        QRegion damage = outputGeometry.intersected(surfaceGeometry);
         
-        if (surfaceGeometry.contains(pos)) {
-            targetSurface = surface;
-            localPos = pos - surfacePos;
-            break;
+        // Unless it moved or resized, only the visible part of the surface changes the output
+        const auto culler = m_occlusion.constFind(it.key());
+        if (!wholeSurface && culler != m_occlusion.constEnd() && culler->geometry(key) == surfaceGeometry) {
+            damage = culler->visibleRegion(key);
+        }
+        
+        if (!damage.isEmpty()) {
+            it.value()->scheduleRepaint(damage.translated(-outputGeometry.topLeft()));
         }
     }
-    
-    if (!targetSurface) {
+}
+
+void WaylandCompositor::setFullscreenSurface(QWaylandOutput *output, QWaylandSurface *surface)
+{
+    OutputRenderLoop *loop = renderLoop(output);
+    if (!loop) {
+        qWarning() << "Cannot set fullscreen surface on unknown output";
         return;
     }
     
-    // Send touch event
-    switch (state) {
-        case 0: // pressed
-            m_seat->touch()->sendTouchPointPressed(id, localPos);
-            break;
-        case 1: // moved
-            m_seat->touch()->sendTouchPointMoved(id, localPos);
-            break;
-        case 2: // released
-            m_seat->touch()->sendTouchPointReleased(id, localPos);
-            break;
+    loop->setFullscreenSurface(surface);
+}
+
+QWaylandSurface *WaylandCompositor::fullscreenSurface(QWaylandOutput *output) const
+{
+    OutputRenderLoop *loop = renderLoop(output);
+    return loop ? loop->fullscreenSurface() : nullptr;
+}
+
+QString WaylandCompositor::outputName(QWaylandOutput *output)
+{
+    if (!output) {
+        return QString();
     }
     
-    emit touchEvent(targetSurface, localPos, id, state);
+    // The screen name is the connector name (e.g. "HDMI-1"), matching the OutputManager
+    if (output->window() && output->window()->screen()) {
+        return output->window()->screen()->name();
+    }
+    
+    return output->model();
 }
 
-void WaylandCompositor::closeAllSurfaces()
+RenderEngine *WaylandCompositor::renderEngine() const
+{
+    return m_renderEngine;
+}
+
+void WaylandCompositor::acquireThumbnails()
 {
+    if (m_thumbnailUsers++ > 0) {
+        return;
+    }
+    
+    // Released surfaces keep the thumbnail they had
     for (QWaylandSurface *surface : m_surfaces) {
-        surface->client()->close();
+        if (m_thumbnails->hasWindow(thumbnailId(surface)) && isSurfaceResident(surface)) {
+            m_thumbnailViews.insert(surface, createBufferView(surface));
+        }
     }
     
-    m_surfaces.clear();
+    armThumbnailTimer();
 }
 
-QVector<QWaylandSurface *> WaylandCompositor::surfaces() const
+void WaylandCompositor::releaseThumbnails()
 {
-    return m_surfaces;
+    if (m_thumbnailUsers == 0 || --m_thumbnailUsers > 0) {
+        return;
+    }
+    
+    // Don't keep client buffers alive for thumbnails nobody shows
+    qDeleteAll(m_thumbnailViews);
+    m_thumbnailViews.clear();
+    m_thumbnailTimer->stop();
 }
 
-void WaylandCompositor::connectSignals()
+bool WaylandCompositor::thumbnailsActive() const
 {
-    // Connect signals from the compositor
-    connect(m_compositor, &QWaylandCompositor::surfaceCreated,
-            this, &WaylandCompositor::handleSurfaceCreated);
-    connect(m_compositor, &QWaylandCompositor::surfaceAboutToBeDestroyed,
-            this, &WaylandCompositor::handleSurfaceDestroyed);
+    return m_thumbnailUsers > 0;
+}
+
+void WaylandCompositor::setSurfaceWorkspace(QWaylandSurface *surface, const QString &workspace)
+{
+    if (!surface || m_surfaceWorkspaces.value(surface) == workspace) {
+        return;
+    }
     
-    // Connect signals from the XDG shell
-    connect(m_xdgShell, &QWaylandXdgShell::toplevelCreated,
-            this, &WaylandCompositor::handleXdgToplevelCreated);
-    connect(m_xdgShell, &QWaylandXdgShell::popupCreated,
-            this, &WaylandCompositor::handleXdgPopupCreated);
+    // Repaint where the surface was before it leaves, and where it shows up after
+    damageSurface(surface, true);
+    damageWorkspace(surface);
+    
+    if (workspace.isEmpty()) {
+        m_surfaceWorkspaces.remove(surface);
+    } else {
+        workspaceKey(workspace);
+        m_surfaceWorkspaces.insert(surface, workspace);
+    }
+    
+    updateResidency(surface);
+    
+    damageSurface(surface, true);
+    damageWorkspace(surface);
+    updateBackgroundFrameTimer();
 }
 
-void WaylandCompositor::handleXdgToplevelCreated(QWaylandXdgToplevel *toplevel, QWaylandXdgSurface *xdgSurface)
+QString WaylandCompositor::surfaceWorkspace(QWaylandSurface *surface) const
 {
-    emit xdgToplevelCreated(toplevel, xdgSurface->surface());
+    return m_surfaceWorkspaces.value(surface);
 }
 
-void WaylandCompositor::handleXdgPopupCreated(QWaylandXdgPopup *popup, QWaylandXdgSurface *xdgSurface)
+bool WaylandCompositor::isSurfaceOnActiveWorkspace(QWaylandSurface *surface) const
 {
-    emit xdgPopupCreated(popup, xdgSurface->surface());
+    const auto it = m_surfaceWorkspaces.constFind(surface);
+    return it == m_surfaceWorkspaces.constEnd() || *it == m_activeWorkspace;
 }
 
-void WaylandCompositor::handleSurfaceCreated(QWaylandSurface *surface)
+void WaylandCompositor::setActiveWorkspace(const QString &workspace)
 {
-    if (!surface) {
+    if (workspace == m_activeWorkspace) {
         return;
     }
     
-    m_surfaces.append(surface);
-    emit surfaceCreated(surface);
+    const QString previous = m_activeWorkspace;
+    m_activeWorkspace = workspace;
+    m_snapshots->setActiveWorkspace(workspaceKey(workspace));
+    
+    // Released surfaces of the new workspace are imported again first
+    for (auto it = m_surfaceWorkspaces.cbegin(); it != m_surfaceWorkspaces.cend(); ++it) {
+        if (*it == previous || *it == workspace) {
+            updateResidency(it.key());
+        }
+    }
+    
+    // Wake the clients of the new workspace up now rather than with the next frame
+    m_catchingUp.clear();
+    m_catchUpTimer->stop();
+    for (QWaylandSurface *surface : m_surfaces) {
+        if (m_surfaceWorkspaces.value(surface) == workspace && surface->hasContent()) {
+            m_catchingUp.insert(surface);
+            surface->sendFrameCallbacks();
+        }
+    }
+    
+    for (OutputRenderLoop *loop : m_renderLoops) {
+        loop->scheduleRepaint();
+    }
+    
+    updateBackgroundFrameTimer();
+    armSnapshotTimer();
+    
+    emit activeWorkspaceChanged(previous, workspace);
+    if (m_catchingUp.isEmpty()) {
+        emit workspaceCaughtUp(workspace);
+        return;
+    }
+    
+    // Idle clients keep showing their last buffer and may never commit
+    m_catchUpTimer->start();
 }
 
-void WaylandCompositor::handleSurfaceDestroyed(QWaylandSurface *surface)
+QString WaylandCompositor::activeWorkspace() const
 {
-    if (!surface) {
+    return m_activeWorkspace;
+}
+
+void WaylandCompositor::removeWorkspace(const QString &workspace)
+{
+    const auto it = m_workspaceKeys.constFind(workspace);
+    if (it == m_workspaceKeys.constEnd()) {
         return;
     }
     
+    m_snapshots->removeWorkspace(*it);
+    if (m_renderEngine) {
+        m_renderEngine->releaseWorkspaceSnapshot(*it);
+    }
+    m_workspaceKeys.erase(it);
+}
+
+uint WaylandCompositor::workspaceSnapshotTexture(const QString &workspace) const
+{
+    const quint64 key = m_workspaceKeys.value(workspace);
+    if (!m_renderEngine || !m_snapshots->isReady(key)) {
+        return 0;
+    }
+    
+    return m_renderEngine->getWorkspaceSnapshotTextureId(key);
+}
+
+void WaylandCompositor::setSurfaceHidden(QWaylandSurface *surface, bool hidden)
+{
+    if (!surface || m_hiddenSurfaces.contains(surface) == hidden) {
+        return;
+    }
+    
+    // Repaint where the surface was before it goes
+    damageSurface(surface, true);
+    
+    if (hidden) {
+        m_hiddenSurfaces.insert(surface);
+    } else {
+        m_hiddenSurfaces.remove(surface);
+    }
+    
+    updateResidency(surface);
+    damageSurface(surface, true);
+    updateBackgroundFrameTimer();
+}
+
+bool WaylandCompositor::isSurfaceHidden(QWaylandSurface *surface) const
+{
+    return m_hiddenSurfaces.contains(surface) || !isSurfaceOnActiveWorkspace(surface);
+}
+
+bool WaylandCompositor::isSurfaceResident(QWaylandSurface *surface) const
+{
+    return m_residency->isResident(residencyId(surface));
+}
+
+void WaylandCompositor::requestSurfaceBuffers(QWaylandSurface *surface)
+{
+    if (!surface) {
+        return;
+    }
+    
+    if (m_residency->reimport(residencyId(surface), Rendering::FrameScheduler::now())) {
+        restoreSurfaceBuffers(surface);
+    }
+    armResidencyTimer();
+}
+
+void WaylandCompositor::setBufferBudget(quint64 bytes)
+{
+    m_residency->setBudget(bytes);
+    armResidencyTimer();
+}
+
+void WaylandCompositor::setBufferGracePeriod(int msec)
+{
+    m_residency->setGracePeriod(static_cast<qint64>(qMax(0, msec)) * 1000000);
+    armResidencyTimer();
+}
+
+Rendering::BufferResidency::Stats WaylandCompositor::bufferResidencyStats() const
+{
+    return m_residency->getStats();
+}
+
+void WaylandCompositor::setSurfaceAnimationsEnabled(bool enabled)
+{
+    if (m_animationsEnabled == enabled) {
+        return;
+    }
+    
+    m_animationsEnabled = enabled;
+    if (enabled) {
+        return;
+    }
+    
+    // Running animations end where they were headed
+    for (QWaylandSurface *surface : m_surfaces) {
+        cancelSurfaceAnimation(surface);
+    }
+}
+
+bool WaylandCompositor::surfaceAnimationsEnabled() const
+{
+    return m_animationsEnabled;
+}
+
+void WaylandCompositor::animateSurfaceGeometry(QWaylandSurface *surface, const QRect &from, const QRect &to)
+{
+    if (!m_animationsEnabled || !surface || !m_surfaces.contains(surface)) {
+        return;
+    }
+    
+    const quint64 id = animationId(surface);
+    const bool wasAnimating = m_animator->isAnimating(id);
+    const bool keepBuffer = m_animator->animate(id, animationRect(from), animationRect(to),
+                                                Rendering::FrameScheduler::now());
+    if (!m_animator->isAnimating(id)) {
+        return;
+    }
+    
+    if (!wasAnimating || keepBuffer) {
+        emit surfaceAnimationStarted(surface, keepBuffer);
+    }
+    
+    // The first frame starts the output's animation cadence
+    damageRect(from.united(to));
+}
+
+void WaylandCompositor::cancelSurfaceAnimation(QWaylandSurface *surface)
+{
+    const quint64 id = animationId(surface);
+    if (!m_animator->isAnimating(id)) {
+        return;
+    }
+    
+    const QRect shown = surfaceAnimatedGeometry(surface).toAlignedRect();
+    m_animator->cancel(id);
+    
+    damageRect(shown);
+    damageSurface(surface, true);
+    emit surfaceAnimationFinished(surface);
+}
+
+bool WaylandCompositor::isSurfaceAnimating(QWaylandSurface *surface) const
+{
+    return m_animator->isAnimating(animationId(surface));
+}
+
+QRectF WaylandCompositor::surfaceAnimatedGeometry(QWaylandSurface *surface) const
+{
+    const Rendering::GeometryAnimator::Transform *transform = m_animator->getTransform(animationId(surface));
+    return transform ? animationRect(transform->rect) : QRectF();
+}
+
+qreal WaylandCompositor::surfaceCrossfade(QWaylandSurface *surface) const
+{
+    const Rendering::GeometryAnimator::Transform *transform = m_animator->getTransform(animationId(surface));
+    return transform ? transform->crossfade : 1.0;
+}
+
+void WaylandCompositor::updateAnimations()
+{
+    const std::vector<Rendering::GeometryAnimator::Transform> &transforms = m_animator->getTransforms();
+    if (transforms.empty()) {
+        return;
+    }
+    
+    // Where the surfaces were drawn in the last frame needs repainting too
+    QRect previous;
+    for (const Rendering::GeometryAnimator::Transform &transform : transforms) {
+        previous |= animationRect(transform.rect).toAlignedRect();
+    }
+    
+    m_animator->update(Rendering::FrameScheduler::now());
+    
+    QRect current;
+    for (const Rendering::GeometryAnimator::Transform &transform : transforms) {
+        current |= animationRect(transform.rect).toAlignedRect();
+    }
+    damageRect(previous | current);
+    
+    // Slots may start new animations, so the transforms aren't walked while emitting
+    QVarLengthArray<QWaylandSurface *, 16> finished;
+    for (const Rendering::GeometryAnimator::Transform &transform : transforms) {
+        if (transform.finished) {
+            finished.append(reinterpret_cast<QWaylandSurface *>(static_cast<quintptr>(transform.window)));
+        }
+    }
+    
+    emit surfaceAnimationsUpdated();
+    for (QWaylandSurface *surface : finished) {
+        emit surfaceAnimationFinished(surface);
+    }
+}
+
+Rendering::GeometryAnimator::Stats WaylandCompositor::animationStats() const
+{
+    return m_animator->getStats();
+}
+
+void WaylandCompositor::setClientLimit(Rendering::ClientAccounting::Resource resource, quint64 soft, quint64 hard)
+{
+    m_clientAccounting->setLimit(resource, soft, hard);
+}
+
+void WaylandCompositor::setClientGracePeriod(int msec)
+{
+    m_clientAccounting->setGracePeriod(static_cast<qint64>(qMax(0, msec)) * 1000000);
+}
+
+Rendering::ClientAccounting::Usage WaylandCompositor::clientUsage(QWaylandClient *client) const
+{
+    Rendering::ClientAccounting::Usage usage;
+    if (!client) {
+        return usage;
+    }
+    
+    const quint64 id = accountingId(client->client());
+    usage.client = id;
+    usage.pid = static_cast<int>(client->processId());
+    for (int resource = 0; resource < Rendering::ClientAccounting::ResourceCount; ++resource) {
+        usage.values[resource] = m_clientAccounting->usage(id, static_cast<Rendering::ClientAccounting::Resource>(resource));
+    }
+    usage.level = m_clientAccounting->level(id);
+    return usage;
+}
+
+QVariantList WaylandCompositor::topClients(int count, const QString &resource) const
+{
+    using Rendering::ClientAccounting;
+    
+    ClientAccounting::Resource by = ClientAccounting::ResourceCount;
+    for (int candidate = 0; candidate < ClientAccounting::ResourceCount; ++candidate) {
+        if (resource == QLatin1String(ClientAccounting::resourceName(static_cast<ClientAccounting::Resource>(candidate)))) {
+            by = static_cast<ClientAccounting::Resource>(candidate);
+        }
+    }
+    
+    QVariantList clients;
+    for (const ClientAccounting::Usage &usage : m_clientAccounting->topClients(static_cast<size_t>(qMax(0, count)), by)) {
+        QVariantMap client;
+        client.insert(QStringLiteral("pid"), usage.pid);
+        client.insert(QStringLiteral("level"), static_cast<int>(usage.level));
+        client.insert(QStringLiteral("requests"), static_cast<quint64>(usage.requests));
+        for (int index = 0; index < ClientAccounting::ResourceCount; ++index) {
+            client.insert(QLatin1String(ClientAccounting::resourceName(static_cast<ClientAccounting::Resource>(index))),
+                          static_cast<quint64>(usage.values[index]));
+        }
+        clients.append(client);
+    }
+    return clients;
+}
+
+Rendering::ClientAccounting::Stats WaylandCompositor::clientAccountingStats() const
+{
+    return m_clientAccounting->getStats();
+}
+
+void WaylandCompositor::damageRect(const QRect &rect)
+{
+    for (auto it = m_renderLoops.cbegin(); it != m_renderLoops.cend(); ++it) {
+        const QRect outputGeometry = it.key()->geometry();
+        const QRect damage = outputGeometry.intersected(rect);
+        if (!damage.isEmpty()) {
+            it.value()->scheduleRepaint(QRegion(damage.translated(-outputGeometry.topLeft())));
+        }
+    }
+}
+
+uint WaylandCompositor::thumbnailTexture() const
+{
+    return m_renderEngine ? m_renderEngine->getThumbnailTextureId() : 0;
+}
+
+QRectF WaylandCompositor::thumbnailRect(QWaylandSurface *surface) const
+{
+    const quint64 id = thumbnailId(surface);
+    if (!m_thumbnails->isReady(id)) {
+        return QRectF();
+    }
+    
+    const Rendering::ThumbnailAtlas::Rect rect = m_thumbnails->getRect(id);
+    const qreal size = m_thumbnails->getSize();
+    return QRectF(rect.x / size, rect.y / size, rect.width / size, rect.height / size);
+}
+
+void WaylandCompositor::setKeyboardFocus(QWaylandSurface *surface)
+{
+    if (!m_seat) {
+        qWarning() << "Cannot set keyboard focus: no seat available";
+        return;
+    }
+    
+    QWaylandSurface *oldFocus = m_seat->keyboardFocus();
+    if (oldFocus != surface) {
+        m_seat->setKeyboardFocus(surface);
+        emit keyboardFocusChanged(surface);
+    }
+}
+
+QWaylandSurface *WaylandCompositor::keyboardFocus() const
+{
+    return m_seat ? m_seat->keyboardFocus() : nullptr;
+}
+
+void WaylandCompositor::sendKeyEvent(bool pressed, int keyCode, int modifiers)
+{
+    if (!m_seat || !m_seat->keyboard()) {
+        qWarning() << "Cannot send key event: no keyboard available";
+        return;
+    }
+    
+    QWaylandSurface *focus = m_seat->keyboardFocus();
+    if (!focus) {
+        qWarning() << "Cannot send key event: no surface has keyboard focus";
+        return;
+    }
+    
+    if (pressed) {
+        m_seat->keyboard()->sendKeyPressEvent(keyCode);
+    } else {
+        m_seat->keyboard()->sendKeyReleaseEvent(keyCode);
+    }
+    
+    emit keyEvent(focus, pressed, keyCode, modifiers);
+}
+
+void WaylandCompositor::sendPointerEvent(const QPointF &pos, bool pressed, int button, int modifiers)
+{
+    if (!m_seat || !m_seat->pointer()) {
+        qWarning() << "Cannot send pointer event: no pointer available";
+        return;
+    }
+    
+    // Find the topmost surface at the position
+    QPointF localPos;
+    QWaylandSurface *targetSurface = surfaceAt(pos, &localPos);
+    
+    if (!targetSurface) {
+        return;
+    }
+    
+    // Set pointer focus
+    m_seat->pointer()->setFocus(targetSurface, localPos);
+    
+    // Send button event if needed
+    if (pressed) {
+        m_seat->pointer()->sendButtonPressEvent(button);
+    } else {
+        m_seat->pointer()->sendButtonReleaseEvent(button);
+    }
+    
+    emit pointerEvent(targetSurface, localPos, pressed, button, modifiers);
+}
+
+void WaylandCompositor::sendTouchEvent(const QPointF &pos, int id, int state)
+{
+    if (!m_seat || !m_seat->touch()) {
+        qWarning() << "Cannot send touch event: no touch device available";
+        return;
+    }
+    
+    // Find the topmost surface at the position
+    QPointF localPos;
+    QWaylandSurface *targetSurface = surfaceAt(pos, &localPos);
+    
+    if (!targetSurface) {
+        return;
+    }
+    
+    // Send touch event
+    switch (state) {
+        case 0: // pressed
+            m_seat->touch()->sendTouchPointPressed(id, localPos);
+            break;
+        case 1: // moved
+            m_seat->touch()->sendTouchPointMoved(id, localPos);
+            break;
+        case 2: // released
+            m_seat->touch()->sendTouchPointReleased(id, localPos);
+            break;
+    }
+    
+    emit touchEvent(targetSurface, localPos, id, state);
+}
+
+void WaylandCompositor::closeAllSurfaces()
+{
+    for (QWaylandSurface *surface : m_surfaces) {
+        surface->client()->close();
+    }
+    
+    m_surfaces.clear();
+}
+
+QVector<QWaylandSurface *> WaylandCompositor::surfaces() const
+{
+    return m_surfaces;
+}
+
+void WaylandCompositor::connectSignals()
+{
+    // Connect signals from the compositor
+    connect(m_compositor, &QWaylandCompositor::surfaceCreated,
+            this, &WaylandCompositor::handleSurfaceCreated);
+    connect(m_compositor, &QWaylandCompositor::surfaceAboutToBeDestroyed,
+            this, &WaylandCompositor::handleSurfaceDestroyed);
+    
+    // Connect signals from the XDG shell
+    connect(m_xdgShell, &QWaylandXdgShell::toplevelCreated,
+            this, &WaylandCompositor::handleXdgToplevelCreated);
+    connect(m_xdgShell, &QWaylandXdgShell::popupCreated,
+            this, &WaylandCompositor::handleXdgPopupCreated);
+}
+
+void WaylandCompositor::handleXdgToplevelCreated(QWaylandXdgToplevel *toplevel, QWaylandXdgSurface *xdgSurface)
+{
+    trackThumbnail(xdgSurface->surface());
+    trackResidency(xdgSurface->surface());
+    emit xdgToplevelCreated(toplevel, xdgSurface->surface());
+}
+
+void WaylandCompositor::handleXdgPopupCreated(QWaylandXdgPopup *popup, QWaylandXdgSurface *xdgSurface)
+{
+    emit xdgPopupCreated(popup, xdgSurface->surface());
+}
+
+void WaylandCompositor::handleSurfaceCreated(QWaylandSurface *surface)
+{
+    if (!surface) {
+        return;
+    }
+    
+    m_surfaces.append(surface);
+    
+    // Repaint the outputs showing the surface whenever it commits
+    connect(surface, &QWaylandSurface::redraw, this, [this, surface]() {
+        scheduleRepaint(surface);
+        damageWorkspace(surface);
+        surfaceCaughtUp(surface);
+        
+        // Every commit counts towards the client's request rate
+        const qint64 now = Rendering::FrameScheduler::now();
+        m_clientAccounting->request(accountingId(surface->client()->client()), now);
+        
+        // A buffer of the new size ends the scaling of an animating surface
+        const QSize size = surface->bufferSize();
+        if (m_animator->bufferCommitted(animationId(surface), size.width(), size.height(), now)) {
+            emit surfaceCrossfadeStarted(surface);
+        }
+    });
+    
+    // Imported shared memory buffers are uploaded again only where they changed
+    connect(surface, &QWaylandSurface::damaged, this, [this, surface](const QRegion &damage) {
+        auto it = m_bufferTextures.find(surface);
+        if (it == m_bufferTextures.end()) {
+            return;
+        }
+        
+        const int scale = surface->bufferScale();
+        for (const QRect &rect : damage) {
+            it->damage += QRect(rect.topLeft() * scale, rect.size() * scale);
+        }
+    });
+    
+    emit surfaceCreated(surface);
+}
+
+void WaylandCompositor::handleSurfaceDestroyed(QWaylandSurface *surface)
+{
+    if (!surface) {
+        return;
+    }
+    
+    // Whatever the surface covered needs repainting
+    scheduleRepaint(surface);
+    
     m_surfaces.removeOne(surface);
+    for (OcclusionCuller &culler : m_occlusion) {
+        culler.remove(occlusionKey(surface));
+    }
+    m_thumbnails->removeWindow(thumbnailId(surface));
+    delete m_thumbnailViews.take(surface);
+    
+    damageWorkspace(surface);
+    m_surfaceWorkspaces.remove(surface);
+    releaseBufferTexture(surface);
+    surfaceCaughtUp(surface);
+    
+    m_hiddenSurfaces.remove(surface);
+    m_residency->removeWindow(residencyId(surface));
+    updateBackgroundFrameTimer();
+    
+    m_animator->cancel(animationId(surface));
+    
     emit surfaceAboutToBeDestroyed(surface);
 }
 
+void WaylandCompositor::trackThumbnail(QWaylandSurface *surface)
+{
+    if (!surface) {
+        return;
+    }
+    
+    const quint64 id = thumbnailId(surface);
+    m_thumbnails->setWindow(id, surface->bufferSize().width(), surface->bufferSize().height());
+    
+    if (thumbnailsActive()) {
+        m_thumbnailViews.insert(surface, createBufferView(surface));
+    }
+    
+    connect(surface, &QWaylandSurface::bufferSizeChanged, this, [this, surface, id]() {
+        m_thumbnails->setWindow(id, surface->bufferSize().width(), surface->bufferSize().height());
+        armThumbnailTimer();
+    });
+    
+    // Only content changes make a thumbnail stale
+    connect(surface, &QWaylandSurface::redraw, this, [this, id]() {
+        m_thumbnails->damageWindow(id);
+        armThumbnailTimer();
+    });
+    
+    armThumbnailTimer();
+}
+
+void WaylandCompositor::armThumbnailTimer()
+{
+    if (!thumbnailsActive() || !m_renderEngine) {
+        return;
+    }
+    
+    const qint64 now = Rendering::FrameScheduler::now();
+    const qint64 next = m_thumbnails->nextUpdateTime(now);
+    if (next < 0) {
+        return;
+    }
+    
+    // Passes are a frame apart; whatever exceeds one pass's budget waits
+    const qint64 due = qMax(next, m_lastThumbnailPass + thumbnailFrameInterval);
+    const int delay = static_cast<int>(qMax<qint64>(0, due - now + 999999) / 1000000);
+    
+    // Keep a running timer unless it would fire too late
+    if (m_thumbnailTimer->isActive() && m_thumbnailTimer->remainingTime() <= delay) {
+        return;
+    }
+    m_thumbnailTimer->start(delay);
+}
+
+void WaylandCompositor::updateThumbnails()
+{
+    if (!thumbnailsActive() || !m_renderEngine) {
+        return;
+    }
+    
+    drawThumbnails();
+    armThumbnailTimer();
+}
+
+void WaylandCompositor::drawThumbnails()
+{
+    // Surfaces without a view, e.g. released ones, are imported for the pass only
+    QVector<QWaylandView *> transientViews;
+    
+    m_lastThumbnailPass = Rendering::FrameScheduler::now();
+    const int drawn = m_renderEngine->updateThumbnails(*m_thumbnails, [this, &transientViews](uint64_t window) -> uint32_t {
+        QWaylandSurface *surface = reinterpret_cast<QWaylandSurface *>(static_cast<quintptr>(window));
+        QWaylandView *view = bufferView(surface);
+        if (!view) {
+            view = createBufferView(surface);
+            transientViews.append(view);
+        }
+        
+        return importBuffer(surface, view);
+    }, m_lastThumbnailPass);
+    qDeleteAll(transientViews);
+    
+    if (drawn > 0) {
+        emit thumbnailsUpdated();
+    }
+}
+
+quint64 WaylandCompositor::workspaceKey(const QString &workspace)
+{
+    auto it = m_workspaceKeys.find(workspace);
+    if (it == m_workspaceKeys.end()) {
+        it = m_workspaceKeys.insert(workspace, m_nextWorkspaceKey++);
+        m_snapshots->addWorkspace(*it);
+    }
+    
+    return *it;
+}
+
+void WaylandCompositor::damageWorkspace(QWaylandSurface *surface)
+{
+    const auto it = m_surfaceWorkspaces.constFind(surface);
+    if (it == m_surfaceWorkspaces.constEnd()) {
+        return;
+    }
+    
+    m_snapshots->damageWorkspace(m_workspaceKeys.value(*it));
+    armSnapshotTimer();
+}
+
+void WaylandCompositor::surfaceCaughtUp(QWaylandSurface *surface)
+{
+    if (m_catchingUp.remove(surface) && m_catchingUp.isEmpty()) {
+        m_catchUpTimer->stop();
+        emit workspaceCaughtUp(m_activeWorkspace);
+    }
+}
+
+void WaylandCompositor::catchUpTimedOut()
+{
+    if (m_catchingUp.isEmpty()) {
+        return;
+    }
+    
+    m_catchingUp.clear();
+    emit workspaceCaughtUp(m_activeWorkspace);
+}
+
+void WaylandCompositor::armSnapshotTimer()
+{
+    if (!m_renderEngine) {
+        return;
+    }
+    
+    const qint64 now = Rendering::FrameScheduler::now();
+    const qint64 next = m_snapshots->nextRefreshTime(now);
+    if (next < 0) {
+        return;
+    }
+    
+    // Snapshots are low priority; passes never come closer than a frame
+    const qint64 due = qMax(next, m_lastSnapshotPass + snapshotFrameInterval);
+    const int delay = static_cast<int>(qMax<qint64>(0, due - now + 999999) / 1000000);
+    
+    // Keep a running timer unless it would fire too late
+    if (m_snapshotTimer->isActive() && m_snapshotTimer->remainingTime() <= delay) {
+        return;
+    }
+    m_snapshotTimer->start(delay);
+}
+
+void WaylandCompositor::updateWorkspaceSnapshots()
+{
+    if (!m_renderEngine) {
+        return;
+    }
+    
+    const QPoint origin = m_primaryOutput ? m_primaryOutput->geometry().topLeft() : QPoint();
+    
+    // Surfaces without a thumbnail view are imported for the pass only; the engine keeps the copy
+    QVector<QWaylandView *> transientViews;
+    
+    m_lastSnapshotPass = Rendering::FrameScheduler::now();
+    const int drawn = m_renderEngine->updateWorkspaceSnapshots(*m_snapshots, [this, origin, &transientViews](uint64_t workspace) {
+        std::vector<Rendering::WorkspaceSnapshots::Layer> layers;
+        
+        // Bottom first, as the workspace was last composited
+        for (QWaylandSurface *surface : m_surfaces) {
+            if (!surface->hasContent() || m_workspaceKeys.value(m_surfaceWorkspaces.value(surface)) != workspace) {
+                continue;
+            }
+            
+            QWaylandView *view = bufferView(surface);
+            if (!view) {
+                view = createBufferView(surface);
+                transientViews.append(view);
+            }
+            
+            const uint texture = importBuffer(surface, view);
+            if (texture == 0) {
+                continue;
+            }
+            
+            const QPoint position = surface->client()->positionForOutput(surface, m_primaryOutput) - origin;
+            Rendering::WorkspaceSnapshots::Layer layer;
+            layer.texture = texture;
+            layer.x = position.x();
+            layer.y = position.y();
+            layer.width = surface->size().width();
+            layer.height = surface->size().height();
+            layers.push_back(layer);
+        }
+        
+        return layers;
+    }, m_lastSnapshotPass);
+    qDeleteAll(transientViews);
+    
+    if (drawn > 0) {
+        emit workspaceSnapshotsUpdated();
+    }
+    
+    armSnapshotTimer();
+}
+
+void WaylandCompositor::updateBackgroundFrameTimer()
+{
+    bool background = false;
+    for (QWaylandSurface *surface : m_surfaces) {
+        if (isSurfaceHidden(surface) && isSurfaceResident(surface)) {
+            background = true;
+            break;
+        }
+    }
+    
+    if (!background) {
+        m_backgroundFrameTimer->stop();
+    } else if (!m_backgroundFrameTimer->isActive()) {
+        m_backgroundFrameTimer->start();
+    }
+}
+
+void WaylandCompositor::sendBackgroundFrameCallbacks()
+{
+    // Enough for background clients to keep their workspace's snapshot current; released ones sleep
+    for (QWaylandSurface *surface : m_surfaces) {
+        if (isSurfaceHidden(surface) && isSurfaceResident(surface)) {
+            surface->sendFrameCallbacks();
+        }
+    }
+}
+
+QWaylandView *WaylandCompositor::bufferView(QWaylandSurface *surface) const
+{
+    return m_thumbnailViews.value(surface);
+}
+
+QWaylandView *WaylandCompositor::createBufferView(QWaylandSurface *surface)
+{
+    QWaylandView *view = new QWaylandView(this, this);
+    view->setSurface(surface);
+    return view;
+}
+
+uint WaylandCompositor::importBuffer(QWaylandSurface *surface, QWaylandView *view)
+{
+    view->advance();
+    const QWaylandBufferRef buffer = view->currentBuffer();
+    
+    // GPU buffers are imported by Qt Quick into its own context, which the engine's doesn't share
+    if (!buffer.isSharedMemory()) {
+        return 0;
+    }
+    
+    const QImage image = buffer.image();
+    const Rendering::ShmUpload::Format format = shmFormat(image.format());
+    if (image.isNull() || format == Rendering::ShmUpload::Format::Invalid) {
+        return 0;
+    }
+    
+    // A new texture is filled completely by its first upload
+    BufferTexture &imported = m_bufferTextures[surface];
+    if (!imported.texture) {
+        imported.texture = m_renderEngine->createTexture(0, 0);
+        imported.damage = QRegion();
+        if (!imported.texture) {
+            m_bufferTextures.remove(surface);
+            return 0;
+        }
+    }
+    
+    std::vector<Rendering::ShmUpload::Rect> damage;
+    damage.reserve(imported.damage.rectCount());
+    for (const QRect &rect : imported.damage) {
+        Rendering::ShmUpload::Rect damaged;
+        damaged.x = rect.x();
+        damaged.y = rect.y();
+        damaged.width = rect.width();
+        damaged.height = rect.height();
+        damage.push_back(damaged);
+    }
+    imported.damage = QRegion();
+    
+    imported.texture->uploadShm(image.constBits(), image.width(), image.height(), image.bytesPerLine(), format,
+                                damage, &m_renderEngine->getPixelBufferRing());
+    return imported.texture->getTextureId();
+}
+
+void WaylandCompositor::releaseBufferTexture(QWaylandSurface *surface)
+{
+    const BufferTexture imported = m_bufferTextures.take(surface);
+    if (!imported.texture || !m_renderEngine) {
+        return;
+    }
+    
+    // The texture goes with its last reference, at the end of this function, in the engine's context
+    m_renderEngine->makeCurrent();
+    m_renderEngine->releaseTexture(imported.texture);
+}
+
+void WaylandCompositor::trackResidency(QWaylandSurface *surface)
+{
+    if (!surface) {
+        return;
+    }
+    
+    const quint64 id = residencyId(surface);
+    m_residency->setWindow(id, surface->bufferSize().width(), surface->bufferSize().height());
+    
+    connect(surface, &QWaylandSurface::bufferSizeChanged, this, [this, surface, id]() {
+        m_residency->setWindow(id, surface->bufferSize().width(), surface->bufferSize().height());
+        armResidencyTimer();
+    });
+    
+    updateResidency(surface);
+}
+
+void WaylandCompositor::updateResidency(QWaylandSurface *surface)
+{
+    const quint64 id = residencyId(surface);
+    if (!m_residency->hasWindow(id)) {
+        return;
+    }
+    
+    if (m_residency->setHidden(id, isSurfaceHidden(surface), Rendering::FrameScheduler::now())) {
+        restoreSurfaceBuffers(surface);
+    }
+    armResidencyTimer();
+}
+
+void WaylandCompositor::armResidencyTimer()
+{
+    const qint64 now = Rendering::FrameScheduler::now();
+    const qint64 next = m_residency->nextReleaseTime(now);
+    if (next < 0) {
+        m_residencyTimer->stop();
+        return;
+    }
+    
+    const qint64 due = qMax(next, m_lastResidencyPass + residencyPassInterval);
+    const int delay = static_cast<int>(qMax<qint64>(0, due - now + 999999) / 1000000);
+    
+    // Keep a running timer unless it would fire too late
+    if (m_residencyTimer->isActive() && m_residencyTimer->remainingTime() <= delay) {
+        return;
+    }
+    m_residencyTimer->start(delay);
+}
+
+void WaylandCompositor::releaseHiddenBuffers()
+{
+    m_lastResidencyPass = Rendering::FrameScheduler::now();
+    
+    // A surface is only released once its thumbnail can stand in for it
+    QVector<quint64> needThumbnail;
+    const std::vector<uint64_t> released = m_residency->takeReleases(m_lastResidencyPass, [this, &needThumbnail](uint64_t id) {
+        QWaylandSurface *surface = reinterpret_cast<QWaylandSurface *>(static_cast<quintptr>(id));
+        if (m_thumbnails->isReady(thumbnailId(surface)) || !m_renderEngine) {
+            return true;
+        }
+        
+        needThumbnail.append(thumbnailId(surface));
+        return false;
+    });
+    
+    for (uint64_t id : released) {
+        releaseSurfaceBuffers(reinterpret_cast<QWaylandSurface *>(static_cast<quintptr>(id)));
+    }
+    
+    if (!needThumbnail.isEmpty()) {
+        for (quint64 id : needThumbnail) {
+            m_thumbnails->damageWindow(id);
+        }
+        drawThumbnails();
+    }
+    
+    if (!released.empty()) {
+        const Rendering::BufferResidency::Stats stats = m_residency->getStats();
+        qDebug() << "Released buffers of" << released.size() << "hidden surfaces," << stats.releasedBytes / 1024
+                 << "KiB released," << stats.droppedBytes / 1024 << "KiB of buffer references dropped in total";
+        updateBackgroundFrameTimer();
+    }
+    
+    armResidencyTimer();
+}
+
+void WaylandCompositor::releaseSurfaceBuffers(QWaylandSurface *surface)
+{
+    // Dropping the views releases the buffer references and textures they hold
+    delete m_thumbnailViews.take(surface);
+    releaseBufferTexture(surface);
+    
+    emit surfaceBuffersReleased(surface);
+}
+
+void WaylandCompositor::restoreSurfaceBuffers(QWaylandSurface *surface)
+{
+    if (thumbnailsActive() && m_thumbnails->hasWindow(thumbnailId(surface)) && !m_thumbnailViews.contains(surface)) {
+        m_thumbnailViews.insert(surface, createBufferView(surface));
+    }
+    
+    // The client slept while released; let it draw a fresh frame
+    surface->sendFrameCallbacks();
+    updateBackgroundFrameTimer();
+    
+    emit surfaceBuffersRestored(surface);
+}
+
+void WaylandCompositor::trackClient(wl_client *client)
+{
+    ClientListener *listener = new ClientListener;
+    listener->compositor = this;
+    listener->client = client;
+    listener->resourceCreated.notify = &WaylandCompositor::handleResourceCreated;
+    listener->destroyed.notify = &WaylandCompositor::handleClientDestroyed;
+    wl_client_add_resource_created_listener(client, &listener->resourceCreated);
+    wl_client_add_destroy_listener(client, &listener->destroyed);
+    m_clientListeners.insert(client, listener);
+    
+    pid_t pid = 0;
+    wl_client_get_credentials(client, &pid, nullptr, nullptr);
+    m_clientAccounting->addClient(accountingId(client), pid, Rendering::FrameScheduler::now());
+}
+
+void WaylandCompositor::untrackClient(ClientListener *listener)
+{
+    wl_list_remove(&listener->resourceCreated.link);
+    wl_list_remove(&listener->destroyed.link);
+    m_clientListeners.remove(listener->client);
+    m_clientAccounting->removeClient(accountingId(listener->client));
+    delete listener;
+}
+
+void WaylandCompositor::accountClients()
+{
+    using Rendering::ClientAccounting;
+    
+    const qint64 now = Rendering::FrameScheduler::now();
+    
+    // Textures are held for the surfaces whose buffers weren't released
+    QHash<wl_client *, quint64> textureBytes;
+    for (QWaylandSurface *surface : m_surfaces) {
+        if (surface->hasContent() && isSurfaceResident(surface)) {
+            const QSize size = surface->bufferSize();
+            textureBytes[surface->client()->client()] += static_cast<quint64>(size.width()) * size.height() * 4;
+        }
+    }
+    
+    // Walking the objects of every client is cheap enough once a second, and needs no bookkeeping per object
+    for (auto it = m_clientListeners.cbegin(); it != m_clientListeners.cend(); ++it) {
+        ClientObjects objects;
+        objects.linuxDmabuf = m_linuxDmabuf;
+        wl_client_for_each_resource(it.key(), countClientObject, &objects);
+        
+        const quint64 id = accountingId(it.key());
+        m_clientAccounting->set(id, ClientAccounting::Surfaces, objects.surfaces, now);
+        m_clientAccounting->set(id, ClientAccounting::Buffers, objects.buffers, now);
+        m_clientAccounting->set(id, ClientAccounting::DmabufImports, objects.dmabufImports, now);
+        m_clientAccounting->set(id, ClientAccounting::ShmBytes, objects.shmBytes, now);
+        m_clientAccounting->set(id, ClientAccounting::TextureBytes, textureBytes.value(it.key()), now);
+        m_clientAccounting->set(id, ClientAccounting::ProtocolObjects, objects.objects, now);
+    }
+    
+    const std::vector<uint64_t> expired = m_clientAccounting->update(now);
+    
+    for (const ClientAccounting::Event &event : m_clientAccounting->takeEvents()) {
+        // A slot of an earlier event may have disconnected the client
+        wl_client *client = reinterpret_cast<wl_client *>(static_cast<quintptr>(event.client));
+        if (!m_clientListeners.contains(client)) {
+            continue;
+        }
+        
+        QWaylandClient *waylandClient = QWaylandClient::fromWlClient(m_compositor, client);
+        const QString resource = QLatin1String(ClientAccounting::resourceName(event.resource));
+        if (event.level != ClientAccounting::Normal) {
+            qWarning() << "Client" << waylandClient->processId() << "is over its"
+                       << (event.level == ClientAccounting::OverHardLimit ? "hard" : "soft") << "limit of" << resource << ":"
+                       << m_clientAccounting->usage(event.client, event.resource);
+        }
+        emit clientResourceLimitChanged(waylandClient, resource, static_cast<int>(event.level));
+    }
+    
+    // Slots may have disconnected clients as well
+    for (uint64_t id : expired) {
+        wl_client *client = reinterpret_cast<wl_client *>(static_cast<quintptr>(id));
+        if (m_clientListeners.contains(client)) {
+            disconnectClient(client);
+        }
+    }
+}
+
+void WaylandCompositor::disconnectClient(wl_client *client)
+{
+    QWaylandClient *waylandClient = QWaylandClient::fromWlClient(m_compositor, client);
+    qWarning() << "Disconnecting client" << waylandClient->processId() << "for staying over its resource limits";
+    emit clientDisconnectedForResources(waylandClient);
+    
+    // Tell the client why before the connection goes away
+    wl_client_post_no_memory(client);
+    wl_client_flush(client);
+    waylandClient->close();
+}
+
+void WaylandCompositor::handleClientCreated(wl_listener *listener, void *data)
+{
+    DisplayListener *displayListener = wl_container_of(listener, displayListener, clientCreated);
+    displayListener->compositor->trackClient(static_cast<wl_client *>(data));
+}
+
+void WaylandCompositor::handleClientDestroyed(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data);
+    ClientListener *clientListener = wl_container_of(listener, clientListener, destroyed);
+    clientListener->compositor->untrackClient(clientListener);
+}
+
+void WaylandCompositor::handleResourceCreated(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data);
+    
+    // Every object a client creates is a request
+    ClientListener *clientListener = wl_container_of(listener, clientListener, resourceCreated);
+    clientListener->compositor->m_clientAccounting->request(accountingId(clientListener->client),
+                                                            Rendering::FrameScheduler::now());
+}
+
 } // namespace VivoX::Compositor
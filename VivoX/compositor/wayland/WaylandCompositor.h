@@ -6,13 +6,42 @@
 #include <QWaylandOutput>
 #include <QWaylandXdgShell>
 #include <QWaylandSeat>
+#include <QHash>
+#include <QRectF>
+#include <QRegion>
+#include <QSet>
+#include <QVariantList>
 #include <QVector>
 #include <memory>
 
+#include "OcclusionCuller.h"
+#include "../rendering/BufferResidency.h"
+#include "../rendering/ClientAccounting.h"
+#include "../rendering/GeometryAnimator.h"
+
+class QTimer;
+class QWaylandClient;
+class QWaylandView;
+struct wl_client;
+struct wl_listener;
+
+namespace VivoX::Wayland {
+class LinuxDmabufProtocol;
+class PresentationTimeProtocol;
+}
+
 namespace VivoX::Compositor {
 
-class WaylandProtocols;
+namespace Rendering {
 class RenderEngine;
+class RenderTexture;
+class ThumbnailAtlas;
+class WorkspaceSnapshots;
+}
+using Rendering::RenderEngine;
+
+class WaylandProtocols;
+class OutputRenderLoop;
 
 /**
  * @brief The WaylandCompositor class is the core of the Wayland compositor implementation.
@@ -110,12 +139,412 @@ public:
      */
     QWaylandOutput *outputForSurface(QWaylandSurface *surface) const;
     
+    /**
+     * @brief Check whether a surface is visible on the given output
+     * @param surface The surface to check
+     * @param output The output to check against
+     * @return True if the surface has content and intersects the output
+     */
+    bool isSurfaceVisibleOnOutput(QWaylandSurface *surface, QWaylandOutput *output) const;
+    
+    /**
+     * @brief Raise a surface to the top of the stacking order
+     * 
+     * New surfaces start on top. The window manager raises a window's
+     * surface when it activates the window, which keeps the occlusion
+     * culling in step with what the user sees.
+     * 
+     * @param surface The surface to raise
+     */
+    void raiseSurface(QWaylandSurface *surface);
+    
+    /**
+     * @brief Lower a surface to the bottom of the stacking order
+     * @param surface The surface to lower
+     */
+    void lowerSurface(QWaylandSurface *surface);
+    
+    /**
+     * @brief Recompute which surfaces are visible on an output
+     * 
+     * Called when a frame for the output starts. Surfaces are walked from
+     * the top of the stacking order down; a surface entirely covered by
+     * opaque surfaces above it is occluded on the output.
+     * 
+     * @param output The output about to be composed
+     */
+    void updateOcclusion(QWaylandOutput *output);
+    
+    /**
+     * @brief Check if a surface is entirely covered on an output
+     * @param surface The surface to check
+     * @param output The output to check on
+     * @return True if nothing of the surface was visible on the output in its last frame
+     */
+    bool isSurfaceOccluded(QWaylandSurface *surface, QWaylandOutput *output) const;
+    
+    /**
+     * @brief Get the number of surfaces culled in the last frame of an output
+     * @param output The output
+     * @return The number of occluded surfaces
+     */
+    int culledSurfaces(QWaylandOutput *output) const;
+    
+    /**
+     * @brief Send wl_surface.frame callbacks for a repainted output
+     * 
+     * Only surfaces visible on the output are notified, so clients on other
+     * outputs keep pacing to their own output's refresh. Occluded surfaces
+     * are not notified either, so their clients stop drawing until they are
+     * uncovered; the surface with keyboard focus is always notified. Hidden
+     * surfaces, like those on inactive workspaces, are notified at a low
+     * fixed rate instead, independently of the outputs, and not at all once
+     * their buffers were released.
+     * 
+     * @param output The output that has just been presented
+     */
+    void sendFrameCallbacks(QWaylandOutput *output);
+    
+    /**
+     * @brief Send wp_presentation feedback for a presented output
+     * 
+     * Surfaces visible on the output are reported as presented at the
+     * given time; occluded ones were left out of the frame, so their
+     * feedback is discarded.
+     * 
+     * @param output The output that has just been presented
+     * @param time Presentation time, CLOCK_MONOTONIC nanoseconds
+     * @param sequence Frame counter of the output
+     * @param refresh Refresh interval of the output in nanoseconds, 0 if unknown
+     */
+    void sendPresentationFeedback(QWaylandOutput *output, qint64 time, quint64 sequence, qint64 refresh);
+    
+    /**
+     * @brief Get the render loop of an output
+     * @param output The output
+     * @return The OutputRenderLoop instance, or nullptr if the output is unknown
+     */
+    OutputRenderLoop *renderLoop(QWaylandOutput *output) const;
+    
+    /**
+     * @brief Schedule a repaint of every output a surface is visible on
+     * @param surface The surface whose content changed
+     */
+    void scheduleRepaint(QWaylandSurface *surface);
+    
+    /**
+     * @brief Schedule a repaint of an area of the desktop, e.g. one the shell draws into
+     * @param rect The area in global coordinates
+     */
+    void scheduleRepaint(const QRect &rect);
+    
+    /**
+     * @brief Let a fullscreen surface drive the refresh rate of an output
+     * 
+     * On outputs with adaptive sync enabled, the output then refreshes when
+     * the client commits a new frame.
+     * 
+     * @param output The output showing the surface
+     * @param surface The fullscreen surface, or nullptr to return to the normal cadence
+     */
+    void setFullscreenSurface(QWaylandOutput *output, QWaylandSurface *surface);
+    
+    /**
+     * @brief Get the fullscreen surface driving the refresh rate of an output
+     * @param output The output
+     * @return The fullscreen surface, or nullptr if none
+     */
+    QWaylandSurface *fullscreenSurface(QWaylandOutput *output) const;
+    
+    /**
+     * @brief Get the name an output is scheduled under
+     * @param output The output
+     * @return The connector name of the output's screen, or its model if unknown
+     */
+    static QString outputName(QWaylandOutput *output);
+    
     /**
      * @brief Get the rendering engine
      * @return The RenderEngine instance
      */
     RenderEngine *renderEngine() const;
     
+    /**
+     * @brief Start keeping window thumbnails up to date
+     * 
+     * Every toplevel surface has a downscaled thumbnail in one shared atlas
+     * texture. While at least one user holds the thumbnails, e.g. the stage,
+     * the window switcher or taskbar previews, surfaces whose content
+     * changed are redrawn into the atlas at a capped rate. Windows are never
+     * reconfigured for this.
+     * 
+     * Calls must be balanced with releaseThumbnails().
+     */
+    void acquireThumbnails();
+    
+    /**
+     * @brief Stop keeping window thumbnails up to date once no user is left
+     */
+    void releaseThumbnails();
+    
+    /**
+     * @brief Check if window thumbnails are being kept up to date
+     * @return True if at least one user holds the thumbnails
+     */
+    bool thumbnailsActive() const;
+    
+    /**
+     * @brief Get the texture holding the thumbnails
+     * @return The texture ID, or 0 before the first thumbnail was drawn
+     */
+    uint thumbnailTexture() const;
+    
+    /**
+     * @brief Get where the thumbnail of a surface is in the thumbnail texture
+     * @param surface The toplevel surface
+     * @return The thumbnail in normalized texture coordinates, or an empty rectangle if it's not drawn yet
+     */
+    QRectF thumbnailRect(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Put a surface on a workspace
+     * 
+     * Surfaces on inactive workspaces are not composited; their frame
+     * callbacks are throttled and their content only goes into the snapshot
+     * of their workspace. Surfaces not put on any workspace, like panels and
+     * popups, are always active.
+     * 
+     * @param surface The toplevel surface
+     * @param workspace The workspace ID, or an empty string to take the surface off its workspace
+     */
+    void setSurfaceWorkspace(QWaylandSurface *surface, const QString &workspace);
+    
+    /**
+     * @brief Get the workspace of a surface
+     * @param surface The surface
+     * @return The workspace ID, or an empty string if the surface isn't on a workspace
+     */
+    QString surfaceWorkspace(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Check if a surface is on the active workspace
+     * @param surface The surface
+     * @return True if the surface is on the active workspace or on no workspace
+     */
+    bool isSurfaceOnActiveWorkspace(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Switch the workspace being composited
+     * 
+     * The clients of the new workspace get their frame callbacks right away.
+     * Until they have all drawn, the switch animation can show the snapshot
+     * of the workspace; workspaceCaughtUp() tells when the live surfaces can
+     * take over. The workspace left is captured into its snapshot.
+     * 
+     * @param workspace The workspace ID
+     */
+    void setActiveWorkspace(const QString &workspace);
+    
+    /**
+     * @brief Get the workspace being composited
+     * @return The workspace ID, or an empty string if none was set
+     */
+    QString activeWorkspace() const;
+    
+    /**
+     * @brief Forget a workspace and free its snapshot
+     * @param workspace The workspace ID
+     */
+    void removeWorkspace(const QString &workspace);
+    
+    /**
+     * @brief Get the texture holding the snapshot of a workspace
+     * 
+     * Snapshots are composited at a reduced scale and refreshed at low
+     * priority while their workspace is in the background.
+     * 
+     * @param workspace The workspace ID
+     * @return The texture ID, or 0 if the snapshot isn't drawn yet
+     */
+    uint workspaceSnapshotTexture(const QString &workspace) const;
+    
+    /**
+     * @brief Hide or show a surface, e.g. a minimized window or a background tab
+     * 
+     * Hidden surfaces, like those on inactive workspaces, are not composited
+     * and their frame callbacks are throttled. Once a surface has been hidden
+     * for the grace period, or earlier when the buffers of all windows exceed
+     * the budget, the compositor drops its buffers and keeps only the
+     * thumbnail as a preview. They are imported again when it is shown.
+     * 
+     * @param surface The toplevel surface
+     * @param hidden True if the surface is no longer shown
+     */
+    void setSurfaceHidden(QWaylandSurface *surface, bool hidden);
+    
+    /**
+     * @brief Check if a surface is hidden
+     * @param surface The surface
+     * @return True if the surface was hidden or is on an inactive workspace
+     */
+    bool isSurfaceHidden(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Check if the compositor holds the buffers of a surface
+     * @param surface The surface
+     * @return False if the buffers were released while the surface is hidden
+     */
+    bool isSurfaceResident(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Import the buffers of a hidden surface again, e.g. for a live preview
+     * 
+     * The surface's grace period starts over.
+     * 
+     * @param surface The surface
+     */
+    void requestSurfaceBuffers(QWaylandSurface *surface);
+    
+    /**
+     * @brief Set the memory budget for the buffers of all windows
+     * @param bytes The budget in bytes; hidden windows are released early while it is exceeded
+     */
+    void setBufferBudget(quint64 bytes);
+    
+    /**
+     * @brief Set how long a surface stays hidden before its buffers are released
+     * @param msec The grace period in milliseconds
+     */
+    void setBufferGracePeriod(int msec);
+    
+    /**
+     * @brief Get the buffer residency statistics
+     * @return The statistics, including the buffer bytes dropped from hidden windows
+     */
+    Rendering::BufferResidency::Stats bufferResidencyStats() const;
+    
+    /**
+     * @brief Enable the geometry animations
+     * 
+     * Off by default: the animations rely on the views drawing client
+     * surfaces to keep the old buffer and draw it at the animated geometry,
+     * and the shell has no such view yet. Until one enables them, surfaces
+     * simply change to their new geometry.
+     * 
+     * @param enabled Whether surfaces animate to new geometries
+     */
+    void setSurfaceAnimationsEnabled(bool enabled);
+    
+    /**
+     * @brief Check if the geometry animations are enabled
+     * @return True if animateSurfaceGeometry() animates
+     */
+    bool surfaceAnimationsEnabled() const;
+    
+    /**
+     * @brief Animate a surface from its old geometry to a new one
+     * 
+     * The client is configured to the new size right away, but its resized
+     * buffer may take many frames to arrive. Until it does, views of the
+     * surface keep drawing its last buffer, scaled into a geometry
+     * interpolated at the output's refresh rate; once it arrives, it is
+     * crossfaded in. A surface already animating continues from where it is.
+     * Does nothing unless the animations are enabled.
+     * 
+     * @param surface The toplevel surface
+     * @param from The geometry shown until now
+     * @param to The new geometry
+     */
+    void animateSurfaceGeometry(QWaylandSurface *surface, const QRect &from, const QRect &to);
+    
+    /**
+     * @brief Stop animating a surface; it is drawn at its new geometry right away
+     * @param surface The surface
+     */
+    void cancelSurfaceAnimation(QWaylandSurface *surface);
+    
+    /**
+     * @brief Check if a surface is animating
+     * @param surface The surface
+     * @return True if the surface is drawn at an interpolated geometry
+     */
+    bool isSurfaceAnimating(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Get the geometry a surface is drawn at in the current frame
+     * @param surface The surface
+     * @return The interpolated geometry, or an empty rectangle if the surface isn't animating
+     */
+    QRectF surfaceAnimatedGeometry(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Get the opacity of a surface's resized buffer over its old one
+     * @param surface The surface
+     * @return 0 while only the old buffer is shown, up to 1 once the crossfade is done
+     */
+    qreal surfaceCrossfade(QWaylandSurface *surface) const;
+    
+    /**
+     * @brief Evaluate the geometry animations for a frame
+     * 
+     * Called when a frame for an output starts. All animations are evaluated
+     * in one pass; outputs showing one are repainted until it finishes.
+     */
+    void updateAnimations();
+    
+    /**
+     * @brief Get the geometry animation statistics
+     * @return The statistics
+     */
+    Rendering::GeometryAnimator::Stats animationStats() const;
+    
+    /**
+     * @brief Set the limits of a resource held by each client
+     * 
+     * Every client's surfaces, buffers, dmabuf imports, shared memory,
+     * textures, protocol objects and request rate are accounted. A client
+     * over a soft limit is reported through clientResourceLimitChanged(). A
+     * client still over a hard limit after the grace period is told it ran
+     * out of memory and disconnected.
+     * 
+     * @param resource The resource
+     * @param soft The soft limit, 0 for none
+     * @param hard The hard limit, 0 for none
+     */
+    void setClientLimit(Rendering::ClientAccounting::Resource resource, quint64 soft, quint64 hard);
+    
+    /**
+     * @brief Set how long a client may stay over a hard limit before it is disconnected
+     * @param msec The grace period in milliseconds
+     */
+    void setClientGracePeriod(int msec);
+    
+    /**
+     * @brief Get the resources held by a client
+     * @param client The client
+     * @return The client's usage, as of the last accounting pass
+     */
+    Rendering::ClientAccounting::Usage clientUsage(QWaylandClient *client) const;
+    
+    /**
+     * @brief Get the clients using the most of a resource, e.g. for a debug overlay
+     * 
+     * Each client is a map with its "pid", its "level" (0 within its limits,
+     * 1 over a soft and 2 over a hard limit), its "requests" in total and the
+     * amount of each resource by name, e.g. "textureBytes".
+     * 
+     * @param count The number of clients
+     * @param resource The name of the resource to rank the clients by
+     * @return The clients, the highest usage first
+     */
+    Q_INVOKABLE QVariantList topClients(int count = 10, const QString &resource = QStringLiteral("textureBytes")) const;
+    
+    /**
+     * @brief Get the client accounting statistics
+     * @return The statistics
+     */
+    Rendering::ClientAccounting::Stats clientAccountingStats() const;
+    
     /**
      * @brief Set keyboard focus to the given surface
      * @param surface The surface to focus
@@ -230,6 +659,108 @@ signals:
      * @param state The touch state (pressed, moved, released)
      */
     void touchEvent(QWaylandSurface *surface, const QPointF &pos, int id, int state);
+    
+    /**
+     * @brief Signal emitted when a surface becomes occluded or visible on an output
+     * 
+     * Meant for views of the surfaces, which need not draw an occluded one.
+     * The compositor itself already withholds its frame callbacks and ignores
+     * its damage.
+     * 
+     * @param output The output
+     * @param surface The surface
+     * @param occluded True if the surface is now entirely covered
+     */
+    void surfaceOcclusionChanged(QWaylandOutput *output, QWaylandSurface *surface, bool occluded);
+    
+    /**
+     * @brief Signal emitted when thumbnails have been redrawn
+     */
+    void thumbnailsUpdated();
+    
+    /**
+     * @brief Signal emitted when the buffers of a hidden surface have been released
+     * 
+     * Views of the surface should discard their buffer and show its thumbnail.
+     * 
+     * @param surface The surface
+     */
+    void surfaceBuffersReleased(QWaylandSurface *surface);
+    
+    /**
+     * @brief Signal emitted when the buffers of a released surface are imported again
+     * @param surface The surface
+     */
+    void surfaceBuffersRestored(QWaylandSurface *surface);
+    
+    /**
+     * @brief Signal emitted when the workspace being composited changes
+     * @param previous The workspace left
+     * @param current The workspace now active
+     */
+    void activeWorkspaceChanged(const QString &previous, const QString &current);
+    
+    /**
+     * @brief Signal emitted when every surface of the active workspace has drawn since the switch
+     * 
+     * Clients with nothing new to draw are not waited for beyond a short grace period.
+     * 
+     * @param workspace The active workspace
+     */
+    void workspaceCaughtUp(const QString &workspace);
+    
+    /**
+     * @brief Signal emitted when workspace snapshots have been redrawn
+     */
+    void workspaceSnapshotsUpdated();
+    
+    /**
+     * @brief Signal emitted when a surface starts animating to a new geometry
+     * 
+     * Views of the surface should lock their current buffer when asked to
+     * keep it, and draw it at surfaceAnimatedGeometry().
+     * 
+     * @param surface The surface
+     * @param keepBuffer True if the buffer shown now is the one to scale until the client resizes
+     */
+    void surfaceAnimationStarted(QWaylandSurface *surface, bool keepBuffer);
+    
+    /**
+     * @brief Signal emitted when the client committed a buffer of the new size
+     * 
+     * Views should draw it over the kept buffer at surfaceCrossfade().
+     * 
+     * @param surface The surface
+     */
+    void surfaceCrossfadeStarted(QWaylandSurface *surface);
+    
+    /**
+     * @brief Signal emitted when the geometry animations have been evaluated for a frame
+     */
+    void surfaceAnimationsUpdated();
+    
+    /**
+     * @brief Signal emitted when a surface has reached its new geometry
+     * 
+     * Views should release the kept buffer and draw the surface as usual.
+     * 
+     * @param surface The surface
+     */
+    void surfaceAnimationFinished(QWaylandSurface *surface);
+    
+    /**
+     * @brief Signal emitted when a client goes over a resource limit or back under it
+     * @param client The client
+     * @param resource The name of the resource, e.g. "textureBytes"
+     * @param level 0 within the limits, 1 over the soft and 2 over the hard limit
+     */
+    void clientResourceLimitChanged(QWaylandClient *client, const QString &resource, int level);
+    
+    /**
+     * @brief Signal emitted before a client over a hard limit is disconnected
+     * @param client The client
+     */
+    void clientDisconnectedForResources(QWaylandClient *client);
 
 private:
     // The underlying QWaylandCompositor instance
@@ -244,6 +775,12 @@ private:
     // The Wayland protocols manager
     WaylandProtocols *m_protocols;
     
+    // wp_presentation, fed by the render loops
+    VivoX::Wayland::PresentationTimeProtocol *m_presentationTime;
+    
+    // zwp_linux_dmabuf_v1, which knows the buffers imported through it
+    VivoX::Wayland::LinuxDmabufProtocol *m_linuxDmabuf;
+    
     // The rendering engine
     RenderEngine *m_renderEngine;
     
@@ -253,9 +790,97 @@ private:
     // Primary output
     QWaylandOutput *m_primaryOutput;
     
-    // List of active surfaces
+    // Independent render loop per output
+    QHash<QWaylandOutput *, OutputRenderLoop *> m_renderLoops;
+    
+    // List of active surfaces in stacking order, bottom first
     QVector<QWaylandSurface *> m_surfaces;
     
+    // Visible regions of the surfaces per output
+    QHash<QWaylandOutput *, OcclusionCuller> m_occlusion;
+    
+    // Thumbnails of the toplevel surfaces
+    std::unique_ptr<Rendering::ThumbnailAtlas> m_thumbnails;
+    
+    // Views holding the current buffer of each toplevel surface while thumbnails are active
+    QHash<QWaylandSurface *, QWaylandView *> m_thumbnailViews;
+    
+    // Number of users holding the thumbnails
+    int m_thumbnailUsers;
+    
+    // Fires when the next thumbnail is due
+    QTimer *m_thumbnailTimer;
+    
+    // Start of the last thumbnail pass, CLOCK_MONOTONIC nanoseconds
+    qint64 m_lastThumbnailPass;
+    
+    // Workspace of each surface put on one
+    QHash<QWaylandSurface *, QString> m_surfaceWorkspaces;
+    
+    // Workspace being composited
+    QString m_activeWorkspace;
+    
+    // Keys of the workspaces in the snapshot schedule
+    QHash<QString, quint64> m_workspaceKeys;
+    quint64 m_nextWorkspaceKey;
+    
+    // Snapshots of the workspaces
+    std::unique_ptr<Rendering::WorkspaceSnapshots> m_snapshots;
+    
+    // Shared memory buffers uploaded into the engine's context for the passes
+    struct BufferTexture {
+        std::shared_ptr<Rendering::RenderTexture> texture;
+        
+        // Damage in buffer pixels since the last upload
+        QRegion damage;
+    };
+    QHash<QWaylandSurface *, BufferTexture> m_bufferTextures;
+    
+    // Surfaces of the active workspace that haven't drawn since the switch
+    QSet<QWaylandSurface *> m_catchingUp;
+    
+    // Stops waiting for them; restarted by every switch
+    QTimer *m_catchUpTimer;
+    
+    // Fires when the next snapshot is due
+    QTimer *m_snapshotTimer;
+    
+    // Start of the last snapshot pass, CLOCK_MONOTONIC nanoseconds
+    qint64 m_lastSnapshotPass;
+    
+    // Paces the frame callbacks of hidden surfaces
+    QTimer *m_backgroundFrameTimer;
+    
+    // Surfaces hidden other than by their workspace
+    QSet<QWaylandSurface *> m_hiddenSurfaces;
+    
+    // Release policy for the buffers of hidden toplevel surfaces
+    std::unique_ptr<Rendering::BufferResidency> m_residency;
+    
+    // Fires when the next hidden surface is due for release
+    QTimer *m_residencyTimer;
+    
+    // Start of the last release pass, CLOCK_MONOTONIC nanoseconds
+    qint64 m_lastResidencyPass;
+    
+    // Geometry animations, evaluated once per frame
+    std::unique_ptr<Rendering::GeometryAnimator> m_animator;
+    
+    // Whether a view draws the animations
+    bool m_animationsEnabled;
+    
+    // Resources held by each client
+    std::unique_ptr<Rendering::ClientAccounting> m_clientAccounting;
+    
+    // Measures the clients periodically
+    QTimer *m_accountingTimer;
+    
+    // libwayland listeners for clients connecting, and for the objects and disconnection of each client
+    struct DisplayListener;
+    struct ClientListener;
+    std::unique_ptr<DisplayListener> m_displayListener;
+    QHash<wl_client *, ClientListener *> m_clientListeners;
+    
     // Connect signals from the compositor
     void connectSignals();
     
@@ -266,6 +891,59 @@ private:
     // Handle surface events
     void handleSurfaceCreated(QWaylandSurface *surface);
     void handleSurfaceDestroyed(QWaylandSurface *surface);
+    
+    // Repaint the outputs showing a surface, or only its visible part unless wholeSurface is set
+    void damageSurface(QWaylandSurface *surface, bool wholeSurface);
+    
+    // The shown surfaces with content, topmost first
+    QVector<OcclusionCuller::Surface> stackingFrontToBack() const;
+    
+    // The surface taking input at a global position, and the position relative to it
+    QWaylandSurface *surfaceAt(const QPointF &pos, QPointF *localPos) const;
+    
+    // Thumbnail bookkeeping
+    void trackThumbnail(QWaylandSurface *surface);
+    void armThumbnailTimer();
+    void updateThumbnails();
+    void drawThumbnails();
+    
+    // View holding the current buffer of a surface while thumbnails are active, if any
+    QWaylandView *bufferView(QWaylandSurface *surface) const;
+    QWaylandView *createBufferView(QWaylandSurface *surface);
+    
+    // Upload a view's current buffer into the engine's context; 0 for buffers that can't be
+    uint importBuffer(QWaylandSurface *surface, QWaylandView *view);
+    void releaseBufferTexture(QWaylandSurface *surface);
+    
+    // Workspace bookkeeping
+    quint64 workspaceKey(const QString &workspace);
+    void damageWorkspace(QWaylandSurface *surface);
+    void surfaceCaughtUp(QWaylandSurface *surface);
+    void catchUpTimedOut();
+    void armSnapshotTimer();
+    void updateWorkspaceSnapshots();
+    void updateBackgroundFrameTimer();
+    void sendBackgroundFrameCallbacks();
+    
+    // Buffer residency of hidden surfaces
+    void trackResidency(QWaylandSurface *surface);
+    void updateResidency(QWaylandSurface *surface);
+    void armResidencyTimer();
+    void releaseHiddenBuffers();
+    void releaseSurfaceBuffers(QWaylandSurface *surface);
+    void restoreSurfaceBuffers(QWaylandSurface *surface);
+    
+    // Geometry animation
+    void damageRect(const QRect &rect);
+    
+    // Client accounting
+    void trackClient(wl_client *client);
+    void untrackClient(ClientListener *listener);
+    void accountClients();
+    void disconnectClient(wl_client *client);
+    static void handleClientCreated(wl_listener *listener, void *data);
+    static void handleClientDestroyed(wl_listener *listener, void *data);
+    static void handleResourceCreated(wl_listener *listener, void *data);
 };
 
 } // namespace VivoX::Compositor
@@ -1,9 +1,13 @@
 #include "VivoXSystem.h"
+#include "system/applications/ProcessLauncher.h"
 
 #include <QDebug>
 
 int main(int argc, char *argv[])
 {
+    // Fork the application spawn helper while the process is still small and single-threaded
+    VivoX::System::ProcessLauncher::prewarm();
+
     // Set up logging
     qSetMessagePattern("[%{time yyyy-MM-dd hh:mm:ss.zzz}] [%{type}] %{message}");
 
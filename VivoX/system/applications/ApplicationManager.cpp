@@ -1,31 +1,53 @@
 #include "ApplicationManager.h"
+#include "DesktopEntryIndex.h"
+#include "ProcessLauncher.h"
 
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QSettings>
 #include <QStandardPaths>
-#include <QProcess>
+#include <QProcessEnvironment>
 #include <QRegularExpression>
 
 namespace VivoX::System {
 
+namespace {
+// Spacing of the last-use times given to migrated recent applications
+const qint64 MigratedRecentSpacing = 60 * 1000;
+
+// Launch latencies kept per application
+const int MaxLatencySamples = 32;
+
+// Terminal emulators tried when $TERMINAL is not set, in order
+const QStringList TerminalEmulators = {
+    "x-terminal-emulator", "foot", "alacritty", "kitty", "konsole", "gnome-terminal", "xterm"
+};
+} // namespace
+
 ApplicationManager::ApplicationManager(QObject *parent)
     : QObject(parent)
+    , m_desktopEntries(new DesktopEntryIndex(this))
+    , m_usage(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation)
+              + QStringLiteral("/vivox/application-usage.log"))
+    , m_launcher(new ProcessLauncher(this))
 {
     qDebug() << "ApplicationManager created";
 }
 
 ApplicationManager::~ApplicationManager()
 {
-    // Save application usage statistics
-    saveApplicationUsage();
-    
     qDebug() << "ApplicationManager destroyed";
 }
 
 bool ApplicationManager::initialize()
 {
+    connect(m_desktopEntries, &DesktopEntryIndex::entriesChanged,
+            this, &ApplicationManager::handleEntriesChanged);
+    connect(m_launcher, &ProcessLauncher::finished,
+            this, &ApplicationManager::handleProcessFinished);
+    
     // Discover installed applications
     discoverApplications();
     
@@ -59,6 +81,11 @@ ApplicationInfo ApplicationManager::getApplicationInfo(const QString &id) const
     return m_applications.value(id, ApplicationInfo());
 }
 
+void ApplicationManager::setWaylandDisplay(const QString &display)
+{
+    m_waylandDisplay = display;
+}
+
 qint64 ApplicationManager::launchApplication(const QString &id, const QStringList &args)
 {
     if (!m_applications.contains(id)) {
@@ -69,40 +96,42 @@ qint64 ApplicationManager::launchApplication(const QString &id, const QStringLis
     const ApplicationInfo &info = m_applications[id];
     
     // Combine default arguments with additional arguments
+    QString program = info.executable;
     QStringList allArgs = info.args;
     allArgs.append(args);
     
-    qint64 pid = 0;
-    
     if (info.terminal) {
         // Launch in terminal
-        QString terminal = "x-terminal-emulator";
-        QStringList terminalArgs;
-        terminalArgs << "-e" << info.executable;
-        terminalArgs.append(allArgs);
-        
-        if (!QProcess::startDetached(terminal, terminalArgs, QString(), &pid)) {
-            qWarning() << "Failed to launch application in terminal:" << id;
-            return 0;
-        }
-    } else {
-        // Launch directly
-        if (!QProcess::startDetached(info.executable, allArgs, QString(), &pid)) {
-            qWarning() << "Failed to launch application:" << id;
+        const QString terminal = terminalEmulator();
+        if (terminal.isEmpty()) {
+            qWarning() << "No terminal emulator found to launch:" << id;
             return 0;
         }
+        allArgs.prepend(program);
+        allArgs.prepend("-e");
+        program = terminal;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    const qint64 pid = m_launcher->launch(program, allArgs, launchEnvironment(info), id);
+    if (pid == 0) {
+        qWarning() << "Failed to launch application:" << id;
+        return 0;
     }
     
     // Update application usage statistics
     updateApplicationUsage(id);
     
-    // Add to running applications
+    // Add to running applications and wait for the first frame
     m_runningApplications[pid] = id;
+    m_pendingLaunches[id] = timer;
     
     // Emit signal
     emit applicationLaunched(id, pid);
     
-    qDebug() << "Launched application:" << id << "with PID:" << pid;
+    qDebug() << "Launched application:" << id << "with PID:" << pid << "in" << timer.nsecsElapsed() / 1000 << "us";
     
     return pid;
 }
@@ -111,139 +140,169 @@ QList<ApplicationInfo> ApplicationManager::searchApplications(const QString &que
 {
     QList<ApplicationInfo> result;
     
-    if (query.isEmpty()) {
-        return result;
+    // The index ignores punctuation, so any query is safe
+    for (const ApplicationSearchIndex::Result &hit : m_searchIndex.search(query)) {
+        result.append(m_applications.value(hit.id));
     }
     
-    QRegularExpression regex(query, QRegularExpression::CaseInsensitiveOption);
+    return result;
+}
+
+QList<ApplicationInfo> ApplicationManager::getRecentApplications(int count) const
+{
+    QList<ApplicationInfo> result;
     
-    for (const ApplicationInfo &info : m_applications.values()) {
-        if (info.name.contains(regex) || info.description.contains(regex)) {
-            result.append(info);
-        }
+    auto installed = [this](const QString &id) { return m_applications.contains(id); };
+    for (const QString &id : m_usage.mostRecent(count, installed)) {
+        result.append(m_applications.value(id));
     }
     
     return result;
 }
 
-QList<ApplicationInfo> ApplicationManager::getRecentApplications(int count) const
+QList<ApplicationInfo> ApplicationManager::getFrequentApplications(int count) const
 {
     QList<ApplicationInfo> result;
     
-    for (const QString &id : m_recentApplications) {
-        if (m_applications.contains(id)) {
-            result.append(m_applications[id]);
-            
-            if (result.size() >= count) {
-                break;
-            }
-        }
+    // Ranked by frecency, so applications used a lot long ago fade out
+    auto installed = [this](const QString &id) { return m_applications.contains(id); };
+    for (const QString &id : m_usage.topFrecent(count, installed)) {
+        result.append(m_applications.value(id));
     }
     
     return result;
 }
 
-QList<ApplicationInfo> ApplicationManager::getFrequentApplications(int count) const
+void ApplicationManager::notifySurfaceCommitted(qint64 pid)
 {
-    // Create a list of application IDs sorted by usage count
-    QList<QPair<QString, int>> sortedUsage;
+    if (m_pendingLaunches.isEmpty()) {
+        return;
+    }
     
-    for (auto it = m_applicationUsage.begin(); it != m_applicationUsage.end(); ++it) {
-        if (m_applications.contains(it.key())) {
-            sortedUsage.append(qMakePair(it.key(), it.value()));
-        }
+    // Wrapper scripts and single-instance helpers fork, so fall back to the cgroup
+    QString id = m_runningApplications.value(pid);
+    if (id.isEmpty()) {
+        id = m_launcher->groupOf(pid);
     }
     
-    // Sort by usage count (descending)
-    std::sort(sortedUsage.begin(), sortedUsage.end(), 
-        [](const QPair<QString, int> &a, const QPair<QString, int> &b) {
-            return a.second > b.second;
-        });
+    auto it = m_pendingLaunches.find(id);
+    if (id.isEmpty() || it == m_pendingLaunches.end()) {
+        return;
+    }
     
-    // Create result list
-    QList<ApplicationInfo> result;
+    const qint64 latency = it->elapsed();
+    m_pendingLaunches.erase(it);
     
-    for (const auto &pair : sortedUsage) {
-        result.append(m_applications[pair.first]);
-        
-        if (result.size() >= count) {
-            break;
-        }
+    QList<qint64> &latencies = m_launchLatencies[id];
+    latencies.append(latency);
+    while (latencies.size() > MaxLatencySamples) {
+        latencies.removeFirst();
     }
     
-    return result;
+    qDebug() << "Application" << id << "committed its first surface after" << latency << "ms";
+    
+    emit applicationReady(id, latency);
+}
+
+QList<qint64> ApplicationManager::getLaunchLatencies(const QString &id) const
+{
+    return m_launchLatencies.value(id);
 }
 
 void ApplicationManager::discoverApplications()
 {
     // Clear existing applications
     m_applications.clear();
+    m_searchIndex.clear();
     
-    // Get application directories
-    QStringList appDirs = QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation);
+    // Cached entries load without parsing; only changed files are read
+    m_desktopEntries->load();
     
-    // Add system application directories
-    appDirs << "/usr/share/applications" << "/usr/local/share/applications";
-    
-    // Find .desktop files
-    for (const QString &dirPath : appDirs) {
-        QDir dir(dirPath);
-        
-        if (!dir.exists()) {
-            continue;
-        }
-        
-        QStringList desktopFiles = dir.entryList(QStringList() << "*.desktop", QDir::Files);
-        
-        for (const QString &file : desktopFiles) {
-            QString filePath = dir.filePath(file);
-            
-            ApplicationInfo info;
-            if (parseDesktopFile(filePath, info)) {
-                m_applications[info.id] = info;
-            }
+    for (const DesktopEntry &entry : m_desktopEntries->entries()) {
+        ApplicationInfo info;
+        if (applicationInfoFor(entry, info)) {
+            m_applications[info.id] = info;
+            m_searchIndex.insert(searchDocumentFor(entry, info));
         }
     }
+    updateSearchUsage();
     
     qDebug() << "Discovered" << m_applications.size() << "applications";
     
     emit applicationsChanged();
 }
 
-bool ApplicationManager::parseDesktopFile(const QString &path, ApplicationInfo &info)
+void ApplicationManager::handleEntriesChanged(const QStringList &ids)
 {
-    QSettings settings(path, QSettings::IniFormat);
-    settings.beginGroup("Desktop Entry");
+    for (const QString &id : ids) {
+        const DesktopEntry entry = m_desktopEntries->entry(id);
+        ApplicationInfo info;
+        if (m_desktopEntries->contains(id) && applicationInfoFor(entry, info)) {
+            m_applications[id] = info;
+            m_searchIndex.insert(searchDocumentFor(entry, info));
+        } else {
+            m_applications.remove(id);
+            m_searchIndex.remove(id);
+        }
+    }
+    updateSearchUsage();
     
-    // Check if this is an application
-    QString type = settings.value("Type").toString();
-    if (type != "Application") {
-        return false;
+    emit applicationsChanged();
+}
+
+void ApplicationManager::handleProcessFinished(qint64 pid, int exitCode)
+{
+    const QString id = m_runningApplications.take(pid);
+    if (id.isEmpty()) {
+        return;
+    }
+    
+    // Exited without ever showing a surface, unless another instance is still starting
+    if (!m_runningApplications.values().contains(id)) {
+        m_pendingLaunches.remove(id);
     }
     
-    // Check if the application should be hidden
-    bool noDisplay = settings.value("NoDisplay", false).toBool();
-    if (noDisplay) {
+    emit applicationFinished(id, exitCode);
+}
+
+bool ApplicationManager::applicationInfoFor(const DesktopEntry &entry, ApplicationInfo &info)
+{
+    // Check if this is an application that should be shown
+    if (!entry.isVisibleApplication()) {
         return false;
     }
     
+    // Respect OnlyShowIn/NotShowIn against the current desktop
+    const QStringList desktops = qEnvironmentVariable("XDG_CURRENT_DESKTOP").split(':', Qt::SkipEmptyParts);
+    if (!entry.onlyShowIn.isEmpty()) {
+        bool shown = false;
+        for (const QString &desktop : desktops) {
+            shown = shown || entry.onlyShowIn.contains(desktop);
+        }
+        if (!shown) {
+            return false;
+        }
+    }
+    for (const QString &desktop : desktops) {
+        if (entry.notShowIn.contains(desktop)) {
+            return false;
+        }
+    }
+    
     // Get application information
-    info.name = settings.value("Name").toString();
-    info.description = settings.value("Comment").toString();
-    info.executable = settings.value("Exec").toString();
-    info.iconName = settings.value("Icon").toString();
-    info.categories = settings.value("Categories").toString().split(';', Qt::SkipEmptyParts);
-    info.terminal = settings.value("Terminal", false).toBool();
-    info.desktopFile = path;
-    
-    // Generate ID from desktop file name
-    QFileInfo fileInfo(path);
-    info.id = fileInfo.completeBaseName();
+    info.id = entry.id;
+    info.name = entry.name;
+    info.description = entry.comment;
+    info.executable = entry.exec;
+    info.iconName = entry.icon;
+    info.categories = entry.categories;
+    info.terminal = entry.terminal;
+    info.desktopFile = entry.path;
     
     // Parse executable and arguments
     if (!info.executable.isEmpty()) {
         // Remove field codes (%f, %F, %u, %U, etc.)
-        QRegularExpression fieldCodeRegex("%[fFuUdDnNickvm]");
+        static const QRegularExpression fieldCodeRegex("%[fFuUdDnNickvm]");
         info.executable = info.executable.remove(fieldCodeRegex);
         
         // Split into executable and arguments
@@ -259,67 +318,98 @@ bool ApplicationManager::parseDesktopFile(const QString &path, ApplicationInfo &
         info.icon = QIcon::fromTheme(info.iconName);
     }
     
-    settings.endGroup();
-    
     return !info.name.isEmpty() && !info.executable.isEmpty();
 }
 
-void ApplicationManager::updateApplicationUsage(const QString &id)
+ApplicationSearchIndex::Document ApplicationManager::searchDocumentFor(const DesktopEntry &entry, const ApplicationInfo &info)
 {
-    // Update usage count
-    m_applicationUsage[id] = m_applicationUsage.value(id, 0) + 1;
-    
-    // Update recent applications list
-    m_recentApplications.removeAll(id);
-    m_recentApplications.prepend(id);
-    
-    // Limit recent applications list to 100 items
-    while (m_recentApplications.size() > 100) {
-        m_recentApplications.removeLast();
+    ApplicationSearchIndex::Document document;
+    document.id = info.id;
+    document.name = info.name;
+    document.untranslatedName = entry.untranslatedName;
+    document.genericName = entry.genericName;
+    document.keywords = entry.keywords;
+    document.executable = QFileInfo(info.executable).fileName();
+    document.comment = entry.comment;
+    document.categories = entry.categories;
+    return document;
+}
+
+void ApplicationManager::updateSearchUsage()
+{
+    for (auto it = m_applications.constBegin(); it != m_applications.constEnd(); ++it) {
+        m_searchIndex.setUsageScore(it.key(), m_usage.relativeScore(it.key()));
     }
 }
 
-void ApplicationManager::loadApplicationUsage()
+QStringList ApplicationManager::launchEnvironment(const ApplicationInfo &info) const
 {
-    // Clear existing data
-    m_recentApplications.clear();
-    m_applicationUsage.clear();
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    
+    // Applications are clients of this compositor, whatever backend it runs on itself
+    if (!m_waylandDisplay.isEmpty()) {
+        environment.insert("WAYLAND_DISPLAY", m_waylandDisplay);
+        environment.insert("XDG_SESSION_TYPE", "wayland");
+        environment.insert("QT_QPA_PLATFORM", "wayland;xcb");
+        environment.insert("GDK_BACKEND", "wayland,x11");
+        environment.insert("MOZ_ENABLE_WAYLAND", "1");
+    }
     
-    // Load from settings
-    QSettings settings("VivoX", "ApplicationManager");
+    if (!info.desktopFile.isEmpty()) {
+        environment.insert("GIO_LAUNCHED_DESKTOP_FILE", info.desktopFile);
+    }
     
-    // Load recent applications
-    m_recentApplications = settings.value("RecentApplications").toStringList();
+    return environment.toStringList();
+}
+
+QString ApplicationManager::terminalEmulator()
+{
+    const QString configured = qEnvironmentVariable("TERMINAL");
+    if (!configured.isEmpty() && !QStandardPaths::findExecutable(configured).isEmpty()) {
+        return configured;
+    }
     
-    // Load application usage
-    settings.beginGroup("ApplicationUsage");
-    QStringList keys = settings.childKeys();
-    for (const QString &key : keys) {
-        m_applicationUsage[key] = settings.value(key).toInt();
+    for (const QString &terminal : TerminalEmulators) {
+        if (!QStandardPaths::findExecutable(terminal).isEmpty()) {
+            return terminal;
+        }
     }
-    settings.endGroup();
     
-    qDebug() << "Loaded application usage statistics:" 
-             << m_recentApplications.size() << "recent," 
-             << m_applicationUsage.size() << "usage counts";
+    return QString();
 }
 
-void ApplicationManager::saveApplicationUsage()
+void ApplicationManager::updateApplicationUsage(const QString &id)
 {
-    // Save to settings
-    QSettings settings("VivoX", "ApplicationManager");
+    // Appended to the usage log right away
+    m_usage.recordUse(id);
     
-    // Save recent applications
-    settings.setValue("RecentApplications", m_recentApplications);
+    updateSearchUsage();
+}
+
+void ApplicationManager::loadApplicationUsage()
+{
+    m_usage.load();
     
-    // Save application usage
-    settings.beginGroup("ApplicationUsage");
-    for (auto it = m_applicationUsage.begin(); it != m_applicationUsage.end(); ++it) {
-        settings.setValue(it.key(), it.value());
+    // Carry over statistics kept in the settings by earlier versions
+    QSettings settings("VivoX", "ApplicationManager");
+    if (m_usage.isEmpty() && settings.childGroups().contains("ApplicationUsage")) {
+        const QStringList recent = settings.value("RecentApplications").toStringList();
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        
+        settings.beginGroup("ApplicationUsage");
+        for (const QString &id : settings.childKeys()) {
+            // Applications missing from the recent list count as used just before it
+            const int rank = recent.contains(id) ? recent.indexOf(id) : recent.size();
+            m_usage.seed(id, settings.value(id).toInt(), now - rank * MigratedRecentSpacing);
+        }
+        settings.endGroup();
     }
-    settings.endGroup();
+    settings.remove("ApplicationUsage");
+    settings.remove("RecentApplications");
+    
+    updateSearchUsage();
     
-    qDebug() << "Saved application usage statistics";
+    qDebug() << "Loaded application usage statistics";
 }
 
 } // namespace VivoX::System
@@ -1,14 +1,22 @@
 #pragma once
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QList>
 #include <QString>
 #include <QIcon>
 #include <QProcess>
 
+#include "ApplicationSearchIndex.h"
+#include "FrecencyStore.h"
+
 namespace VivoX::System {
 
+class DesktopEntryIndex;
+class ProcessLauncher;
+struct DesktopEntry;
+
 /**
  * @brief The ApplicationInfo class contains information about an application.
  */
@@ -30,7 +38,9 @@ public:
  * @brief The ApplicationManager class manages applications and their launching.
  * 
  * It is responsible for discovering installed applications, providing information
- * about them, and launching them.
+ * about them, and launching them. Installed applications come from a
+ * DesktopEntryIndex, which caches parsed desktop entries and keeps them up
+ * to date as files change.
  */
 class ApplicationManager : public QObject {
     Q_OBJECT
@@ -65,8 +75,18 @@ public:
      */
     ApplicationInfo getApplicationInfo(const QString &id) const;
 
+    /**
+     * @brief Set the Wayland display launched applications connect to
+     * @param display The socket name
+     */
+    void setWaylandDisplay(const QString &display);
+
     /**
      * @brief Launch an application
+     * 
+     * The application runs in its own cgroup when possible. The time until
+     * it commits its first surface is recorded, see notifySurfaceCommitted().
+     * 
      * @param id The application ID
      * @param args Additional arguments to pass to the application
      * @return The process ID if successful, 0 otherwise
@@ -75,8 +95,13 @@ public:
 
     /**
      * @brief Search for applications
-     * @param query The search query
-     * @return List of matching application info objects
+     * 
+     * Matches names, generic names, keywords, executables and comments,
+     * ranked by match quality and how often and recently each application
+     * was launched.
+     * 
+     * @param query The search query as typed by the user
+     * @return List of matching application info objects, best match first
      */
     QList<ApplicationInfo> searchApplications(const QString &query) const;
 
@@ -94,6 +119,24 @@ public:
      */
     QList<ApplicationInfo> getFrequentApplications(int count = 10) const;
 
+    /**
+     * @brief Report that a client committed a surface
+     * 
+     * The first commit after a launch completes its launch latency
+     * measurement. Clients forked by a launched application are attributed
+     * to it through its cgroup.
+     * 
+     * @param pid The process ID of the client
+     */
+    void notifySurfaceCommitted(qint64 pid);
+
+    /**
+     * @brief Get the recent launch latencies of an application
+     * @param id The application ID
+     * @return Milliseconds from launch to first surface commit, oldest first
+     */
+    QList<qint64> getLaunchLatencies(const QString &id) const;
+
 signals:
     /**
      * @brief Signal emitted when the list of applications has changed
@@ -114,33 +157,68 @@ signals:
      */
     void applicationFinished(const QString &id, int exitCode);
 
+    /**
+     * @brief Signal emitted when a launched application committed its first surface
+     * @param id The application ID
+     * @param latency Milliseconds since the launch
+     */
+    void applicationReady(const QString &id, qint64 latency);
+
+private slots:
+    void handleEntriesChanged(const QStringList &ids);
+    void handleProcessFinished(qint64 pid, int exitCode);
+
 private:
+    // Index of installed desktop entries
+    DesktopEntryIndex *m_desktopEntries;
+    
     // Map of application ID to application info
     QHash<QString, ApplicationInfo> m_applications;
     
-    // List of recently used application IDs
-    QList<QString> m_recentApplications;
+    // Search index over the applications
+    ApplicationSearchIndex m_searchIndex;
     
-    // Map of application ID to usage count
-    QHash<QString, int> m_applicationUsage;
+    // Frecency of launched applications, persisted as they launch
+    FrecencyStore m_usage;
+    
+    // Spawns applications and reports their exit
+    ProcessLauncher *m_launcher;
     
     // Map of running application processes
     QHash<qint64, QString> m_runningApplications;
     
+    // Launches waiting for their first surface commit, by application ID
+    QHash<QString, QElapsedTimer> m_pendingLaunches;
+    
+    // Recent launch-to-first-commit latencies by application ID
+    QHash<QString, QList<qint64>> m_launchLatencies;
+    
+    // Wayland display for launched applications
+    QString m_waylandDisplay;
+    
     // Discover installed applications
     void discoverApplications();
     
-    // Parse a .desktop file
-    bool parseDesktopFile(const QString &path, ApplicationInfo &info);
+    // Build application info from a desktop entry
+    static bool applicationInfoFor(const DesktopEntry &entry, ApplicationInfo &info);
+    
+    // Build the searchable fields of an application
+    static ApplicationSearchIndex::Document searchDocumentFor(const DesktopEntry &entry, const ApplicationInfo &info);
+    
+    // Rank applications in search results by usage
+    void updateSearchUsage();
+    
+    // Environment for a launched application
+    QStringList launchEnvironment(const ApplicationInfo &info) const;
+    
+    // Find a terminal emulator for terminal applications
+    static QString terminalEmulator();
     
     // Update application usage statistics
     void updateApplicationUsage(const QString &id);
     
     // Load application usage statistics
     void loadApplicationUsage();
-    
-    // Save application usage statistics
-    void saveApplicationUsage();
 };
 
 } // namespace VivoX::System
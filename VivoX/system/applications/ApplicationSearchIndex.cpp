@@ -0,0 +1,375 @@
+#include "ApplicationSearchIndex.h"
+
+#include <algorithm>
+
+namespace VivoX::System {
+
+namespace {
+// Weight of a match in each field
+const float NameWeight = 1.0f;
+const float UntranslatedNameWeight = 0.9f;
+const float GenericNameWeight = 0.8f;
+const float KeywordWeight = 0.7f;
+const float ExecutableWeight = 0.6f;
+const float CommentWeight = 0.3f;
+const float CategoryWeight = 0.3f;
+
+// Bonus for matching the first word of the name
+const double LeadingBonus = 0.2;
+
+// Query tokens shorter than this only match token prefixes
+const int FuzzyMinLength = 3;
+
+// How much a usage score of 1 raises the text score
+const double UsageWeight = 0.5;
+
+bool lessChild(const QPair<QChar, int> &child, QChar c)
+{
+    return child.first < c;
+}
+
+// Check if every application matching the current query also matched the previous one
+bool narrows(const QStringList &previous, const QStringList &current)
+{
+    if (current.size() < previous.size()) {
+        return false;
+    }
+    for (int i = 0; i < previous.size(); ++i) {
+        if (!current[i].startsWith(previous[i])) {
+            return false;
+        }
+        // A token that just became long enough for fuzzy matching can match more
+        if (previous[i].size() < FuzzyMinLength && current[i].size() >= FuzzyMinLength) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+ApplicationSearchIndex::ApplicationSearchIndex()
+    : m_nodes(1)
+    , m_lastValid(false)
+{
+}
+
+void ApplicationSearchIndex::insert(const Document &document)
+{
+    // Replacing an application keeps its usage
+    double usage = 0.0;
+    if (m_slots.contains(document.id)) {
+        usage = m_entries[m_slots.value(document.id)].usage;
+        remove(document.id);
+    }
+
+    int slot;
+    if (!m_freeSlots.isEmpty()) {
+        slot = m_freeSlots.takeLast();
+    } else {
+        slot = m_entries.size();
+        m_entries.append(Entry());
+    }
+
+    Entry &entry = m_entries[slot];
+    entry.id = document.id;
+    entry.name = document.name;
+    entry.usage = usage;
+    entry.used = true;
+
+    const QStringList nameTokens = tokenize(document.name);
+    for (int i = 0; i < nameTokens.size(); ++i) {
+        addToken(entry, nameTokens[i], NameWeight, i == 0);
+    }
+    for (const QString &token : tokenize(document.untranslatedName)) {
+        addToken(entry, token, UntranslatedNameWeight);
+    }
+    for (const QString &token : tokenize(document.genericName)) {
+        addToken(entry, token, GenericNameWeight);
+    }
+    for (const QString &token : tokenize(document.keywords.join(' '))) {
+        addToken(entry, token, KeywordWeight);
+    }
+    for (const QString &token : tokenize(document.executable)) {
+        addToken(entry, token, ExecutableWeight);
+    }
+    for (const QString &token : tokenize(document.comment)) {
+        addToken(entry, token, CommentWeight);
+    }
+    for (const QString &token : tokenize(document.categories.join(' '))) {
+        addToken(entry, token, CategoryWeight);
+    }
+
+    // Add the tokens to the trie; nodes are addressed by index as the vector grows
+    for (const Token &token : entry.tokens) {
+        int node = 0;
+        for (const QChar c : token.text) {
+            int child = childOf(node, c);
+            if (child < 0) {
+                child = m_nodes.size();
+                m_nodes.append(TrieNode());
+                QVector<QPair<QChar, int>> &children = m_nodes[node].children;
+                children.insert(std::lower_bound(children.begin(), children.end(), c, lessChild),
+                                qMakePair(c, child));
+            }
+            node = child;
+        }
+        m_nodes[node].entries.append(slot);
+    }
+
+    m_slots.insert(document.id, slot);
+    m_lastValid = false;
+}
+
+void ApplicationSearchIndex::remove(const QString &id)
+{
+    auto it = m_slots.find(id);
+    if (it == m_slots.end()) {
+        return;
+    }
+
+    const int slot = it.value();
+    m_slots.erase(it);
+
+    // Emptied trie nodes are left in place and reused by later insertions
+    for (const Token &token : m_entries[slot].tokens) {
+        const int node = findNode(token.text);
+        if (node >= 0) {
+            m_nodes[node].entries.removeOne(slot);
+        }
+    }
+
+    m_entries[slot] = Entry();
+    m_freeSlots.append(slot);
+    m_lastValid = false;
+}
+
+void ApplicationSearchIndex::clear()
+{
+    m_entries.clear();
+    m_freeSlots.clear();
+    m_slots.clear();
+    m_nodes = QVector<TrieNode>(1);
+    m_lastValid = false;
+}
+
+int ApplicationSearchIndex::size() const
+{
+    return m_slots.size();
+}
+
+void ApplicationSearchIndex::setUsageScore(const QString &id, double score)
+{
+    auto it = m_slots.constFind(id);
+    if (it != m_slots.constEnd()) {
+        // Usage only changes the ranking, not which applications match
+        m_entries[it.value()].usage = qBound(0.0, score, 1.0);
+    }
+}
+
+QList<ApplicationSearchIndex::Result> ApplicationSearchIndex::search(const QString &query, int limit) const
+{
+    QList<Result> results;
+
+    const QStringList tokens = tokenize(query);
+    if (tokens.isEmpty()) {
+        m_lastValid = false;
+        return results;
+    }
+
+    QVector<int> candidates;
+    if (m_lastValid && narrows(m_lastQuery, tokens)) {
+        // The user typed on: only the previous matches can still match
+        candidates = m_lastMatches;
+    } else {
+        // Short tokens only match by prefix, so the trie yields the exact
+        // candidates; the longest such token has the smallest subtree
+        QString prefix;
+        for (const QString &token : tokens) {
+            if (token.size() < FuzzyMinLength && token.size() > prefix.size()) {
+                prefix = token;
+            }
+        }
+
+        if (!prefix.isEmpty()) {
+            const int node = findNode(prefix);
+            if (node >= 0) {
+                collect(node, candidates);
+                std::sort(candidates.begin(), candidates.end());
+                candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+            }
+        } else {
+            candidates.reserve(m_slots.size());
+            for (int slot : m_slots) {
+                candidates.append(slot);
+            }
+        }
+    }
+
+    struct Hit {
+        double score;
+        int slot;
+    };
+    QVector<Hit> hits;
+    QVector<int> matches;
+    for (int slot : candidates) {
+        const Entry &entry = m_entries[slot];
+        const double textScore = score(entry, tokens);
+        if (textScore < 0.0) {
+            continue;
+        }
+        matches.append(slot);
+        hits.append({ textScore * (1.0 + UsageWeight * entry.usage), slot });
+    }
+
+    m_lastQuery = tokens;
+    m_lastMatches = matches;
+    m_lastValid = true;
+
+    auto better = [this](const Hit &a, const Hit &b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        return m_entries[a.slot].name.localeAwareCompare(m_entries[b.slot].name) < 0;
+    };
+
+    if (limit >= 0 && limit < hits.size()) {
+        std::partial_sort(hits.begin(), hits.begin() + limit, hits.end(), better);
+        hits.resize(limit);
+    } else {
+        std::sort(hits.begin(), hits.end(), better);
+    }
+
+    results.reserve(hits.size());
+    for (const Hit &hit : hits) {
+        results.append({ m_entries[hit.slot].id, hit.score });
+    }
+
+    return results;
+}
+
+QStringList ApplicationSearchIndex::tokenize(const QString &text)
+{
+    QStringList tokens;
+    QString token;
+
+    // Decompose so accents become separate marks that can be dropped
+    const QString decomposed = text.normalized(QString::NormalizationForm_KD);
+    for (const QChar c : decomposed) {
+        if (c.category() == QChar::Mark_NonSpacing) {
+            continue;
+        }
+        if (c.isLetterOrNumber()) {
+            token.append(c.toCaseFolded());
+        } else if (!token.isEmpty()) {
+            tokens.append(token);
+            token.clear();
+        }
+    }
+    if (!token.isEmpty()) {
+        tokens.append(token);
+    }
+
+    return tokens;
+}
+
+void ApplicationSearchIndex::addToken(Entry &entry, const QString &text, float weight, bool leading)
+{
+    for (Token &token : entry.tokens) {
+        if (token.text == text) {
+            token.weight = qMax(token.weight, weight);
+            token.leading = token.leading || leading;
+            return;
+        }
+    }
+    entry.tokens.append({ text, weight, leading });
+}
+
+int ApplicationSearchIndex::findNode(const QString &prefix) const
+{
+    int node = 0;
+    for (const QChar c : prefix) {
+        node = childOf(node, c);
+        if (node < 0) {
+            return -1;
+        }
+    }
+    return node;
+}
+
+int ApplicationSearchIndex::childOf(int node, QChar c) const
+{
+    const QVector<QPair<QChar, int>> &children = m_nodes[node].children;
+    auto it = std::lower_bound(children.begin(), children.end(), c, lessChild);
+    return it != children.end() && it->first == c ? it->second : -1;
+}
+
+void ApplicationSearchIndex::collect(int node, QVector<int> &entries) const
+{
+    QVector<int> stack { node };
+    while (!stack.isEmpty()) {
+        const TrieNode &current = m_nodes[stack.takeLast()];
+        entries.append(current.entries);
+        for (const auto &child : current.children) {
+            stack.append(child.second);
+        }
+    }
+}
+
+double ApplicationSearchIndex::score(const Entry &entry, const QStringList &query) const
+{
+    double total = 0.0;
+
+    // Every query token has to match; each counts with its best match
+    for (const QString &part : query) {
+        double best = 0.0;
+        for (const Token &token : entry.tokens) {
+            double quality = matchQuality(part, token.text);
+            if (quality <= 0.0) {
+                continue;
+            }
+            if (token.leading) {
+                quality += LeadingBonus;
+            }
+            best = qMax(best, quality * token.weight);
+        }
+        if (best <= 0.0) {
+            return -1.0;
+        }
+        total += best;
+    }
+
+    return total / query.size();
+}
+
+double ApplicationSearchIndex::matchQuality(const QString &query, const QString &token)
+{
+    const double coverage = double(query.size()) / token.size();
+
+    // Prefix, with an exact match scoring 1
+    if (token.startsWith(query)) {
+        return 0.7 + 0.3 * coverage;
+    }
+
+    if (query.size() < FuzzyMinLength) {
+        return 0.0;
+    }
+
+    // Inside the token, e.g. "office" in "libreoffice"
+    if (token.contains(query)) {
+        return 0.5 + 0.2 * coverage;
+    }
+
+    // Subsequence, e.g. "thndrbrd" in "thunderbird"
+    int matched = 0;
+    for (const QChar c : token) {
+        if (matched < query.size() && c == query[matched]) {
+            ++matched;
+        }
+    }
+    if (matched < query.size()) {
+        return 0.0;
+    }
+    return 0.2 + 0.2 * coverage;
+}
+
+} // namespace VivoX::System
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace VivoX::System {
+
+/**
+ * @brief Search index for the application launcher.
+ *
+ * Every searchable field of an application (name, untranslated name,
+ * generic name, keywords, executable, comment, categories) is normalized
+ * (case folded, diacritics stripped) and split into tokens, which go into a
+ * prefix trie. A query matches an application when each query token is a
+ * prefix of one of its tokens; query tokens of three or more characters
+ * may also match inside a token or as a subsequence of it, so typos of
+ * omission and CamelCase joins still find the application.
+ *
+ * Matches are scored by match quality and field weight and blended with a
+ * usage score supplied by the caller. While the user keeps typing, each
+ * query only re-checks the applications matched by the previous one.
+ */
+class ApplicationSearchIndex {
+public:
+    /**
+     * @brief The searchable fields of an application
+     */
+    struct Document {
+        QString id;                ///< Application ID
+        QString name;              ///< Localized name
+        QString untranslatedName;  ///< Name without localization
+        QString genericName;       ///< Generic name ("Web Browser")
+        QStringList keywords;      ///< Search keywords
+        QString executable;        ///< Executable name
+        QString comment;           ///< Comment
+        QStringList categories;    ///< Categories
+    };
+
+    /**
+     * @brief A search hit
+     */
+    struct Result {
+        QString id;                ///< Application ID
+        double score = 0.0;        ///< Blended score, higher is better
+    };
+
+    ApplicationSearchIndex();
+
+    /**
+     * @brief Add or replace an application
+     * @param document The searchable fields
+     */
+    void insert(const Document &document);
+
+    /**
+     * @brief Remove an application
+     * @param id The application ID
+     */
+    void remove(const QString &id);
+
+    /**
+     * @brief Remove all applications
+     */
+    void clear();
+
+    /**
+     * @brief Get the number of indexed applications
+     * @return The number of applications
+     */
+    int size() const;
+
+    /**
+     * @brief Set the usage score blended into the ranking
+     * @param id The application ID
+     * @param score The usage score between 0 (never used) and 1 (most used)
+     */
+    void setUsageScore(const QString &id, double score);
+
+    /**
+     * @brief Search the index
+     * @param query The query as typed by the user
+     * @param limit Maximum number of results, or -1 for all
+     * @return The results, best first
+     */
+    QList<Result> search(const QString &query, int limit = -1) const;
+
+    /**
+     * @brief Normalize text for matching and split it into tokens
+     * @param text The text to tokenize
+     * @return The case folded tokens without diacritics
+     */
+    static QStringList tokenize(const QString &text);
+
+private:
+    struct Token {
+        QString text;
+        float weight;
+        bool leading;    // First token of the name
+    };
+
+    struct Entry {
+        QString id;
+        QString name;
+        QVector<Token> tokens;
+        double usage = 0.0;
+        bool used = false;
+    };
+
+    struct TrieNode {
+        QVector<QPair<QChar, int>> children;  // Sorted by character
+        QVector<int> entries;                 // Entries with a token ending here
+    };
+
+    void addToken(Entry &entry, const QString &text, float weight, bool leading = false);
+    int findNode(const QString &prefix) const;
+    int childOf(int node, QChar c) const;
+    void collect(int node, QVector<int> &entries) const;
+
+    // Score an entry against the query tokens, or a negative value if it doesn't match
+    double score(const Entry &entry, const QStringList &query) const;
+    static double matchQuality(const QString &query, const QString &token);
+
+    QVector<Entry> m_entries;
+    QVector<int> m_freeSlots;
+    QHash<QString, int> m_slots;
+    QVector<TrieNode> m_nodes;
+
+    // Tokens and matches of the previous query, for narrowing while typing
+    mutable QStringList m_lastQuery;
+    mutable QVector<int> m_lastMatches;
+    mutable bool m_lastValid;
+};
+
+} // namespace VivoX::System
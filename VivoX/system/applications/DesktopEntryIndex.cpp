@@ -0,0 +1,645 @@
+#include "DesktopEntryIndex.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace VivoX::System {
+
+namespace {
+    const quint32 cacheMagic = 0x56584445; // "VXDE"
+    const quint32 cacheVersion = 1;
+
+    // Package managers touch many files at once; let them finish first
+    const int refreshDelay = 200;
+
+    const uint32_t watchMask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM
+                             | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+    // Locale suffixes to look for, best match first (lang_COUNTRY, lang)
+    const QStringList &localeKeys()
+    {
+        static const QStringList keys = []() {
+            QStringList result;
+            const QString name = QLocale::system().name();
+            if (name != QLatin1String("C")) {
+                result.append(name);
+                const int separator = name.indexOf(QLatin1Char('_'));
+                if (separator > 0) {
+                    result.append(name.left(separator));
+                }
+            }
+            return result;
+        }();
+        return keys;
+    }
+
+    QString unescape(const QString &value)
+    {
+        if (!value.contains(QLatin1Char('\\'))) {
+            return value;
+        }
+
+        QString result;
+        result.reserve(value.size());
+        for (int i = 0; i < value.size(); ++i) {
+            if (value[i] != QLatin1Char('\\') || i + 1 == value.size()) {
+                result.append(value[i]);
+                continue;
+            }
+            switch (value[++i].unicode()) {
+            case 's': result.append(QLatin1Char(' ')); break;
+            case 'n': result.append(QLatin1Char('\n')); break;
+            case 't': result.append(QLatin1Char('\t')); break;
+            case 'r': result.append(QLatin1Char('\r')); break;
+            default: result.append(value[i]); break;
+            }
+        }
+        return result;
+    }
+
+    // Split a list value on unescaped semicolons
+    QStringList splitList(const QString &value)
+    {
+        QStringList result;
+        QString current;
+        for (int i = 0; i < value.size(); ++i) {
+            if (value[i] == QLatin1Char('\\') && i + 1 < value.size()) {
+                current.append(value[i]);
+                current.append(value[++i]);
+            } else if (value[i] == QLatin1Char(';')) {
+                if (!current.isEmpty()) {
+                    result.append(unescape(current));
+                }
+                current.clear();
+            } else {
+                current.append(value[i]);
+            }
+        }
+        if (!current.isEmpty()) {
+            result.append(unescape(current));
+        }
+        return result;
+    }
+
+    void writeEntry(QDataStream &out, const DesktopEntry &entry)
+    {
+        out << entry.path << entry.modified << entry.type << entry.name << entry.untranslatedName
+            << entry.genericName << entry.comment << entry.exec << entry.tryExec << entry.icon
+            << entry.categories << entry.keywords << entry.onlyShowIn << entry.notShowIn
+            << entry.terminal << entry.noDisplay << entry.hidden;
+    }
+
+    void readEntry(QDataStream &in, DesktopEntry &entry)
+    {
+        in >> entry.path >> entry.modified >> entry.type >> entry.name >> entry.untranslatedName
+           >> entry.genericName >> entry.comment >> entry.exec >> entry.tryExec >> entry.icon
+           >> entry.categories >> entry.keywords >> entry.onlyShowIn >> entry.notShowIn
+           >> entry.terminal >> entry.noDisplay >> entry.hidden;
+    }
+
+    QStringList defaultDirectories()
+    {
+        // XDG_DATA_HOME first, then XDG_DATA_DIRS in order
+        QStringList directories;
+        for (const QString &path : QStandardPaths::standardLocations(QStandardPaths::ApplicationsLocation)) {
+            const QString clean = QDir::cleanPath(path);
+            if (!directories.contains(clean)) {
+                directories.append(clean);
+            }
+        }
+        return directories;
+    }
+}
+
+bool DesktopEntry::hasTryExec() const
+{
+    if (tryExec.isEmpty()) {
+        return true;
+    }
+    if (QDir::isAbsolutePath(tryExec)) {
+        return QFileInfo(tryExec).isExecutable();
+    }
+    return !QStandardPaths::findExecutable(tryExec).isEmpty();
+}
+
+DesktopEntryIndex::DesktopEntryIndex(QObject *parent)
+    : DesktopEntryIndex(defaultDirectories(),
+                        QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+                            + QStringLiteral("/vivox/desktop-entries.cache"),
+                        parent)
+{
+}
+
+DesktopEntryIndex::DesktopEntryIndex(const QStringList &directories, const QString &cachePath, QObject *parent)
+    : QObject(parent)
+    , m_cachePath(cachePath)
+    , m_locale(localeKeys().value(0))
+    , m_parsedCount(0)
+    , m_inotify(-1)
+    , m_notifier(nullptr)
+{
+    for (const QString &directory : directories) {
+        m_directories.append(QDir::cleanPath(directory));
+    }
+
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(refreshDelay);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &DesktopEntryIndex::refresh);
+}
+
+DesktopEntryIndex::~DesktopEntryIndex()
+{
+    if (m_inotify >= 0) {
+        close(m_inotify);
+    }
+}
+
+bool DesktopEntryIndex::load()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_files.clear();
+    m_candidates.clear();
+    m_entries.clear();
+
+    if (m_inotify < 0) {
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotify >= 0) {
+            m_notifier = new QSocketNotifier(m_inotify, QSocketNotifier::Read, this);
+            connect(m_notifier, &QSocketNotifier::activated, this, &DesktopEntryIndex::readEvents);
+        } else {
+            qWarning() << "Failed to initialize inotify:" << strerror(errno);
+        }
+    }
+
+    QHash<QString, DesktopEntry> cached;
+    loadCache(cached);
+
+    // Stat every file; only new or modified ones need parsing
+    QHash<QString, qint64> files;
+    for (const QString &directory : std::as_const(m_directories)) {
+        scanDirectory(directory, files);
+    }
+
+    QStringList changed;
+    for (auto it = files.cbegin(); it != files.cend(); ++it) {
+        auto entry = cached.constFind(it.key());
+        if (entry != cached.constEnd() && entry->modified == it.value()) {
+            insertFile(entry.value());
+        } else {
+            changed.append(it.key());
+        }
+    }
+
+    parseFiles(changed);
+    m_parsedCount = changed.size();
+
+    const QStringList ids = m_candidates.keys();
+    for (const QString &id : ids) {
+        resolve(id);
+    }
+
+    // Rewrite the cache if files were added, changed or removed
+    if (!changed.isEmpty() || cached.size() != files.size()) {
+        saveCache();
+    }
+
+    qDebug() << "Loaded" << m_entries.size() << "desktop entries," << m_parsedCount << "parsed, in"
+             << timer.elapsed() << "ms";
+    return true;
+}
+
+QList<DesktopEntry> DesktopEntryIndex::entries() const
+{
+    return m_entries.values();
+}
+
+DesktopEntry DesktopEntryIndex::entry(const QString &id) const
+{
+    return m_entries.value(id);
+}
+
+bool DesktopEntryIndex::contains(const QString &id) const
+{
+    return m_entries.contains(id);
+}
+
+int DesktopEntryIndex::parsedCount() const
+{
+    return m_parsedCount;
+}
+
+bool DesktopEntryIndex::parse(const QString &path, DesktopEntry &entry)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    entry.path = path;
+    entry.modified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+
+    const QStringList &locales = localeKeys();
+    const int unlocalized = locales.size();
+
+    // Locale rank each key was last taken from; lower is a better match
+    QHash<QByteArray, int> ranks;
+    bool inGroup = false;
+    bool found = false;
+
+    const QByteArray data = file.readAll();
+    for (const QByteArray &rawLine : data.split('\n')) {
+        const QByteArray line = rawLine.trimmed();
+
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        if (line.startsWith('[')) {
+            // Only the first group matters; stop once it ends
+            if (found) {
+                break;
+            }
+            inGroup = line == "[Desktop Entry]";
+            found = inGroup;
+            continue;
+        }
+
+        if (!inGroup) {
+            continue;
+        }
+
+        const int separator = line.indexOf('=');
+        if (separator <= 0) {
+            continue;
+        }
+
+        QByteArray key = line.left(separator).trimmed();
+        const QString value = QString::fromUtf8(line.mid(separator + 1).trimmed());
+
+        int rank = unlocalized;
+        const int bracket = key.indexOf('[');
+        if (bracket > 0 && key.endsWith(']')) {
+            rank = locales.indexOf(QString::fromLatin1(key.mid(bracket + 1, key.size() - bracket - 2)));
+            if (rank < 0) {
+                continue;
+            }
+            key.truncate(bracket);
+        } else if (key == "Name") {
+            entry.untranslatedName = unescape(value);
+        }
+
+        auto previous = ranks.constFind(key);
+        if (previous != ranks.constEnd() && previous.value() <= rank) {
+            continue;
+        }
+        ranks.insert(key, rank);
+
+        if (key == "Type") {
+            entry.type = value;
+        } else if (key == "Name") {
+            entry.name = unescape(value);
+        } else if (key == "GenericName") {
+            entry.genericName = unescape(value);
+        } else if (key == "Comment") {
+            entry.comment = unescape(value);
+        } else if (key == "Exec") {
+            entry.exec = unescape(value);
+        } else if (key == "TryExec") {
+            entry.tryExec = unescape(value);
+        } else if (key == "Icon") {
+            entry.icon = unescape(value);
+        } else if (key == "Categories") {
+            entry.categories = splitList(value);
+        } else if (key == "Keywords") {
+            entry.keywords = splitList(value);
+        } else if (key == "OnlyShowIn") {
+            entry.onlyShowIn = splitList(value);
+        } else if (key == "NotShowIn") {
+            entry.notShowIn = splitList(value);
+        } else if (key == "Terminal") {
+            entry.terminal = value == QLatin1String("true");
+        } else if (key == "NoDisplay") {
+            entry.noDisplay = value == QLatin1String("true");
+        } else if (key == "Hidden") {
+            entry.hidden = value == QLatin1String("true");
+        }
+    }
+
+    return found;
+}
+
+void DesktopEntryIndex::readEvents()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+
+    for (;;) {
+        const ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < length;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            const QString directory = m_watches.value(event->wd);
+            if (event->mask & IN_IGNORED) {
+                m_watches.remove(event->wd);
+                continue;
+            }
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost; have every directory looked at again
+                for (const QString &path : std::as_const(m_directories)) {
+                    m_pendingPaths.insert(path);
+                }
+                continue;
+            }
+
+            if (directory.isEmpty()) {
+                continue;
+            }
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                m_pendingPaths.insert(directory);
+                continue;
+            }
+
+            const QString name = QString::fromLocal8Bit(event->name);
+            if ((event->mask & IN_ISDIR) || name.endsWith(QLatin1String(".desktop"))) {
+                m_pendingPaths.insert(directory + QLatin1Char('/') + name);
+            }
+        }
+    }
+
+    if (!m_pendingPaths.isEmpty() && !m_refreshTimer.isActive()) {
+        m_refreshTimer.start();
+    }
+}
+
+void DesktopEntryIndex::refresh()
+{
+    const QSet<QString> paths = std::exchange(m_pendingPaths, {});
+    const QHash<QString, DesktopEntry> before = m_entries;
+
+    QSet<QString> affected;
+    QStringList changed;
+    const QStringList known = m_files.keys();
+
+    for (const QString &path : paths) {
+        const QFileInfo info(path);
+
+        // Forget files that vanished, including everything below a removed directory
+        const QString prefix = path + QLatin1Char('/');
+        for (const QString &file : known) {
+            if ((file == path || file.startsWith(prefix)) && m_files.contains(file) && !QFileInfo::exists(file)) {
+                affected.insert(m_files.value(file).id);
+                removeFile(file);
+            }
+        }
+
+        if (info.isDir()) {
+            // A directory appeared or events were lost: compare its files with the table
+            QHash<QString, qint64> files;
+            scanDirectory(path, files);
+            for (auto it = files.cbegin(); it != files.cend(); ++it) {
+                if (!m_files.contains(it.key()) || m_files.value(it.key()).modified != it.value()) {
+                    changed.append(it.key());
+                }
+            }
+        } else if (info.exists()) {
+            changed.append(path);
+        }
+    }
+
+    parseFiles(changed);
+    m_parsedCount = changed.size();
+
+    for (const QString &path : std::as_const(changed)) {
+        affected.insert(idOf(path));
+    }
+
+    QStringList ids;
+    for (const QString &id : std::as_const(affected)) {
+        resolve(id);
+
+        const bool existed = before.contains(id);
+        const bool exists = m_entries.contains(id);
+        if (existed != exists || (exists && (before.value(id).path != m_entries.value(id).path
+                                            || before.value(id).modified != m_entries.value(id).modified))) {
+            ids.append(id);
+        }
+    }
+
+    if (!changed.isEmpty() || !affected.isEmpty()) {
+        saveCache();
+    }
+
+    if (!ids.isEmpty()) {
+        emit entriesChanged(ids);
+    }
+}
+
+void DesktopEntryIndex::parseFiles(const QStringList &paths)
+{
+    const QList<DesktopEntry> parsed = QtConcurrent::blockingMapped<QList<DesktopEntry>>(paths, [](const QString &path) {
+        DesktopEntry entry;
+        entry.path = path;
+        parse(path, entry);
+        return entry;
+    });
+
+    for (const DesktopEntry &entry : parsed) {
+        insertFile(entry);
+    }
+}
+
+void DesktopEntryIndex::insertFile(const DesktopEntry &entry)
+{
+    DesktopEntry file = entry;
+    file.id = idOf(file.path);
+
+    QStringList &candidates = m_candidates[file.id];
+    if (!candidates.contains(file.path)) {
+        candidates.append(file.path);
+    }
+
+    m_files.insert(file.path, file);
+}
+
+void DesktopEntryIndex::removeFile(const QString &path)
+{
+    const QString id = m_files.take(path).id;
+
+    auto it = m_candidates.find(id);
+    if (it != m_candidates.end()) {
+        it->removeAll(path);
+        if (it->isEmpty()) {
+            m_candidates.erase(it);
+        }
+    }
+}
+
+void DesktopEntryIndex::resolve(const QString &id)
+{
+    // The valid file from the directory with the highest precedence wins
+    const DesktopEntry *winner = nullptr;
+    int winnerRank = m_directories.size();
+
+    for (const QString &path : m_candidates.value(id)) {
+        const DesktopEntry &file = *m_files.constFind(path);
+        const int rank = rankOf(path);
+        if (!file.type.isEmpty() && rank < winnerRank) {
+            winner = &file;
+            winnerRank = rank;
+        }
+    }
+
+    // Hidden=true deletes the ID, masking lower-precedence files too
+    if (winner && !winner->hidden) {
+        m_entries.insert(id, *winner);
+    } else {
+        m_entries.remove(id);
+    }
+}
+
+int DesktopEntryIndex::rankOf(const QString &path) const
+{
+    for (int i = 0; i < m_directories.size(); ++i) {
+        if (path.startsWith(m_directories[i] + QLatin1Char('/'))) {
+            return i;
+        }
+    }
+    return m_directories.size();
+}
+
+QString DesktopEntryIndex::idOf(const QString &path) const
+{
+    const int rank = rankOf(path);
+    QString id = rank < m_directories.size() ? path.mid(m_directories[rank].size() + 1) : QFileInfo(path).fileName();
+
+    id.chop(qstrlen(".desktop"));
+    id.replace(QLatin1Char('/'), QLatin1Char('-'));
+    return id;
+}
+
+void DesktopEntryIndex::scanDirectory(const QString &path, QHash<QString, qint64> &files)
+{
+    if (!QFileInfo(path).isDir()) {
+        return;
+    }
+
+    watchDirectory(path);
+
+    QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+
+        if (info.isDir()) {
+            watchDirectory(info.filePath());
+        } else if (info.fileName().endsWith(QLatin1String(".desktop"))) {
+            files.insert(info.filePath(), info.lastModified().toMSecsSinceEpoch());
+        }
+    }
+}
+
+void DesktopEntryIndex::watchDirectory(const QString &path)
+{
+    if (m_inotify < 0) {
+        return;
+    }
+
+    const int watch = inotify_add_watch(m_inotify, QFile::encodeName(path).constData(), watchMask);
+    if (watch < 0) {
+        qWarning() << "Failed to watch" << path << ":" << strerror(errno);
+        return;
+    }
+
+    m_watches.insert(watch, path);
+}
+
+bool DesktopEntryIndex::loadCache(QHash<QString, DesktopEntry> &entries) const
+{
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return false;
+    }
+
+    // Decode straight from the mapping instead of reading the file into memory
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        return false;
+    }
+
+    const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), file.size());
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString locale;
+    quint32 count = 0;
+    in >> magic >> version >> locale >> count;
+
+    // Localized values depend on the locale the cache was built for
+    if (magic != cacheMagic || version != cacheVersion || locale != m_locale) {
+        return false;
+    }
+
+    entries.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        DesktopEntry entry;
+        readEntry(in, entry);
+        entries.insert(entry.path, entry);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << "Desktop entry cache is corrupt, rebuilding";
+        entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool DesktopEntryIndex::saveCache() const
+{
+    QDir().mkpath(QFileInfo(m_cachePath).absolutePath());
+
+    // Written to a temporary file and renamed, so readers never see a partial cache
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write desktop entry cache:" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << cacheMagic << cacheVersion << m_locale << quint32(m_files.size());
+
+    for (const DesktopEntry &entry : m_files) {
+        writeEntry(out, entry);
+    }
+
+    return file.commit();
+}
+
+} // namespace VivoX::System
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class QSocketNotifier;
+
+namespace VivoX::System {
+
+/**
+ * @brief The parsed [Desktop Entry] group of a .desktop file.
+ */
+struct DesktopEntry {
+    QString id;                ///< Desktop file ID (path below applications/ with '/' replaced by '-')
+    QString path;              ///< Absolute path of the .desktop file
+    qint64 modified = 0;       ///< Modification time of the file in milliseconds since the epoch
+    QString type;              ///< Entry type (Application, Link, Directory)
+    QString name;              ///< Name, localized for the current locale
+    QString untranslatedName;  ///< Name without localization
+    QString genericName;       ///< Generic name, localized
+    QString comment;           ///< Comment, localized
+    QString exec;              ///< Exec line with field codes
+    QString tryExec;           ///< Executable that must exist for the entry to be shown
+    QString icon;              ///< Icon name or path
+    QStringList categories;    ///< Categories
+    QStringList keywords;      ///< Search keywords, localized
+    QStringList onlyShowIn;    ///< Desktops the entry is restricted to
+    QStringList notShowIn;     ///< Desktops the entry is hidden on
+    bool terminal = false;     ///< Whether the application runs in a terminal
+    bool noDisplay = false;    ///< Whether the entry is hidden from menus
+    bool hidden = false;       ///< Whether the entry is deleted (masks lower-precedence files)
+
+    /**
+     * @brief Check if the TryExec executable is installed
+     *
+     * Relative names are looked up in PATH, so this touches the file system.
+     * @return True if the entry has no TryExec or its executable exists
+     */
+    bool hasTryExec() const;
+
+    /**
+     * @brief Check if the entry is a launchable application to show in menus
+     * @return True for visible Application entries whose TryExec executable exists
+     */
+    bool isVisibleApplication() const {
+        return type == QLatin1String("Application") && !noDisplay && !hidden && !exec.isEmpty() && hasTryExec();
+    }
+};
+
+/**
+ * @brief Index of the desktop entries installed on the system.
+ *
+ * The index follows the XDG desktop entry and base directory rules: files
+ * are looked up in the applications directories of XDG_DATA_HOME and
+ * XDG_DATA_DIRS, a file ID found in an earlier directory overrides the same
+ * ID in later ones, and Hidden=true masks an ID altogether.
+ *
+ * Parsed entries are kept in a binary cache keyed by path and modification
+ * time. On load the cache is memory mapped and only files that are new or
+ * changed since are parsed, in parallel. Afterwards the directories are
+ * watched with inotify and changed files are re-read incrementally.
+ */
+class DesktopEntryIndex : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Create an index of the XDG applications directories
+     * @param parent The parent object
+     */
+    explicit DesktopEntryIndex(QObject *parent = nullptr);
+
+    /**
+     * @brief Create an index of specific directories
+     * @param directories The applications directories, in order of precedence
+     * @param cachePath The path of the binary cache file
+     * @param parent The parent object
+     */
+    DesktopEntryIndex(const QStringList &directories, const QString &cachePath, QObject *parent = nullptr);
+    ~DesktopEntryIndex();
+
+    /**
+     * @brief Load the index and start watching the directories
+     * @return True if the index was loaded
+     */
+    bool load();
+
+    /**
+     * @brief Get the entries after precedence resolution
+     * @return List of entries, excluding those masked by Hidden
+     */
+    QList<DesktopEntry> entries() const;
+
+    /**
+     * @brief Get the entry with the given desktop file ID
+     * @param id The desktop file ID without the .desktop suffix
+     * @return The entry, or an empty entry if not found
+     */
+    DesktopEntry entry(const QString &id) const;
+
+    /**
+     * @brief Check if an entry exists
+     * @param id The desktop file ID without the .desktop suffix
+     * @return True if the entry exists and is not hidden
+     */
+    bool contains(const QString &id) const;
+
+    /**
+     * @brief Get the number of files parsed by the last load or refresh
+     * @return The number of parsed files
+     */
+    int parsedCount() const;
+
+    /**
+     * @brief Parse a .desktop file
+     * @param path The path of the file
+     * @param entry The entry to fill
+     * @return True if the file contains a [Desktop Entry] group
+     */
+    static bool parse(const QString &path, DesktopEntry &entry);
+
+signals:
+    /**
+     * @brief Signal emitted when entries were added, changed or removed
+     * @param ids The IDs of the affected entries
+     */
+    void entriesChanged(const QStringList &ids);
+
+private slots:
+    void readEvents();
+    void refresh();
+
+private:
+    // Parse files in parallel and store them in the file table
+    void parseFiles(const QStringList &paths);
+    void insertFile(const DesktopEntry &entry);
+    void removeFile(const QString &path);
+
+    // Recompute which file provides an ID
+    void resolve(const QString &id);
+
+    // Rank of the directory a path belongs to and its desktop file ID
+    int rankOf(const QString &path) const;
+    QString idOf(const QString &path) const;
+
+    void scanDirectory(const QString &path, QHash<QString, qint64> &files);
+    void watchDirectory(const QString &path);
+
+    bool loadCache(QHash<QString, DesktopEntry> &entries) const;
+    bool saveCache() const;
+
+    QStringList m_directories;
+    QString m_cachePath;
+    QString m_locale;
+
+    // All parsed files keyed by path
+    QHash<QString, DesktopEntry> m_files;
+
+    // Paths providing each ID
+    QHash<QString, QStringList> m_candidates;
+
+    // Resolved entries keyed by ID
+    QHash<QString, DesktopEntry> m_entries;
+
+    int m_parsedCount;
+
+    int m_inotify;
+    QSocketNotifier *m_notifier;
+    QHash<int, QString> m_watches;
+
+    // Paths reported by inotify, processed together once events settle
+    QSet<QString> m_pendingPaths;
+    QTimer m_refreshTimer;
+};
+
+} // namespace VivoX::System
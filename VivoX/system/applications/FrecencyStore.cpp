@@ -0,0 +1,281 @@
+#include "FrecencyStore.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <cmath>
+
+namespace VivoX::System {
+
+namespace {
+const QByteArray LogHeader = "VXFR 1";
+
+// Scores are scaled to this time (2020-01-01 UTC) so they stay comparable across runs
+const qint64 Epoch = 1577836800000;
+
+// The log is compacted once it holds this many records and twice as many as applications
+const int MinCompactRecords = 64;
+
+// Applications below this score are dropped on compaction
+const double NegligibleScore = 0.01;
+
+// Relative scores cover applications used up to this factor less than the top one
+const double RelativeRange = std::log(1000.0);
+
+const qint64 MillisecondsPerDay = 24 * 60 * 60 * 1000;
+
+// log(exp(a) + exp(b)) without overflow
+double logAdd(double a, double b)
+{
+    return a > b ? a + std::log1p(std::exp(b - a)) : b + std::log1p(std::exp(a - b));
+}
+} // namespace
+
+FrecencyStore::FrecencyStore(const QString &path, double halfLifeDays)
+    : m_path(path)
+    , m_decay(std::log(2.0) / (halfLifeDays * MillisecondsPerDay))
+    , m_logSize(0)
+{
+}
+
+bool FrecencyStore::load()
+{
+    m_items.clear();
+    m_byScore.clear();
+    m_byRecency.clear();
+    m_logSize = 0;
+
+    QFile file(m_path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open usage log:" << m_path << file.errorString();
+        return false;
+    }
+
+    // Move a log of another format aside, so new records start a valid log instead of going after it
+    if (file.readLine().trimmed() != LogHeader) {
+        file.close();
+        const QString aside = m_path + QStringLiteral(".old");
+        QFile::remove(aside);
+        if (!QFile::rename(m_path, aside)) {
+            qWarning() << "Failed to move usage log with unknown format aside:" << m_path;
+            return false;
+        }
+        qWarning() << "Usage log has an unknown format, moved to" << aside;
+        return true;
+    }
+
+    bool torn = false;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+
+        // A record without newline was cut short by a crash
+        if (!line.endsWith('\n')) {
+            torn = true;
+            break;
+        }
+        line.chop(1);
+
+        const QStringList fields = QString::fromUtf8(line).split('\t');
+        bool ok = false;
+        if (fields.size() == 3 && fields[0] == QLatin1String("L")) {
+            // A use
+            const qint64 timestamp = fields[1].toLongLong(&ok);
+            if (ok) {
+                const Item previous = m_items.value(fields[2], Item { -INFINITY, 0 });
+                update(fields[2], logAdd(previous.key, keyAt(timestamp)), qMax(previous.lastUsed, timestamp));
+            }
+        } else if (fields.size() == 4 && fields[0] == QLatin1String("S")) {
+            // A snapshot written by compaction or seeding
+            bool timeOk = false;
+            const double key = fields[1].toDouble(&ok);
+            const qint64 lastUsed = fields[2].toLongLong(&timeOk);
+            ok = ok && timeOk;
+            if (ok) {
+                update(fields[3], key, lastUsed);
+            }
+        }
+
+        if (ok) {
+            ++m_logSize;
+        }
+    }
+
+    file.close();
+
+    // Rewrite the log so new records don't continue the torn one
+    if (torn) {
+        qWarning() << "Usage log ends with an incomplete record:" << m_path;
+        compact();
+    }
+
+    return true;
+}
+
+void FrecencyStore::recordUse(const QString &id, qint64 timestamp)
+{
+    const Item previous = m_items.value(id, Item { -INFINITY, 0 });
+    update(id, logAdd(previous.key, keyAt(timestamp)), qMax(previous.lastUsed, timestamp));
+
+    if (append(QStringLiteral("L\t%1\t%2").arg(QString::number(timestamp), id))) {
+        ++m_logSize;
+    }
+
+    if (m_logSize >= MinCompactRecords && m_logSize > 2 * m_items.size()) {
+        compact();
+    }
+}
+
+void FrecencyStore::seed(const QString &id, double uses, qint64 lastUsed)
+{
+    if (uses <= 0.0) {
+        return;
+    }
+
+    const Item previous = m_items.value(id, Item { -INFINITY, 0 });
+    const Item item { logAdd(previous.key, std::log(uses) + keyAt(lastUsed)), qMax(previous.lastUsed, lastUsed) };
+    update(id, item.key, item.lastUsed);
+
+    if (append(QStringLiteral("S\t%1\t%2\t%3")
+                   .arg(QString::number(item.key, 'g', 17), QString::number(item.lastUsed), id))) {
+        ++m_logSize;
+    }
+}
+
+double FrecencyStore::score(const QString &id, qint64 now) const
+{
+    auto it = m_items.constFind(id);
+    return it != m_items.constEnd() ? std::exp(it->key - keyAt(now)) : 0.0;
+}
+
+double FrecencyStore::relativeScore(const QString &id) const
+{
+    auto it = m_items.constFind(id);
+    if (it == m_items.constEnd()) {
+        return 0.0;
+    }
+
+    // Log scale, so the top application doesn't flatten everything else
+    const double top = m_byScore.begin()->first;
+    return qMax(0.0, 1.0 + (it->key - top) / RelativeRange);
+}
+
+qint64 FrecencyStore::lastUsed(const QString &id) const
+{
+    return m_items.value(id, Item { 0.0, 0 }).lastUsed;
+}
+
+QStringList FrecencyStore::topFrecent(int count, const std::function<bool(const QString &)> &accept) const
+{
+    QStringList result;
+    for (auto it = m_byScore.begin(); it != m_byScore.end() && result.size() < count; ++it) {
+        if (!accept || accept(it->second)) {
+            result.append(it->second);
+        }
+    }
+    return result;
+}
+
+QStringList FrecencyStore::mostRecent(int count, const std::function<bool(const QString &)> &accept) const
+{
+    QStringList result;
+    for (auto it = m_byRecency.begin(); it != m_byRecency.end() && result.size() < count; ++it) {
+        if (!accept || accept(it->second)) {
+            result.append(it->second);
+        }
+    }
+    return result;
+}
+
+bool FrecencyStore::isEmpty() const
+{
+    return m_items.isEmpty();
+}
+
+int FrecencyStore::logSize() const
+{
+    return m_logSize;
+}
+
+bool FrecencyStore::compact()
+{
+    // Drop applications whose uses have decayed away
+    const double threshold = keyAt(QDateTime::currentMSecsSinceEpoch()) + std::log(NegligibleScore);
+    while (!m_byScore.empty() && std::prev(m_byScore.end())->first < threshold) {
+        const QString id = std::prev(m_byScore.end())->second;
+        m_byRecency.erase({ m_items.value(id).lastUsed, id });
+        m_byScore.erase(std::prev(m_byScore.end()));
+        m_items.remove(id);
+    }
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write usage log:" << m_path << file.errorString();
+        return false;
+    }
+
+    QByteArray data = LogHeader + '\n';
+    for (auto it = m_items.constBegin(); it != m_items.constEnd(); ++it) {
+        data += QStringLiteral("S\t%1\t%2\t%3\n")
+                    .arg(QString::number(it->key, 'g', 17), QString::number(it->lastUsed), it.key())
+                    .toUtf8();
+    }
+    file.write(data);
+
+    if (!file.commit()) {
+        qWarning() << "Failed to write usage log:" << m_path << file.errorString();
+        return false;
+    }
+
+    m_logSize = m_items.size();
+    return true;
+}
+
+double FrecencyStore::keyAt(qint64 timestamp) const
+{
+    return m_decay * (timestamp - Epoch);
+}
+
+void FrecencyStore::update(const QString &id, double key, qint64 lastUsed)
+{
+    auto it = m_items.find(id);
+    if (it != m_items.end()) {
+        m_byScore.erase({ it->key, id });
+        m_byRecency.erase({ it->lastUsed, id });
+        *it = Item { key, lastUsed };
+    } else {
+        m_items.insert(id, Item { key, lastUsed });
+    }
+
+    m_byScore.insert({ key, id });
+    m_byRecency.insert({ lastUsed, id });
+}
+
+bool FrecencyStore::append(const QString &record)
+{
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    QFile file(m_path);
+    const bool created = !file.exists() || file.size() == 0;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to append to usage log:" << m_path << file.errorString();
+        return false;
+    }
+
+    QByteArray data;
+    if (created) {
+        data = LogHeader + '\n';
+    }
+    data += record.toUtf8() + '\n';
+
+    return file.write(data) == data.size();
+}
+
+} // namespace VivoX::System
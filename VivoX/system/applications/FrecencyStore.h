@@ -0,0 +1,139 @@
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <set>
+#include <utility>
+
+namespace VivoX::System {
+
+/**
+ * @brief Persistent frecency ranking of applications.
+ *
+ * Every use adds one point to an application's score, and points decay
+ * exponentially with a fixed half-life. Scores are kept as the logarithm
+ * of the points scaled to a fixed epoch, so decay never has to be applied:
+ * the passage of time scales all scores alike and leaves the order intact.
+ * The ranking is therefore maintained incrementally in ordered sets, which
+ * makes a use O(log n) and reading the top k O(k).
+ *
+ * Uses are appended to a log file as they happen. The log is compacted
+ * into one snapshot record per application when it grows to twice the
+ * number of applications, dropping applications whose score has decayed
+ * to nothing.
+ */
+class FrecencyStore {
+public:
+    /**
+     * @brief Create a store
+     * @param path The path of the log file
+     * @param halfLifeDays Days after which a use counts half
+     */
+    explicit FrecencyStore(const QString &path, double halfLifeDays = 14.0);
+
+    /**
+     * @brief Load the log file
+     *
+     * A file of an unknown format is renamed with an .old suffix and the
+     * store starts empty.
+     * @return True if the file was read, moved aside or doesn't exist yet
+     */
+    bool load();
+
+    /**
+     * @brief Record a use
+     * @param id The application ID
+     * @param timestamp Time of the use in milliseconds since the epoch
+     */
+    void recordUse(const QString &id, qint64 timestamp = QDateTime::currentMSecsSinceEpoch());
+
+    /**
+     * @brief Seed the score of an application, e.g. from older statistics
+     * @param id The application ID
+     * @param uses Number of uses, all counted at the time of the last use
+     * @param lastUsed Time of the last use in milliseconds since the epoch
+     */
+    void seed(const QString &id, double uses, qint64 lastUsed);
+
+    /**
+     * @brief Get the decayed score of an application
+     * @param id The application ID
+     * @param now The time to decay to in milliseconds since the epoch
+     * @return The number of uses after decay, 0 if never used
+     */
+    double score(const QString &id, qint64 now = QDateTime::currentMSecsSinceEpoch()) const;
+
+    /**
+     * @brief Get the score of an application relative to the top one
+     * @param id The application ID
+     * @return Between 0 (never or rarely used) and 1 (the top application)
+     */
+    double relativeScore(const QString &id) const;
+
+    /**
+     * @brief Get the time of the last use
+     * @param id The application ID
+     * @return Milliseconds since the epoch, 0 if never used
+     */
+    qint64 lastUsed(const QString &id) const;
+
+    /**
+     * @brief Get the applications with the highest frecency
+     * @param count Maximum number of applications
+     * @param accept Optional filter; rejected applications are skipped
+     * @return Application IDs, highest score first
+     */
+    QStringList topFrecent(int count, const std::function<bool(const QString &)> &accept = {}) const;
+
+    /**
+     * @brief Get the most recently used applications
+     * @param count Maximum number of applications
+     * @param accept Optional filter; rejected applications are skipped
+     * @return Application IDs, most recent first
+     */
+    QStringList mostRecent(int count, const std::function<bool(const QString &)> &accept = {}) const;
+
+    /**
+     * @brief Check if the store is empty
+     * @return True if no application has been used
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Get the number of records in the log file
+     * @return The number of records
+     */
+    int logSize() const;
+
+    /**
+     * @brief Rewrite the log file with one snapshot record per application
+     * @return True if the file was written
+     */
+    bool compact();
+
+private:
+    struct Item {
+        double key;       // Log of the points, scaled to the epoch
+        qint64 lastUsed;
+    };
+
+    // Log-domain score of a single use at the given time
+    double keyAt(qint64 timestamp) const;
+
+    void update(const QString &id, double key, qint64 lastUsed);
+    bool append(const QString &record);
+
+    QString m_path;
+    double m_decay;       // Per millisecond
+    int m_logSize;
+
+    QHash<QString, Item> m_items;
+    std::set<std::pair<double, QString>, std::greater<>> m_byScore;
+    std::set<std::pair<qint64, QString>, std::greater<>> m_byRecency;
+};
+
+} // namespace VivoX::System
@@ -0,0 +1,708 @@
+#include "ProcessLauncher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+namespace VivoX::System {
+
+namespace {
+const QString CgroupMount = QStringLiteral("/sys/fs/cgroup");
+
+// Helper socket created by prewarm(), taken over by the first launcher
+int s_helperSocket = -1;
+pid_t s_helperPid = -1;
+
+// Largest request the helper accepts, arguments and environment included
+const size_t MaxRequestSize = 128 * 1024;
+
+// How long a launch waits for the helper to answer
+const int HelperTimeout = 2000;
+
+enum ReplyKind : qint32 {
+    Started,     // pid spawned, pidfd attached
+    Failed,      // value is the errno
+    Exited       // pid exited, value is the wait status
+};
+
+struct Reply {
+    qint32 kind;
+    qint32 pid;
+    qint32 value;
+};
+
+// A decoded spawn request; the pointers point into the request buffer
+struct Request {
+    const char *directory = nullptr;
+    const char *cgroupProcs = nullptr;
+    std::vector<char *> argv;
+    std::vector<char *> envp;
+};
+
+int pidfdOpen(pid_t pid)
+{
+    return int(syscall(SYS_pidfd_open, pid, 0));
+}
+
+int exitCodeOf(int status)
+{
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    return WIFSIGNALED(status) ? 128 + WTERMSIG(status) : -1;
+}
+
+// Request layout: directory, cgroup.procs path, argument count, arguments,
+// then environment entries, all NUL terminated
+QByteArray encodeRequest(const QString &directory, const QString &cgroupProcs,
+                         const QStringList &arguments, const QStringList &environment)
+{
+    QByteArray request;
+    auto field = [&request](const QString &value) {
+        request += value.toLocal8Bit();
+        request += '\0';
+    };
+
+    field(directory);
+    field(cgroupProcs);
+    field(QString::number(arguments.size()));
+    for (const QString &argument : arguments) {
+        field(argument);
+    }
+    for (const QString &entry : environment) {
+        field(entry);
+    }
+    return request;
+}
+
+bool decodeRequest(char *data, size_t size, Request &request)
+{
+    if (size == 0 || data[size - 1] != '\0') {
+        return false;
+    }
+
+    std::vector<char *> fields;
+    for (size_t i = 0; i < size; i += strlen(data + i) + 1) {
+        fields.push_back(data + i);
+    }
+    if (fields.size() < 4) {
+        return false;
+    }
+
+    const size_t argc = strtoul(fields[2], nullptr, 10);
+    if (argc == 0 || 3 + argc > fields.size()) {
+        return false;
+    }
+
+    request.directory = fields[0];
+    request.cgroupProcs = fields[1];
+    request.argv.assign(fields.begin() + 3, fields.begin() + 3 + argc);
+    request.argv.push_back(nullptr);
+    request.envp.assign(fields.begin() + 3 + argc, fields.end());
+    request.envp.push_back(nullptr);
+    return true;
+}
+
+// Spawn a process with vfork. Until execve the child shares our memory and
+// stack, so it only makes system calls. Returns the pid or -errno.
+pid_t spawnProcess(const Request &request)
+{
+    int cgroup = -1;
+    if (*request.cgroupProcs) {
+        cgroup = open(request.cgroupProcs, O_WRONLY | O_CLOEXEC);
+    }
+
+    int errorPipe[2];
+    if (pipe2(errorPipe, O_CLOEXEC) != 0) {
+        const int error = errno;
+        if (cgroup >= 0) {
+            close(cgroup);
+        }
+        return -error;
+    }
+
+    // No signal handler of ours may run in the child
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+
+    const pid_t pid = vfork();
+    if (pid == 0) {
+        // Join the launch's cgroup before the application can fork
+        if (cgroup >= 0 && write(cgroup, "0", 1) < 0) {
+            // Accounting is lost, the launch goes on
+        }
+        setsid();
+
+        int error = 0;
+        if (*request.directory && chdir(request.directory) != 0) {
+            error = errno;
+        } else {
+            // Start the application with default dispositions and no blocked signals
+            struct sigaction action;
+            memset(&action, 0, sizeof(action));
+            action.sa_handler = SIG_DFL;
+            for (int signal = 1; signal < NSIG; ++signal) {
+                sigaction(signal, &action, nullptr);
+            }
+            sigset_t none;
+            sigemptyset(&none);
+            sigprocmask(SIG_SETMASK, &none, nullptr);
+
+            execve(request.argv[0], request.argv.data(), request.envp.data());
+            error = errno;
+        }
+
+        if (write(errorPipe[1], &error, sizeof(error)) < 0) {
+            // Nothing left to report through
+        }
+        _exit(127);
+    }
+
+    const int spawnError = errno;
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    close(errorPipe[1]);
+    if (cgroup >= 0) {
+        close(cgroup);
+    }
+
+    if (pid < 0) {
+        close(errorPipe[0]);
+        return -spawnError;
+    }
+
+    // The pipe is closed by a successful exec; data means it failed
+    int error = 0;
+    ssize_t size;
+    do {
+        size = read(errorPipe[0], &error, sizeof(error));
+    } while (size < 0 && errno == EINTR);
+    close(errorPipe[0]);
+
+    if (size == sizeof(error)) {
+        waitpid(pid, nullptr, 0);
+        return -error;
+    }
+    return pid;
+}
+
+void sendReply(int socket, const Reply &reply, int fd = -1)
+{
+    iovec data { const_cast<Reply *>(&reply), sizeof(reply) };
+    msghdr message {};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    if (fd >= 0) {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr *header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(header), &fd, sizeof(int));
+    }
+
+    sendmsg(socket, &message, MSG_NOSIGNAL);
+}
+
+// Returns the size received, 0 on end of file and -1 on error
+ssize_t receiveReply(int socket, Reply &reply, int &fd, int flags)
+{
+    iovec data { &reply, sizeof(reply) };
+    msghdr message {};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    fd = -1;
+    ssize_t size;
+    do {
+        size = recvmsg(socket, &message, MSG_CMSG_CLOEXEC | flags);
+    } while (size < 0 && errno == EINTR);
+
+    if (size > 0) {
+        for (cmsghdr *header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+                memcpy(&fd, CMSG_DATA(header), sizeof(int));
+            }
+        }
+    }
+    return size;
+}
+
+// Main loop of the spawn helper: spawn requested processes, pass their
+// pidfds back and report their exit status once reaped
+[[noreturn]] void runHelper(int socket)
+{
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    if (getppid() == 1) {
+        _exit(0);
+    }
+
+    // Descriptors inherited from the compositor must not reach applications
+    const int maxFd = int(sysconf(_SC_OPEN_MAX));
+    for (int fd = 3; fd < maxFd && fd < 4096; ++fd) {
+        if (fd != socket) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+
+    sigset_t childSignals;
+    sigemptyset(&childSignals);
+    sigaddset(&childSignals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &childSignals, nullptr);
+    const int signals = signalfd(-1, &childSignals, SFD_CLOEXEC | SFD_NONBLOCK);
+
+    std::vector<char> buffer(MaxRequestSize);
+    for (;;) {
+        pollfd fds[2] = { { socket, POLLIN, 0 }, { signals, POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            signalfd_siginfo info;
+            while (read(signals, &info, sizeof(info)) == sizeof(info)) {
+            }
+
+            int status;
+            pid_t pid;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                sendReply(socket, Reply { Exited, pid, status });
+            }
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            const ssize_t size = recv(socket, buffer.data(), buffer.size(), 0);
+            if (size <= 0) {
+                // The compositor is gone
+                break;
+            }
+
+            Request request;
+            if (!decodeRequest(buffer.data(), size_t(size), request)) {
+                sendReply(socket, Reply { Failed, 0, EINVAL });
+                continue;
+            }
+
+            const pid_t pid = spawnProcess(request);
+            if (pid < 0) {
+                sendReply(socket, Reply { Failed, 0, -pid });
+                continue;
+            }
+
+            // The child can't have been reaped yet, so the pidfd refers to it
+            const int pidfd = pidfdOpen(pid);
+            sendReply(socket, Reply { Started, pid, 0 }, pidfd);
+            if (pidfd >= 0) {
+                close(pidfd);
+            }
+        }
+    }
+
+    _exit(0);
+}
+} // namespace
+
+ProcessLauncher::ProcessLauncher(QObject *parent)
+    : QObject(parent)
+    , m_helper(s_helperSocket)
+    , m_helperNotifier(nullptr)
+    , m_launchCount(0)
+{
+    // The helper serves one launcher
+    s_helperSocket = -1;
+
+    if (m_helper >= 0) {
+        m_helperNotifier = new QSocketNotifier(m_helper, QSocketNotifier::Read, this);
+        connect(m_helperNotifier, &QSocketNotifier::activated, this, &ProcessLauncher::readHelper);
+    }
+
+    // Launch cgroups go below our own one when it is delegated to us; moving
+    // processes also needs write access to our cgroup.procs
+    QFile file("/proc/self/cgroup");
+    if (file.open(QIODevice::ReadOnly)) {
+        for (const QByteArray &line : file.readAll().split('\n')) {
+            if (line.startsWith("0::")) {
+                const QString root = CgroupMount + QString::fromLocal8Bit(line.mid(3)).trimmed();
+                if (QFileInfo(root).isWritable() && QFileInfo(root + "/cgroup.procs").isWritable()) {
+                    m_cgroupRoot = QDir::cleanPath(root);
+                }
+            }
+        }
+    }
+
+    qDebug() << "ProcessLauncher created, helper:" << (m_helper >= 0)
+             << "cgroups:" << (m_cgroupRoot.isEmpty() ? QStringLiteral("unavailable") : m_cgroupRoot);
+}
+
+ProcessLauncher::~ProcessLauncher()
+{
+    for (const Process &process : m_processes) {
+        delete process.notifier;
+        close(process.pidfd);
+    }
+
+    if (m_helper >= 0) {
+        // The helper exits when the socket closes
+        delete m_helperNotifier;
+        close(m_helper);
+        if (s_helperPid > 0) {
+            waitpid(s_helperPid, nullptr, 0);
+            s_helperPid = -1;
+        }
+    }
+}
+
+bool ProcessLauncher::prewarm()
+{
+    if (s_helperSocket >= 0) {
+        return true;
+    }
+
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sockets) != 0) {
+        qWarning() << "Failed to create spawn helper socket:" << strerror(errno);
+        return false;
+    }
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        qWarning() << "Failed to fork spawn helper:" << strerror(errno);
+        close(sockets[0]);
+        close(sockets[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(sockets[0]);
+        runHelper(sockets[1]);
+    }
+
+    close(sockets[1]);
+    s_helperSocket = sockets[0];
+    s_helperPid = pid;
+    return true;
+}
+
+qint64 ProcessLauncher::launch(const QString &program, const QStringList &arguments,
+                               const QStringList &environment, const QString &group,
+                               const QString &workingDirectory)
+{
+    const QString path = program.contains('/') ? program : QStandardPaths::findExecutable(program);
+    if (path.isEmpty()) {
+        qWarning() << "Executable not found:" << program;
+        return 0;
+    }
+
+    const QString cgroup = createCgroup(group);
+    QByteArray request = encodeRequest(workingDirectory,
+                                       cgroup.isEmpty() ? QString() : cgroup + "/cgroup.procs",
+                                       QStringList(path) + arguments, environment);
+    if (size_t(request.size()) > MaxRequestSize) {
+        qWarning() << "Launch request too large:" << program;
+        return 0;
+    }
+
+    qint64 pid = -EPIPE;
+    int pidfd = -1;
+    bool viaHelper = false;
+    if (m_helper >= 0) {
+        // Fall back to spawning here only if the helper never got the request
+        bool sent = false;
+        pid = spawnWithHelper(request, pidfd, sent);
+        viaHelper = sent;
+    }
+    if (!viaHelper) {
+        Request decoded;
+        decodeRequest(request.data(), size_t(request.size()), decoded);
+        pid = spawnProcess(decoded);
+        if (pid > 0) {
+            pidfd = pidfdOpen(pid_t(pid));
+        }
+    }
+
+    if (pid <= 0) {
+        qWarning() << "Failed to launch" << program << ":" << strerror(int(-pid));
+        if (!cgroup.isEmpty()) {
+            QDir().rmdir(cgroup);
+            m_cgroupGroups.remove(cgroup);
+        }
+        return 0;
+    }
+
+    Process process { pidfd, nullptr, group, cgroup, viaHelper, false, false, -1 };
+    if (pidfd >= 0) {
+        process.notifier = new QSocketNotifier(pidfd, QSocketNotifier::Read, this);
+        connect(process.notifier, &QSocketNotifier::activated, this, [this, pid]() {
+            handleProcessExit(pid);
+        });
+    } else {
+        // Kernels before 5.3: the exit goes unnoticed
+        qWarning() << "No pidfd for process" << pid << ":" << strerror(errno);
+    }
+    m_processes.insert(pid, process);
+
+    return pid;
+}
+
+QString ProcessLauncher::groupOf(qint64 pid) const
+{
+    auto it = m_processes.constFind(pid);
+    if (it != m_processes.constEnd()) {
+        return it->group;
+    }
+
+    // Processes forked by a launched one inherit its cgroup
+    QFile file(QString("/proc/%1/cgroup").arg(pid));
+    if (m_cgroupGroups.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    for (const QByteArray &line : file.readAll().split('\n')) {
+        if (!line.startsWith("0::")) {
+            continue;
+        }
+        QString cgroup = QDir::cleanPath(CgroupMount + QString::fromLocal8Bit(line.mid(3)).trimmed());
+        while (cgroup.size() > CgroupMount.size()) {
+            auto group = m_cgroupGroups.constFind(cgroup);
+            if (group != m_cgroupGroups.constEnd()) {
+                return group.value();
+            }
+            cgroup = cgroup.left(cgroup.lastIndexOf('/'));
+        }
+    }
+    return QString();
+}
+
+QString ProcessLauncher::cgroupOf(qint64 pid) const
+{
+    return m_processes.value(pid, Process { -1, nullptr, {}, {}, false, false, false, -1 }).cgroup;
+}
+
+bool ProcessLauncher::usesHelper() const
+{
+    return m_helper >= 0;
+}
+
+void ProcessLauncher::readHelper()
+{
+    for (;;) {
+        Reply reply;
+        int fd = -1;
+        const ssize_t size = receiveReply(m_helper, reply, fd, MSG_DONTWAIT);
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (size <= 0) {
+            helperLost();
+            return;
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+        if (size == sizeof(reply) && reply.kind == Exited) {
+            handleHelperExit(reply.pid, reply.value);
+        }
+    }
+}
+
+qint64 ProcessLauncher::spawnWithHelper(const QByteArray &request, int &pidfd, bool &sent)
+{
+    sent = send(m_helper, request.constData(), size_t(request.size()), MSG_NOSIGNAL) == request.size();
+    if (!sent) {
+        qWarning() << "Spawn helper is gone:" << strerror(errno);
+        helperLost();
+        return -EPIPE;
+    }
+
+    // Exit reports for earlier launches may arrive before the answer
+    for (;;) {
+        pollfd fd { m_helper, POLLIN, 0 };
+        const int ready = poll(&fd, 1, HelperTimeout);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            qWarning() << "Spawn helper doesn't answer";
+            helperLost();
+            return -ETIMEDOUT;
+        }
+
+        Reply reply;
+        int received = -1;
+        if (receiveReply(m_helper, reply, received, 0) != sizeof(reply)) {
+            helperLost();
+            return -EPIPE;
+        }
+
+        switch (reply.kind) {
+        case Exited:
+            handleHelperExit(reply.pid, reply.value);
+            break;
+        case Started:
+            pidfd = received;
+            return reply.pid;
+        case Failed:
+            return -reply.value;
+        }
+    }
+}
+
+void ProcessLauncher::handleProcessExit(qint64 pid)
+{
+    auto it = m_processes.find(pid);
+    if (it == m_processes.end()) {
+        return;
+    }
+    it->notifier->setEnabled(false);
+    it->exited = true;
+
+    if (!it->viaHelper) {
+        // Our own child: reap it through the pidfd
+        siginfo_t info {};
+        int exitCode = -1;
+        if (waitid(idtype_t(P_PIDFD), id_t(it->pidfd), &info, WEXITED | WNOHANG) == 0 && info.si_pid == pid) {
+            exitCode = info.si_code == CLD_EXITED ? info.si_status : 128 + info.si_status;
+        }
+        finish(pid, exitCode);
+    } else if (it->statusKnown || m_helper < 0) {
+        finish(pid, it->exitCode);
+    }
+}
+
+void ProcessLauncher::handleHelperExit(qint64 pid, int status)
+{
+    auto it = m_processes.find(pid);
+    if (it == m_processes.end()) {
+        return;
+    }
+    it->statusKnown = true;
+    it->exitCode = exitCodeOf(status);
+
+    // Finish once the pidfd reported the exit as well
+    if (it->exited || it->pidfd < 0) {
+        finish(pid, it->exitCode);
+    }
+}
+
+void ProcessLauncher::finish(qint64 pid, int exitCode)
+{
+    const Process process = m_processes.take(pid);
+    if (process.notifier) {
+        process.notifier->deleteLater();
+    }
+    if (process.pidfd >= 0) {
+        close(process.pidfd);
+    }
+
+    if (!process.cgroup.isEmpty()) {
+        m_staleCgroups.append(process.cgroup);
+    }
+    removeCgroups();
+
+    emit finished(pid, exitCode);
+}
+
+void ProcessLauncher::helperLost()
+{
+    if (m_helper < 0) {
+        return;
+    }
+
+    // May run from the notifier's own signal
+    m_helperNotifier->deleteLater();
+    m_helperNotifier = nullptr;
+    close(m_helper);
+    m_helper = -1;
+
+    // A helper that stopped answering is not coming back; its children live on
+    if (s_helperPid > 0) {
+        kill(s_helperPid, SIGKILL);
+        waitpid(s_helperPid, nullptr, 0);
+        s_helperPid = -1;
+    }
+
+    // Exit statuses of processes that already exited won't come anymore
+    QList<qint64> exited;
+    for (auto it = m_processes.constBegin(); it != m_processes.constEnd(); ++it) {
+        if (it->viaHelper && it->exited) {
+            exited.append(it.key());
+        }
+    }
+    for (qint64 pid : exited) {
+        finish(pid, -1);
+    }
+}
+
+QString ProcessLauncher::createCgroup(const QString &group)
+{
+    if (group.isEmpty() || m_cgroupRoot.isEmpty()) {
+        return QString();
+    }
+
+    QString name = group;
+    for (QChar &c : name) {
+        if (!c.isLetterOrNumber() && c != '-' && c != '_' && c != '.') {
+            c = '_';
+        }
+    }
+
+    const QString path = QString("%1/app-vivox-%2-%3.scope").arg(m_cgroupRoot, name).arg(++m_launchCount);
+    if (!QDir().mkdir(path)) {
+        qWarning() << "Failed to create cgroup" << path << "- launching without";
+        return QString();
+    }
+
+    m_cgroupGroups.insert(path, group);
+    return path;
+}
+
+void ProcessLauncher::removeCgroups()
+{
+    // A cgroup can only be removed once processes forked into it are gone too
+    for (auto it = m_staleCgroups.begin(); it != m_staleCgroups.end();) {
+        if (QDir().rmdir(*it)) {
+            m_cgroupGroups.remove(*it);
+            it = m_staleCgroups.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace VivoX::System
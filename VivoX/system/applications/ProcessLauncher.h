@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QSocketNotifier;
+
+namespace VivoX::System {
+
+/**
+ * @brief Spawns application processes and tracks them until they exit.
+ *
+ * Processes are spawned with vfork and execve, so the compositor's address
+ * space is never copied. When prewarm() was called early in main(), the
+ * spawning is done by a small helper process forked at that point, which
+ * keeps even the vfork off the compositor's threads and memory map.
+ *
+ * Each launch gets its own cgroup below the compositor's cgroup when that
+ * is delegated to us, named like the scopes systemd creates, so resource
+ * usage can be accounted per application and processes can be attributed
+ * to the launch that started them. Exits are tracked through pidfds.
+ */
+class ProcessLauncher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ProcessLauncher(QObject *parent = nullptr);
+    ~ProcessLauncher();
+
+    /**
+     * @brief Fork the spawn helper
+     *
+     * Must be called at the start of main(), before any threads exist.
+     * Without it, processes are spawned from the calling process.
+     *
+     * @return True if the helper was started
+     */
+    static bool prewarm();
+
+    /**
+     * @brief Launch a process
+     * @param program Program name or path
+     * @param arguments Arguments
+     * @param environment Complete environment as NAME=value entries
+     * @param group Group the process is accounted to, usually the application ID
+     * @param workingDirectory Working directory, or empty to inherit ours
+     * @return The process ID if successful, 0 otherwise
+     */
+    qint64 launch(const QString &program, const QStringList &arguments, const QStringList &environment,
+                  const QString &group = QString(), const QString &workingDirectory = QString());
+
+    /**
+     * @brief Get the group a process was launched in
+     *
+     * Also finds processes forked by launched ones, through their cgroup.
+     *
+     * @param pid The process ID
+     * @return The group, or an empty string if unknown
+     */
+    QString groupOf(qint64 pid) const;
+
+    /**
+     * @brief Get the cgroup directory of a launched process
+     * @param pid The process ID returned by launch()
+     * @return The cgroup directory, or an empty string without cgroup
+     */
+    QString cgroupOf(qint64 pid) const;
+
+    /**
+     * @brief Check if processes are spawned by the prewarmed helper
+     * @return True if the helper is in use
+     */
+    bool usesHelper() const;
+
+signals:
+    /**
+     * @brief Signal emitted when a launched process has exited
+     * @param pid The process ID
+     * @param exitCode The exit code, 128 + signal number if killed, or -1 if unknown
+     */
+    void finished(qint64 pid, int exitCode);
+
+private slots:
+    void readHelper();
+
+private:
+    struct Process {
+        int pidfd;
+        QSocketNotifier *notifier;
+        QString group;
+        QString cgroup;
+        bool viaHelper;          // Child of the helper, which reports the exit status
+        bool exited;
+        bool statusKnown;
+        int exitCode;
+    };
+
+    qint64 spawnWithHelper(const QByteArray &request, int &pidfd, bool &sent);
+    void handleProcessExit(qint64 pid);
+    void handleHelperExit(qint64 pid, int status);
+    void finish(qint64 pid, int exitCode);
+    void helperLost();
+
+    QString createCgroup(const QString &group);
+    void removeCgroups();
+
+    int m_helper;
+    QSocketNotifier *m_helperNotifier;
+
+    QHash<qint64, Process> m_processes;
+
+    // Writable cgroup below which launches get their cgroups
+    QString m_cgroupRoot;
+    int m_launchCount;
+
+    // Group of each launch cgroup, and cgroups left behind by exited launches
+    QHash<QString, QString> m_cgroupGroups;
+    QStringList m_staleCgroups;
+};
+
+} // namespace VivoX::System
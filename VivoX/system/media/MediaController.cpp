@@ -2,18 +2,35 @@
 
 #include <QDebug>
 #include <QDBusConnection>
-#include <QDBusInterface>
-#include <QDBusReply>
 #include <QDBusConnectionInterface>
 #include <QDBusMessage>
 #include <QDBusObjectPath>
-#include <QTimer>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
+#include <QDBusVariant>
 
 namespace VivoX::System {
 
+namespace {
+    const QString mprisPrefix = QStringLiteral("org.mpris.MediaPlayer2.");
+    const QString mprisPath = QStringLiteral("/org/mpris/MediaPlayer2");
+    const QString rootInterface = QStringLiteral("org.mpris.MediaPlayer2");
+    const QString playerInterface = QStringLiteral("org.mpris.MediaPlayer2.Player");
+    const QString propertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+}
+
 MediaController::MediaController(QObject *parent)
+    : MediaController(QDBusConnection::sessionBus(), parent)
+{
+}
+
+MediaController::MediaController(const QDBusConnection &connection, QObject *parent)
     : QObject(parent)
+    , m_connection(connection)
+    , m_serviceWatcher(nullptr)
 {
+    m_clock.start();
     qDebug() << "MediaController created";
 }
 
@@ -24,32 +41,41 @@ MediaController::~MediaController()
 
 bool MediaController::initialize()
 {
-    // Connect to the session bus
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    
-    if (!sessionBus.isConnected()) {
+    if (!m_connection.isConnected()) {
         qWarning() << "Failed to connect to session bus";
         return false;
     }
-    
-    // Connect to DBus signals for player changes
-    sessionBus.connect(
-        "org.freedesktop.DBus", 
-        "/org/freedesktop/DBus", 
-        "org.freedesktop.DBus", 
-        "NameOwnerChanged", 
-        this, 
-        SLOT(updateMediaInfo())
+
+    // Only NameOwnerChanged for MPRIS names reaches us (arg0namespace match rule)
+    m_serviceWatcher = new QDBusServiceWatcher(mprisPrefix + QLatin1Char('*'), m_connection,
+                                               QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(m_serviceWatcher, &QDBusServiceWatcher::serviceOwnerChanged,
+            this, &MediaController::handleServiceOwnerChanged);
+
+    // Pick up players that were already running
+    QDBusMessage listNames = QDBusMessage::createMethodCall(
+        "org.freedesktop.DBus",
+        "/org/freedesktop/DBus",
+        "org.freedesktop.DBus",
+        "ListNames"
     );
-    
-    // Start a timer to periodically update media information
-    QTimer *timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, &MediaController::updateMediaInfo);
-    timer->start(2000); // Update every 2 seconds
-    
-    // Initial update
-    updateMediaInfo();
-    
+    auto *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(listNames), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<QStringList> reply = *call;
+        call->deleteLater();
+
+        if (reply.isError()) {
+            qWarning() << "Failed to get registered service names:" << reply.error().message();
+            return;
+        }
+
+        for (const QString &service : reply.value()) {
+            if (service.startsWith(mprisPrefix)) {
+                addPlayer(service, QString());
+            }
+        }
+    });
+
     qDebug() << "MediaController initialized";
     return true;
 }
@@ -62,371 +88,97 @@ QStringList MediaController::getAvailablePlayers() const
 MediaInfo MediaController::getMediaInfo(const QString &playerId) const
 {
     QString id = getPlayerIdToUse(playerId);
-    
+
     if (id.isEmpty() || !m_mediaInfo.contains(id)) {
         return MediaInfo();
     }
-    
-    return m_mediaInfo[id];
+
+    MediaInfo info = m_mediaInfo[id];
+    info.position = interpolatedPosition(id);
+    return info;
 }
 
-bool MediaController::play(const QString &playerId)
+qint64 MediaController::getPosition(const QString &playerId) const
 {
     QString id = getPlayerIdToUse(playerId);
-    
+
     if (id.isEmpty()) {
-        qWarning() << "No player available for play action";
-        return false;
+        return 0;
     }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("Play");
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call Play:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+
+    return interpolatedPosition(id);
+}
+
+bool MediaController::play(const QString &playerId)
+{
+    return callPlayer(playerId, "Play", {}, "play");
 }
 
 bool MediaController::pause(const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for pause action";
-        return false;
-    }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("Pause");
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call Pause:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+    return callPlayer(playerId, "Pause", {}, "pause");
 }
 
 bool MediaController::playPause(const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for playPause action";
-        return false;
-    }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("PlayPause");
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call PlayPause:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+    return callPlayer(playerId, "PlayPause", {}, "playPause");
 }
 
 bool MediaController::stop(const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for stop action";
-        return false;
-    }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("Stop");
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call Stop:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+    return callPlayer(playerId, "Stop", {}, "stop");
 }
 
 bool MediaController::next(const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for next action";
-        return false;
-    }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("Next");
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call Next:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+    return callPlayer(playerId, "Next", {}, "next");
 }
 
 bool MediaController::previous(const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for previous action";
-        return false;
-    }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("Previous");
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call Previous:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+    return callPlayer(playerId, "Previous", {}, "previous");
 }
 
 bool MediaController::seek(qint64 position, const QString &playerId)
 {
     QString id = getPlayerIdToUse(playerId);
-    
+
     if (id.isEmpty()) {
         qWarning() << "No player available for seek action";
         return false;
     }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("SetPosition", QDBusObjectPath("/org/mpris/MediaPlayer2"), position);
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call SetPosition:" << reply.error().message();
-        return false;
+
+    // SetPosition needs the current track id; fall back to a relative seek without one
+    const QString trackId = m_mediaInfo[id].trackId;
+    if (trackId.isEmpty()) {
+        return callPlayer(id, "Seek", {qlonglong(position - interpolatedPosition(id))}, "seek");
     }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+
+    return callPlayer(id, "SetPosition", {QVariant::fromValue(QDBusObjectPath(trackId)), qlonglong(position)}, "seek");
 }
 
 bool MediaController::setVolume(double volume, const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for setVolume action";
-        return false;
-    }
-    
     // Ensure volume is within valid range
     volume = qBound(0.0, volume, 1.0);
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("Volume", volume);
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call Volume:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+
+    return setPlayerProperty(playerId, "Volume", volume, "setVolume");
 }
 
 bool MediaController::setShuffle(bool shuffle, const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for setShuffle action";
-        return false;
-    }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("Shuffle", shuffle);
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call Shuffle:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+    return setPlayerProperty(playerId, "Shuffle", shuffle, "setShuffle");
 }
 
 bool MediaController::setLoopStatus(const QString &loopStatus, const QString &playerId)
 {
-    QString id = getPlayerIdToUse(playerId);
-    
-    if (id.isEmpty()) {
-        qWarning() << "No player available for setLoopStatus action";
-        return false;
-    }
-    
     // Validate loop status
     if (loopStatus != "None" && loopStatus != "Track" && loopStatus != "Playlist") {
         qWarning() << "Invalid loop status:" << loopStatus;
         return false;
     }
-    
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    QDBusInterface mprisInterface(
-        id, 
-        "/org/mpris/MediaPlayer2", 
-        "org.mpris.MediaPlayer2.Player", 
-        sessionBus
-    );
-    
-    if (!mprisInterface.isValid()) {
-        qWarning() << "Failed to create MPRIS interface for player:" << id;
-        return false;
-    }
-    
-    QDBusReply<void> reply = mprisInterface.call("LoopStatus", loopStatus);
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to call LoopStatus:" << reply.error().message();
-        return false;
-    }
-    
-    // Update media info after action
-    QTimer::singleShot(100, this, &MediaController::updateMediaInfo);
-    
-    return true;
+
+    return setPlayerProperty(playerId, "LoopStatus", loopStatus, "setLoopStatus");
 }
 
 QString MediaController::getPlayerIdToUse(const QString &playerId) const
@@ -435,317 +187,403 @@ QString MediaController::getPlayerIdToUse(const QString &playerId) const
     if (!playerId.isEmpty() && m_mediaInfo.contains(playerId)) {
         return playerId;
     }
-    
+
     // Otherwise, use the active player
     if (!m_activePlayerId.isEmpty() && m_mediaInfo.contains(m_activePlayerId)) {
         return m_activePlayerId;
     }
-    
+
     // If no active player, use the first available player
     if (!m_mediaInfo.isEmpty()) {
         return m_mediaInfo.keys().first();
     }
-    
+
     // No players available
     return QString();
 }
 
-void MediaController::updateMediaInfo()
+void MediaController::handleServiceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner)
 {
-    QDBusConnection sessionBus = QDBusConnection::sessionBus();
-    
-    if (!sessionBus.isConnected()) {
-        qWarning() << "Failed to connect to session bus";
+    if (!service.startsWith(mprisPrefix)) {
+        return;
+    }
+
+    if (!oldOwner.isEmpty()) {
+        m_owners.remove(oldOwner);
+        removePlayer(service);
+    }
+
+    if (!newOwner.isEmpty()) {
+        addPlayer(service, newOwner);
+    }
+}
+
+void MediaController::handlePropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated)
+{
+    if (!calledFromDBus()) {
         return;
     }
-    
-    // Get all services on the session bus
-    QDBusReply<QStringList> reply = sessionBus.interface()->registeredServiceNames();
-    
-    if (!reply.isValid()) {
-        qWarning() << "Failed to get registered service names:" << reply.error().message();
+
+    // Signals carry the unique sender name, not the MPRIS name
+    const QString service = m_owners.value(message().service());
+    if (service.isEmpty()) {
         return;
     }
-    
-    QStringList services = reply.value();
-    QStringList mprisServices;
-    
-    // Filter for MPRIS services
-    for (const QString &service : services) {
-        if (service.startsWith("org.mpris.MediaPlayer2.")) {
-            mprisServices.append(service);
-        }
+
+    applyProperties(service, interface, changed);
+
+    // Invalidated properties have to be fetched again
+    if (!invalidated.isEmpty()) {
+        requestProperties(service, interface);
+    }
+}
+
+void MediaController::handleSeeked(qlonglong position)
+{
+    if (!calledFromDBus()) {
+        return;
+    }
+
+    const QString service = m_owners.value(message().service());
+    if (service.isEmpty() || !m_mediaInfo.contains(service)) {
+        return;
     }
-    
-    // Check for removed players
-    QStringList currentPlayers = m_mediaInfo.keys();
-    for (const QString &player : currentPlayers) {
-        if (!mprisServices.contains(player)) {
-            m_mediaInfo.remove(player);
-            emit playerRemoved(player);
-            
-            // If this was the active player, clear it
-            if (m_activePlayerId == player) {
-                m_activePlayerId.clear();
+
+    setPosition(service, position);
+
+    if (service == m_activePlayerId) {
+        emit mediaInfoChanged(getMediaInfo(service));
+    }
+}
+
+void MediaController::addPlayer(const QString &service, const QString &owner)
+{
+    if (!owner.isEmpty()) {
+        m_owners.insert(owner, service);
+    } else {
+        // Resolve the unique name so signals can be attributed to the player
+        QDBusMessage getOwner = QDBusMessage::createMethodCall(
+            "org.freedesktop.DBus",
+            "/org/freedesktop/DBus",
+            "org.freedesktop.DBus",
+            "GetNameOwner"
+        );
+        getOwner << service;
+        auto *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(getOwner), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service](QDBusPendingCallWatcher *call) {
+            QDBusPendingReply<QString> reply = *call;
+            call->deleteLater();
+
+            if (!reply.isError() && m_mediaInfo.contains(service)) {
+                m_owners.insert(reply.value(), service);
+            }
+        });
+    }
+
+    if (m_mediaInfo.contains(service)) {
+        return;
+    }
+
+    MediaInfo info;
+    info.playerId = service;
+    info.playerName = service.mid(mprisPrefix.length());
+    info.length = 0;
+    info.position = 0;
+    info.rate = 1.0;
+    info.volume = 1.0;
+    info.canPlay = false;
+    info.canPause = false;
+    info.canSeek = false;
+    info.canGoNext = false;
+    info.canGoPrevious = false;
+    info.isPlaying = false;
+    info.shuffle = false;
+    info.loopStatus = "None";
+
+    m_mediaInfo.insert(service, info);
+    m_positionTimestamps.insert(service, m_clock.elapsed());
+
+    // Follow the player's properties instead of polling them
+    m_connection.connect(service, mprisPath, propertiesInterface, "PropertiesChanged",
+                         this, SLOT(handlePropertiesChanged(QString,QVariantMap,QStringList)));
+    m_connection.connect(service, mprisPath, playerInterface, "Seeked",
+                         this, SLOT(handleSeeked(qlonglong)));
+
+    requestProperties(service, rootInterface);
+    requestProperties(service, playerInterface);
+
+    emit playerAdded(service);
+
+    // If no active player, set this as active
+    if (m_activePlayerId.isEmpty()) {
+        m_activePlayerId = service;
+        emit activePlayerChanged(service);
+    }
+}
+
+void MediaController::removePlayer(const QString &service)
+{
+    if (!m_mediaInfo.contains(service)) {
+        return;
+    }
+
+    m_connection.disconnect(service, mprisPath, propertiesInterface, "PropertiesChanged",
+                            this, SLOT(handlePropertiesChanged(QString,QVariantMap,QStringList)));
+    m_connection.disconnect(service, mprisPath, playerInterface, "Seeked",
+                            this, SLOT(handleSeeked(qlonglong)));
+
+    m_mediaInfo.remove(service);
+    m_positionTimestamps.remove(service);
+    for (auto it = m_owners.begin(); it != m_owners.end();) {
+        it = it.value() == service ? m_owners.erase(it) : std::next(it);
+    }
+
+    emit playerRemoved(service);
+
+    // If this was the active player, hand over to a playing one if possible
+    if (m_activePlayerId == service) {
+        m_activePlayerId.clear();
+
+        for (const MediaInfo &info : std::as_const(m_mediaInfo)) {
+            if (info.isPlaying || m_activePlayerId.isEmpty()) {
+                m_activePlayerId = info.playerId;
             }
         }
+
+        emit activePlayerChanged(m_activePlayerId);
     }
-    
-    // Update info for each MPRIS service
-    for (const QString &service : mprisServices) {
-        QDBusInterface mprisInterface(
-            service, 
-            "/org/mpris/MediaPlayer2", 
-            "org.mpris.MediaPlayer2.Player", 
-            sessionBus
-        );
-        
-        if (!mprisInterface.isValid()) {
-            qWarning() << "Failed to create MPRIS interface for service:" << service;
-            continue;
+}
+
+void MediaController::requestProperties(const QString &service, const QString &interface)
+{
+    QDBusMessage getAll = QDBusMessage::createMethodCall(service, mprisPath, propertiesInterface, "GetAll");
+    getAll << interface;
+
+    auto *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(getAll), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service, interface](QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<QVariantMap> reply = *call;
+        call->deleteLater();
+
+        if (reply.isError()) {
+            qWarning() << "Failed to get properties of" << service << ":" << reply.error().message();
+            return;
         }
-        
-        // Get player identity
-        QDBusInterface identityInterface(
-            service, 
-            "/org/mpris/MediaPlayer2", 
-            "org.mpris.MediaPlayer2", 
-            sessionBus
-        );
-        
-        QString playerName;
-        if (identityInterface.isValid()) {
-            QDBusReply<QString> identityReply = identityInterface.call("Identity");
-            if (identityReply.isValid()) {
-                playerName = identityReply.value();
-            }
+
+        applyProperties(service, interface, reply.value());
+    });
+}
+
+void MediaController::requestPosition(const QString &service)
+{
+    QDBusMessage get = QDBusMessage::createMethodCall(service, mprisPath, propertiesInterface, "Get");
+    get << playerInterface << QStringLiteral("Position");
+
+    auto *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(get), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service](QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<QDBusVariant> reply = *call;
+        call->deleteLater();
+
+        if (reply.isError() || !m_mediaInfo.contains(service)) {
+            return;
         }
-        
-        // Get player properties
-        QDBusMessage metadataMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        metadataMsg << "org.mpris.MediaPlayer2.Player" << "Metadata";
-        QDBusReply<QVariant> metadataReply = sessionBus.call(metadataMsg);
-        
-        QDBusMessage playbackStatusMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        playbackStatusMsg << "org.mpris.MediaPlayer2.Player" << "PlaybackStatus";
-        QDBusReply<QVariant> playbackStatusReply = sessionBus.call(playbackStatusMsg);
-        
-        QDBusMessage volumeMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        volumeMsg << "org.mpris.MediaPlayer2.Player" << "Volume";
-        QDBusReply<QVariant> volumeReply = sessionBus.call(volumeMsg);
-        
-        QDBusMessage shuffleMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        shuffleMsg << "org.mpris.MediaPlayer2.Player" << "Shuffle";
-        QDBusReply<QVariant> shuffleReply = sessionBus.call(shuffleMsg);
-        
-        QDBusMessage loopStatusMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        loopStatusMsg << "org.mpris.MediaPlayer2.Player" << "LoopStatus";
-        QDBusReply<QVariant> loopStatusReply = sessionBus.call(loopStatusMsg);
-        
-        QDBusMessage canControlMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        canControlMsg << "org.mpris.MediaPlayer2.Player" << "CanControl";
-        QDBusReply<QVariant> canControlReply = sessionBus.call(canControlMsg);
-        
-        QDBusMessage canPlayMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        canPlayMsg << "org.mpris.MediaPlayer2.Player" << "CanPlay";
-        QDBusReply<QVariant> canPlayReply = sessionBus.call(canPlayMsg);
-        
-        QDBusMessage canPauseMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        canPauseMsg << "org.mpris.MediaPlayer2.Player" << "CanPause";
-        QDBusReply<QVariant> canPauseReply = sessionBus.call(canPauseMsg);
-        
-        QDBusMessage canSeekMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        canSeekMsg << "org.mpris.MediaPlayer2.Player" << "CanSeek";
-        QDBusReply<QVariant> canSeekReply = sessionBus.call(canSeekMsg);
-        
-        QDBusMessage canGoNextMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        canGoNextMsg << "org.mpris.MediaPlayer2.Player" << "CanGoNext";
-        QDBusReply<QVariant> canGoNextReply = sessionBus.call(canGoNextMsg);
-        
-        QDBusMessage canGoPreviousMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        canGoPreviousMsg << "org.mpris.MediaPlayer2.Player" << "CanGoPrevious";
-        QDBusReply<QVariant> canGoPreviousReply = sessionBus.call(canGoPreviousMsg);
-        
-        QDBusMessage positionMsg = QDBusMessage::createMethodCall(
-            service,
-            "/org/mpris/MediaPlayer2",
-            "org.freedesktop.DBus.Properties",
-            "Get"
-        );
-        positionMsg << "org.mpris.MediaPlayer2.Player" << "Position";
-        QDBusReply<QVariant> positionReply = sessionBus.call(positionMsg);
-        
-        // Create or update media info
-        MediaInfo info;
-        info.playerId = service;
-        info.playerName = playerName.isEmpty() ? service.mid(23) : playerName; // Remove "org.mpris.MediaPlayer2." prefix
-        
-        // Set defaults
-        info.canPlay = false;
-        info.canPause = false;
-        info.canSeek = false;
-        info.canGoNext = false;
-        info.canGoPrevious = false;
-        info.isPlaying = false;
-        info.shuffle = false;
-        info.loopStatus = "None";
-        info.volume = 1.0;
-        info.length = 0;
-        info.position = 0;
-        
-        // Update with actual values if available
-        if (metadataReply.isValid()) {
-            QVariantMap metadata = qdbus_cast<QVariantMap>(metadataReply.value());
-            
-            if (metadata.contains("xesam:title")) {
-                info.title = metadata["xesam:title"].toString();
-            }
-            
-            if (metadata.contains("xesam:artist")) {
-                QStringList artists = metadata["xesam:artist"].toStringList();
-                info.artist = artists.join(", ");
-            }
-            
-            if (metadata.contains("xesam:album")) {
-                info.album = metadata["xesam:album"].toString();
-            }
-            
-            if (metadata.contains("mpris:artUrl")) {
-                info.artUrl = metadata["mpris:artUrl"].toString();
+
+        setPosition(service, reply.value().variant().toLongLong());
+    });
+}
+
+void MediaController::applyProperties(const QString &service, const QString &interface, const QVariantMap &properties)
+{
+    if (!m_mediaInfo.contains(service) || properties.isEmpty()) {
+        return;
+    }
+
+    MediaInfo &info = m_mediaInfo[service];
+
+    if (interface == rootInterface) {
+        const QString identity = properties.value("Identity").toString();
+        if (!identity.isEmpty()) {
+            info.playerName = identity;
+        }
+    } else if (interface == playerInterface) {
+        bool resyncPosition = false;
+
+        if (properties.contains("Metadata")) {
+            QVariantMap metadata = qdbus_cast<QVariantMap>(properties["Metadata"]);
+
+            const QString trackId = qdbus_cast<QDBusObjectPath>(metadata["mpris:trackid"]).path();
+            const bool trackChanged = trackId != info.trackId || metadata["xesam:title"].toString() != info.title;
+
+            info.trackId = trackId;
+            info.title = metadata["xesam:title"].toString();
+            info.artist = metadata["xesam:artist"].toStringList().join(", ");
+            info.album = metadata["xesam:album"].toString();
+            info.artUrl = metadata["mpris:artUrl"].toString();
+            info.length = metadata["mpris:length"].toLongLong();
+
+            // A new track starts from the beginning
+            if (trackChanged) {
+                setPosition(service, 0);
+                resyncPosition = true;
             }
-            
-            if (metadata.contains("mpris:length")) {
-                info.length = metadata["mpris:length"].toLongLong();
+        }
+
+        if (properties.contains("PlaybackStatus")) {
+            const bool playing = properties["PlaybackStatus"].toString() == "Playing";
+            if (playing != info.isPlaying) {
+                // Freeze the interpolated position at the transition
+                setPosition(service, interpolatedPosition(service));
+                info.isPlaying = playing;
+                resyncPosition = true;
             }
         }
-        
-        if (playbackStatusReply.isValid()) {
-            QString status = playbackStatusReply.value().toString();
-            info.isPlaying = (status == "Playing");
+
+        if (properties.contains("Rate")) {
+            setPosition(service, interpolatedPosition(service));
+            info.rate = properties["Rate"].toDouble();
         }
-        
-        if (volumeReply.isValid()) {
-            info.volume = volumeReply.value().toDouble();
+
+        if (properties.contains("Volume")) {
+            info.volume = properties["Volume"].toDouble();
         }
-        
-        if (shuffleReply.isValid()) {
-            info.shuffle = shuffleReply.value().toBool();
+
+        if (properties.contains("Shuffle")) {
+            info.shuffle = properties["Shuffle"].toBool();
         }
-        
-        if (loopStatusReply.isValid()) {
-            info.loopStatus = loopStatusReply.value().toString();
+
+        if (properties.contains("LoopStatus")) {
+            info.loopStatus = properties["LoopStatus"].toString();
         }
-        
-        if (canControlReply.isValid() && canControlReply.value().toBool()) {
-            if (canPlayReply.isValid()) {
-                info.canPlay = canPlayReply.value().toBool();
-            }
-            
-            if (canPauseReply.isValid()) {
-                info.canPause = canPauseReply.value().toBool();
-            }
-            
-            if (canSeekReply.isValid()) {
-                info.canSeek = canSeekReply.value().toBool();
-            }
-            
-            if (canGoNextReply.isValid()) {
-                info.canGoNext = canGoNextReply.value().toBool();
-            }
-            
-            if (canGoPreviousReply.isValid()) {
-                info.canGoPrevious = canGoPreviousReply.value().toBool();
-            }
+
+        if (properties.contains("CanPlay")) {
+            info.canPlay = properties["CanPlay"].toBool();
         }
-        
-        if (positionReply.isValid()) {
-            info.position = positionReply.value().toLongLong();
+
+        if (properties.contains("CanPause")) {
+            info.canPause = properties["CanPause"].toBool();
         }
-        
-        // Check if this is a new player
-        bool isNewPlayer = !m_mediaInfo.contains(service);
-        
-        // Update the media info
-        m_mediaInfo[service] = info;
-        
-        // Emit signals
-        if (isNewPlayer) {
-            emit playerAdded(service);
-            
-            // If no active player, set this as active
-            if (m_activePlayerId.isEmpty()) {
-                m_activePlayerId = service;
-                emit activePlayerChanged(service);
-            }
+
+        if (properties.contains("CanSeek")) {
+            info.canSeek = properties["CanSeek"].toBool();
+        }
+
+        if (properties.contains("CanGoNext")) {
+            info.canGoNext = properties["CanGoNext"].toBool();
         }
-        
-        // If this is the active player, emit mediaInfoChanged
-        if (service == m_activePlayerId) {
-            emit mediaInfoChanged(info);
+
+        if (properties.contains("CanGoPrevious")) {
+            info.canGoPrevious = properties["CanGoPrevious"].toBool();
         }
-        
-        // If this player is playing and the active player is not, make this the active player
-        if (info.isPlaying && !m_mediaInfo[m_activePlayerId].isPlaying) {
-            m_activePlayerId = service;
-            emit activePlayerChanged(service);
-            emit mediaInfoChanged(info);
+
+        // Players that can't be controlled expose no actions
+        if (properties.contains("CanControl") && !properties["CanControl"].toBool()) {
+            info.canPlay = false;
+            info.canPause = false;
+            info.canSeek = false;
+            info.canGoNext = false;
+            info.canGoPrevious = false;
+        }
+
+        // Position is not signalled; a full fetch carries it, otherwise ask once
+        if (properties.contains("Position")) {
+            setPosition(service, properties["Position"].toLongLong());
+        } else if (resyncPosition) {
+            requestPosition(service);
+        }
+    } else {
+        return;
+    }
+
+    if (service == m_activePlayerId) {
+        emit mediaInfoChanged(getMediaInfo(service));
+    }
+
+    updateActivePlayer(service);
+}
+
+void MediaController::setPosition(const QString &service, qint64 position)
+{
+    m_mediaInfo[service].position = position;
+    m_positionTimestamps[service] = m_clock.elapsed();
+}
+
+qint64 MediaController::interpolatedPosition(const QString &service) const
+{
+    const MediaInfo &info = m_mediaInfo[service];
+
+    if (!info.isPlaying) {
+        return info.position;
+    }
+
+    // Advance by the time passed since the position was sampled
+    const qint64 elapsedMs = m_clock.elapsed() - m_positionTimestamps.value(service);
+    qint64 position = info.position + static_cast<qint64>(elapsedMs * 1000 * info.rate);
+
+    if (info.length > 0) {
+        position = qMin(position, info.length);
+    }
+
+    return qMax<qint64>(0, position);
+}
+
+void MediaController::updateActivePlayer(const QString &service)
+{
+    // If this player is playing and the active player is not, make this the active player
+    if (service == m_activePlayerId || !m_mediaInfo[service].isPlaying) {
+        return;
+    }
+
+    if (m_activePlayerId.isEmpty() || !m_mediaInfo.value(m_activePlayerId).isPlaying) {
+        m_activePlayerId = service;
+        emit activePlayerChanged(service);
+        emit mediaInfoChanged(getMediaInfo(service));
+    }
+}
+
+bool MediaController::callPlayer(const QString &playerId, const QString &method, const QVariantList &arguments, const char *action)
+{
+    QString id = getPlayerIdToUse(playerId);
+
+    if (id.isEmpty()) {
+        qWarning() << "No player available for" << action << "action";
+        return false;
+    }
+
+    QDBusMessage call = QDBusMessage::createMethodCall(id, mprisPath, playerInterface, method);
+    call.setArguments(arguments);
+
+    // The resulting state arrives through PropertiesChanged; only report failures
+    auto *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(call), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [method](QDBusPendingCallWatcher *pending) {
+        if (pending->isError()) {
+            qWarning() << "Failed to call" << method << ":" << pending->error().message();
         }
+        pending->deleteLater();
+    });
+
+    return true;
+}
+
+bool MediaController::setPlayerProperty(const QString &playerId, const QString &property, const QVariant &value, const char *action)
+{
+    QString id = getPlayerIdToUse(playerId);
+
+    if (id.isEmpty()) {
+        qWarning() << "No player available for" << action << "action";
+        return false;
     }
+
+    QDBusMessage set = QDBusMessage::createMethodCall(id, mprisPath, propertiesInterface, "Set");
+    set << playerInterface << property << QVariant::fromValue(QDBusVariant(value));
+
+    auto *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(set), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [property](QDBusPendingCallWatcher *pending) {
+        if (pending->isError()) {
+            qWarning() << "Failed to set" << property << ":" << pending->error().message();
+        }
+        pending->deleteLater();
+    });
+
+    return true;
 }
 
 } // namespace VivoX::System
@@ -3,6 +3,13 @@
 #include <QObject>
 #include <QString>
 #include <QVariantMap>
+#include <QHash>
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QElapsedTimer>
+
+class QDBusServiceWatcher;
+class QDBusPendingCallWatcher;
 
 namespace VivoX::System {
 
@@ -17,8 +24,10 @@ public:
     QString artist;       ///< Artist of the media
     QString album;        ///< Album of the media
     QString artUrl;       ///< URL to the album art
+    QString trackId;      ///< MPRIS track object path, used for seeking
     qint64 length;        ///< Length of the media in microseconds
     qint64 position;      ///< Current position in microseconds
+    double rate;          ///< Playback rate used to advance the position
     double volume;        ///< Current volume (0.0 to 1.0)
     bool canPlay;         ///< Whether the player can play
     bool canPause;        ///< Whether the player can pause
@@ -35,12 +44,26 @@ public:
  * 
  * It provides an interface to MPRIS-compatible media players via D-Bus
  * for controlling media playback and retrieving media information.
+ *
+ * Player state is kept up to date by D-Bus signals only: players are
+ * discovered through NameOwnerChanged (matched on the MPRIS name prefix),
+ * their properties are fetched with one asynchronous GetAll and then
+ * followed through PropertiesChanged and Seeked. The playback position is
+ * interpolated locally instead of being polled.
  */
-class MediaController : public QObject {
+class MediaController : public QObject, protected QDBusContext {
     Q_OBJECT
 
 public:
     explicit MediaController(QObject *parent = nullptr);
+
+    /**
+     * @brief Create a media controller on a specific bus connection
+     * @param connection The bus to watch for players
+     * @param parent The parent object
+     */
+    explicit MediaController(const QDBusConnection &connection, QObject *parent = nullptr);
+
     ~MediaController();
 
     /**
@@ -62,6 +85,17 @@ public:
      */
     MediaInfo getMediaInfo(const QString &playerId = QString()) const;
 
+    /**
+     * @brief Get the current playback position
+     *
+     * The position is extrapolated from the last reported value and the
+     * playback rate, so it can be read every frame without D-Bus traffic.
+     *
+     * @param playerId The player ID, or empty for the active player
+     * @return The position in microseconds
+     */
+    qint64 getPosition(const QString &playerId = QString()) const;
+
     /**
      * @brief Play media
      * @param playerId The player ID, or empty for the active player
@@ -161,18 +195,53 @@ signals:
      */
     void mediaInfoChanged(const MediaInfo &info);
 
+private slots:
+    void handleServiceOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner);
+    void handlePropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+    void handleSeeked(qlonglong position);
+
 private:
+    // Bus the players live on
+    QDBusConnection m_connection;
+    
+    // Watches org.mpris.MediaPlayer2.* names appearing and vanishing
+    QDBusServiceWatcher *m_serviceWatcher;
+    
     // Map of player ID to media info
     QHash<QString, MediaInfo> m_mediaInfo;
     
+    // Map of unique bus name to player ID, to attribute signals
+    QHash<QString, QString> m_owners;
+    
+    // Monotonic time (ms) at which each player's position was sampled
+    QHash<QString, qint64> m_positionTimestamps;
+    
+    // Clock for position interpolation
+    QElapsedTimer m_clock;
+    
     // Active player ID
     QString m_activePlayerId;
     
     // Get the player ID to use
     QString getPlayerIdToUse(const QString &playerId) const;
     
-    // Update media information from D-Bus
-    void updateMediaInfo();
+    // Start or stop tracking a player
+    void addPlayer(const QString &service, const QString &owner);
+    void removePlayer(const QString &service);
+    
+    // Fetch all properties of a player interface asynchronously
+    void requestProperties(const QString &service, const QString &interface);
+    void requestPosition(const QString &service);
+    
+    // Apply changed properties to a player and notify
+    void applyProperties(const QString &service, const QString &interface, const QVariantMap &properties);
+    void setPosition(const QString &service, qint64 position);
+    qint64 interpolatedPosition(const QString &service) const;
+    void updateActivePlayer(const QString &service);
+    
+    // Send a player command without waiting for the reply
+    bool callPlayer(const QString &playerId, const QString &method, const QVariantList &arguments, const char *action);
+    bool setPlayerProperty(const QString &playerId, const QString &property, const QVariant &value, const char *action);
 };
 
 } // namespace VivoX::System
@@ -0,0 +1,588 @@
+#include "NetlinkMonitor.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/if.h>
+#include <linux/if_arp.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+namespace VivoX::System {
+
+namespace {
+    // Large enough for a full dump batch of a busy host
+    const int receiveBufferSize = 1024 * 1024;
+
+    // Failed dumps are retried after 100 ms, backing off up to 30 s
+    const int initialRetryDelay = 100;
+    const int maxRetryDelay = 30000;
+
+    QString formatAddress(int family, const void *data)
+    {
+        char buffer[INET6_ADDRSTRLEN] = {};
+        if (!inet_ntop(family, data, buffer, sizeof(buffer))) {
+            return QString();
+        }
+        return QString::fromLatin1(buffer);
+    }
+
+    QString formatHardwareAddress(const unsigned char *data, int length)
+    {
+        QStringList bytes;
+        for (int i = 0; i < length; ++i) {
+            bytes.append(QStringLiteral("%1").arg(data[i], 2, 16, QLatin1Char('0')).toUpper());
+        }
+        return bytes.join(QLatin1Char(':'));
+    }
+
+    QString routeKey(const rtmsg *route, quint32 table, quint32 priority)
+    {
+        return QStringLiteral("%1:%2:%3").arg(route->rtm_family).arg(table).arg(priority);
+    }
+
+    void removeRoutes(QHash<QString, int> &routes, int index)
+    {
+        for (auto it = routes.begin(); it != routes.end();) {
+            it = it.value() == index ? routes.erase(it) : std::next(it);
+        }
+    }
+}
+
+NetlinkMonitor::NetlinkMonitor(QObject *parent)
+    : QObject(parent)
+    , m_socket(-1)
+    , m_notifier(nullptr)
+    , m_sequence(0)
+    , m_dump(Dump::None)
+    , m_synchronized(false)
+    , m_retryTimer(new QTimer(this))
+    , m_retryDelay(initialRetryDelay)
+{
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &NetlinkMonitor::startResync);
+}
+
+NetlinkMonitor::~NetlinkMonitor()
+{
+    if (m_socket >= 0) {
+        close(m_socket);
+    }
+}
+
+bool NetlinkMonitor::start()
+{
+    if (m_socket >= 0) {
+        return true;
+    }
+
+    m_socket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (m_socket < 0) {
+        qWarning() << "Failed to open rtnetlink socket:" << strerror(errno);
+        return false;
+    }
+
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR
+                      | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+
+    if (bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        qWarning() << "Failed to bind rtnetlink socket:" << strerror(errno);
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &NetlinkMonitor::readMessages);
+
+    // Events arriving from here on are applied on top of the dumps
+    startResync();
+    return true;
+}
+
+bool NetlinkMonitor::isSynchronized() const
+{
+    return m_synchronized;
+}
+
+QList<LinkState> NetlinkMonitor::links() const
+{
+    return m_links.values();
+}
+
+LinkState NetlinkMonitor::link(int index) const
+{
+    return m_links.value(index);
+}
+
+bool NetlinkMonitor::requestDump(Dump dump)
+{
+    struct {
+        nlmsghdr header;
+        rtgenmsg message;
+    } request = {};
+
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(rtgenmsg));
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++m_sequence;
+    request.message.rtgen_family = AF_UNSPEC;
+
+    switch (dump) {
+    case Dump::Links:
+        request.header.nlmsg_type = RTM_GETLINK;
+        m_dumpedLinks.clear();
+        break;
+    case Dump::Addresses:
+        request.header.nlmsg_type = RTM_GETADDR;
+        m_dumpedAddresses.clear();
+        break;
+    case Dump::Routes:
+        request.header.nlmsg_type = RTM_GETROUTE;
+        m_dumpedRoutes.clear();
+        break;
+    case Dump::None:
+        return false;
+    }
+
+    sockaddr_nl kernel = {};
+    kernel.nl_family = AF_NETLINK;
+
+    if (sendto(m_socket, &request, request.header.nlmsg_len, 0,
+               reinterpret_cast<sockaddr *>(&kernel), sizeof(kernel)) < 0) {
+        qWarning() << "Failed to request rtnetlink dump:" << strerror(errno);
+        scheduleRetry();
+        return false;
+    }
+
+    m_dump = dump;
+    return true;
+}
+
+void NetlinkMonitor::startResync()
+{
+    m_retryTimer->stop();
+    requestDump(Dump::Links);
+}
+
+void NetlinkMonitor::scheduleRetry()
+{
+    // Start over from the links; a partly applied dump is reconciled again
+    m_dump = Dump::None;
+    m_retryTimer->start(m_retryDelay);
+    m_retryDelay = qMin(m_retryDelay * 2, maxRetryDelay);
+}
+
+void NetlinkMonitor::finishDump()
+{
+    switch (m_dump) {
+    case Dump::Links: {
+        // Links missing from the dump disappeared while events were lost
+        const QList<int> indices = m_links.keys();
+        for (int index : indices) {
+            if (!m_dumpedLinks.contains(index)) {
+                touch(index);
+                m_links.remove(index);
+            }
+        }
+        requestDump(Dump::Addresses);
+        break;
+    }
+    case Dump::Addresses:
+        for (auto it = m_links.begin(); it != m_links.end(); ++it) {
+            const QList<LinkAddress> addresses = m_dumpedAddresses.value(it.key());
+            if (it.value().addresses != addresses) {
+                touch(it.key());
+                it.value().addresses = addresses;
+            }
+        }
+        requestDump(Dump::Routes);
+        break;
+    case Dump::Routes: {
+        QSet<int> affected;
+        for (int index : std::as_const(m_defaultRoutes)) {
+            affected.insert(index);
+        }
+        for (int index : std::as_const(m_dumpedRoutes)) {
+            affected.insert(index);
+        }
+
+        m_defaultRoutes = m_dumpedRoutes;
+        for (int index : std::as_const(affected)) {
+            updateDefaultRoute(index);
+        }
+
+        m_dump = Dump::None;
+        m_retryDelay = initialRetryDelay;
+        if (!m_synchronized) {
+            m_synchronized = true;
+            flushChanges();
+            emit synchronized();
+        }
+        break;
+    }
+    case Dump::None:
+        break;
+    }
+}
+
+void NetlinkMonitor::readMessages()
+{
+    alignas(nlmsghdr) char buffer[64 * 1024];
+
+    for (;;) {
+        sockaddr_nl sender = {};
+        iovec vector = { buffer, sizeof(buffer) };
+        msghdr header = {};
+        header.msg_name = &sender;
+        header.msg_namelen = sizeof(sender);
+        header.msg_iov = &vector;
+        header.msg_iovlen = 1;
+
+        ssize_t length = recvmsg(m_socket, &header, 0);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == ENOBUFS) {
+                // Events were dropped; rebuild the table unless a dump is already running
+                qWarning() << "rtnetlink events lost, resynchronizing";
+                if (m_dump == Dump::None) {
+                    startResync();
+                }
+                continue;
+            }
+            break;
+        }
+
+        // Only the kernel may change the table
+        if (sender.nl_pid != 0 || (header.msg_flags & MSG_TRUNC)) {
+            continue;
+        }
+
+        for (auto *message = reinterpret_cast<nlmsghdr *>(buffer);
+             NLMSG_OK(message, length);
+             message = NLMSG_NEXT(message, length)) {
+            const bool dumpReply = m_dump != Dump::None && message->nlmsg_seq == m_sequence;
+
+            if (message->nlmsg_type == NLMSG_DONE) {
+                if (dumpReply && (message->nlmsg_flags & NLM_F_DUMP_INTR)) {
+                    // The kernel state changed during the dump; it may be inconsistent
+                    requestDump(m_dump);
+                } else if (dumpReply) {
+                    finishDump();
+                }
+                continue;
+            }
+
+            if (message->nlmsg_type == NLMSG_ERROR) {
+                auto *error = static_cast<nlmsgerr *>(NLMSG_DATA(message));
+                if (dumpReply && error->error != 0) {
+                    qWarning() << "rtnetlink dump failed, retrying in" << m_retryDelay << "ms:" << strerror(-error->error);
+                    scheduleRetry();
+                }
+                continue;
+            }
+
+            handleMessage(message);
+        }
+    }
+
+    // Until the initial dump is complete the table is not worth reporting
+    if (m_synchronized) {
+        flushChanges();
+    }
+}
+
+void NetlinkMonitor::handleMessage(const void *message)
+{
+    const auto *header = static_cast<const nlmsghdr *>(message);
+
+    switch (header->nlmsg_type) {
+    case RTM_NEWLINK:
+    case RTM_DELLINK:
+        handleLink(header, header->nlmsg_type == RTM_DELLINK);
+        break;
+    case RTM_NEWADDR:
+    case RTM_DELADDR:
+        handleAddress(header, header->nlmsg_type == RTM_DELADDR);
+        break;
+    case RTM_NEWROUTE:
+    case RTM_DELROUTE:
+        handleRoute(header, header->nlmsg_type == RTM_DELROUTE);
+        break;
+    default:
+        break;
+    }
+}
+
+void NetlinkMonitor::handleLink(const void *message, bool removed)
+{
+    const auto *header = static_cast<const nlmsghdr *>(message);
+    const auto *info = static_cast<const ifinfomsg *>(NLMSG_DATA(header));
+
+    // Bridge port notifications describe the port, not the link
+    if (info->ifi_family != AF_UNSPEC || header->nlmsg_len < NLMSG_LENGTH(sizeof(ifinfomsg))) {
+        return;
+    }
+
+    const int index = info->ifi_index;
+    touch(index);
+
+    // The kernel flushes IPv4 routes of a downed link without notification
+    if (removed || !(info->ifi_flags & IFF_UP)) {
+        removeRoutes(m_defaultRoutes, index);
+        removeRoutes(m_dumpedRoutes, index);
+    }
+
+    if (removed) {
+        m_links.remove(index);
+        m_dumpedLinks.remove(index);
+        return;
+    }
+
+    LinkState &link = m_links[index];
+    const QString previousName = link.name;
+    link.defaultRoute = false;
+    for (int routeIndex : std::as_const(m_defaultRoutes)) {
+        link.defaultRoute = link.defaultRoute || routeIndex == index;
+    }
+    link.index = index;
+    link.hardwareType = info->ifi_type;
+    link.flags = info->ifi_flags;
+
+    int length = IFLA_PAYLOAD(header);
+    for (auto *attribute = IFLA_RTA(info); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        switch (attribute->rta_type) {
+        case IFLA_IFNAME:
+            link.name = QString::fromUtf8(static_cast<const char *>(RTA_DATA(attribute)));
+            break;
+        case IFLA_MTU:
+            link.mtu = *static_cast<const quint32 *>(RTA_DATA(attribute));
+            break;
+        case IFLA_OPERSTATE:
+            link.operState = *static_cast<const quint8 *>(RTA_DATA(attribute));
+            break;
+        case IFLA_ADDRESS:
+            link.hardwareAddress = formatHardwareAddress(static_cast<const unsigned char *>(RTA_DATA(attribute)),
+                                                         RTA_PAYLOAD(attribute));
+            break;
+        case IFLA_LINKINFO: {
+            int nestedLength = RTA_PAYLOAD(attribute);
+            for (auto *nested = static_cast<rtattr *>(RTA_DATA(attribute)); RTA_OK(nested, nestedLength);
+                 nested = RTA_NEXT(nested, nestedLength)) {
+                if (nested->rta_type == IFLA_INFO_KIND) {
+                    link.kind = QString::fromUtf8(static_cast<const char *>(RTA_DATA(nested)));
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Wireless devices are only distinguishable through sysfs; check once per name
+    if (link.name != previousName) {
+        const QString path = QStringLiteral("/sys/class/net/") + link.name;
+        link.wireless = QFileInfo::exists(path + QStringLiteral("/wireless"))
+                     || QFileInfo::exists(path + QStringLiteral("/phy80211"));
+    }
+
+    if (m_dump == Dump::Links) {
+        m_dumpedLinks.insert(index);
+    }
+}
+
+void NetlinkMonitor::handleAddress(const void *message, bool removed)
+{
+    const auto *header = static_cast<const nlmsghdr *>(message);
+    const auto *info = static_cast<const ifaddrmsg *>(NLMSG_DATA(header));
+
+    if (header->nlmsg_len < NLMSG_LENGTH(sizeof(ifaddrmsg))) {
+        return;
+    }
+
+    const void *local = nullptr;
+    const void *address = nullptr;
+
+    int length = IFA_PAYLOAD(header);
+    for (auto *attribute = IFA_RTA(info); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        if (attribute->rta_type == IFA_LOCAL) {
+            local = RTA_DATA(attribute);
+        } else if (attribute->rta_type == IFA_ADDRESS) {
+            address = RTA_DATA(attribute);
+        }
+    }
+
+    // On point-to-point links IFA_ADDRESS is the peer; IFA_LOCAL is ours
+    const void *data = local ? local : address;
+    if (!data) {
+        return;
+    }
+
+    LinkAddress entry;
+    entry.address = formatAddress(info->ifa_family, data);
+    entry.prefixLength = info->ifa_prefixlen;
+    entry.scope = info->ifa_scope;
+
+    const int index = info->ifa_index;
+
+    // Addresses seen during the address dump are reconciled when it completes
+    if (m_dump == Dump::Addresses) {
+        QList<LinkAddress> &dumped = m_dumpedAddresses[index];
+        dumped.removeAll(entry);
+        if (!removed) {
+            dumped.append(entry);
+        }
+    }
+
+    if (!m_links.contains(index)) {
+        return;
+    }
+
+    touch(index);
+    QList<LinkAddress> &addresses = m_links[index].addresses;
+    addresses.removeAll(entry);
+    if (!removed) {
+        addresses.append(entry);
+    }
+}
+
+void NetlinkMonitor::handleRoute(const void *message, bool removed)
+{
+    const auto *header = static_cast<const nlmsghdr *>(message);
+    const auto *route = static_cast<const rtmsg *>(NLMSG_DATA(header));
+
+    if (header->nlmsg_len < NLMSG_LENGTH(sizeof(rtmsg))) {
+        return;
+    }
+
+    // Only default unicast routes matter
+    if (route->rtm_dst_len != 0 || route->rtm_type != RTN_UNICAST
+        || (route->rtm_family != AF_INET && route->rtm_family != AF_INET6)) {
+        return;
+    }
+
+    quint32 table = route->rtm_table;
+    quint32 priority = 0;
+    int outputIndex = 0;
+
+    int length = RTM_PAYLOAD(header);
+    for (auto *attribute = RTM_RTA(route); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        switch (attribute->rta_type) {
+        case RTA_TABLE:
+            table = *static_cast<const quint32 *>(RTA_DATA(attribute));
+            break;
+        case RTA_PRIORITY:
+            priority = *static_cast<const quint32 *>(RTA_DATA(attribute));
+            break;
+        case RTA_OIF:
+            outputIndex = *static_cast<const quint32 *>(RTA_DATA(attribute));
+            break;
+        case RTA_MULTIPATH:
+            // Attribute a multipath route to its first hop
+            if (!outputIndex && RTA_PAYLOAD(attribute) >= sizeof(rtnexthop)) {
+                outputIndex = static_cast<const rtnexthop *>(RTA_DATA(attribute))->rtnh_ifindex;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (table != RT_TABLE_MAIN) {
+        return;
+    }
+
+    const QString key = routeKey(route, table, priority);
+
+    if (m_dump == Dump::Routes) {
+        if (removed) {
+            m_dumpedRoutes.remove(key);
+        } else {
+            m_dumpedRoutes.insert(key, outputIndex);
+        }
+    }
+
+    const int previousIndex = m_defaultRoutes.value(key);
+    if (removed) {
+        m_defaultRoutes.remove(key);
+    } else {
+        m_defaultRoutes.insert(key, outputIndex);
+    }
+
+    updateDefaultRoute(previousIndex);
+    updateDefaultRoute(outputIndex);
+}
+
+void NetlinkMonitor::updateDefaultRoute(int index)
+{
+    auto it = m_links.find(index);
+    if (it == m_links.end()) {
+        return;
+    }
+
+    bool defaultRoute = false;
+    for (int routeIndex : std::as_const(m_defaultRoutes)) {
+        if (routeIndex == index) {
+            defaultRoute = true;
+            break;
+        }
+    }
+
+    if (it.value().defaultRoute != defaultRoute) {
+        touch(index);
+        it.value().defaultRoute = defaultRoute;
+    }
+}
+
+void NetlinkMonitor::touch(int index)
+{
+    if (m_before.contains(index) || m_missingBefore.contains(index)) {
+        return;
+    }
+
+    auto it = m_links.constFind(index);
+    if (it != m_links.constEnd()) {
+        m_before.insert(index, it.value());
+    } else {
+        m_missingBefore.insert(index);
+    }
+}
+
+void NetlinkMonitor::flushChanges()
+{
+    const QHash<int, LinkState> before = std::exchange(m_before, {});
+    const QSet<int> missingBefore = std::exchange(m_missingBefore, {});
+
+    for (int index : missingBefore) {
+        auto it = m_links.constFind(index);
+        if (it != m_links.constEnd()) {
+            emit linkAdded(it.value());
+        }
+    }
+
+    for (auto previous = before.constBegin(); previous != before.constEnd(); ++previous) {
+        auto it = m_links.constFind(previous.key());
+        if (it == m_links.constEnd()) {
+            emit linkRemoved(previous.value());
+        } else if (it.value() != previous.value()) {
+            emit linkChanged(it.value(), previous.value());
+        }
+    }
+}
+
+} // namespace VivoX::System
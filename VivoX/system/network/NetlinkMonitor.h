@@ -0,0 +1,177 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QSocketNotifier;
+class QTimer;
+
+namespace VivoX::System {
+
+/**
+ * @brief An address assigned to a link.
+ */
+struct LinkAddress {
+    QString address;      ///< Address in textual form
+    int prefixLength = 0; ///< Prefix length of the subnet
+    int scope = 0;        ///< Address scope (RT_SCOPE_*)
+
+    bool operator==(const LinkAddress &other) const {
+        return address == other.address && prefixLength == other.prefixLength && scope == other.scope;
+    }
+};
+
+/**
+ * @brief State of a network link as reported by the kernel.
+ */
+struct LinkState {
+    int index = 0;                 ///< Interface index
+    QString name;                  ///< Interface name
+    QString kind;                  ///< Link kind (veth, bridge, tun, ...), empty for hardware links
+    QString hardwareAddress;       ///< Link layer address
+    uint hardwareType = 0;         ///< Link layer type (ARPHRD_*)
+    uint flags = 0;                ///< Interface flags (IFF_*)
+    uint operState = 0;            ///< Operational state (IF_OPER_*)
+    int mtu = 0;                   ///< Maximum transmission unit
+    bool wireless = false;         ///< Whether the link is a wireless device
+    bool defaultRoute = false;     ///< Whether a default route goes through the link
+    QList<LinkAddress> addresses;  ///< Assigned addresses
+
+    bool operator==(const LinkState &other) const {
+        return index == other.index && name == other.name && kind == other.kind
+            && hardwareAddress == other.hardwareAddress && hardwareType == other.hardwareType
+            && flags == other.flags && operState == other.operState && mtu == other.mtu
+            && wireless == other.wireless && defaultRoute == other.defaultRoute
+            && addresses == other.addresses;
+    }
+    bool operator!=(const LinkState &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Keeps a table of network links up to date from rtnetlink events.
+ *
+ * The monitor subscribes to the kernel's link, address and route multicast
+ * groups and seeds its table with one dump of each. From then on it only
+ * reacts to events, so nothing is polled. Events read in one batch are
+ * applied together and only links whose state actually changed are
+ * reported.
+ *
+ * If the socket buffer overflows and events are lost, the table is
+ * reconciled with a fresh dump. Dumps the kernel refuses are retried with
+ * a growing delay.
+ */
+class NetlinkMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit NetlinkMonitor(QObject *parent = nullptr);
+    ~NetlinkMonitor();
+
+    /**
+     * @brief Open the rtnetlink socket and request the initial state
+     * @return True if the socket could be opened
+     */
+    bool start();
+
+    /**
+     * @brief Check if the initial dump has been applied
+     * @return True once the table reflects the kernel state
+     */
+    bool isSynchronized() const;
+
+    /**
+     * @brief Get all known links
+     * @return List of link states
+     */
+    QList<LinkState> links() const;
+
+    /**
+     * @brief Get a link by interface index
+     * @param index The interface index
+     * @return The link state, or a default state with index 0 if unknown
+     */
+    LinkState link(int index) const;
+
+signals:
+    /**
+     * @brief Signal emitted when a link appears
+     * @param link The new link state
+     */
+    void linkAdded(const LinkState &link);
+
+    /**
+     * @brief Signal emitted when the state of a link changes
+     * @param link The updated link state
+     * @param previous The state before the change
+     */
+    void linkChanged(const LinkState &link, const LinkState &previous);
+
+    /**
+     * @brief Signal emitted when a link disappears
+     * @param link The last known state of the link
+     */
+    void linkRemoved(const LinkState &link);
+
+    /**
+     * @brief Signal emitted when the initial dump has been applied
+     */
+    void synchronized();
+
+private slots:
+    void readMessages();
+
+private:
+    // Dumps requested in order to (re)build the table
+    enum class Dump {
+        None,
+        Links,
+        Addresses,
+        Routes
+    };
+
+    bool requestDump(Dump dump);
+    void startResync();
+    void scheduleRetry();
+    void finishDump();
+
+    void handleMessage(const void *message);
+    void handleLink(const void *message, bool removed);
+    void handleAddress(const void *message, bool removed);
+    void handleRoute(const void *message, bool removed);
+
+    // Record the state of a link before the first change in a batch
+    void touch(int index);
+    void updateDefaultRoute(int index);
+    void flushChanges();
+
+    int m_socket;
+    QSocketNotifier *m_notifier;
+    quint32 m_sequence;
+
+    Dump m_dump;
+    bool m_synchronized;
+
+    // Restarts the dumps after a failure
+    QTimer *m_retryTimer;
+    int m_retryDelay;
+
+    // Link table keyed by interface index
+    QHash<int, LinkState> m_links;
+
+    // Default routes keyed by family, metric and table, mapped to their output link
+    QHash<QString, int> m_defaultRoutes;
+
+    // Reconciliation state of the running dump
+    QSet<int> m_dumpedLinks;
+    QHash<int, QList<LinkAddress>> m_dumpedAddresses;
+    QHash<QString, int> m_dumpedRoutes;
+
+    // Link states before the current batch of messages, for change detection
+    QHash<int, LinkState> m_before;
+    QSet<int> m_missingBefore;
+};
+
+} // namespace VivoX::System
@@ -1,18 +1,19 @@
 #include "NetworkManager.h"
+#include "NetlinkMonitor.h"
 
 #include <QDebug>
-#include <QDBusConnection>
-#include <QDBusInterface>
-#include <QDBusReply>
-#include <QDBusMessage>
-#include <QDBusArgument>
-#include <QNetworkInterface>
 #include <QProcess>
+#include <QTimer>
+
+#include <linux/if.h>
+#include <linux/if_arp.h>
+#include <linux/rtnetlink.h>
 
 namespace VivoX::System {
 
 NetworkManager::NetworkManager(QObject *parent)
     : QObject(parent)
+    , m_netlink(new NetlinkMonitor(this))
     , m_networkingEnabled(false)
     , m_wirelessEnabled(false)
 {
@@ -26,39 +27,16 @@ NetworkManager::~NetworkManager()
 
 bool NetworkManager::initialize()
 {
-    // Connect to NetworkManager via D-Bus
-    QDBusConnection systemBus = QDBusConnection::systemBus();
+    connect(m_netlink, &NetlinkMonitor::linkAdded, this, &NetworkManager::handleLinkAdded);
+    connect(m_netlink, &NetlinkMonitor::linkChanged, this, &NetworkManager::handleLinkChanged);
+    connect(m_netlink, &NetlinkMonitor::linkRemoved, this, &NetworkManager::handleLinkRemoved);
     
-    if (!systemBus.isConnected()) {
-        qWarning() << "Cannot connect to system D-Bus";
-        
-        // Fallback: Use QNetworkInterface to get basic network information
-        updateNetworkInfo();
-        
+    // The initial interface table arrives asynchronously as link additions
+    if (!m_netlink->start()) {
+        qWarning() << "Cannot monitor network interfaces";
         return false;
     }
     
-    // Connect to NetworkManager signals
-    systemBus.connect("org.freedesktop.NetworkManager", 
-                     "/org/freedesktop/NetworkManager",
-                     "org.freedesktop.NetworkManager",
-                     "PropertiesChanged",
-                     this, SLOT(updateNetworkInfo()));
-    
-    systemBus.connect("org.freedesktop.NetworkManager", 
-                     "/org/freedesktop/NetworkManager",
-                     "org.freedesktop.NetworkManager",
-                     "DeviceAdded",
-                     this, SLOT(updateNetworkInfo()));
-    
-    systemBus.connect("org.freedesktop.NetworkManager", 
-                     "/org/freedesktop/NetworkManager",
-                     "org.freedesktop.NetworkManager",
-                     "DeviceRemoved",
-                     this, SLOT(updateNetworkInfo()));
-    
-    // Get initial network information
-    updateNetworkInfo();
     updateAvailableWirelessNetworks();
     
     qDebug() << "NetworkManager initialized";
@@ -284,131 +262,130 @@ bool NetworkManager::isWirelessEnabled() const
     return m_wirelessEnabled;
 }
 
-void NetworkManager::updateNetworkInfo()
+void NetworkManager::handleLinkAdded(const LinkState &link)
 {
-    // In a real implementation, we would use NetworkManager D-Bus API to get network information
-    // For now, we'll use QNetworkInterface to get basic information
+    // Skip loopback interfaces
+    if (link.flags & IFF_LOOPBACK) {
+        return;
+    }
     
-    QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
+    NetworkInfo info = networkInfoFor(link);
+    m_linkIds[link.index] = info.id;
+    m_networks[info.id] = info;
     
-    // Create a set of existing network IDs to track removed networks
-    QSet<QString> existingIds = QSet<QString>::fromList(m_networks.keys());
+    emit networkAdded(info);
     
-    // Process each interface
-    for (const QNetworkInterface &interface : interfaces) {
-        // Skip loopback and non-active interfaces
-        if (interface.flags().testFlag(QNetworkInterface::IsLoopBack) ||
-            !interface.flags().testFlag(QNetworkInterface::IsUp) ||
-            !interface.flags().testFlag(QNetworkInterface::IsRunning)) {
-            continue;
-        }
-        
-        QString id = interface.name();
-        
-        // Determine network type
-        QString type;
-        if (id.startsWith("wlan") || id.startsWith("wlp")) {
-            type = "wifi";
-        } else if (id.startsWith("eth") || id.startsWith("enp")) {
-            type = "ethernet";
-        } else if (id.startsWith("tun") || id.startsWith("tap")) {
-            type = "vpn";
-        } else {
-            type = "other";
-        }
-        
-        // Determine state
-        QString state;
-        if (interface.flags().testFlag(QNetworkInterface::IsRunning)) {
-            bool hasAddress = false;
-            for (const QNetworkAddressEntry &entry : interface.addressEntries()) {
-                if (entry.ip() != QHostAddress::LocalHost && !entry.ip().isNull()) {
-                    hasAddress = true;
-                    break;
-                }
-            }
-            
-            state = hasAddress ? "connected" : "disconnected";
-        } else {
-            state = "disconnected";
+    updateEnabledStates();
+}
+
+void NetworkManager::handleLinkChanged(const LinkState &link, const LinkState &previous)
+{
+    if (link.flags & IFF_LOOPBACK) {
+        return;
+    }
+    
+    NetworkInfo info = networkInfoFor(link);
+    const QString id = m_linkIds.value(link.index);
+    
+    // A renamed interface is a different network to the UI
+    if (id != info.id) {
+        handleLinkRemoved(previous);
+        handleLinkAdded(link);
+        return;
+    }
+    
+    NetworkInfo &current = m_networks[id];
+    if (current.state != info.state || current.isDefault != info.isDefault ||
+        current.type != info.type || current.details != info.details) {
+        current = info;
+        emit networkStateChanged(current);
+    }
+    
+    if ((link.flags ^ previous.flags) & IFF_UP) {
+        updateEnabledStates();
+    }
+}
+
+void NetworkManager::handleLinkRemoved(const LinkState &link)
+{
+    const QString id = m_linkIds.take(link.index);
+    
+    if (id.isEmpty()) {
+        return;
+    }
+    
+    if (m_networks.remove(id)) {
+        emit networkRemoved(id);
+        qDebug() << "Removed network:" << id;
+    }
+    
+    updateEnabledStates();
+}
+
+NetworkInfo NetworkManager::networkInfoFor(const LinkState &link)
+{
+    NetworkInfo info;
+    info.id = link.name;
+    info.name = link.name;
+    
+    // Classify by what the kernel reports rather than by interface name
+    if (link.wireless) {
+        info.type = "wifi";
+    } else if (link.hardwareType == ARPHRD_NONE || link.kind == "tun" || link.kind == "wireguard") {
+        info.type = "vpn";
+    } else if (link.hardwareType == ARPHRD_ETHER && (link.kind.isEmpty() || link.kind == "veth")) {
+        info.type = "ethernet";
+    } else {
+        info.type = "other";
+    }
+    
+    // Connected means carrier and an address usable beyond the link
+    bool hasAddress = false;
+    QStringList addressList;
+    for (const LinkAddress &address : link.addresses) {
+        if (address.scope < RT_SCOPE_HOST) {
+            addressList.append(address.address);
         }
-        
-        // Create or update network info
-        if (m_networks.contains(id)) {
-            NetworkInfo &info = m_networks[id];
-            
-            // Check if state changed
-            if (info.state != state) {
-                info.state = state;
-                emit networkStateChanged(info);
-            }
-            
-            // Remove from existing IDs
-            existingIds.remove(id);
-        } else {
-            NetworkInfo info;
-            info.id = id;
-            info.name = interface.humanReadableName();
-            info.type = type;
-            info.state = state;
-            info.isDefault = false;
-            
-            // Add details
-            QVariantMap details;
-            details["hardwareAddress"] = interface.hardwareAddress();
-            details["mtu"] = interface.maximumTransmissionUnit();
-            
-            QStringList addressList;
-            for (const QNetworkAddressEntry &entry : interface.addressEntries()) {
-                if (entry.ip() != QHostAddress::LocalHost && !entry.ip().isNull()) {
-                    addressList.append(entry.ip().toString());
-                }
-            }
-            details["addresses"] = addressList;
-            
-            info.details = details;
-            
-            // Add to networks
-            m_networks[id] = info;
-            
-            // Emit signal
-            emit networkAdded(info);
+        if (address.scope < RT_SCOPE_LINK) {
+            hasAddress = true;
         }
     }
     
-    // Remove networks that no longer exist
-    for (const QString &id : existingIds) {
-        // Skip wireless networks that we're managing ourselves
-        if (id.startsWith("wifi-")) {
+    const bool running = (link.flags & IFF_UP) && (link.flags & IFF_RUNNING);
+    info.state = running && hasAddress ? "connected" : "disconnected";
+    info.isDefault = link.defaultRoute;
+    
+    // Add details
+    QVariantMap details;
+    details["index"] = link.index;
+    details["kind"] = link.kind;
+    details["hardwareAddress"] = link.hardwareAddress;
+    details["mtu"] = link.mtu;
+    details["addresses"] = addressList;
+    info.details = details;
+    
+    return info;
+}
+
+void NetworkManager::updateEnabledStates()
+{
+    bool networking = false;
+    bool wireless = false;
+    
+    for (const LinkState &link : m_netlink->links()) {
+        if ((link.flags & IFF_LOOPBACK) || !(link.flags & IFF_UP)) {
             continue;
         }
         
-        // Remove network
-        NetworkInfo info = m_networks.take(id);
-        
-        // Emit signal
-        emit networkRemoved(id);
-        
-        qDebug() << "Removed network:" << id;
+        networking = true;
+        wireless = wireless || link.wireless;
     }
     
-    // Update networking enabled state
-    bool networking = !interfaces.isEmpty();
     if (m_networkingEnabled != networking) {
         m_networkingEnabled = networking;
         emit networkingEnabledChanged(m_networkingEnabled);
     }
     
-    // Update wireless enabled state
-    bool wireless = false;
-    for (const QNetworkInterface &interface : interfaces) {
-        if ((interface.name().startsWith("wlan") || interface.name().startsWith("wlp")) &&
-            interface.flags().testFlag(QNetworkInterface::IsUp)) {
-            wireless = true;
-            break;
-        }
-    }
-    
     if (m_wirelessEnabled != wireless) {
         m_wirelessEnabled = wireless;
         emit wirelessEnabledChanged(m_wirelessEnabled);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QStringList>
@@ -7,6 +8,9 @@
 
 namespace VivoX::System {
 
+class NetlinkMonitor;
+struct LinkState;
+
 /**
  * @brief The NetworkInfo class contains information about a network connection.
  */
@@ -25,6 +29,11 @@ public:
  * 
  * It provides an interface to NetworkManager via D-Bus for monitoring and
  * controlling network connections.
+ *
+ * Interface state comes from an rtnetlink monitor: the interface table is
+ * updated incrementally from kernel link, address and route events, and
+ * only networks whose state actually changed are signalled. Nothing is
+ * polled or rescanned.
  */
 class NetworkManager : public QObject {
     Q_OBJECT
@@ -141,10 +150,21 @@ signals:
      */
     void wirelessEnabledChanged(bool enabled);
 
+private slots:
+    void handleLinkAdded(const LinkState &link);
+    void handleLinkChanged(const LinkState &link, const LinkState &previous);
+    void handleLinkRemoved(const LinkState &link);
+
 private:
+    // Kernel interface state
+    NetlinkMonitor *m_netlink;
+    
     // Map of network ID to network info
     QHash<QString, NetworkInfo> m_networks;
     
+    // Map of interface index to network ID
+    QHash<int, QString> m_linkIds;
+    
     // List of available wireless networks
     QList<NetworkInfo> m_availableWirelessNetworks;
     
@@ -154,8 +174,11 @@ private:
     // Wireless enabled state
     bool m_wirelessEnabled;
     
-    // Update network information from D-Bus
-    void updateNetworkInfo();
+    // Describe a kernel link as a network
+    static NetworkInfo networkInfoFor(const LinkState &link);
+    
+    // Recompute the networking and wireless enabled states
+    void updateEnabledStates();
     
     // Update available wireless networks from D-Bus
     void updateAvailableWirelessNetworks();
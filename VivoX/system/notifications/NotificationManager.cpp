@@ -6,10 +6,88 @@
 
 namespace VivoX::System {
 
+namespace {
+// Expiry deadlines are rounded up to this many milliseconds
+const qint64 ExpiryResolution = 50;
+
+// Updates reach the UI at most once per frame
+const int FrameInterval = 16;
+
+// Default per-application rate limit for new notifications
+const int DefaultBurst = 10;
+const double DefaultRefillRate = 2.0;
+
+// Default history bounds
+const int DefaultHistoryEntries = 500;
+const qint64 DefaultHistoryBytes = 256 * 1024;
+
+const char MergedCountHint[] = "x-vivox-merged-count";
+
+// Hints carrying raw image data, which are not kept in the history
+const char *const ImageDataHints[] = { "image-data", "image_data", "icon_data" };
+
+qint64 estimateSize(const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::QString:
+        return 2 * value.toString().size();
+    case QMetaType::QByteArray:
+        return value.toByteArray().size();
+    case QMetaType::QStringList: {
+        qint64 size = 0;
+        for (const QString &string : value.toStringList()) {
+            size += 2 * string.size() + 16;
+        }
+        return size;
+    }
+    case QMetaType::QVariantList: {
+        qint64 size = 0;
+        for (const QVariant &item : value.toList()) {
+            size += estimateSize(item) + 16;
+        }
+        return size;
+    }
+    default:
+        return 16;
+    }
+}
+
+qint64 estimateSize(const NotificationInfo &info)
+{
+    qint64 size = sizeof(NotificationInfo);
+    for (const QString *string : { &info.id, &info.appName, &info.appIcon, &info.summary, &info.body, &info.category }) {
+        size += 2 * string->size();
+    }
+    size += estimateSize(QVariant(info.actions)) + estimateSize(QVariant(info.actionLabels));
+    for (auto it = info.hints.constBegin(); it != info.hints.constEnd(); ++it) {
+        size += 2 * it.key().size() + estimateSize(it.value()) + 32;
+    }
+    return size;
+}
+} // namespace
+
 NotificationManager::NotificationManager(QObject *parent)
     : QObject(parent)
     , m_nextId(1)
+    , m_expiry(ExpiryResolution)
+    , m_expiryTimer(new QTimer(this))
+    , m_expiryWakeup(-1)
+    , m_burst(DefaultBurst)
+    , m_refillRate(DefaultRefillRate)
+    , m_flushTimer(new QTimer(this))
+    , m_historyBytes(0)
+    , m_historyMaxEntries(DefaultHistoryEntries)
+    , m_historyMaxBytes(DefaultHistoryBytes)
 {
+    m_clock.start();
+    
+    m_expiryTimer->setSingleShot(true);
+    connect(m_expiryTimer, &QTimer::timeout, this, &NotificationManager::processExpiry);
+    
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FrameInterval);
+    connect(m_flushTimer, &QTimer::timeout, this, &NotificationManager::flushUpdates);
+    
     qDebug() << "NotificationManager created";
 }
 
@@ -30,10 +108,24 @@ uint NotificationManager::createNotification(const QString &appName, uint replac
                                            int timeout)
 {
     uint id;
+    bool created = true;
+    int mergedCount = 0;
+    const int urgency = hints.value("urgency", 1).toInt();
     
     // Check if this is replacing an existing notification
     if (replacesId > 0 && m_notifications.contains(replacesId)) {
         id = replacesId;
+        created = false;
+    } else if (urgency < 2 && !takeToken(appName, m_clock.elapsed())) {
+        // Over the rate limit: fold into the application's latest notification
+        const uint latestId = m_buckets.value(appName).latestId;
+        if (m_notifications.contains(latestId)) {
+            id = latestId;
+            created = false;
+            mergedCount = m_notifications[id].hints.value(MergedCountHint, 0).toInt() + 1;
+        } else {
+            id = generateId();
+        }
     } else {
         id = generateId();
     }
@@ -60,23 +152,26 @@ uint NotificationManager::createNotification(const QString &appName, uint replac
     
     // Parse hints
     info.resident = hints.value("resident", false).toBool();
-    info.urgency = hints.value("urgency", 1).toInt();
+    info.urgency = urgency;
     info.category = hints.value("category", "").toString();
     
+    if (mergedCount > 0) {
+        info.hints.insert(MergedCountHint, mergedCount);
+    }
+    
     // Add to map
     m_notifications[id] = info;
+    if (urgency < 2 && (created || mergedCount > 0)) {
+        m_buckets[appName].latestId = id;
+    }
     
-    // Emit signal
-    emit notificationCreated(info);
+    // Deliver on the next frame
+    markDirty(id, created);
     
     qDebug() << "Created notification:" << id << summary;
     
-    // Set up expiry timer if timeout is not 0
-    if (timeout > 0) {
-        QTimer::singleShot(timeout, this, [this, id]() {
-            checkExpiry(id);
-        });
-    }
+    // Set up expiry if timeout is not 0; a replacement restarts it
+    scheduleExpiry(id, timeout);
     
     return id;
 }
@@ -89,10 +184,21 @@ bool NotificationManager::closeNotification(uint id, uint reason)
     }
     
     // Remove from map
-    m_notifications.remove(id);
+    addToHistory(m_notifications.take(id));
+    m_expiry.cancel(id);
+    
+    // Created within this frame: the UI never saw it, so drop the creation instead of closing
+    bool shown = true;
+    auto dirty = m_dirty.find(id);
+    if (dirty != m_dirty.end()) {
+        shown = !*dirty;
+        m_dirty.erase(dirty);
+    }
     
     // Emit signal
-    emit notificationClosed(id, reason);
+    if (shown) {
+        emit notificationClosed(id, reason);
+    }
     
     qDebug() << "Closed notification:" << id << "with reason:" << reason;
     
@@ -122,6 +228,36 @@ QStringList NotificationManager::getCapabilities() const
         << "sound";
 }
 
+QList<NotificationInfo> NotificationManager::getHistory() const
+{
+    return m_history;
+}
+
+void NotificationManager::clearHistory()
+{
+    m_history.clear();
+    m_historySizes.clear();
+    m_historyBytes = 0;
+}
+
+qint64 NotificationManager::getHistorySize() const
+{
+    return m_historyBytes;
+}
+
+void NotificationManager::setHistoryLimits(int maxEntries, qint64 maxBytes)
+{
+    m_historyMaxEntries = qMax(0, maxEntries);
+    m_historyMaxBytes = qMax<qint64>(0, maxBytes);
+    trimHistory();
+}
+
+void NotificationManager::setRateLimit(int burst, double perSecond)
+{
+    m_burst = qMax(1, burst);
+    m_refillRate = qMax(0.0, perSecond);
+}
+
 bool NotificationManager::invokeAction(uint id, const QString &actionId)
 {
     if (!m_notifications.contains(id)) {
@@ -150,15 +286,153 @@ bool NotificationManager::invokeAction(uint id, const QString &actionId)
     return true;
 }
 
+void NotificationManager::processExpiry()
+{
+    m_expiryWakeup = -1;
+    
+    for (uint id : m_expiry.advance(m_clock.elapsed())) {
+        closeNotification(id, 1); // Expired
+    }
+    
+    armExpiryTimer();
+}
+
+void NotificationManager::flushUpdates()
+{
+    // Entries stay pending until emitted, so a handler closing a later one drops it
+    // like any close within the frame; notifications a handler creates wait for the next
+    const QList<uint> order = m_dirtyOrder;
+    m_dirtyOrder.clear();
+    
+    for (uint id : order) {
+        // Closed within the frame
+        auto dirty = m_dirty.find(id);
+        if (dirty == m_dirty.end()) {
+            continue;
+        }
+        const bool created = *dirty;
+        m_dirty.erase(dirty);
+        
+        auto it = m_notifications.constFind(id);
+        if (it == m_notifications.constEnd()) {
+            continue;
+        }
+    
+        if (created) {
+            emit notificationCreated(*it);
+        } else {
+            emit notificationUpdated(*it);
+        }
+    }
+}
+
 uint NotificationManager::generateId()
 {
+    // Zero means "new notification" on the bus, so skip it on wrap-around
+    if (m_nextId == 0) {
+        m_nextId = 1;
+    }
     return m_nextId++;
 }
 
-void NotificationManager::checkExpiry(uint id)
+bool NotificationManager::takeToken(const QString &appName, qint64 now)
 {
-    if (m_notifications.contains(id)) {
-        closeNotification(id, 1); // Expired
+    auto it = m_buckets.find(appName);
+    if (it == m_buckets.end()) {
+        pruneBuckets(now);
+        it = m_buckets.insert(appName, RateBucket { double(m_burst), now, 0 });
+    }
+    
+    it->tokens = qMin<double>(m_burst, it->tokens + (now - it->updated) * m_refillRate / 1000.0);
+    it->updated = now;
+    
+    if (it->tokens < 1.0) {
+        return false;
+    }
+    it->tokens -= 1.0;
+    return true;
+}
+
+void NotificationManager::pruneBuckets(qint64 now)
+{
+    // A bucket that refilled completely is no different from a new one
+    for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+        if (it->tokens + (now - it->updated) * m_refillRate / 1000.0 >= m_burst) {
+            it = m_buckets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void NotificationManager::scheduleExpiry(uint id, int timeout)
+{
+    if (timeout > 0) {
+        m_expiry.schedule(id, m_clock.elapsed() + timeout);
+    } else {
+        m_expiry.cancel(id);
+    }
+    armExpiryTimer();
+}
+
+void NotificationManager::armExpiryTimer()
+{
+    const qint64 wakeup = m_expiry.nextWakeup();
+    if (wakeup < 0) {
+        m_expiryTimer->stop();
+        m_expiryWakeup = -1;
+        return;
+    }
+    
+    // Keep the running timer unless the wheel needs an earlier wakeup
+    if (m_expiryTimer->isActive() && m_expiryWakeup <= wakeup) {
+        return;
+    }
+    
+    m_expiryWakeup = wakeup;
+    m_expiryTimer->start(int(qMax<qint64>(0, wakeup - m_clock.elapsed())));
+}
+
+void NotificationManager::markDirty(uint id, bool created)
+{
+    auto it = m_dirty.find(id);
+    if (it == m_dirty.end()) {
+        m_dirty.insert(id, created);
+        m_dirtyOrder.append(id);
+    } else {
+        // Still new to the UI if it was created within this frame
+        *it = *it || created;
+    }
+    
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void NotificationManager::addToHistory(NotificationInfo info)
+{
+    if (m_historyMaxEntries == 0) {
+        return;
+    }
+    
+    for (const char *hint : ImageDataHints) {
+        info.hints.remove(hint);
+    }
+    
+    const qint64 size = estimateSize(info);
+    m_history.append(std::move(info));
+    m_historySizes.append(size);
+    m_historyBytes += size;
+    
+    trimHistory();
+}
+
+void NotificationManager::trimHistory()
+{
+    while (!m_history.isEmpty()
+           && (m_history.size() > m_historyMaxEntries || m_historyBytes > m_historyMaxBytes)) {
+        m_history.removeFirst();
+        m_historyBytes -= m_historySizes.takeFirst();
     }
 }
 
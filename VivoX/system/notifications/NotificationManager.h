@@ -4,7 +4,14 @@
 #include <QString>
 #include <QVariantMap>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QIcon>
+#include <QList>
+
+#include "TimingWheel.h"
+
+class QTimer;
 
 namespace VivoX::System {
 
@@ -33,6 +40,15 @@ public:
  * 
  * It implements the Freedesktop.org Notifications specification and provides
  * an interface for applications to send notifications and for the UI to display them.
+ *
+ * All expiry deadlines share one timer through a timing wheel. Each
+ * application has a token bucket for new notifications; once it is empty,
+ * further notifications are merged into the application's latest one, which
+ * counts them in the "x-vivox-merged-count" hint. Critical notifications are
+ * never rate limited. Creations and replacements are delivered to the UI at
+ * most once per frame, so a burst of updates to one notification costs a
+ * single repaint. Closed notifications are kept in a history bounded both in
+ * entries and in approximate memory.
  */
 class NotificationManager : public QObject {
     Q_OBJECT
@@ -91,6 +107,40 @@ public:
      */
     QStringList getCapabilities() const;
 
+    /**
+     * @brief Get the closed notifications, oldest first
+     *
+     * Image data hints are not kept in the history.
+     *
+     * @return List of notification info objects
+     */
+    QList<NotificationInfo> getHistory() const;
+
+    /**
+     * @brief Clear the notification history
+     */
+    void clearHistory();
+
+    /**
+     * @brief Get the approximate memory used by the history
+     * @return Size in bytes
+     */
+    qint64 getHistorySize() const;
+
+    /**
+     * @brief Set the bounds of the history
+     * @param maxEntries Maximum number of entries
+     * @param maxBytes Maximum approximate memory in bytes
+     */
+    void setHistoryLimits(int maxEntries, qint64 maxBytes);
+
+    /**
+     * @brief Set the per-application rate limit for new notifications
+     * @param burst Number of notifications an application can send at once
+     * @param perSecond Sustained number of notifications per second
+     */
+    void setRateLimit(int burst, double perSecond);
+
 signals:
     /**
      * @brief Signal emitted when a new notification is created
@@ -98,8 +148,17 @@ signals:
      */
     void notificationCreated(const NotificationInfo &info);
 
+    /**
+     * @brief Signal emitted when a notification has been replaced or merged into
+     * @param info The updated notification info
+     */
+    void notificationUpdated(const NotificationInfo &info);
+
     /**
      * @brief Signal emitted when a notification is closed
+     *
+     * Not emitted for notifications closed before notificationCreated was;
+     * the UI never learns of those.
      * @param id The notification ID
      * @param reason The reason for closing (1=expired, 2=dismissed, 3=closed by app)
      */
@@ -121,7 +180,17 @@ public slots:
      */
     bool invokeAction(uint id, const QString &actionId);
 
+private slots:
+    void processExpiry();
+    void flushUpdates();
+
 private:
+    struct RateBucket {
+        double tokens;
+        qint64 updated;
+        uint latestId;       // Most recent notification, which absorbs rate-limited ones
+    };
+
     // Map of notification ID to notification info
     QHash<uint, NotificationInfo> m_notifications;
     
@@ -131,8 +200,42 @@ private:
     // Generate a unique notification ID
     uint generateId();
     
-    // Check if a notification has expired
-    void checkExpiry(uint id);
+    // Take a token from the application's bucket
+    bool takeToken(const QString &appName, qint64 now);
+
+    // Drop the buckets of applications that have been quiet long enough
+    void pruneBuckets(qint64 now);
+
+    // Schedule or cancel the expiry of a notification
+    void scheduleExpiry(uint id, int timeout);
+    void armExpiryTimer();
+
+    // Queue a notification for delivery to the UI on the next frame
+    void markDirty(uint id, bool created);
+
+    void addToHistory(NotificationInfo info);
+    void trimHistory();
+
+    QElapsedTimer m_clock;
+    TimingWheel m_expiry;
+    QTimer *m_expiryTimer;
+    qint64 m_expiryWakeup;
+
+    QHash<QString, RateBucket> m_buckets;
+    int m_burst;
+    double m_refillRate;
+
+    // Notifications waiting for the next frame, and whether they are new to the UI;
+    // the order keeps closed ones until the flush, which skips them
+    QList<uint> m_dirtyOrder;
+    QHash<uint, bool> m_dirty;
+    QTimer *m_flushTimer;
+
+    QList<NotificationInfo> m_history;
+    QList<qint64> m_historySizes;
+    qint64 m_historyBytes;
+    int m_historyMaxEntries;
+    qint64 m_historyMaxBytes;
 };
 
 } // namespace VivoX::System
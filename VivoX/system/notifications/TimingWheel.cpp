@@ -0,0 +1,189 @@
+#include "TimingWheel.h"
+
+#include <algorithm>
+
+namespace VivoX::System {
+
+namespace {
+const int SlotBits = 6;
+const int SlotCount = 1 << SlotBits;
+const qint64 SlotMask = SlotCount - 1;
+const int LevelCount = 4;
+
+// Ticks covered by the wheel; later deadlines wait in the top level
+const qint64 WheelRange = qint64(1) << (SlotBits * LevelCount);
+
+// Longer jumps (e.g. after suspend) rebuild the wheel instead of stepping through it
+const qint64 MaxSteps = qint64(SlotCount) * SlotCount;
+
+qint64 levelRange(int level)
+{
+    return qint64(1) << (SlotBits * (level + 1));
+}
+} // namespace
+
+TimingWheel::TimingWheel(qint64 resolution, qint64 now)
+    : m_resolution(qMax<qint64>(1, resolution))
+    , m_tick(now / m_resolution)
+    , m_levels(LevelCount, QVector<QSet<quint32>>(SlotCount))
+{
+}
+
+void TimingWheel::schedule(quint32 id, qint64 deadline)
+{
+    cancel(id);
+
+    // Round up so the entry never expires before its deadline
+    Entry entry { deadline, (deadline + m_resolution - 1) / m_resolution, 0, 0 };
+    if (entry.tick <= m_tick) {
+        entry.tick = m_tick + 1;
+    }
+
+    place(id, entry);
+    m_entries.insert(id, entry);
+}
+
+void TimingWheel::cancel(quint32 id)
+{
+    auto it = m_entries.find(id);
+    if (it != m_entries.end()) {
+        m_levels[it->level][it->slot].remove(id);
+        m_entries.erase(it);
+    }
+}
+
+bool TimingWheel::contains(quint32 id) const
+{
+    return m_entries.contains(id);
+}
+
+int TimingWheel::size() const
+{
+    return m_entries.size();
+}
+
+QList<quint32> TimingWheel::advance(qint64 now)
+{
+    QList<quint32> expired;
+
+    const qint64 target = now / m_resolution;
+    if (target <= m_tick) {
+        return expired;
+    }
+    if (m_entries.isEmpty()) {
+        m_tick = target;
+        return expired;
+    }
+
+    if (target - m_tick > MaxSteps) {
+        rebuild(target, expired);
+    } else {
+        while (m_tick < target) {
+            ++m_tick;
+
+            // Move entries down from each level whose lower levels wrapped
+            for (int level = 1; level < LevelCount && (m_tick & (levelRange(level - 1) - 1)) == 0; ++level) {
+                cascade(level);
+            }
+
+            QSet<quint32> due;
+            due.swap(m_levels[0][m_tick & SlotMask]);
+            for (quint32 id : due) {
+                expired.append(id);
+            }
+
+            // Nothing left but what just expired: skip the empty ticks
+            if (expired.size() == m_entries.size()) {
+                m_tick = target;
+            }
+        }
+    }
+
+    std::sort(expired.begin(), expired.end(), [this](quint32 a, quint32 b) {
+        const qint64 deadlineA = m_entries.value(a).deadline;
+        const qint64 deadlineB = m_entries.value(b).deadline;
+        return deadlineA != deadlineB ? deadlineA < deadlineB : a < b;
+    });
+    for (quint32 id : expired) {
+        m_entries.remove(id);
+    }
+
+    return expired;
+}
+
+qint64 TimingWheel::nextWakeup() const
+{
+    if (m_entries.isEmpty()) {
+        return -1;
+    }
+
+    bool upperEmpty = true;
+    for (int level = 1; level < LevelCount && upperEmpty; ++level) {
+        for (const QSet<quint32> &slot : m_levels[level]) {
+            if (!slot.isEmpty()) {
+                upperEmpty = false;
+                break;
+            }
+        }
+    }
+
+    // The next cascade may bring entries due right then
+    const qint64 boundary = ((m_tick >> SlotBits) + 1) << SlotBits;
+    for (qint64 tick = m_tick + 1; tick <= m_tick + SlotCount; ++tick) {
+        if (!upperEmpty && tick >= boundary) {
+            return boundary * m_resolution;
+        }
+        if (!m_levels[0][tick & SlotMask].isEmpty()) {
+            return tick * m_resolution;
+        }
+    }
+
+    return boundary * m_resolution;
+}
+
+void TimingWheel::place(quint32 id, Entry &entry)
+{
+    // Entries beyond the wheel's range park in the top level and are
+    // placed again when they cascade
+    const qint64 tick = qMin(entry.tick, m_tick + WheelRange - 1);
+    const qint64 delta = tick - m_tick;
+
+    int level = 0;
+    while (level < LevelCount - 1 && delta >= levelRange(level)) {
+        ++level;
+    }
+
+    entry.level = level;
+    entry.slot = int((tick >> (SlotBits * level)) & SlotMask);
+    m_levels[level][entry.slot].insert(id);
+}
+
+void TimingWheel::cascade(int level)
+{
+    QSet<quint32> slot;
+    slot.swap(m_levels[level][(m_tick >> (SlotBits * level)) & SlotMask]);
+
+    for (quint32 id : slot) {
+        place(id, m_entries[id]);
+    }
+}
+
+void TimingWheel::rebuild(qint64 tick, QList<quint32> &expired)
+{
+    m_tick = tick;
+    for (QVector<QSet<quint32>> &level : m_levels) {
+        for (QSet<quint32> &slot : level) {
+            slot.clear();
+        }
+    }
+
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->tick <= m_tick) {
+            expired.append(it.key());
+        } else {
+            place(it.key(), it.value());
+        }
+    }
+}
+
+} // namespace VivoX::System
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QVector>
+
+namespace VivoX::System {
+
+/**
+ * @brief Hierarchical timing wheel for expiry deadlines.
+ *
+ * Deadlines are kept in four levels of 64 slots. Level 0 holds deadlines
+ * within 64 ticks of the current tick, and each level above covers 64
+ * times the range of the one below. Entries move down a level when the
+ * level below wraps around. Scheduling and cancelling are O(1), and
+ * advancing touches only the slots that come due. One timer set to
+ * nextWakeup() can drive any number of deadlines.
+ *
+ * Deadlines are rounded up to whole ticks, so nothing expires early.
+ */
+class TimingWheel {
+public:
+    /**
+     * @brief Create a wheel
+     * @param resolution Milliseconds per tick
+     * @param now The current time in milliseconds
+     */
+    explicit TimingWheel(qint64 resolution = 50, qint64 now = 0);
+
+    /**
+     * @brief Schedule or reschedule an entry
+     * @param id The entry
+     * @param deadline Expiry time in milliseconds
+     */
+    void schedule(quint32 id, qint64 deadline);
+
+    /**
+     * @brief Cancel an entry
+     * @param id The entry
+     */
+    void cancel(quint32 id);
+
+    /**
+     * @brief Check if an entry is scheduled
+     * @param id The entry
+     * @return True if the entry is scheduled
+     */
+    bool contains(quint32 id) const;
+
+    /**
+     * @brief Get the number of scheduled entries
+     * @return The number of entries
+     */
+    int size() const;
+
+    /**
+     * @brief Advance the wheel and take the expired entries
+     * @param now The current time in milliseconds
+     * @return The expired entries, earliest deadline first
+     */
+    QList<quint32> advance(qint64 now);
+
+    /**
+     * @brief Get when advance() next has work to do
+     *
+     * This is the tick of the earliest entry in level 0, or else the next
+     * time a higher level cascades.
+     *
+     * @return Time in milliseconds, or -1 if the wheel is empty
+     */
+    qint64 nextWakeup() const;
+
+private:
+    struct Entry {
+        qint64 deadline;
+        qint64 tick;
+        int level;
+        int slot;
+    };
+
+    void place(quint32 id, Entry &entry);
+    void cascade(int level);
+    void rebuild(qint64 tick, QList<quint32> &expired);
+
+    qint64 m_resolution;
+    qint64 m_tick;
+    QVector<QVector<QSet<quint32>>> m_levels;
+    QHash<quint32, Entry> m_entries;
+};
+
+} // namespace VivoX::System
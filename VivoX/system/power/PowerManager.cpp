@@ -1,21 +1,44 @@
 #include "PowerManager.h"
+#include "PowerProfileWriter.h"
 
 #include <QDebug>
 #include <QProcess>
-#include <QTimer>
-#include <QDBusConnection>
-#include <QDBusInterface>
-#include <QDBusReply>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
 #include <QFile>
 #include <QSettings>
 
 namespace VivoX::System {
 
+namespace {
+    const QString upowerService = QStringLiteral("org.freedesktop.UPower");
+    const QString upowerPath = QStringLiteral("/org/freedesktop/UPower");
+    const QString deviceInterface = QStringLiteral("org.freedesktop.UPower.Device");
+    const QString propertiesInterface = QStringLiteral("org.freedesktop.DBus.Properties");
+
+    // Window in which device property changes are merged into one update
+    const int coalesceInterval = 100;
+
+    // Poll interval of the sysfs fallback
+    const int sysfsInterval = 30000;
+}
+
 PowerManager::PowerManager(QObject *parent)
+    : PowerManager(QDBusConnection::systemBus(), parent)
+{
+}
+
+PowerManager::PowerManager(const QDBusConnection &connection, QObject *parent)
     : QObject(parent)
+    , m_connection(connection)
+    , m_upowerWatcher(nullptr)
     , m_powerState(OnAC)
     , m_batteryLevel(100)
     , m_batteryTimeRemaining(-1)
+    , m_profileWriter(new PowerProfileWriter(QStringLiteral("/sys"), this))
 {
     // Initialize default power settings
     m_powerSettings["display_timeout_ac"] = 15 * 60;     // 15 minutes on AC
@@ -32,6 +55,13 @@ PowerManager::PowerManager(QObject *parent)
     m_powerSettings["dim_display_on_battery"] = true;
     m_powerSettings["reduce_performance_on_battery"] = true;
     
+    m_coalesceTimer.setSingleShot(true);
+    m_coalesceTimer.setInterval(coalesceInterval);
+    connect(&m_coalesceTimer, &QTimer::timeout, this, &PowerManager::flushDeviceProperties);
+    
+    m_sysfsTimer.setInterval(sysfsInterval);
+    connect(&m_sysfsTimer, &QTimer::timeout, this, &PowerManager::updateFromSysfs);
+    
     qDebug() << "PowerManager created";
 }
 
@@ -42,24 +72,6 @@ PowerManager::~PowerManager()
 
 bool PowerManager::initialize()
 {
-    // Connect to UPower via DBus if available
-    QDBusConnection systemBus = QDBusConnection::systemBus();
-    
-    if (systemBus.isConnected()) {
-        // Connect to UPower signals
-        systemBus.connect("org.freedesktop.UPower", 
-                         "/org/freedesktop/UPower",
-                         "org.freedesktop.UPower",
-                         "DeviceChanged",
-                         this, SLOT(updatePowerInfo()));
-        
-        systemBus.connect("org.freedesktop.UPower", 
-                         "/org/freedesktop/UPower",
-                         "org.freedesktop.UPower",
-                         "Changed",
-                         this, SLOT(updatePowerInfo()));
-    }
-    
     // Load power settings from configuration
     QSettings settings("VivoX", "PowerManager");
     
@@ -69,13 +81,18 @@ bool PowerManager::initialize()
         }
     }
     
-    // Start a timer to periodically update power information
-    QTimer *timer = new QTimer(this);
-    connect(timer, &QTimer::timeout, this, &PowerManager::updatePowerInfo);
-    timer->start(30000); // Update every 30 seconds
-    
-    // Initial update
-    updatePowerInfo();
+    if (m_connection.isConnected()) {
+        // Follow UPower restarts, then read the display device without blocking
+        m_upowerWatcher = new QDBusServiceWatcher(upowerService, m_connection,
+                                                  QDBusServiceWatcher::WatchForOwnerChange, this);
+        connect(m_upowerWatcher, &QDBusServiceWatcher::serviceOwnerChanged,
+                this, &PowerManager::handleUPowerOwnerChanged);
+        
+        connectDisplayDevice();
+    } else {
+        m_sysfsTimer.start();
+        updateFromSysfs();
+    }
     
     qDebug() << "PowerManager initialized";
     return true;
@@ -298,106 +315,205 @@ bool PowerManager::setPowerSetting(const QString &key, const QVariant &value)
     return true;
 }
 
-void PowerManager::updatePowerInfo()
+void PowerManager::handleUPowerOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner)
 {
-    // Try to get power information from UPower via DBus
-    QDBusConnection systemBus = QDBusConnection::systemBus();
-    
-    if (systemBus.isConnected()) {
-        QDBusInterface upower("org.freedesktop.UPower", 
-                             "/org/freedesktop/UPower",
-                             "org.freedesktop.UPower",
-                             systemBus);
-        
-        if (upower.isValid()) {
-            // Get the primary battery device
-            QDBusReply<QDBusObjectPath> reply = upower.call("GetDisplayDevice");
-            
-            if (reply.isValid()) {
-                QDBusObjectPath path = reply.value();
-                
-                QDBusInterface device("org.freedesktop.UPower", 
-                                     path.path(),
-                                     "org.freedesktop.UPower.Device",
-                                     systemBus);
-                
-                if (device.isValid()) {
-                    // Get battery level
-                    QDBusReply<double> levelReply = device.call("GetPercentage");
-                    if (levelReply.isValid()) {
-                        int newLevel = qRound(levelReply.value());
-                        
-                        if (newLevel != m_batteryLevel) {
-                            m_batteryLevel = newLevel;
-                            emit batteryLevelChanged(m_batteryLevel);
-                        }
-                    }
-                    
-                    // Get battery time remaining
-                    QDBusReply<qlonglong> timeReply = device.call("GetTimeToEmpty");
-                    if (timeReply.isValid()) {
-                        int newTime = timeReply.value();
-                        
-                        if (newTime != m_batteryTimeRemaining) {
-                            m_batteryTimeRemaining = newTime;
-                        }
-                    }
-                    
-                    // Get power state
-                    QDBusReply<uint> stateReply = device.call("GetState");
-                    if (stateReply.isValid()) {
-                        uint state = stateReply.value();
-                        PowerState newState;
-                        
-                        // UPower states: 0=unknown, 1=charging, 2=discharging, 3=empty, 4=fully charged, 5=pending charge, 6=pending discharge
-                        if (state == 1 || state == 4 || state == 5) {
-                            newState = OnAC;
-                        } else if (state == 2 || state == 6) {
-                            if (m_batteryLevel <= m_powerSettings["critical_battery_level"].toInt()) {
-                                newState = CriticalBattery;
-                            } else if (m_batteryLevel <= m_powerSettings["low_battery_level"].toInt()) {
-                                newState = LowBattery;
-                            } else {
-                                newState = OnBattery;
-                            }
-                        } else {
-                            // Default to AC if unknown
-                            newState = OnAC;
-                        }
-                        
-                        if (newState != m_powerState) {
-                            m_powerState = newState;
-                            emit powerStateChanged(m_powerState);
-                            
-                            // Apply appropriate performance mode
-                            if (m_powerState == OnAC) {
-                                applyPerformanceMode(m_powerSettings["performance_mode_ac"].toString());
-                            } else {
-                                applyPerformanceMode(m_powerSettings["performance_mode_battery"].toString());
-                                
-                                // Check if we need to take action for critical battery
-                                if (m_powerState == CriticalBattery) {
-                                    QString action = m_powerSettings["critical_battery_action"].toString();
-                                    
-                                    if (action == "suspend") {
-                                        performAction(Suspend);
-                                    } else if (action == "hibernate") {
-                                        performAction(Hibernate);
-                                    } else if (action == "shutdown") {
-                                        performAction(Shutdown);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            
+    Q_UNUSED(service);
+
+    if (!oldOwner.isEmpty()) {
+        disconnectDisplayDevice();
+    }
+
+    if (!newOwner.isEmpty()) {
+        connectDisplayDevice();
+    } else {
+        // UPower went away; keep the state current from sysfs
+        m_sysfsTimer.start();
+        updateFromSysfs();
+    }
+}
+
+void PowerManager::connectDisplayDevice()
+{
+    QDBusMessage getDisplayDevice = QDBusMessage::createMethodCall(upowerService, upowerPath, upowerService, "GetDisplayDevice");
+
+    auto *watcher = new QDBusPendingCallWatcher(m_connection.asyncCall(getDisplayDevice), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call) {
+        QDBusPendingReply<QDBusObjectPath> reply = *call;
+        call->deleteLater();
+
+        if (reply.isError()) {
+            qWarning() << "UPower not available, falling back to sysfs:" << reply.error().message();
+            m_sysfsTimer.start();
+            updateFromSysfs();
             return;
         }
+
+        disconnectDisplayDevice();
+        m_sysfsTimer.stop();
+        m_displayDevice = reply.value().path();
+
+        // Subscribe before reading so no change can fall in between
+        m_connection.connect(upowerService, m_displayDevice, propertiesInterface, "PropertiesChanged",
+                             this, SLOT(handleDevicePropertiesChanged(QString,QVariantMap,QStringList)));
+
+        QDBusMessage getAll = QDBusMessage::createMethodCall(upowerService, m_displayDevice, propertiesInterface, "GetAll");
+        getAll << deviceInterface;
+
+        auto *propertiesWatcher = new QDBusPendingCallWatcher(m_connection.asyncCall(getAll), this);
+        connect(propertiesWatcher, &QDBusPendingCallWatcher::finished, this, [this](QDBusPendingCallWatcher *call) {
+            QDBusPendingReply<QVariantMap> reply = *call;
+            call->deleteLater();
+
+            if (reply.isError()) {
+                qWarning() << "Failed to read UPower display device:" << reply.error().message();
+                return;
+            }
+
+            // Values already queued by PropertiesChanged are newer than the snapshot
+            QVariantMap properties = reply.value();
+            for (auto it = m_pendingProperties.cbegin(); it != m_pendingProperties.cend(); ++it) {
+                properties.insert(it.key(), it.value());
+            }
+            m_pendingProperties.clear();
+            m_coalesceTimer.stop();
+
+            applyDeviceProperties(properties);
+        });
+    });
+}
+
+void PowerManager::disconnectDisplayDevice()
+{
+    if (m_displayDevice.isEmpty()) {
+        return;
     }
-    
-    // Fallback: Try to get power information from sysfs
+
+    m_connection.disconnect(upowerService, m_displayDevice, propertiesInterface, "PropertiesChanged",
+                            this, SLOT(handleDevicePropertiesChanged(QString,QVariantMap,QStringList)));
+    m_displayDevice.clear();
+    m_pendingProperties.clear();
+    m_coalesceTimer.stop();
+}
+
+void PowerManager::handleDevicePropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated)
+{
+    Q_UNUSED(invalidated);
+
+    if (interface != deviceInterface) {
+        return;
+    }
+
+    // UPower reports related properties in separate signals; apply them together
+    for (auto it = changed.cbegin(); it != changed.cend(); ++it) {
+        m_pendingProperties.insert(it.key(), it.value());
+    }
+
+    if (!m_coalesceTimer.isActive()) {
+        m_coalesceTimer.start();
+    }
+}
+
+void PowerManager::flushDeviceProperties()
+{
+    QVariantMap properties;
+    properties.swap(m_pendingProperties);
+
+    applyDeviceProperties(properties);
+}
+
+void PowerManager::applyDeviceProperties(const QVariantMap &properties)
+{
+    if (properties.isEmpty()) {
+        return;
+    }
+
+    // The display device of a machine without battery is not present
+    if (properties.contains("IsPresent") && !properties["IsPresent"].toBool()) {
+        m_batteryTimeRemaining = -1;
+
+        if (m_batteryLevel != -1) {
+            m_batteryLevel = -1;
+            emit batteryLevelChanged(m_batteryLevel);
+        }
+
+        setPowerState(OnAC);
+        return;
+    }
+
+    if (properties.contains("Percentage")) {
+        int newLevel = qRound(properties["Percentage"].toDouble());
+
+        if (newLevel != m_batteryLevel) {
+            m_batteryLevel = newLevel;
+            emit batteryLevelChanged(m_batteryLevel);
+        }
+    }
+
+    if (properties.contains("TimeToEmpty")) {
+        m_batteryTimeRemaining = properties["TimeToEmpty"].toLongLong();
+    }
+
+    bool onAC = m_powerState == OnAC;
+
+    if (properties.contains("State")) {
+        uint state = properties["State"].toUInt();
+
+        // UPower states: 0=unknown, 1=charging, 2=discharging, 3=empty, 4=fully charged, 5=pending charge, 6=pending discharge
+        // Default to AC if unknown
+        onAC = !(state == 2 || state == 6);
+    }
+
+    // A level change may cross the low or critical threshold as well
+    setPowerState(powerStateFor(onAC));
+}
+
+PowerManager::PowerState PowerManager::powerStateFor(bool onAC) const
+{
+    if (onAC) {
+        return OnAC;
+    }
+
+    if (m_batteryLevel <= m_powerSettings["critical_battery_level"].toInt()) {
+        return CriticalBattery;
+    } else if (m_batteryLevel <= m_powerSettings["low_battery_level"].toInt()) {
+        return LowBattery;
+    }
+
+    return OnBattery;
+}
+
+void PowerManager::setPowerState(PowerState state)
+{
+    if (state == m_powerState) {
+        return;
+    }
+
+    m_powerState = state;
+    emit powerStateChanged(m_powerState);
+
+    // Apply appropriate performance mode
+    if (m_powerState == OnAC) {
+        applyPerformanceMode(m_powerSettings["performance_mode_ac"].toString());
+    } else {
+        applyPerformanceMode(m_powerSettings["performance_mode_battery"].toString());
+
+        // Check if we need to take action for critical battery
+        if (m_powerState == CriticalBattery) {
+            QString action = m_powerSettings["critical_battery_action"].toString();
+
+            if (action == "suspend") {
+                performAction(Suspend);
+            } else if (action == "hibernate") {
+                performAction(Hibernate);
+            } else if (action == "shutdown") {
+                performAction(Shutdown);
+            }
+        }
+    }
+}
+
+void PowerManager::updateFromSysfs()
+{
     if (QFile::exists("/sys/class/power_supply/BAT0") || QFile::exists("/sys/class/power_supply/BAT1")) {
         // We have a battery
         bool onAC = false;
@@ -437,87 +553,27 @@ void PowerManager::updatePowerInfo()
             emit batteryLevelChanged(m_batteryLevel);
         }
         
-        // Determine power state
-        PowerState newState;
-        
-        if (onAC) {
-            newState = OnAC;
-        } else {
-            if (m_batteryLevel <= m_powerSettings["critical_battery_level"].toInt()) {
-                newState = CriticalBattery;
-            } else if (m_batteryLevel <= m_powerSettings["low_battery_level"].toInt()) {
-                newState = LowBattery;
-            } else {
-                newState = OnBattery;
-            }
-        }
-        
-        if (newState != m_powerState) {
-            m_powerState = newState;
-            emit powerStateChanged(m_powerState);
-            
-            // Apply appropriate performance mode
-            if (m_powerState == OnAC) {
-                applyPerformanceMode(m_powerSettings["performance_mode_ac"].toString());
-            } else {
-                applyPerformanceMode(m_powerSettings["performance_mode_battery"].toString());
-                
-                // Check if we need to take action for critical battery
-                if (m_powerState == CriticalBattery) {
-                    QString action = m_powerSettings["critical_battery_action"].toString();
-                    
-                    if (action == "suspend") {
-                        performAction(Suspend);
-                    } else if (action == "hibernate") {
-                        performAction(Hibernate);
-                    } else if (action == "shutdown") {
-                        performAction(Shutdown);
-                    }
-                }
-            }
-        }
+        setPowerState(powerStateFor(onAC));
     } else {
         // No battery, assume we're on AC
-        if (m_powerState != OnAC) {
-            m_powerState = OnAC;
+        m_batteryTimeRemaining = -1;
+        
+        if (m_batteryLevel != -1) {
             m_batteryLevel = -1;
-            m_batteryTimeRemaining = -1;
-            
-            emit powerStateChanged(m_powerState);
             emit batteryLevelChanged(m_batteryLevel);
-            
-            // Apply AC performance mode
-            applyPerformanceMode(m_powerSettings["performance_mode_ac"].toString());
         }
+        
+        setPowerState(OnAC);
     }
 }
 
 void PowerManager::applyPerformanceMode(const QString &mode)
 {
-    // Apply the specified performance mode
-    // This is system-dependent and might involve:
-    // - Setting CPU governor
-    // - Adjusting screen brightness
-    // - Configuring other power-saving features
+    // The CPU governor, energy/performance preference and boost are written
+    // off the main thread, and only where they differ
+    m_profileWriter->apply(PowerProfile::forMode(mode));
     
     if (mode == "performance") {
-        // Set CPU governor to performance if possible
-        if (QFile::exists("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor")) {
-            for (int i = 0; i < 16; i++) { // Try up to 16 CPUs
-                QString path = QString("/sys/devices/system/cpu/cpu%1/cpufreq/scaling_governor").arg(i);
-                
-                if (!QFile::exists(path)) {
-                    break;
-                }
-                
-                QFile file(path);
-                if (file.open(QIODevice::WriteOnly)) {
-                    file.write("performance");
-                    file.close();
-                }
-            }
-        }
-        
         // Set maximum brightness if on AC
         if (m_powerState == OnAC) {
             if (QFile::exists("/sys/class/backlight/acpi_video0/brightness")) {
@@ -535,23 +591,6 @@ void PowerManager::applyPerformanceMode(const QString &mode)
             }
         }
     } else if (mode == "powersave") {
-        // Set CPU governor to powersave if possible
-        if (QFile::exists("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor")) {
-            for (int i = 0; i < 16; i++) { // Try up to 16 CPUs
-                QString path = QString("/sys/devices/system/cpu/cpu%1/cpufreq/scaling_governor").arg(i);
-                
-                if (!QFile::exists(path)) {
-                    break;
-                }
-                
-                QFile file(path);
-                if (file.open(QIODevice::WriteOnly)) {
-                    file.write("powersave");
-                    file.close();
-                }
-            }
-        }
-        
         // Reduce brightness if on battery and dim_display_on_battery is enabled
         if (m_powerState != OnAC && m_powerSettings["dim_display_on_battery"].toBool()) {
             if (QFile::exists("/sys/class/backlight/acpi_video0/brightness")) {
@@ -577,23 +616,6 @@ void PowerManager::applyPerformanceMode(const QString &mode)
             }
         }
     } else if (mode == "balanced") {
-        // Set CPU governor to ondemand if possible
-        if (QFile::exists("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor")) {
-            for (int i = 0; i < 16; i++) { // Try up to 16 CPUs
-                QString path = QString("/sys/devices/system/cpu/cpu%1/cpufreq/scaling_governor").arg(i);
-                
-                if (!QFile::exists(path)) {
-                    break;
-                }
-                
-                QFile file(path);
-                if (file.open(QIODevice::WriteOnly)) {
-                    file.write("ondemand");
-                    file.close();
-                }
-            }
-        }
-        
         // Set appropriate brightness based on power state
         if (m_powerState == OnAC) {
             if (QFile::exists("/sys/class/backlight/acpi_video0/brightness")) {
@@ -1,16 +1,31 @@
 #pragma once
 
+#include <QDBusConnection>
 #include <QObject>
 #include <QString>
+#include <QTimer>
 #include <QVariantMap>
 
+class QDBusServiceWatcher;
+
 namespace VivoX::System {
 
+class PowerProfileWriter;
+
 /**
  * @brief The PowerManager class manages system power states and settings.
  * 
  * It provides an interface to control power-related functionality such as
  * suspend, hibernate, shutdown, and power settings.
+ *
+ * Battery state is event driven: the UPower display device is read once
+ * with an asynchronous GetAll and then followed through PropertiesChanged.
+ * Bursts of changes are coalesced into a single update, so an idle system
+ * causes no bus traffic and the caller never blocks on the system bus.
+ * Only without UPower does the manager fall back to polling sysfs.
+ *
+ * Performance modes reach the CPUs through a PowerProfileWriter, which
+ * writes the cpufreq settings of all online CPUs on a worker thread.
  */
 class PowerManager : public QObject {
     Q_OBJECT
@@ -38,6 +53,13 @@ public:
     };
 
     explicit PowerManager(QObject *parent = nullptr);
+
+    /**
+     * @brief Create a power manager talking to UPower on a specific bus
+     * @param connection The bus UPower lives on, normally the system bus
+     * @param parent The parent object
+     */
+    explicit PowerManager(const QDBusConnection &connection, QObject *parent = nullptr);
     ~PowerManager();
 
     /**
@@ -112,7 +134,31 @@ signals:
      */
     void powerSettingChanged(const QString &key, const QVariant &value);
 
+private slots:
+    void handleUPowerOwnerChanged(const QString &service, const QString &oldOwner, const QString &newOwner);
+    void handleDevicePropertiesChanged(const QString &interface, const QVariantMap &changed, const QStringList &invalidated);
+    void flushDeviceProperties();
+    void updateFromSysfs();
+
 private:
+    // Bus UPower lives on
+    QDBusConnection m_connection;
+    
+    // Watches UPower starting and stopping
+    QDBusServiceWatcher *m_upowerWatcher;
+    
+    // Object path of the UPower display device, empty if not resolved
+    QString m_displayDevice;
+    
+    // Device properties received but not yet applied
+    QVariantMap m_pendingProperties;
+    
+    // Coalesces bursts of property changes into one update
+    QTimer m_coalesceTimer;
+    
+    // Polls sysfs when UPower is not available
+    QTimer m_sysfsTimer;
+    
     // Current power state
     PowerState m_powerState;
     
@@ -125,8 +171,22 @@ private:
     // Power settings
     QVariantMap m_powerSettings;
     
-    // Update power information
-    void updatePowerInfo();
+    // Applies the CPU side of performance modes
+    PowerProfileWriter *m_profileWriter;
+    
+    // Resolve the display device and subscribe to its changes
+    void connectDisplayDevice();
+    void disconnectDisplayDevice();
+    
+    // Apply a set of UPower device properties
+    void applyDeviceProperties(const QVariantMap &properties);
+    
+    // Power state for the given AC status and the current battery level
+    PowerState powerStateFor(bool onAC) const;
+    void setPowerState(PowerState state);
+    
+    // Apply a performance mode
+    void applyPerformanceMode(const QString &mode);
 };
 
 } // namespace VivoX::System
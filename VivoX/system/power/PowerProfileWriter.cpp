@@ -0,0 +1,291 @@
+#include "PowerProfileWriter.h"
+
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSet>
+
+#include <algorithm>
+#include <utility>
+
+namespace VivoX::System {
+
+namespace {
+    // Read a sysfs attribute, null if it can't be read
+    QByteArray readValue(const QString &path)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return QByteArray();
+        }
+        return file.readAll().trimmed();
+    }
+
+    // Parse a CPU list such as "0-3,6,8-11"
+    QList<int> parseCpuList(const QByteArray &list)
+    {
+        QList<int> cpus;
+        for (const QByteArray &range : list.split(',')) {
+            const int dash = range.indexOf('-');
+            bool firstOk = false;
+            bool lastOk = false;
+            const int first = range.left(dash < 0 ? range.size() : dash).trimmed().toInt(&firstOk);
+            const int last = dash < 0 ? first : range.mid(dash + 1).trimmed().toInt(&lastOk);
+            if (!firstOk || (dash >= 0 && !lastOk)) {
+                continue;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.append(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    QStringList splitValues(const QByteArray &values)
+    {
+        return QString::fromLatin1(values).split(' ', Qt::SkipEmptyParts);
+    }
+
+    // First candidate the policy offers; the first candidate if it doesn't say
+    QString pick(const QStringList &candidates, const QStringList &available)
+    {
+        if (available.isEmpty()) {
+            return candidates.first();
+        }
+        for (const QString &candidate : candidates) {
+            if (available.contains(candidate)) {
+                return candidate;
+            }
+        }
+        return QString();
+    }
+}
+
+PowerProfile PowerProfile::forMode(const QString &mode)
+{
+    PowerProfile profile;
+    if (mode == "performance") {
+        profile.governors = { "performance" };
+        profile.energyPreferences = { "performance" };
+        profile.boost = 1;
+    } else if (mode == "balanced") {
+        // intel_pstate and amd-pstate only offer performance and powersave,
+        // where powersave is the dynamic governor tuned by the preference
+        profile.governors = { "schedutil", "ondemand", "powersave" };
+        profile.energyPreferences = { "balance_performance", "default" };
+        profile.boost = 1;
+    } else if (mode == "powersave") {
+        profile.governors = { "powersave", "conservative" };
+        profile.energyPreferences = { "power", "balance_power" };
+        profile.boost = 0;
+    }
+    return profile;
+}
+
+PowerProfileWriter::PowerProfileWriter(const QString &sysfsRoot, QObject *parent)
+    : QObject(parent)
+    , m_root(sysfsRoot)
+    , m_hasQueued(false)
+    , m_running(false)
+    , m_enumerated(false)
+    , m_boostInverted(false)
+    , m_writeCount(0)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+PowerProfileWriter::~PowerProfileWriter()
+{
+    waitForIdle();
+    m_pool.waitForDone();
+}
+
+void PowerProfileWriter::apply(const PowerProfile &profile)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queued = profile;
+    m_hasQueued = true;
+
+    // A running pass picks the profile up when it's done
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_pool.start([this]() { run(); });
+}
+
+bool PowerProfileWriter::waitForIdle(int timeout)
+{
+    QDeadlineTimer deadline(timeout);
+    QMutexLocker locker(&m_mutex);
+    while (m_running) {
+        if (!m_idle.wait(&m_mutex, deadline)) {
+            return !m_running;
+        }
+    }
+    return true;
+}
+
+QList<int> PowerProfileWriter::cpus() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cpus;
+}
+
+int PowerProfileWriter::writeCount() const
+{
+    return m_writeCount.load();
+}
+
+void PowerProfileWriter::run()
+{
+    forever {
+        PowerProfile profile;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_hasQueued) {
+                m_running = false;
+                m_idle.wakeAll();
+                return;
+            }
+            profile = std::exchange(m_queued, PowerProfile());
+            m_hasQueued = false;
+        }
+
+        if (!m_enumerated) {
+            enumerate();
+        }
+
+        const bool success = write(profile);
+        QMetaObject::invokeMethod(this, [this, success]() {
+            emit profileApplied(success);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void PowerProfileWriter::enumerate()
+{
+    m_enumerated = true;
+    const QString cpuDir = m_root + "/devices/system/cpu";
+
+    QList<int> online = parseCpuList(readValue(cpuDir + "/online"));
+    if (online.isEmpty()) {
+        // Without hotplug support every present CPU is online
+        const QStringList entries = QDir(cpuDir).entryList({ "cpu[0-9]*" }, QDir::Dirs);
+        for (const QString &entry : entries) {
+            bool ok = false;
+            const int cpu = entry.mid(3).toInt(&ok);
+            if (ok) {
+                online.append(cpu);
+            }
+        }
+        std::sort(online.begin(), online.end());
+    }
+
+    // CPUs sharing a policy link to the same cpufreq directory
+    QList<int> cpus;
+    QSet<QString> seen;
+    for (int cpu : online) {
+        const QString policyPath = QFileInfo(QString("%1/cpu%2/cpufreq").arg(cpuDir).arg(cpu)).canonicalFilePath();
+        if (policyPath.isEmpty()) {
+            continue;
+        }
+        cpus.append(cpu);
+        if (seen.contains(policyPath)) {
+            continue;
+        }
+        seen.insert(policyPath);
+
+        Policy policy;
+        policy.path = policyPath;
+        policy.governors = splitValues(readValue(policyPath + "/scaling_available_governors"));
+        policy.energyPreferences = splitValues(readValue(policyPath + "/energy_performance_available_preferences"));
+        for (const char *name : { "/scaling_governor", "/energy_performance_preference" }) {
+            const QByteArray value = readValue(policyPath + name);
+            if (!value.isNull()) {
+                m_values.insert(policyPath + name, value);
+            }
+        }
+        m_policies.append(policy);
+    }
+
+    // acpi-cpufreq and amd-pstate expose boost, intel_pstate its inverse
+    const QString boostPath = cpuDir + "/cpufreq/boost";
+    const QString noTurboPath = cpuDir + "/intel_pstate/no_turbo";
+    for (const QString &path : { boostPath, noTurboPath }) {
+        const QByteArray value = readValue(path);
+        if (!value.isNull()) {
+            m_boostPath = path;
+            m_boostInverted = path == noTurboPath;
+            m_values.insert(path, value);
+            break;
+        }
+    }
+
+    qDebug() << "PowerProfileWriter found" << cpus.size() << "CPUs in" << m_policies.size() << "cpufreq policies";
+
+    QMutexLocker locker(&m_mutex);
+    m_cpus = cpus;
+}
+
+bool PowerProfileWriter::write(const PowerProfile &profile)
+{
+    bool success = true;
+
+    for (const Policy &policy : std::as_const(m_policies)) {
+        const QString governorPath = policy.path + "/scaling_governor";
+        const QString preferencePath = policy.path + "/energy_performance_preference";
+
+        if (!profile.governors.isEmpty() && m_values.contains(governorPath)) {
+            const QString governor = pick(profile.governors, policy.governors);
+            const QByteArray previous = m_values.value(governorPath);
+            if (governor.isEmpty()) {
+                qWarning() << "No governor of" << profile.governors << "available in" << policy.path;
+            } else if (!writeValue(governorPath, governor.toLatin1())) {
+                success = false;
+            } else if (previous != governor.toLatin1() && m_values.contains(preferencePath)) {
+                // The driver may reset the preference along with the governor
+                m_values.insert(preferencePath, readValue(preferencePath));
+            }
+        }
+
+        if (!profile.energyPreferences.isEmpty() && m_values.contains(preferencePath)) {
+            const QString preference = pick(profile.energyPreferences, policy.energyPreferences);
+            if (!preference.isEmpty() && !writeValue(preferencePath, preference.toLatin1())) {
+                success = false;
+            }
+        }
+    }
+
+    if (profile.boost >= 0 && !m_boostPath.isEmpty()) {
+        const bool enabled = profile.boost > 0;
+        if (!writeValue(m_boostPath, enabled != m_boostInverted ? "1" : "0")) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+bool PowerProfileWriter::writeValue(const QString &path, const QByteArray &value)
+{
+    if (m_values.value(path) == value) {
+        return true;
+    }
+
+    // Unbuffered, so the kernel's answer to the write is the result
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered) || file.write(value) != value.size()) {
+        qWarning() << "Failed to write" << value << "to" << path << ":" << file.errorString();
+        return false;
+    }
+
+    m_values.insert(path, value);
+    ++m_writeCount;
+    return true;
+}
+
+} // namespace VivoX::System
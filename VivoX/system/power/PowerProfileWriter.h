@@ -0,0 +1,134 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <atomic>
+
+namespace VivoX::System {
+
+/**
+ * @brief CPU power settings to apply
+ *
+ * Governors and energy/performance preferences are listed in order of
+ * preference; the first one a CPU policy offers is used. Empty lists leave
+ * the setting unchanged.
+ */
+struct PowerProfile {
+    QStringList governors;           ///< Scaling governors in order of preference
+    QStringList energyPreferences;   ///< Energy/performance preferences in order of preference
+    int boost = -1;                  ///< 1 to allow turbo/boost, 0 to disable it, -1 to leave unchanged
+
+    /**
+     * @brief Get the profile of a performance mode
+     * @param mode "performance", "balanced" or "powersave"
+     * @return The profile, empty for unknown modes
+     */
+    static PowerProfile forMode(const QString &mode);
+};
+
+/**
+ * @brief Applies CPU power profiles through sysfs off the main thread.
+ *
+ * The online CPUs and their cpufreq policies are enumerated once, on the
+ * first use, and the current values of every setting are read along with
+ * them. Each policy is written once, however many CPUs share it, and a
+ * value that is already set is not written again.
+ *
+ * All sysfs access happens on a private worker thread. apply() only
+ * records the profile; while one is being written, newer profiles replace
+ * the queued one, so a burst of mode changes costs at most two passes.
+ */
+class PowerProfileWriter : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Create a writer
+     * @param sysfsRoot Root of the sysfs tree, e.g. a fake tree in tests
+     * @param parent The parent object
+     */
+    explicit PowerProfileWriter(const QString &sysfsRoot = QStringLiteral("/sys"), QObject *parent = nullptr);
+
+    /**
+     * @brief Destructor; waits for the profile being written
+     */
+    ~PowerProfileWriter() override;
+
+    /**
+     * @brief Apply a profile asynchronously
+     * @param profile The profile
+     */
+    void apply(const PowerProfile &profile);
+
+    /**
+     * @brief Wait until no profile is queued or being written
+     * @param timeout Timeout in milliseconds, -1 to wait forever
+     * @return True if the writer is idle
+     */
+    bool waitForIdle(int timeout = -1);
+
+    /**
+     * @brief Get the online CPUs with frequency scaling
+     * @return CPU numbers, empty until the first profile was applied
+     */
+    QList<int> cpus() const;
+
+    /**
+     * @brief Get the number of sysfs writes performed so far
+     * @return Number of writes
+     */
+    int writeCount() const;
+
+signals:
+    /**
+     * @brief Signal emitted when a profile has been written
+     * @param success True if every write succeeded
+     */
+    void profileApplied(bool success);
+
+private:
+    // A cpufreq policy, shared by one or more CPUs
+    struct Policy {
+        QString path;
+        QStringList governors;
+        QStringList energyPreferences;
+    };
+
+    void run();
+    void enumerate();
+    bool write(const PowerProfile &profile);
+    bool writeValue(const QString &path, const QByteArray &value);
+
+    QString m_root;
+
+    // Guards the queue and the idle state
+    mutable QMutex m_mutex;
+    QWaitCondition m_idle;
+    PowerProfile m_queued;
+    bool m_hasQueued;
+    bool m_running;
+
+    // Only touched on the worker thread, except cpus() after enumeration
+    bool m_enumerated;
+    QList<int> m_cpus;
+    QList<Policy> m_policies;
+    QString m_boostPath;
+    bool m_boostInverted;
+
+    // Last value read from or written to each file
+    QHash<QString, QByteArray> m_values;
+
+    std::atomic<int> m_writeCount;
+
+    // Runs the writes one at a time
+    QThreadPool m_pool;
+};
+
+} // namespace VivoX::System
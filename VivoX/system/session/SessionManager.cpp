@@ -8,9 +8,7 @@
 #include <QFileInfo>
 #include <QSettings>
 #include <QStandardPaths>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include <QTimer>
 #include <QDBusConnection>
 #include <QDBusInterface>
 #include <QDBusReply>
@@ -18,12 +16,28 @@
 #include <QUuid>
 #include <unistd.h>
 #include <pwd.h>
+#include <utility>
 
 namespace VivoX::System {
 
+namespace {
+// Changes are written this long after the first one, so bursts share one write
+const int FlushDelay = 500;
+
+// A restore gives up on windows that haven't mapped after this long
+const int RestoreTimeout = 30000;
+} // namespace
+
 SessionManager::SessionManager(QObject *parent)
     : QObject(parent)
     , m_sessionStartTime(QDateTime::currentSecsSinceEpoch())
+    , m_store(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/sessions")
+    , m_flushTimer(new QTimer(this))
+    , m_recording(false)
+    , m_ending(false)
+    , m_restoredWindows(0)
+    , m_restoreTimeout(new QTimer(this))
+    , m_lastRestoreTime(-1)
 {
     // Get current user name
     uid_t uid = getuid();
@@ -41,11 +55,30 @@ SessionManager::SessionManager(QObject *parent)
     QUuid sessionUuid = QUuid::createUuid();
     m_sessionId = sessionUuid.toString(QUuid::WithoutBraces);
     
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FlushDelay);
+    connect(m_flushTimer, &QTimer::timeout, this, [this]() {
+        m_store.flush();
+    });
+    
+    m_restoreTimeout->setSingleShot(true);
+    m_restoreTimeout->setInterval(RestoreTimeout);
+    connect(m_restoreTimeout, &QTimer::timeout, this, &SessionManager::finishRestore);
+    
+    // Applications exiting because the session ends must stay in the saved session
+    connect(this, &SessionManager::sessionEnding, this, [this]() {
+        m_ending = true;
+    });
+    
     qDebug() << "SessionManager created for user:" << m_userName << "with session ID:" << m_sessionId;
 }
 
 SessionManager::~SessionManager()
 {
+    if (m_store.hasPendingChanges()) {
+        m_store.flush();
+    }
+    
     qDebug() << "SessionManager destroyed";
 }
 
@@ -54,6 +87,10 @@ bool SessionManager::initialize()
     // Load startup applications
     loadStartupApplications();
     
+    // Keep the previous session around for restoreSession()
+    m_store.load();
+    m_savedState = m_store.state();
+    
     // Connect to session DBus signals if available
     QDBusConnection sessionBus = QDBusConnection::sessionBus();
     
@@ -164,161 +201,164 @@ bool SessionManager::removeStartupApplication(const QString &appId)
 
 bool SessionManager::saveSession()
 {
-    // Create session state
-    QVariantMap sessionState;
-    
-    // Add basic session info
-    sessionState["sessionId"] = m_sessionId;
-    sessionState["userName"] = m_userName;
-    sessionState["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-    
-    // Add running applications
-    // In a real implementation, we would query the window manager for this information
-    // For now, we'll just save a placeholder
-    QVariantList runningApps;
-    // TODO: Get actual running applications from window manager
-    sessionState["runningApplications"] = runningApps;
-    
-    // Add window positions and states
-    // In a real implementation, we would query the window manager for this information
-    // For now, we'll just save a placeholder
-    QVariantList windowStates;
-    // TODO: Get actual window states from window manager
-    sessionState["windowStates"] = windowStates;
-    
-    // Add workspace information
-    // In a real implementation, we would query the workspace manager for this information
-    // For now, we'll just save a placeholder
-    QVariantList workspaces;
-    // TODO: Get actual workspace information from workspace manager
-    sessionState["workspaces"] = workspaces;
-    
-    // Save session state to file
-    QString sessionDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/sessions";
-    QDir().mkpath(sessionDir);
-    
-    QString sessionFile = sessionDir + "/session-" + m_sessionId + ".json";
-    QFile file(sessionFile);
-    
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning() << "Failed to open session file for writing:" << sessionFile;
-        return false;
-    }
+    m_flushTimer->stop();
     
-    QJsonDocument doc = QJsonDocument::fromVariant(sessionState);
-    file.write(doc.toJson());
-    file.close();
-    
-    // Save as the latest session
-    QString latestSessionFile = sessionDir + "/latest-session.json";
-    QFile latestFile(latestSessionFile);
-    
-    if (latestFile.open(QIODevice::WriteOnly)) {
-        latestFile.write(doc.toJson());
-        latestFile.close();
+    if (!m_store.compact()) {
+        qWarning() << "Failed to save session";
+        return false;
     }
     
-    m_sessionState = sessionState;
-    
-    qDebug() << "Session saved to:" << sessionFile;
+    qDebug() << "Session saved";
     return true;
 }
 
 bool SessionManager::restoreSession()
 {
-    // Load the latest session
-    QString sessionDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/sessions";
-    QString latestSessionFile = sessionDir + "/latest-session.json";
-    
-    QFile file(latestSessionFile);
-    
-    if (!file.exists()) {
+    if (m_savedState.isEmpty()) {
         qWarning() << "No saved session found";
         return false;
     }
     
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "Failed to open session file for reading:" << latestSessionFile;
-        return false;
-    }
+    const SessionState state = std::exchange(m_savedState, SessionState());
     
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
+    m_restoreClock.start();
+    m_pendingWindows = state.windows;
+    m_restoredWindows = 0;
     
-    if (doc.isNull() || !doc.isObject()) {
-        qWarning() << "Invalid session file format:" << latestSessionFile;
-        return false;
+    emit sessionRestoreStarted(state);
+    
+    // Launch everything at once; each window is matched whenever it maps
+    QStringList applications = state.applications;
+    for (const SessionWindow &window : state.windows) {
+        if (!window.appId.isEmpty() && !applications.contains(window.appId)) {
+            applications.append(window.appId);
+        }
     }
     
-    QVariantMap sessionState = doc.object().toVariantMap();
+    qDebug() << "Restoring session:" << applications.size() << "applications," << state.windows.size() << "windows";
     
-    // Validate session state
-    if (!sessionState.contains("sessionId") || !sessionState.contains("userName")) {
-        qWarning() << "Invalid session state: missing required fields";
-        return false;
+    for (const QString &appId : applications) {
+        emit applicationRestoreRequested(appId);
     }
     
-    // Check if the session is for the current user
-    if (sessionState["userName"].toString() != m_userName) {
-        qWarning() << "Session is for a different user:" << sessionState["userName"].toString();
-        return false;
+    // Windows may all have matched while launching already
+    if (isRestoring()) {
+        if (m_pendingWindows.isEmpty()) {
+            finishRestore();
+        } else {
+            m_restoreTimeout->start();
+        }
     }
     
-    // Restore running applications
-    if (sessionState.contains("runningApplications")) {
-        QVariantList runningApps = sessionState["runningApplications"].toList();
-        
-        for (const QVariant &app : runningApps) {
-            QVariantMap appInfo = app.toMap();
-            
-            if (appInfo.contains("appId")) {
-                QString appId = appInfo["appId"].toString();
-                
-                // In a real implementation, we would launch the application
-                // For now, we'll just log it
-                qDebug() << "Would restore application:" << appId;
-                
-                // TODO: Launch application with appropriate parameters
-            }
-        }
+    return true;
+}
+
+SessionState SessionManager::getSavedSession() const
+{
+    return m_savedState;
+}
+
+bool SessionManager::isRestoring() const
+{
+    return m_restoreClock.isValid();
+}
+
+bool SessionManager::matchRestoredWindow(const QString &appId, const QString &title, SessionWindow &saved)
+{
+    if (!isRestoring()) {
+        return false;
     }
     
-    // Restore window positions and states
-    if (sessionState.contains("windowStates")) {
-        QVariantList windowStates = sessionState["windowStates"].toList();
-        
-        for (const QVariant &window : windowStates) {
-            QVariantMap windowInfo = window.toMap();
-            
-            // In a real implementation, we would restore the window state
-            // For now, we'll just log it
-            qDebug() << "Would restore window:" << windowInfo;
-            
-            // TODO: Restore window state
+    int match = -1;
+    for (int i = 0; i < m_pendingWindows.size(); ++i) {
+        if (m_pendingWindows[i].appId != appId) {
+            continue;
+        }
+        if (m_pendingWindows[i].title == title) {
+            match = i;
+            break;
+        }
+        if (match < 0) {
+            match = i;
         }
     }
     
-    // Restore workspace information
-    if (sessionState.contains("workspaces")) {
-        QVariantList workspaces = sessionState["workspaces"].toList();
-        
-        for (const QVariant &workspace : workspaces) {
-            QVariantMap workspaceInfo = workspace.toMap();
-            
-            // In a real implementation, we would restore the workspace
-            // For now, we'll just log it
-            qDebug() << "Would restore workspace:" << workspaceInfo;
-            
-            // TODO: Restore workspace
-        }
+    if (match < 0) {
+        return false;
     }
     
-    m_sessionState = sessionState;
+    saved = m_pendingWindows.takeAt(match);
+    ++m_restoredWindows;
+    
+    if (m_pendingWindows.isEmpty()) {
+        finishRestore();
+    }
     
-    qDebug() << "Session restored from:" << latestSessionFile;
     return true;
 }
 
+qint64 SessionManager::getLastRestoreTime() const
+{
+    return m_lastRestoreTime;
+}
+
+void SessionManager::updateWindow(const SessionWindow &window)
+{
+    if (record()) {
+        m_store.setWindow(window);
+    }
+}
+
+void SessionManager::removeWindow(const QString &key)
+{
+    if (record()) {
+        m_store.removeWindow(key);
+    }
+}
+
+void SessionManager::updateWorkspace(const SessionWorkspace &workspace)
+{
+    if (record()) {
+        m_store.setWorkspace(workspace);
+    }
+}
+
+void SessionManager::removeWorkspace(const QString &id)
+{
+    if (record()) {
+        m_store.removeWorkspace(id);
+    }
+}
+
+void SessionManager::setActiveWorkspace(const QString &id)
+{
+    if (record()) {
+        m_store.setActiveWorkspace(id);
+    }
+}
+
+void SessionManager::applicationStarted(const QString &appId)
+{
+    ++m_applicationInstances[appId];
+    
+    if (record()) {
+        m_store.addApplication(appId);
+    }
+}
+
+void SessionManager::applicationStopped(const QString &appId)
+{
+    auto it = m_applicationInstances.find(appId);
+    if (it == m_applicationInstances.end() || --*it > 0) {
+        return;
+    }
+    m_applicationInstances.erase(it);
+    
+    if (record()) {
+        m_store.removeApplication(appId);
+    }
+}
+
 bool SessionManager::logOut(bool saveSession)
 {
     // Save session if requested
@@ -615,6 +655,40 @@ void SessionManager::saveStartupApplications()
     }
 }
 
+bool SessionManager::record()
+{
+    if (m_ending) {
+        return false;
+    }
+    
+    if (!m_recording) {
+        m_recording = true;
+        m_store.clear();
+    }
+    
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+    
+    return true;
+}
+
+void SessionManager::finishRestore()
+{
+    m_restoreTimeout->stop();
+    
+    m_lastRestoreTime = m_restoreClock.elapsed();
+    m_restoreClock.invalidate();
+    
+    const int savedWindows = m_restoredWindows + m_pendingWindows.size();
+    m_pendingWindows.clear();
+    
+    qDebug() << "Session restored in" << m_lastRestoreTime << "ms:" << m_restoredWindows
+             << "of" << savedWindows << "windows";
+    
+    emit sessionRestored(m_lastRestoreTime, m_restoredWindows, savedWindows);
+}
+
 QString SessionManager::findDesktopFile(const QString &appId)
 {
     // Check if the appId is a path
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QVariantMap>
 
+#include "SessionStore.h"
+
+class QTimer;
+
 namespace VivoX::System {
 
 /**
@@ -11,6 +17,13 @@ namespace VivoX::System {
  * 
  * It provides an interface to control session-related functionality such as
  * startup applications, session saving/restoring, and session control.
+ *
+ * Window geometry, workspace membership and running applications are
+ * reported as they change and kept in a SessionStore, which appends them
+ * to a log shortly after each change. Restoring relaunches all saved
+ * applications at once and hands out the saved geometry as their windows
+ * map, so restore time is bounded by the slowest application rather than
+ * by the sum of them.
  */
 class SessionManager : public QObject {
     Q_OBJECT
@@ -65,16 +78,97 @@ public:
 
     /**
      * @brief Save the current session state
+     *
+     * Writes a complete snapshot. Changes are saved incrementally anyway,
+     * so this is only needed to make sure everything is on disk.
+     *
      * @return True if successful
      */
     bool saveSession();
 
     /**
      * @brief Restore the previous session state
-     * @return True if successful
+     *
+     * Requests all saved applications to be launched at once. Their windows
+     * get their saved state through matchRestoredWindow() as they map.
+     *
+     * @return True if there was a session to restore
      */
     bool restoreSession();
 
+    /**
+     * @brief Get the state saved by the previous session
+     * @return The saved state, empty once restored
+     */
+    SessionState getSavedSession() const;
+
+    /**
+     * @brief Check if a restore is waiting for windows
+     * @return True while restoring
+     */
+    bool isRestoring() const;
+
+    /**
+     * @brief Get the saved state for a window that has just mapped
+     *
+     * Prefers a saved window of the same application with the same title,
+     * then the application's earliest saved window.
+     *
+     * @param appId The application ID of the window
+     * @param title The title of the window
+     * @param saved Receives the saved window state
+     * @return True if a saved window matched
+     */
+    bool matchRestoredWindow(const QString &appId, const QString &title, SessionWindow &saved);
+
+    /**
+     * @brief Get how long the last restore took
+     * @return Milliseconds from restoreSession() to the last matched window, or -1
+     */
+    qint64 getLastRestoreTime() const;
+
+    /**
+     * @brief Record a window that was mapped or has changed
+     * @param window The window state
+     */
+    void updateWindow(const SessionWindow &window);
+
+    /**
+     * @brief Record a window that was closed
+     * @param key The window key
+     */
+    void removeWindow(const QString &key);
+
+    /**
+     * @brief Record a workspace that was added or has changed
+     * @param workspace The workspace state
+     */
+    void updateWorkspace(const SessionWorkspace &workspace);
+
+    /**
+     * @brief Record a workspace that was removed
+     * @param id The workspace ID
+     */
+    void removeWorkspace(const QString &id);
+
+    /**
+     * @brief Record the active workspace
+     * @param id The workspace ID
+     */
+    void setActiveWorkspace(const QString &id);
+
+    /**
+     * @brief Record an application instance that was started
+     * @param appId The application ID
+     */
+    void applicationStarted(const QString &appId);
+
+    /**
+     * @brief Record an application instance that has exited
+     * @param appId The application ID
+     */
+    void applicationStopped(const QString &appId);
+
     /**
      * @brief Log out the current user
      * @param saveSession Whether to save the session before logging out
@@ -118,6 +212,30 @@ signals:
      */
     void startupApplicationsChanged();
 
+    /**
+     * @brief Signal emitted when restoring a session starts
+     *
+     * Emitted before any application is launched, so workspaces can be
+     * recreated first.
+     *
+     * @param state The saved state
+     */
+    void sessionRestoreStarted(const SessionState &state);
+
+    /**
+     * @brief Signal emitted for each application to relaunch
+     * @param appId The application ID
+     */
+    void applicationRestoreRequested(const QString &appId);
+
+    /**
+     * @brief Signal emitted when all saved windows were matched or the restore timed out
+     * @param elapsed Milliseconds since the restore started
+     * @param restoredWindows Number of windows that got their saved state
+     * @param savedWindows Number of saved windows
+     */
+    void sessionRestored(qint64 elapsed, int restoredWindows, int savedWindows);
+
 private:
     // Current user name
     QString m_userName;
@@ -131,14 +249,38 @@ private:
     // List of startup applications
     QStringList m_startupApplications;
     
-    // Session state
-    QVariantMap m_sessionState;
+    // Live session state, and the state saved by the previous session
+    SessionStore m_store;
+    SessionState m_savedState;
+    QTimer *m_flushTimer;
+    
+    // The store still holds the previous session until the first change
+    bool m_recording;
+    
+    // Set once the session ends, so exiting applications stay saved
+    bool m_ending;
+    
+    // Running instances per application
+    QHash<QString, int> m_applicationInstances;
+    
+    // Saved windows not yet mapped during a restore
+    QList<SessionWindow> m_pendingWindows;
+    int m_restoredWindows;
+    QElapsedTimer m_restoreClock;
+    QTimer *m_restoreTimeout;
+    qint64 m_lastRestoreTime;
     
     // Load startup applications
     void loadStartupApplications();
     
     // Save startup applications
     void saveStartupApplications();
+    
+    // Start replacing the previous session in the store and schedule a flush
+    bool record();
+    
+    // Report the end of a restore
+    void finishRestore();
 };
 
 } // namespace VivoX::System
@@ -0,0 +1,418 @@
+#include "SessionStore.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <unistd.h>
+
+namespace VivoX::System {
+
+namespace {
+const QByteArray LogHeader = "VXSL 1";
+
+// The log is compacted once it holds this many records and four times as many as objects
+const int MinCompactRecords = 256;
+const int CompactFactor = 4;
+
+const QString WindowRecord = QStringLiteral("window");
+const QString WindowRemovedRecord = QStringLiteral("window-removed");
+const QString WorkspaceRecord = QStringLiteral("workspace");
+const QString WorkspaceRemovedRecord = QStringLiteral("workspace-removed");
+const QString ActiveWorkspaceRecord = QStringLiteral("active-workspace");
+const QString ApplicationRecord = QStringLiteral("application");
+const QString ApplicationRemovedRecord = QStringLiteral("application-removed");
+
+QJsonObject toJson(const SessionWindow &window)
+{
+    return QJsonObject {
+        { "t", WindowRecord },
+        { "key", window.key },
+        { "app", window.appId },
+        { "title", window.title },
+        { "x", window.geometry.x() },
+        { "y", window.geometry.y() },
+        { "width", window.geometry.width() },
+        { "height", window.geometry.height() },
+        { "state", window.state },
+        { "workspace", window.workspace },
+    };
+}
+
+SessionWindow windowFromJson(const QJsonObject &record)
+{
+    SessionWindow window;
+    window.key = record.value("key").toString();
+    window.appId = record.value("app").toString();
+    window.title = record.value("title").toString();
+    window.geometry = QRect(record.value("x").toInt(), record.value("y").toInt(),
+                            record.value("width").toInt(), record.value("height").toInt());
+    window.state = record.value("state").toInt();
+    window.workspace = record.value("workspace").toInt(-1);
+    return window;
+}
+
+QJsonObject toJson(const SessionWorkspace &workspace)
+{
+    return QJsonObject {
+        { "t", WorkspaceRecord },
+        { "id", workspace.id },
+        { "name", workspace.name },
+        { "index", workspace.index },
+    };
+}
+
+SessionWorkspace workspaceFromJson(const QJsonObject &record)
+{
+    SessionWorkspace workspace;
+    workspace.id = record.value("id").toString();
+    workspace.name = record.value("name").toString();
+    workspace.index = record.value("index").toInt();
+    return workspace;
+}
+
+QJsonObject simpleRecord(const QString &type, const QString &field, const QString &value)
+{
+    return QJsonObject { { "t", type }, { field, value } };
+}
+} // namespace
+
+SessionStore::SessionStore(const QString &directory)
+    : m_snapshotPath(directory + "/session.json")
+    , m_logPath(directory + "/session.log")
+    , m_generation(0)
+    , m_logSize(0)
+    , m_needsCompaction(false)
+{
+}
+
+bool SessionStore::load()
+{
+    m_windows.clear();
+    m_workspaces.clear();
+    m_activeWorkspace.clear();
+    m_applications.clear();
+    m_pendingOrder.clear();
+    m_pending.clear();
+    m_generation = 0;
+    m_logSize = 0;
+    m_needsCompaction = false;
+
+    QFile snapshot(m_snapshotPath);
+    if (snapshot.exists()) {
+        if (!snapshot.open(QIODevice::ReadOnly)) {
+            qWarning() << "Failed to open session snapshot:" << m_snapshotPath << snapshot.errorString();
+            return false;
+        }
+
+        const QJsonDocument document = QJsonDocument::fromJson(snapshot.readAll());
+        if (!document.isObject()) {
+            qWarning() << "Invalid session snapshot:" << m_snapshotPath;
+            m_needsCompaction = true;
+            return false;
+        }
+
+        const QJsonObject root = document.object();
+        m_generation = root.value("generation").toVariant().toULongLong();
+        for (const QJsonValue &window : root.value("windows").toArray()) {
+            m_windows.append(windowFromJson(window.toObject()));
+        }
+        for (const QJsonValue &workspace : root.value("workspaces").toArray()) {
+            m_workspaces.append(workspaceFromJson(workspace.toObject()));
+        }
+        m_activeWorkspace = root.value("activeWorkspace").toString();
+        for (const QJsonValue &application : root.value("applications").toArray()) {
+            m_applications.append(application.toString());
+        }
+    }
+
+    QFile log(m_logPath);
+    if (!log.exists()) {
+        return true;
+    }
+    if (!log.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open session log:" << m_logPath << log.errorString();
+        m_needsCompaction = true;
+        return false;
+    }
+
+    // A log of another generation predates the snapshot, which already contains it
+    const QByteArray header = log.readLine().trimmed();
+    if (header != LogHeader + ' ' + QByteArray::number(m_generation)) {
+        qWarning() << "Ignoring stale session log:" << m_logPath;
+        m_needsCompaction = true;
+        return true;
+    }
+
+    while (!log.atEnd()) {
+        const QByteArray line = log.readLine();
+
+        // A record without newline was cut short by a crash
+        const QJsonDocument record = QJsonDocument::fromJson(line);
+        if (!line.endsWith('\n') || !record.isObject()) {
+            qWarning() << "Session log ends with an incomplete record:" << m_logPath;
+            m_needsCompaction = true;
+            break;
+        }
+
+        apply(record.object());
+        ++m_logSize;
+    }
+
+    return true;
+}
+
+SessionState SessionStore::state() const
+{
+    SessionState state;
+    state.windows = m_windows;
+    state.workspaces = m_workspaces;
+    state.activeWorkspace = m_activeWorkspace;
+    state.applications = m_applications;
+
+    std::stable_sort(state.workspaces.begin(), state.workspaces.end(),
+                     [](const SessionWorkspace &a, const SessionWorkspace &b) { return a.index < b.index; });
+    return state;
+}
+
+void SessionStore::setWindow(const SessionWindow &window)
+{
+    const QJsonObject record = toJson(window);
+    apply(record);
+    stage(WindowRecord + ':' + window.key, record);
+}
+
+void SessionStore::removeWindow(const QString &key)
+{
+    const QJsonObject record = simpleRecord(WindowRemovedRecord, "key", key);
+    apply(record);
+    stage(WindowRecord + ':' + key, record);
+}
+
+void SessionStore::setWorkspace(const SessionWorkspace &workspace)
+{
+    const QJsonObject record = toJson(workspace);
+    apply(record);
+    stage(WorkspaceRecord + ':' + workspace.id, record);
+}
+
+void SessionStore::removeWorkspace(const QString &id)
+{
+    const QJsonObject record = simpleRecord(WorkspaceRemovedRecord, "id", id);
+    apply(record);
+    stage(WorkspaceRecord + ':' + id, record);
+}
+
+void SessionStore::setActiveWorkspace(const QString &id)
+{
+    if (id == m_activeWorkspace) {
+        return;
+    }
+
+    const QJsonObject record = simpleRecord(ActiveWorkspaceRecord, "id", id);
+    apply(record);
+    stage(ActiveWorkspaceRecord, record);
+}
+
+void SessionStore::addApplication(const QString &appId)
+{
+    if (m_applications.contains(appId)) {
+        return;
+    }
+
+    const QJsonObject record = simpleRecord(ApplicationRecord, "id", appId);
+    apply(record);
+    stage(ApplicationRecord + ':' + appId, record);
+}
+
+void SessionStore::removeApplication(const QString &appId)
+{
+    if (!m_applications.contains(appId)) {
+        return;
+    }
+
+    const QJsonObject record = simpleRecord(ApplicationRemovedRecord, "id", appId);
+    apply(record);
+    stage(ApplicationRecord + ':' + appId, record);
+}
+
+void SessionStore::clear()
+{
+    m_windows.clear();
+    m_workspaces.clear();
+    m_activeWorkspace.clear();
+    m_applications.clear();
+    m_pendingOrder.clear();
+    m_pending.clear();
+
+    // The next flush replaces the files with an empty snapshot
+    m_needsCompaction = true;
+}
+
+bool SessionStore::hasPendingChanges() const
+{
+    return m_needsCompaction || !m_pending.isEmpty();
+}
+
+bool SessionStore::flush()
+{
+    if (!hasPendingChanges()) {
+        return true;
+    }
+
+    const int records = m_logSize + m_pending.size();
+    if (m_needsCompaction || !QFile::exists(m_logPath)
+        || (records >= MinCompactRecords && records > CompactFactor * liveObjects())) {
+        return compact();
+    }
+
+    QFile log(m_logPath);
+    if (!log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Failed to append to session log:" << m_logPath << log.errorString();
+        m_needsCompaction = true;
+        return false;
+    }
+
+    QByteArray data;
+    for (const QString &key : m_pendingOrder) {
+        data += QJsonDocument(m_pending.value(key)).toJson(QJsonDocument::Compact) + '\n';
+    }
+
+    // One write and one sync per flush, however many records it holds
+    if (log.write(data) != data.size() || !log.flush() || ::fdatasync(log.handle()) != 0) {
+        qWarning() << "Failed to append to session log:" << m_logPath << log.errorString();
+        m_needsCompaction = true;
+        return false;
+    }
+
+    m_logSize += m_pending.size();
+    m_pendingOrder.clear();
+    m_pending.clear();
+    return true;
+}
+
+bool SessionStore::compact()
+{
+    QDir().mkpath(QFileInfo(m_snapshotPath).absolutePath());
+
+    QJsonArray windows;
+    for (const SessionWindow &window : m_windows) {
+        windows.append(toJson(window));
+    }
+    QJsonArray workspaces;
+    for (const SessionWorkspace &workspace : m_workspaces) {
+        workspaces.append(toJson(workspace));
+    }
+
+    const QJsonObject root {
+        { "generation", QString::number(m_generation + 1) },
+        { "windows", windows },
+        { "workspaces", workspaces },
+        { "activeWorkspace", m_activeWorkspace },
+        { "applications", QJsonArray::fromStringList(m_applications) },
+    };
+
+    // Snapshot first: until the new log replaces the old one, the old log
+    // is recognized as stale by its generation
+    QSaveFile snapshot(m_snapshotPath);
+    if (!snapshot.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write session snapshot:" << m_snapshotPath << snapshot.errorString();
+        m_needsCompaction = true;
+        return false;
+    }
+    snapshot.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!snapshot.commit()) {
+        qWarning() << "Failed to write session snapshot:" << m_snapshotPath << snapshot.errorString();
+        m_needsCompaction = true;
+        return false;
+    }
+
+    ++m_generation;
+    m_pendingOrder.clear();
+    m_pending.clear();
+    m_logSize = 0;
+
+    QSaveFile log(m_logPath);
+    if (!log.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write session log:" << m_logPath << log.errorString();
+        m_needsCompaction = true;
+        return false;
+    }
+    log.write(LogHeader + ' ' + QByteArray::number(m_generation) + '\n');
+    if (!log.commit()) {
+        qWarning() << "Failed to write session log:" << m_logPath << log.errorString();
+        m_needsCompaction = true;
+        return false;
+    }
+
+    m_needsCompaction = false;
+    return true;
+}
+
+int SessionStore::logSize() const
+{
+    return m_logSize;
+}
+
+void SessionStore::apply(const QJsonObject &record)
+{
+    const QString type = record.value("t").toString();
+
+    if (type == WindowRecord || type == WindowRemovedRecord) {
+        const QString key = record.value("key").toString();
+        auto it = std::find_if(m_windows.begin(), m_windows.end(),
+                               [&key](const SessionWindow &window) { return window.key == key; });
+        if (type == WindowRemovedRecord) {
+            if (it != m_windows.end()) {
+                m_windows.erase(it);
+            }
+        } else if (it != m_windows.end()) {
+            *it = windowFromJson(record);
+        } else {
+            m_windows.append(windowFromJson(record));
+        }
+    } else if (type == WorkspaceRecord || type == WorkspaceRemovedRecord) {
+        const QString id = record.value("id").toString();
+        auto it = std::find_if(m_workspaces.begin(), m_workspaces.end(),
+                               [&id](const SessionWorkspace &workspace) { return workspace.id == id; });
+        if (type == WorkspaceRemovedRecord) {
+            if (it != m_workspaces.end()) {
+                m_workspaces.erase(it);
+            }
+        } else if (it != m_workspaces.end()) {
+            *it = workspaceFromJson(record);
+        } else {
+            m_workspaces.append(workspaceFromJson(record));
+        }
+    } else if (type == ActiveWorkspaceRecord) {
+        m_activeWorkspace = record.value("id").toString();
+    } else if (type == ApplicationRecord) {
+        const QString id = record.value("id").toString();
+        if (!m_applications.contains(id)) {
+            m_applications.append(id);
+        }
+    } else if (type == ApplicationRemovedRecord) {
+        m_applications.removeAll(record.value("id").toString());
+    }
+}
+
+void SessionStore::stage(const QString &key, const QJsonObject &record)
+{
+    // A later change to the same object replaces the earlier record
+    if (!m_pending.contains(key)) {
+        m_pendingOrder.append(key);
+    }
+    m_pending.insert(key, record);
+}
+
+int SessionStore::liveObjects() const
+{
+    return m_windows.size() + m_workspaces.size() + m_applications.size() + 1;
+}
+
+} // namespace VivoX::System
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QRect>
+#include <QString>
+#include <QStringList>
+
+namespace VivoX::System {
+
+/**
+ * @brief Saved state of a window
+ */
+struct SessionWindow {
+    enum State {
+        Normal,
+        Maximized,
+        Fullscreen
+    };
+
+    QString key;          ///< Identifier of the window within its session
+    QString appId;        ///< Application the window belongs to
+    QString title;        ///< Window title
+    QRect geometry;       ///< Window geometry
+    int state = Normal;   ///< Window state
+    int workspace = -1;   ///< Index of the workspace the window is on, -1 if none
+};
+
+/**
+ * @brief Saved state of a workspace
+ */
+struct SessionWorkspace {
+    QString id;           ///< Workspace ID
+    QString name;         ///< Workspace name
+    int index = 0;        ///< Position among the workspaces
+};
+
+/**
+ * @brief Saved state of a session
+ */
+struct SessionState {
+    QList<SessionWindow> windows;          ///< Windows in the order they were mapped
+    QList<SessionWorkspace> workspaces;    ///< Workspaces ordered by index
+    QString activeWorkspace;               ///< ID of the active workspace
+    QStringList applications;              ///< Running applications in launch order
+
+    bool isEmpty() const { return windows.isEmpty() && applications.isEmpty(); }
+};
+
+/**
+ * @brief Crash-safe, incremental store of the session state.
+ *
+ * Changes are collected in memory and appended to a log as one JSON
+ * record per line when flush() is called. Changes to the same window,
+ * workspace or application between two flushes coalesce into one record,
+ * so dragging a window costs one record per flush rather than one per
+ * frame. Each flush is synced to disk.
+ *
+ * When the log grows to several times the size of the state, the state is
+ * written to a snapshot file with an atomic rename and a fresh log is
+ * started. The snapshot and the log carry a generation number, so a log
+ * left over from before an interrupted compaction is recognized and
+ * ignored. A record torn by a crash ends the replay of the log.
+ */
+class SessionStore {
+public:
+    /**
+     * @brief Create a store
+     * @param directory The directory holding the snapshot and log files
+     */
+    explicit SessionStore(const QString &directory);
+
+    /**
+     * @brief Load the snapshot and replay the log
+     * @return True if the files were read or don't exist yet
+     */
+    bool load();
+
+    /**
+     * @brief Get the current state
+     * @return The state
+     */
+    SessionState state() const;
+
+    /**
+     * @brief Add or update a window
+     * @param window The window
+     */
+    void setWindow(const SessionWindow &window);
+
+    /**
+     * @brief Remove a window
+     * @param key The window key
+     */
+    void removeWindow(const QString &key);
+
+    /**
+     * @brief Add or update a workspace
+     * @param workspace The workspace
+     */
+    void setWorkspace(const SessionWorkspace &workspace);
+
+    /**
+     * @brief Remove a workspace
+     * @param id The workspace ID
+     */
+    void removeWorkspace(const QString &id);
+
+    /**
+     * @brief Set the active workspace
+     * @param id The workspace ID
+     */
+    void setActiveWorkspace(const QString &id);
+
+    /**
+     * @brief Add a running application
+     * @param appId The application ID
+     */
+    void addApplication(const QString &appId);
+
+    /**
+     * @brief Remove a running application
+     * @param appId The application ID
+     */
+    void removeApplication(const QString &appId);
+
+    /**
+     * @brief Forget the whole state, e.g. when a new session starts
+     */
+    void clear();
+
+    /**
+     * @brief Check if there are changes that have not been flushed
+     * @return True if flush() has work to do
+     */
+    bool hasPendingChanges() const;
+
+    /**
+     * @brief Write pending changes to the log
+     *
+     * Compacts instead when the log has grown large or can't be appended to.
+     *
+     * @return True if successful
+     */
+    bool flush();
+
+    /**
+     * @brief Write a snapshot of the state and start a new log
+     * @return True if successful
+     */
+    bool compact();
+
+    /**
+     * @brief Get the number of records in the log
+     * @return Number of records
+     */
+    int logSize() const;
+
+private:
+    void apply(const QJsonObject &record);
+    void stage(const QString &key, const QJsonObject &record);
+    int liveObjects() const;
+
+    QString m_snapshotPath;
+    QString m_logPath;
+    quint64 m_generation;
+    int m_logSize;
+
+    // The log doesn't match the snapshot or ends in a torn record
+    bool m_needsCompaction;
+
+    QList<SessionWindow> m_windows;
+    QList<SessionWorkspace> m_workspaces;
+    QString m_activeWorkspace;
+    QStringList m_applications;
+
+    // Records not yet in the log, one per object, in order of first change
+    QStringList m_pendingOrder;
+    QHash<QString, QJsonObject> m_pending;
+};
+
+} // namespace VivoX::System
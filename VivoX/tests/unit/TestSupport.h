@@ -0,0 +1,73 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// The Qt fixture is only there for tests built against Qt
+#ifdef QT_CORE_LIB
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <functional>
+#endif
+
+namespace VivoX::Testing {
+
+/**
+ * @brief Microseconds between two points in time, for benchmark results
+ */
+inline int64_t microseconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+/**
+ * @brief The sample below which the given share of the samples lie
+ * @param samples The samples, in any order; must not be empty
+ * @param percent The share, 50 for the median
+ */
+template<typename T>
+T percentile(std::vector<T> samples, int percent) {
+    std::sort(samples.begin(), samples.end());
+    return samples[(samples.size() - 1) * percent / 100];
+}
+
+#ifdef QT_CORE_LIB
+/**
+ * @brief Fixture for tests that need a Qt event loop
+ *
+ * The application is created by the first suite that needs it and lives
+ * until the test program exits. Suites with setup of their own call
+ * QtTest::SetUpTestSuite() from theirs.
+ */
+class QtTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite() {
+        if (!QCoreApplication::instance()) {
+            static int argc = 1;
+            static char name[] = "vivox-unit-test";
+            static char *argv[] = { name, nullptr };
+            new QCoreApplication(argc, argv);
+        }
+    }
+
+    // Process events until the condition holds or the timeout expires
+    static bool waitFor(const std::function<bool()> &condition, int timeout = 5000) {
+        QElapsedTimer timer;
+        timer.start();
+        while (!condition() && timer.elapsed() < timeout) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+        return condition();
+    }
+
+    // Process events for a while
+    static void settle(int duration) {
+        waitFor([]() { return false; }, duration);
+    }
+};
+#endif
+
+} // namespace VivoX::Testing
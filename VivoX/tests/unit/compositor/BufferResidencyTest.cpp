@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/rendering/BufferResidency.h"
+
+using namespace VivoX::Compositor::Rendering;
+using namespace testing;
+
+namespace {
+    const int64_t second = 1000000000;
+
+    // A 1920x1080 RGBA buffer
+    const uint64_t fullHd = 1920ull * 1080 * 4;
+}
+
+class BufferResidencyTest : public Test {
+protected:
+    void SetUp() override {
+        m_residency.setGracePeriod(10 * second);
+        for (uint64_t window = 1; window <= 4; ++window) {
+            m_residency.setWindow(window, 1920, 1080);
+        }
+    }
+
+    BufferResidency m_residency;
+};
+
+TEST_F(BufferResidencyTest, KeepsVisibleWindows) {
+    EXPECT_EQ(m_residency.getStats().residentBytes, 4 * fullHd);
+    EXPECT_TRUE(m_residency.takeReleases(100 * second).empty());
+    EXPECT_EQ(m_residency.nextReleaseTime(0), -1);
+
+    // Even over budget
+    m_residency.setBudget(fullHd);
+    EXPECT_TRUE(m_residency.takeReleases(100 * second).empty());
+}
+
+TEST_F(BufferResidencyTest, ReleasesHiddenWindowsAfterGracePeriod) {
+    m_residency.setHidden(1, true, 0);
+    m_residency.setHidden(2, true, 2 * second);
+    EXPECT_EQ(m_residency.nextReleaseTime(second), 10 * second);
+
+    EXPECT_TRUE(m_residency.takeReleases(5 * second).empty());
+    EXPECT_THAT(m_residency.takeReleases(10 * second), ElementsAre(1u));
+    EXPECT_FALSE(m_residency.isResident(1));
+    EXPECT_EQ(m_residency.nextReleaseTime(10 * second), 12 * second);
+
+    // Shown again before its grace period is over
+    EXPECT_FALSE(m_residency.setHidden(2, false, 11 * second));
+    EXPECT_TRUE(m_residency.takeReleases(20 * second).empty());
+
+    const BufferResidency::Stats stats = m_residency.getStats();
+    EXPECT_EQ(stats.hiddenWindows, 1u);
+    EXPECT_EQ(stats.releasedWindows, 1u);
+    EXPECT_EQ(stats.residentBytes, 3 * fullHd);
+    EXPECT_EQ(stats.releasedBytes, fullHd);
+    EXPECT_EQ(stats.droppedBytes, fullHd);
+}
+
+TEST_F(BufferResidencyTest, ReleasesEarlyOverBudget) {
+    m_residency.setBudget(2 * fullHd + 1);
+    m_residency.setHidden(3, true, 2 * second);
+    m_residency.setHidden(1, true, 0);
+    m_residency.setHidden(2, true, second);
+    EXPECT_EQ(m_residency.nextReleaseTime(3 * second), 3 * second);
+
+    // The longest hidden go first, until the budget is met
+    EXPECT_THAT(m_residency.takeReleases(3 * second), ElementsAre(1u, 2u));
+    EXPECT_TRUE(m_residency.isResident(3));
+    EXPECT_EQ(m_residency.getStats().residentBytes, 2 * fullHd);
+    EXPECT_EQ(m_residency.nextReleaseTime(3 * second), 12 * second);
+}
+
+TEST_F(BufferResidencyTest, ReimportsOnDemand) {
+    m_residency.setHidden(1, true, 0);
+    m_residency.takeReleases(10 * second);
+
+    // A preview needs the buffer once more; the grace period starts over
+    EXPECT_TRUE(m_residency.reimport(1, 11 * second));
+    EXPECT_FALSE(m_residency.reimport(1, 11 * second));
+    EXPECT_TRUE(m_residency.isResident(1));
+    EXPECT_TRUE(m_residency.takeReleases(15 * second).empty());
+    EXPECT_THAT(m_residency.takeReleases(21 * second), ElementsAre(1u));
+
+    // Showing the window imports it again
+    EXPECT_TRUE(m_residency.setHidden(1, false, 22 * second));
+
+    const BufferResidency::Stats stats = m_residency.getStats();
+    EXPECT_EQ(stats.releases, 2u);
+    EXPECT_EQ(stats.reimports, 2u);
+    EXPECT_EQ(stats.droppedBytes, 2 * fullHd);
+    EXPECT_EQ(stats.releasedBytes, 0u);
+    EXPECT_EQ(stats.residentBytes, 4 * fullHd);
+}
+
+TEST_F(BufferResidencyTest, WaitsForWindowsNotReadyToBeReleased) {
+    m_residency.setHidden(1, true, 0);
+    m_residency.setHidden(2, true, 0);
+
+    // Window 1 has no preview yet
+    EXPECT_THAT(m_residency.takeReleases(10 * second, [](uint64_t window) { return window != 1; }), ElementsAre(2u));
+    EXPECT_THAT(m_residency.takeReleases(10 * second), ElementsAre(1u));
+}
+
+TEST_F(BufferResidencyTest, TracksResizedAndRemovedWindows) {
+    m_residency.setHidden(1, true, 0);
+    m_residency.takeReleases(10 * second);
+
+    m_residency.setWindow(1, 960, 540);
+    EXPECT_EQ(m_residency.getStats().releasedBytes, fullHd / 4);
+
+    m_residency.removeWindow(1);
+    m_residency.removeWindow(2);
+    EXPECT_FALSE(m_residency.hasWindow(1));
+    EXPECT_TRUE(m_residency.isResident(1));
+
+    const BufferResidency::Stats stats = m_residency.getStats();
+    EXPECT_EQ(stats.windows, 2u);
+    EXPECT_EQ(stats.releasedBytes, 0u);
+    EXPECT_EQ(stats.residentBytes, 2 * fullHd);
+    EXPECT_EQ(stats.droppedBytes, fullHd);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/rendering/ClientAccounting.h"
+
+using namespace VivoX::Compositor::Rendering;
+using namespace testing;
+
+namespace {
+    const int64_t second = 1000000000;
+    const int64_t millisecond = 1000000;
+}
+
+class ClientAccountingTest : public Test {
+protected:
+    void SetUp() override {
+        m_accounting.setGracePeriod(2 * second);
+        m_accounting.setLimit(ClientAccounting::Surfaces, 10, 20);
+        m_accounting.setLimit(ClientAccounting::RequestRate, 100, 1000);
+        for (uint64_t client = 1; client <= 3; ++client) {
+            m_accounting.addClient(client, static_cast<int>(100 + client), 0);
+        }
+    }
+
+    ClientAccounting m_accounting;
+};
+
+TEST_F(ClientAccountingTest, AccountsResourcesPerClient) {
+    m_accounting.add(1, ClientAccounting::Surfaces, 3, 0);
+    m_accounting.add(1, ClientAccounting::Surfaces, -1, 0);
+    m_accounting.set(2, ClientAccounting::TextureBytes, 4096, 0);
+
+    EXPECT_EQ(m_accounting.usage(1, ClientAccounting::Surfaces), 2u);
+    EXPECT_EQ(m_accounting.usage(2, ClientAccounting::Surfaces), 0u);
+    EXPECT_EQ(m_accounting.usage(2, ClientAccounting::TextureBytes), 4096u);
+
+    // Releasing more than held stops at nothing
+    m_accounting.add(1, ClientAccounting::Surfaces, -5, 0);
+    EXPECT_EQ(m_accounting.usage(1, ClientAccounting::Surfaces), 0u);
+
+    // Unknown clients are ignored
+    EXPECT_EQ(m_accounting.add(9, ClientAccounting::Surfaces, 50, 0), ClientAccounting::Normal);
+    EXPECT_FALSE(m_accounting.hasClient(9));
+
+    // Removing a client drops its pending events
+    m_accounting.set(2, ClientAccounting::Surfaces, 12, 0);
+    m_accounting.removeClient(2);
+    EXPECT_EQ(m_accounting.usage(2, ClientAccounting::TextureBytes), 0u);
+    EXPECT_TRUE(m_accounting.takeEvents().empty());
+    EXPECT_EQ(m_accounting.getStats().clients, 2u);
+}
+
+TEST_F(ClientAccountingTest, ReportsLimitsGoneOver) {
+    EXPECT_EQ(m_accounting.set(1, ClientAccounting::Surfaces, 10, 0), ClientAccounting::Normal);
+    EXPECT_EQ(m_accounting.set(1, ClientAccounting::Surfaces, 11, 0), ClientAccounting::OverSoftLimit);
+    EXPECT_EQ(m_accounting.set(1, ClientAccounting::Surfaces, 15, 0), ClientAccounting::OverSoftLimit);
+    EXPECT_EQ(m_accounting.set(1, ClientAccounting::Surfaces, 21, 0), ClientAccounting::OverHardLimit);
+    EXPECT_EQ(m_accounting.set(1, ClientAccounting::Surfaces, 5, 0), ClientAccounting::Normal);
+
+    // Only changes of level are reported
+    const std::vector<ClientAccounting::Event> events = m_accounting.takeEvents();
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].level, ClientAccounting::OverSoftLimit);
+    EXPECT_EQ(events[1].level, ClientAccounting::OverHardLimit);
+    EXPECT_EQ(events[2].level, ClientAccounting::Normal);
+    EXPECT_EQ(events[2].resource, ClientAccounting::Surfaces);
+    EXPECT_TRUE(m_accounting.takeEvents().empty());
+
+    const ClientAccounting::Stats stats = m_accounting.getStats();
+    EXPECT_EQ(stats.softLimitHits, 1u);
+    EXPECT_EQ(stats.hardLimitHits, 1u);
+    EXPECT_EQ(stats.clientsOverSoftLimit, 0u);
+}
+
+TEST_F(ClientAccountingTest, DisconnectsAfterGracePeriod) {
+    m_accounting.set(1, ClientAccounting::Surfaces, 25, second);
+    m_accounting.set(2, ClientAccounting::Surfaces, 25, second);
+    EXPECT_EQ(m_accounting.getStats().clientsOverHardLimit, 2u);
+    EXPECT_TRUE(m_accounting.update(2 * second).empty());
+
+    // The second client cleans up in time
+    m_accounting.set(2, ClientAccounting::Surfaces, 12, 2 * second);
+    EXPECT_EQ(m_accounting.update(3 * second), std::vector<uint64_t>({ 1 }));
+    EXPECT_TRUE(m_accounting.update(4 * second).empty());
+    EXPECT_EQ(m_accounting.getStats().disconnects, 1u);
+
+    // Its grace period starts over if it goes over again
+    m_accounting.set(2, ClientAccounting::Surfaces, 30, 5 * second);
+    EXPECT_TRUE(m_accounting.update(6 * second).empty());
+    EXPECT_EQ(m_accounting.update(7 * second), std::vector<uint64_t>({ 2 }));
+}
+
+TEST_F(ClientAccountingTest, MeasuresRequestRate) {
+    // 200 requests spread over a second
+    for (int i = 0; i < 200; ++i) {
+        m_accounting.request(1, i * 5 * millisecond);
+    }
+    EXPECT_EQ(m_accounting.level(1), ClientAccounting::OverSoftLimit);
+    EXPECT_EQ(m_accounting.usage(1, ClientAccounting::RequestRate), 200u);
+    EXPECT_EQ(m_accounting.getStats().requests, 200u);
+
+    // Half a second later, half of them still count
+    m_accounting.update(1500 * millisecond);
+    EXPECT_EQ(m_accounting.usage(1, ClientAccounting::RequestRate), 100u);
+
+    // The rate falls while the client is idle
+    m_accounting.update(3 * second);
+    EXPECT_EQ(m_accounting.usage(1, ClientAccounting::RequestRate), 0u);
+    EXPECT_EQ(m_accounting.level(1), ClientAccounting::Normal);
+
+    // A flood goes over the hard limit
+    m_accounting.request(2, 3 * second, 5000);
+    EXPECT_EQ(m_accounting.level(2), ClientAccounting::OverHardLimit);
+}
+
+TEST_F(ClientAccountingTest, RanksTopClients) {
+    m_accounting.set(1, ClientAccounting::TextureBytes, 100, 0);
+    m_accounting.set(2, ClientAccounting::TextureBytes, 300, 0);
+    m_accounting.set(3, ClientAccounting::TextureBytes, 200, 0);
+    m_accounting.set(3, ClientAccounting::Surfaces, 4, 0);
+
+    const std::vector<ClientAccounting::Usage> top = m_accounting.topClients(2, ClientAccounting::TextureBytes);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_EQ(top[0].client, 2u);
+    EXPECT_EQ(top[0].pid, 102);
+    EXPECT_EQ(top[1].client, 3u);
+    EXPECT_EQ(top[1].values[ClientAccounting::Surfaces], 4u);
+
+    EXPECT_EQ(m_accounting.topClients(10, ClientAccounting::Surfaces).size(), 3u);
+    EXPECT_STREQ(ClientAccounting::resourceName(ClientAccounting::TextureBytes), "textureBytes");
+}
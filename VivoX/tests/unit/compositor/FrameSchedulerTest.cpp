@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/rendering/FrameScheduler.h"
+
+using namespace VivoX::Compositor::Rendering;
+using namespace testing;
+
+namespace {
+    const int64_t refresh60 = 16666666;
+    const int64_t millisecond = 1000000;
+}
+
+class FrameSchedulerTest : public Test {
+protected:
+    void SetUp() override {
+        m_scheduler.addOutput("DP-1", 60000);
+        m_scheduler.setSafetyMargin(millisecond);
+    }
+
+    // Render a frame of the given duration starting at the given time
+    void renderFrame(const std::string& output, int64_t start, int64_t duration) {
+        m_scheduler.renderStarted(output, start);
+        m_scheduler.renderFinished(output, start + duration);
+    }
+
+    FrameScheduler m_scheduler;
+};
+
+TEST_F(FrameSchedulerTest, RendersImmediatelyWithoutPhase) {
+    EXPECT_EQ(m_scheduler.nextRenderStart("DP-1", 1000), 1000);
+    EXPECT_EQ(m_scheduler.nextRenderStart("unknown", 1000), 1000);
+}
+
+TEST_F(FrameSchedulerTest, PredictsNextVblankFromFeedback) {
+    const int64_t vblank = 1000 * millisecond;
+    m_scheduler.presented("DP-1", vblank, 1, refresh60);
+
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-1", vblank + millisecond), vblank + refresh60);
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-1", vblank + refresh60 + millisecond), vblank + 2 * refresh60);
+}
+
+TEST_F(FrameSchedulerTest, StartsLateWhenRenderTimeIsShort) {
+    const int64_t vblank = 1000 * millisecond;
+    m_scheduler.presented("DP-1", vblank, 1, refresh60);
+
+    // Build a history of 3 ms frames
+    for (int i = 0; i < 10; ++i) {
+        renderFrame("DP-1", vblank + millisecond, 3 * millisecond);
+    }
+
+    int64_t start = m_scheduler.nextRenderStart("DP-1", vblank + millisecond);
+    EXPECT_EQ(start, vblank + refresh60 - 3 * millisecond - millisecond);
+    EXPECT_EQ(m_scheduler.getStats("DP-1").predictedRenderTime, 3 * millisecond);
+}
+
+TEST_F(FrameSchedulerTest, CountsMissedDeadlines) {
+    const int64_t vblank = 1000 * millisecond;
+    m_scheduler.presented("DP-1", vblank, 1, refresh60);
+
+    // Frame targeting the next vblank is presented one refresh late
+    renderFrame("DP-1", vblank + millisecond, 20 * millisecond);
+    m_scheduler.presented("DP-1", vblank + 2 * refresh60, 3, refresh60);
+
+    // Frame presented on time
+    renderFrame("DP-1", vblank + 2 * refresh60 + millisecond, 2 * millisecond);
+    m_scheduler.presented("DP-1", vblank + 3 * refresh60, 4, refresh60);
+
+    FrameScheduler::OutputStats stats = m_scheduler.getStats("DP-1");
+    EXPECT_EQ(stats.framesPresented, 3u);
+    EXPECT_EQ(stats.missedDeadlines, 1u);
+    EXPECT_EQ(stats.lastSequence, 4u);
+}
+
+TEST_F(FrameSchedulerTest, DerivesRefreshFromHardwareSequence) {
+    m_scheduler.addOutput("HDMI-1", 0);
+
+    m_scheduler.presented("HDMI-1", 1000 * millisecond, 10);
+    m_scheduler.presented("HDMI-1", 1000 * millisecond + 2 * 6944444, 12);
+
+    EXPECT_EQ(m_scheduler.getStats("HDMI-1").refreshInterval, 6944444);
+}
+
+TEST_F(FrameSchedulerTest, OutputsAreScheduledIndependently) {
+    m_scheduler.addOutput("HDMI-1", 144000);
+
+    m_scheduler.presented("DP-1", 1000 * millisecond, 1, refresh60);
+    m_scheduler.presented("HDMI-1", 1003 * millisecond, 1, 6944444);
+
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-1", 1004 * millisecond), 1000 * millisecond + refresh60);
+    EXPECT_EQ(m_scheduler.nextPresentationTime("HDMI-1", 1004 * millisecond), 1003 * millisecond + 6944444);
+
+    m_scheduler.removeOutput("HDMI-1");
+    EXPECT_FALSE(m_scheduler.hasOutput("HDMI-1"));
+    EXPECT_TRUE(m_scheduler.hasOutput("DP-1"));
+}
+
+TEST_F(FrameSchedulerTest, ContentDrivenAdaptiveSyncFollowsClient) {
+    m_scheduler.addOutput("DP-2", 144000);
+    m_scheduler.setAdaptiveSync("DP-2", true);
+
+    const int64_t refresh144 = 6944444;
+    const int64_t vblank = 1000 * millisecond;
+    m_scheduler.presented("DP-2", vblank, 1, refresh144);
+
+    // Without content driving the refresh the fixed cadence still applies
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-2", vblank + 10 * millisecond), vblank + 2 * refresh144);
+
+    // A fullscreen client can present as soon as the maximum rate allows
+    m_scheduler.setContentDriven("DP-2", true);
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-2", vblank + 10 * millisecond), vblank + 10 * millisecond);
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-2", vblank + millisecond), vblank + refresh144);
+    EXPECT_EQ(m_scheduler.nextRenderStart("DP-2", vblank + 10 * millisecond), vblank + 10 * millisecond);
+}
+
+TEST_F(FrameSchedulerTest, AdaptiveSyncWaitsForSelfRefresh) {
+    // A 48-144 Hz panel
+    m_scheduler.addOutput("DP-2", 144000);
+    m_scheduler.setAdaptiveSync("DP-2", true, 48000);
+    m_scheduler.setContentDriven("DP-2", true);
+
+    const int64_t refresh144 = 6944444;
+    const int64_t refresh48 = 20833333;
+    const int64_t vblank = 1000 * millisecond;
+    m_scheduler.presented("DP-2", vblank, 1, refresh144);
+
+    // Within the range the client's frame goes out right away
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-2", vblank + 15 * millisecond), vblank + 15 * millisecond);
+
+    // Once the panel repeated the frame, the next one waits for that scanout
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-2", vblank + 22 * millisecond), vblank + refresh48 + refresh144);
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-2", vblank + 30 * millisecond), vblank + 30 * millisecond);
+    EXPECT_EQ(m_scheduler.nextPresentationTime("DP-2", vblank + 2 * refresh48 + millisecond), vblank + 2 * refresh48 + refresh144);
+}
+
+TEST_F(FrameSchedulerTest, ReportsPerOutputFrameRate) {
+    m_scheduler.addOutput("HDMI-1", 144000);
+
+    const int64_t refresh144 = 6944444;
+    for (int i = 0; i < 10; ++i) {
+        m_scheduler.presented("DP-1", i * refresh60, i, refresh60);
+        m_scheduler.presented("HDMI-1", i * refresh144 + 1, i, refresh144);
+    }
+
+    EXPECT_NEAR(m_scheduler.getStats("DP-1").frameRate, 60.0f, 0.1f);
+    EXPECT_NEAR(m_scheduler.getStats("HDMI-1").frameRate, 144.0f, 0.1f);
+    EXPECT_EQ(m_scheduler.getStats("HDMI-1").averageFrameTime, refresh144);
+}
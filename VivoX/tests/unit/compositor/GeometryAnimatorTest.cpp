@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/rendering/GeometryAnimator.h"
+
+using namespace VivoX::Compositor::Rendering;
+using namespace testing;
+
+namespace {
+    const int64_t millisecond = 1000000;
+
+    GeometryAnimator::Rect rect(float x, float y, float width, float height) {
+        GeometryAnimator::Rect r;
+        r.x = x;
+        r.y = y;
+        r.width = width;
+        r.height = height;
+        return r;
+    }
+}
+
+class GeometryAnimatorTest : public Test {
+protected:
+    void SetUp() override {
+        m_animator.setDuration(100 * millisecond);
+        m_animator.setCurve(GeometryAnimator::Curve::Linear);
+        m_animator.setCrossfadeDuration(50 * millisecond);
+        m_animator.setResizeTimeout(200 * millisecond);
+    }
+
+    GeometryAnimator m_animator;
+};
+
+TEST_F(GeometryAnimatorTest, InterpolatesGeometryAndScalesOldBuffer) {
+    EXPECT_TRUE(m_animator.animate(1, rect(0, 0, 800, 600), rect(100, 0, 400, 600), 0));
+    EXPECT_TRUE(m_animator.isAnimating(1));
+
+    EXPECT_EQ(m_animator.update(50 * millisecond), 1u);
+    const GeometryAnimator::Transform* transform = m_animator.getTransform(1);
+    ASSERT_NE(transform, nullptr);
+    EXPECT_FLOAT_EQ(transform->rect.x, 50.0f);
+    EXPECT_FLOAT_EQ(transform->rect.width, 600.0f);
+    EXPECT_FLOAT_EQ(transform->oldScaleX, 0.75f);
+    EXPECT_FLOAT_EQ(transform->oldScaleY, 1.0f);
+    EXPECT_FLOAT_EQ(transform->newScaleX, 1.5f);
+
+    // Until the client resizes, only the old buffer is shown
+    EXPECT_FLOAT_EQ(transform->crossfade, 0.0f);
+    EXPECT_FALSE(transform->finished);
+}
+
+TEST_F(GeometryAnimatorTest, CrossfadesToResizedBuffer) {
+    m_animator.animate(1, rect(0, 0, 800, 600), rect(0, 0, 400, 600), 0);
+
+    EXPECT_FALSE(m_animator.bufferCommitted(1, 800, 600, 10 * millisecond));
+    EXPECT_TRUE(m_animator.bufferCommitted(1, 400, 600, 80 * millisecond));
+    EXPECT_FALSE(m_animator.bufferCommitted(1, 400, 600, 90 * millisecond));
+
+    m_animator.update(105 * millisecond);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->crossfade, 0.5f);
+    EXPECT_FALSE(m_animator.getTransform(1)->finished);
+
+    // The last frame is at the target, then the animation is dropped
+    m_animator.update(130 * millisecond);
+    EXPECT_TRUE(m_animator.getTransform(1)->finished);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->rect.width, 400.0f);
+    EXPECT_FALSE(m_animator.isAnimating(1));
+
+    EXPECT_EQ(m_animator.update(146 * millisecond), 0u);
+    EXPECT_EQ(m_animator.getTransform(1), nullptr);
+
+    const GeometryAnimator::Stats stats = m_animator.getStats();
+    EXPECT_EQ(stats.crossfades, 1u);
+    EXPECT_EQ(stats.finished, 1u);
+    EXPECT_EQ(stats.timedOut, 0u);
+}
+
+TEST_F(GeometryAnimatorTest, MovesWithoutCrossfadeWhenSizeIsKept) {
+    EXPECT_FALSE(m_animator.animate(1, rect(0, 0, 800, 600), rect(200, 100, 800, 600), 0));
+    EXPECT_FALSE(m_animator.animate(2, rect(0, 0, 800, 600), rect(0, 0, 800, 600), 0));
+    EXPECT_FALSE(m_animator.isAnimating(2));
+
+    m_animator.update(50 * millisecond);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->crossfade, 1.0f);
+    m_animator.update(100 * millisecond);
+    EXPECT_TRUE(m_animator.getTransform(1)->finished);
+}
+
+TEST_F(GeometryAnimatorTest, GivesUpOnSlowClients) {
+    m_animator.animate(1, rect(0, 0, 800, 600), rect(0, 0, 400, 600), 0);
+
+    m_animator.update(200 * millisecond);
+    EXPECT_FALSE(m_animator.getTransform(1)->finished);
+    m_animator.update(300 * millisecond);
+    EXPECT_TRUE(m_animator.getTransform(1)->finished);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->crossfade, 1.0f);
+    EXPECT_EQ(m_animator.getStats().timedOut, 1u);
+}
+
+TEST_F(GeometryAnimatorTest, RetargetsFromCurrentPosition) {
+    m_animator.animate(1, rect(0, 0, 800, 600), rect(0, 0, 400, 600), 0);
+
+    // The old buffer is still the one shown
+    EXPECT_FALSE(m_animator.animate(1, rect(0, 0, 400, 600), rect(0, 0, 1000, 600), 50 * millisecond));
+    m_animator.update(50 * millisecond);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->rect.width, 600.0f);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->oldScaleX, 0.75f);
+
+    m_animator.update(100 * millisecond);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->rect.width, 800.0f);
+
+    // Once the resized buffer is shown, it becomes the one to keep
+    m_animator.bufferCommitted(1, 1000, 600, 150 * millisecond);
+    m_animator.update(200 * millisecond);
+    EXPECT_TRUE(m_animator.animate(1, rect(0, 0, 1000, 600), rect(0, 0, 500, 600), 200 * millisecond));
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->oldScaleX, 1.0f);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(1)->crossfade, 0.0f);
+    EXPECT_EQ(m_animator.getStats().retargeted, 2u);
+}
+
+TEST_F(GeometryAnimatorTest, KeepsOthersWhenOneIsCancelled) {
+    for (uint64_t window = 1; window <= 3; ++window) {
+        m_animator.animate(window, rect(0, 0, 100, 100), rect(100.0f * window, 0, 100, 100), 0);
+    }
+
+    m_animator.cancel(1);
+    EXPECT_FALSE(m_animator.isAnimating(1));
+    EXPECT_EQ(m_animator.update(50 * millisecond), 2u);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(2)->rect.x, 100.0f);
+    EXPECT_FLOAT_EQ(m_animator.getTransform(3)->rect.x, 150.0f);
+    EXPECT_THAT(m_animator.getTransforms(), SizeIs(2));
+    EXPECT_EQ(m_animator.getStats().active, 2u);
+}
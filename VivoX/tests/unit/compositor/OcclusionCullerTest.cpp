@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/wayland/OcclusionCuller.h"
+
+#include <QElapsedTimer>
+
+using namespace VivoX::Compositor;
+using namespace testing;
+
+namespace {
+    const QRect output(0, 0, 1920, 1080);
+
+    OcclusionCuller::Surface opaque(quintptr key, const QRect &geometry) {
+        return { key, geometry, QRegion(QRect(QPoint(0, 0), geometry.size())) };
+    }
+
+    OcclusionCuller::Surface translucent(quintptr key, const QRect &geometry) {
+        return { key, geometry, QRegion() };
+    }
+}
+
+TEST(OcclusionCullerTest, CullsFullyCoveredSurfaces) {
+    OcclusionCuller culler;
+    culler.update(output, {
+        opaque(1, QRect(0, 0, 1920, 1080)),
+        opaque(2, QRect(100, 100, 800, 600)),
+        translucent(3, QRect(200, 200, 300, 300)),
+    });
+
+    EXPECT_FALSE(culler.isOccluded(1));
+    EXPECT_TRUE(culler.isOccluded(2));
+    EXPECT_TRUE(culler.isOccluded(3));
+    EXPECT_EQ(culler.culledCount(), 2);
+    EXPECT_EQ(culler.visibleCount(), 1);
+    EXPECT_EQ(culler.visibleRegion(1), QRegion(output));
+}
+
+TEST(OcclusionCullerTest, KeepsPartiallyCoveredSurfaces) {
+    OcclusionCuller culler;
+    culler.update(output, {
+        opaque(1, QRect(0, 0, 960, 1080)),
+        opaque(2, QRect(480, 0, 960, 1080)),
+    });
+
+    EXPECT_FALSE(culler.isOccluded(2));
+    EXPECT_EQ(culler.visibleRegion(2), QRegion(QRect(960, 0, 480, 1080)));
+    EXPECT_EQ(culler.culledCount(), 0);
+}
+
+TEST(OcclusionCullerTest, TranslucentSurfacesDontOcclude) {
+    OcclusionCuller culler;
+    culler.update(output, {
+        translucent(1, output),
+        opaque(2, QRect(100, 100, 800, 600)),
+    });
+
+    EXPECT_FALSE(culler.isOccluded(2));
+    EXPECT_EQ(culler.culledCount(), 0);
+}
+
+TEST(OcclusionCullerTest, UsesOpaqueRegionInSurfaceCoordinates) {
+    // A window with a translucent 20 pixel shadow around its opaque body
+    OcclusionCuller::Surface shadowed = { 1, QRect(80, 80, 840, 640), QRegion(20, 20, 800, 600) };
+
+    OcclusionCuller culler;
+    culler.update(output, {
+        shadowed,
+        opaque(2, QRect(100, 100, 800, 600)),
+        opaque(3, QRect(90, 90, 820, 620)),
+    });
+
+    EXPECT_TRUE(culler.isOccluded(2));
+    EXPECT_FALSE(culler.isOccluded(3));
+    EXPECT_EQ(culler.visibleRegion(3), QRegion(QRect(90, 90, 820, 620)) - QRegion(100, 100, 800, 600));
+}
+
+TEST(OcclusionCullerTest, CombinesSeveralOccluders) {
+    OcclusionCuller culler;
+    culler.update(output, {
+        opaque(1, QRect(0, 0, 960, 1080)),
+        opaque(2, QRect(960, 0, 960, 1080)),
+        opaque(3, QRect(500, 300, 900, 500)),
+    });
+
+    EXPECT_TRUE(culler.isOccluded(3));
+}
+
+TEST(OcclusionCullerTest, IgnoresSurfacesOnOtherOutputs) {
+    OcclusionCuller culler;
+    culler.update(output, {
+        opaque(1, output),
+        opaque(2, QRect(1920, 0, 1920, 1080)),
+    });
+
+    EXPECT_FALSE(culler.isOccluded(2));
+    EXPECT_TRUE(culler.visibleRegion(2).isEmpty());
+    EXPECT_TRUE(culler.geometry(2).isEmpty());
+    EXPECT_EQ(culler.culledCount(), 0);
+    EXPECT_EQ(culler.visibleCount(), 1);
+}
+
+TEST(OcclusionCullerTest, ReportsChanges) {
+    OcclusionCuller culler;
+    EXPECT_TRUE(culler.update(output, { opaque(1, QRect(0, 0, 800, 600)), opaque(2, output) }).isEmpty());
+
+    // Maximizing the top window hides the one below
+    EXPECT_THAT(culler.update(output, { opaque(1, output), opaque(2, output) }), ElementsAre(2));
+    EXPECT_TRUE(culler.update(output, { opaque(1, output), opaque(2, output) }).isEmpty());
+
+    // Moving the hidden window to another output uncovers it here
+    EXPECT_THAT(culler.update(output, { opaque(1, output), opaque(2, QRect(1920, 0, 800, 600)) }), ElementsAre(2));
+    EXPECT_FALSE(culler.isOccluded(2));
+
+    culler.update(output, { opaque(1, output), opaque(2, output) });
+    culler.remove(2);
+    EXPECT_FALSE(culler.isOccluded(2));
+    EXPECT_EQ(culler.culledCount(), 0);
+}
+
+TEST(OcclusionCullerTest, ClicksGoToTheTopmostSurface) {
+    const QVector<OcclusionCuller::Surface> editorOnTop = {
+        opaque(1, QRect(100, 100, 800, 600)),
+        translucent(2, QRect(500, 300, 800, 600)),
+        opaque(3, output),
+    };
+
+    OcclusionCuller culler;
+    culler.update(output, editorOnTop);
+
+    // The overlap belongs to the window on top, the rest of each window to itself
+    EXPECT_EQ(culler.surfaceAt(QPointF(600, 400), editorOnTop), 1u);
+    EXPECT_EQ(culler.surfaceAt(QPointF(1200, 800), editorOnTop), 2u);
+    EXPECT_EQ(culler.surfaceAt(QPointF(50, 50), editorOnTop), 3u);
+    EXPECT_EQ(culler.surfaceAt(QPointF(2000, 50), editorOnTop), 0u);
+
+    // Raising the other window moves the overlap to it, even before the next update
+    const QVector<OcclusionCuller::Surface> terminalOnTop = { editorOnTop[1], editorOnTop[0], editorOnTop[2] };
+    EXPECT_EQ(culler.surfaceAt(QPointF(600, 400), terminalOnTop), 2u);
+    EXPECT_EQ(culler.surfaceAt(QPointF(200, 200), terminalOnTop), 1u);
+
+    // A surface culled in the last update takes no input
+    culler.update(output, { opaque(1, output), opaque(4, QRect(0, 0, 100, 100)) });
+    ASSERT_TRUE(culler.isOccluded(4));
+    EXPECT_EQ(culler.surfaceAt(QPointF(50, 50), { opaque(4, QRect(0, 0, 100, 100)) }), 0u);
+}
+
+TEST(OcclusionCullerTest, StackedWindowsBenchmark) {
+    const int windows = 500;
+    const int frames = 200;
+
+    // A maximized window on top of a pile of overlapping ones
+    QVector<OcclusionCuller::Surface> frontToBack;
+    frontToBack.append(opaque(1, output));
+    for (int window = 2; window <= windows; ++window) {
+        frontToBack.append(opaque(window, QRect((window * 37) % 1200, (window * 23) % 600, 640, 480)));
+    }
+
+    OcclusionCuller culler;
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < frames; ++frame) {
+        culler.update(output, frontToBack);
+    }
+    const qint64 elapsed = timer.nsecsElapsed() / 1000;
+
+    EXPECT_EQ(culler.culledCount(), windows - 1);
+    EXPECT_EQ(culler.visibleCount(), 1);
+
+    RecordProperty("windows", windows);
+    RecordProperty("culled", culler.culledCount());
+    RecordProperty("updateUs", static_cast<int>(elapsed / frames));
+}
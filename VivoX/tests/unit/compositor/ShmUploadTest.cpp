@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/rendering/ShmUpload.h"
+#include "tests/unit/TestSupport.h"
+
+#include <chrono>
+#include <vector>
+
+using namespace VivoX::Compositor::Rendering;
+using namespace VivoX::Testing;
+using namespace testing;
+
+namespace {
+    ShmUpload::Rect rect(int x, int y, int width, int height) {
+        ShmUpload::Rect result;
+        result.x = x;
+        result.y = y;
+        result.width = width;
+        result.height = height;
+        return result;
+    }
+
+    // Every byte tells where it came from
+    std::vector<uint8_t> pattern(int stride, int height) {
+        std::vector<uint8_t> pixels(static_cast<size_t>(stride) * height);
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = static_cast<uint8_t>(i * 7 + i / 251);
+        }
+        return pixels;
+    }
+}
+
+TEST(ShmUploadTest, MapsShmFormats) {
+    EXPECT_EQ(ShmUpload::fromShmFormat(0), ShmUpload::Format::BGRA);
+    EXPECT_EQ(ShmUpload::fromShmFormat(1), ShmUpload::Format::BGRX);
+    EXPECT_EQ(ShmUpload::fromShmFormat(0x34324241), ShmUpload::Format::RGBA);
+    EXPECT_EQ(ShmUpload::fromShmFormat(0x34324742), ShmUpload::Format::RGB);
+    EXPECT_EQ(ShmUpload::fromShmFormat(0x36314752), ShmUpload::Format::Invalid);
+
+    EXPECT_EQ(ShmUpload::bytesPerPixel(ShmUpload::Format::BGRX), 4);
+    EXPECT_EQ(ShmUpload::bytesPerPixel(ShmUpload::Format::RGB), 3);
+    EXPECT_EQ(ShmUpload::bytesPerPixel(ShmUpload::Format::Invalid), 0);
+    EXPECT_TRUE(ShmUpload::hasAlpha(ShmUpload::Format::BGRA));
+    EXPECT_FALSE(ShmUpload::hasAlpha(ShmUpload::Format::BGRX));
+}
+
+TEST(ShmUploadTest, ClipsAndMergesDamage) {
+    // Two glyph cells next to each other, one far away and one outside the buffer
+    const ShmUpload::Plan plan = ShmUpload::plan(1000, 800, ShmUpload::Format::BGRX,
+                                                 { rect(500, 300, 10, 20), rect(100, 10, 10, 20),
+                                                   rect(110, 10, 10, 20), rect(2000, 0, 10, 10),
+                                                   rect(-5, 790, 20, 20) });
+    ASSERT_EQ(plan.regions.size(), 3u);
+    EXPECT_FALSE(plan.full);
+
+    // Sorted top to bottom
+    EXPECT_EQ(plan.regions[0].rect.x, 100);
+    EXPECT_EQ(plan.regions[0].rect.width, 20);
+    EXPECT_EQ(plan.regions[1].rect.y, 300);
+    EXPECT_EQ(plan.regions[2].rect.x, 0);
+    EXPECT_EQ(plan.regions[2].rect.width, 15);
+    EXPECT_EQ(plan.regions[2].rect.height, 10);
+
+    // Regions are staged one after another, aligned
+    EXPECT_EQ(plan.regions[0].offset, 0u);
+    EXPECT_EQ(plan.regions[1].offset, 20u * 20 * 4);
+    EXPECT_EQ(plan.regions[2].offset % 16, 0u);
+    EXPECT_EQ(plan.bytes, plan.regions[2].offset + 15 * 10 * 4);
+
+    EXPECT_TRUE(ShmUpload::plan(1000, 800, ShmUpload::Format::BGRX, { rect(1000, 800, 5, 5) }).regions.empty());
+    EXPECT_TRUE(ShmUpload::plan(1000, 800, ShmUpload::Format::Invalid, { rect(0, 0, 5, 5) }).regions.empty());
+}
+
+TEST(ShmUploadTest, LimitsTheNumberOfRegions) {
+    // A checkerboard of cells too far apart to be merged by waste alone
+    std::vector<ShmUpload::Rect> damage;
+    for (int i = 0; i < 100; ++i) {
+        damage.push_back(rect((i % 10) * 300, (i / 10) * 200, 8, 8));
+    }
+
+    const ShmUpload::Plan plan = ShmUpload::plan(3000, 2000, ShmUpload::Format::RGBA, damage);
+    EXPECT_FALSE(plan.full);
+    EXPECT_LE(plan.regions.size(), 16u);
+    EXPECT_GE(plan.regions.size(), 2u);
+}
+
+TEST(ShmUploadTest, FallsBackToFullUpload) {
+    const ShmUpload::Plan plan = ShmUpload::plan(100, 100, ShmUpload::Format::RGB,
+                                                 { rect(0, 0, 100, 40), rect(0, 50, 100, 40) });
+    ASSERT_EQ(plan.regions.size(), 1u);
+    EXPECT_TRUE(plan.full);
+    EXPECT_EQ(plan.regions[0].rect.width, 100);
+    EXPECT_EQ(plan.regions[0].rect.height, 100);
+    EXPECT_EQ(plan.bytes, 100u * 100 * 3);
+}
+
+TEST(ShmUploadTest, StagesDamagedRows) {
+    // Rows are padded, as clients commonly do
+    const int width = 256;
+    const int height = 128;
+    const int stride = width * 3 + 8;
+    const std::vector<uint8_t> pixels = pattern(stride, height);
+
+    const ShmUpload::Plan plan = ShmUpload::plan(width, height, ShmUpload::Format::RGB,
+                                                 { rect(3, 2, 5, 4), rect(200, 100, 7, 3) });
+    ASSERT_EQ(plan.regions.size(), 2u);
+
+    std::vector<uint8_t> staging(plan.bytes);
+    ShmUpload::stage(plan, pixels.data(), stride, ShmUpload::Format::RGB, staging.data());
+
+    for (const ShmUpload::Region& region : plan.regions) {
+        const ShmUpload::Rect& r = region.rect;
+        for (int y = 0; y < r.height; ++y) {
+            for (int x = 0; x < r.width * 3; ++x) {
+                ASSERT_EQ(staging[region.offset + y * r.width * 3 + x], pixels[(r.y + y) * stride + r.x * 3 + x]);
+            }
+        }
+    }
+
+    // A full upload of a tightly packed buffer is a plain copy
+    const std::vector<uint8_t> packed = pattern(width * 4, height);
+    const ShmUpload::Plan full = ShmUpload::plan(width, height, ShmUpload::Format::BGRA, { rect(0, 0, width, height) });
+    std::vector<uint8_t> copy(full.bytes);
+    ShmUpload::stage(full, packed.data(), width * 4, ShmUpload::Format::BGRA, copy.data());
+    EXPECT_EQ(copy, packed);
+}
+
+TEST(ShmUploadTest, TerminalBenchmark) {
+    // A 4K terminal with 10x20 cells; each frame the user types a character
+    const int width = 3840;
+    const int height = 2160;
+    const int stride = width * 4;
+    const int cellWidth = 10;
+    const int cellHeight = 20;
+    const std::vector<uint8_t> pixels = pattern(stride, height);
+    std::vector<uint8_t> staging(static_cast<size_t>(stride) * height);
+
+    const int frames = 120;
+    size_t partialBytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        const int column = frame % (width / cellWidth - 1);
+        const int line = 50 + frame / (width / cellWidth - 1);
+
+        // The new character, the cursor moved next to it, and the clock in the status line
+        const ShmUpload::Plan plan = ShmUpload::plan(width, height, ShmUpload::Format::BGRX,
+                                                     { rect(column * cellWidth, line * cellHeight, cellWidth, cellHeight),
+                                                       rect((column + 1) * cellWidth, line * cellHeight, cellWidth, cellHeight),
+                                                       rect(width - 80 * cellWidth, height - cellHeight, 80 * cellWidth, cellHeight) });
+        ShmUpload::stage(plan, pixels.data(), stride, ShmUpload::Format::BGRX, staging.data());
+        partialBytes += plan.bytes;
+    }
+    const auto partial = std::chrono::steady_clock::now();
+
+    size_t fullBytes = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        const ShmUpload::Plan plan = ShmUpload::plan(width, height, ShmUpload::Format::BGRX, { rect(0, 0, width, height) });
+        ShmUpload::stage(plan, pixels.data(), stride, ShmUpload::Format::BGRX, staging.data());
+        fullBytes += plan.bytes;
+    }
+    const auto full = std::chrono::steady_clock::now();
+
+    // Well under a percent of the buffer
+    EXPECT_LT(partialBytes * 100, fullBytes);
+
+    RecordProperty("frames", frames);
+    RecordProperty("damagedBytesPerFrame", static_cast<int>(partialBytes / frames));
+    RecordProperty("damagedUsPerFrame", static_cast<int>(microseconds(start, partial) / frames));
+    RecordProperty("fullBytesPerFrame", static_cast<int>(fullBytes / frames));
+    RecordProperty("fullUsPerFrame", static_cast<int>(microseconds(partial, full) / frames));
+}
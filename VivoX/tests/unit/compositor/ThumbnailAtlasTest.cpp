@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/rendering/ThumbnailAtlas.h"
+
+#include <chrono>
+#include <set>
+
+using namespace VivoX::Compositor::Rendering;
+using namespace testing;
+
+namespace {
+    const int64_t millisecond = 1000000;
+
+    bool overlaps(const ThumbnailAtlas::Rect& a, const ThumbnailAtlas::Rect& b) {
+        return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+    }
+
+    std::set<uint64_t> windowsOf(const std::vector<ThumbnailAtlas::Update>& updates) {
+        std::set<uint64_t> windows;
+        for (const auto& update : updates) {
+            windows.insert(update.window);
+        }
+        return windows;
+    }
+}
+
+class ThumbnailAtlasTest : public Test {
+protected:
+    // Check that every window has a cell inside the atlas and no cells overlap
+    void expectDisjoint(const ThumbnailAtlas& atlas, uint64_t windows) {
+        std::vector<ThumbnailAtlas::Rect> rects;
+        for (uint64_t window = 1; window <= windows; ++window) {
+            if (!atlas.hasWindow(window)) {
+                continue;
+            }
+            const ThumbnailAtlas::Rect rect = atlas.getRect(window);
+            ASSERT_GT(rect.width, 0) << window;
+            ASSERT_GE(rect.x, 0);
+            ASSERT_GE(rect.y, 0);
+            ASSERT_LE(rect.x + rect.width, atlas.getSize());
+            ASSERT_LE(rect.y + rect.height, atlas.getSize());
+            for (const auto& other : rects) {
+                ASSERT_FALSE(overlaps(rect, other)) << window;
+            }
+            rects.push_back(rect);
+        }
+    }
+};
+
+TEST_F(ThumbnailAtlasTest, ScalesDownKeepingAspectRatio) {
+    ThumbnailAtlas atlas(2048, 256);
+    atlas.setWindow(1, 1920, 1080);
+    atlas.setWindow(2, 400, 1200);
+    atlas.setWindow(3, 100, 50);
+
+    EXPECT_EQ(atlas.getRect(1).width, 256);
+    EXPECT_EQ(atlas.getRect(1).height, 144);
+    EXPECT_EQ(atlas.getRect(2).width, 85);
+    EXPECT_EQ(atlas.getRect(2).height, 256);
+
+    // Small windows are not scaled up
+    EXPECT_EQ(atlas.getRect(3).width, 100);
+    EXPECT_EQ(atlas.getRect(3).height, 50);
+    EXPECT_EQ(atlas.getRect(4).width, 0);
+}
+
+TEST_F(ThumbnailAtlasTest, AlignsCellsToSmallestMipLevel) {
+    ThumbnailAtlas atlas(1024, 256, 4);
+    for (uint64_t window = 1; window <= 20; ++window) {
+        atlas.setWindow(window, 100 + 37 * window, 80 + 13 * window);
+    }
+
+    for (const auto& update : atlas.takeUpdates(0)) {
+        EXPECT_EQ(update.cell.x % 8, 0);
+        EXPECT_EQ(update.cell.y % 8, 0);
+        EXPECT_EQ(update.cell.width % 8, 0);
+        EXPECT_EQ(update.cell.height % 8, 0);
+        EXPECT_EQ(update.rect.x, update.cell.x);
+        EXPECT_LE(update.rect.width, update.cell.width);
+    }
+    expectDisjoint(atlas, 20);
+}
+
+TEST_F(ThumbnailAtlasTest, RedrawsOnlyChangedContentAtCappedRate) {
+    ThumbnailAtlas atlas;
+    atlas.setUpdateInterval(100 * millisecond);
+    atlas.setWindow(1, 800, 600);
+    atlas.setWindow(2, 800, 600);
+
+    // New thumbnails are drawn right away
+    EXPECT_EQ(windowsOf(atlas.takeUpdates(0)), std::set<uint64_t>({ 1, 2 }));
+    EXPECT_TRUE(atlas.isReady(1));
+    EXPECT_TRUE(atlas.takeUpdates(200 * millisecond).empty());
+    EXPECT_EQ(atlas.nextUpdateTime(200 * millisecond), -1);
+
+    // A client committing every frame is redrawn at most ten times a second
+    int updates = 0;
+    for (int64_t now = 0; now < 1000 * millisecond; now += 16 * millisecond) {
+        atlas.damageWindow(1);
+        updates += static_cast<int>(atlas.takeUpdates(now).size());
+    }
+    EXPECT_LE(updates, 10);
+    EXPECT_GE(updates, 8);
+    EXPECT_GT(atlas.getStats().coalescedDamage, 40u);
+
+    // The wakeup for pending damage honours the interval
+    atlas.damageWindow(2);
+    EXPECT_EQ(atlas.nextUpdateTime(1000 * millisecond), 1000 * millisecond);
+    atlas.takeUpdates(1000 * millisecond);
+    atlas.damageWindow(2);
+    EXPECT_EQ(atlas.nextUpdateTime(1010 * millisecond), 1100 * millisecond);
+}
+
+TEST_F(ThumbnailAtlasTest, SpreadsUpdatesOverFrames) {
+    ThumbnailAtlas atlas;
+    atlas.setUpdateBudget(8);
+    atlas.setUpdateInterval(0);
+    for (uint64_t window = 1; window <= 20; ++window) {
+        atlas.setWindow(window, 640, 480);
+    }
+    atlas.takeUpdates(0);
+    atlas.takeUpdates(0);
+    atlas.takeUpdates(0);
+
+    // Everything changes at once; the stalest go first, and nothing starves
+    for (uint64_t window = 1; window <= 20; ++window) {
+        atlas.damageWindow(window);
+    }
+    std::set<uint64_t> seen;
+    for (int frame = 1; frame <= 3; ++frame) {
+        const auto updates = atlas.takeUpdates(frame * millisecond);
+        EXPECT_LE(updates.size(), 8u);
+        for (const auto& update : updates) {
+            EXPECT_TRUE(seen.insert(update.window).second);
+        }
+    }
+    EXPECT_EQ(seen.size(), 20u);
+}
+
+TEST_F(ThumbnailAtlasTest, ResizeKeepsOrMovesCell) {
+    ThumbnailAtlas atlas(2048, 256);
+    atlas.setWindow(1, 1920, 1080);
+    atlas.takeUpdates(0);
+    const ThumbnailAtlas::Rect before = atlas.getRect(1);
+
+    // A slightly different size fits the same cell and keeps the old content
+    atlas.setWindow(1, 1910, 1080);
+    EXPECT_EQ(atlas.getRect(1).x, before.x);
+    EXPECT_EQ(atlas.getRect(1).y, before.y);
+    EXPECT_TRUE(atlas.isReady(1));
+    EXPECT_EQ(atlas.getStats().pendingUpdates, 1u);
+
+    // A portrait window needs a new cell, drawn before its first use
+    atlas.setWindow(1, 600, 1200);
+    EXPECT_EQ(atlas.getRect(1).height, 256);
+    EXPECT_FALSE(atlas.isReady(1));
+}
+
+TEST_F(ThumbnailAtlasTest, ReusesFreedCells) {
+    ThumbnailAtlas atlas(1024, 256);
+    for (uint64_t window = 1; window <= 16; ++window) {
+        atlas.setWindow(window, 1280, 1280);
+    }
+    EXPECT_EQ(atlas.getStats().usedArea, 1024 * 1024);
+
+    const ThumbnailAtlas::Rect freed = atlas.getRect(6);
+    atlas.removeWindow(6);
+    atlas.setWindow(17, 1280, 1280);
+    EXPECT_EQ(atlas.getRect(17).x, freed.x);
+    EXPECT_EQ(atlas.getRect(17).y, freed.y);
+    EXPECT_EQ(atlas.getStats().repacks, 0u);
+
+    for (uint64_t window = 1; window <= 17; ++window) {
+        atlas.removeWindow(window);
+    }
+    EXPECT_EQ(atlas.getStats().usedArea, 0);
+    EXPECT_EQ(atlas.getStats().windows, 0u);
+}
+
+TEST_F(ThumbnailAtlasTest, ShrinksThumbnailsWhenFull) {
+    ThumbnailAtlas atlas(1024, 256);
+    for (uint64_t window = 1; window <= 150; ++window) {
+        atlas.setWindow(window, 1600 + static_cast<int>(window % 7) * 40, 900 + static_cast<int>(window % 5) * 60);
+    }
+
+    ThumbnailAtlas::Stats stats = atlas.getStats();
+    EXPECT_EQ(stats.windows, 150u);
+    EXPECT_LT(stats.thumbnailSize, 256);
+    EXPECT_GT(stats.repacks, 0u);
+    expectDisjoint(atlas, 150);
+
+    // Repacked thumbnails are drawn again
+    EXPECT_EQ(stats.pendingUpdates, 150u);
+
+    // With most windows gone, thumbnails grow back
+    for (uint64_t window = 11; window <= 150; ++window) {
+        atlas.removeWindow(window);
+    }
+    EXPECT_EQ(atlas.getStats().thumbnailSize, 256);
+    expectDisjoint(atlas, 150);
+}
+
+TEST_F(ThumbnailAtlasTest, ManyWindowsBenchmark) {
+    const int windows = 200;
+    const int frames = 600;
+
+    ThumbnailAtlas atlas;
+    for (int window = 1; window <= windows; ++window) {
+        atlas.setWindow(window, 800 + (window * 53) % 1100, 600 + (window * 31) % 500);
+    }
+    expectDisjoint(atlas, windows);
+
+    // Ten seconds of a 60 Hz overview with every client animating
+    size_t updates = 0;
+    size_t maxPerFrame = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        const int64_t now = frame * 16666666LL;
+        for (int window = 1; window <= windows; ++window) {
+            atlas.damageWindow(window);
+            if (frame % 60 == window % 60) {
+                atlas.setWindow(window, 800 + (window * 53 + frame) % 1100, 600 + (window * 31) % 500);
+            }
+        }
+        const size_t count = atlas.takeUpdates(now).size();
+        updates += count;
+        maxPerFrame = std::max(maxPerFrame, count);
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_LE(maxPerFrame, 8u);
+    expectDisjoint(atlas, windows);
+
+    RecordProperty("redraws", static_cast<int>(updates));
+    RecordProperty("redrawsWithoutAtlas", windows * frames);
+    RecordProperty("bookkeepingUsPerFrame", static_cast<int>(elapsed / frames));
+    RecordProperty("repacks", static_cast<int>(atlas.getStats().repacks));
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "compositor/rendering/WorkspaceSnapshots.h"
+
+using namespace VivoX::Compositor::Rendering;
+using namespace testing;
+
+namespace {
+    const int64_t millisecond = 1000000;
+    const int64_t second = 1000 * millisecond;
+}
+
+class WorkspaceSnapshotsTest : public Test {
+protected:
+    void SetUp() override {
+        m_snapshots.setSize(1920, 1080);
+        for (uint64_t workspace = 1; workspace <= 4; ++workspace) {
+            m_snapshots.addWorkspace(workspace);
+        }
+        m_snapshots.setActiveWorkspace(1);
+    }
+
+    WorkspaceSnapshots m_snapshots;
+};
+
+TEST_F(WorkspaceSnapshotsTest, ScalesTextures) {
+    EXPECT_EQ(m_snapshots.getTextureWidth(), 960);
+    EXPECT_EQ(m_snapshots.getTextureHeight(), 540);
+
+    WorkspaceSnapshots unsized;
+    unsized.addWorkspace(1);
+    EXPECT_EQ(unsized.getTextureWidth(), 0);
+    EXPECT_TRUE(unsized.takeRefreshes(0).empty());
+    EXPECT_EQ(unsized.nextRefreshTime(0), -1);
+}
+
+TEST_F(WorkspaceSnapshotsTest, DrawsMissingSnapshotsWithinBudget) {
+    m_snapshots.setRefreshBudget(2);
+
+    // The active workspace is on screen and not drawn
+    const std::vector<uint64_t> first = m_snapshots.takeRefreshes(0);
+    EXPECT_THAT(first, SizeIs(2));
+    EXPECT_THAT(first, Not(Contains(1u)));
+
+    const std::vector<uint64_t> second = m_snapshots.takeRefreshes(16 * millisecond);
+    ASSERT_THAT(second, SizeIs(1));
+    EXPECT_THAT(first, Not(Contains(second[0])));
+
+    EXPECT_TRUE(m_snapshots.takeRefreshes(32 * millisecond).empty());
+    EXPECT_FALSE(m_snapshots.isReady(1));
+    EXPECT_TRUE(m_snapshots.isReady(2));
+    EXPECT_EQ(m_snapshots.getStats().refreshesIssued, 3u);
+}
+
+TEST_F(WorkspaceSnapshotsTest, RefreshesDamagedWorkspacesAtLowRate) {
+    m_snapshots.setRefreshBudget(4);
+    m_snapshots.takeRefreshes(0);
+
+    m_snapshots.damageWorkspace(2);
+    m_snapshots.damageWorkspace(2);
+    EXPECT_EQ(m_snapshots.getStats().coalescedDamage, 1u);
+
+    // Damage on the active workspace waits until it is left
+    m_snapshots.damageWorkspace(1);
+
+    EXPECT_TRUE(m_snapshots.takeRefreshes(500 * millisecond).empty());
+    EXPECT_EQ(m_snapshots.nextRefreshTime(500 * millisecond), second);
+    EXPECT_THAT(m_snapshots.takeRefreshes(second), ElementsAre(2u));
+    EXPECT_EQ(m_snapshots.nextRefreshTime(second), -1);
+
+    // Undamaged snapshots stay as they are
+    EXPECT_TRUE(m_snapshots.takeRefreshes(10 * second).empty());
+}
+
+TEST_F(WorkspaceSnapshotsTest, CapturesWorkspaceWhenLeft) {
+    m_snapshots.setRefreshBudget(1);
+    m_snapshots.takeRefreshes(0);
+    m_snapshots.takeRefreshes(0);
+    m_snapshots.takeRefreshes(0);
+
+    // Workspace 3 is waiting for its low priority refresh
+    m_snapshots.damageWorkspace(3);
+    m_snapshots.damageWorkspace(1);
+    m_snapshots.setActiveWorkspace(2);
+    EXPECT_EQ(m_snapshots.getActiveWorkspace(), 2u);
+    EXPECT_EQ(m_snapshots.nextRefreshTime(100 * millisecond), 100 * millisecond);
+
+    // The workspace just left doesn't wait for the interval or the budget
+    EXPECT_THAT(m_snapshots.takeRefreshes(100 * millisecond), ElementsAre(1u));
+    EXPECT_TRUE(m_snapshots.takeRefreshes(200 * millisecond).empty());
+    EXPECT_THAT(m_snapshots.takeRefreshes(second), ElementsAre(3u));
+    EXPECT_EQ(m_snapshots.getStats().departureCaptures, 1u);
+
+    // An unchanged workspace is not captured again
+    m_snapshots.setActiveWorkspace(1);
+    EXPECT_TRUE(m_snapshots.takeRefreshes(2 * second).empty());
+}
+
+TEST_F(WorkspaceSnapshotsTest, RedrawsEverythingAfterResize) {
+    m_snapshots.setRefreshBudget(4);
+    m_snapshots.takeRefreshes(0);
+    EXPECT_TRUE(m_snapshots.isReady(4));
+
+    m_snapshots.setSize(2560, 1440);
+    EXPECT_FALSE(m_snapshots.isReady(4));
+    EXPECT_TRUE(m_snapshots.isStale(4));
+    EXPECT_THAT(m_snapshots.takeRefreshes(millisecond), UnorderedElementsAre(2u, 3u, 4u));
+}
+
+TEST_F(WorkspaceSnapshotsTest, ForgetsRemovedWorkspaces) {
+    m_snapshots.removeWorkspace(3);
+    m_snapshots.damageWorkspace(3);
+    EXPECT_FALSE(m_snapshots.hasWorkspace(3));
+    EXPECT_EQ(m_snapshots.getStats().workspaces, 3u);
+
+    m_snapshots.removeWorkspace(1);
+    EXPECT_EQ(m_snapshots.getActiveWorkspace(), 0u);
+
+    m_snapshots.setRefreshBudget(4);
+    EXPECT_THAT(m_snapshots.takeRefreshes(0), UnorderedElementsAre(2u, 4u));
+}
@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/applications/ApplicationSearchIndex.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace VivoX::System;
+using namespace testing;
+
+class ApplicationSearchIndexTest : public Test {
+protected:
+    static ApplicationSearchIndex::Document document(const QString &id, const QString &name,
+                                                     const QString &genericName = QString(),
+                                                     const QStringList &keywords = QStringList()) {
+        ApplicationSearchIndex::Document document;
+        document.id = id;
+        document.name = name;
+        document.untranslatedName = name;
+        document.genericName = genericName;
+        document.keywords = keywords;
+        document.executable = id;
+        return document;
+    }
+
+    static QStringList ids(const QList<ApplicationSearchIndex::Result> &results) {
+        QStringList ids;
+        for (const ApplicationSearchIndex::Result &result : results) {
+            ids.append(result.id);
+        }
+        return ids;
+    }
+
+    // Synthetic applications with names made of common words
+    static void populate(ApplicationSearchIndex &index, int count) {
+        static const QStringList words = {
+            "office", "writer", "calc", "impress", "draw", "photo", "image", "viewer", "editor",
+            "text", "code", "studio", "music", "player", "video", "audio", "recorder", "mail",
+            "chat", "web", "browser", "file", "manager", "terminal", "system", "monitor",
+            "settings", "disk", "usage", "backup", "sync", "cloud", "game", "chess", "puzzle",
+            "map", "weather", "clock", "calendar", "notes", "paint", "scanner", "printer",
+            "network", "remote", "desktop", "font", "color", "archive", "torrent"
+        };
+        std::mt19937 random(42);
+        std::uniform_int_distribution<int> pick(0, words.size() - 1);
+        for (int i = 0; i < count; ++i) {
+            const QString name = QString("%1 %2 %3").arg(words[pick(random)], words[pick(random)]).arg(i);
+            index.insert(document(QString("app%1").arg(i), name, words[pick(random)] + " tool",
+                                  { words[pick(random)], words[pick(random)] }));
+        }
+    }
+};
+
+TEST_F(ApplicationSearchIndexTest, RanksByMatchQuality) {
+    ApplicationSearchIndex index;
+    index.insert(document("firefox", "Firefox", "Web Browser", { "internet", "www" }));
+    index.insert(document("files", "Files", "File Manager", { "folder" }));
+    index.insert(document("thunderbird", "Thunderbird", "Mail Client", { "email" }));
+
+    // Exact and shorter prefixes rank first
+    EXPECT_EQ(ids(index.search("fi")), QStringList({ "files", "firefox" }));
+    EXPECT_EQ(ids(index.search("firefox")), QStringList { "firefox" });
+
+    // Generic names and keywords match as well
+    EXPECT_EQ(ids(index.search("web")), QStringList { "firefox" });
+    EXPECT_EQ(ids(index.search("email")), QStringList { "thunderbird" });
+
+    // Longer tokens match inside words and as subsequences
+    EXPECT_EQ(ids(index.search("bird")), QStringList { "thunderbird" });
+    EXPECT_EQ(ids(index.search("thndrbrd")), QStringList { "thunderbird" });
+
+    // Every query token has to match
+    EXPECT_EQ(ids(index.search("file manager")), QStringList { "files" });
+    EXPECT_TRUE(index.search("file mail").isEmpty());
+}
+
+TEST_F(ApplicationSearchIndexTest, MatchesLocalizedAndUntranslatedNames) {
+    ApplicationSearchIndex index;
+    ApplicationSearchIndex::Document browser = document("browser", "Navigateur Web");
+    browser.untranslatedName = "Web Browser";
+    index.insert(browser);
+
+    EXPECT_EQ(ids(index.search("navig")), QStringList { "browser" });
+    EXPECT_EQ(ids(index.search("browser")), QStringList { "browser" });
+}
+
+TEST_F(ApplicationSearchIndexTest, NormalizesQueries) {
+    ApplicationSearchIndex index;
+    index.insert(document("cafe", "Café Übersicht"));
+    index.insert(document("ide", "C++ IDE"));
+
+    EXPECT_EQ(ApplicationSearchIndex::tokenize("Café Übersicht"), QStringList({ "cafe", "ubersicht" }));
+    EXPECT_EQ(ids(index.search("CAFE")), QStringList { "cafe" });
+    EXPECT_EQ(ids(index.search("uber")), QStringList { "cafe" });
+
+    // Characters that would break a regular expression are separators
+    EXPECT_EQ(ids(index.search("c++ (ide")), QStringList { "ide" });
+    EXPECT_TRUE(index.search("[*").isEmpty());
+    EXPECT_TRUE(index.search("").isEmpty());
+}
+
+TEST_F(ApplicationSearchIndexTest, BlendsUsageIntoRanking) {
+    ApplicationSearchIndex index;
+    index.insert(document("alpha", "Terminal Alpha"));
+    index.insert(document("beta", "Terminal Beta"));
+
+    EXPECT_EQ(ids(index.search("term")), QStringList({ "alpha", "beta" }));
+
+    index.setUsageScore("beta", 1.0);
+    EXPECT_EQ(ids(index.search("term")), QStringList({ "beta", "alpha" }));
+
+    // Usage only ranks matches, it never adds any
+    EXPECT_EQ(ids(index.search("alpha")), QStringList { "alpha" });
+
+    // Replacing an application keeps its usage
+    index.insert(document("beta", "Terminal Beta"));
+    EXPECT_EQ(ids(index.search("term")).first(), "beta");
+}
+
+TEST_F(ApplicationSearchIndexTest, UpdatesIncrementally) {
+    ApplicationSearchIndex index;
+    index.insert(document("editor", "Text Editor"));
+    EXPECT_EQ(ids(index.search("edit")), QStringList { "editor" });
+
+    index.insert(document("editor", "Notepad"));
+    EXPECT_TRUE(index.search("edit").isEmpty());
+    EXPECT_EQ(ids(index.search("note")), QStringList { "editor" });
+
+    index.remove("editor");
+    EXPECT_TRUE(index.search("note").isEmpty());
+    EXPECT_EQ(index.size(), 0);
+
+    // Freed slots are reused
+    index.insert(document("viewer", "Image Viewer"));
+    EXPECT_EQ(ids(index.search("im")), QStringList { "viewer" });
+}
+
+TEST_F(ApplicationSearchIndexTest, NarrowingMatchesFreshSearch) {
+    ApplicationSearchIndex typing;
+    ApplicationSearchIndex fresh;
+    populate(typing, 2000);
+    populate(fresh, 2000);
+
+    for (const QString &query : { QString("office writer"), QString("mus pl"), QString("ofice"),
+                                  QString("web browser 12") }) {
+        for (int length = 1; length <= query.size(); ++length) {
+            const QString prefix = query.left(length);
+
+            // An empty query drops the narrowing state
+            fresh.search(QString());
+            EXPECT_EQ(ids(typing.search(prefix)), ids(fresh.search(prefix))) << prefix.toStdString();
+        }
+    }
+}
+
+TEST_F(ApplicationSearchIndexTest, KeystrokeLatencyOnLargeIndex) {
+    const int count = 10000;
+    ApplicationSearchIndex index;
+
+    QElapsedTimer timer;
+    timer.start();
+    populate(index, count);
+    const qint64 buildTime = timer.elapsed();
+    ASSERT_EQ(index.size(), count);
+
+    std::vector<qint64> latencies;
+    for (const QString &query : { QString("office writer"), QString("terminal"), QString("vdeo plyr"),
+                                  QString("chess game 99"), QString("cloud sync backup") }) {
+        for (int length = 1; length <= query.size(); ++length) {
+            timer.restart();
+            const QList<ApplicationSearchIndex::Result> results = index.search(query.left(length), 50);
+            latencies.push_back(timer.nsecsElapsed());
+            EXPECT_LE(results.size(), 50);
+        }
+        index.search(QString());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    const qint64 p50 = latencies[latencies.size() / 2];
+    const qint64 p99 = latencies[(latencies.size() * 99) / 100];
+
+    RecordProperty("applications", count);
+    RecordProperty("buildMs", static_cast<int>(buildTime));
+    RecordProperty("keystrokeP50Us", static_cast<int>(p50 / 1000));
+    RecordProperty("keystrokeP99Us", static_cast<int>(p99 / 1000));
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/applications/DesktopEntryIndex.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <memory>
+
+using namespace VivoX::System;
+using namespace VivoX::Testing;
+using namespace testing;
+
+class DesktopEntryIndexTest : public QtTest {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_root.isValid());
+        m_home = m_root.filePath("home/applications");
+        m_system = m_root.filePath("system/applications");
+        QDir().mkpath(m_home);
+        QDir().mkpath(m_system);
+    }
+
+    std::unique_ptr<DesktopEntryIndex> createIndex() {
+        return std::make_unique<DesktopEntryIndex>(QStringList { m_home, m_system },
+                                                   m_root.filePath("cache/desktop-entries.cache"));
+    }
+
+    static void writeEntry(const QString &path, const QString &name, const QString &extra = QString()) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(QStringLiteral("[Desktop Entry]\nType=Application\nName=%1\nExec=%2 %U\n%3")
+                       .arg(name, name.toLower(), extra).toUtf8());
+    }
+
+    static void setModified(const QString &path, qint64 secondsAgo) {
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::ReadWrite));
+        file.setFileTime(QDateTime::currentDateTime().addSecs(-secondsAgo), QFileDevice::FileModificationTime);
+    }
+
+    QTemporaryDir m_root;
+    QString m_home;
+    QString m_system;
+};
+
+TEST_F(DesktopEntryIndexTest, ParsesDesktopEntryGroup) {
+    const QString path = m_system + "/editor.desktop";
+    writeEntry(path, "Editor",
+               "Comment=Edit\\stext\nCategories=Utility;TextEditor;\nKeywords=text;notes\\;memo;\n"
+               "Terminal=true\n[Desktop Action New]\nName=Overridden\n");
+
+    DesktopEntry entry;
+    ASSERT_TRUE(DesktopEntryIndex::parse(path, entry));
+    EXPECT_EQ(entry.name, "Editor");
+    EXPECT_EQ(entry.untranslatedName, "Editor");
+    EXPECT_EQ(entry.comment, "Edit text");
+    EXPECT_EQ(entry.exec, "editor %U");
+    EXPECT_EQ(entry.categories, QStringList({ "Utility", "TextEditor" }));
+    EXPECT_EQ(entry.keywords, QStringList({ "text", "notes;memo" }));
+    EXPECT_TRUE(entry.terminal);
+    EXPECT_TRUE(entry.isVisibleApplication());
+}
+
+TEST_F(DesktopEntryIndexTest, HidesEntriesWithoutTryExec) {
+    const QString binary = m_root.filePath("viewer");
+    {
+        QFile file(binary);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("#!/bin/sh\n");
+    }
+    QFile::setPermissions(binary, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    writeEntry(m_system + "/viewer.desktop", "Viewer", "TryExec=" + binary + "\n");
+    DesktopEntry viewer;
+    ASSERT_TRUE(DesktopEntryIndex::parse(m_system + "/viewer.desktop", viewer));
+    EXPECT_EQ(viewer.tryExec, binary);
+    EXPECT_TRUE(viewer.isVisibleApplication());
+
+    // Uninstalled, or not in PATH
+    writeEntry(m_system + "/gone.desktop", "Gone", "TryExec=" + m_root.filePath("gone") + "\n");
+    DesktopEntry gone;
+    ASSERT_TRUE(DesktopEntryIndex::parse(m_system + "/gone.desktop", gone));
+    EXPECT_FALSE(gone.isVisibleApplication());
+
+    writeEntry(m_system + "/missing.desktop", "Missing", "TryExec=vivox-no-such-binary\n");
+    DesktopEntry missing;
+    ASSERT_TRUE(DesktopEntryIndex::parse(m_system + "/missing.desktop", missing));
+    EXPECT_FALSE(missing.hasTryExec());
+    EXPECT_FALSE(missing.isVisibleApplication());
+}
+
+TEST_F(DesktopEntryIndexTest, FollowsXdgPrecedence) {
+    writeEntry(m_system + "/browser.desktop", "System Browser");
+    writeEntry(m_home + "/browser.desktop", "User Browser");
+    writeEntry(m_system + "/game.desktop", "Game");
+    writeEntry(m_home + "/game.desktop", "Game", "Hidden=true\n");
+    writeEntry(m_system + "/kde/settings.desktop", "Settings");
+
+    auto index = createIndex();
+    ASSERT_TRUE(index->load());
+
+    // The user directory overrides the system one
+    EXPECT_EQ(index->entry("browser").name, "User Browser");
+
+    // Hidden=true masks the ID entirely
+    EXPECT_FALSE(index->contains("game"));
+
+    // Subdirectories become part of the ID
+    EXPECT_TRUE(index->contains("kde-settings"));
+    EXPECT_EQ(index->entries().size(), 2);
+}
+
+TEST_F(DesktopEntryIndexTest, ParsesOnlyChangedFilesWithCache) {
+    for (int i = 0; i < 20; ++i) {
+        writeEntry(QString("%1/app%2.desktop").arg(m_system).arg(i), QString("App %1").arg(i));
+        setModified(QString("%1/app%2.desktop").arg(m_system).arg(i), 60);
+    }
+
+    auto cold = createIndex();
+    ASSERT_TRUE(cold->load());
+    EXPECT_EQ(cold->parsedCount(), 20);
+    cold.reset();
+
+    auto warm = createIndex();
+    ASSERT_TRUE(warm->load());
+    EXPECT_EQ(warm->parsedCount(), 0);
+    EXPECT_EQ(warm->entry("app7").name, "App 7");
+    warm.reset();
+
+    writeEntry(m_system + "/app7.desktop", "Renamed");
+    QFile::remove(m_system + "/app8.desktop");
+
+    auto updated = createIndex();
+    ASSERT_TRUE(updated->load());
+    EXPECT_EQ(updated->parsedCount(), 1);
+    EXPECT_EQ(updated->entry("app7").name, "Renamed");
+    EXPECT_FALSE(updated->contains("app8"));
+}
+
+TEST_F(DesktopEntryIndexTest, RefreshesFromInotify) {
+    writeEntry(m_system + "/viewer.desktop", "Viewer");
+
+    auto index = createIndex();
+    ASSERT_TRUE(index->load());
+    QSignalSpy changed(index.get(), &DesktopEntryIndex::entriesChanged);
+
+    // An override in the user directory replaces the system entry
+    writeEntry(m_home + "/viewer.desktop", "My Viewer");
+    ASSERT_TRUE(waitFor([&changed]() { return changed.count() > 0; }));
+    EXPECT_EQ(changed.takeFirst().first().toStringList(), QStringList { "viewer" });
+    EXPECT_EQ(index->entry("viewer").name, "My Viewer");
+    EXPECT_EQ(index->parsedCount(), 1);
+
+    // Removing it falls back to the system entry
+    QFile::remove(m_home + "/viewer.desktop");
+    ASSERT_TRUE(waitFor([&changed]() { return changed.count() > 0; }));
+    EXPECT_EQ(index->entry("viewer").name, "Viewer");
+
+    // New subdirectories are picked up with their contents
+    writeEntry(m_system + "/wine/program.desktop", "Program");
+    ASSERT_TRUE(waitFor([&index]() { return index->contains("wine-program"); }));
+}
+
+TEST_F(DesktopEntryIndexTest, LoadsLargeTreeFromCache) {
+    const int count = 10000;
+    for (int i = 0; i < count; ++i) {
+        writeEntry(QString("%1/bench%2.desktop").arg(i % 2 ? m_home : m_system).arg(i),
+                   QString("Bench %1").arg(i), "Categories=Game;\nKeywords=bench;synthetic;\n");
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    auto cold = createIndex();
+    ASSERT_TRUE(cold->load());
+    const qint64 coldTime = timer.elapsed();
+    EXPECT_EQ(cold->entries().size(), count);
+    cold.reset();
+
+    timer.restart();
+    auto warm = createIndex();
+    ASSERT_TRUE(warm->load());
+    const qint64 warmTime = timer.elapsed();
+    EXPECT_EQ(warm->parsedCount(), 0);
+    EXPECT_EQ(warm->entries().size(), count);
+
+    RecordProperty("entries", count);
+    RecordProperty("coldLoadMs", static_cast<int>(coldTime));
+    RecordProperty("cachedLoadMs", static_cast<int>(warmTime));
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/applications/FrecencyStore.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace VivoX::System;
+using namespace testing;
+
+class FrecencyStoreTest : public Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+        m_path = m_dir.filePath("usage/application-usage.log");
+        m_now = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    static qint64 days(double count) {
+        return qint64(count * 24 * 60 * 60 * 1000);
+    }
+
+    QTemporaryDir m_dir;
+    QString m_path;
+    qint64 m_now = 0;
+};
+
+TEST_F(FrecencyStoreTest, DecaysWithHalfLife) {
+    FrecencyStore store(m_path, 14.0);
+    store.recordUse("editor", m_now);
+    store.recordUse("editor", m_now);
+
+    EXPECT_NEAR(store.score("editor", m_now), 2.0, 1e-9);
+    EXPECT_NEAR(store.score("editor", m_now + days(14)), 1.0, 1e-9);
+    EXPECT_NEAR(store.score("editor", m_now + days(28)), 0.5, 1e-9);
+    EXPECT_EQ(store.score("unknown", m_now), 0.0);
+    EXPECT_EQ(store.lastUsed("editor"), m_now);
+}
+
+TEST_F(FrecencyStoreTest, RanksByFrecencyAndRecency) {
+    FrecencyStore store(m_path, 14.0);
+    for (int i = 0; i < 10; ++i) {
+        store.recordUse("old-favourite", m_now - days(60) + i);
+    }
+    for (int i = 0; i < 3; ++i) {
+        store.recordUse("current", m_now - days(1) + i);
+    }
+    store.recordUse("once", m_now);
+
+    // Ten uses two months ago count for less than three yesterday
+    EXPECT_EQ(store.topFrecent(3), QStringList({ "current", "once", "old-favourite" }));
+    EXPECT_EQ(store.mostRecent(2), QStringList({ "once", "current" }));
+    EXPECT_EQ(store.topFrecent(1), QStringList { "current" });
+
+    // Rejected entries are skipped without shortening the result
+    auto notCurrent = [](const QString &id) { return id != "current"; };
+    EXPECT_EQ(store.topFrecent(2, notCurrent), QStringList({ "once", "old-favourite" }));
+
+    // Relative scores put the top application at 1
+    EXPECT_DOUBLE_EQ(store.relativeScore("current"), 1.0);
+    EXPECT_LT(store.relativeScore("old-favourite"), store.relativeScore("once"));
+    EXPECT_EQ(store.relativeScore("unknown"), 0.0);
+}
+
+TEST_F(FrecencyStoreTest, AppendsAndReloads) {
+    {
+        FrecencyStore store(m_path);
+        store.recordUse("browser", m_now - days(2));
+        store.recordUse("terminal", m_now - days(1));
+        store.recordUse("browser", m_now);
+        store.seed("mail", 5, m_now - days(3));
+        EXPECT_EQ(store.logSize(), 4);
+    }
+
+    FrecencyStore store(m_path);
+    ASSERT_TRUE(store.load());
+    EXPECT_EQ(store.logSize(), 4);
+    EXPECT_EQ(store.topFrecent(3), QStringList({ "mail", "browser", "terminal" }));
+    EXPECT_EQ(store.mostRecent(1), QStringList { "browser" });
+    EXPECT_NEAR(store.score("mail", m_now - days(3)), 5.0, 1e-9);
+}
+
+TEST_F(FrecencyStoreTest, CompactsLog) {
+    FrecencyStore store(m_path);
+    for (int i = 0; i < 200; ++i) {
+        store.recordUse(QString("app%1").arg(i % 4), m_now - i);
+    }
+
+    // Compaction keeps the log below twice the number of applications plus the minimum
+    EXPECT_LT(store.logSize(), 64);
+    const QStringList ranking = store.topFrecent(4);
+
+    // Applications not used for months are dropped
+    store.recordUse("ancient", m_now - days(365));
+    store.compact();
+    EXPECT_EQ(store.logSize(), 4);
+
+    FrecencyStore reloaded(m_path);
+    ASSERT_TRUE(reloaded.load());
+    EXPECT_EQ(reloaded.topFrecent(10), ranking);
+    EXPECT_NEAR(reloaded.score("app0", m_now), store.score("app0", m_now), 1e-9);
+}
+
+TEST_F(FrecencyStoreTest, RecoversFromTornRecord) {
+    {
+        FrecencyStore store(m_path);
+        store.recordUse("viewer", m_now);
+    }
+
+    // A crash in the middle of an append leaves a partial line
+    {
+        QFile file(m_path);
+        ASSERT_TRUE(file.open(QIODevice::Append));
+        file.write("L\t17");
+    }
+
+    {
+        FrecencyStore store(m_path);
+        ASSERT_TRUE(store.load());
+        EXPECT_EQ(store.topFrecent(10), QStringList { "viewer" });
+        store.recordUse("player", m_now + 1);
+    }
+
+    FrecencyStore store(m_path);
+    ASSERT_TRUE(store.load());
+    EXPECT_EQ(store.mostRecent(10), QStringList({ "player", "viewer" }));
+}
+
+TEST_F(FrecencyStoreTest, MovesUnknownFormatAside) {
+    {
+        QFile file(m_path);
+        ASSERT_TRUE(QDir().mkpath(m_dir.filePath("usage")));
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write("VXFR 2\nL\t17\tviewer\n");
+    }
+
+    {
+        FrecencyStore store(m_path);
+        ASSERT_TRUE(store.load());
+        EXPECT_TRUE(store.isEmpty());
+        store.recordUse("player", m_now);
+    }
+    EXPECT_TRUE(QFile::exists(m_path + ".old"));
+
+    // The new records make a log of their own
+    FrecencyStore store(m_path);
+    ASSERT_TRUE(store.load());
+    EXPECT_EQ(store.mostRecent(10), QStringList { "player" });
+}
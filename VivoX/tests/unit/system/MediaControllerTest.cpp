@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/media/MediaController.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QProcess>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QThread>
+#include <memory>
+
+using namespace VivoX::System;
+using namespace VivoX::Testing;
+using namespace testing;
+
+// Minimal MPRIS player exported on the test bus
+class StubPlayer : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.mpris.MediaPlayer2.Player")
+    Q_PROPERTY(QString PlaybackStatus READ playbackStatus)
+    Q_PROPERTY(QVariantMap Metadata READ metadata)
+    Q_PROPERTY(qlonglong Position READ position)
+    Q_PROPERTY(double Rate READ rate)
+    Q_PROPERTY(double Volume READ volume WRITE setVolume)
+    Q_PROPERTY(bool CanPlay READ canControl)
+    Q_PROPERTY(bool CanPause READ canControl)
+    Q_PROPERTY(bool CanSeek READ canControl)
+
+public:
+    QString playbackStatus() const { return m_playing ? "Playing" : "Paused"; }
+    QVariantMap metadata() const {
+        return {
+            { "mpris:trackid", QVariant::fromValue(QDBusObjectPath("/track/1")) },
+            { "xesam:title", "First Track" },
+            { "mpris:length", qlonglong(300000000) },
+        };
+    }
+    qlonglong position() const { return m_position; }
+    double rate() const { return 1.0; }
+    double volume() const { return m_volume; }
+    void setVolume(double volume) { m_volume = volume; }
+    bool canControl() const { return true; }
+
+    void setPlaying(QDBusConnection &connection, bool playing) {
+        m_playing = playing;
+        emitChanged(connection, { { "PlaybackStatus", playbackStatus() } });
+    }
+
+    void emitChanged(QDBusConnection &connection, const QVariantMap &changed) {
+        QDBusMessage signal = QDBusMessage::createSignal("/org/mpris/MediaPlayer2",
+                                                         "org.freedesktop.DBus.Properties",
+                                                         "PropertiesChanged");
+        signal << QString("org.mpris.MediaPlayer2.Player") << changed << QStringList();
+        connection.send(signal);
+    }
+
+    int playCalls = 0;
+    qlonglong seekTarget = -1;
+    qlonglong m_position = 5000000;
+
+public slots:
+    void Play() { ++playCalls; }
+    void SetPosition(const QDBusObjectPath &, qlonglong position) { seekTarget = position; }
+
+private:
+    bool m_playing = false;
+    double m_volume = 0.5;
+};
+
+class MediaControllerTest : public QtTest {
+protected:
+    void SetUp() override {
+        // Run against a private bus so the host session is left alone
+        const QString daemon = QStandardPaths::findExecutable("dbus-daemon");
+        if (daemon.isEmpty()) {
+            GTEST_SKIP() << "dbus-daemon not available";
+        }
+
+        m_daemon = std::make_unique<QProcess>();
+        m_daemon->start(daemon, { "--session", "--nofork", "--print-address" });
+        ASSERT_TRUE(m_daemon->waitForReadyRead(5000));
+        m_address = QString::fromUtf8(m_daemon->readLine()).trimmed();
+
+        m_playerBus = std::make_unique<QDBusConnection>(QDBusConnection::connectToBus(m_address, "player"));
+        ASSERT_TRUE(m_playerBus->isConnected());
+
+        m_controller = std::make_unique<MediaController>(QDBusConnection::connectToBus(m_address, "controller"));
+        ASSERT_TRUE(m_controller->initialize());
+    }
+
+    void TearDown() override {
+        m_controller.reset();
+        m_playerBus.reset();
+        QDBusConnection::disconnectFromBus("controller");
+        QDBusConnection::disconnectFromBus("player");
+        if (m_daemon) {
+            m_daemon->kill();
+            m_daemon->waitForFinished();
+        }
+    }
+
+    void registerPlayer() {
+        ASSERT_TRUE(m_playerBus->registerObject("/org/mpris/MediaPlayer2", &m_player,
+                                                QDBusConnection::ExportAllSlots | QDBusConnection::ExportAllProperties));
+        ASSERT_TRUE(m_playerBus->registerService(m_service));
+        ASSERT_TRUE(waitFor([this]() {
+            return m_controller->getMediaInfo(m_service).title == "First Track";
+        }));
+    }
+
+    const QString m_service = "org.mpris.MediaPlayer2.teststub";
+    std::unique_ptr<QProcess> m_daemon;
+    QString m_address;
+    std::unique_ptr<QDBusConnection> m_playerBus;
+    std::unique_ptr<MediaController> m_controller;
+    StubPlayer m_player;
+};
+
+TEST_F(MediaControllerTest, DiscoversPlayerFromOwnerChange) {
+    QSignalSpy added(m_controller.get(), &MediaController::playerAdded);
+    registerPlayer();
+
+    EXPECT_EQ(added.count(), 1);
+    EXPECT_EQ(m_controller->getAvailablePlayers(), QStringList { m_service });
+
+    MediaInfo info = m_controller->getMediaInfo(m_service);
+    EXPECT_EQ(info.trackId, "/track/1");
+    EXPECT_EQ(info.length, 300000000);
+    EXPECT_DOUBLE_EQ(info.volume, 0.5);
+    EXPECT_TRUE(info.canSeek);
+}
+
+TEST_F(MediaControllerTest, FollowsPropertiesChangedSignals) {
+    registerPlayer();
+    QSignalSpy changed(m_controller.get(), &MediaController::mediaInfoChanged);
+
+    m_player.setPlaying(*m_playerBus, true);
+    ASSERT_TRUE(waitFor([this]() { return m_controller->getMediaInfo(m_service).isPlaying; }));
+
+    m_player.emitChanged(*m_playerBus, { { "Volume", 0.25 } });
+    ASSERT_TRUE(waitFor([this]() { return m_controller->getMediaInfo(m_service).volume == 0.25; }));
+    EXPECT_GE(changed.count(), 2);
+}
+
+TEST_F(MediaControllerTest, InterpolatesPositionWhilePlaying) {
+    registerPlayer();
+    EXPECT_EQ(m_controller->getPosition(m_service), 5000000);
+
+    m_player.setPlaying(*m_playerBus, true);
+    ASSERT_TRUE(waitFor([this]() { return m_controller->getMediaInfo(m_service).isPlaying; }));
+
+    // The position advances locally without asking the player
+    const qint64 before = m_controller->getPosition(m_service);
+    QThread::msleep(50);
+    EXPECT_GE(m_controller->getPosition(m_service) - before, 40000);
+
+    m_player.setPlaying(*m_playerBus, false);
+    ASSERT_TRUE(waitFor([this]() { return !m_controller->getMediaInfo(m_service).isPlaying; }));
+    const qint64 paused = m_controller->getPosition(m_service);
+    QThread::msleep(20);
+    EXPECT_EQ(m_controller->getPosition(m_service), paused);
+}
+
+TEST_F(MediaControllerTest, SendsControlsAsynchronously) {
+    registerPlayer();
+
+    EXPECT_TRUE(m_controller->play(m_service));
+    EXPECT_TRUE(m_controller->seek(42000000, m_service));
+    EXPECT_TRUE(m_controller->setVolume(2.0, m_service));
+
+    EXPECT_TRUE(waitFor([this]() { return m_player.playCalls == 1; }));
+    EXPECT_TRUE(waitFor([this]() { return m_player.seekTarget == 42000000; }));
+    EXPECT_TRUE(waitFor([this]() { return m_player.volume() == 1.0; }));
+}
+
+TEST_F(MediaControllerTest, RemovesPlayerWhenNameVanishes) {
+    registerPlayer();
+    QSignalSpy removed(m_controller.get(), &MediaController::playerRemoved);
+
+    m_playerBus->unregisterService(m_service);
+
+    ASSERT_TRUE(waitFor([&removed]() { return removed.count() == 1; }));
+    EXPECT_TRUE(m_controller->getAvailablePlayers().isEmpty());
+    EXPECT_FALSE(m_controller->play());
+}
+
+#include "MediaControllerTest.moc"
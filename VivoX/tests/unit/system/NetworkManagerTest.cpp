@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/network/NetlinkMonitor.h"
+#include "system/network/NetworkManager.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QProcess>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <memory>
+
+#include <sched.h>
+
+using namespace VivoX::System;
+using namespace VivoX::Testing;
+using namespace testing;
+
+class NetworkManagerTest : public QtTest {
+protected:
+    static void SetUpTestSuite() {
+        QtTest::SetUpTestSuite();
+
+        // Work in a private network namespace so the host is left alone
+        s_isolated = !QStandardPaths::findExecutable("ip").isEmpty() && unshare(CLONE_NEWNET) == 0;
+    }
+
+    void SetUp() override {
+        if (!s_isolated) {
+            GTEST_SKIP() << "Network namespaces not available";
+        }
+    }
+
+    void TearDown() override {
+        if (s_isolated) {
+            QProcess::execute("ip", { "link", "del", "veth0" });
+            QProcess::execute("ip", { "link", "del", "dummy0" });
+        }
+    }
+
+    static void ip(const QStringList &arguments) {
+        ASSERT_EQ(QProcess::execute("ip", arguments), 0) << arguments.join(' ').toStdString();
+    }
+
+    static bool s_isolated;
+};
+
+bool NetworkManagerTest::s_isolated = false;
+
+TEST_F(NetworkManagerTest, DumpsExistingLinks) {
+    ip({ "link", "add", "veth0", "type", "veth", "peer", "name", "veth1" });
+
+    NetworkManager manager;
+    QSignalSpy added(&manager, &NetworkManager::networkAdded);
+    ASSERT_TRUE(manager.initialize());
+
+    // Loopback is not a network
+    ASSERT_TRUE(waitFor([&added]() { return added.count() == 2; }));
+    EXPECT_EQ(manager.getNetworkInfo("veth0").type, "ethernet");
+    EXPECT_EQ(manager.getNetworkInfo("veth0").state, "disconnected");
+    EXPECT_TRUE(manager.getNetworkInfo("lo").id.isEmpty());
+}
+
+TEST_F(NetworkManagerTest, FollowsLinkAddressAndRouteEvents) {
+    NetworkManager manager;
+    ASSERT_TRUE(manager.initialize());
+    QSignalSpy added(&manager, &NetworkManager::networkAdded);
+    QSignalSpy removed(&manager, &NetworkManager::networkRemoved);
+
+    ip({ "link", "add", "veth0", "type", "veth", "peer", "name", "veth1" });
+    ASSERT_TRUE(waitFor([&added]() { return added.count() == 2; }));
+
+    ip({ "link", "set", "veth1", "up" });
+    ip({ "link", "set", "veth0", "up" });
+    ip({ "addr", "add", "10.1.0.1/24", "dev", "veth0" });
+    ip({ "route", "add", "default", "via", "10.1.0.2", "dev", "veth0" });
+
+    ASSERT_TRUE(waitFor([&manager]() { return manager.getNetworkInfo("veth0").isDefault; }));
+    NetworkInfo info = manager.getNetworkInfo("veth0");
+    EXPECT_EQ(info.state, "connected");
+    EXPECT_TRUE(info.details["addresses"].toStringList().contains("10.1.0.1"));
+    EXPECT_EQ(manager.getActiveNetworks().size(), 1);
+    EXPECT_TRUE(manager.isNetworkingEnabled());
+
+    // Taking the link down drops its routes without a route event
+    ip({ "link", "set", "veth0", "down" });
+    ASSERT_TRUE(waitFor([&manager]() { return manager.getNetworkInfo("veth0").state == "disconnected"; }));
+    EXPECT_FALSE(manager.getNetworkInfo("veth0").isDefault);
+
+    ip({ "link", "del", "veth0" });
+    ASSERT_TRUE(waitFor([&removed]() { return removed.count() == 2; }));
+    EXPECT_TRUE(manager.getAllNetworks().isEmpty());
+}
+
+TEST_F(NetworkManagerTest, FollowsDummyLinks) {
+    NetworkManager manager;
+    ASSERT_TRUE(manager.initialize());
+    QSignalSpy added(&manager, &NetworkManager::networkAdded);
+    QSignalSpy removed(&manager, &NetworkManager::networkRemoved);
+
+    ip({ "link", "add", "dummy0", "type", "dummy" });
+    ASSERT_TRUE(waitFor([&added]() { return added.count() == 1; }));
+    EXPECT_EQ(manager.getNetworkInfo("dummy0").type, "other");
+    EXPECT_EQ(manager.getNetworkInfo("dummy0").details["kind"].toString(), "dummy");
+
+    // Dummy links have no carrier to wait for
+    ip({ "link", "set", "dummy0", "up" });
+    ip({ "addr", "add", "10.2.0.1/24", "dev", "dummy0" });
+    ASSERT_TRUE(waitFor([&manager]() { return manager.getNetworkInfo("dummy0").state == "connected"; }));
+    EXPECT_TRUE(manager.getNetworkInfo("dummy0").details["addresses"].toStringList().contains("10.2.0.1"));
+
+    ip({ "addr", "del", "10.2.0.1/24", "dev", "dummy0" });
+    ASSERT_TRUE(waitFor([&manager]() { return manager.getNetworkInfo("dummy0").state == "disconnected"; }));
+
+    ip({ "link", "del", "dummy0" });
+    ASSERT_TRUE(waitFor([&removed]() { return removed.count() == 1; }));
+    EXPECT_TRUE(manager.getAllNetworks().isEmpty());
+}
+
+TEST_F(NetworkManagerTest, ReportsOnlyDeltas) {
+    ip({ "link", "add", "veth0", "type", "veth", "peer", "name", "veth1" });
+
+    NetlinkMonitor monitor;
+    QSignalSpy changed(&monitor, &NetlinkMonitor::linkChanged);
+    ASSERT_TRUE(monitor.start());
+    ASSERT_TRUE(waitFor([&monitor]() { return monitor.isSynchronized(); }));
+
+    // An idle system produces no events and nothing is polled
+    waitFor([]() { return false; }, 500);
+    EXPECT_EQ(changed.count(), 0);
+
+    // Changing the MTU of one link reports exactly that link
+    ip({ "link", "set", "veth0", "mtu", "1400" });
+    ASSERT_TRUE(waitFor([&changed]() { return changed.count() > 0; }));
+    waitFor([]() { return false; }, 200);
+
+    for (const QList<QVariant> &arguments : changed) {
+        EXPECT_EQ(arguments.first().value<LinkState>().name, "veth0");
+    }
+    EXPECT_EQ(changed.last().first().value<LinkState>().mtu, 1400);
+}
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/notifications/NotificationManager.h"
+#include "system/notifications/TimingWheel.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QSignalSpy>
+
+using namespace VivoX::System;
+using namespace VivoX::Testing;
+using namespace testing;
+
+class NotificationManagerTest : public QtTest {
+protected:
+    static uint notify(NotificationManager &manager, const QString &appName, const QString &summary,
+                       uint replacesId = 0, int timeout = 0, const QVariantMap &hints = QVariantMap()) {
+        return manager.createNotification(appName, replacesId, QString(), summary, QString(), QStringList(),
+                                          hints, timeout);
+    }
+
+};
+
+TEST(TimingWheelTest, ExpiresInDeadlineOrder) {
+    TimingWheel wheel(10, 0);
+    wheel.schedule(1, 300);
+    wheel.schedule(2, 100);
+    wheel.schedule(3, 105);
+    wheel.schedule(4, 100);
+    EXPECT_EQ(wheel.size(), 4);
+
+    // Deadlines round up to whole ticks
+    EXPECT_TRUE(wheel.advance(99).isEmpty());
+    EXPECT_EQ(wheel.advance(100), QList<quint32>({ 2, 4 }));
+    EXPECT_TRUE(wheel.advance(109).isEmpty());
+    EXPECT_EQ(wheel.advance(1000), QList<quint32>({ 3, 1 }));
+    EXPECT_EQ(wheel.size(), 0);
+    EXPECT_EQ(wheel.nextWakeup(), -1);
+}
+
+TEST(TimingWheelTest, ReschedulesAndCancels) {
+    TimingWheel wheel(10, 0);
+    wheel.schedule(1, 100);
+    wheel.schedule(2, 200);
+    wheel.schedule(1, 400);
+    wheel.cancel(2);
+
+    EXPECT_TRUE(wheel.contains(1));
+    EXPECT_FALSE(wheel.contains(2));
+    EXPECT_TRUE(wheel.advance(300).isEmpty());
+    EXPECT_EQ(wheel.advance(400), QList<quint32>({ 1 }));
+}
+
+TEST(TimingWheelTest, CascadesDistantDeadlines) {
+    TimingWheel wheel(50, 0);
+
+    // Spread over every level, the last one past the wheel's range
+    const QList<qint64> deadlines = { 3'000, 60'000, 3'600'000, 86'400'000, 2'000'000'000 };
+    for (int i = 0; i < deadlines.size(); ++i) {
+        wheel.schedule(quint32(i), deadlines[i]);
+    }
+
+    // Following nextWakeup() never overshoots a deadline
+    qint64 now = 0;
+    for (int i = 0; i < 4; ++i) {
+        QList<quint32> expired;
+        while (expired.isEmpty()) {
+            const qint64 wakeup = wheel.nextWakeup();
+            ASSERT_GT(wakeup, now);
+            ASSERT_LE(wakeup, deadlines[i]);
+            now = wakeup;
+            expired = wheel.advance(now);
+        }
+        EXPECT_EQ(expired, QList<quint32>({ quint32(i) }));
+        EXPECT_EQ(now, deadlines[i]);
+    }
+
+    // Long jumps, as after a suspend, rebuild the wheel
+    EXPECT_TRUE(wheel.advance(1'999'999'999).isEmpty());
+    EXPECT_EQ(wheel.advance(2'000'000'000), QList<quint32>({ 4 }));
+}
+
+TEST_F(NotificationManagerTest, ReplacementRestartsExpiry) {
+    NotificationManager manager;
+    QSignalSpy closed(&manager, &NotificationManager::notificationClosed);
+
+    const uint id = notify(manager, "mail", "First", 0, 100);
+    settle(60);
+    EXPECT_EQ(notify(manager, "mail", "Second", id, 300), id);
+    settle(150);
+    EXPECT_EQ(closed.count(), 0);
+
+    ASSERT_TRUE(waitFor([&closed]() { return closed.count() == 1; }));
+    EXPECT_EQ(closed.first().at(0).toUInt(), id);
+    EXPECT_EQ(closed.first().at(1).toUInt(), 1u);
+    EXPECT_EQ(manager.getHistory().size(), 1);
+    EXPECT_EQ(manager.getHistory().first().summary, "Second");
+}
+
+TEST_F(NotificationManagerTest, CoalescesUpdatesPerFrame) {
+    NotificationManager manager;
+    QSignalSpy created(&manager, &NotificationManager::notificationCreated);
+    QSignalSpy updated(&manager, &NotificationManager::notificationUpdated);
+    QSignalSpy closed(&manager, &NotificationManager::notificationClosed);
+
+    // Created and replaced within one frame: the UI only sees the result
+    uint id = notify(manager, "player", "Track 0");
+    for (int i = 1; i < 100; ++i) {
+        notify(manager, "player", QString("Track %1").arg(i), id);
+    }
+    ASSERT_TRUE(waitFor([&created]() { return created.count() > 0; }));
+    settle(50);
+    EXPECT_EQ(created.count(), 1);
+    EXPECT_EQ(updated.count(), 0);
+    EXPECT_EQ(created.first().at(0).value<NotificationInfo>().summary, "Track 99");
+
+    // A burst of progress updates is one UI update
+    for (int i = 0; i <= 100; ++i) {
+        notify(manager, "player", QString("Progress %1").arg(i), id);
+    }
+    ASSERT_TRUE(waitFor([&updated]() { return updated.count() > 0; }));
+    settle(50);
+    EXPECT_EQ(updated.count(), 1);
+    EXPECT_EQ(updated.first().at(0).value<NotificationInfo>().summary, "Progress 100");
+
+    // Closed before its frame: never shown, so never closed either
+    id = notify(manager, "player", "Gone");
+    manager.closeNotification(id);
+    settle(50);
+    EXPECT_EQ(created.count(), 1);
+    EXPECT_EQ(closed.count(), 0);
+    EXPECT_EQ(manager.getHistory().last().summary, "Gone");
+
+    // A handler closing a notification still waiting in the same frame
+    notify(manager, "player", "First");
+    const uint second = notify(manager, "player", "Second");
+    QObject::connect(&manager, &NotificationManager::notificationCreated, &manager,
+                     [&manager, second](const NotificationInfo &info) {
+                         if (info.summary == "First") {
+                             manager.closeNotification(second);
+                         }
+                     });
+    settle(50);
+    EXPECT_EQ(created.count(), 2);
+    EXPECT_EQ(closed.count(), 0);
+}
+
+TEST_F(NotificationManagerTest, RateLimitsPerApplication) {
+    NotificationManager manager;
+    manager.setRateLimit(5, 0.0);
+
+    QList<uint> ids;
+    for (int i = 0; i < 20; ++i) {
+        ids.append(notify(manager, "chat", QString("Message %1").arg(i)));
+    }
+
+    // The burst gets its own notifications, the rest merge into the latest
+    EXPECT_EQ(QSet<uint>(ids.begin(), ids.end()).size(), 5);
+    const NotificationInfo latest = manager.getNotificationInfo(ids.last());
+    EXPECT_EQ(latest.summary, "Message 19");
+    EXPECT_EQ(latest.hints.value("x-vivox-merged-count").toInt(), 15);
+
+    // Other applications and critical notifications are unaffected
+    EXPECT_FALSE(ids.contains(notify(manager, "mail", "Inbox")));
+    EXPECT_FALSE(ids.contains(notify(manager, "chat", "Urgent", 0, 0, { { "urgency", 2 } })));
+    EXPECT_EQ(manager.getActiveNotifications().size(), 7);
+}
+
+TEST_F(NotificationManagerTest, BoundsHistory) {
+    NotificationManager manager;
+    manager.setHistoryLimits(1000, 64 * 1024);
+
+    const QVariantMap hints = { { "image-data", QByteArray(32 * 1024, 'x') }, { "category", "im" } };
+    for (int i = 0; i < 200; ++i) {
+        const uint id = notify(manager, QString("app%1").arg(i), QString("Message %1").arg(i), 0, 0, hints);
+        manager.closeNotification(id, 2);
+    }
+
+    // Image data is dropped, so far more than two entries fit
+    const QList<NotificationInfo> history = manager.getHistory();
+    EXPECT_GT(history.size(), 50);
+    EXPECT_LE(manager.getHistorySize(), 64 * 1024);
+    EXPECT_EQ(history.last().summary, "Message 199");
+    EXPECT_FALSE(history.last().hints.contains("image-data"));
+    EXPECT_EQ(history.last().category, "im");
+
+    manager.setHistoryLimits(10, 64 * 1024);
+    EXPECT_EQ(manager.getHistory().size(), 10);
+    EXPECT_EQ(manager.getHistory().first().summary, "Message 190");
+
+    manager.clearHistory();
+    EXPECT_TRUE(manager.getHistory().isEmpty());
+    EXPECT_EQ(manager.getHistorySize(), 0);
+}
+
+TEST_F(NotificationManagerTest, SyntheticFlood) {
+    NotificationManager manager;
+    manager.setHistoryLimits(500, 256 * 1024);
+
+    int created = 0;
+    int updated = 0;
+    int closed = 0;
+    QObject::connect(&manager, &NotificationManager::notificationCreated, [&created]() { ++created; });
+    QObject::connect(&manager, &NotificationManager::notificationUpdated, [&updated]() { ++updated; });
+    QObject::connect(&manager, &NotificationManager::notificationClosed, [&closed]() { ++closed; });
+
+    // 50 applications sending 1000 short-lived notifications each, plus
+    // progress updates, all within a few frames
+    const int applications = 50;
+    const int perApplication = 1000;
+    QHash<QString, uint> progress;
+    QSet<uint> ids;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < perApplication; ++i) {
+        for (int app = 0; app < applications; ++app) {
+            const QString appName = QString("app%1").arg(app);
+            ids.insert(notify(manager, appName, QString("Message %1").arg(i), 0, 200 + (i * 7 + app) % 300,
+                              { { "image-data", QByteArray(1024, 'x') } }));
+            progress[appName] = notify(manager, appName, QString("Progress %1").arg(i), progress.value(appName), 1000);
+            ids.insert(progress[appName]);
+        }
+    }
+    const qint64 floodTime = timer.elapsed();
+
+    // Each application's burst is all that reaches the screen
+    EXPECT_LE(manager.getActiveNotifications().size(), applications * 20);
+
+    ASSERT_TRUE(waitFor([&manager]() { return manager.getActiveNotifications().isEmpty(); }, 10000));
+    const qint64 drainTime = timer.elapsed();
+
+    // Notifications that expired before their first frame were never shown
+    EXPECT_LE(ids.size(), applications * 20);
+    EXPECT_LE(created, ids.size());
+    EXPECT_LE(updated, ids.size() * 10);
+    EXPECT_EQ(closed, created);
+    EXPECT_LE(manager.getHistory().size(), 500);
+    EXPECT_LE(manager.getHistorySize(), 256 * 1024);
+
+    RecordProperty("requests", applications * perApplication * 2);
+    RecordProperty("floodMs", static_cast<int>(floodTime));
+    RecordProperty("notifications", ids.size());
+    RecordProperty("shown", created);
+    RecordProperty("uiUpdates", updated);
+    RecordProperty("drainMs", static_cast<int>(drainTime));
+    RecordProperty("historyEntries", manager.getHistory().size());
+    RecordProperty("historyBytes", static_cast<int>(manager.getHistorySize()));
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/power/PowerManager.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QProcess>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <memory>
+
+using namespace VivoX::System;
+using namespace VivoX::Testing;
+using namespace testing;
+
+namespace {
+    const QString displayDevicePath = "/org/freedesktop/UPower/devices/DisplayDevice";
+}
+
+// UPower daemon object handing out the display device
+class MockUPower : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.UPower")
+
+public:
+    int calls = 0;
+
+public slots:
+    QDBusObjectPath GetDisplayDevice() {
+        ++calls;
+        return QDBusObjectPath(displayDevicePath);
+    }
+};
+
+// UPower display device; every property read counts as bus traffic
+class MockDevice : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.UPower.Device")
+    Q_PROPERTY(double Percentage READ percentage)
+    Q_PROPERTY(qlonglong TimeToEmpty READ timeToEmpty)
+    Q_PROPERTY(uint State READ state)
+    Q_PROPERTY(bool IsPresent READ isPresent)
+
+public:
+    double percentage() const { ++reads; return 80.0; }
+    qlonglong timeToEmpty() const { ++reads; return 7200; }
+    uint state() const { ++reads; return 1; }
+    bool isPresent() const { ++reads; return true; }
+
+    void emitChanged(QDBusConnection &connection, const QVariantMap &changed) {
+        QDBusMessage signal = QDBusMessage::createSignal(displayDevicePath,
+                                                         "org.freedesktop.DBus.Properties",
+                                                         "PropertiesChanged");
+        signal << QString("org.freedesktop.UPower.Device") << changed << QStringList();
+        connection.send(signal);
+    }
+
+    mutable int reads = 0;
+};
+
+class PowerManagerTest : public QtTest {
+protected:
+    void SetUp() override {
+        // Run against a private bus standing in for the system bus
+        const QString daemon = QStandardPaths::findExecutable("dbus-daemon");
+        if (daemon.isEmpty()) {
+            GTEST_SKIP() << "dbus-daemon not available";
+        }
+
+        m_daemon = std::make_unique<QProcess>();
+        m_daemon->start(daemon, { "--session", "--nofork", "--print-address" });
+        ASSERT_TRUE(m_daemon->waitForReadyRead(5000));
+        const QString address = QString::fromUtf8(m_daemon->readLine()).trimmed();
+
+        m_upowerBus = std::make_unique<QDBusConnection>(QDBusConnection::connectToBus(address, "upower"));
+        ASSERT_TRUE(m_upowerBus->registerObject("/org/freedesktop/UPower", &m_upower, QDBusConnection::ExportAllSlots));
+        ASSERT_TRUE(m_upowerBus->registerObject(displayDevicePath, &m_device, QDBusConnection::ExportAllProperties));
+        ASSERT_TRUE(m_upowerBus->registerService("org.freedesktop.UPower"));
+
+        m_powerManager = std::make_unique<PowerManager>(QDBusConnection::connectToBus(address, "power"));
+        ASSERT_TRUE(m_powerManager->initialize());
+        ASSERT_TRUE(waitFor([this]() { return m_powerManager->getBatteryLevel() == 80; }));
+    }
+
+    void TearDown() override {
+        m_powerManager.reset();
+        m_upowerBus.reset();
+        QDBusConnection::disconnectFromBus("power");
+        QDBusConnection::disconnectFromBus("upower");
+        if (m_daemon) {
+            m_daemon->kill();
+            m_daemon->waitForFinished();
+        }
+    }
+
+    std::unique_ptr<QProcess> m_daemon;
+    std::unique_ptr<QDBusConnection> m_upowerBus;
+    std::unique_ptr<PowerManager> m_powerManager;
+    MockUPower m_upower;
+    MockDevice m_device;
+};
+
+TEST_F(PowerManagerTest, ReadsDisplayDeviceWithSingleGetAll) {
+    EXPECT_EQ(m_upower.calls, 1);
+    EXPECT_EQ(m_device.reads, 4);
+    EXPECT_EQ(m_powerManager->getBatteryTimeRemaining(), 7200);
+    EXPECT_EQ(m_powerManager->getPowerState(), PowerManager::OnAC);
+}
+
+TEST_F(PowerManagerTest, CoalescesPropertyChangeBursts) {
+    QSignalSpy levelChanged(m_powerManager.get(), &PowerManager::batteryLevelChanged);
+
+    m_device.emitChanged(*m_upowerBus, { { "Percentage", 79.0 } });
+    m_device.emitChanged(*m_upowerBus, { { "TimeToEmpty", qlonglong(7000) } });
+    m_device.emitChanged(*m_upowerBus, { { "Percentage", 78.0 } });
+
+    ASSERT_TRUE(waitFor([&levelChanged]() { return levelChanged.count() > 0; }));
+    waitFor([]() { return false; }, 300);
+
+    ASSERT_EQ(levelChanged.count(), 1);
+    EXPECT_EQ(levelChanged.first().first().toInt(), 78);
+    EXPECT_EQ(m_powerManager->getBatteryTimeRemaining(), 7000);
+}
+
+TEST_F(PowerManagerTest, StaysQuietWhenIdle) {
+    const int calls = m_upower.calls;
+    const int reads = m_device.reads;
+
+    // Nothing changes, so nothing may be sent over the bus
+    waitFor([]() { return false; }, 1000);
+
+    EXPECT_EQ(m_upower.calls, calls);
+    EXPECT_EQ(m_device.reads, reads);
+}
+
+#include "PowerManagerTest.moc"
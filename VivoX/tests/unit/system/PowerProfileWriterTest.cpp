@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/power/PowerProfileWriter.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+using namespace VivoX::System;
+using namespace VivoX::Testing;
+using namespace testing;
+
+class PowerProfileWriterTest : public QtTest {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+        m_root = m_dir.path();
+        m_cpuDir = m_root + "/devices/system/cpu";
+    }
+
+    void writeFile(const QString &path, const QByteArray &data) const {
+        ASSERT_TRUE(QDir().mkpath(QFileInfo(path).path()));
+        QFile file(path);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data + "\n");
+    }
+
+    QByteArray readFile(const QString &path) const {
+        QFile file(path);
+        return file.open(QIODevice::ReadOnly) ? file.readAll().trimmed() : QByteArray();
+    }
+
+    QString policyPath(int policy) const {
+        return QString("%1/cpufreq/policy%2").arg(m_cpuDir).arg(policy);
+    }
+
+    // A cpufreq tree with cpusPerPolicy CPUs linked to each policy
+    void createTree(int cpus, const QByteArray &online, int cpusPerPolicy = 1,
+                    const QByteArray &governors = "conservative ondemand userspace powersave performance schedutil",
+                    const QByteArray &preferences = QByteArray()) {
+        writeFile(m_cpuDir + "/online", online);
+        for (int cpu = 0; cpu < cpus; ++cpu) {
+            const int policy = cpu - cpu % cpusPerPolicy;
+            if (policy == cpu) {
+                writeFile(policyPath(policy) + "/scaling_governor", "powersave");
+                writeFile(policyPath(policy) + "/scaling_available_governors", governors);
+                if (!preferences.isEmpty()) {
+                    writeFile(policyPath(policy) + "/energy_performance_preference", "default");
+                    writeFile(policyPath(policy) + "/energy_performance_available_preferences", preferences);
+                }
+            }
+            ASSERT_TRUE(QDir().mkpath(QString("%1/cpu%2").arg(m_cpuDir).arg(cpu)));
+            ASSERT_TRUE(QFile::link(policyPath(policy), QString("%1/cpu%2/cpufreq").arg(m_cpuDir).arg(cpu)));
+        }
+    }
+
+    static PowerProfile governorProfile(const QString &governor) {
+        PowerProfile profile;
+        profile.governors = { governor };
+        return profile;
+    }
+
+    QTemporaryDir m_dir;
+    QString m_root;
+    QString m_cpuDir;
+};
+
+TEST_F(PowerProfileWriterTest, AppliesToEveryOnlineCpu) {
+    // 64 CPUs, of which 48 to 55 are offline
+    createTree(64, "0-47,56-63");
+
+    PowerProfileWriter writer(m_root);
+    writer.apply(governorProfile("performance"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+
+    EXPECT_EQ(writer.cpus().size(), 56);
+    EXPECT_EQ(writer.cpus().last(), 63);
+    EXPECT_EQ(writer.writeCount(), 56);
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        const bool online = cpu < 48 || cpu >= 56;
+        EXPECT_EQ(readFile(policyPath(cpu) + "/scaling_governor"), online ? "performance" : "powersave") << cpu;
+    }
+}
+
+TEST_F(PowerProfileWriterTest, WritesSharedPolicyOnce) {
+    createTree(16, "0-15", 4);
+
+    PowerProfileWriter writer(m_root);
+    writer.apply(governorProfile("schedutil"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+
+    EXPECT_EQ(writer.cpus().size(), 16);
+    EXPECT_EQ(writer.writeCount(), 4);
+    EXPECT_EQ(readFile(policyPath(12) + "/scaling_governor"), "schedutil");
+}
+
+TEST_F(PowerProfileWriterTest, SkipsValuesAlreadySet) {
+    createTree(8, "0-7");
+    writeFile(policyPath(3) + "/scaling_governor", "performance");
+
+    PowerProfileWriter writer(m_root);
+    writer.apply(governorProfile("performance"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+    EXPECT_EQ(writer.writeCount(), 7);
+
+    writer.apply(governorProfile("performance"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+    EXPECT_EQ(writer.writeCount(), 7);
+
+    writer.apply(governorProfile("powersave"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+    EXPECT_EQ(writer.writeCount(), 15);
+}
+
+TEST_F(PowerProfileWriterTest, FallsBackToAvailableSettings) {
+    // intel_pstate: two governors, preferences and an inverted boost switch
+    createTree(4, "0-3", 1, "performance powersave",
+               "default performance balance_performance balance_power power");
+    writeFile(m_cpuDir + "/intel_pstate/no_turbo", "0");
+
+    PowerProfileWriter writer(m_root);
+    writer.apply(PowerProfile::forMode("balanced"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+    EXPECT_EQ(readFile(policyPath(0) + "/scaling_governor"), "powersave");
+    EXPECT_EQ(readFile(policyPath(0) + "/energy_performance_preference"), "balance_performance");
+    EXPECT_EQ(readFile(m_cpuDir + "/intel_pstate/no_turbo"), "0");
+
+    writer.apply(PowerProfile::forMode("powersave"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+    EXPECT_EQ(readFile(policyPath(3) + "/energy_performance_preference"), "power");
+    EXPECT_EQ(readFile(m_cpuDir + "/intel_pstate/no_turbo"), "1");
+
+    writer.apply(PowerProfile::forMode("performance"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+    EXPECT_EQ(readFile(policyPath(3) + "/scaling_governor"), "performance");
+    EXPECT_EQ(readFile(policyPath(3) + "/energy_performance_preference"), "performance");
+    EXPECT_EQ(readFile(m_cpuDir + "/intel_pstate/no_turbo"), "0");
+}
+
+TEST_F(PowerProfileWriterTest, LeavesUnavailableGovernorAlone) {
+    createTree(2, "0-1", 1, "performance powersave");
+    writeFile(m_cpuDir + "/cpufreq/boost", "1");
+
+    PowerProfileWriter writer(m_root);
+    QSignalSpy applied(&writer, &PowerProfileWriter::profileApplied);
+    PowerProfile profile = governorProfile("ondemand");
+    profile.boost = 0;
+    writer.apply(profile);
+    ASSERT_TRUE(writer.waitForIdle(5000));
+
+    EXPECT_EQ(readFile(policyPath(0) + "/scaling_governor"), "powersave");
+    EXPECT_EQ(readFile(m_cpuDir + "/cpufreq/boost"), "0");
+    ASSERT_TRUE(applied.wait(5000));
+    EXPECT_TRUE(applied.first().at(0).toBool());
+}
+
+TEST_F(PowerProfileWriterTest, CoalescesQueuedProfiles) {
+    createTree(64, "0-63");
+
+    PowerProfileWriter writer(m_root);
+    QSignalSpy applied(&writer, &PowerProfileWriter::profileApplied);
+
+    // Flapping between AC and battery: only the latest mode matters
+    const QStringList modes = { "performance", "powersave", "balanced" };
+    for (int i = 0; i < 300; ++i) {
+        writer.apply(PowerProfile::forMode(modes[i % modes.size()]));
+    }
+    ASSERT_TRUE(writer.waitForIdle(5000));
+
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        EXPECT_EQ(readFile(policyPath(cpu) + "/scaling_governor"), "schedutil") << cpu;
+    }
+    EXPECT_LT(writer.writeCount(), 300 * 64 / 2);
+
+    QCoreApplication::processEvents();
+    EXPECT_GE(applied.count(), 1);
+    EXPECT_LT(applied.count(), 300);
+}
+
+TEST_F(PowerProfileWriterTest, ApplyLatency) {
+    const int cpus = 256;
+    createTree(cpus, "0-255", 1, "conservative ondemand userspace powersave performance schedutil",
+               "default performance balance_performance balance_power power");
+    writeFile(m_cpuDir + "/cpufreq/boost", "1");
+
+    PowerProfileWriter writer(m_root);
+    const QStringList modes = { "performance", "powersave", "balanced" };
+    qint64 callTime = 0;
+    qint64 passTime = 0;
+
+    QElapsedTimer timer;
+    for (const QString &mode : modes) {
+        timer.start();
+        writer.apply(PowerProfile::forMode(mode));
+        callTime = qMax(callTime, timer.nsecsElapsed() / 1000);
+        ASSERT_TRUE(writer.waitForIdle(5000));
+        passTime = qMax(passTime, timer.nsecsElapsed() / 1000);
+    }
+
+    // Applying the same mode again touches nothing
+    const int writes = writer.writeCount();
+    writer.apply(PowerProfile::forMode("balanced"));
+    ASSERT_TRUE(writer.waitForIdle(5000));
+    EXPECT_EQ(writer.writeCount(), writes);
+
+    RecordProperty("cpus", cpus);
+    RecordProperty("applyUs", static_cast<int>(callTime));
+    RecordProperty("workerPassUs", static_cast<int>(passTime));
+    RecordProperty("writes", writes);
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/applications/ProcessLauncher.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <csignal>
+#include <memory>
+#include <vector>
+
+using namespace VivoX::System;
+using namespace VivoX::Testing;
+using namespace testing;
+
+class ProcessLauncherTest : public QtTest {
+protected:
+    static void SetUpTestSuite() {
+        // The helper has to be forked before anything else starts threads
+        s_prewarmed = ProcessLauncher::prewarm();
+
+        QtTest::SetUpTestSuite();
+
+        s_launcher = new ProcessLauncher();
+    }
+
+    static void TearDownTestSuite() {
+        delete s_launcher;
+        s_launcher = nullptr;
+    }
+
+    static QStringList environment() {
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        environment.insert("VIVOX_TEST", "launched");
+        return environment.toStringList();
+    }
+
+    // Launch a shell command and wait for it to exit
+    static int run(ProcessLauncher *launcher, const QString &command, const QString &directory = QString()) {
+        QSignalSpy finished(launcher, &ProcessLauncher::finished);
+        const qint64 pid = launcher->launch("sh", { "-c", command }, environment(), "test", directory);
+        if (pid <= 0) {
+            return -2;
+        }
+        if (!waitFor([&finished]() { return finished.count() > 0; })) {
+            return -3;
+        }
+        EXPECT_EQ(finished.first().at(0).toLongLong(), pid);
+        return finished.first().at(1).toInt();
+    }
+
+    static ProcessLauncher *s_launcher;
+    static bool s_prewarmed;
+};
+
+ProcessLauncher *ProcessLauncherTest::s_launcher = nullptr;
+bool ProcessLauncherTest::s_prewarmed = false;
+
+TEST_F(ProcessLauncherTest, SpawnsThroughHelper) {
+    ASSERT_TRUE(s_prewarmed);
+    EXPECT_TRUE(s_launcher->usesHelper());
+
+    EXPECT_EQ(run(s_launcher, "exit 3"), 3);
+    EXPECT_EQ(run(s_launcher, "kill -9 $$"), 128 + 9);
+    EXPECT_TRUE(s_launcher->usesHelper());
+}
+
+TEST_F(ProcessLauncherTest, PassesEnvironmentAndDirectory) {
+    QTemporaryDir directory;
+    ASSERT_TRUE(directory.isValid());
+
+    EXPECT_EQ(run(s_launcher, "echo \"$VIVOX_TEST\" > output; pwd >> output", directory.path()), 0);
+
+    QFile output(directory.filePath("output"));
+    ASSERT_TRUE(output.open(QIODevice::ReadOnly));
+    EXPECT_EQ(QString::fromUtf8(output.readAll()).split('\n', Qt::SkipEmptyParts),
+              QStringList({ "launched", QFileInfo(directory.path()).canonicalFilePath() }));
+}
+
+TEST_F(ProcessLauncherTest, ReportsSpawnFailures) {
+    EXPECT_EQ(s_launcher->launch("vivox-no-such-program", {}, environment()), 0);
+    EXPECT_EQ(s_launcher->launch("/bin/sh", {}, environment(), "test", "/nonexistent/directory"), 0);
+
+    // The helper survives failed launches
+    EXPECT_EQ(run(s_launcher, "exit 0"), 0);
+}
+
+TEST_F(ProcessLauncherTest, SpawnsInProcessWithoutHelper) {
+    // The helper already belongs to the suite's launcher
+    ProcessLauncher launcher;
+    EXPECT_FALSE(launcher.usesHelper());
+
+    EXPECT_EQ(run(&launcher, "exit 7"), 7);
+}
+
+TEST_F(ProcessLauncherTest, AttributesForkedProcessesThroughCgroup) {
+    QSignalSpy finished(s_launcher, &ProcessLauncher::finished);
+    const qint64 pid = s_launcher->launch("sh", { "-c", "sleep 5 & echo $! ; wait" }, environment(), "browser");
+    ASSERT_GT(pid, 0);
+    EXPECT_EQ(s_launcher->groupOf(pid), "browser");
+
+    if (s_launcher->cgroupOf(pid).isEmpty()) {
+        ::kill(pid_t(pid), SIGKILL);
+        waitFor([&finished]() { return finished.count() > 0; });
+        GTEST_SKIP() << "No delegated cgroup available";
+    }
+
+    // The forked child lands in the launch's cgroup
+    QFile procs(s_launcher->cgroupOf(pid) + "/cgroup.procs");
+    ASSERT_TRUE(waitFor([&procs]() {
+        procs.close();
+        return procs.open(QIODevice::ReadOnly) && procs.readAll().split('\n').size() > 2;
+    }));
+    procs.close();
+    ASSERT_TRUE(procs.open(QIODevice::ReadOnly));
+    for (const QByteArray &line : procs.readAll().split('\n')) {
+        if (!line.isEmpty()) {
+            EXPECT_EQ(s_launcher->groupOf(line.toLongLong()), "browser");
+        }
+    }
+
+    QFile kill(s_launcher->cgroupOf(pid) + "/cgroup.kill");
+    ASSERT_TRUE(kill.open(QIODevice::WriteOnly));
+    kill.write("1");
+    kill.close();
+    ASSERT_TRUE(waitFor([&finished]() { return finished.count() > 0; }));
+}
+
+TEST_F(ProcessLauncherTest, SpawnLatency) {
+    const int launches = 100;
+    ProcessLauncher direct;
+
+    auto measure = [](ProcessLauncher *launcher) {
+        std::vector<qint64> latencies;
+        QSignalSpy finished(launcher, &ProcessLauncher::finished);
+        for (int i = 0; i < launches; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            EXPECT_GT(launcher->launch("/bin/true", {}, environment()), 0);
+            latencies.push_back(timer.nsecsElapsed() / 1000);
+        }
+        EXPECT_TRUE(waitFor([&finished]() { return finished.count() == launches; }));
+        return latencies;
+    };
+
+    const std::vector<qint64> helper = measure(s_launcher);
+    const std::vector<qint64> inProcess = measure(&direct);
+
+    RecordProperty("spawns", launches);
+    RecordProperty("helperP50Us", static_cast<int>(percentile(helper, 50)));
+    RecordProperty("helperP99Us", static_cast<int>(percentile(helper, 99)));
+    RecordProperty("inProcessP50Us", static_cast<int>(percentile(inProcess, 50)));
+    RecordProperty("inProcessP99Us", static_cast<int>(percentile(inProcess, 99)));
+}
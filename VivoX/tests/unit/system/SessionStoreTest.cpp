@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "system/session/SessionStore.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace VivoX::System;
+using namespace testing;
+
+class SessionStoreTest : public Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(m_dir.isValid());
+        m_path = m_dir.filePath("sessions");
+    }
+
+    static SessionWindow window(const QString &key, const QString &appId, int x, int workspace = 0) {
+        SessionWindow window;
+        window.key = key;
+        window.appId = appId;
+        window.title = appId + " " + key;
+        window.geometry = QRect(x, 20, 800, 600);
+        window.workspace = workspace;
+        return window;
+    }
+
+    QByteArray readLog() const {
+        QFile file(m_path + "/session.log");
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+
+    void writeLog(const QByteArray &data) const {
+        QFile file(m_path + "/session.log");
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+    QTemporaryDir m_dir;
+    QString m_path;
+};
+
+TEST_F(SessionStoreTest, RoundTripsState) {
+    SessionStore store(m_path);
+    ASSERT_TRUE(store.load());
+
+    store.setWorkspace({ "ws-1", "Main", 0 });
+    store.setWorkspace({ "ws-2", "Web", 1 });
+    store.setActiveWorkspace("ws-2");
+    store.addApplication("editor");
+    store.addApplication("browser");
+    store.setWindow(window("1", "editor", 10));
+    SessionWindow browser = window("2", "browser", 400, 1);
+    browser.state = SessionWindow::Maximized;
+    store.setWindow(browser);
+    ASSERT_TRUE(store.flush());
+
+    SessionStore loaded(m_path);
+    ASSERT_TRUE(loaded.load());
+    const SessionState state = loaded.state();
+    ASSERT_EQ(state.windows.size(), 2);
+    EXPECT_EQ(state.windows[0].key, "1");
+    EXPECT_EQ(state.windows[0].geometry, QRect(10, 20, 800, 600));
+    EXPECT_EQ(state.windows[1].appId, "browser");
+    EXPECT_EQ(state.windows[1].title, "browser 2");
+    EXPECT_EQ(state.windows[1].state, SessionWindow::Maximized);
+    EXPECT_EQ(state.windows[1].workspace, 1);
+    ASSERT_EQ(state.workspaces.size(), 2);
+    EXPECT_EQ(state.workspaces[1].name, "Web");
+    EXPECT_EQ(state.activeWorkspace, "ws-2");
+    EXPECT_EQ(state.applications, QStringList({ "editor", "browser" }));
+}
+
+TEST_F(SessionStoreTest, CoalescesChangesBetweenFlushes) {
+    SessionStore store(m_path);
+    ASSERT_TRUE(store.load());
+    store.setWindow(window("1", "editor", 0));
+    ASSERT_TRUE(store.flush());
+    const int logSize = store.logSize();
+
+    // A drag across the screen, then a closed window and an application that came and went
+    for (int x = 0; x < 1000; x += 10) {
+        store.setWindow(window("1", "editor", x));
+    }
+    store.setWindow(window("2", "terminal", 0));
+    store.removeWindow("2");
+    store.addApplication("calculator");
+    store.removeApplication("calculator");
+    EXPECT_TRUE(store.hasPendingChanges());
+    ASSERT_TRUE(store.flush());
+    EXPECT_FALSE(store.hasPendingChanges());
+    EXPECT_EQ(store.logSize(), logSize + 3);
+
+    SessionStore loaded(m_path);
+    ASSERT_TRUE(loaded.load());
+    ASSERT_EQ(loaded.state().windows.size(), 1);
+    EXPECT_EQ(loaded.state().windows[0].geometry.x(), 990);
+    EXPECT_TRUE(loaded.state().applications.isEmpty());
+}
+
+TEST_F(SessionStoreTest, StopsAtTornRecord) {
+    SessionStore store(m_path);
+    ASSERT_TRUE(store.load());
+    store.setWindow(window("1", "editor", 10));
+    ASSERT_TRUE(store.flush());
+    store.setWindow(window("2", "browser", 20));
+    ASSERT_TRUE(store.flush());
+
+    // Cut the last record short, as a crash during the write would
+    QByteArray log = readLog();
+    log.chop(10);
+    writeLog(log);
+
+    SessionStore loaded(m_path);
+    ASSERT_TRUE(loaded.load());
+    ASSERT_EQ(loaded.state().windows.size(), 1);
+    EXPECT_EQ(loaded.state().windows[0].key, "1");
+
+    // New records don't continue the torn one
+    loaded.setWindow(window("3", "terminal", 30));
+    ASSERT_TRUE(loaded.flush());
+    SessionStore reloaded(m_path);
+    ASSERT_TRUE(reloaded.load());
+    EXPECT_EQ(reloaded.state().windows.size(), 2);
+}
+
+TEST_F(SessionStoreTest, IgnoresLogOfEarlierGeneration) {
+    SessionStore store(m_path);
+    ASSERT_TRUE(store.load());
+    store.setWindow(window("1", "editor", 10));
+    ASSERT_TRUE(store.flush());
+    store.setWindow(window("2", "browser", 20));
+    ASSERT_TRUE(store.flush());
+    const QByteArray staleLog = readLog();
+
+    // Compaction interrupted after the snapshot was renamed into place
+    store.removeWindow("1");
+    store.setWindow(window("2", "browser", 50));
+    ASSERT_TRUE(store.compact());
+    writeLog(staleLog);
+
+    // Replaying the old log would move the window back
+    SessionStore loaded(m_path);
+    ASSERT_TRUE(loaded.load());
+    ASSERT_EQ(loaded.state().windows.size(), 1);
+    EXPECT_EQ(loaded.state().windows[0].key, "2");
+    EXPECT_EQ(loaded.state().windows[0].geometry.x(), 50);
+}
+
+TEST_F(SessionStoreTest, CompactsGrowingLog) {
+    SessionStore store(m_path);
+    ASSERT_TRUE(store.load());
+
+    for (int i = 0; i < 2000; ++i) {
+        store.setWindow(window(QString::number(i % 5), "editor", i));
+        ASSERT_TRUE(store.flush());
+    }
+    EXPECT_LT(store.logSize(), 300);
+
+    SessionStore loaded(m_path);
+    ASSERT_TRUE(loaded.load());
+    ASSERT_EQ(loaded.state().windows.size(), 5);
+    EXPECT_EQ(loaded.state().windows[4].geometry.x(), 1999);
+}
+
+TEST_F(SessionStoreTest, ClearStartsEmptySession) {
+    SessionStore store(m_path);
+    ASSERT_TRUE(store.load());
+    store.setWindow(window("1", "editor", 10));
+    store.addApplication("editor");
+    ASSERT_TRUE(store.flush());
+
+    store.clear();
+    EXPECT_TRUE(store.state().isEmpty());
+    EXPECT_TRUE(store.hasPendingChanges());
+    ASSERT_TRUE(store.flush());
+
+    SessionStore loaded(m_path);
+    ASSERT_TRUE(loaded.load());
+    EXPECT_TRUE(loaded.state().isEmpty());
+}
+
+TEST_F(SessionStoreTest, FlushAndLoadLatency) {
+    const int windows = 200;
+    const int flushes = 200;
+
+    SessionStore store(m_path);
+    ASSERT_TRUE(store.load());
+    for (int i = 0; i < windows; ++i) {
+        store.setWindow(window(QString::number(i), QString("app%1").arg(i % 40), i, i % 4));
+        store.addApplication(QString("app%1").arg(i % 40));
+    }
+    ASSERT_TRUE(store.compact());
+
+    // Each flush carries one moved window, as while dragging
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < flushes; ++i) {
+        store.setWindow(window(QString::number(i % windows), QString("app%1").arg(i % 40), 1000 + i, i % 4));
+        ASSERT_TRUE(store.flush());
+    }
+    const qint64 flushTime = timer.nsecsElapsed() / 1000;
+
+    timer.restart();
+    SessionStore loaded(m_path);
+    ASSERT_TRUE(loaded.load());
+    const qint64 loadTime = timer.nsecsElapsed() / 1000;
+    EXPECT_EQ(loaded.state().windows.size(), windows);
+
+    RecordProperty("windows", windows);
+    RecordProperty("flushUs", static_cast<int>(flushTime / flushes));
+    RecordProperty("loadUs", static_cast<int>(loadTime));
+    RecordProperty("logRecords", loaded.logSize());
+}
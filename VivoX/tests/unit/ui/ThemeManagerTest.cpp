@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "ui/qml/theme/ThemeManager.h"
+#include "tests/unit/TestSupport.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QQmlComponent>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QTemporaryDir>
+#include <memory>
+
+using namespace VivoX::UI;
+using namespace VivoX::Testing;
+using namespace testing;
+
+// Counts how often QML bindings are re-evaluated
+class BindingCounter : public QObject {
+    Q_OBJECT
+
+public:
+    Q_INVOKABLE QColor hit(const QColor &color) {
+        m_hits++;
+        return color;
+    }
+
+    int hits() const { return m_hits; }
+    void reset() { m_hits = 0; }
+
+private:
+    int m_hits = 0;
+};
+
+class ThemeManagerTest : public QtTest {
+protected:
+    void SetUp() override {
+        m_themeManager = std::make_unique<ThemeManager>();
+    }
+
+    void TearDown() override {
+        m_themeManager.reset();
+    }
+
+    // Count emissions of a signal
+    template<typename Signal>
+    std::shared_ptr<int> countSignal(Signal signal) {
+        auto count = std::make_shared<int>(0);
+        QObject::connect(m_themeManager.get(), signal, m_themeManager.get(), [count]() { ++*count; });
+        return count;
+    }
+
+    std::unique_ptr<ThemeManager> m_themeManager;
+};
+
+TEST_F(ThemeManagerTest, DarkModeSwitchNotifiesOnce) {
+    auto background = countSignal(&ThemeManager::backgroundColorChanged);
+    auto palette = countSignal(&ThemeManager::paletteChanged);
+    auto theme = countSignal(&ThemeManager::themeChanged);
+
+    m_themeManager->setDarkMode(true);
+
+    EXPECT_EQ(*background, 1);
+    EXPECT_EQ(*palette, 1);
+    EXPECT_EQ(*theme, 1);
+    EXPECT_EQ(m_themeManager->backgroundColor(), QColor(30, 30, 30));
+}
+
+TEST_F(ThemeManagerTest, UnchangedColorsAreNotNotified) {
+    auto primary = countSignal(&ThemeManager::primaryColorChanged);
+
+    // The accent color did not change, so neither do the colors derived from it
+    m_themeManager->setDarkMode(true);
+
+    EXPECT_EQ(*primary, 0);
+}
+
+TEST_F(ThemeManagerTest, BatchedUpdateDefersNotifications) {
+    auto palette = countSignal(&ThemeManager::paletteChanged);
+    auto theme = countSignal(&ThemeManager::themeChanged);
+
+    m_themeManager->beginUpdate();
+    m_themeManager->setDarkMode(true);
+    m_themeManager->setAccentColor(QColor("#ff4081"));
+    m_themeManager->setColor("background", QColor("#121212"));
+    m_themeManager->setCornerRadius(8);
+
+    EXPECT_TRUE(m_themeManager->isUpdating());
+    EXPECT_EQ(*palette, 0);
+    EXPECT_EQ(*theme, 0);
+
+    m_themeManager->endUpdate();
+
+    EXPECT_FALSE(m_themeManager->isUpdating());
+    EXPECT_EQ(*palette, 1);
+    EXPECT_EQ(*theme, 1);
+    EXPECT_EQ(m_themeManager->backgroundColor(), QColor("#121212"));
+}
+
+TEST_F(ThemeManagerTest, NestedUpdatesFlushAtOutermostEnd) {
+    auto theme = countSignal(&ThemeManager::themeChanged);
+
+    m_themeManager->beginUpdate();
+    m_themeManager->beginUpdate();
+    m_themeManager->setSpacing(4);
+    m_themeManager->endUpdate();
+
+    EXPECT_EQ(*theme, 0);
+
+    m_themeManager->endUpdate();
+
+    EXPECT_EQ(*theme, 1);
+}
+
+TEST_F(ThemeManagerTest, SetPaletteAppliesAtomically) {
+    auto palette = countSignal(&ThemeManager::paletteChanged);
+    auto theme = countSignal(&ThemeManager::themeChanged);
+
+    ThemePalette newPalette = m_themeManager->palette();
+    newPalette.background = QColor("#101010");
+    newPalette.text = QColor("#fafafa");
+    newPalette.accent = QColor("#2196f3");
+
+    m_themeManager->setPalette(newPalette);
+
+    EXPECT_EQ(*palette, 1);
+    EXPECT_EQ(*theme, 1);
+    EXPECT_EQ(m_themeManager->palette(), newPalette);
+
+    // Setting the same palette again is a no-op
+    m_themeManager->setPalette(newPalette);
+
+    EXPECT_EQ(*palette, 1);
+}
+
+TEST_F(ThemeManagerTest, LoadThemeNotifiesOnce) {
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    QFile file(dir.filePath("theme.json"));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.write(R"({
+        "name": "dark",
+        "darkMode": true,
+        "accentColor": "#ff4081",
+        "fontSize": 13,
+        "fontFamily": "Noto Sans",
+        "cornerRadius": 8,
+        "shadowRadius": 12,
+        "spacing": 8,
+        "padding": 12,
+        "colors": {
+            "background": "#121212",
+            "text": "#ffffff",
+            "border": "#424242"
+        }
+    })");
+    file.close();
+
+    auto palette = countSignal(&ThemeManager::paletteChanged);
+    auto theme = countSignal(&ThemeManager::themeChanged);
+
+    EXPECT_TRUE(m_themeManager->loadTheme(file.fileName()));
+
+    EXPECT_EQ(*palette, 1);
+    EXPECT_EQ(*theme, 1);
+    EXPECT_EQ(m_themeManager->backgroundColor(), QColor("#121212"));
+    EXPECT_EQ(m_themeManager->getColor("border"), QColor("#424242"));
+}
+
+// Measures binding re-evaluations and time spent during a theme switch with
+// many items bound both to individual color properties and to the palette.
+TEST_F(ThemeManagerTest, ThemeSwitchBindingBenchmark) {
+    constexpr int kItemCount = 2000;
+
+    QQmlEngine engine;
+    BindingCounter counter;
+    engine.rootContext()->setContextProperty("theme", m_themeManager.get());
+    engine.rootContext()->setContextProperty("counter", &counter);
+
+    QQmlComponent component(&engine);
+    component.setData(R"(
+        import QtQml 2.15
+        QtObject {
+            property color background: counter.hit(theme.backgroundColor)
+            property color foreground: counter.hit(theme.foregroundColor)
+            property color text: counter.hit(theme.textColor)
+            property color shadow: counter.hit(theme.shadowColor)
+            property color paletteBackground: counter.hit(theme.palette.background)
+            property color paletteForeground: counter.hit(theme.palette.foreground)
+            property color paletteText: counter.hit(theme.palette.text)
+            property color paletteShadow: counter.hit(theme.palette.shadow)
+        }
+    )", QUrl());
+    ASSERT_TRUE(component.isReady()) << component.errorString().toStdString();
+
+    std::vector<std::unique_ptr<QObject>> items;
+    items.reserve(kItemCount);
+    for (int i = 0; i < kItemCount; ++i) {
+        items.emplace_back(component.create());
+        ASSERT_TRUE(items.back());
+    }
+
+    counter.reset();
+
+    QElapsedTimer timer;
+    timer.start();
+    m_themeManager->setDarkMode(true);
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    // Each binding is re-evaluated exactly once per switch
+    EXPECT_EQ(counter.hits(), kItemCount * 8);
+    EXPECT_EQ(items.front()->property("paletteBackground").value<QColor>(), QColor(30, 30, 30));
+
+    RecordProperty("bindingEvaluations", counter.hits());
+    RecordProperty("switchTimeUs", static_cast<int>(elapsed / 1000));
+}
+
+#include "ThemeManagerTest.moc"
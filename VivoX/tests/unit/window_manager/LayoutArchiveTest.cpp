@@ -0,0 +1,310 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "window_manager/layouts/LayoutArchive.h"
+#include "tests/unit/TestSupport.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace VivoX::WindowManager::Layouts;
+using namespace VivoX::WindowManager::Windows;
+using namespace VivoX::Testing;
+using namespace testing;
+
+namespace {
+    WindowRegistry::Geometry geometry(int x, int y, int width, int height) {
+        WindowRegistry::Geometry result;
+        result.x = x;
+        result.y = y;
+        result.width = width;
+        result.height = height;
+        return result;
+    }
+
+    SavedLayout::Node split(SavedLayout::Split type, uint32_t children, float weight = 1.0f) {
+        SavedLayout::Node node;
+        node.split = type;
+        node.children = children;
+        node.weight = weight;
+        return node;
+    }
+
+    SavedLayout::Node leaf(float weight = 1.0f) {
+        return split(SavedLayout::Split::Leaf, 0, weight);
+    }
+
+    SavedLayout::Rule rule(const std::string& appId, const std::string& title, uint32_t workspace, int32_t leafIndex) {
+        SavedLayout::Rule result;
+        result.appId = appId;
+        result.title = title;
+        result.workspace = workspace;
+        result.leaf = leafIndex;
+        return result;
+    }
+
+    LayoutWindow window(uint32_t id, std::string_view appId, std::string_view title = std::string_view()) {
+        LayoutWindow result;
+        result.id = id;
+        result.appId = appId;
+        result.title = title;
+        return result;
+    }
+
+    bool operator==(const WindowRegistry::Geometry& a, const WindowRegistry::Geometry& b) {
+        return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+    }
+
+    /*
+     * Workspace 1: an editor taking two thirds of the screen, two terminals stacked on the right.
+     * Workspace 2: a floating browser only.
+     */
+    SavedLayout sampleLayout() {
+        SavedLayout layout;
+
+        SavedLayout::Workspace coding;
+        coding.id = 1;
+        coding.area = geometry(0, 0, 1920, 1080);
+        coding.nodes = {
+            split(SavedLayout::Split::Horizontal, 2),
+            leaf(2.0f),
+            split(SavedLayout::Split::Vertical, 2),
+            leaf(),
+            leaf()
+        };
+        layout.workspaces.push_back(coding);
+
+        SavedLayout::Workspace browsing;
+        browsing.id = 2;
+        browsing.area = geometry(0, 0, 1920, 1080);
+        layout.workspaces.push_back(browsing);
+
+        layout.rules.push_back(rule("editor", "", 1, 1));
+        layout.rules.push_back(rule("terminal", "build", 1, 3));
+        layout.rules.push_back(rule("terminal", "", 1, 4));
+
+        SavedLayout::Rule browser = rule("browser", "", 2, -1);
+        browser.geometry = geometry(100, 100, 1280, 800);
+        browser.flags = WindowRegistry::Visible | WindowRegistry::Maximized;
+        layout.rules.push_back(browser);
+        return layout;
+    }
+}
+
+TEST(LayoutArchiveTest, RoundTripsLayouts) {
+    const std::vector<uint8_t> data = LayoutArchive::serialize(sampleLayout());
+    ASSERT_FALSE(data.empty());
+
+    LayoutArchive archive;
+    ASSERT_TRUE(archive.open(data.data(), data.size()));
+    EXPECT_EQ(archive.fileVersion(), LayoutArchive::version);
+    EXPECT_EQ(archive.workspaceCount(), 2u);
+    EXPECT_EQ(archive.nodeCount(), 5u);
+    EXPECT_EQ(archive.ruleCount(), 4u);
+    EXPECT_EQ(archive.rule(1).appId, "terminal");
+    EXPECT_EQ(archive.rule(1).title, "build");
+
+    // Weights are stored as shares of the parent
+    const SavedLayout copy = archive.toLayout();
+    ASSERT_EQ(copy.workspaces.size(), 2u);
+    EXPECT_FLOAT_EQ(copy.workspaces[0].nodes[1].weight, 2.0f / 3.0f);
+    EXPECT_EQ(copy.rules[2].leaf, 4);
+    EXPECT_EQ(copy.rules[3].leaf, -1);
+    EXPECT_EQ(LayoutArchive::serialize(copy), data);
+}
+
+TEST(LayoutArchiveTest, PlacesWindowsByRules) {
+    const std::vector<uint8_t> data = LayoutArchive::serialize(sampleLayout());
+    LayoutArchive archive;
+    ASSERT_TRUE(archive.open(data.data(), data.size()));
+
+    // The build terminal finds its own rule even after the other terminal
+    const std::vector<LayoutPlacement> placements = archive.place({
+        window(10, "terminal", "shell"),
+        window(11, "editor"),
+        window(12, "terminal", "build"),
+        window(13, "browser"),
+        window(14, "player")
+    });
+    ASSERT_EQ(placements.size(), 4u);
+
+    EXPECT_EQ(placements[0].window, 10u);
+    EXPECT_TRUE(placements[0].geometry == geometry(1280, 540, 640, 540));
+    EXPECT_EQ(placements[1].window, 11u);
+    EXPECT_TRUE(placements[1].geometry == geometry(0, 0, 1280, 1080));
+    EXPECT_EQ(placements[2].window, 12u);
+    EXPECT_TRUE(placements[2].geometry == geometry(1280, 0, 640, 540));
+    EXPECT_EQ(placements[3].workspace, 2u);
+    EXPECT_TRUE(placements[3].geometry == geometry(100, 100, 1280, 800));
+    EXPECT_EQ(placements[3].flags, uint32_t(WindowRegistry::Visible | WindowRegistry::Maximized));
+
+    // Applied to the registered windows in one go
+    WindowRegistry registry;
+    registry.insert(10, geometry(0, 0, 10, 10), 3);
+    registry.insert(13, geometry(0, 0, 10, 10), 3);
+    EXPECT_EQ(LayoutArchive::apply(placements, registry), 2u);
+    EXPECT_EQ(registry.workspace(registry.find(10)), 1u);
+    EXPECT_TRUE(registry.geometry(registry.find(13)) == geometry(100, 100, 1280, 800));
+    EXPECT_EQ(registry.flags(registry.find(13)), uint32_t(WindowRegistry::Visible | WindowRegistry::Maximized));
+}
+
+TEST(LayoutArchiveTest, RejectsMalformedLayouts) {
+    SavedLayout layout = sampleLayout();
+    layout.rules.push_back(rule("editor", "", 7, -1));
+    EXPECT_TRUE(LayoutArchive::serialize(layout).empty());
+
+    layout = sampleLayout();
+    layout.rules.push_back(rule("editor", "", 1, 2));
+    EXPECT_TRUE(LayoutArchive::serialize(layout).empty());
+
+    layout = sampleLayout();
+    layout.workspaces[0].nodes.push_back(leaf());
+    EXPECT_TRUE(LayoutArchive::serialize(layout).empty());
+}
+
+TEST(LayoutArchiveTest, RejectsDamagedFiles) {
+    const std::vector<uint8_t> data = LayoutArchive::serialize(sampleLayout());
+    LayoutArchive archive;
+
+    std::vector<uint8_t> damaged = data;
+    damaged[damaged.size() - 1] ^= 0xff;
+    EXPECT_FALSE(archive.open(damaged.data(), damaged.size()));
+    EXPECT_FALSE(archive.isOpen());
+
+    EXPECT_FALSE(archive.open(data.data(), data.size() - 1));
+
+    // A newer, incompatible version
+    damaged = data;
+    damaged[4] = LayoutArchive::version + 1;
+    EXPECT_FALSE(archive.open(damaged.data(), damaged.size()));
+
+    EXPECT_TRUE(archive.open(data.data(), data.size()));
+}
+
+TEST(LayoutArchiveTest, ReadsNewerMinorVersions) {
+    const std::vector<uint8_t> data = LayoutArchive::serialize(sampleLayout());
+    auto get32 = [&](size_t offset) {
+        uint32_t value;
+        std::memcpy(&value, data.data() + offset, sizeof(value));
+        return value;
+    };
+    auto put16 = [](std::vector<uint8_t>& out, size_t offset, uint16_t value) {
+        std::memcpy(out.data() + offset, &value, sizeof(value));
+    };
+
+    // A later minor version appended four bytes to every rule
+    const size_t headerSize = 40;
+    const size_t rules = headerSize + get32(12) * 28 + get32(16) * 12;
+    std::vector<uint8_t> newer(data.begin(), data.begin() + rules);
+    for (uint32_t i = 0; i < get32(20); ++i) {
+        const auto from = data.begin() + rules + i * 44;
+        newer.insert(newer.end(), from, from + 44);
+        newer.insert(newer.end(), { 0xaa, 0xbb, 0xcc, 0xdd });
+    }
+    newer.insert(newer.end(), data.begin() + rules + get32(20) * 44, data.end());
+    put16(newer, 32, 48);
+    put16(newer, 34, LayoutArchive::minorVersion + 1);
+
+    // FNV-1a over everything after the header
+    uint32_t sum = 2166136261u;
+    for (size_t i = headerSize; i < newer.size(); ++i) {
+        sum = (sum ^ newer[i]) * 16777619u;
+    }
+    std::memcpy(newer.data() + 36, &sum, sizeof(sum));
+
+    LayoutArchive archive;
+    ASSERT_TRUE(archive.open(newer.data(), newer.size()));
+    EXPECT_EQ(archive.fileVersion(), LayoutArchive::version);
+    EXPECT_EQ(archive.fileMinorVersion(), LayoutArchive::minorVersion + 1);
+    EXPECT_EQ(archive.ruleCount(), 4u);
+    EXPECT_EQ(archive.rule(3).appId, "browser");
+
+    // Records smaller than this version's can't be read
+    put16(newer, 32, 40);
+    EXPECT_FALSE(archive.open(newer.data(), newer.size()));
+}
+
+TEST(LayoutArchiveTest, SavesAndMapsFiles) {
+    char path[] = "/tmp/vivox-layout-XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    ASSERT_TRUE(LayoutArchive::save(sampleLayout(), path));
+    {
+        LayoutArchive archive;
+        ASSERT_TRUE(archive.open(std::string(path)));
+        EXPECT_EQ(archive.ruleCount(), 4u);
+        EXPECT_EQ(archive.rule(3).appId, "browser");
+    }
+
+    std::remove(path);
+    LayoutArchive missing;
+    EXPECT_FALSE(missing.open(std::string(path)));
+}
+
+TEST(LayoutArchiveTest, SaveLoadBenchmark) {
+    const uint32_t workspaces = 32;
+    const uint32_t windowsPerWorkspace = 16;
+
+    // Every workspace splits into columns of stacked windows
+    SavedLayout layout;
+    for (uint32_t w = 1; w <= workspaces; ++w) {
+        SavedLayout::Workspace workspace;
+        workspace.id = w;
+        workspace.area = geometry(0, 0, 3840, 2160);
+        workspace.nodes.push_back(split(SavedLayout::Split::Horizontal, 4));
+        for (int column = 0; column < 4; ++column) {
+            workspace.nodes.push_back(split(SavedLayout::Split::Vertical, windowsPerWorkspace / 4, 1.0f + column));
+            for (uint32_t row = 0; row < windowsPerWorkspace / 4; ++row) {
+                layout.rules.push_back(rule("app" + std::to_string(row), "window " + std::to_string(layout.rules.size()),
+                                            w, static_cast<int32_t>(workspace.nodes.size())));
+                workspace.nodes.push_back(leaf());
+            }
+        }
+        layout.workspaces.push_back(workspace);
+    }
+
+    std::vector<LayoutWindow> windows;
+    for (size_t i = 0; i < layout.rules.size(); ++i) {
+        windows.push_back(window(static_cast<uint32_t>(i + 1), layout.rules[i].appId, layout.rules[i].title));
+    }
+
+    char path[] = "/tmp/vivox-layout-XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(LayoutArchive::save(layout, path));
+    const auto saved = std::chrono::steady_clock::now();
+
+    LayoutArchive archive;
+    ASSERT_TRUE(archive.open(std::string(path)));
+    const auto loaded = std::chrono::steady_clock::now();
+
+    const std::vector<LayoutPlacement> placements = archive.place(windows);
+    const auto placed = std::chrono::steady_clock::now();
+
+    ASSERT_EQ(placements.size(), windows.size());
+    for (size_t i = 0; i < placements.size(); ++i) {
+        ASSERT_EQ(placements[i].window, windows[i].id);
+        ASSERT_EQ(placements[i].workspace, layout.rules[i].workspace);
+        ASSERT_GT(placements[i].geometry.width, 0);
+        ASSERT_GT(placements[i].geometry.height, 0);
+    }
+
+    struct stat info;
+    ASSERT_EQ(stat(path, &info), 0);
+    std::remove(path);
+
+    RecordProperty("windows", static_cast<int>(windows.size()));
+    RecordProperty("workspaces", static_cast<int>(workspaces));
+    RecordProperty("fileBytes", static_cast<int>(info.st_size));
+    RecordProperty("saveUs", static_cast<int>(microseconds(start, saved)));
+    RecordProperty("loadUs", static_cast<int>(microseconds(saved, loaded)));
+    RecordProperty("placeUs", static_cast<int>(microseconds(loaded, placed)));
+}
@@ -0,0 +1,263 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "window_manager/windows/WindowRegistry.h"
+
+#include <chrono>
+#include <map>
+#include <random>
+#include <set>
+
+using namespace VivoX::WindowManager::Windows;
+using namespace testing;
+
+namespace {
+    WindowRegistry::Geometry geometry(int x, int y, int width = 640, int height = 480) {
+        WindowRegistry::Geometry result;
+        result.x = x;
+        result.y = y;
+        result.width = width;
+        result.height = height;
+        return result;
+    }
+
+    std::set<uint32_t> idsOf(const WindowRegistry& registry, WindowRegistry::Range<WindowHandle> handles) {
+        std::set<uint32_t> ids;
+        for (const WindowHandle& handle : handles) {
+            ids.insert(registry.id(handle));
+        }
+        return ids;
+    }
+}
+
+class WindowRegistryTest : public Test {
+protected:
+    WindowRegistry m_registry;
+};
+
+TEST_F(WindowRegistryTest, FindsWindowsById) {
+    const WindowHandle a = m_registry.insert(1, geometry(0, 0), 1);
+    const WindowHandle b = m_registry.insert(2, geometry(10, 20), 1);
+
+    EXPECT_EQ(m_registry.find(1), a);
+    EXPECT_EQ(m_registry.find(2), b);
+    EXPECT_TRUE(m_registry.find(3).isNull());
+    EXPECT_EQ(m_registry.geometry(b).y, 20);
+    EXPECT_EQ(m_registry.size(), 2u);
+
+    // IDs are unique
+    EXPECT_TRUE(m_registry.insert(2, geometry(0, 0), 1).isNull());
+    EXPECT_EQ(m_registry.size(), 2u);
+}
+
+TEST_F(WindowRegistryTest, HandlesGoStaleWhenSlotsAreReused) {
+    const WindowHandle old = m_registry.insert(1, geometry(0, 0), 1);
+    ASSERT_TRUE(m_registry.remove(old));
+    EXPECT_FALSE(m_registry.remove(old));
+
+    const WindowHandle reused = m_registry.insert(2, geometry(5, 5), 1);
+    EXPECT_EQ(reused.index, old.index);
+    EXPECT_NE(reused, old);
+
+    EXPECT_FALSE(m_registry.contains(old));
+    EXPECT_EQ(m_registry.id(old), 0u);
+    EXPECT_FALSE(m_registry.move(old, 100, 100));
+    EXPECT_EQ(m_registry.geometry(reused).x, 5);
+
+    // Clearing keeps handed out handles stale as well
+    m_registry.clear();
+    EXPECT_FALSE(m_registry.contains(reused));
+    EXPECT_NE(m_registry.insert(3, geometry(0, 0), 1), reused);
+}
+
+TEST_F(WindowRegistryTest, KeepsHotDataPacked) {
+    std::vector<WindowHandle> handles;
+    for (uint32_t id = 1; id <= 10; ++id) {
+        handles.push_back(m_registry.insert(id, geometry(static_cast<int>(id) * 10, 0), 1));
+    }
+    m_registry.remove(handles[0]);
+    m_registry.remove(handles[4]);
+
+    ASSERT_EQ(m_registry.handles().size(), 8u);
+    ASSERT_EQ(m_registry.geometries().size(), 8u);
+    for (size_t i = 0; i < m_registry.handles().size(); ++i) {
+        const WindowHandle handle = m_registry.handles()[i];
+        EXPECT_EQ(m_registry.geometries()[i].x, static_cast<int>(m_registry.id(handle)) * 10);
+        EXPECT_EQ(m_registry.stackPositions()[i], m_registry.z(handle));
+        EXPECT_EQ(m_registry.allFlags()[i], static_cast<uint32_t>(WindowRegistry::Visible));
+        EXPECT_EQ(m_registry.workspaces()[i], 1u);
+    }
+}
+
+TEST_F(WindowRegistryTest, IndexesWorkspaces) {
+    const WindowHandle a = m_registry.insert(1, geometry(0, 0), 1);
+    const WindowHandle b = m_registry.insert(2, geometry(0, 0), 1);
+    const WindowHandle c = m_registry.insert(3, geometry(0, 0), 2);
+
+    EXPECT_EQ(idsOf(m_registry, m_registry.windowsOnWorkspace(1)), std::set<uint32_t>({ 1, 2 }));
+    EXPECT_TRUE(m_registry.windowsOnWorkspace(7).empty());
+
+    m_registry.setWorkspace(a, 2);
+    EXPECT_EQ(m_registry.workspace(a), 2u);
+    EXPECT_EQ(idsOf(m_registry, m_registry.windowsOnWorkspace(1)), std::set<uint32_t>({ 2 }));
+    EXPECT_EQ(idsOf(m_registry, m_registry.windowsOnWorkspace(2)), std::set<uint32_t>({ 1, 3 }));
+
+    m_registry.remove(c);
+    m_registry.remove(b);
+    EXPECT_EQ(idsOf(m_registry, m_registry.windowsOnWorkspace(2)), std::set<uint32_t>({ 1 }));
+    EXPECT_TRUE(m_registry.windowsOnWorkspace(1).empty());
+}
+
+TEST_F(WindowRegistryTest, IndexesGroups) {
+    const WindowHandle a = m_registry.insert(1, geometry(0, 0), 1);
+    const WindowHandle b = m_registry.insert(2, geometry(0, 0), 1);
+    const WindowHandle c = m_registry.insert(3, geometry(0, 0), 1);
+
+    EXPECT_TRUE(m_registry.addToGroup(a, 10));
+    EXPECT_TRUE(m_registry.addToGroup(b, 10));
+    EXPECT_TRUE(m_registry.addToGroup(c, 10));
+    EXPECT_TRUE(m_registry.addToGroup(b, 20));
+    EXPECT_FALSE(m_registry.addToGroup(b, 20));
+
+    EXPECT_THAT(std::vector<uint32_t>(m_registry.groupsOf(b).begin(), m_registry.groupsOf(b).end()),
+                UnorderedElementsAre(10u, 20u));
+
+    EXPECT_TRUE(m_registry.removeFromGroup(a, 10));
+    EXPECT_FALSE(m_registry.removeFromGroup(a, 10));
+    EXPECT_FALSE(m_registry.isInGroup(a, 10));
+    EXPECT_EQ(idsOf(m_registry, m_registry.windowsInGroup(10)), std::set<uint32_t>({ 2, 3 }));
+
+    // Removing a window takes it out of all of its groups
+    m_registry.remove(b);
+    EXPECT_EQ(idsOf(m_registry, m_registry.windowsInGroup(10)), std::set<uint32_t>({ 3 }));
+    EXPECT_TRUE(m_registry.windowsInGroup(20).empty());
+    EXPECT_TRUE(m_registry.isInGroup(c, 10));
+
+    EXPECT_EQ(m_registry.removeGroup(10), 1u);
+    EXPECT_TRUE(m_registry.groupsOf(c).empty());
+    EXPECT_EQ(m_registry.removeGroup(10), 0u);
+}
+
+TEST_F(WindowRegistryTest, TracksStackingOrder) {
+    const WindowHandle a = m_registry.insert(1, geometry(0, 0), 1);
+    const WindowHandle b = m_registry.insert(2, geometry(0, 0), 1);
+    const WindowHandle c = m_registry.insert(3, geometry(0, 0), 1);
+
+    std::vector<WindowHandle> order;
+    m_registry.stackingOrder(order);
+    EXPECT_THAT(order, ElementsAre(a, b, c));
+
+    m_registry.raise(a);
+    m_registry.lower(c);
+    m_registry.stackingOrder(order);
+    EXPECT_THAT(order, ElementsAre(c, b, a));
+
+    // The buffer is reused
+    const WindowHandle* data = order.data();
+    m_registry.remove(b);
+    m_registry.stackingOrder(order);
+    EXPECT_THAT(order, ElementsAre(c, a));
+    EXPECT_EQ(order.data(), data);
+
+    EXPECT_EQ(m_registry.topmost(1), a);
+    m_registry.setFlags(a, WindowRegistry::Visible | WindowRegistry::Minimized);
+    EXPECT_EQ(m_registry.topmost(1, WindowRegistry::Minimized), c);
+    EXPECT_TRUE(m_registry.topmost(2).isNull());
+}
+
+TEST_F(WindowRegistryTest, StressBenchmark) {
+    const int cycles = 5000;
+    const uint32_t workspaces = 8;
+    const uint32_t groups = 32;
+
+    // Reference model the registry is checked against
+    struct Model {
+        uint32_t id;
+        WindowHandle handle;
+        int x;
+        uint32_t workspace;
+        std::set<uint32_t> groups;
+    };
+    std::vector<Model> model;
+    std::vector<WindowHandle> stale;
+
+    std::mt19937 random(42);
+    uint32_t nextId = 1;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        // Create
+        const uint32_t id = nextId++;
+        const uint32_t workspace = 1 + random() % workspaces;
+        Model entry = { id, m_registry.insert(id, geometry(cycle, 0), workspace), cycle, workspace, {} };
+        ASSERT_FALSE(entry.handle.isNull());
+        for (int i = 0; i < 2; ++i) {
+            const uint32_t group = 1 + random() % groups;
+            if (m_registry.addToGroup(entry.handle, group)) {
+                entry.groups.insert(group);
+            }
+        }
+        model.push_back(entry);
+
+        // Move one window on screen and one to another workspace
+        Model& moved = model[random() % model.size()];
+        moved.x = static_cast<int>(random() % 4000);
+        ASSERT_TRUE(m_registry.move(moved.handle, moved.x, 0));
+        m_registry.raise(moved.handle);
+
+        Model& switched = model[random() % model.size()];
+        switched.workspace = 1 + random() % workspaces;
+        ASSERT_TRUE(m_registry.setWorkspace(switched.handle, switched.workspace));
+
+        // Destroy, keeping the population around a thousand windows
+        if (model.size() > 1000 || random() % 3 == 0) {
+            const size_t victim = random() % model.size();
+            ASSERT_TRUE(m_registry.remove(model[victim].handle));
+            stale.push_back(model[victim].handle);
+            model[victim] = model.back();
+            model.pop_back();
+        }
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    ASSERT_EQ(m_registry.size(), model.size());
+    std::map<uint32_t, const Model*> byId;
+    for (const Model& entry : model) {
+        byId[entry.id] = &entry;
+        ASSERT_EQ(m_registry.find(entry.id), entry.handle);
+        ASSERT_EQ(m_registry.geometry(entry.handle).x, entry.x);
+        ASSERT_EQ(m_registry.workspace(entry.handle), entry.workspace);
+        ASSERT_EQ(std::set<uint32_t>(m_registry.groupsOf(entry.handle).begin(), m_registry.groupsOf(entry.handle).end()),
+                  entry.groups);
+    }
+    for (const WindowHandle& handle : stale) {
+        ASSERT_FALSE(m_registry.contains(handle));
+    }
+
+    size_t onWorkspaces = 0;
+    for (uint32_t workspace = 1; workspace <= workspaces; ++workspace) {
+        for (const WindowHandle& handle : m_registry.windowsOnWorkspace(workspace)) {
+            ASSERT_EQ(m_registry.workspace(handle), workspace);
+            onWorkspaces++;
+        }
+    }
+    EXPECT_EQ(onWorkspaces, model.size());
+
+    size_t memberships = 0;
+    for (uint32_t group = 1; group <= groups; ++group) {
+        for (const WindowHandle& handle : m_registry.windowsInGroup(group)) {
+            ASSERT_TRUE(byId.at(m_registry.id(handle))->groups.count(group));
+            memberships++;
+        }
+    }
+    size_t expectedMemberships = 0;
+    for (const Model& entry : model) {
+        expectedMemberships += entry.groups.size();
+    }
+    EXPECT_EQ(memberships, expectedMemberships);
+
+    RecordProperty("cycles", cycles);
+    RecordProperty("elapsedUs", static_cast<int>(elapsed));
+    RecordProperty("windowsLeft", static_cast<int>(model.size()));
+}
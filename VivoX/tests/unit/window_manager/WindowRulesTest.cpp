@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include "window_manager/windows/WindowRules.h"
+#include "core/configuration/ConfigManager.h"
+#include "tests/unit/TestSupport.h"
+
+#include <chrono>
+#include <string>
+
+using namespace VivoX::WindowManager::Windows;
+using namespace VivoX::Testing;
+using namespace testing;
+
+namespace {
+    WindowRule rule(const std::string& name, const std::string& appId, int priority = 0) {
+        WindowRule result;
+        result.name = name;
+        result.appId = appId;
+        result.priority = priority;
+        return result;
+    }
+
+    WindowRuleQuery query(std::string_view appId, std::string_view title = std::string_view(),
+                          WindowType type = WindowType::Normal, std::string_view output = std::string_view()) {
+        WindowRuleQuery result;
+        result.appId = appId;
+        result.title = title;
+        result.type = type;
+        result.output = output;
+        return result;
+    }
+
+    uint32_t typeMask(WindowType type) {
+        return 1u << static_cast<uint32_t>(type);
+    }
+}
+
+TEST(WindowRulesTest, MergesRulesByPriority) {
+    WindowRule terminal = rule("terminal", "terminal", 10);
+    terminal.workspace = 3;
+    terminal.floating = false;
+
+    WindowRule everything = rule("everything", "");
+    everything.workspace = 1;
+    everything.opacity = 0.9f;
+
+    WindowRules rules;
+    EXPECT_EQ(rules.setRules({ terminal, everything }), 2u);
+    EXPECT_EQ(rules.getRules().front().name, "everything");
+
+    WindowRuleResult result = rules.evaluate(query("terminal"));
+    EXPECT_EQ(result.matchedRules, 2u);
+    EXPECT_EQ(result.workspace, 3u);
+    EXPECT_EQ(result.floating, false);
+    EXPECT_FLOAT_EQ(result.opacity.value_or(0.0f), 0.9f);
+
+    result = rules.evaluate(query("editor"));
+    EXPECT_EQ(result.matchedRules, 1u);
+    EXPECT_EQ(result.workspace, 1u);
+    EXPECT_FALSE(result.floating.has_value());
+}
+
+TEST(WindowRulesTest, MatchesTitleTypeAndOutput) {
+    WindowRule pictureInPicture = rule("pip", "browser");
+    pictureInPicture.title = "^Picture-in-Picture$";
+    pictureInPicture.floating = true;
+
+    WindowRule dialogs = rule("dialogs", "");
+    dialogs.types = typeMask(WindowType::Dialog) | typeMask(WindowType::Utility);
+    dialogs.floating = true;
+
+    WindowRule external = rule("external", "");
+    external.output = "HDMI-1";
+    external.workspace = 5;
+
+    WindowRules rules;
+    ASSERT_EQ(rules.setRules({ pictureInPicture, dialogs, external }), 3u);
+
+    EXPECT_EQ(rules.evaluate(query("browser", "Picture-in-Picture")).floating, true);
+    EXPECT_EQ(rules.evaluate(query("browser", "Picture-in-Picture - Video")).matchedRules, 0u);
+    EXPECT_EQ(rules.evaluate(query("player", "", WindowType::Dialog)).floating, true);
+    EXPECT_EQ(rules.evaluate(query("player", "", WindowType::Popup)).matchedRules, 0u);
+    EXPECT_EQ(rules.evaluate(query("player", "", WindowType::Normal, "HDMI-1")).workspace, 5u);
+    EXPECT_EQ(rules.evaluate(query("player", "", WindowType::Normal, "eDP-1")).matchedRules, 0u);
+}
+
+TEST(WindowRulesTest, CachesApplicationsUntilRulesChange) {
+    WindowRule editor = rule("editor", "editor");
+    editor.workspace = 2;
+
+    WindowRule build = rule("build", "terminal");
+    build.title = "make|ninja";
+    build.workspace = 4;
+
+    WindowRules rules;
+    rules.setRules({ editor, build });
+
+    rules.evaluate(query("editor", "a.cpp"));
+    rules.evaluate(query("editor", "b.cpp"));
+    rules.evaluate(query("terminal", "ninja -C build"));
+    EXPECT_EQ(rules.evaluate(query("terminal", "bash")).matchedRules, 0u);
+
+    WindowRules::Stats stats = rules.getStats();
+    EXPECT_EQ(stats.evaluations, 4u);
+    EXPECT_EQ(stats.cachedEntries, 2u);
+    EXPECT_EQ(stats.cacheHits, 2u);
+    EXPECT_EQ(stats.titleMatches, 2u);
+
+    // New rules drop the cached outcomes
+    editor.workspace = 6;
+    rules.setRules({ editor });
+    EXPECT_EQ(rules.getStats().cachedEntries, 0u);
+    EXPECT_EQ(rules.getStats().generation, 2u);
+    EXPECT_EQ(rules.evaluate(query("editor")).workspace, 6u);
+}
+
+TEST(WindowRulesTest, RejectsInvalidRules) {
+    WindowRule broken = rule("broken", "terminal");
+    broken.title = "([unclosed";
+
+    WindowRule tooManyEffects = rule("effects", "player");
+    for (int i = 0; i < 65; ++i) {
+        tooManyEffects.effects.push_back("effect" + std::to_string(i));
+    }
+
+    WindowRules rules;
+    EXPECT_EQ(rules.setRules({ broken, tooManyEffects, rule("valid", "editor") }), 1u);
+    EXPECT_EQ(rules.getStats().rejectedRules, 2u);
+    EXPECT_EQ(rules.evaluate(query("terminal", "([unclosed")).matchedRules, 0u);
+}
+
+TEST(WindowRulesTest, CombinesEffects) {
+    WindowRule blur = rule("blur", "");
+    blur.effects = { "blur" };
+
+    WindowRule terminal = rule("terminal", "terminal");
+    terminal.effects = { "shadow", "blur" };
+
+    WindowRules rules;
+    rules.setRules({ blur, terminal });
+
+    const int blurId = rules.effectId("blur");
+    const int shadowId = rules.effectId("shadow");
+    ASSERT_GE(blurId, 0);
+    ASSERT_GE(shadowId, 0);
+    EXPECT_EQ(rules.effectName(shadowId), "shadow");
+    EXPECT_EQ(rules.effectId("wobble"), -1);
+
+    EXPECT_EQ(rules.evaluate(query("terminal")).effects, (uint64_t(1) << blurId) | (uint64_t(1) << shadowId));
+    EXPECT_EQ(rules.evaluate(query("editor")).effects, uint64_t(1) << blurId);
+}
+
+TEST(WindowRulesTest, LoadsRulesFromConfig) {
+    auto config = VivoX::Core::Configuration::ConfigManager::getInstance();
+    config->setValue<std::string>("test.windowRules.terminal.appId", "terminal");
+    config->setValue<int>("test.windowRules.terminal.workspace", 2);
+    config->setValue<double>("test.windowRules.terminal.opacity", 0.8);
+    config->setValue<std::string>("test.windowRules.terminal.effects", "[\"blur\"]");
+    config->setValue<std::string>("test.windowRules.dialogs.types", "[\"dialog\",\"splash\"]");
+    config->setValue<bool>("test.windowRules.dialogs.floating", true);
+    config->setValue<int>("test.windowRules.dialogs.geometry.width", 640);
+    config->setValue<int>("test.windowRules.dialogs.geometry.height", 480);
+    config->setValue<int>("test.windowRules.dialogs.priority", 5);
+
+    WindowRules rules;
+    ASSERT_EQ(rules.loadFromConfig(*config, "test.windowRules"), 2u);
+    EXPECT_EQ(rules.getRules().back().name, "dialogs");
+    EXPECT_EQ(rules.getRules().back().types, typeMask(WindowType::Dialog) | typeMask(WindowType::Splash));
+
+    WindowRuleResult result = rules.evaluate(query("terminal"));
+    EXPECT_EQ(result.workspace, 2u);
+    EXPECT_FLOAT_EQ(result.opacity.value_or(0.0f), 0.8f);
+    EXPECT_EQ(result.effects, uint64_t(1) << rules.effectId("blur"));
+
+    result = rules.evaluate(query("terminal", "", WindowType::Dialog));
+    EXPECT_EQ(result.floating, true);
+    ASSERT_TRUE(result.geometry.has_value());
+    EXPECT_EQ(result.geometry->width, 640);
+
+    for (const std::string& key : config->getKeysWithPrefix("test.windowRules.")) {
+        config->removeKey(key);
+    }
+}
+
+TEST(WindowRulesTest, EvaluateBenchmark) {
+    const int applications = 1000;
+    const int rulesPerApplication = 5;
+
+    // Every fifth application has a rule matching on the title
+    std::vector<WindowRule> ruleSet;
+    for (int app = 0; app < applications; ++app) {
+        for (int i = 0; i < rulesPerApplication; ++i) {
+            WindowRule current = rule("rule" + std::to_string(ruleSet.size()), "app" + std::to_string(app), i);
+            current.workspace = static_cast<uint32_t>(i + 1);
+            if (i == 0 && app % 5 == 0) {
+                current.title = "^Settings";
+                current.floating = true;
+            } else if (i == 1) {
+                current.types = typeMask(WindowType::Dialog);
+            }
+            ruleSet.push_back(current);
+        }
+    }
+    WindowRule everything = rule("everything", "");
+    everything.effects = { "shadow" };
+    ruleSet.push_back(everything);
+
+    WindowRules rules;
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(rules.setRules(ruleSet), ruleSet.size());
+    const auto compiled = std::chrono::steady_clock::now();
+
+    std::vector<std::string> appIds;
+    for (int app = 0; app < applications; ++app) {
+        appIds.push_back("app" + std::to_string(app));
+    }
+
+    const int windows = 100000;
+    uint32_t matched = 0;
+    for (int i = 0; i < windows; ++i) {
+        matched += rules.evaluate(query(appIds[i % applications], i % 7 == 0 ? "Settings" : "Document")).matchedRules;
+    }
+    const auto evaluated = std::chrono::steady_clock::now();
+
+    EXPECT_GT(matched, 0u);
+    EXPECT_EQ(rules.getStats().cacheHits, uint64_t(windows - applications));
+
+    RecordProperty("rules", static_cast<int>(ruleSet.size()));
+    RecordProperty("compileUs", static_cast<int>(microseconds(start, compiled)));
+    RecordProperty("windows", windows);
+    RecordProperty("evaluateUs", static_cast<int>(microseconds(compiled, evaluated)));
+}
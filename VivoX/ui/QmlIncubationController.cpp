@@ -0,0 +1,105 @@
+#include "QmlIncubationController.h"
+
+#include <QDebug>
+#include <QQuickWindow>
+
+namespace VivoX::UI {
+
+namespace {
+// Nominal frame interval used when no window drives incubation
+constexpr int kFallbackFrameInterval = 16;
+}
+
+QmlIncubationController::QmlIncubationController(QObject *parent)
+    : QObject(parent)
+    , m_frameBudget(4)
+{
+    m_frameTimer.setInterval(kFallbackFrameInterval);
+    connect(&m_frameTimer, &QTimer::timeout, this, &QmlIncubationController::incubateFrame);
+}
+
+QmlIncubationController::~QmlIncubationController()
+{
+    m_frameTimer.stop();
+}
+
+void QmlIncubationController::setFrameBudget(int msecs)
+{
+    if (msecs <= 0) {
+        qWarning() << "Invalid incubation frame budget:" << msecs;
+        return;
+    }
+
+    m_frameBudget = msecs;
+}
+
+int QmlIncubationController::frameBudget() const
+{
+    return m_frameBudget;
+}
+
+void QmlIncubationController::attachToWindow(QQuickWindow *window)
+{
+    if (m_windowConnection) {
+        disconnect(m_windowConnection);
+    }
+
+    m_window = window;
+
+    if (m_window) {
+        m_frameTimer.stop();
+        m_windowConnection = connect(m_window, &QQuickWindow::afterAnimating,
+                                     this, &QmlIncubationController::incubateFrame);
+    }
+
+    // Re-evaluate how incubation is driven for objects already in flight
+    incubatingObjectCountChanged(incubatingObjectCount());
+}
+
+void QmlIncubationController::incubatingObjectCountChanged(int count)
+{
+    if (count == 0) {
+        m_frameTimer.stop();
+        return;
+    }
+
+    if (m_window) {
+        // Make sure the window produces a frame so incubation can proceed
+        m_window->update();
+    } else if (!m_frameTimer.isActive()) {
+        m_frameTimer.start();
+    }
+}
+
+void QmlIncubationController::incubateFrame()
+{
+    if (incubatingObjectCount() == 0) {
+        return;
+    }
+
+    incubateFor(m_frameBudget);
+
+    // Keep requesting frames while work is pending
+    if (m_window && incubatingObjectCount() > 0) {
+        m_window->update();
+    }
+}
+
+QmlObjectIncubator::QmlObjectIncubator(Callback callback)
+    : QQmlIncubator(QQmlIncubator::Asynchronous)
+    , m_callback(std::move(callback))
+{
+}
+
+void QmlObjectIncubator::statusChanged(Status status)
+{
+    if (status != QQmlIncubator::Ready && status != QQmlIncubator::Error) {
+        return;
+    }
+
+    if (m_callback) {
+        m_callback(this);
+    }
+}
+
+} // namespace VivoX::UI
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QQmlIncubator>
+#include <QQmlIncubationController>
+#include <QTimer>
+#include <functional>
+
+class QQuickWindow;
+
+namespace VivoX::UI {
+
+/**
+ * @brief Time-sliced incubation controller for asynchronous QML object creation.
+ *
+ * Asynchronous QML creations are only advanced when the controller calls
+ * incubateFor(). This controller spends at most a fixed budget per frame on
+ * incubation, so creating large views (overview, command palette, speed dial)
+ * is spread over several frames instead of blocking a single one.
+ *
+ * When attached to a window, incubation runs after the window has animated
+ * each frame. Without a window a timer at the nominal frame interval is used.
+ */
+class QmlIncubationController : public QObject, public QQmlIncubationController {
+    Q_OBJECT
+
+public:
+    explicit QmlIncubationController(QObject *parent = nullptr);
+    ~QmlIncubationController() override;
+
+    /**
+     * @brief Set the incubation budget per frame
+     * @param msecs Maximum time in milliseconds spent incubating per frame
+     */
+    void setFrameBudget(int msecs);
+
+    /**
+     * @brief Get the incubation budget per frame
+     * @return The budget in milliseconds
+     */
+    int frameBudget() const;
+
+    /**
+     * @brief Drive incubation from the frames of a window
+     * @param window The window, or nullptr to fall back to the timer
+     */
+    void attachToWindow(QQuickWindow *window);
+
+protected:
+    void incubatingObjectCountChanged(int count) override;
+
+private slots:
+    void incubateFrame();
+
+private:
+    // Fallback frame timer used when no window is attached
+    QTimer m_frameTimer;
+
+    // Window driving the incubation, if any
+    QPointer<QQuickWindow> m_window;
+
+    // Budget per frame in milliseconds
+    int m_frameBudget;
+
+    // Connection to the window's afterAnimating signal
+    QMetaObject::Connection m_windowConnection;
+};
+
+/**
+ * @brief Incubator that reports completion through a callback.
+ */
+class QmlObjectIncubator : public QQmlIncubator {
+public:
+    using Callback = std::function<void(QmlObjectIncubator *incubator)>;
+
+    explicit QmlObjectIncubator(Callback callback);
+
+protected:
+    void statusChanged(Status status) override;
+
+private:
+    Callback m_callback;
+};
+
+} // namespace VivoX::UI
@@ -2,6 +2,8 @@
 #include "panels/Panel.h"
 #include "widgets/Widget.h"
 #include "config/Theme.h"
+#include "QmlIncubationController.h"
+#include "effects/ShadowItem.h"
 
 #include <QDebug>
 #include <QQmlComponent>
@@ -12,9 +14,16 @@
 #include <QTranslator>
 #include <QCoreApplication>
 #include <QSettings>
+#include <QCryptographicHash>
+#include <QTimer>
 
 namespace VivoX::UI {
 
+namespace {
+    // Inline components kept compiled; generated sources would otherwise accumulate forever
+    const int sourceComponentCacheSize = 64;
+}
+
 UIManager::UIManager(QObject *parent)
     : QObject(parent)
     , m_qmlEngine(nullptr)
@@ -26,6 +35,8 @@ UIManager::UIManager(QObject *parent)
     , m_accessibilityMode(false)
     , m_language("en")
     , m_nextNotificationId(1)
+    , m_sourceComponentCache(sourceComponentCacheSize)
+    , m_incubationController(nullptr)
 {
     qDebug() << "UIManager created";
 }
@@ -46,9 +57,16 @@ bool UIManager::initialize()
         return false;
     }
     
+    // Install the time-sliced incubation controller for asynchronous creation
+    m_incubationController = new QmlIncubationController(this);
+    m_qmlEngine->setIncubationController(m_incubationController);
+    
     // Register QML types
     registerQmlTypes();
     
+    // Register native effect items
+    registerQmlType<ShadowItem>("VivoX.Effects", 1, 0, "VxShadow");
+    
     // Register context properties
     registerContextProperties();
     
@@ -94,10 +112,26 @@ bool UIManager::initialize()
     QString lang = settings.value("ui/language", "en").toString();
     setLanguage(lang);
     
+    // Incubation budget per frame
+    m_incubationController->setFrameBudget(settings.value("ui/incubationBudget", 4).toInt());
+    
     qDebug() << "UIManager initialized";
     
     emit uiReady();
     
+    // Warm up frequently used views after startup
+    QStringList preloadViews = settings.value("ui/preloadViews", QStringList{
+        "qrc:/qml/views/vx_overview.qml",
+        "qrc:/qml/views/vx_command_palette.qml",
+        "qrc:/qml/views/vx_speed_dial.qml"
+    }).toStringList();
+    
+    QList<QUrl> preloadUrls;
+    for (const QString &view : preloadViews) {
+        preloadUrls.append(QUrl(view));
+    }
+    preloadQml(preloadUrls);
+    
     return true;
 }
 
@@ -125,8 +159,18 @@ void UIManager::shutdown()
     // Clear widget factories
     m_widgetFactories.clear();
     
+    // Abort pending incubations and drop compiled components before the engine goes away
+    m_preloadQueue.clear();
+    for (QmlObjectIncubator *incubator : m_incubators) {
+        incubator->clear();
+    }
+    qDeleteAll(m_incubators);
+    m_incubators.clear();
+    clearComponentCache();
+    
     // Delete QML engine
     if (m_qmlEngine) {
+        m_qmlEngine->setIncubationController(nullptr);
         delete m_qmlEngine;
         m_qmlEngine = nullptr;
     }
@@ -163,17 +207,13 @@ QObject *UIManager::loadQml(const QUrl &url)
         return nullptr;
     }
     
-    QQmlComponent component(m_qmlEngine, url);
+    QQmlComponent *component = cachedComponent(url);
     
-    if (component.isError()) {
-        qWarning() << "Failed to load QML file:" << url;
-        for (const QQmlError &error : component.errors()) {
-            qWarning() << error.toString();
-        }
+    if (!component) {
         return nullptr;
     }
     
-    QObject *object = component.create(m_qmlEngine->rootContext());
+    QObject *object = component->create(m_qmlEngine->rootContext());
     
     if (!object) {
         qWarning() << "Failed to create QML object from file:" << url;
@@ -192,18 +232,30 @@ QObject *UIManager::createQmlComponent(const QString &qml)
         return nullptr;
     }
     
-    QQmlComponent component(m_qmlEngine);
-    component.setData(qml.toUtf8(), QUrl());
+    // Look up the compiled component by source hash
+    QByteArray source = qml.toUtf8();
+    QByteArray key = QCryptographicHash::hash(source, QCryptographicHash::Sha1);
     
-    if (component.isError()) {
-        qWarning() << "Failed to create QML component";
-        for (const QQmlError &error : component.errors()) {
-            qWarning() << error.toString();
+    QQmlComponent *component = m_sourceComponentCache.object(key);
+    
+    if (!component) {
+        component = new QQmlComponent(m_qmlEngine, this);
+        component->setData(source, QUrl());
+        
+        if (component->isError()) {
+            qWarning() << "Failed to create QML component";
+            for (const QQmlError &error : component->errors()) {
+                qWarning() << error.toString();
+            }
+            delete component;
+            return nullptr;
         }
-        return nullptr;
+        
+        // Objects created from an evicted component keep working; only the compilation is lost
+        m_sourceComponentCache.insert(key, component);
     }
     
-    QObject *object = component.create(m_qmlEngine->rootContext());
+    QObject *object = component->create(m_qmlEngine->rootContext());
     
     if (!object) {
         qWarning() << "Failed to create QML object from component";
@@ -215,6 +267,177 @@ QObject *UIManager::createQmlComponent(const QString &qml)
     return object;
 }
 
+bool UIManager::createQmlAsync(const QUrl &url, std::function<void(QObject*)> callback,
+                               const QVariantMap &initialProperties)
+{
+    if (!m_qmlEngine) {
+        qWarning() << "QML engine not initialized";
+        return false;
+    }
+    
+    QQmlComponent *component = cachedComponent(url);
+    
+    if (!component) {
+        return false;
+    }
+    
+    if (component->isLoading()) {
+        // Start incubating once loading is done; a failed component is dropped by cachedComponent
+        auto connection = std::make_shared<QMetaObject::Connection>();
+        *connection = connect(component, &QQmlComponent::statusChanged, this,
+            [this, component, connection, url, callback, initialProperties](QQmlComponent::Status status) {
+                if (status == QQmlComponent::Loading) {
+                    return;
+                }
+                
+                disconnect(*connection);
+                
+                if (status == QQmlComponent::Ready) {
+                    incubate(component, url, callback, initialProperties);
+                } else if (callback) {
+                    callback(nullptr);
+                }
+            });
+        return true;
+    }
+    
+    incubate(component, url, callback, initialProperties);
+    
+    return true;
+}
+
+void UIManager::incubate(QQmlComponent *component, const QUrl &url, std::function<void(QObject*)> callback,
+                         const QVariantMap &initialProperties)
+{
+    QmlObjectIncubator *incubator = new QmlObjectIncubator(
+        [this, url, callback](QmlObjectIncubator *finished) {
+            QObject *object = nullptr;
+            
+            if (finished->isReady()) {
+                object = finished->object();
+                qDebug() << "Incubated QML file:" << url;
+            } else {
+                qWarning() << "Failed to incubate QML file:" << url;
+                for (const QQmlError &error : finished->errors()) {
+                    qWarning() << error.toString();
+                }
+            }
+            
+            // The incubator cannot be deleted from within its own status callback
+            QMetaObject::invokeMethod(this, [this, finished]() {
+                if (m_incubators.removeOne(finished)) {
+                    delete finished;
+                }
+            }, Qt::QueuedConnection);
+            
+            if (callback) {
+                callback(object);
+            }
+        });
+    
+    incubator->setInitialProperties(initialProperties);
+    m_incubators.append(incubator);
+    
+    component->create(*incubator, m_qmlEngine->rootContext());
+}
+
+QQmlComponent *UIManager::cachedComponent(const QUrl &url)
+{
+    if (!m_qmlEngine) {
+        qWarning() << "QML engine not initialized";
+        return nullptr;
+    }
+    
+    QQmlComponent *component = m_componentCache.value(url, nullptr);
+    
+    if (component) {
+        return component;
+    }
+    
+    component = new QQmlComponent(m_qmlEngine, url, QQmlComponent::PreferSynchronous, this);
+    
+    if (component->isError()) {
+        qWarning() << "Failed to load QML file:" << url;
+        for (const QQmlError &error : component->errors()) {
+            qWarning() << error.toString();
+        }
+        delete component;
+        return nullptr;
+    }
+    
+    if (component->isLoading()) {
+        connect(component, &QQmlComponent::statusChanged, this, [this, url, component](QQmlComponent::Status status) {
+            if (status != QQmlComponent::Error) {
+                return;
+            }
+            
+            qWarning() << "Failed to load QML file:" << url;
+            for (const QQmlError &error : component->errors()) {
+                qWarning() << error.toString();
+            }
+            
+            if (m_componentCache.value(url) == component) {
+                m_componentCache.remove(url);
+            }
+            component->deleteLater();
+        });
+    }
+    
+    m_componentCache.insert(url, component);
+    
+    return component;
+}
+
+void UIManager::preloadQml(const QList<QUrl> &urls)
+{
+    bool idle = m_preloadQueue.isEmpty();
+    
+    for (const QUrl &url : urls) {
+        if (!m_componentCache.contains(url) && !m_preloadQueue.contains(url)) {
+            m_preloadQueue.append(url);
+        }
+    }
+    
+    if (idle && !m_preloadQueue.isEmpty()) {
+        QTimer::singleShot(0, this, &UIManager::preloadNext);
+    }
+}
+
+void UIManager::preloadNext()
+{
+    if (m_preloadQueue.isEmpty() || !m_qmlEngine) {
+        return;
+    }
+    
+    QUrl url = m_preloadQueue.takeFirst();
+    
+    if (cachedComponent(url)) {
+        qDebug() << "Preloaded QML file:" << url;
+    }
+    
+    // Compile one file per event loop iteration
+    if (!m_preloadQueue.isEmpty()) {
+        QTimer::singleShot(0, this, &UIManager::preloadNext);
+    }
+}
+
+void UIManager::clearComponentCache()
+{
+    qDeleteAll(m_componentCache);
+    m_componentCache.clear();
+    
+    m_sourceComponentCache.clear();
+    
+    if (m_qmlEngine) {
+        m_qmlEngine->trimComponentCache();
+    }
+}
+
+QmlIncubationController *UIManager::incubationController() const
+{
+    return m_incubationController;
+}
+
 QString UIManager::currentTheme() const
 {
     return m_currentThemeName;
@@ -9,6 +9,9 @@
 #include <QColor>
 #include <QFont>
 #include <QUrl>
+#include <QCache>
+#include <QHash>
+#include <QList>
 #include <memory>
 #include <functional>
 
@@ -18,6 +21,8 @@ class Panel;
 class Widget;
 class Theme;
 class WidgetFactory;
+class QmlIncubationController;
+class QmlObjectIncubator;
 
 /**
  * @brief The UIManager class manages the UI components and their integration.
@@ -117,6 +122,53 @@ public:
      * @return The created QObject, or nullptr if creation failed
      */
     QObject *createQmlComponent(const QString &qml);
+
+    /**
+     * @brief Create a QML object asynchronously
+     *
+     * The object is incubated in time slices over several frames, after the
+     * file has finished loading if it couldn't be loaded synchronously; the
+     * callback is invoked with the created object, or nullptr on failure.
+     *
+     * @param url The URL of the QML file
+     * @param callback Callback receiving the created object
+     * @param initialProperties Properties to set before the object completes
+     * @return True if incubation was started
+     */
+    bool createQmlAsync(const QUrl &url, std::function<void(QObject*)> callback,
+                        const QVariantMap &initialProperties = QVariantMap());
+
+    /**
+     * @brief Get the compiled component for a QML file
+     *
+     * Components are compiled once and kept in a cache keyed by URL. Files
+     * that can't be loaded synchronously, e.g. remote ones, are returned
+     * while still loading and dropped from the cache if loading fails.
+     *
+     * @param url The URL of the QML file
+     * @return The component, or nullptr if compilation failed
+     */
+    QQmlComponent *cachedComponent(const QUrl &url);
+
+    /**
+     * @brief Compile QML files ahead of use
+     *
+     * Files are compiled one per event loop iteration so startup is not blocked.
+     *
+     * @param urls The URLs of the QML files
+     */
+    void preloadQml(const QList<QUrl> &urls);
+
+    /**
+     * @brief Drop all cached components
+     */
+    void clearComponentCache();
+
+    /**
+     * @brief Get the controller driving asynchronous QML incubation
+     * @return The incubation controller
+     */
+    QmlIncubationController *incubationController() const;
     
     /**
      * @brief Get the current theme name
@@ -475,6 +527,28 @@ private:
     
     // Notification counter
     int m_nextNotificationId;
+
+    // Compiled components keyed by URL
+    QHash<QUrl, QQmlComponent*> m_componentCache;
+
+    // Compiled components keyed by a hash of their source, least recently used evicted first
+    QCache<QByteArray, QQmlComponent> m_sourceComponentCache;
+
+    // Files waiting to be preloaded
+    QList<QUrl> m_preloadQueue;
+
+    // Time-sliced incubation of asynchronous creations
+    QmlIncubationController *m_incubationController;
+
+    // Incubations in flight
+    QList<QmlObjectIncubator*> m_incubators;
+
+    // Compile the next file in the preload queue
+    void preloadNext();
+    
+    // Incubate an object from a component that has finished loading
+    void incubate(QQmlComponent *component, const QUrl &url, std::function<void(QObject*)> callback,
+                  const QVariantMap &initialProperties);
     
     // Register all QML types
     void registerQmlTypes();
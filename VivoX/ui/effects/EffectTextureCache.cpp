@@ -0,0 +1,165 @@
+#include "EffectTextureCache.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QQuickWindow>
+#include <QSGTexture>
+#include <QVector>
+
+namespace VivoX::UI {
+
+namespace {
+
+struct WindowTextures {
+    QHash<QString, QSGTexture*> textures;
+};
+
+QMutex s_mutex;
+QHash<QQuickWindow*, WindowTextures> s_windowTextures;
+
+QString shadowKey(int radius, int cornerRadius, const QColor &color)
+{
+    return QString("shadow:%1:%2:%3").arg(radius).arg(cornerRadius).arg(color.rgba(), 8, 16, QChar('0'));
+}
+
+int boxRadius(int radius)
+{
+    // Three box passes of radius b have a variance of about b^2, so b ~ sigma ~ radius / 2
+    return qMax(1, (radius + 1) / 2);
+}
+
+void boxBlurLine(QRgb *data, int count, int step, int radius, QVector<QRgb> &scratch)
+{
+    const int window = radius * 2 + 1;
+    auto pixel = [&](int i) { return data[qBound(0, i, count - 1) * step]; };
+
+    int sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+    for (int i = -radius; i <= radius; ++i) {
+        QRgb p = pixel(i);
+        sumA += qAlpha(p);
+        sumR += qRed(p);
+        sumG += qGreen(p);
+        sumB += qBlue(p);
+    }
+
+    scratch.resize(count);
+    for (int i = 0; i < count; ++i) {
+        scratch[i] = qRgba(sumR / window, sumG / window, sumB / window, sumA / window);
+
+        QRgb in = pixel(i + radius + 1);
+        QRgb out = pixel(i - radius);
+        sumA += qAlpha(in) - qAlpha(out);
+        sumR += qRed(in) - qRed(out);
+        sumG += qGreen(in) - qGreen(out);
+        sumB += qBlue(in) - qBlue(out);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        data[i * step] = scratch[i];
+    }
+}
+
+} // namespace
+
+int EffectTextureCache::shadowExtent(int radius)
+{
+    return radius > 0 ? boxRadius(radius) * 3 : 0;
+}
+
+int EffectTextureCache::shadowMargin(int radius, int cornerRadius)
+{
+    return shadowExtent(radius) * 2 + qMax(0, cornerRadius);
+}
+
+void EffectTextureCache::blurImage(QImage &image, int radius)
+{
+    if (radius <= 0 || image.isNull()) {
+        return;
+    }
+
+    if (image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    const int box = boxRadius(radius);
+    const int width = image.width();
+    const int height = image.height();
+    const int stride = image.bytesPerLine() / int(sizeof(QRgb));
+    QRgb *bits = reinterpret_cast<QRgb *>(image.bits());
+    QVector<QRgb> scratch;
+
+    for (int pass = 0; pass < 3; ++pass) {
+        for (int y = 0; y < height; ++y) {
+            boxBlurLine(bits + y * stride, width, 1, box, scratch);
+        }
+        for (int x = 0; x < width; ++x) {
+            boxBlurLine(bits + x, height, stride, box, scratch);
+        }
+    }
+}
+
+QImage EffectTextureCache::createShadowImage(int radius, int cornerRadius, const QColor &color)
+{
+    // The caster is inset by the blur extent; the stretchable center is one pixel wide
+    const int extent = shadowExtent(radius);
+    const int corner = qMax(0, cornerRadius);
+    const int size = (extent + corner) * 2 + extent * 2 + 1;
+
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(color);
+    painter.drawRoundedRect(QRectF(extent, extent, size - extent * 2, size - extent * 2), corner, corner);
+    painter.end();
+
+    blurImage(image, radius);
+
+    return image;
+}
+
+QSGTexture *EffectTextureCache::shadowTexture(QQuickWindow *window, int radius, int cornerRadius, const QColor &color)
+{
+    if (!window) {
+        return nullptr;
+    }
+
+    const QString key = shadowKey(radius, cornerRadius, color);
+
+    QMutexLocker locker(&s_mutex);
+
+    if (!s_windowTextures.contains(window)) {
+        QObject::connect(window, &QQuickWindow::sceneGraphInvalidated, window,
+                         [window]() { releaseWindow(window); }, Qt::DirectConnection);
+    }
+
+    WindowTextures &entry = s_windowTextures[window];
+    QSGTexture *texture = entry.textures.value(key, nullptr);
+
+    if (!texture) {
+        texture = window->createTextureFromImage(createShadowImage(radius, cornerRadius, color));
+        texture->setFiltering(QSGTexture::Linear);
+        entry.textures.insert(key, texture);
+    }
+
+    return texture;
+}
+
+void EffectTextureCache::releaseWindow(QQuickWindow *window)
+{
+    QMutexLocker locker(&s_mutex);
+
+    auto it = s_windowTextures.find(window);
+    if (it == s_windowTextures.end()) {
+        return;
+    }
+
+    qDeleteAll(it->textures);
+    s_windowTextures.erase(it);
+}
+
+} // namespace VivoX::UI
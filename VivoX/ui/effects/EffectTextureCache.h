@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QColor>
+#include <QImage>
+
+class QQuickWindow;
+class QSGTexture;
+
+namespace VivoX::UI {
+
+/**
+ * @brief Shared textures for the native shadow item.
+ *
+ * Shadows are drawn from small nine-patch textures that are generated once
+ * per (blur radius, corner radius, color) and shared by every item in a
+ * window. N panels therefore cost N textured quads instead of N offscreen
+ * layers plus N blur passes.
+ *
+ * Texture lookups must happen on the render thread (from updatePaintNode()).
+ * Textures are released when the window's scene graph is invalidated.
+ */
+class EffectTextureCache {
+public:
+    /**
+     * @brief Get the nine-patch shadow texture for the given parameters
+     * @param window The window the texture is used in
+     * @param radius The blur radius in pixels
+     * @param cornerRadius The corner radius of the shadow caster
+     * @param color The shadow color
+     * @return The shared texture, owned by the cache
+     */
+    static QSGTexture *shadowTexture(QQuickWindow *window, int radius, int cornerRadius, const QColor &color);
+
+    /**
+     * @brief Width of the nine-patch border for a shadow
+     * @param radius The blur radius in pixels
+     * @param cornerRadius The corner radius of the shadow caster
+     * @return The border width in pixels
+     */
+    static int shadowMargin(int radius, int cornerRadius);
+
+    /**
+     * @brief Extent of the blur beyond the caster's edge
+     * @param radius The blur radius in pixels
+     * @return The extent in pixels
+     */
+    static int shadowExtent(int radius);
+
+    /**
+     * @brief Generate a nine-patch shadow image
+     * @param radius The blur radius in pixels
+     * @param cornerRadius The corner radius of the shadow caster
+     * @param color The shadow color
+     * @return The shadow image
+     */
+    static QImage createShadowImage(int radius, int cornerRadius, const QColor &color);
+
+    /**
+     * @brief Approximate a gaussian blur with three box blur passes
+     * @param image The image to blur in place
+     * @param radius The blur radius in pixels
+     */
+    static void blurImage(QImage &image, int radius);
+
+private:
+    static void releaseWindow(QQuickWindow *window);
+};
+
+} // namespace VivoX::UI
@@ -0,0 +1,215 @@
+#include "ShadowItem.h"
+#include "EffectTextureCache.h"
+
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGTextureMaterial>
+#include <QtMath>
+
+namespace VivoX::UI {
+
+namespace {
+
+// A nine-patch is a 4x4 vertex grid drawn as 9 cells of 2 triangles
+constexpr int kGridSize = 4;
+constexpr int kVertexCount = kGridSize * kGridSize;
+constexpr int kIndexCount = 9 * 6;
+
+void fillNinePatchGeometry(QSGGeometry *geometry, const QRectF &rect, qreal margin,
+                           const QRectF &sourceRect, const QSizeF &sourceMargin)
+{
+    // Shrink the border if the rect is smaller than two margins
+    const qreal mx = qMin(margin, rect.width() / 2);
+    const qreal my = qMin(margin, rect.height() / 2);
+    const qreal ux = margin > 0 ? sourceMargin.width() * (mx / margin) : 0;
+    const qreal uy = margin > 0 ? sourceMargin.height() * (my / margin) : 0;
+
+    const qreal xs[kGridSize] = { rect.left(), rect.left() + mx, rect.right() - mx, rect.right() };
+    const qreal ys[kGridSize] = { rect.top(), rect.top() + my, rect.bottom() - my, rect.bottom() };
+    const qreal us[kGridSize] = { sourceRect.left(), sourceRect.left() + ux, sourceRect.right() - ux, sourceRect.right() };
+    const qreal vs[kGridSize] = { sourceRect.top(), sourceRect.top() + uy, sourceRect.bottom() - uy, sourceRect.bottom() };
+
+    QSGGeometry::TexturedPoint2D *vertices = geometry->vertexDataAsTexturedPoint2D();
+    for (int row = 0; row < kGridSize; ++row) {
+        for (int column = 0; column < kGridSize; ++column) {
+            vertices[row * kGridSize + column].set(xs[column], ys[row], us[column], vs[row]);
+        }
+    }
+
+    quint16 *indices = geometry->indexDataAsUShort();
+    for (int row = 0; row < kGridSize - 1; ++row) {
+        for (int column = 0; column < kGridSize - 1; ++column) {
+            const quint16 topLeft = quint16(row * kGridSize + column);
+            const quint16 topRight = quint16(topLeft + 1);
+            const quint16 bottomLeft = quint16(topLeft + kGridSize);
+            const quint16 bottomRight = quint16(bottomLeft + 1);
+            *indices++ = topLeft;
+            *indices++ = bottomLeft;
+            *indices++ = topRight;
+            *indices++ = topRight;
+            *indices++ = bottomLeft;
+            *indices++ = bottomRight;
+        }
+    }
+}
+
+} // namespace
+
+ShadowItem::ShadowItem(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_radius(8)
+    , m_cornerRadius(0)
+    , m_horizontalOffset(0)
+    , m_verticalOffset(0)
+    , m_color(0, 0, 0, 0x30)
+{
+    setFlag(ItemHasContents, true);
+}
+
+qreal ShadowItem::radius() const
+{
+    return m_radius;
+}
+
+void ShadowItem::setRadius(qreal radius)
+{
+    radius = qMax<qreal>(0, radius);
+    if (m_radius == radius) {
+        return;
+    }
+
+    m_radius = radius;
+    update();
+    emit radiusChanged();
+}
+
+qreal ShadowItem::cornerRadius() const
+{
+    return m_cornerRadius;
+}
+
+void ShadowItem::setCornerRadius(qreal radius)
+{
+    radius = qMax<qreal>(0, radius);
+    if (m_cornerRadius == radius) {
+        return;
+    }
+
+    m_cornerRadius = radius;
+    update();
+    emit cornerRadiusChanged();
+}
+
+qreal ShadowItem::horizontalOffset() const
+{
+    return m_horizontalOffset;
+}
+
+void ShadowItem::setHorizontalOffset(qreal offset)
+{
+    if (m_horizontalOffset == offset) {
+        return;
+    }
+
+    m_horizontalOffset = offset;
+    update();
+    emit horizontalOffsetChanged();
+}
+
+qreal ShadowItem::verticalOffset() const
+{
+    return m_verticalOffset;
+}
+
+void ShadowItem::setVerticalOffset(qreal offset)
+{
+    if (m_verticalOffset == offset) {
+        return;
+    }
+
+    m_verticalOffset = offset;
+    update();
+    emit verticalOffsetChanged();
+}
+
+QColor ShadowItem::color() const
+{
+    return m_color;
+}
+
+void ShadowItem::setColor(const QColor &color)
+{
+    if (m_color == color) {
+        return;
+    }
+
+    m_color = color;
+    update();
+    emit colorChanged();
+}
+
+void ShadowItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+
+    if (newGeometry.size() != oldGeometry.size()) {
+        update();
+    }
+}
+
+QSGNode *ShadowItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+
+    auto *node = static_cast<QSGGeometryNode *>(oldNode);
+
+    if (width() <= 0 || height() <= 0 || m_color.alpha() == 0 || !window()) {
+        delete node;
+        return nullptr;
+    }
+
+    // Quantize parameters so similar shadows share one texture
+    const int radius = qRound(m_radius);
+    const int cornerRadius = qRound(m_cornerRadius);
+
+    QSGTexture *texture = EffectTextureCache::shadowTexture(window(), radius, cornerRadius, m_color);
+    if (!texture) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = new QSGGeometryNode;
+
+        auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(),
+                                         kVertexCount, kIndexCount, QSGGeometry::UnsignedShortType);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        node->setGeometry(geometry);
+        node->setFlag(QSGNode::OwnsGeometry);
+
+        // The material does not own the texture; it is shared through the cache
+        auto *material = new QSGTextureMaterial;
+        material->setFiltering(QSGTexture::Linear);
+        node->setMaterial(material);
+        node->setFlag(QSGNode::OwnsMaterial);
+    }
+
+    static_cast<QSGTextureMaterial *>(node->material())->setTexture(texture);
+
+    const int extent = EffectTextureCache::shadowExtent(radius);
+    const int margin = EffectTextureCache::shadowMargin(radius, cornerRadius);
+    const QRectF rect = boundingRect()
+                            .adjusted(-extent, -extent, extent, extent)
+                            .translated(m_horizontalOffset, m_verticalOffset);
+
+    const QRectF sourceRect = texture->normalizedTextureSubRect();
+    const QSizeF sourceMargin(sourceRect.width() * margin / texture->textureSize().width(),
+                              sourceRect.height() * margin / texture->textureSize().height());
+
+    fillNinePatchGeometry(node->geometry(), rect, margin, sourceRect, sourceMargin);
+    node->markDirty(QSGNode::DirtyGeometry | QSGNode::DirtyMaterial);
+
+    return node;
+}
+
+} // namespace VivoX::UI
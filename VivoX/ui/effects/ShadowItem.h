@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QColor>
+#include <QQuickItem>
+
+namespace VivoX::UI {
+
+/**
+ * @brief Native drop shadow drawn from a shared nine-patch texture.
+ *
+ * Replaces `layer.enabled` + `DropShadow` on panels and popups. The item
+ * covers the shadow caster (usually `anchors.fill: parent` with `z: -1`)
+ * and draws one textured quad grid around it; no offscreen layer or
+ * per-frame blur pass is needed.
+ *
+ * Exposed to QML as `VxShadow` in `VivoX.Effects 1.0`.
+ */
+class ShadowItem : public QQuickItem {
+    Q_OBJECT
+    Q_PROPERTY(qreal radius READ radius WRITE setRadius NOTIFY radiusChanged)
+    Q_PROPERTY(qreal cornerRadius READ cornerRadius WRITE setCornerRadius NOTIFY cornerRadiusChanged)
+    Q_PROPERTY(qreal horizontalOffset READ horizontalOffset WRITE setHorizontalOffset NOTIFY horizontalOffsetChanged)
+    Q_PROPERTY(qreal verticalOffset READ verticalOffset WRITE setVerticalOffset NOTIFY verticalOffsetChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+
+public:
+    explicit ShadowItem(QQuickItem *parent = nullptr);
+
+    qreal radius() const;
+    void setRadius(qreal radius);
+
+    qreal cornerRadius() const;
+    void setCornerRadius(qreal radius);
+
+    qreal horizontalOffset() const;
+    void setHorizontalOffset(qreal offset);
+
+    qreal verticalOffset() const;
+    void setVerticalOffset(qreal offset);
+
+    QColor color() const;
+    void setColor(const QColor &color);
+
+signals:
+    void radiusChanged();
+    void cornerRadiusChanged();
+    void horizontalOffsetChanged();
+    void verticalOffsetChanged();
+    void colorChanged();
+
+protected:
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+private:
+    qreal m_radius;
+    qreal m_cornerRadius;
+    qreal m_horizontalOffset;
+    qreal m_verticalOffset;
+    QColor m_color;
+};
+
+} // namespace VivoX::UI
@@ -4,6 +4,7 @@ import QtQuick.Layouts 1.15
 import "../ui/theme"
 import "../ui/atoms"
 import "../ui/molecules"
+import VivoX.Effects 1.0
 
 Item {
     id: root
@@ -54,12 +55,12 @@ Item {
         opacity: 0.9
         
         // Schatten
-        layer.enabled: true
-        layer.effect: DropShadow {
-            horizontalOffset: 0
+        VxShadow {
+            anchors.fill: parent
+            z: -1
+            cornerRadius: parent.radius
             verticalOffset: position === 0 ? 2 : (position === 1 ? -2 : 0) // Top: nach unten, Bottom: nach oben
             radius: 8
-            samples: 17
             color: "#30000000"
         }
     }
@@ -4,19 +4,20 @@ import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
 import "../../theme"
 import "../widgets"
+import VivoX.Effects 1.0
 
 Rectangle {
     id: sidebar
     color: ThemeManager.colorBackgroundPrimary
 
     // Schatten für die Sidebar
-    layer.enabled: true
-    layer.effect: DropShadow {
-        transparentBorder: true
+    VxShadow {
+        anchors.fill: parent
+        z: -1
+        cornerRadius: parent.radius
         horizontalOffset: 2
         verticalOffset: 0
-        radius: 8.0
-        samples: 17
+        radius: 8
         color: "#40000000"
     }
 
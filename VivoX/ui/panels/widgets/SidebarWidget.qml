@@ -3,6 +3,7 @@ import QtQuick 2.15
 import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
 import "../../theme"
+import VivoX.Effects 1.0
 
 Rectangle {
     id: root
@@ -16,13 +17,12 @@ Rectangle {
     radius: ThemeManager.cornerRadiusNormal
 
     // Schatten für das Widget
-    layer.enabled: true
-    layer.effect: DropShadow {
-        transparentBorder: true
-        horizontalOffset: 0
+    VxShadow {
+        anchors.fill: parent
+        z: -1
+        cornerRadius: parent.radius
         verticalOffset: 2
-        radius: 6.0
-        samples: 17
+        radius: 6
         color: "#30000000"
     }
 
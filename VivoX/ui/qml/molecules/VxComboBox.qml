@@ -3,6 +3,7 @@ import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
 import "../atoms"
 import "../theme"
+import VivoX.Effects 1.0
 
 ComboBox {
     id: root
@@ -129,12 +130,12 @@ ComboBox {
             border.color: VxTheme.colorBorderNormal
             
             // Schatten
-            layer.enabled: true
-            layer.effect: DropShadow {
-                horizontalOffset: 0
+            VxShadow {
+                anchors.fill: parent
+                z: -1
+                cornerRadius: parent.radius
                 verticalOffset: 3
                 radius: 8
-                samples: 17
                 color: "#30000000"
             }
         }
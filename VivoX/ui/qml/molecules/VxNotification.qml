@@ -3,6 +3,7 @@ import QtQuick.Controls 2.15
 import QtQuick.Layouts 1.15
 import "../atoms"
 import "../theme"
+import VivoX.Effects 1.0
 
 Popup {
     id: root
@@ -68,12 +69,12 @@ Popup {
         }
         
         // Schatten
-        layer.enabled: true
-        layer.effect: DropShadow {
-            horizontalOffset: 0
+        VxShadow {
+            anchors.fill: parent
+            z: -1
+            cornerRadius: parent.radius
             verticalOffset: 2
             radius: 8
-            samples: 17
             color: "#40000000"
         }
     }
@@ -17,6 +17,8 @@ ThemeManager::ThemeManager(QObject *parent)
     , m_shadowRadius(8)
     , m_spacing(8)
     , m_padding(12)
+    , m_pendingChanges(0)
+    , m_updateDepth(0)
 {
     qDebug() << "ThemeManager created";
     
@@ -44,7 +46,7 @@ void ThemeManager::setThemeName(const QString &themeName)
 {
     if (m_themeName != themeName) {
         m_themeName = themeName;
-        emit themeNameChanged(m_themeName);
+        markChanged(ThemeNameChange);
         
         qDebug() << "Theme name changed:" << m_themeName;
     }
@@ -61,10 +63,10 @@ void ThemeManager::setDarkMode(bool darkMode)
         m_darkMode = darkMode;
         
         // Update colors based on dark mode
+        beginUpdate();
         updateDerivedColors();
-        
-        emit darkModeChanged(m_darkMode);
-        emit themeChanged();
+        markChanged(DarkModeChange);
+        endUpdate();
         
         qDebug() << "Dark mode changed:" << m_darkMode;
     }
@@ -81,10 +83,10 @@ void ThemeManager::setAccentColor(const QColor &color)
         m_accentColor = color;
         
         // Update derived colors
+        beginUpdate();
         updateDerivedColors();
-        
-        emit accentColorChanged(m_accentColor);
-        emit themeChanged();
+        markChanged(AccentColorChange);
+        endUpdate();
         
         qDebug() << "Accent color changed:" << m_accentColor.name();
     }
@@ -134,8 +136,7 @@ void ThemeManager::setFontSize(int size)
 {
     if (m_fontSize != size) {
         m_fontSize = size;
-        emit fontSizeChanged(m_fontSize);
-        emit themeChanged();
+        markChanged(FontSizeChange);
         
         qDebug() << "Font size changed:" << m_fontSize;
     }
@@ -150,8 +151,7 @@ void ThemeManager::setFontFamily(const QString &family)
 {
     if (m_fontFamily != family) {
         m_fontFamily = family;
-        emit fontFamilyChanged(m_fontFamily);
-        emit themeChanged();
+        markChanged(FontFamilyChange);
         
         qDebug() << "Font family changed:" << m_fontFamily;
     }
@@ -166,8 +166,7 @@ void ThemeManager::setCornerRadius(int radius)
 {
     if (m_cornerRadius != radius) {
         m_cornerRadius = radius;
-        emit cornerRadiusChanged(m_cornerRadius);
-        emit themeChanged();
+        markChanged(CornerRadiusChange);
         
         qDebug() << "Corner radius changed:" << m_cornerRadius;
     }
@@ -182,8 +181,7 @@ void ThemeManager::setShadowRadius(int radius)
 {
     if (m_shadowRadius != radius) {
         m_shadowRadius = radius;
-        emit shadowRadiusChanged(m_shadowRadius);
-        emit themeChanged();
+        markChanged(ShadowRadiusChange);
         
         qDebug() << "Shadow radius changed:" << m_shadowRadius;
     }
@@ -198,8 +196,7 @@ void ThemeManager::setSpacing(int spacing)
 {
     if (m_spacing != spacing) {
         m_spacing = spacing;
-        emit spacingChanged(m_spacing);
-        emit themeChanged();
+        markChanged(SpacingChange);
         
         qDebug() << "Spacing changed:" << m_spacing;
     }
@@ -214,8 +211,7 @@ void ThemeManager::setPadding(int padding)
 {
     if (m_padding != padding) {
         m_padding = padding;
-        emit paddingChanged(m_padding);
-        emit themeChanged();
+        markChanged(PaddingChange);
         
         qDebug() << "Padding changed:" << m_padding;
     }
@@ -242,6 +238,9 @@ bool ThemeManager::loadTheme(const QString &filePath)
     
     QJsonObject obj = doc.object();
     
+    // Apply the whole theme as one batched update
+    beginUpdate();
+    
     // Load theme properties
     setThemeName(obj["name"].toString());
     setDarkMode(obj["darkMode"].toBool());
@@ -259,6 +258,8 @@ bool ThemeManager::loadTheme(const QString &filePath)
         setColor(it.key(), QColor(it.value().toString()));
     }
     
+    endUpdate();
+    
     qDebug() << "Loaded theme from file:" << filePath;
     
     return true;
@@ -321,29 +322,22 @@ bool ThemeManager::setColor(const QString &name, const QColor &color)
     if (name == "accent") {
         setAccentColor(color);
     } else if (name == "background") {
-        m_backgroundColor = color;
-        emit backgroundColorChanged(m_backgroundColor);
+        assignColor(m_backgroundColor, color, BackgroundColorChange);
     } else if (name == "foreground") {
-        m_foregroundColor = color;
-        emit foregroundColorChanged(m_foregroundColor);
+        assignColor(m_foregroundColor, color, ForegroundColorChange);
     } else if (name == "text") {
-        m_textColor = color;
-        emit textColorChanged(m_textColor);
+        assignColor(m_textColor, color, TextColorChange);
     } else if (name == "primary") {
-        m_primaryColor = color;
-        emit primaryColorChanged(m_primaryColor);
+        assignColor(m_primaryColor, color, PrimaryColorChange);
     } else if (name == "secondary") {
-        m_secondaryColor = color;
-        emit secondaryColorChanged(m_secondaryColor);
+        assignColor(m_secondaryColor, color, SecondaryColorChange);
     } else if (name == "highlight") {
-        m_highlightColor = color;
-        emit highlightColorChanged(m_highlightColor);
+        assignColor(m_highlightColor, color, HighlightColorChange);
     } else if (name == "shadow") {
-        m_shadowColor = color;
-        emit shadowColorChanged(m_shadowColor);
+        assignColor(m_shadowColor, color, ShadowColorChange);
     } else {
-        // For custom colors, just emit the theme changed signal
-        emit themeChanged();
+        // For custom colors, just notify a theme change
+        markChanged(CustomColorChange);
     }
     
     qDebug() << "Set color:" << name << color.name();
@@ -364,31 +358,30 @@ void ThemeManager::applyTheme()
 void ThemeManager::updateDerivedColors()
 {
     // Update derived colors based on accent color and dark mode
+    beginUpdate();
     
     if (m_darkMode) {
         // Dark theme
-        m_backgroundColor = QColor(30, 30, 30);
-        m_foregroundColor = QColor(50, 50, 50);
-        m_textColor = QColor(240, 240, 240);
-        m_shadowColor = QColor(0, 0, 0, 100);
+        assignColor(m_backgroundColor, QColor(30, 30, 30), BackgroundColorChange);
+        assignColor(m_foregroundColor, QColor(50, 50, 50), ForegroundColorChange);
+        assignColor(m_textColor, QColor(240, 240, 240), TextColorChange);
+        assignColor(m_shadowColor, QColor(0, 0, 0, 100), ShadowColorChange);
     } else {
         // Light theme
-        m_backgroundColor = QColor(240, 240, 240);
-        m_foregroundColor = QColor(255, 255, 255);
-        m_textColor = QColor(30, 30, 30);
-        m_shadowColor = QColor(0, 0, 0, 50);
+        assignColor(m_backgroundColor, QColor(240, 240, 240), BackgroundColorChange);
+        assignColor(m_foregroundColor, QColor(255, 255, 255), ForegroundColorChange);
+        assignColor(m_textColor, QColor(30, 30, 30), TextColorChange);
+        assignColor(m_shadowColor, QColor(0, 0, 0, 50), ShadowColorChange);
     }
     
     // Derive colors from accent color
-    m_primaryColor = m_accentColor;
+    assignColor(m_primaryColor, m_accentColor, PrimaryColorChange);
     
     // Create a slightly darker version of the accent color for secondary
-    QColor secondary = m_accentColor.darker(120);
-    m_secondaryColor = secondary;
+    assignColor(m_secondaryColor, m_accentColor.darker(120), SecondaryColorChange);
     
     // Create a slightly lighter version of the accent color for highlight
-    QColor highlight = m_accentColor.lighter(120);
-    m_highlightColor = highlight;
+    assignColor(m_highlightColor, m_accentColor.lighter(120), HighlightColorChange);
     
     // Update the color map
     m_colors["accent"] = m_accentColor;
@@ -400,21 +393,164 @@ void ThemeManager::updateDerivedColors()
     m_colors["highlight"] = m_highlightColor;
     m_colors["shadow"] = m_shadowColor;
     
-    // Emit signals for all changed colors
-    emit backgroundColorChanged(m_backgroundColor);
-    emit foregroundColorChanged(m_foregroundColor);
-    emit textColorChanged(m_textColor);
-    emit primaryColorChanged(m_primaryColor);
-    emit secondaryColorChanged(m_secondaryColor);
-    emit highlightColorChanged(m_highlightColor);
-    emit shadowColorChanged(m_shadowColor);
+    // Signals for the changed colors are emitted once the outermost update ends
+    endUpdate();
     
     qDebug() << "Updated derived colors";
 }
 
+ThemePalette ThemeManager::palette() const
+{
+    ThemePalette palette;
+    palette.accent = m_accentColor;
+    palette.background = m_backgroundColor;
+    palette.foreground = m_foregroundColor;
+    palette.text = m_textColor;
+    palette.primary = m_primaryColor;
+    palette.secondary = m_secondaryColor;
+    palette.highlight = m_highlightColor;
+    palette.shadow = m_shadowColor;
+    return palette;
+}
+
+void ThemeManager::setPalette(const ThemePalette &palette)
+{
+    beginUpdate();
+    
+    assignColor(m_accentColor, palette.accent, AccentColorChange);
+    assignColor(m_backgroundColor, palette.background, BackgroundColorChange);
+    assignColor(m_foregroundColor, palette.foreground, ForegroundColorChange);
+    assignColor(m_textColor, palette.text, TextColorChange);
+    assignColor(m_primaryColor, palette.primary, PrimaryColorChange);
+    assignColor(m_secondaryColor, palette.secondary, SecondaryColorChange);
+    assignColor(m_highlightColor, palette.highlight, HighlightColorChange);
+    assignColor(m_shadowColor, palette.shadow, ShadowColorChange);
+    
+    m_colors["accent"] = m_accentColor;
+    m_colors["background"] = m_backgroundColor;
+    m_colors["foreground"] = m_foregroundColor;
+    m_colors["text"] = m_textColor;
+    m_colors["primary"] = m_primaryColor;
+    m_colors["secondary"] = m_secondaryColor;
+    m_colors["highlight"] = m_highlightColor;
+    m_colors["shadow"] = m_shadowColor;
+    
+    endUpdate();
+}
+
+void ThemeManager::beginUpdate()
+{
+    m_updateDepth++;
+}
+
+void ThemeManager::endUpdate()
+{
+    if (m_updateDepth == 0) {
+        qWarning() << "endUpdate() called without matching beginUpdate()";
+        return;
+    }
+    
+    if (--m_updateDepth == 0) {
+        flushChanges();
+    }
+}
+
+bool ThemeManager::isUpdating() const
+{
+    return m_updateDepth > 0;
+}
+
+void ThemeManager::assignColor(QColor &member, const QColor &color, Change change)
+{
+    if (member == color) {
+        return;
+    }
+    
+    member = color;
+    markChanged(change);
+}
+
+void ThemeManager::markChanged(quint32 changes)
+{
+    m_pendingChanges |= changes;
+    
+    if (m_updateDepth == 0) {
+        flushChanges();
+    }
+}
+
+void ThemeManager::flushChanges()
+{
+    const quint32 changes = m_pendingChanges;
+    m_pendingChanges = 0;
+    
+    if (changes == 0) {
+        return;
+    }
+    
+    if (changes & ThemeNameChange) {
+        emit themeNameChanged(m_themeName);
+    }
+    if (changes & DarkModeChange) {
+        emit darkModeChanged(m_darkMode);
+    }
+    if (changes & AccentColorChange) {
+        emit accentColorChanged(m_accentColor);
+    }
+    if (changes & BackgroundColorChange) {
+        emit backgroundColorChanged(m_backgroundColor);
+    }
+    if (changes & ForegroundColorChange) {
+        emit foregroundColorChanged(m_foregroundColor);
+    }
+    if (changes & TextColorChange) {
+        emit textColorChanged(m_textColor);
+    }
+    if (changes & PrimaryColorChange) {
+        emit primaryColorChanged(m_primaryColor);
+    }
+    if (changes & SecondaryColorChange) {
+        emit secondaryColorChanged(m_secondaryColor);
+    }
+    if (changes & HighlightColorChange) {
+        emit highlightColorChanged(m_highlightColor);
+    }
+    if (changes & ShadowColorChange) {
+        emit shadowColorChanged(m_shadowColor);
+    }
+    if (changes & FontSizeChange) {
+        emit fontSizeChanged(m_fontSize);
+    }
+    if (changes & FontFamilyChange) {
+        emit fontFamilyChanged(m_fontFamily);
+    }
+    if (changes & CornerRadiusChange) {
+        emit cornerRadiusChanged(m_cornerRadius);
+    }
+    if (changes & ShadowRadiusChange) {
+        emit shadowRadiusChanged(m_shadowRadius);
+    }
+    if (changes & SpacingChange) {
+        emit spacingChanged(m_spacing);
+    }
+    if (changes & PaddingChange) {
+        emit paddingChanged(m_padding);
+    }
+    
+    if (changes & PaletteChanges) {
+        emit paletteChanged();
+    }
+    
+    // A rename alone does not restyle anything
+    if (changes & ~quint32(ThemeNameChange)) {
+        emit themeChanged();
+    }
+}
+
 void ThemeManager::loadDefaultTheme()
 {
     // Set default theme properties
+    beginUpdate();
     setThemeName("Default");
     setDarkMode(false);
     setAccentColor(QColor(0, 120, 215)); // Windows blue
@@ -424,6 +560,7 @@ void ThemeManager::loadDefaultTheme()
     setShadowRadius(8);
     setSpacing(8);
     setPadding(12);
+    endUpdate();
     
     // Derived colors will be updated by setAccentColor and setDarkMode
     
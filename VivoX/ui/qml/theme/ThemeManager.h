@@ -6,6 +6,8 @@
 #include <QQuickItem>
 #include <QColor>
 
+#include "ThemePalette.h"
+
 namespace VivoX::UI {
 
 /**
@@ -26,6 +28,7 @@ class ThemeManager : public QObject {
     Q_PROPERTY(QColor secondaryColor READ secondaryColor NOTIFY secondaryColorChanged)
     Q_PROPERTY(QColor highlightColor READ highlightColor NOTIFY highlightColorChanged)
     Q_PROPERTY(QColor shadowColor READ shadowColor NOTIFY shadowColorChanged)
+    Q_PROPERTY(VivoX::UI::ThemePalette palette READ palette WRITE setPalette NOTIFY paletteChanged)
     Q_PROPERTY(int fontSize READ fontSize WRITE setFontSize NOTIFY fontSizeChanged)
     Q_PROPERTY(QString fontFamily READ fontFamily WRITE setFontFamily NOTIFY fontFamilyChanged)
     Q_PROPERTY(int cornerRadius READ cornerRadius WRITE setCornerRadius NOTIFY cornerRadiusChanged)
@@ -121,6 +124,41 @@ public:
      */
     QColor shadowColor() const;
 
+    /**
+     * @brief Get all standard colors as one value
+     * @return The current palette
+     */
+    ThemePalette palette() const;
+
+    /**
+     * @brief Replace all standard colors at once
+     *
+     * The palette is applied as a single batched update.
+     *
+     * @param palette The new palette
+     */
+    void setPalette(const ThemePalette &palette);
+
+    /**
+     * @brief Begin a batched theme update
+     *
+     * Change notifications are held back until the matching endUpdate().
+     * Each property that actually changed is then notified once, followed
+     * by a single paletteChanged() and themeChanged(). Calls may be nested.
+     */
+    Q_INVOKABLE void beginUpdate();
+
+    /**
+     * @brief End a batched theme update and emit the collected notifications
+     */
+    Q_INVOKABLE void endUpdate();
+
+    /**
+     * @brief Check if a batched update is in progress
+     * @return True between beginUpdate() and the matching endUpdate()
+     */
+    bool isUpdating() const;
+
     /**
      * @brief Get the font size
      * @return The font size
@@ -319,6 +357,11 @@ signals:
      */
     void paddingChanged(int padding);
 
+    /**
+     * @brief Signal emitted once when any standard color changes
+     */
+    void paletteChanged();
+
     /**
      * @brief Signal emitted when the theme changes
      */
@@ -354,6 +397,42 @@ private:
     // Map of color names to colors
     QHash<QString, QColor> m_colors;
     
+    // Properties changed since the last notification
+    enum Change : quint32 {
+        ThemeNameChange = 1 << 0,
+        DarkModeChange = 1 << 1,
+        AccentColorChange = 1 << 2,
+        BackgroundColorChange = 1 << 3,
+        ForegroundColorChange = 1 << 4,
+        TextColorChange = 1 << 5,
+        PrimaryColorChange = 1 << 6,
+        SecondaryColorChange = 1 << 7,
+        HighlightColorChange = 1 << 8,
+        ShadowColorChange = 1 << 9,
+        FontSizeChange = 1 << 10,
+        FontFamilyChange = 1 << 11,
+        CornerRadiusChange = 1 << 12,
+        ShadowRadiusChange = 1 << 13,
+        SpacingChange = 1 << 14,
+        PaddingChange = 1 << 15,
+        CustomColorChange = 1 << 16,
+        PaletteChanges = AccentColorChange | BackgroundColorChange | ForegroundColorChange | TextColorChange
+                       | PrimaryColorChange | SecondaryColorChange | HighlightColorChange | ShadowColorChange
+    };
+    quint32 m_pendingChanges;
+    
+    // Nesting depth of beginUpdate()/endUpdate()
+    int m_updateDepth;
+    
+    // Record a change and notify unless a batched update is in progress
+    void markChanged(quint32 changes);
+    
+    // Emit the notifications for all recorded changes
+    void flushChanges();
+    
+    // Assign a standard color and record the change if it differs
+    void assignColor(QColor &member, const QColor &color, Change change);
+    
     // Apply the current theme
     void applyTheme();
     
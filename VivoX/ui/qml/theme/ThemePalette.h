@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QColor>
+#include <QMetaType>
+#include <QObject>
+
+namespace VivoX::UI {
+
+/**
+ * @brief Compact value type holding the standard theme colors.
+ *
+ * Exposed to QML as a single value (`ThemeManager.palette`) so bindings on
+ * any of its colors are re-evaluated once per palette change instead of once
+ * per individual color signal.
+ */
+struct ThemePalette {
+    Q_GADGET
+    Q_PROPERTY(QColor accent MEMBER accent)
+    Q_PROPERTY(QColor background MEMBER background)
+    Q_PROPERTY(QColor foreground MEMBER foreground)
+    Q_PROPERTY(QColor text MEMBER text)
+    Q_PROPERTY(QColor primary MEMBER primary)
+    Q_PROPERTY(QColor secondary MEMBER secondary)
+    Q_PROPERTY(QColor highlight MEMBER highlight)
+    Q_PROPERTY(QColor shadow MEMBER shadow)
+
+public:
+    QColor accent;
+    QColor background;
+    QColor foreground;
+    QColor text;
+    QColor primary;
+    QColor secondary;
+    QColor highlight;
+    QColor shadow;
+
+    bool operator==(const ThemePalette &other) const
+    {
+        return accent == other.accent
+            && background == other.background
+            && foreground == other.foreground
+            && text == other.text
+            && primary == other.primary
+            && secondary == other.secondary
+            && highlight == other.highlight
+            && shadow == other.shadow;
+    }
+
+    bool operator!=(const ThemePalette &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+} // namespace VivoX::UI
+
+Q_DECLARE_METATYPE(VivoX::UI::ThemePalette)
@@ -0,0 +1,6 @@
+import QtQuick 2.15
+
+// The command palette has no content yet; a root item keeps the view loadable and compiled with the others
+Item {
+    id: root
+}
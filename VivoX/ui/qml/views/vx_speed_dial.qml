@@ -0,0 +1,6 @@
+import QtQuick 2.15
+
+// The speed dial has no content yet; a root item keeps the view loadable and compiled with the others
+Item {
+    id: root
+}
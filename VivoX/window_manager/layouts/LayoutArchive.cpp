@@ -0,0 +1,705 @@
+#include "LayoutArchive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace VivoX {
+namespace WindowManager {
+namespace Layouts {
+
+namespace {
+    const char magic[4] = { 'V', 'X', 'L', 'A' };
+    const uint32_t byteOrderMark = 0x01020304;
+
+    // Sizes of the header and records written by this version
+    const uint16_t headerSize = 40;
+    const uint16_t workspaceSize = 28;
+    const uint16_t nodeSize = 12;
+    const uint16_t ruleSize = 44;
+
+    template <typename T>
+    void put(std::vector<uint8_t>& out, T value) {
+        const size_t at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &value, sizeof(T));
+    }
+
+    template <typename T>
+    T get(const uint8_t* data, size_t offset) {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        return value;
+    }
+
+    void putGeometry(std::vector<uint8_t>& out, const WindowRegistry::Geometry& geometry) {
+        put<int32_t>(out, geometry.x);
+        put<int32_t>(out, geometry.y);
+        put<int32_t>(out, geometry.width);
+        put<int32_t>(out, geometry.height);
+    }
+
+    WindowRegistry::Geometry getGeometry(const uint8_t* data, size_t offset) {
+        WindowRegistry::Geometry geometry;
+        geometry.x = get<int32_t>(data, offset);
+        geometry.y = get<int32_t>(data, offset + 4);
+        geometry.width = get<int32_t>(data, offset + 8);
+        geometry.height = get<int32_t>(data, offset + 12);
+        return geometry;
+    }
+
+    uint32_t checksum(const uint8_t* data, size_t size) {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    /*
+     * Walk a tiling tree in pre-order. Calls visit(node, parent) for every
+     * node; returns false unless the nodes form exactly one tree.
+     */
+    bool walkTree(size_t count, const std::function<uint32_t(size_t)>& children,
+                  const std::function<void(size_t, int64_t)>& visit) {
+        struct Frame {
+            size_t node;
+            uint32_t remaining;
+        };
+        std::vector<Frame> stack;
+
+        for (size_t i = 0; i < count; ++i) {
+            while (!stack.empty() && stack.back().remaining == 0) {
+                stack.pop_back();
+            }
+            if (stack.empty() && i != 0) {
+                return false;
+            }
+
+            const int64_t parent = stack.empty() ? -1 : static_cast<int64_t>(stack.back().node);
+            if (!stack.empty()) {
+                stack.back().remaining--;
+            }
+            visit(i, parent);
+
+            const uint32_t childCount = children(i);
+            if (childCount > count - i - 1) {
+                return false;
+            }
+            if (childCount > 0) {
+                stack.push_back({ i, childCount });
+            }
+        }
+
+        while (!stack.empty() && stack.back().remaining == 0) {
+            stack.pop_back();
+        }
+        return stack.empty();
+    }
+
+    struct TitleKey {
+        std::string_view appId;
+        std::string_view title;
+
+        bool operator==(const TitleKey& other) const { return appId == other.appId && title == other.title; }
+    };
+
+    struct TitleKeyHash {
+        size_t operator()(const TitleKey& key) const {
+            const size_t hash = std::hash<std::string_view>()(key.appId);
+            return hash ^ (std::hash<std::string_view>()(key.title) + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+        }
+    };
+
+    // Rules of one application, or of one application and title, in file order
+    struct Bucket {
+        std::vector<uint32_t> rules;
+        size_t next = 0;
+
+        int64_t take(std::vector<bool>& used) {
+            while (next < rules.size() && used[rules[next]]) {
+                next++;
+            }
+            if (next == rules.size()) {
+                return -1;
+            }
+            used[rules[next]] = true;
+            return rules[next++];
+        }
+    };
+}
+
+const uint16_t LayoutArchive::version = 1;
+const uint16_t LayoutArchive::minorVersion = 0;
+
+LayoutArchive::LayoutArchive()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_mapping(nullptr)
+    , m_mappingSize(0)
+    , m_version(0)
+    , m_minorVersion(0)
+    , m_workspaceCount(0)
+    , m_nodeCount(0)
+    , m_ruleCount(0)
+    , m_stringBytes(0)
+    , m_workspaceSize(0)
+    , m_nodeSize(0)
+    , m_ruleSize(0)
+    , m_workspaceOffset(0)
+    , m_nodeOffset(0)
+    , m_ruleOffset(0)
+    , m_stringOffset(0)
+{
+}
+
+LayoutArchive::~LayoutArchive() {
+    close();
+}
+
+std::vector<uint8_t> LayoutArchive::serialize(const SavedLayout& layout) {
+    std::vector<uint8_t> out;
+
+    // Index of each workspace's root among all nodes, and the share of each node in its parent
+    std::unordered_map<uint32_t, const SavedLayout::Workspace*> workspaces;
+    std::vector<uint32_t> firstNodes;
+    std::vector<float> shares;
+    for (const SavedLayout::Workspace& workspace : layout.workspaces) {
+        if (!workspaces.emplace(workspace.id, &workspace).second) {
+            return out;
+        }
+        firstNodes.push_back(static_cast<uint32_t>(shares.size()));
+
+        const std::vector<SavedLayout::Node>& nodes = workspace.nodes;
+        for (const SavedLayout::Node& node : nodes) {
+            if (node.split != SavedLayout::Split::Leaf && node.children == 0) {
+                return out;
+            }
+        }
+
+        std::vector<int64_t> parents(nodes.size(), -1);
+        std::vector<float> totals(nodes.size(), 0.0f);
+        const bool valid = walkTree(nodes.size(),
+            [&nodes](size_t i) { return nodes[i].split == SavedLayout::Split::Leaf ? 0 : nodes[i].children; },
+            [&](size_t i, int64_t parent) {
+                parents[i] = parent;
+                if (parent >= 0) {
+                    totals[parent] += std::max(0.0f, nodes[i].weight);
+                }
+            });
+        if (!valid) {
+            return out;
+        }
+
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const int64_t parent = parents[i];
+            if (parent < 0) {
+                shares.push_back(1.0f);
+            } else if (totals[parent] > 0.0f) {
+                shares.push_back(std::max(0.0f, nodes[i].weight) / totals[parent]);
+            } else {
+                shares.push_back(1.0f / nodes[parent].children);
+            }
+        }
+    }
+
+    // Rules refer to leaves by their index among all nodes
+    std::vector<int32_t> leaves;
+    for (const SavedLayout::Rule& rule : layout.rules) {
+        auto it = workspaces.find(rule.workspace);
+        if (it == workspaces.end()) {
+            return out;
+        }
+        if (rule.leaf < 0) {
+            leaves.push_back(-1);
+            continue;
+        }
+
+        const std::vector<SavedLayout::Node>& nodes = it->second->nodes;
+        if (static_cast<size_t>(rule.leaf) >= nodes.size() || nodes[rule.leaf].split != SavedLayout::Split::Leaf) {
+            return out;
+        }
+        const size_t index = static_cast<size_t>(it->second - layout.workspaces.data());
+        leaves.push_back(static_cast<int32_t>(firstNodes[index]) + rule.leaf);
+    }
+
+    size_t stringBytes = 0;
+    for (const SavedLayout::Rule& rule : layout.rules) {
+        stringBytes += rule.appId.size() + rule.title.size();
+    }
+
+    const size_t total = headerSize + layout.workspaces.size() * workspaceSize + shares.size() * nodeSize
+        + layout.rules.size() * ruleSize + stringBytes;
+    if (total > UINT32_MAX) {
+        return out;
+    }
+    out.reserve(total);
+
+    out.insert(out.end(), magic, magic + sizeof(magic));
+    put<uint16_t>(out, version);
+    put<uint16_t>(out, headerSize);
+    put<uint32_t>(out, byteOrderMark);
+    put<uint32_t>(out, static_cast<uint32_t>(layout.workspaces.size()));
+    put<uint32_t>(out, static_cast<uint32_t>(shares.size()));
+    put<uint32_t>(out, static_cast<uint32_t>(layout.rules.size()));
+    put<uint32_t>(out, static_cast<uint32_t>(stringBytes));
+    put<uint16_t>(out, workspaceSize);
+    put<uint16_t>(out, nodeSize);
+    put<uint16_t>(out, ruleSize);
+    put<uint16_t>(out, minorVersion);
+    put<uint32_t>(out, 0);
+
+    for (size_t i = 0; i < layout.workspaces.size(); ++i) {
+        const SavedLayout::Workspace& workspace = layout.workspaces[i];
+        put<uint32_t>(out, workspace.id);
+        put<uint32_t>(out, firstNodes[i]);
+        put<uint32_t>(out, static_cast<uint32_t>(workspace.nodes.size()));
+        putGeometry(out, workspace.area);
+    }
+
+    size_t node = 0;
+    for (const SavedLayout::Workspace& workspace : layout.workspaces) {
+        for (const SavedLayout::Node& entry : workspace.nodes) {
+            const bool leaf = entry.split == SavedLayout::Split::Leaf;
+            put<uint8_t>(out, static_cast<uint8_t>(entry.split));
+            put<uint8_t>(out, 0);
+            put<uint16_t>(out, 0);
+            put<uint32_t>(out, leaf ? 0 : entry.children);
+            put<float>(out, shares[node++]);
+        }
+    }
+
+    uint32_t stringOffset = 0;
+    for (size_t i = 0; i < layout.rules.size(); ++i) {
+        const SavedLayout::Rule& rule = layout.rules[i];
+        put<uint32_t>(out, stringOffset);
+        put<uint32_t>(out, static_cast<uint32_t>(rule.appId.size()));
+        stringOffset += static_cast<uint32_t>(rule.appId.size());
+        put<uint32_t>(out, stringOffset);
+        put<uint32_t>(out, static_cast<uint32_t>(rule.title.size()));
+        stringOffset += static_cast<uint32_t>(rule.title.size());
+        put<uint32_t>(out, rule.workspace);
+        put<int32_t>(out, leaves[i]);
+        putGeometry(out, rule.geometry);
+        put<uint32_t>(out, rule.flags);
+    }
+
+    for (const SavedLayout::Rule& rule : layout.rules) {
+        out.insert(out.end(), rule.appId.begin(), rule.appId.end());
+        out.insert(out.end(), rule.title.begin(), rule.title.end());
+    }
+
+    const uint32_t sum = checksum(out.data() + headerSize, out.size() - headerSize);
+    std::memcpy(out.data() + 36, &sum, sizeof(sum));
+    return out;
+}
+
+bool LayoutArchive::save(const SavedLayout& layout, const std::string& path) {
+    const std::vector<uint8_t> data = serialize(layout);
+    if (data.empty()) {
+        return false;
+    }
+
+    // Write a temporary file and rename it over the old one, so a crash leaves either
+    const std::string temporary = path + ".tmp";
+    const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+        if (result <= 0) {
+            ::close(fd);
+            ::unlink(temporary.c_str());
+            return false;
+        }
+        written += static_cast<size_t>(result);
+    }
+
+    const bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    if (!synced || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LayoutArchive::open(const std::string& path) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size < headerSize) {
+        ::close(fd);
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mappingSize = size;
+    m_data = static_cast<const uint8_t*>(mapping);
+    m_size = size;
+    if (!validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool LayoutArchive::open(const void* data, size_t size) {
+    close();
+    if (!data) {
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = size;
+    if (!validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LayoutArchive::close() {
+    if (m_mapping) {
+        ::munmap(m_mapping, m_mappingSize);
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_data = nullptr;
+    m_size = 0;
+    m_version = 0;
+    m_minorVersion = 0;
+    m_workspaceCount = 0;
+    m_nodeCount = 0;
+    m_ruleCount = 0;
+    m_stringBytes = 0;
+}
+
+bool LayoutArchive::isOpen() const {
+    return m_data != nullptr;
+}
+
+uint16_t LayoutArchive::fileVersion() const {
+    return m_version;
+}
+
+uint16_t LayoutArchive::fileMinorVersion() const {
+    return m_minorVersion;
+}
+
+size_t LayoutArchive::workspaceCount() const {
+    return m_workspaceCount;
+}
+
+size_t LayoutArchive::nodeCount() const {
+    return m_nodeCount;
+}
+
+size_t LayoutArchive::ruleCount() const {
+    return m_ruleCount;
+}
+
+LayoutArchive::Workspace LayoutArchive::workspace(size_t index) const {
+    const uint8_t* data = record(m_workspaceOffset, m_workspaceSize, index);
+    Workspace workspace;
+    workspace.id = get<uint32_t>(data, 0);
+    workspace.firstNode = get<uint32_t>(data, 4);
+    workspace.nodeCount = get<uint32_t>(data, 8);
+    workspace.area = getGeometry(data, 12);
+    return workspace;
+}
+
+SavedLayout::Node LayoutArchive::node(size_t index) const {
+    const uint8_t* data = record(m_nodeOffset, m_nodeSize, index);
+    SavedLayout::Node node;
+    node.split = static_cast<SavedLayout::Split>(get<uint8_t>(data, 0));
+    node.children = get<uint32_t>(data, 4);
+    node.weight = get<float>(data, 8);
+    return node;
+}
+
+LayoutArchive::Rule LayoutArchive::rule(size_t index) const {
+    const uint8_t* data = record(m_ruleOffset, m_ruleSize, index);
+    const char* strings = reinterpret_cast<const char*>(m_data + m_stringOffset);
+    Rule rule;
+    rule.appId = std::string_view(strings + get<uint32_t>(data, 0), get<uint32_t>(data, 4));
+    rule.title = std::string_view(strings + get<uint32_t>(data, 8), get<uint32_t>(data, 12));
+    rule.workspace = get<uint32_t>(data, 16);
+    rule.leaf = get<int32_t>(data, 20);
+    rule.geometry = getGeometry(data, 24);
+    rule.flags = get<uint32_t>(data, 40);
+    return rule;
+}
+
+SavedLayout LayoutArchive::toLayout() const {
+    SavedLayout layout;
+    std::unordered_map<uint32_t, uint32_t> firstNodes;
+
+    layout.workspaces.reserve(m_workspaceCount);
+    for (size_t i = 0; i < m_workspaceCount; ++i) {
+        const Workspace stored = workspace(i);
+        SavedLayout::Workspace entry;
+        entry.id = stored.id;
+        entry.area = stored.area;
+        entry.nodes.reserve(stored.nodeCount);
+        for (uint32_t n = 0; n < stored.nodeCount; ++n) {
+            entry.nodes.push_back(node(stored.firstNode + n));
+        }
+        firstNodes[stored.id] = stored.firstNode;
+        layout.workspaces.push_back(std::move(entry));
+    }
+
+    layout.rules.reserve(m_ruleCount);
+    for (size_t i = 0; i < m_ruleCount; ++i) {
+        const Rule stored = rule(i);
+        SavedLayout::Rule entry;
+        entry.appId = std::string(stored.appId);
+        entry.title = std::string(stored.title);
+        entry.workspace = stored.workspace;
+        entry.leaf = stored.leaf < 0 ? -1 : stored.leaf - static_cast<int32_t>(firstNodes[stored.workspace]);
+        entry.geometry = stored.geometry;
+        entry.flags = stored.flags;
+        layout.rules.push_back(std::move(entry));
+    }
+    return layout;
+}
+
+std::vector<LayoutPlacement> LayoutArchive::place(const std::vector<LayoutWindow>& windows) const {
+    std::vector<LayoutPlacement> placements;
+    if (!isOpen()) {
+        return placements;
+    }
+
+    // Lay out every tiling tree in one pass; a node's share is of its parent's extent
+    std::vector<WindowRegistry::Geometry> rects(m_nodeCount);
+    struct Frame {
+        SavedLayout::Split split;
+        uint32_t remaining;
+        int cursor;
+        WindowRegistry::Geometry rect;
+    };
+    std::vector<Frame> stack;
+
+    for (size_t w = 0; w < m_workspaceCount; ++w) {
+        const Workspace stored = workspace(w);
+        stack.clear();
+        for (uint32_t i = stored.firstNode; i < stored.firstNode + stored.nodeCount; ++i) {
+            while (!stack.empty() && stack.back().remaining == 0) {
+                stack.pop_back();
+            }
+
+            const SavedLayout::Node entry = node(i);
+            WindowRegistry::Geometry rect = stored.area;
+            if (!stack.empty()) {
+                Frame& parent = stack.back();
+                rect = parent.rect;
+                const bool horizontal = parent.split == SavedLayout::Split::Horizontal;
+                const int extent = horizontal ? parent.rect.width : parent.rect.height;
+                const int end = horizontal ? parent.rect.x + parent.rect.width : parent.rect.y + parent.rect.height;
+
+                // The last child takes whatever rounding left over
+                const int length = parent.remaining == 1 ? end - parent.cursor
+                    : std::min(end - parent.cursor, static_cast<int>(std::lround(entry.weight * extent)));
+                if (horizontal) {
+                    rect.x = parent.cursor;
+                    rect.width = length;
+                } else {
+                    rect.y = parent.cursor;
+                    rect.height = length;
+                }
+                parent.cursor += length;
+                parent.remaining--;
+            }
+            rects[i] = rect;
+
+            if (entry.children > 0) {
+                const bool horizontal = entry.split == SavedLayout::Split::Horizontal;
+                stack.push_back({ entry.split, entry.children, horizontal ? rect.x : rect.y, rect });
+            }
+        }
+    }
+
+    // Index the rules by application, and by application and title
+    std::unordered_map<std::string_view, Bucket> byApp;
+    std::unordered_map<TitleKey, Bucket, TitleKeyHash> byTitle;
+    byApp.reserve(m_ruleCount);
+    byTitle.reserve(m_ruleCount);
+    for (uint32_t i = 0; i < m_ruleCount; ++i) {
+        const Rule stored = rule(i);
+        byApp[stored.appId].rules.push_back(i);
+        if (!stored.title.empty()) {
+            byTitle[{ stored.appId, stored.title }].rules.push_back(i);
+        }
+    }
+
+    // Windows with their exact title first, then the rest of each application
+    std::vector<bool> used(m_ruleCount, false);
+    std::vector<int64_t> matches(windows.size(), -1);
+    for (size_t i = 0; i < windows.size(); ++i) {
+        auto it = byTitle.find({ windows[i].appId, windows[i].title });
+        if (it != byTitle.end()) {
+            matches[i] = it->second.take(used);
+        }
+    }
+    for (size_t i = 0; i < windows.size(); ++i) {
+        if (matches[i] >= 0) {
+            continue;
+        }
+        auto it = byApp.find(windows[i].appId);
+        if (it != byApp.end()) {
+            matches[i] = it->second.take(used);
+        }
+    }
+
+    placements.reserve(windows.size());
+    for (size_t i = 0; i < windows.size(); ++i) {
+        if (matches[i] < 0) {
+            continue;
+        }
+
+        const Rule stored = rule(static_cast<size_t>(matches[i]));
+        LayoutPlacement placement;
+        placement.window = windows[i].id;
+        placement.workspace = stored.workspace;
+        placement.geometry = stored.leaf >= 0 ? rects[stored.leaf] : stored.geometry;
+        placement.flags = stored.flags;
+        placements.push_back(placement);
+    }
+    return placements;
+}
+
+size_t LayoutArchive::apply(const std::vector<LayoutPlacement>& placements, WindowRegistry& registry) {
+    size_t placed = 0;
+    for (const LayoutPlacement& placement : placements) {
+        const Windows::WindowHandle handle = registry.find(placement.window);
+        if (handle.isNull()) {
+            continue;
+        }
+
+        registry.setWorkspace(handle, placement.workspace);
+        registry.setGeometry(handle, placement.geometry);
+        registry.setFlags(handle, placement.flags);
+        placed++;
+    }
+    return placed;
+}
+
+bool LayoutArchive::validate() {
+    if (m_size < headerSize || std::memcmp(m_data, magic, sizeof(magic)) != 0
+        || get<uint32_t>(m_data, 8) != byteOrderMark) {
+        return false;
+    }
+
+    // Newer minor versions may append fields to records and the header, but nothing else changes within a version
+    m_version = get<uint16_t>(m_data, 4);
+    const uint16_t fileHeaderSize = get<uint16_t>(m_data, 6);
+    if (m_version == 0 || m_version > version || fileHeaderSize < headerSize || fileHeaderSize > m_size) {
+        return false;
+    }
+
+    m_workspaceCount = get<uint32_t>(m_data, 12);
+    m_nodeCount = get<uint32_t>(m_data, 16);
+    m_ruleCount = get<uint32_t>(m_data, 20);
+    m_stringBytes = get<uint32_t>(m_data, 24);
+    m_workspaceSize = get<uint16_t>(m_data, 28);
+    m_nodeSize = get<uint16_t>(m_data, 30);
+    m_ruleSize = get<uint16_t>(m_data, 32);
+    m_minorVersion = get<uint16_t>(m_data, 34);
+    if (m_workspaceSize < workspaceSize || m_nodeSize < nodeSize || m_ruleSize < ruleSize) {
+        return false;
+    }
+
+    const uint64_t expected = uint64_t(fileHeaderSize) + uint64_t(m_workspaceCount) * m_workspaceSize
+        + uint64_t(m_nodeCount) * m_nodeSize + uint64_t(m_ruleCount) * m_ruleSize + m_stringBytes;
+    if (expected != m_size || get<uint32_t>(m_data, 36) != checksum(m_data + fileHeaderSize, m_size - fileHeaderSize)) {
+        return false;
+    }
+
+    m_workspaceOffset = fileHeaderSize;
+    m_nodeOffset = m_workspaceOffset + size_t(m_workspaceCount) * m_workspaceSize;
+    m_ruleOffset = m_nodeOffset + size_t(m_nodeCount) * m_nodeSize;
+    m_stringOffset = m_ruleOffset + size_t(m_ruleCount) * m_ruleSize;
+
+    // The workspaces' trees must partition the nodes, each a single well-formed tree
+    std::vector<int32_t> owners(m_nodeCount, -1);
+    std::unordered_map<uint32_t, uint32_t> workspaceIndices;
+    for (uint32_t w = 0; w < m_workspaceCount; ++w) {
+        const Workspace stored = workspace(w);
+        if (uint64_t(stored.firstNode) + stored.nodeCount > m_nodeCount
+            || !workspaceIndices.emplace(stored.id, w).second) {
+            return false;
+        }
+
+        bool splitsValid = true;
+        const bool treeValid = walkTree(stored.nodeCount,
+            [&](size_t i) {
+                const SavedLayout::Node entry = node(stored.firstNode + i);
+                if (entry.split > SavedLayout::Split::Vertical
+                    || (entry.split == SavedLayout::Split::Leaf) != (entry.children == 0)) {
+                    splitsValid = false;
+                }
+                return entry.children;
+            },
+            [&](size_t i, int64_t) {
+                int32_t& owner = owners[stored.firstNode + i];
+                if (owner >= 0) {
+                    splitsValid = false;
+                }
+                owner = static_cast<int32_t>(w);
+            });
+        if (!treeValid || !splitsValid) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < m_ruleCount; ++i) {
+        const uint8_t* data = record(m_ruleOffset, m_ruleSize, i);
+        const uint64_t appIdEnd = uint64_t(get<uint32_t>(data, 0)) + get<uint32_t>(data, 4);
+        const uint64_t titleEnd = uint64_t(get<uint32_t>(data, 8)) + get<uint32_t>(data, 12);
+        if (appIdEnd > m_stringBytes || titleEnd > m_stringBytes) {
+            return false;
+        }
+
+        auto it = workspaceIndices.find(get<uint32_t>(data, 16));
+        const int32_t leaf = get<int32_t>(data, 20);
+        if (it == workspaceIndices.end()) {
+            return false;
+        }
+        if (leaf >= 0 && (static_cast<uint32_t>(leaf) >= m_nodeCount || owners[leaf] != static_cast<int32_t>(it->second)
+                          || node(static_cast<size_t>(leaf)).split != SavedLayout::Split::Leaf)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const uint8_t* LayoutArchive::record(size_t offset, size_t size, size_t index) const {
+    return m_data + offset + index * size;
+}
+
+} // namespace Layouts
+} // namespace WindowManager
+} // namespace VivoX
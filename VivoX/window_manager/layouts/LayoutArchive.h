@@ -0,0 +1,279 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../windows/WindowRegistry.h"
+
+namespace VivoX {
+namespace WindowManager {
+namespace Layouts {
+
+using Windows::WindowRegistry;
+
+/**
+ * @brief Editable form of a saved layout
+ *
+ * Each workspace has a tiling tree, stored in pre-order: a node is followed
+ * by the subtrees of its children. Windows are placed by rules matched on
+ * their application ID and, to tell windows of one application apart, on
+ * their title. A rule puts its window in a leaf of the tiling tree or at a
+ * floating geometry.
+ */
+struct SavedLayout {
+    /**
+     * @brief How a node divides its area among its children
+     */
+    enum class Split : uint8_t {
+        Leaf,           ///< No children; holds one window
+        Horizontal,     ///< Children side by side
+        Vertical        ///< Children on top of each other
+    };
+
+    /**
+     * @brief Node of a tiling tree
+     */
+    struct Node {
+        Split split = Split::Leaf;
+        uint32_t children = 0;      ///< Number of children
+        float weight = 1.0f;        ///< Share of the parent's area, relative to its siblings
+    };
+
+    /**
+     * @brief Workspace and its tiling tree
+     */
+    struct Workspace {
+        uint32_t id = 0;
+        WindowRegistry::Geometry area;  ///< Area the tree is laid out in
+        std::vector<Node> nodes;        ///< Tiling tree in pre-order, empty if the workspace only floats
+    };
+
+    /**
+     * @brief Placement rule for one window
+     */
+    struct Rule {
+        std::string appId;
+        std::string title;                  ///< Preferred title; empty matches any
+        uint32_t workspace = 0;
+        int32_t leaf = -1;                  ///< Index of the leaf node in the workspace's tree, -1 if floating
+        WindowRegistry::Geometry geometry;  ///< Geometry of a floating window
+        uint32_t flags = WindowRegistry::Visible;
+    };
+
+    std::vector<Workspace> workspaces;
+    std::vector<Rule> rules;
+};
+
+/**
+ * @brief Window to be placed by a layout
+ */
+struct LayoutWindow {
+    uint32_t id = 0;
+    std::string_view appId;
+    std::string_view title;
+};
+
+/**
+ * @brief Where a layout puts a window
+ */
+struct LayoutPlacement {
+    uint32_t window = 0;
+    uint32_t workspace = 0;
+    WindowRegistry::Geometry geometry;
+    uint32_t flags = 0;
+};
+
+/**
+ * @brief Compact, versioned binary format for saved layouts
+ *
+ * A layout file is a fixed header followed by arrays of fixed-size
+ * workspace, node and rule records and a table of the strings they refer
+ * to. Files are memory-mapped and validated when opened, and read in place
+ * afterwards: records are decoded on access and strings are views into the
+ * mapping, so opening a layout costs no parsing.
+ *
+ * The header records the size of each kind of record, so fields appended to
+ * records later are skipped by older readers. Such additions bump the minor
+ * version, and files of a newer minor version are read as long as their
+ * records are at least as large as the known ones. Files of a newer major
+ * version, whose changes aren't compatible, are rejected, as are files whose
+ * checksum doesn't match.
+ *
+ * Placing windows computes all their geometries in one pass over the
+ * tiling trees and the windows, in O(nodes + rules + windows); the result
+ * is then applied to the registry in one go.
+ */
+class LayoutArchive {
+public:
+    /**
+     * @brief Workspace as stored in an archive
+     */
+    struct Workspace {
+        uint32_t id = 0;
+        WindowRegistry::Geometry area;
+        uint32_t firstNode = 0;     ///< Index of the workspace's root node
+        uint32_t nodeCount = 0;     ///< Number of nodes in the workspace's tree
+    };
+
+    /**
+     * @brief Rule as stored in an archive
+     */
+    struct Rule {
+        std::string_view appId;     ///< View into the archive
+        std::string_view title;     ///< View into the archive
+        uint32_t workspace = 0;
+        int32_t leaf = -1;          ///< Index of the leaf node among all nodes, -1 if floating
+        WindowRegistry::Geometry geometry;
+        uint32_t flags = 0;
+    };
+
+    /**
+     * @brief The format version written by this build; readers reject newer ones
+     */
+    static const uint16_t version;
+
+    /**
+     * @brief The minor version written by this build, bumped when fields are appended
+     */
+    static const uint16_t minorVersion;
+
+    LayoutArchive();
+    ~LayoutArchive();
+
+    LayoutArchive(const LayoutArchive&) = delete;
+    LayoutArchive& operator=(const LayoutArchive&) = delete;
+
+    /**
+     * @brief Encode a layout
+     * @param layout The layout
+     * @return The encoded layout, or an empty buffer if the layout is malformed
+     */
+    static std::vector<uint8_t> serialize(const SavedLayout& layout);
+
+    /**
+     * @brief Write a layout to a file, replacing it atomically
+     * @param layout The layout
+     * @param path The file
+     * @return True if the layout was written
+     */
+    static bool save(const SavedLayout& layout, const std::string& path);
+
+    /**
+     * @brief Map a layout file
+     * @param path The file
+     * @return True if the file is a valid layout
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Read a layout from memory
+     * @param data The encoded layout; it must outlive the archive or the next open()
+     * @param size The size of the encoded layout
+     * @return True if the data is a valid layout
+     */
+    bool open(const void* data, size_t size);
+
+    /**
+     * @brief Unmap the layout
+     */
+    void close();
+
+    /**
+     * @brief Check if a layout is open
+     * @return True if a valid layout was opened
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Get the format version of the open layout
+     * @return The version, 0 if none is open
+     */
+    uint16_t fileVersion() const;
+
+    /**
+     * @brief Get the minor format version of the open layout
+     * @return The minor version, 0 if none is open
+     */
+    uint16_t fileMinorVersion() const;
+
+    size_t workspaceCount() const;
+    size_t nodeCount() const;
+    size_t ruleCount() const;
+
+    /**
+     * @brief Get a workspace
+     * @param index Index of the workspace, less than workspaceCount()
+     * @return The workspace
+     */
+    Workspace workspace(size_t index) const;
+
+    /**
+     * @brief Get a node of the tiling trees
+     * @param index Index of the node among all nodes, less than nodeCount()
+     * @return The node
+     */
+    SavedLayout::Node node(size_t index) const;
+
+    /**
+     * @brief Get a rule
+     * @param index Index of the rule, less than ruleCount()
+     * @return The rule; its strings are valid while the layout is open
+     */
+    Rule rule(size_t index) const;
+
+    /**
+     * @brief Copy the open layout into its editable form
+     * @return The layout
+     */
+    SavedLayout toLayout() const;
+
+    /**
+     * @brief Place windows by the open layout
+     *
+     * A window takes the first unused rule of its application with its
+     * title, or failing that, the first unused rule of its application.
+     * Windows no rule matches are left out.
+     *
+     * @param windows The windows
+     * @return The placements, in the order of the windows
+     */
+    std::vector<LayoutPlacement> place(const std::vector<LayoutWindow>& windows) const;
+
+    /**
+     * @brief Apply placements to the registered windows
+     * @param placements The placements
+     * @param registry The registry
+     * @return The number of windows found and placed
+     */
+    static size_t apply(const std::vector<LayoutPlacement>& placements, WindowRegistry& registry);
+
+private:
+    bool validate();
+    const uint8_t* record(size_t offset, size_t size, size_t index) const;
+
+    const uint8_t* m_data;
+    size_t m_size;
+    void* m_mapping;
+    size_t m_mappingSize;
+
+    uint16_t m_version;
+    uint16_t m_minorVersion;
+    uint32_t m_workspaceCount;
+    uint32_t m_nodeCount;
+    uint32_t m_ruleCount;
+    uint32_t m_stringBytes;
+    uint16_t m_workspaceSize;
+    uint16_t m_nodeSize;
+    uint16_t m_ruleSize;
+    size_t m_workspaceOffset;
+    size_t m_nodeOffset;
+    size_t m_ruleOffset;
+    size_t m_stringOffset;
+};
+
+} // namespace Layouts
+} // namespace WindowManager
+} // namespace VivoX
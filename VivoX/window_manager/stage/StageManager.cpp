@@ -51,16 +51,12 @@ void StageManager::setActive(bool active)
         m_active = active;
         
         if (m_active) {
-            // Save original window positions
-            for (Window *window : m_windowManager->getAllWindows()) {
-                m_originalWindowPositions[window] = window->geometry();
-            }
-            
-            // Arrange windows in stage mode
+            // Arrange window thumbnails in stage mode
             arrangeWindows();
         } else {
-            // Restore original window positions
-            restoreWindowPositions();
+            // Windows were never moved, so there is nothing to restore
+            m_windowStagePositions.clear();
+            emit stageLayoutChanged();
         }
         
         emit activeChanged(m_active);
@@ -142,59 +138,29 @@ void StageManager::arrangeWindows()
         return;
     }
     
-    // Calculate window positions
+    // Calculate thumbnail positions; the windows themselves stay untouched
     calculateWindowPositions();
-    
-    // Apply positions to windows
-    for (auto it = m_windowStagePositions.begin(); it != m_windowStagePositions.end(); ++it) {
-        Window *window = it.key();
-        QRect geometry = it.value();
-        
-        window->setGeometry(geometry);
-    }
+    emit stageLayoutChanged();
     
     qDebug() << "Arranged windows in stage mode";
 }
 
-void StageManager::restoreWindowPositions()
-{
-    // Restore original window positions
-    for (auto it = m_originalWindowPositions.begin(); it != m_originalWindowPositions.end(); ++it) {
-        Window *window = it.key();
-        QRect geometry = it.value();
-        
-        window->setGeometry(geometry);
-    }
-    
-    // Clear saved positions
-    m_originalWindowPositions.clear();
-    
-    qDebug() << "Restored window positions after exiting stage mode";
-}
-
 void StageManager::handleWindowAdded(Window *window)
 {
+    Q_UNUSED(window);
+    
     if (m_active) {
-        // Save original position
-        m_originalWindowPositions[window] = window->geometry();
-        
-        // Recalculate window positions
-        calculateWindowPositions();
-        
-        // Apply position to the new window
-        window->setGeometry(m_windowStagePositions.value(window, window->geometry()));
+        arrangeWindows();
     }
 }
 
 void StageManager::handleWindowRemoved(Window *window)
 {
-    // Remove from maps
+    // Remove from map
     m_windowStagePositions.remove(window);
-    m_originalWindowPositions.remove(window);
     
     if (m_active) {
-        // Recalculate window positions
-        calculateWindowPositions();
+        arrangeWindows();
     }
 }
 
@@ -224,13 +190,25 @@ void StageManager::calculateWindowPositions()
         int row = i / cols;
         int col = i % cols;
         
-        QRect geometry(
+        QRect cell(
             m_stageArea.x() + col * (cellWidth + padding) + padding,
             m_stageArea.y() + row * (cellHeight + padding) + padding,
             cellWidth,
             cellHeight
         );
         
+        // Fit the thumbnail into its cell, keeping the window's aspect ratio
+        // and never showing it larger than the window itself
+        QSize size = windows.at(i)->geometry().size();
+        if (size.isEmpty()) {
+            size = cell.size();
+        } else if (size.width() > cell.width() || size.height() > cell.height()) {
+            size.scale(cell.size(), Qt::KeepAspectRatio);
+        }
+        
+        QRect geometry(QPoint(), size);
+        geometry.moveCenter(cell.center());
+        
         // Store position
         m_windowStagePositions[windows.at(i)] = geometry;
     }
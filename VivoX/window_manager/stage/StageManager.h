@@ -17,6 +17,10 @@ class WindowManager;
  * It is responsible for arranging windows in an overview mode similar to
  * macOS Mission Control or GNOME Activities, allowing users to see all
  * windows at once and select one to focus.
+ *
+ * Windows keep their geometry while the stage is shown: the stage draws
+ * their thumbnails at the positions calculated here, so no client has to
+ * re-layout or re-render at another size.
  */
 class StageManager : public QObject {
     Q_OBJECT
@@ -90,6 +94,11 @@ signals:
      */
     void stageAreaChanged(const QRect &area);
 
+    /**
+     * @brief Signal emitted when the stage positions of the windows change
+     */
+    void stageLayoutChanged();
+
     /**
      * @brief Signal emitted when a window is selected in stage mode
      * @param window The selected window
@@ -106,18 +115,12 @@ private:
     // The stage area
     QRect m_stageArea;
     
-    // Map of window to stage position
+    // Map of window to the rectangle its thumbnail is shown in
     QHash<Window*, QRect> m_windowStagePositions;
     
-    // Original window positions before entering stage mode
-    QHash<Window*, QRect> m_originalWindowPositions;
-    
     // Arrange windows in stage mode
     void arrangeWindows();
     
-    // Restore window positions after exiting stage mode
-    void restoreWindowPositions();
-    
     // Handle window added to the window manager
     void handleWindowAdded(Window *window);
     
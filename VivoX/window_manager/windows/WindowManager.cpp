@@ -1,9 +1,12 @@
 #include "WindowManager.h"
+#include "WindowRegistry.h"
+#include "WindowRules.h"
 #include "Window.h"
 #include "../workspaces/WindowWorkspace.h"
 #include "../groups/WindowGroup.h"
 #include "../layouts/WindowLayout.h"
 #include "../layouts/LayoutEngine.h"
+#include "../../core/configuration/ConfigManager.h"
 
 #include <iostream>
 #include <algorithm>
@@ -36,9 +39,12 @@ public:
         
         // Create default workspace
         auto defaultWorkspace = std::make_shared<WindowWorkspace>(m_nextWorkspaceId++, "Default");
-        m_workspaces.push_back(defaultWorkspace);
+        addWorkspace(defaultWorkspace);
         m_currentWorkspace = defaultWorkspace;
         
+        // Compile the configured window rules
+        reloadWindowRules();
+        
         m_initialized = true;
         return true;
     }
@@ -48,9 +54,15 @@ public:
             return;
         }
         
+        // No reloads once the rules' owner is going away
+        if (!m_rulesFile.empty()) {
+            Core::Configuration::ConfigManager::getInstance()->unwatchConfigFile(m_rulesFile);
+            m_rulesFile.clear();
+        }
+        
         // Clear all windows, groups, and workspaces
-        m_windows.clear();
-        m_windowsById.clear();
+        m_registry.clear();
+        m_windowSlots.clear();
         m_groups.clear();
         m_groupsById.clear();
         m_groupsByName.clear();
@@ -67,31 +79,117 @@ public:
         return m_initialized;
     }
     
-    std::shared_ptr<Window> createWindow(const std::string& title, int x, int y, int width, int height, WindowType type) {
+    WindowRules& getWindowRules() {
+        return m_rules;
+    }
+    
+    bool reloadWindowRules() {
+        auto config = Core::Configuration::ConfigManager::getInstance();
+        std::lock_guard<std::mutex> lock(m_rulesMutex);
+        m_rules.loadFromConfig(*config);
+        return m_rules.getStats().rejectedRules == 0;
+    }
+    
+    bool watchWindowRules(const std::filesystem::path& filePath) {
+        auto config = Core::Configuration::ConfigManager::getInstance();
+        if (!m_rulesFile.empty()) {
+            config->unwatchConfigFile(m_rulesFile);
+            m_rulesFile.clear();
+        }
+        
+        // Called on the watcher thread; loading merges, so the old rules are removed first
+        bool watching = config->watchConfigFile(filePath, [this, filePath]() {
+            auto config = Core::Configuration::ConfigManager::getInstance();
+            for (const std::string& key : config->getKeysWithPrefix("windowRules.")) {
+                config->removeKey(key);
+            }
+            if (config->loadFromFile(filePath)) {
+                reloadWindowRules();
+            }
+        });
+        if (watching) {
+            m_rulesFile = filePath;
+        }
+        
+        return watching;
+    }
+    
+    // Look a window up in the registry; IDs are never reused, so the ID identifies it
+    WindowHandle findHandle(const std::shared_ptr<Window>& window) const {
+        return window ? m_registry.find(window->getId()) : WindowHandle();
+    }
+    
+    // Set a window's state and mirror it in the registry's state flags
+    void setWindowState(WindowHandle handle, const std::shared_ptr<Window>& window, WindowState state) {
+        window->setState(state);
+        
+        uint32_t flags = m_registry.flags(handle)
+            & ~(WindowRegistry::Minimized | WindowRegistry::Maximized | WindowRegistry::Fullscreen);
+        if (state == WindowState::Minimized) {
+            flags |= WindowRegistry::Minimized;
+        } else if (state == WindowState::Maximized) {
+            flags |= WindowRegistry::Maximized;
+        } else if (state == WindowState::Fullscreen) {
+            flags |= WindowRegistry::Fullscreen;
+        }
+        m_registry.setFlags(handle, flags);
+    }
+    
+    std::shared_ptr<Window> createWindow(const std::string& title, int x, int y, int width, int height, WindowType type,
+                                         const std::string& appId) {
         if (!m_initialized) {
             std::cerr << "WindowManager not initialized" << std::endl;
             return nullptr;
         }
         
+        // Match the window against the rules
+        WindowRuleQuery query;
+        query.appId = appId;
+        query.title = title;
+        query.type = type;
+        WindowRuleResult rules;
+        {
+            std::lock_guard<std::mutex> lock(m_rulesMutex);
+            rules = m_rules.evaluate(query);
+        }
+        if (rules.geometry) {
+            x = rules.geometry->x;
+            y = rules.geometry->y;
+            width = rules.geometry->width;
+            height = rules.geometry->height;
+        }
+        
+        std::shared_ptr<WindowWorkspace> workspace = m_currentWorkspace;
+        if (rules.workspace) {
+            if (auto target = getWorkspace(*rules.workspace)) {
+                workspace = target;
+            }
+        }
+        
         // Create window
         auto window = std::make_shared<Window>(m_nextWindowId++, title, x, y, width, height, type);
         
-        // Add to lists
-        m_windows.push_back(window);
-        m_windowsById[window->getId()] = window;
+        // Register it on top of its workspace
+        uint32_t workspaceId = workspace ? workspace->getId() : 0;
+        WindowHandle handle = m_registry.insert(window->getId(), { x, y, width, height }, workspaceId);
+        if (m_windowSlots.size() <= handle.index) {
+            m_windowSlots.resize(handle.index + 1);
+        }
+        m_windowSlots[handle.index] = window;
         
-        // Add to current workspace
-        if (m_currentWorkspace) {
-            m_currentWorkspace->addWindow(window);
+        if (rules.floating && !*rules.floating) {
+            setWindowState(handle, window, WindowState::Tiled);
+        }
+        
+        if (workspace) {
+            workspace->addWindow(window);
         }
         
         // If this is the first window, activate it
-        if (m_windows.size() == 1 && !m_activeWindow) {
+        if (m_registry.size() == 1 && !m_activeWindow) {
             activateWindow(window);
         }
         
-        std::cout << "Created window: " << window->getId() << " - " << title << std::endl;
-        
         return window;
     }
     
@@ -103,66 +201,81 @@ public:
         uint32_t windowId = window->getId();
         
         // Check if window exists
-        auto it = m_windowsById.find(windowId);
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << windowId << std::endl;
             return false;
         }
         
-        // If this is the active window, clear it
-        if (m_activeWindow == window) {
-            m_activeWindow = nullptr;
-            
-            // Activate another window if available
-            if (!m_windows.empty()) {
-                // Find the next window to activate
-                auto it = std::find(m_windows.begin(), m_windows.end(), window);
-                if (it != m_windows.end() && it + 1 != m_windows.end()) {
-                    // Activate the next window
-                    activateWindow(*(it + 1));
-                } else if (!m_windows.empty()) {
-                    // Activate the first window
-                    activateWindow(m_windows.front());
-                }
+        // Remove from its workspace and groups, found through the registry's indexes
+        if (auto workspace = getWorkspace(m_registry.workspace(handle))) {
+            workspace->removeWindow(window);
+        }
+        for (uint32_t groupId : m_registry.groupsOf(handle)) {
+            if (auto group = getWindowGroup(groupId)) {
+                group->removeWindow(window);
             }
         }
         
-        // Remove from workspace
-        for (auto& workspace : m_workspaces) {
-            workspace->removeWindow(window);
-        }
+        // Remove from the registry
+        uint32_t workspaceId = m_registry.workspace(handle);
+        m_registry.remove(handle);
+        m_windowSlots[handle.index] = nullptr;
         
-        // Remove from groups
-        for (auto& group : m_groups) {
-            group->removeWindow(window);
+        // If this was the active window, activate the topmost one left on its workspace
+        if (m_activeWindow == window) {
+            m_activeWindow = nullptr;
+            
+            WindowHandle next = m_registry.topmost(workspaceId, WindowRegistry::Minimized);
+            if (!next.isNull()) {
+                activateWindow(m_windowSlots[next.index]);
+            }
         }
         
-        // Remove from lists
-        m_windows.erase(std::remove(m_windows.begin(), m_windows.end(), window), m_windows.end());
-        m_windowsById.erase(windowId);
-        
         std::cout << "Destroyed window: " << windowId << std::endl;
         
         return true;
     }
     
     std::vector<std::shared_ptr<Window>> getWindows() const {
-        return m_windows;
+        // Bottom of the stack first, as before
+        std::vector<WindowHandle> order;
+        m_registry.stackingOrder(order);
+        
+        std::vector<std::shared_ptr<Window>> result;
+        result.reserve(order.size());
+        for (WindowHandle handle : order) {
+            result.push_back(m_windowSlots[handle.index]);
+        }
+        
+        return result;
     }
     
     std::shared_ptr<Window> getWindow(uint32_t id) const {
-        auto it = m_windowsById.find(id);
-        if (it == m_windowsById.end()) {
+        return getWindow(m_registry.find(id));
+    }
+    
+    std::shared_ptr<Window> getWindow(WindowHandle handle) const {
+        if (!m_registry.contains(handle)) {
             return nullptr;
         }
         
-        return it->second;
+        return m_windowSlots[handle.index];
+    }
+    
+    WindowHandle getWindowHandle(uint32_t id) const {
+        return m_registry.find(id);
+    }
+    
+    const WindowRegistry& getWindowRegistry() const {
+        return m_registry;
     }
     
     std::vector<std::shared_ptr<Window>> getWindowsByType(WindowType type) const {
         std::vector<std::shared_ptr<Window>> result;
         
-        for (const auto& window : m_windows) {
+        for (WindowHandle handle : m_registry.handles()) {
+            const auto& window = m_windowSlots[handle.index];
             if (window->getType() == type) {
                 result.push_back(window);
             }
@@ -172,12 +285,15 @@ public:
     }
     
     std::vector<std::shared_ptr<Window>> getWindowsByWorkspace(uint32_t workspaceId) const {
-        auto workspace = getWorkspace(workspaceId);
-        if (!workspace) {
-            return {};
+        auto members = m_registry.windowsOnWorkspace(workspaceId);
+        
+        std::vector<std::shared_ptr<Window>> result;
+        result.reserve(members.size());
+        for (WindowHandle handle : members) {
+            result.push_back(m_windowSlots[handle.index]);
         }
         
-        return workspace->getWindows();
+        return result;
     }
     
     std::shared_ptr<Window> getActiveWindow() const {
@@ -190,8 +306,8 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
@@ -203,22 +319,18 @@ public:
         
         // Deactivate current active window
         if (m_activeWindow) {
-            m_activeWindow->setState(WindowState::Normal);
+            setWindowState(findHandle(m_activeWindow), m_activeWindow, WindowState::Normal);
         }
         
         // Set new active window
         m_activeWindow = window;
         
         // Raise the window to the top
-        m_windows.erase(std::remove(m_windows.begin(), m_windows.end(), window), m_windows.end());
-        m_windows.push_back(window);
+        m_registry.raise(handle);
         
         // Switch to the workspace containing the window
-        for (auto& workspace : m_workspaces) {
-            if (workspace->containsWindow(window)) {
-                switchToWorkspace(workspace);
-                break;
-            }
+        if (auto workspace = getWorkspace(m_registry.workspace(handle))) {
+            switchToWorkspace(workspace);
         }
         
         std::cout << "Activated window: " << window->getId() << std::endl;
@@ -232,14 +344,14 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Set window state
-        window->setState(WindowState::Maximized);
+        setWindowState(handle, window, WindowState::Maximized);
         
         std::cout << "Maximized window: " << window->getId() << std::endl;
         
@@ -252,25 +364,22 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Set window state
-        window->setState(WindowState::Minimized);
+        setWindowState(handle, window, WindowState::Minimized);
         
-        // If this is the active window, activate another window
+        // If this is the active window, activate the topmost one left on its workspace
         if (m_activeWindow == window) {
             m_activeWindow = nullptr;
             
-            // Find another window to activate
-            for (auto& w : m_windows) {
-                if (w != window && w->getState() != WindowState::Minimized) {
-                    activateWindow(w);
-                    break;
-                }
+            WindowHandle next = m_registry.topmost(m_registry.workspace(handle), WindowRegistry::Minimized);
+            if (!next.isNull()) {
+                activateWindow(m_windowSlots[next.index]);
             }
         }
         
@@ -285,14 +394,14 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Set window state
-        window->setState(WindowState::Normal);
+        setWindowState(handle, window, WindowState::Normal);
         
         std::cout << "Restored window: " << window->getId() << std::endl;
         
@@ -305,14 +414,14 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Set window state
-        window->setState(fullscreen ? WindowState::Fullscreen : WindowState::Normal);
+        setWindowState(handle, window, fullscreen ? WindowState::Fullscreen : WindowState::Normal);
         
         std::cout << "Set fullscreen for window: " << window->getId() << " - " << (fullscreen ? "true" : "false") << std::endl;
         
@@ -325,14 +434,15 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Move window
         window->setPosition(x, y);
+        m_registry.move(handle, x, y);
         
         std::cout << "Moved window: " << window->getId() << " to (" << x << ", " << y << ")" << std::endl;
         
@@ -345,14 +455,18 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Resize window
         window->setSize(width, height);
+        WindowRegistry::Geometry geometry = m_registry.geometry(handle);
+        geometry.width = width;
+        geometry.height = height;
+        m_registry.setGeometry(handle, geometry);
         
         std::cout << "Resized window: " << window->getId() << " to " << width << "x" << height << std::endl;
         
@@ -365,15 +479,14 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Raise window
-        m_windows.erase(std::remove(m_windows.begin(), m_windows.end(), window), m_windows.end());
-        m_windows.push_back(window);
+        m_registry.raise(handle);
         
         std::cout << "Raised window: " << window->getId() << std::endl;
         
@@ -386,15 +499,14 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
         
         // Lower window
-        m_windows.erase(std::remove(m_windows.begin(), m_windows.end(), window), m_windows.end());
-        m_windows.insert(m_windows.begin(), window);
+        m_registry.lower(handle);
         
         std::cout << "Lowered window: " << window->getId() << std::endl;
         
@@ -407,8 +519,8 @@ public:
         }
         
         // Check if window exists
-        auto it = m_windowsById.find(window->getId());
-        if (it == m_windowsById.end()) {
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
             std::cerr << "Window not found: " << window->getId() << std::endl;
             return false;
         }
@@ -482,7 +594,8 @@ public:
         // Set window position and size
         window->setPosition(x, y);
         window->setSize(width, height);
-        window->setState(WindowState::Snapped);
+        m_registry.setGeometry(handle, { x, y, width, height });
+        setWindowState(handle, window, WindowState::Snapped);
         
         std::cout << "Snapped window: " << window->getId() << " to position " << static_cast<int>(position) << std::endl;
         
@@ -517,5 +630,611 @@ public:
         
         // Get screen dimensions (for now, hardcoded)
         int screenWidth = 1920;
-        int screenHeight = 108
-(Content truncated due to size limit. Use line ranges to read in chunks)
\ No newline at end of file
+        int screenHeight = 1080;
+        
+        // Calculate the geometry of each window
+        const int count = static_cast<int>(windows.size());
+        int columns = 1;
+        int rows = 1;
+        if (layout == "grid") {
+            while (columns * columns < count) {
+                columns++;
+            }
+            rows = (count + columns - 1) / columns;
+        } else if (layout == "horizontal") {
+            columns = count;
+        } else if (layout == "vertical") {
+            rows = count;
+        } else {
+            std::cerr << "Unknown layout: " << layout << std::endl;
+            return false;
+        }
+        
+        const int cellWidth = screenWidth / columns;
+        const int cellHeight = screenHeight / rows;
+        for (int i = 0; i < count; ++i) {
+            const auto& window = windows[i];
+            WindowHandle handle = findHandle(window);
+            if (handle.isNull()) {
+                continue;
+            }
+            
+            const int x = (i % columns) * cellWidth;
+            const int y = (i / columns) * cellHeight;
+            window->setPosition(x, y);
+            window->setSize(cellWidth, cellHeight);
+            m_registry.setGeometry(handle, { x, y, cellWidth, cellHeight });
+            setWindowState(handle, window, WindowState::Tiled);
+        }
+        
+        std::cout << "Tiled " << count << " windows with layout: " << layout << std::endl;
+        
+        return true;
+    }
+    
+    std::shared_ptr<WindowGroup> createWindowGroup(const std::string& name, const std::vector<std::shared_ptr<Window>>& windows) {
+        if (!m_initialized) {
+            return nullptr;
+        }
+        
+        // Check if a group with this name already exists
+        if (m_groupsByName.find(name) != m_groupsByName.end()) {
+            std::cerr << "Window group already exists: " << name << std::endl;
+            return nullptr;
+        }
+        
+        // Create group
+        auto group = std::make_shared<WindowGroup>(m_nextGroupId++, name);
+        
+        // Add the windows, in the group and in the registry's group index
+        for (const auto& window : windows) {
+            WindowHandle handle = findHandle(window);
+            if (handle.isNull()) {
+                continue;
+            }
+            
+            group->addWindow(window);
+            m_registry.addToGroup(handle, group->getId());
+        }
+        
+        // Add to lists
+        m_groups.push_back(group);
+        m_groupsById[group->getId()] = group;
+        m_groupsByName[name] = group;
+        
+        return group;
+    }
+    
+    bool destroyWindowGroup(std::shared_ptr<WindowGroup> group) {
+        if (!m_initialized || !group) {
+            return false;
+        }
+        
+        // Check if group exists
+        auto it = m_groupsById.find(group->getId());
+        if (it == m_groupsById.end() || it->second != group) {
+            std::cerr << "Window group not found: " << group->getId() << std::endl;
+            return false;
+        }
+        
+        // Take its windows out of it, so the registry no longer lists them in the group
+        std::vector<WindowHandle> members(m_registry.windowsInGroup(group->getId()).begin(),
+                                          m_registry.windowsInGroup(group->getId()).end());
+        for (WindowHandle handle : members) {
+            group->removeWindow(m_windowSlots[handle.index]);
+        }
+        m_registry.removeGroup(group->getId());
+        
+        // Remove from lists
+        m_groups.erase(std::remove(m_groups.begin(), m_groups.end(), group), m_groups.end());
+        m_groupsById.erase(it);
+        m_groupsByName.erase(group->getName());
+        
+        return true;
+    }
+    
+    std::vector<std::shared_ptr<WindowGroup>> getWindowGroups() const {
+        return m_groups;
+    }
+    
+    std::shared_ptr<WindowGroup> getWindowGroup(uint32_t id) const {
+        auto it = m_groupsById.find(id);
+        return it != m_groupsById.end() ? it->second : nullptr;
+    }
+    
+    std::shared_ptr<WindowGroup> getWindowGroupByName(const std::string& name) const {
+        auto it = m_groupsByName.find(name);
+        return it != m_groupsByName.end() ? it->second : nullptr;
+    }
+    
+    std::shared_ptr<WindowWorkspace> createWorkspace(const std::string& name) {
+        if (!m_initialized) {
+            return nullptr;
+        }
+        
+        // Check if a workspace with this name already exists
+        if (m_workspacesByName.find(name) != m_workspacesByName.end()) {
+            std::cerr << "Workspace already exists: " << name << std::endl;
+            return nullptr;
+        }
+        
+        // Create workspace
+        auto workspace = std::make_shared<WindowWorkspace>(m_nextWorkspaceId++, name);
+        addWorkspace(workspace);
+        
+        return workspace;
+    }
+    
+    bool destroyWorkspace(std::shared_ptr<WindowWorkspace> workspace) {
+        if (!m_initialized || !workspace) {
+            return false;
+        }
+        
+        // Check if workspace exists
+        auto it = m_workspacesById.find(workspace->getId());
+        if (it == m_workspacesById.end() || it->second != workspace) {
+            std::cerr << "Workspace not found: " << workspace->getId() << std::endl;
+            return false;
+        }
+        
+        // The last workspace stays
+        if (m_workspaces.size() == 1) {
+            std::cerr << "Cannot destroy the last workspace" << std::endl;
+            return false;
+        }
+        
+        // Its windows go to the first workspace left
+        std::shared_ptr<WindowWorkspace> fallback = m_workspaces.front() != workspace ? m_workspaces.front() : m_workspaces[1];
+        if (m_currentWorkspace == workspace) {
+            switchToWorkspace(fallback);
+        }
+        
+        std::vector<WindowHandle> members(m_registry.windowsOnWorkspace(workspace->getId()).begin(),
+                                          m_registry.windowsOnWorkspace(workspace->getId()).end());
+        for (WindowHandle handle : members) {
+            moveWindowToWorkspace(m_windowSlots[handle.index], fallback);
+        }
+        
+        // Remove from lists
+        m_workspaces.erase(std::remove(m_workspaces.begin(), m_workspaces.end(), workspace), m_workspaces.end());
+        m_workspacesById.erase(it);
+        m_workspacesByName.erase(workspace->getName());
+        
+        return true;
+    }
+    
+    std::vector<std::shared_ptr<WindowWorkspace>> getWorkspaces() const {
+        return m_workspaces;
+    }
+    
+    std::shared_ptr<WindowWorkspace> getWorkspace(uint32_t id) const {
+        auto it = m_workspacesById.find(id);
+        return it != m_workspacesById.end() ? it->second : nullptr;
+    }
+    
+    std::shared_ptr<WindowWorkspace> getWorkspaceByName(const std::string& name) const {
+        auto it = m_workspacesByName.find(name);
+        return it != m_workspacesByName.end() ? it->second : nullptr;
+    }
+    
+    std::shared_ptr<WindowWorkspace> getCurrentWorkspace() const {
+        return m_currentWorkspace;
+    }
+    
+    bool switchToWorkspace(std::shared_ptr<WindowWorkspace> workspace) {
+        if (!m_initialized || !workspace) {
+            return false;
+        }
+        
+        // Check if workspace exists
+        if (getWorkspace(workspace->getId()) != workspace) {
+            std::cerr << "Workspace not found: " << workspace->getId() << std::endl;
+            return false;
+        }
+        
+        // If already current, do nothing
+        if (m_currentWorkspace == workspace) {
+            return true;
+        }
+        
+        m_currentWorkspace = workspace;
+        
+        // Focus follows the switch unless the active window is already on the workspace
+        if (!m_activeWindow || m_registry.workspace(findHandle(m_activeWindow)) != workspace->getId()) {
+            m_activeWindow = nullptr;
+            
+            WindowHandle next = m_registry.topmost(workspace->getId(), WindowRegistry::Minimized);
+            if (!next.isNull()) {
+                activateWindow(m_windowSlots[next.index]);
+            }
+        }
+        
+        std::cout << "Switched to workspace: " << workspace->getId() << std::endl;
+        
+        return true;
+    }
+    
+    bool moveWindowToWorkspace(std::shared_ptr<Window> window, std::shared_ptr<WindowWorkspace> workspace) {
+        if (!m_initialized || !window || !workspace) {
+            return false;
+        }
+        
+        // Check if window exists
+        WindowHandle handle = findHandle(window);
+        if (handle.isNull()) {
+            std::cerr << "Window not found: " << window->getId() << std::endl;
+            return false;
+        }
+        
+        // Check if workspace exists
+        if (getWorkspace(workspace->getId()) != workspace) {
+            std::cerr << "Workspace not found: " << workspace->getId() << std::endl;
+            return false;
+        }
+        
+        // Move it in the workspaces and in the registry's workspace index, which destroyWindow relies on
+        if (auto current = getWorkspace(m_registry.workspace(handle))) {
+            if (current == workspace) {
+                return true;
+            }
+            current->removeWindow(window);
+        }
+        workspace->addWindow(window);
+        m_registry.setWorkspace(handle, workspace->getId());
+        
+        std::cout << "Moved window: " << window->getId() << " to workspace " << workspace->getId() << std::endl;
+        
+        return true;
+    }
+    
+    std::vector<std::string> getAvailableLayouts() const {
+        std::vector<std::string> layouts = { "default", "grid", "horizontal", "vertical" };
+        for (const auto& [name, _] : m_savedLayouts) {
+            layouts.push_back(name);
+        }
+        
+        return layouts;
+    }
+    
+    std::string getCurrentLayout() const {
+        return m_currentLayout;
+    }
+    
+    bool setCurrentLayout(const std::string& layout) {
+        if (!m_initialized) {
+            return false;
+        }
+        
+        // Saved layouts restore geometries, the others tile the current workspace
+        if (m_savedLayouts.find(layout) != m_savedLayouts.end()) {
+            if (!loadLayout(layout)) {
+                return false;
+            }
+        } else if (layout != "default" && !tileWindows(layout, 0)) {
+            return false;
+        }
+        
+        m_currentLayout = layout;
+        return true;
+    }
+    
+    bool saveLayout(const std::string& name) {
+        if (!m_initialized || name.empty()) {
+            return false;
+        }
+        
+        // Keep the geometry of every window, by ID
+        std::vector<SavedGeometry> geometries;
+        geometries.reserve(m_registry.size());
+        auto handles = m_registry.handles();
+        auto stored = m_registry.geometries();
+        for (size_t i = 0; i < handles.size(); ++i) {
+            geometries.push_back({ m_registry.id(handles[i]), stored[i] });
+        }
+        m_savedLayouts[name] = std::move(geometries);
+        
+        return true;
+    }
+    
+    bool loadLayout(const std::string& name) {
+        if (!m_initialized) {
+            return false;
+        }
+        
+        auto it = m_savedLayouts.find(name);
+        if (it == m_savedLayouts.end()) {
+            std::cerr << "Layout not found: " << name << std::endl;
+            return false;
+        }
+        
+        // Windows closed since the layout was saved are skipped
+        for (const SavedGeometry& saved : it->second) {
+            WindowHandle handle = m_registry.find(saved.id);
+            if (handle.isNull()) {
+                continue;
+            }
+            
+            const auto& window = m_windowSlots[handle.index];
+            window->setPosition(saved.geometry.x, saved.geometry.y);
+            window->setSize(saved.geometry.width, saved.geometry.height);
+            m_registry.setGeometry(handle, saved.geometry);
+        }
+        
+        return true;
+    }
+    
+    bool deleteLayout(const std::string& name) {
+        if (m_savedLayouts.erase(name) == 0) {
+            return false;
+        }
+        
+        if (m_currentLayout == name) {
+            m_currentLayout = "default";
+        }
+        
+        return true;
+    }
+    
+private:
+    struct SavedGeometry {
+        uint32_t id;
+        WindowRegistry::Geometry geometry;
+    };
+    
+    void addWorkspace(const std::shared_ptr<WindowWorkspace>& workspace) {
+        m_workspaces.push_back(workspace);
+        m_workspacesById[workspace->getId()] = workspace;
+        m_workspacesByName[workspace->getName()] = workspace;
+    }
+    
+    bool m_initialized;
+    uint32_t m_nextWindowId;
+    uint32_t m_nextGroupId;
+    uint32_t m_nextWorkspaceId;
+    std::string m_currentLayout;
+    
+    // Windows; the registry holds their hot data, the slots the objects, by handle index
+    WindowRegistry m_registry;
+    std::vector<std::shared_ptr<Window>> m_windowSlots;
+    
+    std::vector<std::shared_ptr<WindowGroup>> m_groups;
+    std::map<uint32_t, std::shared_ptr<WindowGroup>> m_groupsById;
+    std::map<std::string, std::shared_ptr<WindowGroup>> m_groupsByName;
+    
+    std::vector<std::shared_ptr<WindowWorkspace>> m_workspaces;
+    std::map<uint32_t, std::shared_ptr<WindowWorkspace>> m_workspacesById;
+    std::map<std::string, std::shared_ptr<WindowWorkspace>> m_workspacesByName;
+    std::shared_ptr<WindowWorkspace> m_currentWorkspace;
+    
+    std::shared_ptr<Window> m_activeWindow;
+    
+    // Window rules; reloads from the watched file come from the configuration's watcher thread
+    WindowRules m_rules;
+    std::mutex m_rulesMutex;
+    std::filesystem::path m_rulesFile;
+    
+    // Saved layouts, window geometries by name
+    std::map<std::string, std::vector<SavedGeometry>> m_savedLayouts;
+};
+
+std::shared_ptr<WindowManager> WindowManager::s_instance = nullptr;
+std::mutex WindowManager::s_instanceMutex;
+
+std::shared_ptr<WindowManager> WindowManager::getInstance() {
+    std::lock_guard<std::mutex> lock(s_instanceMutex);
+    
+    if (!s_instance) {
+        s_instance = std::shared_ptr<WindowManager>(new WindowManager());
+    }
+    
+    return s_instance;
+}
+
+WindowManager::WindowManager() : m_impl(std::make_unique<Impl>()), m_nextCallbackId(1) {
+}
+
+WindowManager::~WindowManager() {
+}
+
+bool WindowManager::initialize() {
+    return m_impl->initialize();
+}
+
+void WindowManager::shutdown() {
+    m_impl->shutdown();
+}
+
+bool WindowManager::isInitialized() const {
+    return m_impl->isInitialized();
+}
+
+std::shared_ptr<Window> WindowManager::createWindow(const std::string& title, int x, int y, int width, int height, WindowType type,
+                                                    const std::string& appId) {
+    return m_impl->createWindow(title, x, y, width, height, type, appId);
+}
+
+bool WindowManager::destroyWindow(std::shared_ptr<Window> window) {
+    return m_impl->destroyWindow(window);
+}
+
+std::vector<std::shared_ptr<Window>> WindowManager::getWindows() const {
+    return m_impl->getWindows();
+}
+
+std::shared_ptr<Window> WindowManager::getWindow(uint32_t id) const {
+    return m_impl->getWindow(id);
+}
+
+std::shared_ptr<Window> WindowManager::getWindow(WindowHandle handle) const {
+    return m_impl->getWindow(handle);
+}
+
+WindowHandle WindowManager::getWindowHandle(uint32_t id) const {
+    return m_impl->getWindowHandle(id);
+}
+
+const WindowRegistry& WindowManager::getWindowRegistry() const {
+    return m_impl->getWindowRegistry();
+}
+
+std::vector<std::shared_ptr<Window>> WindowManager::getWindowsByType(WindowType type) const {
+    return m_impl->getWindowsByType(type);
+}
+
+std::vector<std::shared_ptr<Window>> WindowManager::getWindowsByWorkspace(uint32_t workspaceId) const {
+    return m_impl->getWindowsByWorkspace(workspaceId);
+}
+
+std::shared_ptr<Window> WindowManager::getActiveWindow() const {
+    return m_impl->getActiveWindow();
+}
+
+bool WindowManager::activateWindow(std::shared_ptr<Window> window) {
+    return m_impl->activateWindow(window);
+}
+
+bool WindowManager::maximizeWindow(std::shared_ptr<Window> window) {
+    return m_impl->maximizeWindow(window);
+}
+
+bool WindowManager::minimizeWindow(std::shared_ptr<Window> window) {
+    return m_impl->minimizeWindow(window);
+}
+
+bool WindowManager::restoreWindow(std::shared_ptr<Window> window) {
+    return m_impl->restoreWindow(window);
+}
+
+bool WindowManager::setFullscreen(std::shared_ptr<Window> window, bool fullscreen) {
+    return m_impl->setFullscreen(window, fullscreen);
+}
+
+bool WindowManager::moveWindow(std::shared_ptr<Window> window, int x, int y) {
+    return m_impl->moveWindow(window, x, y);
+}
+
+bool WindowManager::resizeWindow(std::shared_ptr<Window> window, int width, int height) {
+    return m_impl->resizeWindow(window, width, height);
+}
+
+bool WindowManager::raiseWindow(std::shared_ptr<Window> window) {
+    return m_impl->raiseWindow(window);
+}
+
+bool WindowManager::lowerWindow(std::shared_ptr<Window> window) {
+    return m_impl->lowerWindow(window);
+}
+
+bool WindowManager::snapWindow(std::shared_ptr<Window> window, SnapPosition position) {
+    return m_impl->snapWindow(window, position);
+}
+
+bool WindowManager::tileWindows(const std::string& layout, uint32_t workspaceId) {
+    return m_impl->tileWindows(layout, workspaceId);
+}
+
+std::shared_ptr<WindowGroup> WindowManager::createWindowGroup(const std::string& name, const std::vector<std::shared_ptr<Window>>& windows) {
+    return m_impl->createWindowGroup(name, windows);
+}
+
+bool WindowManager::destroyWindowGroup(std::shared_ptr<WindowGroup> group) {
+    return m_impl->destroyWindowGroup(group);
+}
+
+std::vector<std::shared_ptr<WindowGroup>> WindowManager::getWindowGroups() const {
+    return m_impl->getWindowGroups();
+}
+
+std::shared_ptr<WindowGroup> WindowManager::getWindowGroup(uint32_t id) const {
+    return m_impl->getWindowGroup(id);
+}
+
+std::shared_ptr<WindowGroup> WindowManager::getWindowGroupByName(const std::string& name) const {
+    return m_impl->getWindowGroupByName(name);
+}
+
+std::shared_ptr<WindowWorkspace> WindowManager::createWorkspace(const std::string& name) {
+    return m_impl->createWorkspace(name);
+}
+
+bool WindowManager::destroyWorkspace(std::shared_ptr<WindowWorkspace> workspace) {
+    return m_impl->destroyWorkspace(workspace);
+}
+
+std::vector<std::shared_ptr<WindowWorkspace>> WindowManager::getWorkspaces() const {
+    return m_impl->getWorkspaces();
+}
+
+std::shared_ptr<WindowWorkspace> WindowManager::getWorkspace(uint32_t id) const {
+    return m_impl->getWorkspace(id);
+}
+
+std::shared_ptr<WindowWorkspace> WindowManager::getWorkspaceByName(const std::string& name) const {
+    return m_impl->getWorkspaceByName(name);
+}
+
+std::shared_ptr<WindowWorkspace> WindowManager::getCurrentWorkspace() const {
+    return m_impl->getCurrentWorkspace();
+}
+
+bool WindowManager::switchToWorkspace(std::shared_ptr<WindowWorkspace> workspace) {
+    return m_impl->switchToWorkspace(workspace);
+}
+
+bool WindowManager::moveWindowToWorkspace(std::shared_ptr<Window> window, std::shared_ptr<WindowWorkspace> workspace) {
+    return m_impl->moveWindowToWorkspace(window, workspace);
+}
+
+int WindowManager::registerWindowEventCallback(std::function<void(const std::string&, std::shared_ptr<Window>)> callback) {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    
+    int callbackId = m_nextCallbackId++;
+    m_windowEventCallbacks[callbackId] = callback;
+    return callbackId;
+}
+
+bool WindowManager::unregisterWindowEventCallback(int callbackId) {
+    std::lock_guard<std::mutex> lock(m_callbackMutex);
+    
+    return m_windowEventCallbacks.erase(callbackId) > 0;
+}
+
+std::vector<std::string> WindowManager::getAvailableLayouts() const {
+    return m_impl->getAvailableLayouts();
+}
+
+std::string WindowManager::getCurrentLayout() const {
+    return m_impl->getCurrentLayout();
+}
+
+bool WindowManager::setCurrentLayout(const std::string& layout) {
+    return m_impl->setCurrentLayout(layout);
+}
+
+bool WindowManager::saveLayout(const std::string& name) {
+    return m_impl->saveLayout(name);
+}
+
+bool WindowManager::loadLayout(const std::string& name) {
+    return m_impl->loadLayout(name);
+}
+
+bool WindowManager::deleteLayout(const std::string& name) {
+    return m_impl->deleteLayout(name);
+}
+
+WindowRules& WindowManager::getWindowRules() {
+    return m_impl->getWindowRules();
+}
+
+bool WindowManager::reloadWindowRules() {
+    return m_impl->reloadWindowRules();
+}
+
+bool WindowManager::watchWindowRules(const std::filesystem::path& filePath) {
+    return m_impl->watchWindowRules(filePath);
+}
+
+} // namespace Windows
+} // namespace WindowManager
+} // namespace VivoX
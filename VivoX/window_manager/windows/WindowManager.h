@@ -6,6 +6,9 @@
 #include <map>
 #include <functional>
 #include <mutex>
+#include <filesystem>
+
+#include "WindowRegistry.h"
 
 namespace VivoX {
 namespace WindowManager {
@@ -15,6 +18,7 @@ class Window;
 class WindowGroup;
 class WindowLayout;
 class WindowWorkspace;
+class WindowRules;
 
 /**
  * @brief Window state enumeration
@@ -75,6 +79,10 @@ enum class SnapPosition {
  * - Window workspaces
  * - Window focus management
  * - Window event handling
+ * 
+ * Windows are kept in a WindowRegistry: stable handles, O(1) lookup and
+ * removal, and packed geometry, stacking, state and workspace data that
+ * can be iterated without copying.
  */
 class WindowManager {
 public:
@@ -109,9 +117,11 @@ public:
      * @param width Window width
      * @param height Window height
      * @param type Window type
+     * @param appId Application ID the window rules match on, empty if unknown
      * @return Shared pointer to the created window, or nullptr if creation failed
      */
-    std::shared_ptr<Window> createWindow(const std::string& title, int x, int y, int width, int height, WindowType type = WindowType::Normal);
+    std::shared_ptr<Window> createWindow(const std::string& title, int x, int y, int width, int height, WindowType type = WindowType::Normal,
+                                         const std::string& appId = std::string());
     
     /**
      * @brief Destroy a window
@@ -122,7 +132,10 @@ public:
     
     /**
      * @brief Get all windows
-     * @return Vector of all windows
+     * 
+     * Copies the windows; use getWindowRegistry() to iterate without allocating.
+     * 
+     * @return Vector of all windows, from the bottom of the stack to the top
      */
     std::vector<std::shared_ptr<Window>> getWindows() const;
     
@@ -133,6 +146,31 @@ public:
      */
     std::shared_ptr<Window> getWindow(uint32_t id) const;
     
+    /**
+     * @brief Get a window by handle
+     * @param handle Window handle
+     * @return Shared pointer to the window, or nullptr if the handle is stale
+     */
+    std::shared_ptr<Window> getWindow(WindowHandle handle) const;
+    
+    /**
+     * @brief Get the handle of a window
+     * @param id Window ID
+     * @return The window's handle, or a null handle if it wasn't found
+     */
+    WindowHandle getWindowHandle(uint32_t id) const;
+    
+    /**
+     * @brief Get the window registry
+     * 
+     * The registry's views give the geometry, stacking position, state and
+     * workspace of every window, and the windows of a workspace or group,
+     * without copying.
+     * 
+     * @return The registry
+     */
+    const WindowRegistry& getWindowRegistry() const;
+    
     /**
      * @brief Get windows by type
      * @param type Window type
@@ -380,6 +418,36 @@ public:
      * @return True if the operation was successful, false otherwise
      */
     bool deleteLayout(const std::string& name);
+    
+    /**
+     * @brief Get the window rules
+     * 
+     * The rules are matched against every window when it is created, and
+     * are loaded from the "windowRules" configuration on initialization.
+     * Changing them directly isn't synchronized with reloads from a file
+     * watched with watchWindowRules().
+     * 
+     * @return The window rules
+     */
+    WindowRules& getWindowRules();
+    
+    /**
+     * @brief Reload the window rules from the configuration
+     * @return True if every configured rule was compiled, false if some were rejected
+     */
+    bool reloadWindowRules();
+    
+    /**
+     * @brief Reload the window rules whenever a configuration file changes
+     * 
+     * The file is loaded into the configuration and the rules are compiled
+     * again on the configuration's watcher thread; rules removed from the
+     * file are dropped. Replaces the file watched before, if any.
+     * 
+     * @param filePath Path to the configuration file holding the rules
+     * @return True if the file is being watched
+     */
+    bool watchWindowRules(const std::filesystem::path& filePath);
 
 private:
     WindowManager();
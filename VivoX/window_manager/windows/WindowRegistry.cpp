@@ -0,0 +1,409 @@
+#include "WindowRegistry.h"
+
+#include <algorithm>
+
+namespace VivoX {
+namespace WindowManager {
+namespace Windows {
+
+namespace {
+    const uint32_t npos = UINT32_MAX;
+}
+
+WindowRegistry::WindowRegistry()
+    : m_topZ(0)
+    , m_bottomZ(0)
+{
+}
+
+WindowRegistry::~WindowRegistry() {
+}
+
+WindowHandle WindowRegistry::insert(uint32_t id, const Geometry& geometry, uint32_t workspace, uint32_t flags) {
+    if (m_byId.count(id)) {
+        return WindowHandle();
+    }
+
+    // Reuse a free slot; its generation already moved past any old handle
+    uint32_t index;
+    if (!m_freeSlots.empty()) {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.push_back({ npos, 0 });
+    }
+
+    const uint32_t dense = static_cast<uint32_t>(m_handles.size());
+    const WindowHandle handle = { index, m_slots[index].generation };
+    m_slots[index].dense = dense;
+
+    m_handles.push_back(handle);
+    m_geometries.push_back(geometry);
+    m_z.push_back(++m_topZ);
+    m_flags.push_back(flags);
+    m_workspaces.push_back(workspace);
+    m_ids.push_back(id);
+    m_workspacePositions.push_back(0);
+    m_groups.emplace_back();
+    m_groupPositions.emplace_back();
+
+    attachToWorkspace(dense, workspace);
+    m_byId[id] = handle;
+    return handle;
+}
+
+bool WindowRegistry::remove(WindowHandle handle) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    detachFromWorkspace(dense);
+    while (!m_groups[dense].empty()) {
+        detachFromGroup(dense, m_groups[dense].size() - 1);
+    }
+    m_byId.erase(m_ids[dense]);
+
+    // Move the last window into the hole
+    const uint32_t last = static_cast<uint32_t>(m_handles.size()) - 1;
+    if (dense != last) {
+        m_handles[dense] = m_handles[last];
+        m_geometries[dense] = m_geometries[last];
+        m_z[dense] = m_z[last];
+        m_flags[dense] = m_flags[last];
+        m_workspaces[dense] = m_workspaces[last];
+        m_ids[dense] = m_ids[last];
+        m_workspacePositions[dense] = m_workspacePositions[last];
+        m_groups[dense] = std::move(m_groups[last]);
+        m_groupPositions[dense] = std::move(m_groupPositions[last]);
+        m_slots[m_handles[dense].index].dense = dense;
+    }
+
+    m_handles.pop_back();
+    m_geometries.pop_back();
+    m_z.pop_back();
+    m_flags.pop_back();
+    m_workspaces.pop_back();
+    m_ids.pop_back();
+    m_workspacePositions.pop_back();
+    m_groups.pop_back();
+    m_groupPositions.pop_back();
+
+    Slot& slot = m_slots[handle.index];
+    slot.dense = npos;
+    slot.generation++;
+    m_freeSlots.push_back(handle.index);
+    return true;
+}
+
+void WindowRegistry::clear() {
+    // Keep the slots, so handles handed out before stay stale
+    for (uint32_t index = 0; index < m_slots.size(); ++index) {
+        if (m_slots[index].dense != npos) {
+            m_slots[index].dense = npos;
+            m_slots[index].generation++;
+            m_freeSlots.push_back(index);
+        }
+    }
+
+    m_handles.clear();
+    m_geometries.clear();
+    m_z.clear();
+    m_flags.clear();
+    m_workspaces.clear();
+    m_ids.clear();
+    m_workspacePositions.clear();
+    m_groups.clear();
+    m_groupPositions.clear();
+    m_byId.clear();
+    m_workspaceMembers.clear();
+    m_groupMembers.clear();
+    m_topZ = 0;
+    m_bottomZ = 0;
+}
+
+bool WindowRegistry::contains(WindowHandle handle) const {
+    return denseIndex(handle) != npos;
+}
+
+WindowHandle WindowRegistry::find(uint32_t id) const {
+    auto it = m_byId.find(id);
+    return it != m_byId.end() ? it->second : WindowHandle();
+}
+
+size_t WindowRegistry::size() const {
+    return m_handles.size();
+}
+
+uint32_t WindowRegistry::id(WindowHandle handle) const {
+    const uint32_t dense = denseIndex(handle);
+    return dense != npos ? m_ids[dense] : 0;
+}
+
+WindowRegistry::Geometry WindowRegistry::geometry(WindowHandle handle) const {
+    const uint32_t dense = denseIndex(handle);
+    return dense != npos ? m_geometries[dense] : Geometry();
+}
+
+bool WindowRegistry::setGeometry(WindowHandle handle, const Geometry& geometry) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    m_geometries[dense] = geometry;
+    return true;
+}
+
+bool WindowRegistry::move(WindowHandle handle, int x, int y) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    m_geometries[dense].x = x;
+    m_geometries[dense].y = y;
+    return true;
+}
+
+int64_t WindowRegistry::z(WindowHandle handle) const {
+    const uint32_t dense = denseIndex(handle);
+    return dense != npos ? m_z[dense] : 0;
+}
+
+bool WindowRegistry::raise(WindowHandle handle) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    // Positions only need to be ordered, not consecutive
+    if (m_z[dense] != m_topZ) {
+        m_z[dense] = ++m_topZ;
+    }
+    return true;
+}
+
+bool WindowRegistry::lower(WindowHandle handle) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    if (m_z[dense] != m_bottomZ) {
+        m_z[dense] = --m_bottomZ;
+    }
+    return true;
+}
+
+uint32_t WindowRegistry::flags(WindowHandle handle) const {
+    const uint32_t dense = denseIndex(handle);
+    return dense != npos ? m_flags[dense] : 0;
+}
+
+bool WindowRegistry::setFlags(WindowHandle handle, uint32_t flags) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    m_flags[dense] = flags;
+    return true;
+}
+
+uint32_t WindowRegistry::workspace(WindowHandle handle) const {
+    const uint32_t dense = denseIndex(handle);
+    return dense != npos ? m_workspaces[dense] : 0;
+}
+
+bool WindowRegistry::setWorkspace(WindowHandle handle, uint32_t workspace) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    if (m_workspaces[dense] != workspace) {
+        detachFromWorkspace(dense);
+        m_workspaces[dense] = workspace;
+        attachToWorkspace(dense, workspace);
+    }
+    return true;
+}
+
+bool WindowRegistry::addToGroup(WindowHandle handle, uint32_t group) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos || isInGroup(handle, group)) {
+        return false;
+    }
+
+    std::vector<WindowHandle>& members = m_groupMembers[group];
+    m_groups[dense].push_back(group);
+    m_groupPositions[dense].push_back(static_cast<uint32_t>(members.size()));
+    members.push_back(handle);
+    return true;
+}
+
+bool WindowRegistry::removeFromGroup(WindowHandle handle, uint32_t group) {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    const std::vector<uint32_t>& groups = m_groups[dense];
+    auto it = std::find(groups.begin(), groups.end(), group);
+    if (it == groups.end()) {
+        return false;
+    }
+
+    detachFromGroup(dense, static_cast<size_t>(it - groups.begin()));
+    return true;
+}
+
+size_t WindowRegistry::removeGroup(uint32_t group) {
+    auto it = m_groupMembers.find(group);
+    if (it == m_groupMembers.end()) {
+        return 0;
+    }
+
+    // The whole member list goes, so only the windows' side needs updating
+    const size_t count = it->second.size();
+    for (const WindowHandle& member : it->second) {
+        const uint32_t dense = denseIndex(member);
+        std::vector<uint32_t>& groups = m_groups[dense];
+        const size_t membership = static_cast<size_t>(std::find(groups.begin(), groups.end(), group) - groups.begin());
+        groups[membership] = groups.back();
+        groups.pop_back();
+        m_groupPositions[dense][membership] = m_groupPositions[dense].back();
+        m_groupPositions[dense].pop_back();
+    }
+
+    m_groupMembers.erase(it);
+    return count;
+}
+
+bool WindowRegistry::isInGroup(WindowHandle handle, uint32_t group) const {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return false;
+    }
+
+    const std::vector<uint32_t>& groups = m_groups[dense];
+    return std::find(groups.begin(), groups.end(), group) != groups.end();
+}
+
+WindowRegistry::Range<WindowHandle> WindowRegistry::handles() const {
+    return Range<WindowHandle>(m_handles.data(), m_handles.data() + m_handles.size());
+}
+
+WindowRegistry::Range<WindowRegistry::Geometry> WindowRegistry::geometries() const {
+    return Range<Geometry>(m_geometries.data(), m_geometries.data() + m_geometries.size());
+}
+
+WindowRegistry::Range<int64_t> WindowRegistry::stackPositions() const {
+    return Range<int64_t>(m_z.data(), m_z.data() + m_z.size());
+}
+
+WindowRegistry::Range<uint32_t> WindowRegistry::allFlags() const {
+    return Range<uint32_t>(m_flags.data(), m_flags.data() + m_flags.size());
+}
+
+WindowRegistry::Range<uint32_t> WindowRegistry::workspaces() const {
+    return Range<uint32_t>(m_workspaces.data(), m_workspaces.data() + m_workspaces.size());
+}
+
+WindowRegistry::Range<WindowHandle> WindowRegistry::windowsOnWorkspace(uint32_t workspace) const {
+    auto it = m_workspaceMembers.find(workspace);
+    if (it == m_workspaceMembers.end()) {
+        return Range<WindowHandle>();
+    }
+    return Range<WindowHandle>(it->second.data(), it->second.data() + it->second.size());
+}
+
+WindowRegistry::Range<WindowHandle> WindowRegistry::windowsInGroup(uint32_t group) const {
+    auto it = m_groupMembers.find(group);
+    if (it == m_groupMembers.end()) {
+        return Range<WindowHandle>();
+    }
+    return Range<WindowHandle>(it->second.data(), it->second.data() + it->second.size());
+}
+
+WindowRegistry::Range<uint32_t> WindowRegistry::groupsOf(WindowHandle handle) const {
+    const uint32_t dense = denseIndex(handle);
+    if (dense == npos) {
+        return Range<uint32_t>();
+    }
+    return Range<uint32_t>(m_groups[dense].data(), m_groups[dense].data() + m_groups[dense].size());
+}
+
+void WindowRegistry::stackingOrder(std::vector<WindowHandle>& order) const {
+    order.assign(m_handles.begin(), m_handles.end());
+    std::sort(order.begin(), order.end(), [this](WindowHandle a, WindowHandle b) {
+        return m_z[m_slots[a.index].dense] < m_z[m_slots[b.index].dense];
+    });
+}
+
+WindowHandle WindowRegistry::topmost(uint32_t workspace, uint32_t excludedFlags) const {
+    WindowHandle result;
+    int64_t resultZ = 0;
+    for (const WindowHandle& handle : windowsOnWorkspace(workspace)) {
+        const uint32_t dense = m_slots[handle.index].dense;
+        if ((m_flags[dense] & excludedFlags) == 0 && (result.isNull() || m_z[dense] > resultZ)) {
+            result = handle;
+            resultZ = m_z[dense];
+        }
+    }
+    return result;
+}
+
+uint32_t WindowRegistry::denseIndex(WindowHandle handle) const {
+    if (handle.index >= m_slots.size() || m_slots[handle.index].generation != handle.generation) {
+        return npos;
+    }
+    return m_slots[handle.index].dense;
+}
+
+void WindowRegistry::detachFromWorkspace(uint32_t dense) {
+    std::vector<WindowHandle>& members = m_workspaceMembers[m_workspaces[dense]];
+    const uint32_t position = m_workspacePositions[dense];
+
+    // Move the last member into the hole
+    const WindowHandle moved = members.back();
+    members[position] = moved;
+    members.pop_back();
+    if (moved != m_handles[dense]) {
+        m_workspacePositions[m_slots[moved.index].dense] = position;
+    }
+}
+
+void WindowRegistry::attachToWorkspace(uint32_t dense, uint32_t workspace) {
+    std::vector<WindowHandle>& members = m_workspaceMembers[workspace];
+    m_workspacePositions[dense] = static_cast<uint32_t>(members.size());
+    members.push_back(m_handles[dense]);
+}
+
+void WindowRegistry::detachFromGroup(uint32_t dense, size_t membership) {
+    const uint32_t group = m_groups[dense][membership];
+    const uint32_t position = m_groupPositions[dense][membership];
+    std::vector<WindowHandle>& members = m_groupMembers[group];
+
+    // Move the group's last member into the hole and tell it where it went
+    const WindowHandle moved = members.back();
+    members[position] = moved;
+    members.pop_back();
+    if (moved != m_handles[dense]) {
+        const uint32_t movedDense = m_slots[moved.index].dense;
+        const std::vector<uint32_t>& groups = m_groups[movedDense];
+        const size_t movedMembership = static_cast<size_t>(std::find(groups.begin(), groups.end(), group) - groups.begin());
+        m_groupPositions[movedDense][movedMembership] = position;
+    }
+
+    m_groups[dense][membership] = m_groups[dense].back();
+    m_groups[dense].pop_back();
+    m_groupPositions[dense][membership] = m_groupPositions[dense].back();
+    m_groupPositions[dense].pop_back();
+}
+
+} // namespace Windows
+} // namespace WindowManager
+} // namespace VivoX
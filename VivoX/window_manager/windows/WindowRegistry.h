@@ -0,0 +1,346 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace VivoX {
+namespace WindowManager {
+namespace Windows {
+
+/**
+ * @brief Stable reference to a window in a WindowRegistry
+ *
+ * A handle stays valid while its window is registered. Once the window is
+ * removed, the handle goes stale and never refers to another window, even
+ * when its slot is reused.
+ */
+struct WindowHandle {
+    uint32_t index = UINT32_MAX;    ///< Slot of the window
+    uint32_t generation = 0;        ///< Generation of the slot when the window was registered
+
+    bool isNull() const { return index == UINT32_MAX; }
+    bool operator==(const WindowHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const WindowHandle& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Window store with stable handles and contiguous hot data
+ *
+ * Windows live in a slot map: a handle names a slot, and the slot points
+ * into dense arrays holding each window's hot data (geometry, stacking
+ * position, state flags and workspace) side by side. Removing a window moves
+ * the last one into its place, so insertion, removal and lookup are O(1)
+ * and the arrays stay packed for iteration.
+ *
+ * Workspaces and groups are indexed the other way round as well, so the
+ * windows of a workspace or group, and the groups of a window, are found
+ * without scanning.
+ *
+ * Views returned by the registry don't allocate; they are invalidated by
+ * inserting or removing windows, or by changing the membership they show.
+ */
+class WindowRegistry {
+public:
+    /**
+     * @brief Window geometry
+     */
+    struct Geometry {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    /**
+     * @brief Window state flags
+     */
+    enum Flag : uint32_t {
+        Visible = 1 << 0,
+        Minimized = 1 << 1,
+        Maximized = 1 << 2,
+        Fullscreen = 1 << 3
+    };
+
+    /**
+     * @brief Read-only view of contiguous elements
+     */
+    template <typename T>
+    class Range {
+    public:
+        Range() : m_begin(nullptr), m_end(nullptr) {}
+        Range(const T* begin, const T* end) : m_begin(begin), m_end(end) {}
+
+        const T* begin() const { return m_begin; }
+        const T* end() const { return m_end; }
+        size_t size() const { return static_cast<size_t>(m_end - m_begin); }
+        bool empty() const { return m_begin == m_end; }
+        const T& operator[](size_t index) const { return m_begin[index]; }
+
+    private:
+        const T* m_begin;
+        const T* m_end;
+    };
+
+    WindowRegistry();
+    ~WindowRegistry();
+
+    /**
+     * @brief Register a window on top of the stack
+     * @param id Window ID
+     * @param geometry Window geometry
+     * @param workspace Workspace ID
+     * @param flags State flags
+     * @return Handle of the window, or a null handle if the ID is taken
+     */
+    WindowHandle insert(uint32_t id, const Geometry& geometry, uint32_t workspace, uint32_t flags = Visible);
+
+    /**
+     * @brief Unregister a window and remove it from its workspace and groups
+     * @param handle Window handle
+     * @return True if the window was registered
+     */
+    bool remove(WindowHandle handle);
+
+    /**
+     * @brief Unregister all windows
+     */
+    void clear();
+
+    /**
+     * @brief Check if a handle refers to a registered window
+     * @param handle Window handle
+     * @return True if the window is registered
+     */
+    bool contains(WindowHandle handle) const;
+
+    /**
+     * @brief Find a window by ID
+     * @param id Window ID
+     * @return Handle of the window, or a null handle if it isn't registered
+     */
+    WindowHandle find(uint32_t id) const;
+
+    /**
+     * @brief Get the number of registered windows
+     * @return The number of windows
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the ID of a window
+     * @param handle Window handle
+     * @return The window ID, or 0 if the handle is stale
+     */
+    uint32_t id(WindowHandle handle) const;
+
+    /**
+     * @brief Get the geometry of a window
+     * @param handle Window handle
+     * @return The geometry, empty if the handle is stale
+     */
+    Geometry geometry(WindowHandle handle) const;
+
+    /**
+     * @brief Set the geometry of a window
+     * @param handle Window handle
+     * @param geometry New geometry
+     * @return True if the window is registered
+     */
+    bool setGeometry(WindowHandle handle, const Geometry& geometry);
+
+    /**
+     * @brief Move a window
+     * @param handle Window handle
+     * @param x New X position
+     * @param y New Y position
+     * @return True if the window is registered
+     */
+    bool move(WindowHandle handle, int x, int y);
+
+    /**
+     * @brief Get the stacking position of a window
+     * @param handle Window handle
+     * @return The position; higher is closer to the top
+     */
+    int64_t z(WindowHandle handle) const;
+
+    /**
+     * @brief Raise a window to the top of the stack
+     * @param handle Window handle
+     * @return True if the window is registered
+     */
+    bool raise(WindowHandle handle);
+
+    /**
+     * @brief Lower a window to the bottom of the stack
+     * @param handle Window handle
+     * @return True if the window is registered
+     */
+    bool lower(WindowHandle handle);
+
+    /**
+     * @brief Get the state flags of a window
+     * @param handle Window handle
+     * @return The flags, 0 if the handle is stale
+     */
+    uint32_t flags(WindowHandle handle) const;
+
+    /**
+     * @brief Set the state flags of a window
+     * @param handle Window handle
+     * @param flags New flags
+     * @return True if the window is registered
+     */
+    bool setFlags(WindowHandle handle, uint32_t flags);
+
+    /**
+     * @brief Get the workspace of a window
+     * @param handle Window handle
+     * @return The workspace ID, 0 if the handle is stale
+     */
+    uint32_t workspace(WindowHandle handle) const;
+
+    /**
+     * @brief Move a window to another workspace
+     * @param handle Window handle
+     * @param workspace Workspace ID
+     * @return True if the window is registered
+     */
+    bool setWorkspace(WindowHandle handle, uint32_t workspace);
+
+    /**
+     * @brief Add a window to a group
+     * @param handle Window handle
+     * @param group Group ID
+     * @return True if the window was added, false if it's stale or already in the group
+     */
+    bool addToGroup(WindowHandle handle, uint32_t group);
+
+    /**
+     * @brief Remove a window from a group
+     * @param handle Window handle
+     * @param group Group ID
+     * @return True if the window was in the group
+     */
+    bool removeFromGroup(WindowHandle handle, uint32_t group);
+
+    /**
+     * @brief Remove every window from a group
+     * @param group Group ID
+     * @return The number of windows that were in the group
+     */
+    size_t removeGroup(uint32_t group);
+
+    /**
+     * @brief Check if a window is in a group
+     * @param handle Window handle
+     * @param group Group ID
+     * @return True if the window is in the group
+     */
+    bool isInGroup(WindowHandle handle, uint32_t group) const;
+
+    /**
+     * @brief Get the handles of all windows, in storage order
+     * @return View of the handles; the hot data views below are in the same order
+     */
+    Range<WindowHandle> handles() const;
+
+    /**
+     * @brief Get the geometries of all windows, in storage order
+     * @return View of the geometries
+     */
+    Range<Geometry> geometries() const;
+
+    /**
+     * @brief Get the stacking positions of all windows, in storage order
+     * @return View of the stacking positions
+     */
+    Range<int64_t> stackPositions() const;
+
+    /**
+     * @brief Get the state flags of all windows, in storage order
+     * @return View of the flags
+     */
+    Range<uint32_t> allFlags() const;
+
+    /**
+     * @brief Get the workspaces of all windows, in storage order
+     * @return View of the workspace IDs
+     */
+    Range<uint32_t> workspaces() const;
+
+    /**
+     * @brief Get the windows on a workspace
+     * @param workspace Workspace ID
+     * @return View of the handles, in no particular order
+     */
+    Range<WindowHandle> windowsOnWorkspace(uint32_t workspace) const;
+
+    /**
+     * @brief Get the windows in a group
+     * @param group Group ID
+     * @return View of the handles, in no particular order
+     */
+    Range<WindowHandle> windowsInGroup(uint32_t group) const;
+
+    /**
+     * @brief Get the groups a window is in
+     * @param handle Window handle
+     * @return View of the group IDs
+     */
+    Range<uint32_t> groupsOf(WindowHandle handle) const;
+
+    /**
+     * @brief Get the windows from the bottom of the stack to the top
+     * @param order Filled with the handles; its capacity is reused
+     */
+    void stackingOrder(std::vector<WindowHandle>& order) const;
+
+    /**
+     * @brief Find the topmost window on a workspace
+     * @param workspace Workspace ID
+     * @param excludedFlags Windows with any of these flags are skipped
+     * @return Handle of the window, or a null handle if there is none
+     */
+    WindowHandle topmost(uint32_t workspace, uint32_t excludedFlags = 0) const;
+
+private:
+    struct Slot {
+        uint32_t dense;             // Index into the dense arrays, npos while free
+        uint32_t generation;
+    };
+
+    uint32_t denseIndex(WindowHandle handle) const;
+    void detachFromWorkspace(uint32_t dense);
+    void attachToWorkspace(uint32_t dense, uint32_t workspace);
+    void detachFromGroup(uint32_t dense, size_t membership);
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+
+    // Hot data, one element per window
+    std::vector<WindowHandle> m_handles;
+    std::vector<Geometry> m_geometries;
+    std::vector<int64_t> m_z;
+    std::vector<uint32_t> m_flags;
+    std::vector<uint32_t> m_workspaces;
+
+    // Cold data, one element per window
+    std::vector<uint32_t> m_ids;
+    std::vector<uint32_t> m_workspacePositions;           // Position in the workspace's member list
+    std::vector<std::vector<uint32_t>> m_groups;          // Groups of the window
+    std::vector<std::vector<uint32_t>> m_groupPositions;  // Position in each group's member list
+
+    std::unordered_map<uint32_t, WindowHandle> m_byId;
+    std::unordered_map<uint32_t, std::vector<WindowHandle>> m_workspaceMembers;
+    std::unordered_map<uint32_t, std::vector<WindowHandle>> m_groupMembers;
+
+    int64_t m_topZ;
+    int64_t m_bottomZ;
+};
+
+} // namespace Windows
+} // namespace WindowManager
+} // namespace VivoX
@@ -0,0 +1,317 @@
+#include "WindowRules.h"
+#include "../../core/configuration/ConfigManager.h"
+
+#include <algorithm>
+#include <map>
+
+namespace VivoX {
+namespace WindowManager {
+namespace Windows {
+
+namespace {
+    const size_t maxEffects = 64;
+
+    const std::pair<const char*, WindowType> typeNames[] = {
+        { "normal", WindowType::Normal },
+        { "dialog", WindowType::Dialog },
+        { "popup", WindowType::Popup },
+        { "utility", WindowType::Utility },
+        { "splash", WindowType::Splash },
+        { "notification", WindowType::Notification },
+        { "dock", WindowType::Dock },
+        { "desktop", WindowType::Desktop },
+        { "menu", WindowType::Menu }
+    };
+
+    // The configuration keeps arrays as their JSON text; only arrays of strings are expected
+    std::vector<std::string> parseStringArray(const std::string& json) {
+        std::vector<std::string> values;
+        size_t pos = 0;
+        while ((pos = json.find('"', pos)) != std::string::npos) {
+            const size_t end = json.find('"', pos + 1);
+            if (end == std::string::npos) {
+                break;
+            }
+            values.push_back(json.substr(pos + 1, end - pos - 1));
+            pos = end + 1;
+        }
+        return values;
+    }
+}
+
+WindowRules::WindowRules()
+    : m_rejectedRules(0)
+    , m_evaluations(0)
+    , m_cacheHits(0)
+    , m_titleMatches(0)
+    , m_generation(0)
+{
+}
+
+WindowRules::~WindowRules() {
+}
+
+size_t WindowRules::setRules(const std::vector<WindowRule>& rules) {
+    m_rules.clear();
+    m_compiled.clear();
+    m_patterns.clear();
+    m_outputs.clear();
+    m_effects.clear();
+    m_byApp.clear();
+    m_anyApp.clear();
+    m_cache.clear();
+    m_rejectedRules = 0;
+    m_generation++;
+
+    // Lower priorities first, so the rules merged last win
+    std::vector<const WindowRule*> sorted;
+    sorted.reserve(rules.size());
+    for (const WindowRule& rule : rules) {
+        sorted.push_back(&rule);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const WindowRule* a, const WindowRule* b) {
+        return a->priority < b->priority;
+    });
+
+    for (const WindowRule* rule : sorted) {
+        CompiledRule compiled;
+        compiled.types = rule->types;
+        compiled.output = -1;
+        compiled.pattern = -1;
+        compiled.effects = 0;
+
+        if (!rule->title.empty()) {
+            try {
+                m_patterns.emplace_back(rule->title, std::regex::ECMAScript | std::regex::optimize);
+            } catch (const std::regex_error&) {
+                m_rejectedRules++;
+                continue;
+            }
+            compiled.pattern = static_cast<int>(m_patterns.size() - 1);
+        }
+
+        bool effectsValid = true;
+        for (const std::string& effect : rule->effects) {
+            int id = effectId(effect);
+            if (id < 0 && m_effects.size() < maxEffects) {
+                m_effects.push_back(effect);
+                id = static_cast<int>(m_effects.size() - 1);
+            }
+            if (id < 0) {
+                effectsValid = false;
+                break;
+            }
+            compiled.effects |= uint64_t(1) << id;
+        }
+        if (!effectsValid) {
+            if (compiled.pattern >= 0) {
+                m_patterns.pop_back();
+            }
+            m_rejectedRules++;
+            continue;
+        }
+
+        if (!rule->output.empty()) {
+            auto it = std::find(m_outputs.begin(), m_outputs.end(), rule->output);
+            compiled.output = static_cast<int>(it - m_outputs.begin());
+            if (it == m_outputs.end()) {
+                m_outputs.push_back(rule->output);
+            }
+        }
+
+        const uint32_t index = static_cast<uint32_t>(m_rules.size());
+        m_rules.push_back(*rule);
+        m_compiled.push_back(compiled);
+        if (rule->appId.empty()) {
+            m_anyApp.push_back(index);
+        } else {
+            m_byApp[rule->appId].push_back(index);
+        }
+    }
+
+    return m_rules.size();
+}
+
+size_t WindowRules::loadFromConfig(const Core::Configuration::ConfigManager& config, const std::string& prefix) {
+    // Collect the rule names; the map keeps them in a stable order
+    const std::string keyPrefix = prefix + ".";
+    std::map<std::string, bool> names;
+    for (const std::string& key : config.getKeysWithPrefix(keyPrefix)) {
+        const size_t end = key.find('.', keyPrefix.size());
+        if (end != std::string::npos) {
+            names[key.substr(keyPrefix.size(), end - keyPrefix.size())] = true;
+        }
+    }
+
+    std::vector<WindowRule> rules;
+    rules.reserve(names.size());
+    for (const auto& item : names) {
+        const std::string base = keyPrefix + item.first + ".";
+        WindowRule rule;
+        rule.name = item.first;
+        rule.priority = config.getValue<int>(base + "priority", 0);
+        rule.appId = config.getValue<std::string>(base + "appId", "");
+        rule.title = config.getValue<std::string>(base + "title", "");
+        rule.output = config.getValue<std::string>(base + "output", "");
+
+        for (const std::string& name : parseStringArray(config.getValue<std::string>(base + "types", ""))) {
+            if (std::optional<WindowType> type = typeFromName(name)) {
+                rule.types |= 1u << static_cast<uint32_t>(*type);
+            }
+        }
+
+        if (config.hasKey(base + "workspace")) {
+            rule.workspace = static_cast<uint32_t>(config.getValue<int>(base + "workspace", 0));
+        }
+        if (config.hasKey(base + "floating")) {
+            rule.floating = config.getValue<bool>(base + "floating", false);
+        }
+        if (config.hasKey(base + "opacity")) {
+            // Whole numbers are read as integers
+            const double opacity = config.getValue<double>(base + "opacity",
+                                                           config.getValue<int>(base + "opacity", 1));
+            rule.opacity = static_cast<float>(std::clamp(opacity, 0.0, 1.0));
+        }
+        if (config.hasKey(base + "geometry.width") && config.hasKey(base + "geometry.height")) {
+            WindowRegistry::Geometry geometry;
+            geometry.x = config.getValue<int>(base + "geometry.x", 0);
+            geometry.y = config.getValue<int>(base + "geometry.y", 0);
+            geometry.width = config.getValue<int>(base + "geometry.width", 0);
+            geometry.height = config.getValue<int>(base + "geometry.height", 0);
+            rule.geometry = geometry;
+        }
+        rule.effects = parseStringArray(config.getValue<std::string>(base + "effects", ""));
+
+        rules.push_back(std::move(rule));
+    }
+
+    return setRules(rules);
+}
+
+const std::vector<WindowRule>& WindowRules::getRules() const {
+    return m_rules;
+}
+
+WindowRuleResult WindowRules::evaluate(const WindowRuleQuery& query) {
+    m_evaluations++;
+    const CacheEntry& entry = entryFor(query);
+    if (entry.rules.empty()) {
+        return entry.fixed;
+    }
+
+    // Some rules of the application look at the title, which changes from window to window
+    WindowRuleResult result;
+    for (uint32_t rule : entry.rules) {
+        const int pattern = m_compiled[rule].pattern;
+        if (pattern >= 0) {
+            m_titleMatches++;
+            if (!std::regex_search(query.title.begin(), query.title.end(), m_patterns[pattern])) {
+                continue;
+            }
+        }
+        merge(result, rule);
+    }
+    return result;
+}
+
+std::string WindowRules::effectName(int id) const {
+    return id >= 0 && static_cast<size_t>(id) < m_effects.size() ? m_effects[id] : std::string();
+}
+
+int WindowRules::effectId(const std::string& name) const {
+    auto it = std::find(m_effects.begin(), m_effects.end(), name);
+    return it != m_effects.end() ? static_cast<int>(it - m_effects.begin()) : -1;
+}
+
+WindowRules::Stats WindowRules::getStats() const {
+    Stats stats;
+    stats.rules = m_rules.size();
+    stats.rejectedRules = m_rejectedRules;
+    stats.cachedEntries = m_cache.size();
+    stats.evaluations = m_evaluations;
+    stats.cacheHits = m_cacheHits;
+    stats.titleMatches = m_titleMatches;
+    stats.generation = m_generation;
+    return stats;
+}
+
+std::optional<WindowType> WindowRules::typeFromName(std::string_view name) {
+    for (const auto& item : typeNames) {
+        if (name == item.first) {
+            return item.second;
+        }
+    }
+    return std::nullopt;
+}
+
+void WindowRules::merge(WindowRuleResult& result, uint32_t rule) const {
+    const WindowRule& source = m_rules[rule];
+    if (source.workspace) {
+        result.workspace = source.workspace;
+    }
+    if (source.floating) {
+        result.floating = source.floating;
+    }
+    if (source.opacity) {
+        result.opacity = source.opacity;
+    }
+    if (source.geometry) {
+        result.geometry = source.geometry;
+    }
+    result.effects |= m_compiled[rule].effects;
+    result.matchedRules++;
+}
+
+const WindowRules::CacheEntry& WindowRules::entryFor(const WindowRuleQuery& query) {
+    // The key buffer is reused, so cached lookups don't allocate
+    m_key.assign(query.appId.data(), query.appId.size());
+    m_key.push_back('\0');
+    m_key.append(query.output.data(), query.output.size());
+    m_key.push_back('\0');
+    m_key.push_back(static_cast<char>(query.type));
+
+    auto cached = m_cache.find(m_key);
+    if (cached != m_cache.end()) {
+        m_cacheHits++;
+        return cached->second;
+    }
+
+    // Merge the application's rules with those for any application, keeping the priority order
+    static const std::vector<uint32_t> none;
+    auto app = m_byApp.find(std::string(query.appId));
+    const std::vector<uint32_t>& own = app != m_byApp.end() ? app->second : none;
+
+    std::vector<uint32_t> candidates;
+    candidates.reserve(own.size() + m_anyApp.size());
+    std::merge(own.begin(), own.end(), m_anyApp.begin(), m_anyApp.end(), std::back_inserter(candidates));
+
+    const uint32_t typeBit = 1u << static_cast<uint32_t>(query.type);
+    CacheEntry entry;
+    bool matchesTitle = false;
+    for (uint32_t rule : candidates) {
+        const CompiledRule& compiled = m_compiled[rule];
+        if (compiled.types != 0 && !(compiled.types & typeBit)) {
+            continue;
+        }
+        if (compiled.output >= 0 && m_outputs[compiled.output] != query.output) {
+            continue;
+        }
+        entry.rules.push_back(rule);
+        matchesTitle = matchesTitle || compiled.pattern >= 0;
+    }
+
+    // Without title patterns the outcome is the same for every window of the application
+    if (!matchesTitle) {
+        for (uint32_t rule : entry.rules) {
+            merge(entry.fixed, rule);
+        }
+        entry.rules.clear();
+        entry.rules.shrink_to_fit();
+    }
+
+    return m_cache.emplace(m_key, std::move(entry)).first->second;
+}
+
+} // namespace Windows
+} // namespace WindowManager
+} // namespace VivoX
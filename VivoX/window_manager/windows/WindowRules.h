@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "WindowManager.h"
+#include "WindowRegistry.h"
+
+namespace VivoX {
+namespace Core {
+namespace Configuration {
+class ConfigManager;
+}
+}
+
+namespace WindowManager {
+namespace Windows {
+
+/**
+ * @brief Rule applied to matching windows when they are mapped
+ *
+ * Every condition left empty matches any window. The actions left unset
+ * leave the window as it is.
+ */
+struct WindowRule {
+    std::string name;
+    int priority = 0;                   ///< Rules with a higher priority override those with a lower one
+
+    // Conditions
+    std::string appId;                  ///< Exact application ID
+    std::string title;                  ///< ECMAScript regular expression searched in the title
+    uint32_t types = 0;                 ///< Mask of (1 << WindowType) values
+    std::string output;                 ///< Name of the output the window is mapped on
+
+    // Actions
+    std::optional<uint32_t> workspace;
+    std::optional<bool> floating;
+    std::optional<float> opacity;
+    std::optional<WindowRegistry::Geometry> geometry;
+    std::vector<std::string> effects;   ///< Effects added to the window
+};
+
+/**
+ * @brief Window to be matched against the rules
+ */
+struct WindowRuleQuery {
+    std::string_view appId;
+    std::string_view title;
+    WindowType type = WindowType::Normal;
+    std::string_view output;
+};
+
+/**
+ * @brief Actions of all rules matching a window, merged
+ */
+struct WindowRuleResult {
+    std::optional<uint32_t> workspace;
+    std::optional<bool> floating;
+    std::optional<float> opacity;
+    std::optional<WindowRegistry::Geometry> geometry;
+    uint64_t effects = 0;               ///< Mask of effect IDs, see WindowRules::effectName()
+    uint32_t matchedRules = 0;          ///< Number of rules that matched
+};
+
+/**
+ * @brief Per-application window rules, compiled into a decision table
+ *
+ * Rules are sorted by priority once, when they are set, and indexed by
+ * application ID; rules for any application are merged into every
+ * application's list. Checking a window then only walks the rules of its
+ * application.
+ *
+ * The outcome of the rules that don't look at the title is cached per
+ * application ID, window type and output, so mapping another window of an
+ * application is a hash lookup. Only rules matching on the title are
+ * evaluated for every window, and only for windows of their application.
+ * Setting new rules, e.g. when the configuration is reloaded, clears the
+ * cache.
+ *
+ * Effects are identified by bits in a mask, so at most 64 distinct effects
+ * can be used.
+ */
+class WindowRules {
+public:
+    /**
+     * @brief Rule engine statistics
+     */
+    struct Stats {
+        size_t rules = 0;               ///< Rules compiled
+        size_t rejectedRules = 0;       ///< Rules dropped for an invalid pattern or too many effects
+        size_t cachedEntries = 0;       ///< Application, type and output combinations cached
+        uint64_t evaluations = 0;       ///< Windows matched in total
+        uint64_t cacheHits = 0;         ///< Windows whose application was cached
+        uint64_t titleMatches = 0;      ///< Title patterns evaluated in total
+        uint64_t generation = 0;        ///< Number of times the rules were set
+    };
+
+    WindowRules();
+    ~WindowRules();
+
+    /**
+     * @brief Replace the rules and compile them
+     * @param rules The rules
+     * @return The number of rules compiled; invalid ones are dropped
+     */
+    size_t setRules(const std::vector<WindowRule>& rules);
+
+    /**
+     * @brief Replace the rules with those of the configuration
+     *
+     * Each rule is an object under the prefix, named by its key, e.g.
+     * "windowRules.terminal.appId". Its fields are appId, title, types (an
+     * array of type names), output, priority, workspace, floating, opacity,
+     * geometry.x/y/width/height and effects (an array of names).
+     *
+     * @param config The configuration
+     * @param prefix Key of the rules object
+     * @return The number of rules compiled
+     */
+    size_t loadFromConfig(const Core::Configuration::ConfigManager& config, const std::string& prefix = "windowRules");
+
+    /**
+     * @brief Get the rules
+     * @return The rules, sorted by priority from lowest to highest
+     */
+    const std::vector<WindowRule>& getRules() const;
+
+    /**
+     * @brief Match a window against the rules
+     * @param query The window
+     * @return The merged actions of the matching rules
+     */
+    WindowRuleResult evaluate(const WindowRuleQuery& query);
+
+    /**
+     * @brief Get the name of an effect
+     * @param id Bit of the effect in WindowRuleResult::effects
+     * @return The name, or an empty string if no rule uses the effect
+     */
+    std::string effectName(int id) const;
+
+    /**
+     * @brief Get the bit of an effect
+     * @param name The effect
+     * @return The bit in WindowRuleResult::effects, or -1 if no rule uses the effect
+     */
+    int effectId(const std::string& name) const;
+
+    /**
+     * @brief Get the rule engine statistics
+     * @return The statistics
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief Parse a window type name
+     * @param name The name, e.g. "dialog"
+     * @return The type, or nothing if the name is unknown
+     */
+    static std::optional<WindowType> typeFromName(std::string_view name);
+
+private:
+    struct CompiledRule {
+        uint32_t types;
+        int output;                     // Index into m_outputs, -1 for any
+        int pattern;                    // Index into m_patterns, -1 if the title isn't matched
+        uint64_t effects;
+    };
+
+    struct CacheEntry {
+        WindowRuleResult fixed;         // Outcome when no rule matches on the title
+        std::vector<uint32_t> rules;    // Rules that passed, when some match on the title
+    };
+
+    void merge(WindowRuleResult& result, uint32_t rule) const;
+    const CacheEntry& entryFor(const WindowRuleQuery& query);
+
+    std::vector<WindowRule> m_rules;
+    std::vector<CompiledRule> m_compiled;
+    std::vector<std::regex> m_patterns;
+    std::vector<std::string> m_outputs;
+    std::vector<std::string> m_effects;
+
+    // Rules by application, each list in priority order and including the rules for any application
+    std::unordered_map<std::string, std::vector<uint32_t>> m_byApp;
+    std::vector<uint32_t> m_anyApp;
+
+    std::unordered_map<std::string, CacheEntry> m_cache;
+    std::string m_key;
+
+    size_t m_rejectedRules;
+    uint64_t m_evaluations;
+    uint64_t m_cacheHits;
+    uint64_t m_titleMatches;
+    uint64_t m_generation;
+};
+
+} // namespace Windows
+} // namespace WindowManager
+} // namespace VivoX